@@ -0,0 +1,240 @@
+#include "BenchmarkLibrary.h"
+
+#include "utils/FileSystemUtil.h"
+#include "utils/TimelineUtil.h"
+#include "CollectionSystemManager.h"
+#include "GamelistWriter.h"
+#include "Log.h"
+#include "Metrics.h"
+#include "SystemData.h"
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <sstream>
+
+// systems of the generated library, all of them have a folder in the usual themes. Asking for more systems than
+// there are here starts over with a number behind the name, those keep the theme of the first round
+static const struct
+{
+	const char* name;
+	const char* fullName;
+	const char* extension;
+
+} sSystems[] =
+{
+	{ "nes",          "Nintendo Entertainment System", ".nes" },
+	{ "snes",         "Super Nintendo",                ".sfc" },
+	{ "megadrive",    "Sega Mega Drive",               ".md"  },
+	{ "gba",          "Game Boy Advance",              ".gba" },
+	{ "n64",          "Nintendo 64",                   ".z64" },
+	{ "mastersystem", "Sega Master System",            ".sms" },
+	{ "gb",           "Game Boy",                      ".gb"  },
+	{ "gbc",          "Game Boy Color",                ".gbc" },
+	{ "pcengine",     "PC Engine",                     ".pce" },
+	{ "atari2600",    "Atari 2600",                    ".a26" },
+};
+
+static const unsigned int SYSTEM_COUNT = sizeof(sSystems) / sizeof(sSystems[0]);
+
+// a 1x1 PNG, only what it takes for the image paths of a gamelist to point at something
+static const unsigned char sImage[] =
+{
+	0x89, 0x50, 0x4E, 0x47, 0x0D, 0x0A, 0x1A, 0x0A, 0x00, 0x00, 0x00, 0x0D, 0x49, 0x48, 0x44, 0x52,
+	0x00, 0x00, 0x00, 0x01, 0x00, 0x00, 0x00, 0x01, 0x08, 0x06, 0x00, 0x00, 0x00, 0x1F, 0x15, 0xC4,
+	0x89, 0x00, 0x00, 0x00, 0x0B, 0x49, 0x44, 0x41, 0x54, 0x78, 0xDA, 0x63, 0x60, 0x00, 0x02, 0x00,
+	0x00, 0x05, 0x00, 0x01, 0xE9, 0xFA, 0xDC, 0xD8, 0x00, 0x00, 0x00, 0x00, 0x49, 0x45, 0x4E, 0x44,
+	0xAE, 0x42, 0x60, 0x82,
+};
+
+// spreads a percentage evenly over the games instead of giving it all to the first ones
+static bool isPicked(const unsigned int _game, const unsigned int _percentage, const unsigned int _stride)
+{
+	return ((_game * _stride) % 100) < _percentage;
+
+} // isPicked
+
+bool BenchmarkLibrary::init(const Options& _options)
+{
+	const std::string path       = getPath();
+	const std::string markerPath = path + "/library.txt";
+
+	std::stringstream options;
+	options << _options.systems << " " << _options.games << " " << _options.metadata << " " << _options.media;
+
+	// the marker holds the options the library was written with, different options write it again
+	std::ifstream marker(markerPath.c_str());
+	std::string   written;
+
+	if(!std::getline(marker, written) || (written != options.str()))
+	{
+		marker.close();
+
+		LOG(LogInfo) << "Writing benchmark library of " << _options.games << " games in " << _options.systems << " systems to \"" << path << "\"";
+
+		if(!write(path, _options))
+		{
+			LOG(LogError) << "Could not write benchmark library to \"" << path << "\"";
+			return false;
+		}
+
+		std::ofstream(markerPath.c_str(), std::ios::out | std::ios::trunc) << options.str() << "\n";
+	}
+
+	SystemData::setConfigPath(path + "/es_systems.cfg");
+
+	return true;
+
+} // init
+
+void BenchmarkLibrary::deinit()
+{
+	SystemData::setConfigPath("");
+
+} // deinit
+
+int BenchmarkLibrary::runLoadBenchmark(const std::string& _tracePath)
+{
+	// the scopes of the loaders are what gets reported, they only record while the timeline runs
+	if(!Utils::Timeline::isStarted())
+		Utils::Timeline::start();
+
+	const bool loaded = SystemData::loadConfig(nullptr);
+
+	Utils::Timeline::stop();
+
+	if(!loaded || SystemData::sSystemVector.empty())
+	{
+		std::cout << "Could not load the systems of \"" << getPath() << "\"\n";
+		return 1;
+	}
+
+	unsigned int games = 0;
+
+	for(auto it = SystemData::sSystemVector.cbegin(); it != SystemData::sSystemVector.cend(); ++it)
+	{
+		if((*it)->isGameSystem())
+			games += (*it)->getGameCount();
+	}
+
+	const std::vector<Utils::Timeline::Total> totals = Utils::Timeline::getTotals();
+
+	std::cout << std::fixed << std::setprecision(2);
+	std::cout << "Load benchmark, " << games << " games in " << SystemData::sSystemVector.size() << " systems and collections\n";
+	std::cout << "Phases in ms, summed over the threads they ran on\n";
+
+	for(auto it = totals.cbegin(); it != totals.cend(); ++it)
+		std::cout << "   " << std::left << std::setw(48) << it->name << std::right << std::setw(10) << (it->duration / 1000.0) << " (" << it->count << "x)\n";
+
+	std::cout << "Peak resident memory " << (Metrics::getPeakResidentMemory() / 1024.0 / 1024.0) << " MiB\n";
+
+	if(!_tracePath.empty() && !Utils::Timeline::save(_tracePath))
+		std::cout << "Could not write timeline to \"" << _tracePath << "\"\n";
+
+	CollectionSystemManager::deinit();
+	SystemData::deleteSystems();
+	GamelistWriter::deinit();
+
+	return 0;
+
+} // runLoadBenchmark
+
+bool BenchmarkLibrary::write(const std::string& _path, const Options& _options)
+{
+	if(!Utils::FileSystem::createDirectory(_path))
+		return false;
+
+	std::ofstream systems((_path + "/es_systems.cfg").c_str(), std::ios::out | std::ios::trunc);
+
+	if(!systems.is_open())
+		return false;
+
+	systems << "<?xml version=\"1.0\"?>\n<systemList>\n";
+
+	for(unsigned int i = 0; i < _options.systems; ++i)
+	{
+		const unsigned int round     = i / SYSTEM_COUNT;
+		const auto&        system    = sSystems[i % SYSTEM_COUNT];
+		const std::string  name      = system.name + ((round > 0) ? std::to_string(round + 1) : "");
+		const std::string  romPath   = _path + "/roms/" + name;
+		const std::string  mediaPath = romPath + "/media";
+		const unsigned int games     = (_options.games / _options.systems) + ((i < (_options.games % _options.systems)) ? 1 : 0);
+
+		if(!Utils::FileSystem::createDirectory(romPath) || ((_options.media > 0) && !Utils::FileSystem::createDirectory(mediaPath)))
+			return false;
+
+		systems << "\t<system>\n";
+		systems << "\t\t<name>"      << name             << "</name>\n";
+		systems << "\t\t<fullname>"  << system.fullName  << ((round > 0) ? (" " + std::to_string(round + 1)) : "") << "</fullname>\n";
+		systems << "\t\t<path>"      << romPath          << "</path>\n";
+		systems << "\t\t<extension>" << system.extension << "</extension>\n";
+		systems << "\t\t<command>true</command>\n";
+		systems << "\t\t<platform>"  << system.name      << "</platform>\n";
+		systems << "\t\t<theme>"     << system.name      << "</theme>\n";
+		systems << "\t</system>\n";
+
+		// a gamelist gives the loaders something to parse and the views text to lay out, the ROMs themselves are empty
+		std::ofstream gamelist((romPath + "/gamelist.xml").c_str(), std::ios::out | std::ios::trunc);
+
+		if(!gamelist.is_open())
+			return false;
+
+		gamelist << "<?xml version=\"1.0\"?>\n<gameList>\n";
+
+		for(unsigned int game = 0; game < games; ++game)
+		{
+			std::stringstream title;
+			title << "Benchmark Game " << std::setw(5) << std::setfill('0') << (game + 1);
+
+			const std::string fileName = title.str() + system.extension;
+			const std::string filePath = romPath + "/" + fileName;
+
+			if(!Utils::FileSystem::exists(filePath))
+				std::ofstream(filePath.c_str(), std::ios::out | std::ios::trunc);
+
+			gamelist << "\t<game>\n";
+			gamelist << "\t\t<path>./" << fileName    << "</path>\n";
+			gamelist << "\t\t<name>"   << title.str() << "</name>\n";
+
+			if(isPicked(game, _options.metadata, 37))
+			{
+				gamelist << "\t\t<desc>"        << system.fullName << " game number " << (game + 1) << " of the benchmark library.</desc>\n";
+				gamelist << "\t\t<rating>"      << ((game % 11) / 10.0) << "</rating>\n";
+				gamelist << "\t\t<releasedate>" << (1980 + (game % 40)) << "0101T000000</releasedate>\n";
+				gamelist << "\t\t<developer>"   << "Developer " << (game % 50) << "</developer>\n";
+				gamelist << "\t\t<publisher>"   << "Publisher " << (game % 20) << "</publisher>\n";
+				gamelist << "\t\t<genre>"       << "Genre " << (game % 12) << "</genre>\n";
+				gamelist << "\t\t<players>"     << ((game % 4) + 1) << "</players>\n";
+			}
+
+			if(isPicked(game, _options.media, 61))
+			{
+				const std::string imagePath = mediaPath + "/" + title.str() + ".png";
+
+				if(!Utils::FileSystem::exists(imagePath))
+					std::ofstream(imagePath.c_str(), std::ios::out | std::ios::trunc | std::ios::binary).write((const char*)sImage, sizeof(sImage));
+
+				gamelist << "\t\t<image>./media/" << title.str() << ".png</image>\n";
+			}
+
+			gamelist << "\t</game>\n";
+		}
+
+		gamelist << "</gameList>\n";
+		gamelist.close();
+
+		if(gamelist.fail())
+			return false;
+	}
+
+	systems << "</systemList>\n";
+	systems.close();
+
+	return !systems.fail();
+
+} // write
+
+std::string BenchmarkLibrary::getPath()
+{
+	return Utils::FileSystem::getHomePath() + "/.emulationstation/benchmark";
+
+} // getPath
@@ -0,0 +1,41 @@
+#pragma once
+#ifndef ES_APP_BENCHMARK_LIBRARY_H
+#define ES_APP_BENCHMARK_LIBRARY_H
+
+#include <string>
+
+class Window;
+
+// Generates a fake ROM library with gamelists in ~/.emulationstation/benchmark/ and points SystemData at its own
+// es_systems.cfg, so boot and UI timings can be compared on the same library from run to run. The library is only
+// written again when the options change
+class BenchmarkLibrary
+{
+public:
+
+	struct Options
+	{
+		unsigned int systems;
+		unsigned int games;    // over all systems
+		unsigned int metadata; // percentage of the games with full metadata, the others only have a name
+		unsigned int media;    // percentage of the games with an image file
+
+		Options() : systems(5), games(10000), metadata(100), media(0) { }
+	};
+
+	// Writes the library if needed and loads it instead of the usual systems, call before the systems are loaded
+	static bool init  (const Options& _options);
+	static void deinit();
+
+	// Loads the systems and collections without a window and prints how long each phase took, returns the exit code.
+	// The timeline of the load is written to _tracePath as well, if given
+	static int runLoadBenchmark(const std::string& _tracePath);
+
+private:
+
+	static bool        write  (const std::string& _path, const Options& _options);
+	static std::string getPath();
+
+}; // BenchmarkLibrary
+
+#endif // ES_APP_BENCHMARK_LIBRARY_H
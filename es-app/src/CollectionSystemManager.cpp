@@ -4,6 +4,7 @@
 #include "guis/GuiInfoPopup.h"
 #include "utils/FileSystemUtil.h"
 #include "utils/StringUtil.h"
+#include "utils/TimelineUtil.h"
 #include "views/gamelist/IGameListView.h"
 #include "views/gamelist/ISimpleGameListView.h"
 #include "views/ViewController.h"
@@ -59,11 +60,15 @@ CollectionSystemManager::CollectionSystemManager(Window* window) : mWindow(windo
 	mEditingCollectionSystemData = NULL;
 	mCustomCollectionsBundle = NULL;
 	mRandomCollection = NULL;
+	mPopulating = false;
+
+	FileData::addMetaDataListener(this);
 }
 
 CollectionSystemManager::~CollectionSystemManager()
 {
 	assert(sInstance == this);
+	FileData::removeMetaDataListener(this);
 	removeCollectionsFromDisplayedSystems();
 
 	// iterate the map
@@ -101,7 +106,7 @@ void CollectionSystemManager::deinit()
 bool CollectionSystemManager::saveCustomCollection(SystemData* sys)
 {
 	std::string name = sys->getName();
-	std::unordered_map<std::string, FileData*> games = sys->getRootFolder()->getChildrenByFilename();
+	const std::unordered_map<std::string, FileData*>& games = sys->getRootFolder()->getChildrenByFilename();
 	bool found = mCustomCollectionSystemsData.find(name) != mCustomCollectionSystemsData.cend();
 	if (!found)
 	{
@@ -109,7 +114,7 @@ bool CollectionSystemManager::saveCustomCollection(SystemData* sys)
 		return false;
 	}
 
-	CollectionSystemData sysData = mCustomCollectionSystemsData.at(name);
+	const CollectionSystemData& sysData = mCustomCollectionSystemsData.at(name);
 	if (sysData.needsSave)
 	{
 		std::string absCollectionFn = getCustomCollectionConfigPath(name);
@@ -135,6 +140,8 @@ bool CollectionSystemManager::saveCustomCollection(SystemData* sys)
 // loads all Collection Systems
 void CollectionSystemManager::loadCollectionSystems(bool async)
 {
+	TimelineScope("CollectionSystemManager::loadCollectionSystems");
+
 	initAutoCollectionSystems();
 	CollectionSystemDecl decl = mCollectionSystemDeclsIndex[CUSTOM_COLL_ID];
 	mCustomCollectionsBundle = createNewCollectionEntry(decl.name, decl, CollectionFlags::NONE);
@@ -176,6 +183,8 @@ void CollectionSystemManager::loadEnabledListFromSettings()
 // updates enabled system list in System View
 void CollectionSystemManager::updateSystemsList()
 {
+	TimelineScope("CollectionSystemManager::updateSystemsList");
+
 	// remove all Collection Systems
 	removeCollectionsFromDisplayedSystems();
 	// add custom enabled ones
@@ -217,7 +226,7 @@ void CollectionSystemManager::updateSystemsList()
 	// create views for collections, before reload
 	for(auto sysIt = SystemData::sSystemVector.cbegin(); sysIt != SystemData::sSystemVector.cend(); sysIt++)
 	{
-		if ((*sysIt)->isCollection())
+		if ((*sysIt)->isCollection() && !needsPopulating(*sysIt))
 			ViewController::get()->getGameListView((*sysIt));
 	}
 
@@ -235,17 +244,19 @@ void CollectionSystemManager::refreshCollectionSystems(FileData* file)
 	if (!file->getSystem()->isGameSystem() || file->getType() != GAME)
 		return;
 
-	std::map<std::string, CollectionSystemData> allCollections;
-	allCollections.insert(mAutoCollectionSystemsData.cbegin(), mAutoCollectionSystemsData.cend());
-	allCollections.insert(mCustomCollectionSystemsData.cbegin(), mCustomCollectionSystemsData.cend());
+	// no copy of the collection maps, this runs every time a game is launched or edited
+	for(auto sysDataIt = mAutoCollectionSystemsData.cbegin(); sysDataIt != mAutoCollectionSystemsData.cend(); sysDataIt++)
+		updateCollectionSystem(file, sysDataIt->second);
 
-	for(auto sysDataIt = allCollections.cbegin(); sysDataIt != allCollections.cend(); sysDataIt++)
+	for(auto sysDataIt = mCustomCollectionSystemsData.cbegin(); sysDataIt != mCustomCollectionSystemsData.cend(); sysDataIt++)
 	{
-		updateCollectionSystem(file, sysDataIt->second);
+		// an auto collection with the same name takes precedence, like when both maps were merged
+		if(mAutoCollectionSystemsData.find(sysDataIt->first) == mAutoCollectionSystemsData.cend())
+			updateCollectionSystem(file, sysDataIt->second);
 	}
 }
 
-void CollectionSystemManager::updateCollectionSystem(FileData* file, CollectionSystemData sysData)
+void CollectionSystemManager::updateCollectionSystem(FileData* file, const CollectionSystemData& sysData)
 {
 	if (sysData.isPopulated)
 	{
@@ -258,6 +269,8 @@ void CollectionSystemManager::updateCollectionSystem(FileData* file, CollectionS
 		FileData* rootFolder = curSys->getRootFolder();
 		FileFilterIndex* fileIndex = curSys->getIndex();
 		std::string name = curSys->getName();
+		// only the changed entry is moved into place, the rest of the collection is still in order
+		FileData* entryToSort = NULL;
 
 		if (found) {
 			// if we found it, we need to update it
@@ -274,6 +287,7 @@ void CollectionSystemManager::updateCollectionSystem(FileData* file, CollectionS
 			{
 				// re-index with new metadata
 				fileIndex->addToIndex(collectionEntry);
+				entryToSort = collectionEntry;
 				ViewController::get()->onFileChanged(collectionEntry, FILE_METADATA_CHANGED);
 			}
 		}
@@ -285,11 +299,13 @@ void CollectionSystemManager::updateCollectionSystem(FileData* file, CollectionS
 				CollectionFileData* newGame = new CollectionFileData(file, curSys);
 				rootFolder->addChild(newGame);
 				fileIndex->addToIndex(newGame);
+				entryToSort = newGame;
 				ViewController::get()->onFileChanged(file, FILE_METADATA_CHANGED);
 				ViewController::get()->getGameListView(curSys)->onFileChanged(newGame, FILE_METADATA_CHANGED);
 			}
 		}
-		rootFolder->sort(getSortTypeFromString(mCollectionSystemDeclsIndex[name].defaultSort));
+		if (entryToSort)
+			rootFolder->resortChild(entryToSort, getSortTypeFromString(mCollectionSystemDeclsIndex[name].defaultSort));
 		if (name == "recent")
 		{
 			trimCollectionCount(rootFolder, LAST_PLAYED_MAX, false);
@@ -305,14 +321,20 @@ void CollectionSystemManager::updateCollectionSystem(FileData* file, CollectionS
 void CollectionSystemManager::trimCollectionCount(FileData* rootFolder, int limit, bool shuffle)
 {
 	SystemData* curSys = rootFolder->getSystem();
-	while ((int)rootFolder->getChildrenListToDisplay().size() > limit)
+	// collections are flat, every displayed game removed shortens the displayed list by one
+	int excess = (int)rootFolder->getChildrenListToDisplay().size() - limit;
+	if (excess > 0)
 	{
 		std::vector<FileData*> games = rootFolder->getFilesRecursive(GAME, true);
 		if (shuffle)
 			std::shuffle(games.begin(), games.end(), SystemData::sURNG);
 
-		CollectionFileData* gameToRemove = (CollectionFileData*)games.back();
-		ViewController::get()->getGameListView(curSys).get()->remove(gameToRemove, false, false);
+		for (; excess > 0 && !games.empty(); excess--)
+		{
+			CollectionFileData* gameToRemove = (CollectionFileData*)games.back();
+			games.pop_back();
+			ViewController::get()->getGameListView(curSys).get()->remove(gameToRemove, false, false);
+		}
 	}
 	ViewController::get()->onFileChanged(rootFolder, FILE_REMOVED);
 }
@@ -446,6 +468,10 @@ void CollectionSystemManager::setEditMode(std::string collectionName, bool quiet
 		LOG(LogError) << "Tried to edit a non-existing collection: " << collectionName;
 		return;
 	}
+	// what the one edited until now got isn't in its folder metadata yet
+	if (mIsEditingCustom)
+		updateCollectionFolderMetadata(mEditingCollectionSystemData->system);
+
 	mIsEditingCustom = true;
 	mEditingCollection = collectionName;
 
@@ -472,6 +498,7 @@ void CollectionSystemManager::exitEditMode(bool quiet)
 	if (mIsEditingCustom) {
 		mIsEditingCustom = false;
 		mEditingCollection = "Favorites";
+		updateCollectionFolderMetadata(mEditingCollectionSystemData->system);
 		mEditingCollectionSystemData->system->onMetaDataSavePoint();
 		saveCustomCollection(mEditingCollectionSystemData->system);
 	}
@@ -535,44 +562,32 @@ bool CollectionSystemManager::toggleGameInCollection(FileData* file)
 				CollectionFileData* newGame = new CollectionFileData(file, sysData);
 				rootFolder->addChild(newGame);
 				fileIndex->addToIndex(newGame);
-				// this is the biggest performance bottleneck for this process.
-				// this code has been here for 7 years, since this feature was added.
-				// I might have been playing it safe back then, but it feels unnecessary, especially given following onFileChanged to sort
-				// Commenting this out for now.
-				//ViewController::get()->getGameListView(systemViewToUpdate)->onFileChanged(newGame, FILE_METADATA_CHANGED);
-				rootFolder->sort(getSortTypeFromString(mEditingCollectionSystemData->decl.defaultSort));
-				ViewController::get()->onFileChanged(systemViewToUpdate->getRootFolder(), FILE_SORTED);
+				// the rest is still sorted, only the new game has to find its place, and the list only has to make its entry
+				rootFolder->resortChild(newGame, getSortTypeFromString(mEditingCollectionSystemData->decl.defaultSort));
+				ViewController::get()->onFileChanged(systemViewToUpdate != sysData ? systemViewToUpdate->getRootFolder() : newGame, FILE_SORTED);
 				// add to bundle index as well, if needed
 				if(systemViewToUpdate != sysData)
 				{
 					systemViewToUpdate->getIndex()->addToIndex(newGame);
 				}
 			}
+			// the folder metadata goes through every game, it's updated once editing is done
 			sysData->setShuffledCacheDirty();
-			updateCollectionFolderMetadata(sysData);
 		}
 		else
 		{
-			file->getSourceFileData()->getSystem()->getIndex()->removeFromIndex(file);
-			MetaDataList* md = &file->getSourceFileData()->metadata;
-			std::string value = md->get("favorite");
-			if (value == "false")
-			{
-				md->set("favorite", "true");
-			}
-			else
+			FileData* source = file->getSourceFileData();
+			if (source->metadata.get("favorite") != "false")
 			{
 				if (needDoublePress(getPressCountInDuration())) {
 					return true;
 				}
 				adding = false;
-				md->set("favorite", "false");
 			}
-			file->getSourceFileData()->getSystem()->getIndex()->addToIndex(file);
+			// the favorites collection hears of it like everything else
+			source->changeMetaData([adding](MetaDataList& metadata) { metadata.set("favorite", adding ? "true" : "false"); });
 
-			file->getSourceFileData()->getSystem()->onMetaDataSavePoint();
-
-			refreshCollectionSystems(file->getSourceFileData());
+			source->getSystem()->onMetaDataSavePoint();
 		}
 		if (adding)
 		{
@@ -689,7 +704,7 @@ void CollectionSystemManager::updateCollectionFolderMetadata(SystemData* sys)
 	std::string thumbnail = "";
 	std::string image = "";
 
-	std::unordered_map<std::string, FileData*> games = rootFolder->getChildrenByFilename();
+	const std::unordered_map<std::string, FileData*>& games = rootFolder->getChildrenByFilename();
 
 	if(games.size() > 0)
 	{
@@ -806,25 +821,28 @@ SystemData* CollectionSystemManager::createNewCollectionEntry(std::string name,
 }
 
 void CollectionSystemManager::addRandomGames(SystemData* newSys, SystemData* sourceSystem, FileData* rootFolder,
-	FileFilterIndex* index, std::map<std::string, std::map<std::string, int>> mapsForRandomColl, int defaultValue)
+	FileFilterIndex* index, const std::map<std::string, std::map<std::string, int>>& mapsForRandomColl, int defaultValue)
 {
 
 	int gamesForSourceSystem = defaultValue;
 	for (auto& m : mapsForRandomColl)
 	{
 		// m.first unused
-		std::map<std::string, int> collMap = m.second;
-		if (collMap.find(sourceSystem->getFullName()) != collMap.end())
+		const std::map<std::string, int>& collMap = m.second;
+		auto maxIt = collMap.find(sourceSystem->getFullName());
+		if (maxIt != collMap.end())
 		{
-			int maxForSys = collMap[sourceSystem->getFullName()];
 			// we won't add more than the max and less than 0
-			gamesForSourceSystem = Math::max(Math::min(RANDOM_SYSTEM_MAX, maxForSys), 0);
+			gamesForSourceSystem = Math::max(Math::min(RANDOM_SYSTEM_MAX, maxIt->second), 0);
 			break;
 		}
 	}
 
+	if (gamesForSourceSystem == 0)
+		return;
+
 	// load exclusion collection
-	std::unordered_map<std::string,FileData*> exclusionMap;
+	const std::unordered_map<std::string,FileData*>* exclusionMap = NULL;
 	std::string exclusionCollection = Settings::getInstance()->getString("RandomCollectionExclusionCollection");
 	auto sysDataIt = mCustomCollectionSystemsData.find(exclusionCollection);
 
@@ -834,53 +852,48 @@ void CollectionSystemManager::addRandomGames(SystemData* newSys, SystemData* sou
 			populateCustomCollection(&(sysDataIt->second));
 		}
 
-		exclusionMap = mCustomCollectionSystemsData[exclusionCollection].system->getRootFolder()->getChildrenByFilename();
-
+		exclusionMap = &(sysDataIt->second.system->getRootFolder()->getChildrenByFilename());
 	}
 
-	// we do this to avoid trying to add more games than there are in the system
-	gamesForSourceSystem = Math::min(gamesForSourceSystem, sourceSystem->getRootFolder()->getFilesRecursive(GAME).size());
-
-	int startCount = rootFolder->getFilesRecursive(GAME).size();
-	int endCount = startCount + gamesForSourceSystem;
+	// getRandomGame() hands out the system's games in a shuffled order it keeps between calls,
+	// so a full round through them without a hit means there is nothing left to add
+	const std::unordered_map<std::string,FileData*>& children = rootFolder->getChildrenByFilename();
+	const unsigned int available = sourceSystem->getDisplayedGameCount();
+	int added = 0;
 	int retryCount = 10;
 
-	for (int iterCount = startCount; iterCount < endCount;)
+	for (unsigned int drawn = 0; added < gamesForSourceSystem && drawn < available; drawn++)
 	{
-		FileData* randomGame = sourceSystem->getRandomGame()->getSourceFileData();
-		CollectionFileData* newGame = NULL;
+		FileData* randomGame = sourceSystem->getRandomGame();
+		if (!randomGame)
+			return;
+		randomGame = randomGame->getSourceFileData();
 
-		if(exclusionMap.find(randomGame->getFullPath()) == exclusionMap.end())
+		const std::string key = randomGame->getFullPath();
+		if (children.find(key) == children.cend() && (!exclusionMap || exclusionMap->find(key) == exclusionMap->cend()))
 		{
-			// Not in the exclusion collection
-			newGame = new CollectionFileData(randomGame, newSys);
+			CollectionFileData* newGame = new CollectionFileData(randomGame, newSys);
 			rootFolder->addChild(newGame);
-			index->addToIndex(newGame);
-		}
-
-		if (rootFolder->getFilesRecursive(GAME).size() > iterCount)
-		{
-			// added game, proceed
-			iterCount++;
+			index->importGame(randomGame->getSystem()->getIndex(), randomGame, newGame);
+			added++;
 			retryCount = 10;
 		}
 		else
 		{
-			// the game already exists in the collection, let's try again
-			LOG(LogDebug) << "Clash: " << randomGame->getName() << " already exists or in exclusion list. Deleting and trying again";
-			delete newGame;
+			// the game already exists in the collection or is excluded, let's try again
+			LOG(LogDebug) << "Clash: " << randomGame->getName() << " already exists or in exclusion list. Trying again";
 			retryCount--;
 			if (retryCount == 0)
 			{
 				// we give up. Either we were very unlucky, or all the games in this system are already there.
-				LOG(LogDebug) << "Giving up retrying: cannot add this game. Deleting and moving on.";
+				LOG(LogDebug) << "Giving up retrying: cannot add this game. Moving on.";
 				return;
 			}
 		}
 	}
 }
 
-void CollectionSystemManager::populateRandomCollectionFromCollections(std::map<std::string, std::map<std::string, int>> mapsForRandomColl)
+void CollectionSystemManager::populateRandomCollectionFromCollections(const std::map<std::string, std::map<std::string, int>>& mapsForRandomColl)
 {
 	CollectionSystemData* sysData = &mAutoCollectionSystemsData[RANDOM_COLL_ID];
 	SystemData* newSys = sysData->system;
@@ -891,7 +904,8 @@ void CollectionSystemManager::populateRandomCollectionFromCollections(std::map<s
 	// iterate the auto collections map
 	for(auto &c : mAutoCollectionSystemsData)
 	{
-		CollectionSystemData csd = c.second;
+		// by reference, so a collection populated here stays populated for the next reroll
+		CollectionSystemData& csd = c.second;
 		// we can't add games from the random collection to the random collection
 		if (csd.decl.type != AUTO_RANDOM)
 		{
@@ -907,7 +921,7 @@ void CollectionSystemManager::populateRandomCollectionFromCollections(std::map<s
 	// iterate the custom collections map
 	for(auto &c : mCustomCollectionSystemsData)
 	{
-		CollectionSystemData csd = c.second;
+		CollectionSystemData& csd = c.second;
 		// collections might not be populated
 		if (!csd.isPopulated)
 			populateCustomCollection(&csd);
@@ -948,18 +962,17 @@ void CollectionSystemManager::populateAutoCollection(CollectionSystemData* sysDa
 			}
 			else
 			{
-				std::vector<FileData*> files = (*sysIt)->getRootFolder()->getFilesRecursive(GAME);
-
-				for(auto gameIt = files.cbegin(); gameIt != files.cend(); gameIt++)
+				FileFilterIndex* systemIndex = (*sysIt)->getIndex();
+				(*sysIt)->getRootFolder()->forEachFile(GAME, false, [this, &sysDecl, newSys, rootFolder, index, systemIndex](FileData* game)
 				{
-					bool include = includeFileInAutoCollections(*gameIt);
+					bool include = includeFileInAutoCollections(game);
 					switch(sysDecl.type) {
 						case AUTO_LAST_PLAYED:
-							include = include && (*gameIt)->metadata.get("playcount") > "0";
+							include = include && game->metadata.get("playcount") > "0";
 							break;
 						case AUTO_FAVORITES:
 							// we may still want to add files we don't want in auto collections in "favorites"
-							include = (*gameIt)->metadata.get("favorite") == "true";
+							include = game->metadata.get("favorite") == "true";
 							break;
 						case AUTO_ALL_GAMES:
 							break;
@@ -972,11 +985,11 @@ void CollectionSystemManager::populateAutoCollection(CollectionSystemData* sysDa
 
 					if (include)
 					{
-						CollectionFileData* newGame = new CollectionFileData(*gameIt, newSys);
+						CollectionFileData* newGame = new CollectionFileData(game, newSys);
 						rootFolder->addChild(newGame);
-						index->addToIndex(newGame);
+						index->importGame(systemIndex, game, newGame);
 					}
-				}
+				});
 			}
 		}
 	}
@@ -1021,18 +1034,16 @@ void CollectionSystemManager::populateCustomCollection(CollectionSystemData* sys
 	// get Configuration for this Custom System
 	std::ifstream input(path);
 
-	// get all files map
-	std::unordered_map<std::string,FileData*> allFilesMap = getAllGamesCollection()->getRootFolder()->getChildrenByFilename();
-
 	// iterate list of files in config file
 	for(std::string gameKey; getline(input, gameKey); )
 	{
-		std::unordered_map<std::string,FileData*>::const_iterator it = allFilesMap.find(gameKey);
-		if (it != allFilesMap.cend())
+		// looked up directly instead of through "all games", which doesn't have to be populated for this
+		FileData* game = FileData::findGame(gameKey);
+		if (game && includeFileInAutoCollections(game))
 		{
-			CollectionFileData* newGame = new CollectionFileData(it->second, newSys);
+			CollectionFileData* newGame = new CollectionFileData(game, newSys);
 			rootFolder->addChild(newGame);
-			index->addToIndex(newGame);
+			index->importGame(game->getSystem()->getIndex(), game, newGame);
 		}
 		else
 		{
@@ -1088,8 +1099,8 @@ void CollectionSystemManager::addEnabledCollectionsToDisplayedSystems(std::map<s
 		{
 			if(it->second.isEnabled)
 			{
-				// check if populated, otherwise populate
-				if (!it->second.isPopulated)
+				// check if populated, otherwise populate, unless that's left for when its games are needed
+				if (!it->second.isPopulated && !Settings::getInstance()->getBool("LazyCollections"))
 				{
 					if(it->second.decl.isCustom)
 						populateCustomCollection(&(it->second));
@@ -1115,6 +1126,105 @@ void CollectionSystemManager::addEnabledCollectionsToDisplayedSystems(std::map<s
 	}
 }
 
+/* Populating collections on demand */
+CollectionSystemData* CollectionSystemManager::getCollectionData(SystemData* sys)
+{
+	for(auto it = mAutoCollectionSystemsData.begin(); it != mAutoCollectionSystemsData.end(); it++)
+	{
+		if (it->second.system == sys)
+			return &(it->second);
+	}
+
+	for(auto it = mCustomCollectionSystemsData.begin(); it != mCustomCollectionSystemsData.end(); it++)
+	{
+		if (it->second.system == sys)
+			return &(it->second);
+	}
+
+	return NULL;
+}
+
+bool CollectionSystemManager::isBundled(const CollectionSystemData& sysData)
+{
+	return mCustomCollectionsBundle && sysData.system->getRootFolder()->getParent() == mCustomCollectionsBundle->getRootFolder();
+}
+
+bool CollectionSystemManager::needsPopulating(SystemData* sys)
+{
+	if (!sys->isCollection())
+		return false;
+
+	// the bundle shows the games of all the custom collections in it
+	if (sys == mCustomCollectionsBundle)
+	{
+		for(auto it = mCustomCollectionSystemsData.cbegin(); it != mCustomCollectionSystemsData.cend(); it++)
+		{
+			if (it->second.isEnabled && !it->second.isPopulated && isBundled(it->second))
+				return true;
+		}
+		return false;
+	}
+
+	CollectionSystemData* sysData = getCollectionData(sys);
+	return sysData && sysData->isEnabled && !sysData->isPopulated;
+}
+
+void CollectionSystemManager::populateIfNeeded(SystemData* sys)
+{
+	// populating can ask for the collection's own view, which brings us back here. While systems are still loading
+	// a collection would miss the ones that aren't done yet, and the collections may still be added to
+	if (mPopulating || SystemData::isLoading() || !needsPopulating(sys))
+		return;
+
+	if (sys == mCustomCollectionsBundle)
+	{
+		for(auto it = mCustomCollectionSystemsData.begin(); it != mCustomCollectionSystemsData.end(); it++)
+		{
+			if (it->second.isEnabled && !it->second.isPopulated && isBundled(it->second))
+				populateCollection(&(it->second));
+		}
+	}
+	else
+		populateCollection(getCollectionData(sys));
+}
+
+void CollectionSystemManager::populateOnIdle()
+{
+	if (mPopulating || SystemData::isLoading() || mWindow->getTimeSinceLastInput() < IDLE_POPULATE_DELAY)
+		return;
+
+	// one collection per frame at most, so input is never held up for long
+	std::map<std::string, CollectionSystemData>* colSystemData[] = { &mAutoCollectionSystemsData, &mCustomCollectionSystemsData };
+
+	for (auto* data : colSystemData)
+	{
+		for(auto it = data->begin(); it != data->end(); it++)
+		{
+			if (it->second.isEnabled && !it->second.isPopulated)
+			{
+				populateCollection(&(it->second));
+				return;
+			}
+		}
+	}
+}
+
+void CollectionSystemManager::populateCollection(CollectionSystemData* sysData)
+{
+	LOG(LogDebug) << "Populating collection " << sysData->system->getName();
+
+	mPopulating = true;
+	if (sysData->decl.isCustom)
+		populateCustomCollection(sysData);
+	else
+		populateAutoCollection(sysData);
+	mPopulating = false;
+
+	// the bundle imported this collection's index while it was still empty
+	if (isBundled(*sysData))
+		mCustomCollectionsBundle->getIndex()->importIndex(sysData->system->getIndex());
+}
+
 /* Auxiliary methods to get available custom collection possibilities */
 std::vector<std::string> CollectionSystemManager::getSystemsFromConfig()
 {
@@ -2,12 +2,12 @@
 #ifndef ES_APP_COLLECTION_SYSTEM_MANAGER_H
 #define ES_APP_COLLECTION_SYSTEM_MANAGER_H
 
+#include "FileData.h"
 #include <map>
 #include <SDL_timer.h>
 #include <string>
 #include <vector>
 
-class FileData;
 class SystemData;
 class Window;
 struct SystemEnvironmentData;
@@ -67,7 +67,7 @@ struct CollectionSystemData
 	bool needsSave;
 };
 
-class CollectionSystemManager
+class CollectionSystemManager : public MetaDataListener
 {
 public:
 	CollectionSystemManager(Window* window);
@@ -83,7 +83,8 @@ public:
 	void updateSystemsList();
 
 	void refreshCollectionSystems(FileData* file);
-	void updateCollectionSystem(FileData* file, CollectionSystemData sysData);
+	void onMetaDataChanged(FileData* file) override { refreshCollectionSystems(file); }
+	void updateCollectionSystem(FileData* file, const CollectionSystemData& sysData);
 	void deleteCollectionFiles(FileData* file);
 	void recreateCollection(SystemData* sysData);
 
@@ -111,6 +112,12 @@ public:
 
 	void trimCollectionCount(FileData* rootFolder, int limit, bool shuffle);
 
+	// with LazyCollections, enabled collections stay empty at startup until their games are first needed
+	bool needsPopulating(SystemData* sys);
+	void populateIfNeeded(SystemData* sys);
+	// populates one of the collections still left empty, once there was no input for a while
+	void populateOnIdle();
+
 private:
 	static CollectionSystemManager* sInstance;
 	SystemEnvironmentData* mCollectionEnvData;
@@ -128,9 +135,12 @@ private:
 	SystemData* createNewCollectionEntry(std::string name, CollectionSystemDecl sysDecl, const CollectionFlags flags);
 	void populateAutoCollection(CollectionSystemData* sysData);
 	void populateCustomCollection(CollectionSystemData* sysData);
+	void populateCollection(CollectionSystemData* sysData);
+	CollectionSystemData* getCollectionData(SystemData* sys);
+	bool isBundled(const CollectionSystemData& sysData);
 	void addRandomGames(SystemData* newSys, SystemData* sourceSystem, FileData* rootFolder, FileFilterIndex* index,
-		std::map<std::string, std::map<std::string, int>> mapsForRandomColl, int defaultValue);
-	void populateRandomCollectionFromCollections(std::map<std::string, std::map<std::string, int>> mapsForRandomColl);
+		const std::map<std::string, std::map<std::string, int>>& mapsForRandomColl, int defaultValue);
+	void populateRandomCollectionFromCollections(const std::map<std::string, std::map<std::string, int>>& mapsForRandomColl);
 
 	void removeCollectionsFromDisplayedSystems();
 	void addEnabledCollectionsToDisplayedSystems(std::map<std::string, CollectionSystemData>* colSystemData, bool processRandom);
@@ -150,8 +160,10 @@ private:
 
 	SystemData* mCustomCollectionsBundle;
 	SystemData* mRandomCollection;
+	bool mPopulating;
 
 	static const int DOUBLE_PRESS_DETECTION_DURATION = 1500; // millis
+	static const unsigned int IDLE_POPULATE_DELAY = 3000; // millis
 };
 
 std::string getCustomCollectionConfigPath(std::string collectionName);
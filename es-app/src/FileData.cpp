@@ -1,34 +1,126 @@
 #include "FileData.h"
 
+#include "resources/Font.h"
+#include "resources/SVGCache.h"
 #include "utils/FileSystemUtil.h"
 #include "utils/StringUtil.h"
+#include "utils/TaskScheduler.h"
 #include "utils/TimeUtil.h"
 #include "AudioManager.h"
 #include "CollectionSystemManager.h"
+#include "FileDataPool.h"
 #include "FileFilterIndex.h"
 #include "FileSorts.h"
+#include "Gamelist.h"
+#include "GameSearchIndex.h"
 #include "InputManager.h"
 #include "Log.h"
 #include "MameNames.h"
+#include "MediaIndex.h"
+#include "MemoryUsage.h"
 #include "platform.h"
 #include "Scripting.h"
 #include "SystemData.h"
 #include "VolumeControl.h"
 #include "Window.h"
+#include <algorithm>
 #include <assert.h>
 
+std::unordered_map<std::string, FileData*> FileData::sGamesByPath;
+std::mutex FileData::sGamesByPathMutex;
+std::vector<MetaDataListener*> FileData::sMetaDataListeners;
+
+FileData* FileData::findGame(const std::string& path)
+{
+	const std::unique_lock<std::mutex> lock(sGamesByPathMutex);
+	auto it = sGamesByPath.find(path);
+	return it != sGamesByPath.cend() ? it->second : NULL;
+}
+
+void FileData::forgetGames(SystemData* system)
+{
+	const std::unique_lock<std::mutex> lock(sGamesByPathMutex);
+	for(auto it = sGamesByPath.begin(); it != sGamesByPath.end(); )
+	{
+		if(it->second->getSystem() == system)
+			it = sGamesByPath.erase(it);
+		else
+			it++;
+	}
+}
+
+void FileData::addMetaDataListener(MetaDataListener* listener)
+{
+	sMetaDataListeners.push_back(listener);
+}
+
+void FileData::removeMetaDataListener(MetaDataListener* listener)
+{
+	sMetaDataListeners.erase(std::remove(sMetaDataListeners.begin(), sMetaDataListeners.end(), listener), sMetaDataListeners.end());
+}
+
+void FileData::changeMetaData(const std::function<void(MetaDataList& metadata)>& change)
+{
+	FileData* game = getSourceFileData();
+	FileFilterIndex* index = (game->mType == GAME) ? game->mSystem->getIndex() : NULL;
+
+	// by position, a listener may remove itself
+	for(size_t i = 0; i < sMetaDataListeners.size(); i++)
+		sMetaDataListeners[i]->onMetaDataChanging(game);
+
+	if(index)
+		index->removeFromIndex(game);
+
+	change(game->metadata);
+
+	if(index)
+		index->addToIndex(game);
+
+	for(size_t i = 0; i < sMetaDataListeners.size(); i++)
+		sMetaDataListeners[i]->onMetaDataChanged(game);
+}
+
 FileData::FileData(FileType type, const std::string& path, SystemEnvironmentData* envData, SystemData* system)
-	: mType(type), mPath(path), mSystem(system), mEnvData(envData), mSourceFileData(NULL), mParent(NULL), metadata(type == GAME ? GAME_METADATA : FOLDER_METADATA) // metadata is REALLY set in the constructor!
+	: mType(type), mSystem(system), mEnvData(envData), mSourceFileData(NULL), mParent(NULL), mFilteredIndex(NULL), mFilteredGeneration(0), mFilteredValid(false), mSortedGeneration(0), mSortedValid(false), mTreeGeneration(0), mGameCount(0), mGameCountValid(false), mDisplayedGameCount(0), mDisplayedIndex(NULL), mDisplayedGeneration(0), mDisplayedValid(false), mLettersIndex(NULL), mLettersGeneration(0), mLettersChangeCount(0), mLettersValid(false), mChildrenByFilenameValid(true), metadata(type == GAME ? GAME_METADATA : FOLDER_METADATA) // metadata is REALLY set in the constructor!
 {
+	// only the file name is stored per node, the directory it's in is shared with its siblings
+	const size_t split = path.find_last_of('/') + 1; // 0 when there's no '/', the path is just a file name then
+	mPathDirectory = Utils::String::intern(path.substr(0, split));
+	mPathFile = path.substr(split);
+
 	// metadata needs at least a name field (since that's what getName() will return)
-	if(metadata.get("name").empty())
-		metadata.set("name", getDisplayName());
+	if(metadata.get(MD_ID_NAME).empty())
+		metadata.set(MD_ID_NAME, getDisplayName());
 	mSystemName = system->getName();
 	metadata.resetChangedFlag();
+
+	// systems load on several threads at once
+	if(mType == GAME && !system->isCollection())
+	{
+		const std::unique_lock<std::mutex> lock(sGamesByPathMutex);
+		sGamesByPath.insert(std::make_pair(path, this));
+	}
+}
+
+FileData::FileData(FileData* source, SystemData* system)
+	: mType(source->mType), mSystem(system), mEnvData(source->mEnvData), mSourceFileData(source), mParent(NULL), mFilteredIndex(NULL), mFilteredGeneration(0), mFilteredValid(false), mSortedGeneration(0), mSortedValid(false), mTreeGeneration(0), mGameCount(0), mGameCountValid(false), mDisplayedGameCount(0), mDisplayedIndex(NULL), mDisplayedGeneration(0), mDisplayedValid(false), mLettersIndex(NULL), mLettersGeneration(0), mLettersChangeCount(0), mLettersValid(false), mChildrenByFilenameValid(true), metadata(source->metadata), mPathDirectory(source->mPathDirectory), mPathFile(source->mPathFile), mSystemName(source->getSystem()->getName())
+{
+	// the values are interned, the copy only holds pointers to the strings of the source
+	metadata.resetChangedFlag();
 }
 
 FileData::~FileData()
 {
+	if(mType == GAME && !mSystem->isCollection())
+	{
+		const std::unique_lock<std::mutex> lock(sGamesByPathMutex);
+		auto it = sGamesByPath.find(getPath());
+		if(it != sGamesByPath.cend() && it->second == this)
+			sGamesByPath.erase(it);
+
+		GameSearchIndex::forget(this);
+	}
+
 	if(mParent)
 		mParent->removeChild(this);
 
@@ -38,10 +130,30 @@ FileData::~FileData()
 	mChildren.clear();
 }
 
+void* FileData::operator new(size_t size)
+{
+	return FileDataPool::allocate(nullptr, size);
+}
+
+void* FileData::operator new(size_t size, FileDataPool* pool)
+{
+	return FileDataPool::allocate(pool, size);
+}
+
+void FileData::operator delete(void* ptr)
+{
+	FileDataPool::release(ptr);
+}
+
+void FileData::operator delete(void* ptr, FileDataPool* /*pool*/)
+{
+	FileDataPool::release(ptr);
+}
+
 std::string FileData::getDisplayName() const
 {
-	std::string stem = Utils::FileSystem::getStem(mPath);
-	if(mSystem && mSystem->hasPlatformId(PlatformIds::ARCADE) || mSystem->hasPlatformId(PlatformIds::NEOGEO))
+	std::string stem = Utils::FileSystem::getStem(getPath());
+	if(mSystem && (mSystem->hasPlatformId(PlatformIds::ARCADE) || mSystem->hasPlatformId(PlatformIds::NEOGEO)))
 		stem = MameNames::getInstance()->getRealName(stem);
 
 	return stem;
@@ -54,12 +166,12 @@ std::string FileData::getCleanName() const
 
 const std::string FileData::getThumbnailPath() const
 {
-	std::string thumbnail = metadata.get("thumbnail");
+	std::string thumbnail = metadata.get(MD_ID_THUMBNAIL);
 
 	// no thumbnail, try image
 	if(thumbnail.empty())
 	{
-		thumbnail = metadata.get("image");
+		thumbnail = metadata.get(MD_ID_IMAGE);
 
 		// no image, try to use local image
 		if(thumbnail.empty() && Settings::getInstance()->getBool("LocalArt"))
@@ -70,7 +182,7 @@ const std::string FileData::getThumbnailPath() const
 				if(thumbnail.empty())
 				{
 					std::string path = mEnvData->mStartPath + "/images/" + getDisplayName() + "-image" + extList[i];
-					if(Utils::FileSystem::exists(path))
+					if(MediaIndex::getInstance()->exists(path))
 						thumbnail = path;
 				}
 			}
@@ -82,21 +194,25 @@ const std::string FileData::getThumbnailPath() const
 
 const std::string& FileData::getName()
 {
-	return metadata.get("name");
+	return metadata.get(MD_ID_NAME);
 }
 
 const std::string& FileData::getSortName()
 {
-	if (metadata.get("sortname").empty())
-		return metadata.get("name");
+	if (metadata.get(MD_ID_SORTNAME).empty())
+		return metadata.get(MD_ID_NAME);
 	else
-		return metadata.get("sortname");
+		return metadata.get(MD_ID_SORTNAME);
 }
 
 const std::vector<FileData*>& FileData::getChildrenListToDisplay() {
 
 	FileFilterIndex* idx = CollectionSystemManager::get()->getSystemToView(mSystem)->getIndex();
 	if (idx->isFiltered()) {
+		const unsigned int generation = FileFilterIndex::getGeneration();
+		if (mFilteredValid && mFilteredIndex == idx && mFilteredGeneration == generation)
+			return mFilteredChildren;
+
 		mFilteredChildren.clear();
 		for(auto it = mChildren.cbegin(); it != mChildren.cend(); it++)
 		{
@@ -105,6 +221,9 @@ const std::vector<FileData*>& FileData::getChildrenListToDisplay() {
 			}
 		}
 
+		mFilteredIndex = idx;
+		mFilteredGeneration = generation;
+		mFilteredValid = true;
 		return mFilteredChildren;
 	}
 	else
@@ -113,15 +232,53 @@ const std::vector<FileData*>& FileData::getChildrenListToDisplay() {
 	}
 }
 
+const std::vector<FileData::LetterIndex>& FileData::getLetterIndex()
+{
+	const std::vector<FileData*>& list = getChildrenListToDisplay();
+
+	// the filtered list is rebuilt with the filters, the letters change with the names
+	FileFilterIndex* idx = CollectionSystemManager::get()->getSystemToView(mSystem)->getIndex();
+	FileFilterIndex* filter = idx->isFiltered() ? idx : NULL;
+	const unsigned int generation = filter ? FileFilterIndex::getGeneration() : 0;
+	const unsigned int changeCount = MetaDataList::getChangeCount();
+	if (mLettersValid && mLettersIndex == filter && mLettersGeneration == generation && mLettersChangeCount == changeCount)
+		return mLetters;
+
+	// where each letter is in mLetters, -1 until it shows up
+	int slots[256];
+	std::fill(slots, slots + 256, -1);
+
+	mLetters.clear();
+	for(size_t i = 0; i < list.size(); i++)
+	{
+		const std::string key = FileSorts::getNameKey(list[i]);
+		const unsigned char letter = key.empty() ? '\0' : (unsigned char)key[0];
+
+		if (slots[letter] < 0)
+		{
+			slots[letter] = (int)mLetters.size();
+			mLetters.push_back({ (char)letter, (unsigned int)i, 0 });
+		}
+
+		mLetters[slots[letter]].count++;
+	}
+
+	mLettersIndex = filter;
+	mLettersGeneration = generation;
+	mLettersChangeCount = changeCount;
+	mLettersValid = true;
+	return mLetters;
+}
+
 const std::string FileData::getVideoPath() const
 {
-	std::string video = metadata.get("video");
+	std::string video = metadata.get(MD_ID_VIDEO);
 
 	// no video, try to use local video
 	if(video.empty() && Settings::getInstance()->getBool("LocalArt"))
 	{
 		std::string path = mEnvData->mStartPath + "/images/" + getDisplayName() + "-video.mp4";
-		if(Utils::FileSystem::exists(path))
+		if(MediaIndex::getInstance()->exists(path))
 			video = path;
 	}
 
@@ -130,7 +287,7 @@ const std::string FileData::getVideoPath() const
 
 const std::string FileData::getMarqueePath() const
 {
-	std::string marquee = metadata.get("marquee");
+	std::string marquee = metadata.get(MD_ID_MARQUEE);
 
 	// no marquee, try to use local marquee
 	if(marquee.empty() && Settings::getInstance()->getBool("LocalArt"))
@@ -141,7 +298,7 @@ const std::string FileData::getMarqueePath() const
 			if(marquee.empty())
 			{
 				std::string path = mEnvData->mStartPath + "/images/" + getDisplayName() + "-marquee" + extList[i];
-				if(Utils::FileSystem::exists(path))
+				if(MediaIndex::getInstance()->exists(path))
 					marquee = path;
 			}
 		}
@@ -152,7 +309,7 @@ const std::string FileData::getMarqueePath() const
 
 const std::string FileData::getImagePath() const
 {
-	std::string image = metadata.get("image");
+	std::string image = metadata.get(MD_ID_IMAGE);
 
 	// no image, try to use local image
 	if(image.empty())
@@ -163,7 +320,7 @@ const std::string FileData::getImagePath() const
 			if(image.empty())
 			{
 				std::string path = mEnvData->mStartPath + "/images/" + getDisplayName() + "-image" + extList[i];
-				if(Utils::FileSystem::exists(path))
+				if(MediaIndex::getInstance()->exists(path))
 					image = path;
 			}
 		}
@@ -175,24 +332,62 @@ const std::string FileData::getImagePath() const
 std::vector<FileData*> FileData::getFilesRecursive(unsigned int typeMask, bool displayedOnly) const
 {
 	std::vector<FileData*> out;
-	FileFilterIndex* idx = mSystem->getIndex();
+	forEachFile(typeMask, displayedOnly, [&out](FileData* file) { out.push_back(file); });
+	return out;
+}
 
-	for(auto it = mChildren.cbegin(); it != mChildren.cend(); it++)
+unsigned int FileData::getGameCount(bool displayedOnly)
+{
+	FileFilterIndex* idx = mSystem->getIndex();
+	if (!displayedOnly || !idx->isFiltered())
 	{
-		if((*it)->getType() & typeMask)
+		if (!mGameCountValid)
 		{
-			if (!displayedOnly || !idx->isFiltered() || idx->showFile(*it))
-				out.push_back(*it);
+			mGameCount = 0;
+			for(auto it = mChildren.cbegin(); it != mChildren.cend(); it++)
+			{
+				if((*it)->getType() == GAME)
+					mGameCount++;
+				else if((*it)->getChildren().size() > 0)
+					mGameCount += (*it)->getGameCount();
+			}
+			mGameCountValid = true;
 		}
+		return mGameCount;
+	}
 
-		if((*it)->getChildren().size() > 0)
+	const unsigned int generation = FileFilterIndex::getGeneration();
+	if (!mDisplayedValid || mDisplayedIndex != idx || mDisplayedGeneration != generation)
+	{
+		mDisplayedGameCount = 0;
+		for(auto it = mChildren.cbegin(); it != mChildren.cend(); it++)
 		{
-			std::vector<FileData*> subchildren = (*it)->getFilesRecursive(typeMask, displayedOnly);
-			out.insert(out.cend(), subchildren.cbegin(), subchildren.cend());
+			if((*it)->getType() == GAME)
+				mDisplayedGameCount += idx->showFile(*it) ? 1 : 0;
+			else if((*it)->getChildren().size() > 0)
+				mDisplayedGameCount += (*it)->getGameCount(true);
 		}
+		mDisplayedIndex = idx;
+		mDisplayedGeneration = generation;
+		mDisplayedValid = true;
 	}
+	return mDisplayedGameCount;
+}
 
-	return out;
+bool FileData::isDisplayed(FileData* file) const
+{
+	FileFilterIndex* idx = mSystem->getIndex();
+	return !idx->isFiltered() || idx->showFile(file);
+}
+
+void FileData::onChildrenChanged()
+{
+	for(FileData* folder = this; folder != NULL; folder = folder->mParent)
+	{
+		folder->mTreeGeneration++;
+		folder->mGameCountValid = false;
+		folder->mDisplayedValid = false;
+	}
 }
 
 std::string FileData::getKey() {
@@ -201,12 +396,12 @@ std::string FileData::getKey() {
 
 const bool FileData::isArcadeAsset()
 {
-	const std::string stem = Utils::FileSystem::getStem(mPath);
-	return (
-		(mSystem && (mSystem->hasPlatformId(PlatformIds::ARCADE) || mSystem->hasPlatformId(PlatformIds::NEOGEO)))
-		&&
-		(MameNames::getInstance()->isBios(stem) || MameNames::getInstance()->isDevice(stem))
-	);
+	// only arcade systems have assets, the others don't need the stem
+	if(!mSystem || !(mSystem->hasPlatformId(PlatformIds::ARCADE) || mSystem->hasPlatformId(PlatformIds::NEOGEO)))
+		return false;
+
+	const std::string stem = Utils::FileSystem::getStem(getPath());
+	return (MameNames::getInstance()->isBios(stem) || MameNames::getInstance()->isDevice(stem));
 }
 
 FileData* FileData::getSourceFileData()
@@ -220,11 +415,15 @@ void FileData::addChild(FileData* file)
 	assert(file->getParent() == NULL);
 
 	const std::string key = file->getKey();
-	if (mChildrenByFilename.find(key) == mChildrenByFilename.cend())
+	if (getChildrenByFilename().find(key) == mChildrenByFilename.cend())
 	{
 		mChildrenByFilename[key] = file;
 		mChildren.push_back(file);
 		file->mParent = this;
+		mFilteredValid = false;
+		mSortedValid = false;
+		mLettersValid = false;
+		onChildrenChanged();
 	}
 }
 
@@ -232,13 +431,17 @@ void FileData::removeChild(FileData* file)
 {
 	assert(mType == FOLDER);
 	assert(file->getParent() == this);
-	mChildrenByFilename.erase(file->getKey());
+	if (mChildrenByFilenameValid)
+		mChildrenByFilename.erase(file->getKey());
 	for(auto it = mChildren.cbegin(); it != mChildren.cend(); it++)
 	{
 		if(*it == file)
 		{
 			file->mParent = NULL;
-			mChildren.erase(it);
+			mChildren.erase(it); // the rest stays in order
+			mFilteredValid = false;
+			mLettersValid = false;
+			onChildrenChanged();
 			return;
 		}
 	}
@@ -248,32 +451,204 @@ void FileData::removeChild(FileData* file)
 
 }
 
-void FileData::sort(ComparisonFunction& comparator, bool ascending)
+const std::unordered_map<std::string, FileData*>& FileData::getChildrenByFilename() const
 {
-	if (ascending)
+	if (!mChildrenByFilenameValid)
 	{
-		std::stable_sort(mChildren.begin(), mChildren.end(), comparator);
-		for(auto it = mChildren.cbegin(); it != mChildren.cend(); it++)
+		for (auto it = mChildren.cbegin(); it != mChildren.cend(); it++)
+			mChildrenByFilename[(*it)->getKey()] = *it;
+
+		mChildrenByFilenameValid = true;
+	}
+
+	return mChildrenByFilename;
+}
+
+void FileData::releaseChildrenByFilename()
+{
+	// clear() would keep the buckets
+	std::unordered_map<std::string, FileData*>().swap(mChildrenByFilename);
+	mChildrenByFilenameValid = false;
+
+	for (auto it = mChildren.cbegin(); it != mChildren.cend(); it++)
+	{
+		if ((*it)->getType() == FOLDER)
+			(*it)->releaseChildrenByFilename();
+	}
+}
+
+std::string FileData::getDescription() const
+{
+	const uint32_t offset = metadata.getDeferredDesc();
+	if (!offset)
+		return metadata.get(MD_ID_DESC);
+
+	// the one of a collection entry is in the snapshot of the system its game is in
+	const FileData* source = mSourceFileData ? mSourceFileData : this;
+	return loadGamelistDescription(source->getSystem(), offset);
+}
+
+void FileData::loadDescription()
+{
+	if (!metadata.getDeferredDesc())
+		return;
+
+	// it's still the same description, nothing to save
+	const bool changed = metadata.wasChanged();
+	metadata.set(MD_ID_DESC, getDescription());
+	if (!changed)
+		metadata.resetChangedFlag();
+}
+
+typedef std::pair<std::string, FileData*> SortKeyPair;
+
+static bool compareSortKeys(const SortKeyPair& a, const SortKeyPair& b)
+{
+	return a.first < b.first;
+}
+
+// anything smaller sorts faster on one thread than it takes to hand the work out
+static const size_t PARALLEL_SORT_THRESHOLD = 4096;
+
+template<typename T, typename Compare>
+static void stableSort(std::vector<T>& items, Compare compare, bool ascending, Utils::TaskScheduler* scheduler)
+{
+	// same order as a stable sort over reverse iterators, equal items end up in reverse order
+	if(!ascending)
+		std::reverse(items.begin(), items.end());
+
+	if(scheduler && items.size() >= PARALLEL_SORT_THRESHOLD)
+	{
+		// sort one run per core in parallel, then merge neighbouring runs until only one is left
+		const size_t runSize = (items.size() + std::max(2u, std::thread::hardware_concurrency()) - 1) / std::max(2u, std::thread::hardware_concurrency());
+		std::vector<size_t> bounds;
+		for(size_t pos = 0; pos < items.size(); pos += runSize)
+			bounds.push_back(pos);
+		bounds.push_back(items.size());
+
+		const size_t runCount = bounds.size() - 1;
+		Utils::TaskScheduler::Group pending;
+
+		for(size_t i = 0; i < runCount; i++)
 		{
-			if((*it)->getChildren().size() > 0)
-				(*it)->sort(comparator, ascending);
+			scheduler->queue([&items, &bounds, compare, i]
+			{
+				std::stable_sort(items.begin() + bounds[i], items.begin() + bounds[i + 1], compare);
+			}, Utils::TaskScheduler::PRIORITY_NORMAL, &pending);
+		}
+		pending.wait();
+
+		// inplace_merge keeps equal items of the left run first, so the result stays stable
+		for(size_t width = 1; width < runCount; width *= 2)
+		{
+			for(size_t i = 0; (i + width) < runCount; i += (2 * width))
+			{
+				const size_t last = std::min(i + (2 * width), runCount);
+				scheduler->queue([&items, &bounds, compare, i, width, last]
+				{
+					std::inplace_merge(items.begin() + bounds[i], items.begin() + bounds[i + width], items.begin() + bounds[last], compare);
+				}, Utils::TaskScheduler::PRIORITY_NORMAL, &pending);
+			}
+			pending.wait();
 		}
 	}
 	else
+		std::stable_sort(items.begin(), items.end(), compare);
+
+	if(!ascending)
+		std::reverse(items.begin(), items.end());
+}
+
+bool FileData::isSorted(const SortType& type, unsigned int generation) const
+{
+	return mSortedValid && mSortedGeneration == generation && mSortDesc == type.description;
+}
+
+void FileData::sort(const SortType& type, unsigned int generation, Utils::TaskScheduler* scheduler)
+{
+	// nothing changed since the last time this folder got this sort, its children are already in order
+	if (!isSorted(type, generation))
 	{
-		std::stable_sort(mChildren.rbegin(), mChildren.rend(), comparator);
-		for(auto it = mChildren.rbegin(); it != mChildren.rend(); it++)
+		mFilteredValid = false;
+		mLettersValid = false;
+
+		if (type.keyFunction)
 		{
-			if((*it)->getChildren().size() > 0)
-				(*it)->sort(comparator, ascending);
+			// every key is built once up front, instead of twice for every comparison
+			std::vector<SortKeyPair> keys;
+			keys.reserve(mChildren.size());
+			for(auto it = mChildren.cbegin(); it != mChildren.cend(); it++)
+				keys.push_back(SortKeyPair(type.keyFunction(*it), *it));
+
+			stableSort(keys, compareSortKeys, type.ascending, scheduler);
+
+			for(size_t i = 0; i < keys.size(); i++)
+				mChildren[i] = keys[i].second;
 		}
+		else
+			stableSort(mChildren, type.comparisonFunction, type.ascending, scheduler);
+
+		mSortDesc = type.description;
+		mSortedGeneration = generation;
+		mSortedValid = true;
+	}
+
+	// subfolders don't depend on each other, with a scheduler they're sorted side by side
+	Utils::TaskScheduler::Group pendingFolders;
+
+	for(auto it = mChildren.cbegin(); it != mChildren.cend(); it++)
+	{
+		FileData* child = *it;
+		if(child->getChildren().size() == 0)
+			continue;
+
+		if(scheduler)
+			scheduler->queue([child, &type, generation, scheduler] { child->sort(type, generation, scheduler); }, Utils::TaskScheduler::PRIORITY_NORMAL, &pendingFolders);
+		else
+			child->sort(type, generation, scheduler);
 	}
+
+	pendingFolders.wait();
+}
+
+void FileData::resortChild(FileData* file, const SortType& type)
+{
+	assert(mType == FOLDER);
+	assert(file->getParent() == this);
+
+	if(mSortDesc != type.description)
+	{
+		sort(type);
+		return;
+	}
+
+	auto it = std::find(mChildren.begin(), mChildren.end(), file);
+	assert(it != mChildren.end());
+	mChildren.erase(it);
+
+	// a binary search for the new place, the rest only has to shift by one
+	if(type.ascending)
+		it = std::upper_bound(mChildren.begin(), mChildren.end(), file, type.comparisonFunction);
+	else
+		it = std::upper_bound(mChildren.begin(), mChildren.end(), file, [&type](const FileData* a, const FileData* b) { return type.comparisonFunction(b, a); });
+
+	mChildren.insert(it, file);
+	mSortedValid = true; // in order again after addChild()
+	mFilteredValid = false;
+	mLettersValid = false;
 }
 
 void FileData::sort(const SortType& type)
 {
-	sort(*type.comparisonFunction, type.ascending);
-	mSortDesc = type.description;
+	const unsigned int generation = FileSorts::getGeneration();
+	Utils::TaskScheduler* scheduler = SystemData::getLoadScheduler();
+
+	// outside of loading only a big folder that really needs sorting is worth spreading across threads
+	if(!scheduler && (mChildren.size() >= PARALLEL_SORT_THRESHOLD) && !isSorted(type, generation) &&
+	   (std::thread::hardware_concurrency() > 2) && Settings::getInstance()->getBool("ThreadedLoading"))
+		scheduler = Utils::TaskScheduler::getInstance();
+
+	sort(type, generation, scheduler);
 }
 
 void FileData::launchGame(Window* window)
@@ -285,6 +660,15 @@ void FileData::launchGame(Window* window)
 	InputManager::getInstance()->deinit();
 	window->deinit();
 
+	// what's built again once it's shown goes, so the emulator gets the RAM. The views of other systems were dropped
+	// by the ViewController before this
+	if(Settings::getInstance()->getBool("TrimMemoryDuringGames"))
+	{
+		Font::releaseTextCaches();
+		SVGCache::clear();
+		trimHeap();
+	}
+
 	std::string command = mEnvData->mLaunchCommand;
 
 	const std::string rom      = Utils::FileSystem::getEscapedPath(getPath());
@@ -317,25 +701,23 @@ void FileData::launchGame(Window* window)
 
 	FileData* gameToUpdate = getSourceFileData();
 
-	int timesPlayed = gameToUpdate->metadata.getInt("playcount") + 1;
-	gameToUpdate->metadata.set("playcount", std::to_string(static_cast<long long>(timesPlayed)));
+	gameToUpdate->changeMetaData([](MetaDataList& metadata)
+	{
+		int timesPlayed = metadata.getInt(MD_ID_PLAYCOUNT) + 1;
+		metadata.set(MD_ID_PLAYCOUNT, std::to_string(static_cast<long long>(timesPlayed)));
 
-	//update last played time
-	gameToUpdate->metadata.set("lastplayed", Utils::Time::DateTime(Utils::Time::now()));
-	CollectionSystemManager::get()->refreshCollectionSystems(gameToUpdate);
+		//update last played time
+		metadata.set(MD_ID_LASTPLAYED, Utils::Time::DateTime(Utils::Time::now()));
+	});
 
 	gameToUpdate->mSystem->onMetaDataSavePoint();
 }
 
 CollectionFileData::CollectionFileData(FileData* file, SystemData* system)
-	: FileData(file->getSourceFileData()->getType(), file->getSourceFileData()->getPath(), file->getSourceFileData()->getSystemEnvData(), system)
+	: FileData(file->getSourceFileData(), system), mCollectionFileNameSource(NULL)
 {
-	// we use this constructor to create a clone of the filedata, and change its system
-	mSourceFileData = file->getSourceFileData();
-	refreshMetadata();
-	mParent = NULL;
-	metadata = mSourceFileData->metadata;
-	mSystemName = mSourceFileData->getSystem()->getName();
+	// these come from the heap, not from a pool
+	MemoryUsage::add(MemoryUsage::COLLECTIONS, sizeof(CollectionFileData));
 }
 
 CollectionFileData::~CollectionFileData()
@@ -344,6 +726,8 @@ CollectionFileData::~CollectionFileData()
 	if(mParent)
 		mParent->removeChild(this);
 	mParent = NULL;
+
+	MemoryUsage::remove(MemoryUsage::COLLECTIONS, sizeof(CollectionFileData));
 }
 
 std::string CollectionFileData::getKey() {
@@ -357,21 +741,24 @@ FileData* CollectionFileData::getSourceFileData()
 
 void CollectionFileData::refreshMetadata()
 {
+	// pointers to the interned values of the source, nothing is copied but those
 	metadata = mSourceFileData->metadata;
-	mDirty = true;
 }
 
 const std::string& CollectionFileData::getName()
 {
-	if (mDirty) {
-		mCollectionFileName = Utils::String::removeParenthesis(mSourceFileData->metadata.get("name"));
+	const std::string& name = mSourceFileData->metadata.get(MD_ID_NAME);
+	if (!Settings::getInstance()->getBool("CollectionShowSystemInfo"))
+		return name;
+
+	// interned, a different string is a different name
+	if (mCollectionFileNameSource != &name) {
+		mCollectionFileName = Utils::String::removeParenthesis(name);
 		mCollectionFileName += " [" + Utils::String::toUpper(mSourceFileData->getSystem()->getName()) + "]";
-		mDirty = false;
+		mCollectionFileNameSource = &name;
 	}
 
-	if (Settings::getInstance()->getBool("CollectionShowSystemInfo"))
-		return mCollectionFileName;
-	return mSourceFileData->metadata.get("name");
+	return mCollectionFileName;
 }
 
 // returns Sort Type based on a string description
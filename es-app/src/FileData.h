@@ -4,8 +4,16 @@
 
 #include "utils/FileSystemUtil.h"
 #include "MetaData.h"
+#include <functional>
+#include <mutex>
 #include <unordered_map>
+#include <vector>
 
+namespace Utils { class TaskScheduler; }
+
+class FileData;
+class FileDataPool;
+class FileFilterIndex;
 class SystemData;
 class Window;
 struct SystemEnvironmentData;
@@ -29,6 +37,18 @@ enum FileChangeType
 const char* fileTypeToString(FileType type);
 FileType stringToFileType(const char* str);
 
+// Told about every metadata change made through FileData::changeMetaData(). What's derived from metadata, like
+// collections, search and views, subscribes instead of being updated by every place that changes it. Main thread only
+class MetaDataListener
+{
+public:
+	virtual ~MetaDataListener() { }
+
+	// the game still has its old values
+	virtual void onMetaDataChanging(FileData* /*game*/) { }
+	virtual void onMetaDataChanged(FileData* game) = 0;
+};
+
 // A tree node that holds information for a file.
 class FileData
 {
@@ -36,12 +56,27 @@ public:
 	FileData(FileType type, const std::string& path, SystemEnvironmentData* envData, SystemData* system);
 	virtual ~FileData();
 
+	// the games and folders of a system come from its pool, new (system->getFileDataPool()) FileData(...)
+	static void* operator new   (size_t size);
+	static void* operator new   (size_t size, FileDataPool* pool);
+	static void  operator delete(void* ptr);
+	static void  operator delete(void* ptr, FileDataPool* pool);
+
+	// the game with this full path in any loaded system, collections excluded, NULL if there's none.
+	// when systems share a folder, the first loaded game at that path is returned
+	static FileData* findGame(const std::string& path);
+	// the games of a system are freed with its pool without being destroyed one by one, they're forgotten here first
+	static void forgetGames(SystemData* system);
+
+	static void addMetaDataListener   (MetaDataListener* listener);
+	static void removeMetaDataListener(MetaDataListener* listener);
+
 	virtual const std::string& getName();
 	virtual const std::string& getSortName();
 	inline FileType getType() const { return mType; }
-	inline const std::string& getPath() const { return mPath; }
+	inline std::string getPath() const { return *mPathDirectory + mPathFile; }
 	inline FileData* getParent() const { return mParent; }
-	inline const std::unordered_map<std::string, FileData*>& getChildrenByFilename() const { return mChildrenByFilename; }
+	const std::unordered_map<std::string, FileData*>& getChildrenByFilename() const;
 	inline const std::vector<FileData*>& getChildren() const { return mChildren; }
 	inline SystemData* getSystem() const { return mSystem; }
 	inline SystemEnvironmentData* getSystemEnvData() const { return mEnvData; }
@@ -51,10 +86,26 @@ public:
 	virtual const std::string getImagePath() const;
 
 	const std::vector<FileData*>& getChildrenListToDisplay();
+	struct LetterIndex
+	{
+		char letter; // the first character of FileSorts::getNameKey()
+		unsigned int first; // where the first child starting with it is in getChildrenListToDisplay()
+		unsigned int count;
+	};
+	// the letters of getChildrenListToDisplay() in the order they first show up, built again only when the list or a name changed
+	const std::vector<LetterIndex>& getLetterIndex();
 	std::vector<FileData*> getFilesRecursive(unsigned int typeMask, bool displayedOnly = false) const;
+	// getFilesRecursive(GAME, displayedOnly).size(), counted again only below folders whose children, index or filters changed
+	unsigned int getGameCount(bool displayedOnly = false);
+	// calls visit(file) for the same files as getFilesRecursive() in the same order, without collecting them first
+	template<typename Visitor> void forEachFile(unsigned int typeMask, bool displayedOnly, Visitor&& visit) const;
+	// goes up with every file added to or removed from this folder or the ones below it
+	inline unsigned int getTreeGeneration() const { return mTreeGeneration; }
 
 	void addChild(FileData* file); // Error if mType != FOLDER
 	void removeChild(FileData* file); //Error if mType != FOLDER
+	// frees getChildrenByFilename() of this folder and the ones below it, it's built again for a folder that needs it
+	void releaseChildrenByFilename();
 
 	inline bool isPlaceHolder() { return mType == PLACEHOLDER; };
 
@@ -67,6 +118,11 @@ public:
 	virtual FileData* getSourceFileData();
 	inline std::string getSystemName() const { return mSystemName; };
 
+	// the description in the metadata, or the one left in the gamelist snapshot
+	std::string getDescription() const;
+	// puts a description left in the snapshot into the metadata, for when all of it is edited
+	void loadDescription();
+
 	// Returns our best guess at the "real" name for this file (will attempt to perform MAME name translation)
 	std::string getDisplayName() const;
 
@@ -76,35 +132,73 @@ public:
 	void launchGame(Window* window);
 
 	typedef bool ComparisonFunction(const FileData* a, const FileData* b);
+	typedef std::string SortKeyFunction(const FileData* file);
 	struct SortType
 	{
 		ComparisonFunction* comparisonFunction;
+		SortKeyFunction* keyFunction; // if set, sorting compares these keys, computed once per file, instead of calling comparisonFunction
 		bool ascending;
 		std::string description;
 
-		SortType(ComparisonFunction* sortFunction, bool sortAscending, const std::string & sortDescription)
-			: comparisonFunction(sortFunction), ascending(sortAscending), description(sortDescription) {}
+		SortType(ComparisonFunction* sortFunction, bool sortAscending, const std::string & sortDescription, SortKeyFunction* sortKeyFunction = NULL)
+			: comparisonFunction(sortFunction), keyFunction(sortKeyFunction), ascending(sortAscending), description(sortDescription) {}
 	};
 
 	void sort(const SortType& type);
+	// moves a single child to where sort() would put it after it was added or changed, the other children must still be in order.
+	// falls back to a full sort() when the folder wasn't sorted by this type.
+	void resortChild(FileData* file, const SortType& type);
 	std::string getSortDescription() { return mSortDesc; }
+	// the only part of a game other threads may read while the main thread runs, see MetaDataList. the tree itself is
+	// the main thread's, work done elsewhere takes what it needs from it there
 	MetaDataList metadata;
+	// changes the metadata of the source game in change, its own filter index is kept up to date before the listeners
+	// hear of it. this is how metadata is changed once everything is loaded
+	void changeMetaData(const std::function<void(MetaDataList& metadata)>& change);
 
 protected:
+	// a collection entry of source, it takes the path and metadata of source as they are
+	FileData(FileData* source, SystemData* system);
+
 	FileData* mSourceFileData;
 	FileData* mParent;
 	std::string mSystemName;
 
 private:
-	void sort(ComparisonFunction& comparator, bool ascending = true);
+	void sort(const SortType& type, unsigned int generation, Utils::TaskScheduler* scheduler);
+	bool isSorted(const SortType& type, unsigned int generation) const;
+	static std::unordered_map<std::string, FileData*> sGamesByPath;
+	static std::mutex sGamesByPathMutex;
+	static std::vector<MetaDataListener*> sMetaDataListeners;
 	FileType mType;
-	std::string mPath;
+	const std::string* mPathDirectory; // interned and shared by everything in the same directory, ends with the '/'
+	std::string mPathFile;
 	SystemEnvironmentData* mEnvData;
 	SystemData* mSystem;
-	std::unordered_map<std::string,FileData*> mChildrenByFilename;
+	mutable std::unordered_map<std::string,FileData*> mChildrenByFilename;
+	mutable bool mChildrenByFilenameValid;
 	std::vector<FileData*> mChildren;
-	std::vector<FileData*> mFilteredChildren;
+	std::vector<FileData*> mFilteredChildren; // only rebuilt when the children, the index or the filters change
+	FileFilterIndex* mFilteredIndex;
+	unsigned int mFilteredGeneration;
+	bool mFilteredValid;
 	std::string mSortDesc;
+	unsigned int mSortedGeneration; // the children are still in the order of mSortDesc while this matches FileSorts::getGeneration()
+	bool mSortedValid;
+	bool isDisplayed(FileData* file) const; // by the index of mSystem
+	void onChildrenChanged(); // for this folder and the ones it's in
+	unsigned int mTreeGeneration;
+	unsigned int mGameCount;
+	bool mGameCountValid;
+	unsigned int mDisplayedGameCount;
+	FileFilterIndex* mDisplayedIndex;
+	unsigned int mDisplayedGeneration;
+	bool mDisplayedValid;
+	std::vector<LetterIndex> mLetters;
+	FileFilterIndex* mLettersIndex; // NULL when the list wasn't filtered
+	unsigned int mLettersGeneration;
+	unsigned int mLettersChangeCount; // MetaDataList::getChangeCount() at the time
+	bool mLettersValid;
 };
 
 class CollectionFileData : public FileData
@@ -117,11 +211,24 @@ public:
 	FileData* getSourceFileData();
 	std::string getKey();
 private:
-	// needs to be updated when metadata changes
+	// made again when the name of the source changed
 	std::string mCollectionFileName;
-	bool mDirty;
+	const std::string* mCollectionFileNameSource; // the interned name of the source it was made from
 };
 
 FileData::SortType getSortTypeFromString(std::string desc);
 
+template<typename Visitor>
+void FileData::forEachFile(unsigned int typeMask, bool displayedOnly, Visitor&& visit) const
+{
+	for(auto it = mChildren.cbegin(); it != mChildren.cend(); it++)
+	{
+		if(((*it)->getType() & typeMask) && (!displayedOnly || isDisplayed(*it)))
+			visit(*it);
+
+		if((*it)->getChildren().size() > 0)
+			(*it)->forEachFile(typeMask, displayedOnly, visit);
+	}
+}
+
 #endif // ES_APP_FILE_DATA_H
@@ -0,0 +1,97 @@
+#include "FileDataPool.h"
+
+#include "FileData.h"
+#include <new>
+
+// every allocation starts with the pool it belongs to, NULL for the heap, padded so the object stays aligned
+static const size_t HEADER_SIZE     = alignof(max_align_t);
+static const size_t SLOT_SIZE       = HEADER_SIZE + ((sizeof(FileData) + HEADER_SIZE - 1) / HEADER_SIZE * HEADER_SIZE);
+static const size_t SLOTS_PER_BLOCK = 1024;
+
+static_assert(sizeof(FileDataPool*) <= HEADER_SIZE, "FileDataPool header doesn't fit");
+
+FileDataPool::FileDataPool(const MemoryUsage::Subsystem _subsystem) : mFreeList(nullptr), mNext(nullptr), mEnd(nullptr), mCount(0), mSubsystem(_subsystem)
+{
+
+} // FileDataPool
+
+FileDataPool::~FileDataPool()
+{
+	for(auto it = mBlocks.cbegin(); it != mBlocks.cend(); ++it)
+		::operator delete(*it);
+
+	MemoryUsage::remove(mSubsystem, mBlocks.size() * SLOT_SIZE * SLOTS_PER_BLOCK);
+
+} // ~FileDataPool
+
+void* FileDataPool::allocate(FileDataPool* _pool, const size_t _size)
+{
+	char* slot;
+
+	// derived types like CollectionFileData are bigger than a slot and always come from the heap
+	if(_pool && (_size == sizeof(FileData)))
+		slot = (char*)_pool->allocateSlot();
+	else
+	{
+		slot  = (char*)::operator new(HEADER_SIZE + _size);
+		_pool = nullptr;
+	}
+
+	*(FileDataPool**)slot = _pool;
+	return slot + HEADER_SIZE;
+
+} // allocate
+
+void FileDataPool::release(void* _ptr)
+{
+	if(!_ptr)
+		return;
+
+	char*         slot = (char*)_ptr - HEADER_SIZE;
+	FileDataPool* pool = *(FileDataPool**)slot;
+
+	if(pool)
+		pool->releaseSlot(slot);
+	else
+		::operator delete(slot);
+
+} // release
+
+void* FileDataPool::allocateSlot()
+{
+	// folders can be populated from several threads at once
+	const std::unique_lock<std::mutex> lock(mMutex);
+
+	++mCount;
+
+	if(mFreeList)
+	{
+		void* slot = mFreeList;
+		mFreeList  = *(void**)slot;
+		return slot;
+	}
+
+	if(mNext == mEnd)
+	{
+		mNext = (char*)::operator new(SLOT_SIZE * SLOTS_PER_BLOCK);
+		mEnd  = mNext + (SLOT_SIZE * SLOTS_PER_BLOCK);
+		mBlocks.push_back(mNext);
+		MemoryUsage::add(mSubsystem, SLOT_SIZE * SLOTS_PER_BLOCK);
+	}
+
+	void* slot = mNext;
+	mNext += SLOT_SIZE;
+	return slot;
+
+} // allocateSlot
+
+void FileDataPool::releaseSlot(void* _slot)
+{
+	const std::unique_lock<std::mutex> lock(mMutex);
+
+	--mCount;
+
+	*(void**)_slot = mFreeList;
+	mFreeList      = _slot;
+
+} // releaseSlot
@@ -0,0 +1,44 @@
+#pragma once
+#ifndef ES_APP_FILE_DATA_POOL_H
+#define ES_APP_FILE_DATA_POOL_H
+
+#include "MemoryUsage.h"
+#include <mutex>
+#include <stddef.h>
+#include <vector>
+
+// Hands out the memory of the games and folders of one system from large blocks instead of one heap allocation each.
+// Nodes created in a row end up next to each other, which keeps walking the tree cache friendly,
+// and all of the memory goes away in one go when the system is deleted.
+// A freed node goes back to the pool it came from and is reused by the next one created.
+class FileDataPool
+{
+public:
+
+	 FileDataPool(const MemoryUsage::Subsystem _subsystem = MemoryUsage::FILE_DATA);
+	~FileDataPool();
+
+	// Memory for an object of _size bytes, from _pool if there is one and _size is that of a FileData, from the heap otherwise.
+	static void* allocate(FileDataPool* _pool, const size_t _size);
+
+	// Gives back memory from allocate(), to the pool it came from or to the heap.
+	static void  release (void* _ptr);
+
+	size_t getCount() const { return mCount; }
+
+private:
+
+	void* allocateSlot();
+	void  releaseSlot (void* _slot);
+
+	std::vector<char*>     mBlocks;
+	void*                  mFreeList;
+	char*                  mNext;
+	char*                  mEnd;
+	size_t                 mCount;
+	MemoryUsage::Subsystem mSubsystem; // the blocks are counted in
+	std::mutex             mMutex;
+
+}; // FileDataPool
+
+#endif // ES_APP_FILE_DATA_POOL_H
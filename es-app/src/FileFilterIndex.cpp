@@ -6,11 +6,35 @@
 #include "Log.h"
 #include "Settings.h"
 
+static Setting<bool> sForceDisableFilters("ForceDisableFilters");
+
 #define UNKNOWN_LABEL "UNKNOWN"
 #define INCLUDE_UNKNOWN false;
 
+std::atomic<unsigned int> FileFilterIndex::sGeneration(0);
+
+static void setGameBit(std::vector<uint64_t>& set, size_t ordinal)
+{
+	if(set.size() <= (ordinal / 64))
+		set.resize((ordinal / 64) + 1, 0);
+
+	set[ordinal / 64] |= ((uint64_t)1 << (ordinal % 64));
+}
+
+static void clearGameBit(std::vector<uint64_t>& set, size_t ordinal)
+{
+	if(set.size() > (ordinal / 64))
+		set[ordinal / 64] &= ~((uint64_t)1 << (ordinal % 64));
+}
+
+static bool testGameBit(const std::vector<uint64_t>& set, size_t ordinal)
+{
+	return (set.size() > (ordinal / 64)) && ((set[ordinal / 64] & ((uint64_t)1 << (ordinal % 64))) != 0);
+}
+
 FileFilterIndex::FileFilterIndex()
-	: filterByFavorites(false), filterByGenre(false), filterByHidden(false), filterByKidGame(false), filterByPlayers(false), filterByPubDev(false), filterByRatings(false)
+	: filterByFavorites(false), filterByGenre(false), filterByHidden(false), filterByKidGame(false), filterByPlayers(false), filterByPubDev(false), filterByRatings(false),
+	  mOrdinalCount(0), mShownGamesValid(false), mPendingRoot(nullptr)
 {
 	clearAllFilters();
 	FilterDataDecl filterDecls[] = {
@@ -32,13 +56,62 @@ FileFilterIndex::~FileFilterIndex()
 	resetIndex();
 }
 
+size_t FileFilterIndex::getMemoryUsage() const
+{
+	// a std::map node has three pointers and its color next to the value, an unordered_map one a pointer and the hash
+	const size_t mapNode = 4 * sizeof(void*);
+	const size_t hashNode = 2 * sizeof(void*);
+	size_t total = 0;
+
+	total += mGameOrdinals.size() * (sizeof(std::pair<const FileData*, size_t>) + hashNode) + mGameOrdinals.bucket_count() * sizeof(void*);
+	total += mFreeOrdinals.capacity() * sizeof(size_t);
+	total += mGameKeys.capacity() * sizeof(GameKeys);
+	total += mShownGames.capacity() * sizeof(uint64_t);
+
+	for(int type = 0; type < FILTER_TYPE_COUNT; type++)
+	{
+		for(auto it = mGameSets[type].cbegin(); it != mGameSets[type].cend(); it++)
+			total += sizeof(*it) + mapNode + Utils::String::getHeapSize(it->first) + (it->second.capacity() * sizeof(uint64_t));
+	}
+
+	for(auto decl = filterDataDecl.cbegin(); decl != filterDataDecl.cend(); decl++)
+	{
+		for(auto it = decl->allIndexKeys->cbegin(); it != decl->allIndexKeys->cend(); it++)
+			total += sizeof(*it) + mapNode + Utils::String::getHeapSize(it->first);
+	}
+
+	return total;
+}
+
 std::vector<FilterDataDecl>& FileFilterIndex::getFilterDataDecls()
 {
+	// the menu lists every key there is
+	build();
 	return filterDataDecl;
 }
 
+void FileFilterIndex::setPendingRoot(FileData* root)
+{
+	mPendingRoot = root;
+}
+
+void FileFilterIndex::build()
+{
+	if (!mPendingRoot)
+		return;
+
+	FileData* root = mPendingRoot;
+	mPendingRoot = nullptr;
+
+	const std::vector<FileData*> games = root->getFilesRecursive(GAME);
+	for (std::vector<FileData*>::const_iterator it = games.cbegin(); it != games.cend(); ++it)
+		addToIndex(*it);
+}
+
 void FileFilterIndex::importIndex(FileFilterIndex* indexToImport)
 {
+	indexToImport->build();
+
 	struct IndexImportStructure
 	{
 		std::map<std::string, int>* destinationIndex;
@@ -76,6 +149,13 @@ void FileFilterIndex::importIndex(FileFilterIndex* indexToImport)
 void FileFilterIndex::resetIndex()
 {
 	clearAllFilters();
+	mGameOrdinals.clear();
+	mFreeOrdinals.clear();
+	mOrdinalCount = 0;
+	mGameKeys.clear();
+	for (int i = 0; i < FILTER_TYPE_COUNT; i++)
+		mGameSets[i].clear();
+
 	clearIndex(genreIndexAllKeys);
 	clearIndex(playersIndexAllKeys);
 	clearIndex(pubDevIndexAllKeys);
@@ -92,7 +172,7 @@ std::string FileFilterIndex::getIndexableKey(FileData* game, FilterIndexType typ
 	{
 		case GENRE_FILTER:
 		{
-			key = Utils::String::toUpper(game->metadata.get("genre"));
+			key = Utils::String::toUpper(game->metadata.get(MD_ID_GENRE));
 			key = Utils::String::trim(key);
 			if (getSecondary && !key.empty()) {
 				std::istringstream f(key);
@@ -114,18 +194,18 @@ std::string FileFilterIndex::getIndexableKey(FileData* game, FilterIndexType typ
 			if (getSecondary)
 				break;
 
-			key = game->metadata.get("players");
+			key = game->metadata.get(MD_ID_PLAYERS);
 			break;
 		}
 		case PUBDEV_FILTER:
 		{
-			key = Utils::String::toUpper(game->metadata.get("publisher"));
+			key = Utils::String::toUpper(game->metadata.get(MD_ID_PUBLISHER));
 			key = Utils::String::trim(key);
 
 			if ((getSecondary && !key.empty()) || (!getSecondary && key.empty()))
-				key = Utils::String::toUpper(game->metadata.get("developer"));
+				key = Utils::String::toUpper(game->metadata.get(MD_ID_DEVELOPER));
 			else
-				key = Utils::String::toUpper(game->metadata.get("publisher"));
+				key = Utils::String::toUpper(game->metadata.get(MD_ID_PUBLISHER));
 			break;
 		}
 		case RATINGS_FILTER:
@@ -133,7 +213,7 @@ std::string FileFilterIndex::getIndexableKey(FileData* game, FilterIndexType typ
 			int ratingNumber = 0;
 			if (!getSecondary)
 			{
-				std::string ratingString = game->metadata.get("rating");
+				std::string ratingString = game->metadata.get(MD_ID_RATING);
 				if (!ratingString.empty()) {
 					try {
 						ratingNumber = (int)((std::stod(ratingString)*5)+0.5);
@@ -154,21 +234,21 @@ std::string FileFilterIndex::getIndexableKey(FileData* game, FilterIndexType typ
 		{
 			if (game->getType() != GAME)
 				return "FALSE";
-			key = Utils::String::toUpper(game->metadata.get("favorite"));
+			key = Utils::String::toUpper(game->metadata.get(MD_ID_FAVORITE));
 			break;
 		}
 		case HIDDEN_FILTER:
 		{
 			if (game->getType() != GAME)
 				return "FALSE";
-			key = Utils::String::toUpper(game->metadata.get("hidden"));
+			key = Utils::String::toUpper(game->metadata.get(MD_ID_HIDDEN));
 			break;
 		}
 		case KIDGAME_FILTER:
 		{
 			if (game->getType() != GAME)
 				return "FALSE";
-			key = Utils::String::toUpper(game->metadata.get("kidgame"));
+			key = Utils::String::toUpper(game->metadata.get(MD_ID_KIDGAME));
 			break;
 		}
 		default:
@@ -182,30 +262,98 @@ std::string FileFilterIndex::getIndexableKey(FileData* game, FilterIndexType typ
 	return key;
 }
 
+void FileFilterIndex::getIndexableKeys(FileData* game, IndexKeys& keys)
+{
+	for (std::vector<FilterDataDecl>::const_iterator it = filterDataDecl.cbegin(); it != filterDataDecl.cend(); ++it )
+	{
+		keys.primary[(*it).type] = getIndexableKey(game, (*it).type, false);
+		keys.secondary[(*it).type] = (*it).hasSecondaryKey ? getIndexableKey(game, (*it).type, true) : UNKNOWN_LABEL;
+	}
+}
+
+void FileFilterIndex::getGameKeys(size_t ordinal, IndexKeys& keys) const
+{
+	const GameKeys& gameKeys = mGameKeys[ordinal];
+	for (std::vector<FilterDataDecl>::const_iterator it = filterDataDecl.cbegin(); it != filterDataDecl.cend(); ++it )
+	{
+		keys.primary[(*it).type] = *gameKeys.primary[(*it).type];
+		keys.secondary[(*it).type] = gameKeys.secondary[(*it).type] ? *gameKeys.secondary[(*it).type] : UNKNOWN_LABEL;
+	}
+}
+
 void FileFilterIndex::addToIndex(FileData* game)
 {
-	manageGenreEntryInIndex(game);
-	managePlayerEntryInIndex(game);
-	managePubDevEntryInIndex(game);
-	manageRatingsEntryInIndex(game);
-	manageFavoritesEntryInIndex(game);
-	manageHiddenEntryInIndex(game);
-	manageKidGameEntryInIndex(game);
+	// build() finds it in the tree
+	if (mPendingRoot || (mGameOrdinals.find(game) != mGameOrdinals.cend()))
+		return;
+
+	sGeneration++;
+	IndexKeys keys;
+	getIndexableKeys(game, keys);
+	manageEntriesInIndex(keys);
+	addToGameSets(game, keys);
+}
+
+void FileFilterIndex::importGame(const FileFilterIndex* source, const FileData* sourceGame, FileData* game)
+{
+	if (mPendingRoot || (mGameOrdinals.find(game) != mGameOrdinals.cend()))
+		return;
+
+	// the source worked out the keys of its game from the metadata already, only they are copied
+	auto ordinal = source->mGameOrdinals.find(sourceGame);
+	if (ordinal == source->mGameOrdinals.cend())
+	{
+		addToIndex(game);
+		return;
+	}
+
+	sGeneration++;
+	IndexKeys keys;
+	source->getGameKeys(ordinal->second, keys);
+	manageEntriesInIndex(keys);
+	addToGameSets(game, keys);
 }
 
 void FileFilterIndex::removeFromIndex(FileData* game)
 {
-	manageGenreEntryInIndex(game, true);
-	managePlayerEntryInIndex(game, true);
-	managePubDevEntryInIndex(game, true);
-	manageRatingsEntryInIndex(game, true);
-	manageFavoritesEntryInIndex(game, true);
-	manageHiddenEntryInIndex(game, true);
-	manageKidGameEntryInIndex(game, true);
+	// never added, build() won't find it in the tree anymore
+	if (mPendingRoot)
+		return;
+
+	sGeneration++;
+
+	// the metadata may have changed since the game was added, what was counted then is taken back
+	IndexKeys keys;
+	auto ordinal = mGameOrdinals.find(game);
+	if (ordinal != mGameOrdinals.cend())
+		getGameKeys(ordinal->second, keys);
+	else
+		getIndexableKeys(game, keys);
+
+	manageEntriesInIndex(keys, true);
+	removeFromGameSets(game);
+}
+
+void FileFilterIndex::manageEntriesInIndex(const IndexKeys& keys, bool remove)
+{
+	manageGenreEntryInIndex(keys, remove);
+	managePlayerEntryInIndex(keys, remove);
+	managePubDevEntryInIndex(keys, remove);
+	manageRatingsEntryInIndex(keys, remove);
+	manageFavoritesEntryInIndex(keys, remove);
+	manageHiddenEntryInIndex(keys, remove);
+	manageKidGameEntryInIndex(keys, remove);
 }
 
 void FileFilterIndex::setFilter(FilterIndexType type, std::vector<std::string>* values)
 {
+	sGeneration++;
+	mShownGamesValid = false;
+
+	// only keys the index has can be filtered by
+	if(type != NONE)
+		build();
+
 	// test if it exists before setting
 	if(type == NONE)
 	{
@@ -233,6 +381,8 @@ void FileFilterIndex::setFilter(FilterIndexType type, std::vector<std::string>*
 
 void FileFilterIndex::clearAllFilters()
 {
+	sGeneration++;
+	mShownGamesValid = false;
 	for (std::vector<FilterDataDecl>::const_iterator it = filterDataDecl.cbegin(); it != filterDataDecl.cend(); ++it )
 	{
 		FilterDataDecl filterData = (*it);
@@ -250,7 +400,7 @@ void FileFilterIndex::resetFilters()
 
 void FileFilterIndex::setUIModeFilters()
 {
-	if(!Settings::getInstance()->getBool("ForceDisableFilters")){
+	if(!sForceDisableFilters.get()){
 		if (UIModeController::getInstance()->isUIModeKiosk())
 		{
 			filterByHidden = true;
@@ -268,6 +418,7 @@ void FileFilterIndex::setUIModeFilters()
 
 void FileFilterIndex::debugPrintIndexes()
 {
+	build();
 	LOG(LogInfo) << "Printing Indexes...";
 	for (auto x: playersIndexAllKeys) {
 		LOG(LogInfo) << "Multiplayer Index: " << x.first << ": " << x.second;
@@ -301,7 +452,7 @@ bool FileFilterIndex::showFile(FileData* game)
 	// if folder, needs further inspection - i.e. see if folder contains at least one element
 	// that should be shown
 	if (game->getType() == FOLDER) {
-		std::vector<FileData*> children = game->getChildren();
+		const std::vector<FileData*>& children = game->getChildren();
 		// iterate through all of the children, until there's a match
 
 		for (std::vector<FileData*>::const_iterator it = children.cbegin(); it != children.cend(); ++it ) {
@@ -313,6 +464,21 @@ bool FileFilterIndex::showFile(FileData* game)
 		return false;
 	}
 
+	auto ordinal = mGameOrdinals.find(game);
+	if (ordinal != mGameOrdinals.cend())
+	{
+		if (!mShownGamesValid)
+			updateShownGames();
+
+		return testGameBit(mShownGames, ordinal->second);
+	}
+
+	// not indexed here, i.e. games shown by the "My Collections" bundle, look at their keys instead
+	return showFileByKeys(game);
+}
+
+bool FileFilterIndex::showFileByKeys(FileData* game)
+{
 	bool keepGoing = false;
 
 	for (std::vector<FilterDataDecl>::const_iterator it = filterDataDecl.cbegin(); it != filterDataDecl.cend(); ++it ) {
@@ -347,6 +513,99 @@ bool FileFilterIndex::showFile(FileData* game)
 	return keepGoing;
 }
 
+void FileFilterIndex::addToGameSets(FileData* game, const IndexKeys& keys)
+{
+	if (mGameOrdinals.find(game) != mGameOrdinals.cend())
+		return;
+
+	size_t ordinal;
+	if (mFreeOrdinals.empty())
+	{
+		ordinal = mOrdinalCount++;
+	}
+	else
+	{
+		ordinal = mFreeOrdinals.back();
+		mFreeOrdinals.pop_back();
+	}
+	mGameOrdinals[game] = ordinal;
+	if (mGameKeys.size() <= ordinal)
+		mGameKeys.resize(ordinal + 1);
+
+	// same keys as showFileByKeys compares against, secondary keys only count when they're known. The sets are never
+	// erased before resetIndex(), so the game keeps pointers to their keys instead of copies
+	GameKeys& gameKeys = mGameKeys[ordinal];
+	for (std::vector<FilterDataDecl>::const_iterator it = filterDataDecl.cbegin(); it != filterDataDecl.cend(); ++it )
+	{
+		auto set = mGameSets[(*it).type].emplace(keys.primary[(*it).type], GameSet()).first;
+		setGameBit(set->second, ordinal);
+		gameKeys.primary[(*it).type] = &set->first;
+		gameKeys.secondary[(*it).type] = nullptr;
+
+		if ((*it).hasSecondaryKey && (keys.secondary[(*it).type] != UNKNOWN_LABEL))
+		{
+			set = mGameSets[(*it).type].emplace(keys.secondary[(*it).type], GameSet()).first;
+			setGameBit(set->second, ordinal);
+			gameKeys.secondary[(*it).type] = &set->first;
+		}
+	}
+
+	mShownGamesValid = false;
+}
+
+void FileFilterIndex::removeFromGameSets(FileData* game)
+{
+	auto it = mGameOrdinals.find(game);
+	if (it == mGameOrdinals.cend())
+		return;
+
+	const size_t ordinal = it->second;
+	mGameOrdinals.erase(it);
+	mFreeOrdinals.push_back(ordinal);
+
+	// the keys it was added with, its metadata may already have changed
+	const GameKeys& gameKeys = mGameKeys[ordinal];
+	for (std::vector<FilterDataDecl>::const_iterator declIt = filterDataDecl.cbegin(); declIt != filterDataDecl.cend(); ++declIt )
+	{
+		clearGameBit(mGameSets[(*declIt).type][*gameKeys.primary[(*declIt).type]], ordinal);
+		if (gameKeys.secondary[(*declIt).type])
+			clearGameBit(mGameSets[(*declIt).type][*gameKeys.secondary[(*declIt).type]], ordinal);
+	}
+
+	mShownGamesValid = false;
+}
+
+void FileFilterIndex::updateShownGames()
+{
+	const size_t words = (mOrdinalCount + 63) / 64;
+	mShownGames.assign(words, ~(uint64_t)0);
+
+	for (std::vector<FilterDataDecl>::const_iterator it = filterDataDecl.cbegin(); it != filterDataDecl.cend(); ++it )
+	{
+		if (!*((*it).filteredByRef))
+			continue;
+
+		// a game passes a filter when any of the selected keys matches, and has to pass all of them
+		GameSet matches(words, 0);
+		const std::map<std::string, GameSet>& sets = mGameSets[(*it).type];
+
+		for (std::vector<std::string>::const_iterator keyIt = (*it).currentFilteredKeys->cbegin(); keyIt != (*it).currentFilteredKeys->cend(); ++keyIt )
+		{
+			std::map<std::string, GameSet>::const_iterator set = sets.find(*keyIt);
+			if (set == sets.cend())
+				continue;
+
+			for (size_t i = 0; i < set->second.size(); i++)
+				matches[i] |= set->second[i];
+		}
+
+		for (size_t i = 0; i < words; i++)
+			mShownGames[i] &= matches[i];
+	}
+
+	mShownGamesValid = true;
+}
+
 bool FileFilterIndex::isKeyBeingFilteredBy(std::string key, FilterIndexType type)
 {
 	const FilterIndexType filterTypes[7] = { FAVORITES_FILTER, GENRE_FILTER, PLAYER_FILTER, PUBDEV_FILTER, RATINGS_FILTER,HIDDEN_FILTER, KIDGAME_FILTER };
@@ -370,10 +629,10 @@ bool FileFilterIndex::isKeyBeingFilteredBy(std::string key, FilterIndexType type
 	return false;
 }
 
-void FileFilterIndex::manageGenreEntryInIndex(FileData* game, bool remove)
+void FileFilterIndex::manageGenreEntryInIndex(const IndexKeys& keys, bool remove)
 {
 
-	std::string key = getIndexableKey(game, GENRE_FILTER, false);
+	std::string key = keys.primary[GENRE_FILTER];
 
 	// flag for including unknowns
 	bool includeUnknown = INCLUDE_UNKNOWN;
@@ -386,18 +645,18 @@ void FileFilterIndex::manageGenreEntryInIndex(FileData* game, bool remove)
 
 	manageIndexEntry(&genreIndexAllKeys, key, remove);
 
-	key = getIndexableKey(game, GENRE_FILTER, true);
+	key = keys.secondary[GENRE_FILTER];
 	if (!includeUnknown && key == UNKNOWN_LABEL)
 	{
 		manageIndexEntry(&genreIndexAllKeys, key, remove);
 	}
 }
 
-void FileFilterIndex::managePlayerEntryInIndex(FileData* game, bool remove)
+void FileFilterIndex::managePlayerEntryInIndex(const IndexKeys& keys, bool remove)
 {
 	// flag for including unknowns
 	bool includeUnknown = INCLUDE_UNKNOWN;
-	std::string key = getIndexableKey(game, PLAYER_FILTER, false);
+	std::string key = keys.primary[PLAYER_FILTER];
 
 	// only add unknown in pubdev IF both dev and pub are empty
 	if (!includeUnknown && key == UNKNOWN_LABEL) {
@@ -408,10 +667,10 @@ void FileFilterIndex::managePlayerEntryInIndex(FileData* game, bool remove)
 	manageIndexEntry(&playersIndexAllKeys, key, remove);
 }
 
-void FileFilterIndex::managePubDevEntryInIndex(FileData* game, bool remove)
+void FileFilterIndex::managePubDevEntryInIndex(const IndexKeys& keys, bool remove)
 {
-	std::string pub = getIndexableKey(game, PUBDEV_FILTER, false);
-	std::string dev = getIndexableKey(game, PUBDEV_FILTER, true);
+	std::string pub = keys.primary[PUBDEV_FILTER];
+	std::string dev = keys.secondary[PUBDEV_FILTER];
 
 	// flag for including unknowns
 	bool includeUnknown = INCLUDE_UNKNOWN;
@@ -447,9 +706,9 @@ void FileFilterIndex::managePubDevEntryInIndex(FileData* game, bool remove)
 	}
 }
 
-void FileFilterIndex::manageRatingsEntryInIndex(FileData* game, bool remove)
+void FileFilterIndex::manageRatingsEntryInIndex(const IndexKeys& keys, bool remove)
 {
-	std::string key = getIndexableKey(game, RATINGS_FILTER, false);
+	std::string key = keys.primary[RATINGS_FILTER];
 
 	// flag for including unknowns
 	bool includeUnknown = INCLUDE_UNKNOWN;
@@ -462,11 +721,11 @@ void FileFilterIndex::manageRatingsEntryInIndex(FileData* game, bool remove)
 	manageIndexEntry(&ratingsIndexAllKeys, key, remove);
 }
 
-void FileFilterIndex::manageFavoritesEntryInIndex(FileData* game, bool remove)
+void FileFilterIndex::manageFavoritesEntryInIndex(const IndexKeys& keys, bool remove)
 {
 	// flag for including unknowns
 	bool includeUnknown = INCLUDE_UNKNOWN;
-	std::string key = getIndexableKey(game, FAVORITES_FILTER, false);
+	std::string key = keys.primary[FAVORITES_FILTER];
 	if (!includeUnknown && key == UNKNOWN_LABEL) {
 		// no valid favorites info found
 		return;
@@ -475,11 +734,11 @@ void FileFilterIndex::manageFavoritesEntryInIndex(FileData* game, bool remove)
 	manageIndexEntry(&favoritesIndexAllKeys, key, remove);
 }
 
-void FileFilterIndex::manageHiddenEntryInIndex(FileData* game, bool remove)
+void FileFilterIndex::manageHiddenEntryInIndex(const IndexKeys& keys, bool remove)
 {
 	// flag for including unknowns
 	bool includeUnknown = INCLUDE_UNKNOWN;
-	std::string key = getIndexableKey(game, HIDDEN_FILTER, false);
+	std::string key = keys.primary[HIDDEN_FILTER];
 	if (!includeUnknown && key == UNKNOWN_LABEL) {
 		// no valid hidden info found
 		return;
@@ -488,11 +747,11 @@ void FileFilterIndex::manageHiddenEntryInIndex(FileData* game, bool remove)
 	manageIndexEntry(&hiddenIndexAllKeys, key, remove);
 }
 
-void FileFilterIndex::manageKidGameEntryInIndex(FileData* game, bool remove)
+void FileFilterIndex::manageKidGameEntryInIndex(const IndexKeys& keys, bool remove)
 {
 	// flag for including unknowns
 	bool includeUnknown = INCLUDE_UNKNOWN;
-	std::string key = getIndexableKey(game, KIDGAME_FILTER, false);
+	std::string key = keys.primary[KIDGAME_FILTER];
 	if (!includeUnknown && key == UNKNOWN_LABEL) {
 		// no valid kidgame info found
 		return;
@@ -534,7 +793,7 @@ void FileFilterIndex::manageIndexEntry(std::map<std::string, int>* index, std::s
 	}
 }
 
-void FileFilterIndex::clearIndex(std::map<std::string, int> indexMap)
+void FileFilterIndex::clearIndex(std::map<std::string, int>& indexMap)
 {
 	indexMap.clear();
 }
@@ -2,7 +2,10 @@
 #ifndef ES_APP_FILE_FILTER_INDEX_H
 #define ES_APP_FILE_FILTER_INDEX_H
 
+#include <atomic>
 #include <map>
+#include <stdint.h>
+#include <unordered_map>
 #include <vector>
 #include <string>
 
@@ -17,7 +20,9 @@ enum FilterIndexType
 	RATINGS_FILTER,
 	FAVORITES_FILTER,
 	HIDDEN_FILTER,
-	KIDGAME_FILTER
+	KIDGAME_FILTER,
+
+	FILTER_TYPE_COUNT
 };
 
 struct FilterDataDecl
@@ -37,7 +42,15 @@ class FileFilterIndex
 public:
 	FileFilterIndex();
 	~FileFilterIndex();
+	// The games under root are only indexed once something needs their keys, a filter being set, or build() on an idle
+	// screen. Until then games coming and going are left for build() to find in the tree
+	void setPendingRoot(FileData* root);
+	bool isBuilt() const { return mPendingRoot == nullptr; }
+	void build();
 	void addToIndex(FileData* game);
+	// Adds game with the keys source has for sourceGame, like a collection's copy of a system's game. Saves working
+	// them out from the metadata again, which is most of what indexing a game costs
+	void importGame(const FileFilterIndex* source, const FileData* sourceGame, FileData* game);
 	void removeFromIndex(FileData* game);
 	void setFilter(FilterIndexType type, std::vector<std::string>* values);
 	void clearAllFilters();
@@ -52,21 +65,64 @@ public:
 	void resetFilters();
 	void setUIModeFilters();
 
+	// changes whenever a filter or an indexed game changes in any index, so filtered lists know when to rebuild
+	static unsigned int getGeneration() { return sGeneration; }
+
+	// An estimate of the bytes the keys, game sets and ordinals take
+	size_t getMemoryUsage() const;
+
 private:
+	static std::atomic<unsigned int> sGeneration;
+
 	std::vector<FilterDataDecl> filterDataDecl;
 	std::string getIndexableKey(FileData* game, FilterIndexType type, bool getSecondary);
 
-	void manageGenreEntryInIndex(FileData* game, bool remove = false);
-	void managePlayerEntryInIndex(FileData* game, bool remove = false);
-	void managePubDevEntryInIndex(FileData* game, bool remove = false);
-	void manageRatingsEntryInIndex(FileData* game, bool remove = false);
-	void manageFavoritesEntryInIndex(FileData* game, bool remove = false);
-	void manageHiddenEntryInIndex(FileData* game, bool remove = false);
-	void manageKidGameEntryInIndex(FileData* game, bool remove = false);
+	// the keys of a game for every filter type, the secondary one is UNKNOWN_LABEL for types without one
+	struct IndexKeys
+	{
+		std::string primary[FILTER_TYPE_COUNT];
+		std::string secondary[FILTER_TYPE_COUNT];
+	};
+
+	void getIndexableKeys(FileData* game, IndexKeys& keys);
+	void getGameKeys(size_t ordinal, IndexKeys& keys) const;
+
+	void manageEntriesInIndex(const IndexKeys& keys, bool remove = false);
+	void manageGenreEntryInIndex(const IndexKeys& keys, bool remove = false);
+	void managePlayerEntryInIndex(const IndexKeys& keys, bool remove = false);
+	void managePubDevEntryInIndex(const IndexKeys& keys, bool remove = false);
+	void manageRatingsEntryInIndex(const IndexKeys& keys, bool remove = false);
+	void manageFavoritesEntryInIndex(const IndexKeys& keys, bool remove = false);
+	void manageHiddenEntryInIndex(const IndexKeys& keys, bool remove = false);
+	void manageKidGameEntryInIndex(const IndexKeys& keys, bool remove = false);
 
 	void manageIndexEntry(std::map<std::string, int>* index, std::string key, bool remove);
 
-	void clearIndex(std::map<std::string, int> indexMap);
+	void clearIndex(std::map<std::string, int>& indexMap);
+
+	// every indexed game gets an ordinal, each key of each filter type a set of the ordinals of the games that match it
+	// filters are then applied by combining those sets once, after that showFile only needs to test a bit
+	typedef std::vector<uint64_t> GameSet;
+
+	// the keys of the sets an indexed game is in, by ordinal. nullptr for a secondary key it doesn't have
+	struct GameKeys
+	{
+		const std::string* primary[FILTER_TYPE_COUNT];
+		const std::string* secondary[FILTER_TYPE_COUNT];
+	};
+
+	void addToGameSets(FileData* game, const IndexKeys& keys);
+	void removeFromGameSets(FileData* game);
+	void updateShownGames();
+	bool showFileByKeys(FileData* game);
+
+	std::unordered_map<const FileData*, size_t> mGameOrdinals;
+	std::vector<size_t> mFreeOrdinals;
+	size_t mOrdinalCount;
+	std::map<std::string, GameSet> mGameSets[FILTER_TYPE_COUNT];
+	std::vector<GameKeys> mGameKeys;
+	GameSet mShownGames;
+	bool mShownGamesValid;
 
 	bool filterByGenre;
 	bool filterByPlayers;
@@ -92,7 +148,7 @@ private:
 	std::vector<std::string> hiddenIndexFilteredKeys;
 	std::vector<std::string> kidGameIndexFilteredKeys;
 
-	FileData* mRootFolder;
+	FileData* mPendingRoot;
 
 };
 
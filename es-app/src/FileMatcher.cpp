@@ -0,0 +1,171 @@
+#include "FileMatcher.h"
+
+#include "utils/StringUtil.h"
+
+static inline char toLowerAscii(const char _c)
+{
+	return ((_c >= 'A') && (_c <= 'Z')) ? (char)(_c + ('a' - 'A')) : _c;
+
+} // toLowerAscii
+
+FileMatcher::FileMatcher()
+{
+
+} // FileMatcher
+
+FileMatcher::FileMatcher(const std::vector<std::string>& _extensions, const std::vector<std::string>& _include, const std::vector<std::string>& _exclude)
+{
+	size_t size = 8;
+	while(size < (_extensions.size() * 2))
+		size *= 2;
+
+	mExtensions.resize(size);
+
+	for(auto it = _extensions.cbegin(); it != _extensions.cend(); ++it)
+	{
+		if(it->empty())
+			continue;
+
+		const std::string lower = Utils::String::toLower(*it);
+		size_t            slot  = hash(lower.data(), lower.size()) & (size - 1);
+
+		// .SFC and .sfc end up in the same slot
+		while(!mExtensions[slot].empty() && (mExtensions[slot] != lower))
+			slot = (slot + 1) & (size - 1);
+
+		mExtensions[slot] = lower;
+	}
+
+	addGlobs(mInclude, _include);
+	addGlobs(mExclude, _exclude);
+
+} // FileMatcher
+
+bool FileMatcher::isGame(const char* _name, const size_t _length, const bool _isDirectory) const
+{
+	if(!mExtensions.empty())
+	{
+		// the extension starts at the last '.', without one it's "." as with Utils::FileSystem::getExtension()
+		const char* extension = ".";
+		size_t      length    = 1;
+
+		for(size_t offset = _length; offset > 0; --offset)
+		{
+			if(_name[offset - 1] == '.')
+			{
+				extension = _name + offset - 1;
+				length    = _length - offset + 1;
+				break;
+			}
+		}
+
+		const size_t mask = mExtensions.size() - 1;
+
+		for(size_t slot = hash(extension, length) & mask; !mExtensions[slot].empty(); slot = (slot + 1) & mask)
+		{
+			if(equals(mExtensions[slot], extension, length))
+				return true;
+		}
+	}
+
+	return matchAny(mInclude, _name, _length, _isDirectory);
+
+} // isGame
+
+bool FileMatcher::isExcluded(const char* _name, const size_t _length, const bool _isDirectory) const
+{
+	return matchAny(mExclude, _name, _length, _isDirectory);
+
+} // isExcluded
+
+uint32_t FileMatcher::hash(const char* _data, const size_t _length)
+{
+	// FNV-1a of the lowercase characters
+	uint32_t value = 2166136261u;
+
+	for(size_t i = 0; i < _length; ++i)
+		value = (value ^ (uint8_t)toLowerAscii(_data[i])) * 16777619u;
+
+	return value;
+
+} // hash
+
+bool FileMatcher::equals(const std::string& _lower, const char* _data, const size_t _length)
+{
+	if(_lower.size() != _length)
+		return false;
+
+	for(size_t i = 0; i < _length; ++i)
+	{
+		if(_lower[i] != toLowerAscii(_data[i]))
+			return false;
+	}
+
+	return true;
+
+} // equals
+
+bool FileMatcher::matchGlob(const std::string& _pattern, const char* _name, const size_t _length)
+{
+	size_t pattern  = 0;
+	size_t name     = 0;
+	size_t star     = std::string::npos; // the last * seen, what it matched grows by one on a mismatch
+	size_t starName = 0;
+
+	while(name < _length)
+	{
+		if((pattern < _pattern.size()) && (_pattern[pattern] == '*'))
+		{
+			star     = pattern++;
+			starName = name;
+		}
+		else if((pattern < _pattern.size()) && ((_pattern[pattern] == '?') || (_pattern[pattern] == toLowerAscii(_name[name]))))
+		{
+			++pattern;
+			++name;
+		}
+		else if(star != std::string::npos)
+		{
+			pattern = star + 1;
+			name    = ++starName;
+		}
+		else
+			return false;
+	}
+
+	while((pattern < _pattern.size()) && (_pattern[pattern] == '*'))
+		++pattern;
+
+	return (pattern == _pattern.size());
+
+} // matchGlob
+
+bool FileMatcher::matchAny(const std::vector<Glob>& _globs, const char* _name, const size_t _length, const bool _isDirectory)
+{
+	for(auto it = _globs.cbegin(); it != _globs.cend(); ++it)
+	{
+		if((!it->directoryOnly || _isDirectory) && matchGlob(it->pattern, _name, _length))
+			return true;
+	}
+
+	return false;
+
+} // matchAny
+
+void FileMatcher::addGlobs(std::vector<Glob>& _globs, const std::vector<std::string>& _patterns)
+{
+	for(auto it = _patterns.cbegin(); it != _patterns.cend(); ++it)
+	{
+		Glob glob = { Utils::String::toLower(*it), false };
+
+		if(!glob.pattern.empty() && (glob.pattern.back() == '/'))
+		{
+			glob.pattern.pop_back();
+			glob.directoryOnly = true;
+		}
+
+		if(!glob.pattern.empty())
+			_globs.push_back(glob);
+	}
+
+} // addGlobs
@@ -0,0 +1,51 @@
+#pragma once
+#ifndef ES_APP_FILE_MATCHER_H
+#define ES_APP_FILE_MATCHER_H
+
+#include <stdint.h>
+#include <string>
+#include <vector>
+
+// The rules of a system for which directory entries are games, built once from the <extension>, <include> and
+// <exclude> of es_systems.cfg. Entries are matched on their name alone and ignoring case, without building a path
+// or an extension string per entry. A glob has * and ?, one ending in / only applies to folders
+class FileMatcher
+{
+public:
+
+	FileMatcher();
+	FileMatcher(const std::vector<std::string>& _extensions, const std::vector<std::string>& _include, const std::vector<std::string>& _exclude);
+
+	// an entry is a game when its extension is listed or it matches an include glob, "." lists the files without one
+	bool isGame    (const char* _name, const size_t _length, const bool _isDirectory) const;
+	// neither a game nor a folder that's scanned
+	bool isExcluded(const char* _name, const size_t _length, const bool _isDirectory) const;
+
+	inline bool isGame    (const std::string& _name, const bool _isDirectory) const { return isGame    (_name.data(), _name.size(), _isDirectory); }
+	inline bool isExcluded(const std::string& _name, const bool _isDirectory) const { return isExcluded(_name.data(), _name.size(), _isDirectory); }
+
+	inline bool hasExcludes() const { return !mExclude.empty(); }
+
+private:
+
+	struct Glob
+	{
+		std::string pattern;       // lowercase
+		bool        directoryOnly;
+	};
+
+	static uint32_t hash     (const char* _data, const size_t _length);
+	static bool     equals   (const std::string& _lower, const char* _data, const size_t _length);
+	static bool     matchGlob(const std::string& _pattern, const char* _name, const size_t _length);
+	static bool     matchAny (const std::vector<Glob>& _globs, const char* _name, const size_t _length, const bool _isDirectory);
+
+	static void addGlobs(std::vector<Glob>& _globs, const std::vector<std::string>& _patterns);
+
+	// open addressing, a power of two with at least half of it empty. An empty string is an empty slot
+	std::vector<std::string> mExtensions;
+	std::vector<Glob>        mInclude;
+	std::vector<Glob>        mExclude;
+
+}; // FileMatcher
+
+#endif // ES_APP_FILE_MATCHER_H
@@ -3,13 +3,14 @@
 #include "utils/StringUtil.h"
 #include "Settings.h"
 #include "Log.h"
+#include <mutex>
 
 namespace FileSorts
 {
 
 	const FileData::SortType typesArr[] = {
-		FileData::SortType(&compareName, true, "name, ascending"),
-		FileData::SortType(&compareName, false, "name, descending"),
+		FileData::SortType(&compareName, true, "name, ascending", &getNameKey),
+		FileData::SortType(&compareName, false, "name, descending", &getNameKey),
 
 		FileData::SortType(&compareRating, true, "rating, ascending"),
 		FileData::SortType(&compareRating, false, "rating, descending"),
@@ -26,42 +27,118 @@ namespace FileSorts
 		FileData::SortType(&compareReleaseDate, true, "release date, ascending"),
 		FileData::SortType(&compareReleaseDate, false, "release date, descending"),
 
-		FileData::SortType(&compareGenre, true, "genre, ascending"),
-		FileData::SortType(&compareGenre, false, "genre, descending"),
+		FileData::SortType(&compareGenre, true, "genre, ascending", &getGenreKey),
+		FileData::SortType(&compareGenre, false, "genre, descending", &getGenreKey),
 
-		FileData::SortType(&compareDeveloper, true, "developer, ascending"),
-		FileData::SortType(&compareDeveloper, false, "developer, descending"),
+		FileData::SortType(&compareDeveloper, true, "developer, ascending", &getDeveloperKey),
+		FileData::SortType(&compareDeveloper, false, "developer, descending", &getDeveloperKey),
 
-		FileData::SortType(&comparePublisher, true, "publisher, ascending"),
-		FileData::SortType(&comparePublisher, false, "publisher, descending"),
+		FileData::SortType(&comparePublisher, true, "publisher, ascending", &getPublisherKey),
+		FileData::SortType(&comparePublisher, false, "publisher, descending", &getPublisherKey),
 
-		FileData::SortType(&compareSystem, true, "system, ascending"),
-		FileData::SortType(&compareSystem, false, "system, descending")
+		FileData::SortType(&compareSystem, true, "system, ascending", &getSystemKey),
+		FileData::SortType(&compareSystem, false, "system, descending", &getSystemKey)
 	};
 
 	const std::vector<FileData::SortType> SortTypes(typesArr, typesArr + sizeof(typesArr)/sizeof(typesArr[0]));
 
-	//returns if file1 should come before file2
-	bool compareName(const FileData* file1, const FileData* file2)
+	// the leading articles settings are parsed once per change instead of in every comparison
+	// folders can be sorted from several threads while systems are loading
+	static std::mutex articlesMutex;
+	static bool articlesEnabled = false;
+	static std::string articlesSetting;
+	static std::vector<std::string> articles;
+	static unsigned int articlesGeneration = 0;
+
+	static void updateLeadingArticles()
 	{
-		// we compare the actual metadata name, as collection files have the system appended which messes up the order
-		std::string name1 = Utils::String::toUpper(file1->metadata.get("sortname"));
-		std::string name2 = Utils::String::toUpper(file2->metadata.get("sortname"));
-		if(name1.empty()){
-			name1 = Utils::String::toUpper(file1->metadata.get("name"));
+		const bool enabled = Settings::getInstance()->getBool("IgnoreLeadingArticles");
+		const std::string setting = Settings::getInstance()->getString("LeadingArticles");
+
+		if (enabled == articlesEnabled && setting == articlesSetting)
+			return;
+
+		articlesEnabled = enabled;
+		articlesSetting = setting;
+		articles.clear();
+
+		std::vector<std::string> list = Utils::String::delimitedStringToVector(setting, ",");
+		for(auto it = list.cbegin(); it != list.cend(); it++)
+			articles.push_back(Utils::String::toUpper(*it) + " ");
+
+		articlesGeneration++;
+	}
+
+	static void removeLeadingArticles(std::string& name)
+	{
+		const std::unique_lock<std::mutex> lock(articlesMutex);
+		updateLeadingArticles();
+
+		if (!articlesEnabled)
+			return;
+
+		for(auto it = articles.cbegin(); it != articles.cend(); it++)
+		{
+			if (Utils::String::startsWith(name, *it))
+				name = Utils::String::replace(name, *it, "");
 		}
-		if(name2.empty()){
-			name2 = Utils::String::toUpper(file2->metadata.get("name"));
+	}
+
+	unsigned int getGeneration()
+	{
+		unsigned int options;
+
+		{
+			const std::unique_lock<std::mutex> lock(articlesMutex);
+			updateLeadingArticles();
+			options = articlesGeneration;
 		}
 
-		ignoreLeadingArticles(name1, name2);
+		// both only ever go up, so their sum changes whenever one of them does
+		return MetaDataList::getChangeCount() + options;
+	}
+
+	std::string getNameKey(const FileData* file)
+	{
+		// we use the actual metadata name, as collection files have the system appended which messes up the order
+		std::string name = file->metadata.get(MD_ID_SORTNAME);
+		if(name.empty())
+			name = file->metadata.get(MD_ID_NAME);
+
+		Utils::String::makeUpper(name);
+		removeLeadingArticles(name);
+		return name;
+	}
+
+	std::string getGenreKey(const FileData* file)
+	{
+		return Utils::String::toUpper(file->metadata.get(MD_ID_GENRE));
+	}
+
+	std::string getDeveloperKey(const FileData* file)
+	{
+		return Utils::String::toUpper(file->metadata.get(MD_ID_DEVELOPER));
+	}
+
+	std::string getPublisherKey(const FileData* file)
+	{
+		return Utils::String::toUpper(file->metadata.get(MD_ID_PUBLISHER));
+	}
+
+	std::string getSystemKey(const FileData* file)
+	{
+		return Utils::String::toUpper(file->getSystemName());
+	}
 
-		return name1.compare(name2) < 0;
+	//returns if file1 should come before file2
+	bool compareName(const FileData* file1, const FileData* file2)
+	{
+		return getNameKey(file1).compare(getNameKey(file2)) < 0;
 	}
 
 	bool compareRating(const FileData* file1, const FileData* file2)
 	{
-		return file1->metadata.getFloat("rating") < file2->metadata.getFloat("rating");
+		return file1->metadata.getFloat(MD_ID_RATING) < file2->metadata.getFloat(MD_ID_RATING);
 	}
 
 	bool compareTimesPlayed(const FileData* file1, const FileData* file2)
@@ -69,7 +146,7 @@ namespace FileSorts
 		//only games have playcount metadata
 		if(file1->metadata.getType() == GAME_METADATA && file2->metadata.getType() == GAME_METADATA)
 		{
-			return (file1)->metadata.getInt("playcount") < (file2)->metadata.getInt("playcount");
+			return (file1)->metadata.getInt(MD_ID_PLAYCOUNT) < (file2)->metadata.getInt(MD_ID_PLAYCOUNT);
 		}
 
 		return false;
@@ -77,74 +154,48 @@ namespace FileSorts
 
 	bool compareLastPlayed(const FileData* file1, const FileData* file2)
 	{
-		// since it's stored as an ISO string (YYYYMMDDTHHMMSS), we can compare as a string
-		// as it's a lot faster than the time casts and then time comparisons
-		return (file1)->metadata.get("lastplayed") < (file2)->metadata.get("lastplayed");
+		// parsed once when set, unlike the ISO strings unset dates ("not-a-date-time") sort before every real one
+		return (file1)->metadata.getTime(MD_ID_LASTPLAYED) < (file2)->metadata.getTime(MD_ID_LASTPLAYED);
 	}
 
 	bool compareNumPlayers(const FileData* file1, const FileData* file2)
 	{
-		return (file1)->metadata.getInt("players") < (file2)->metadata.getInt("players");
+		return (file1)->metadata.getInt(MD_ID_PLAYERS) < (file2)->metadata.getInt(MD_ID_PLAYERS);
 	}
 
 	bool compareReleaseDate(const FileData* file1, const FileData* file2)
 	{
-		// since it's stored as an ISO string (YYYYMMDDTHHMMSS), we can compare as a string
-		// as it's a lot faster than the time casts and then time comparisons
-		return (file1)->metadata.get("releasedate") < (file2)->metadata.get("releasedate");
+		// parsed once when set, unlike the ISO strings unset dates ("not-a-date-time") sort before every real one
+		return (file1)->metadata.getTime(MD_ID_RELEASEDATE) < (file2)->metadata.getTime(MD_ID_RELEASEDATE);
 	}
 
 	bool compareGenre(const FileData* file1, const FileData* file2)
 	{
-		std::string genre1 = Utils::String::toUpper(file1->metadata.get("genre"));
-		std::string genre2 = Utils::String::toUpper(file2->metadata.get("genre"));
-		return genre1.compare(genre2) < 0;
+		return getGenreKey(file1).compare(getGenreKey(file2)) < 0;
 	}
 
 	bool compareDeveloper(const FileData* file1, const FileData* file2)
 	{
-		std::string developer1 = Utils::String::toUpper(file1->metadata.get("developer"));
-		std::string developer2 = Utils::String::toUpper(file2->metadata.get("developer"));
-		return developer1.compare(developer2) < 0;
+		return getDeveloperKey(file1).compare(getDeveloperKey(file2)) < 0;
 	}
 
 	bool comparePublisher(const FileData* file1, const FileData* file2)
 	{
-		std::string publisher1 = Utils::String::toUpper(file1->metadata.get("publisher"));
-		std::string publisher2 = Utils::String::toUpper(file2->metadata.get("publisher"));
-		return publisher1.compare(publisher2) < 0;
+		return getPublisherKey(file1).compare(getPublisherKey(file2)) < 0;
 	}
 
 	bool compareSystem(const FileData* file1, const FileData* file2)
 	{
-		std::string system1 = Utils::String::toUpper(file1->getSystemName());
-		std::string system2 = Utils::String::toUpper(file2->getSystemName());
-		return system1.compare(system2) < 0;
+		return getSystemKey(file1).compare(getSystemKey(file2)) < 0;
 	}
 
 	//If option is enabled, ignore leading articles by temporarily modifying the name prior to sorting
 	//(Artciles are defined within the settings config file)
+	//(Names are expected to be upper case already, as the sort keys are)
 	void ignoreLeadingArticles(std::string &name1, std::string &name2) {
 
-		if (Settings::getInstance()->getBool("IgnoreLeadingArticles"))
-		{
-
-			std::vector<std::string> articles = Utils::String::delimitedStringToVector(Settings::getInstance()->getString("LeadingArticles"), ",");
-
-			for(Utils::String::stringVector::iterator it = articles.begin(); it != articles.end(); it++)
-			{
-			
-				if (Utils::String::startsWith(Utils::String::toUpper(name1), Utils::String::toUpper(it[0]) + " ")) {
-					name1 = Utils::String::replace(Utils::String::toUpper(name1), Utils::String::toUpper(it[0]) + " ", "");
-				}
-
-				if (Utils::String::startsWith(Utils::String::toUpper(name2), Utils::String::toUpper(it[0]) + " ")) {
-					name2 = Utils::String::replace(Utils::String::toUpper(name2), Utils::String::toUpper(it[0]) + " ", "");
-				}
-
-			}
-
-		}
+		removeLeadingArticles(name1);
+		removeLeadingArticles(name2);
 
 	}
 
@@ -18,8 +18,17 @@ namespace FileSorts
 	bool comparePublisher(const FileData* file1, const FileData* file2);
 	bool compareSystem(const FileData* file1, const FileData* file2);
 
+	std::string getNameKey(const FileData* file);
+	std::string getGenreKey(const FileData* file);
+	std::string getDeveloperKey(const FileData* file);
+	std::string getPublisherKey(const FileData* file);
+	std::string getSystemKey(const FileData* file);
+
 	void ignoreLeadingArticles(std::string &name1, std::string &name2);
 
+	// changes whenever a sorted order may have become outdated, because metadata or the leading articles settings changed
+	unsigned int getGeneration();
+
 	extern const std::vector<FileData::SortType> SortTypes;
 };
 
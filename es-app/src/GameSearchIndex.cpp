@@ -0,0 +1,579 @@
+#include "GameSearchIndex.h"
+
+#include "utils/StringUtil.h"
+#include "FileData.h"
+#include "Log.h"
+#include "SystemData.h"
+#include <algorithm>
+#include <ctype.h>
+#include <string.h>
+#include <unordered_map>
+
+// forgotten entries are only dropped from the lists once they make up a good part of them
+static const size_t COMPACT_MIN_DEAD = 1024;
+
+// Upper case words of letters and digits, split at everything else and joined by single spaces
+static std::string normalize(const std::string& _text)
+{
+	const std::string upper = Utils::String::toUpper(_text);
+	std::string       normalized;
+
+	normalized.reserve(upper.size());
+
+	for(size_t i = 0; i < upper.size(); ++i)
+	{
+		const unsigned char c = (unsigned char)upper[i];
+
+		// anything past ASCII belongs to a UTF-8 letter
+		if((c >= 0x80) || isalnum(c))
+			normalized += (char)c;
+		else if(!normalized.empty() && (normalized.back() != ' '))
+			normalized += ' ';
+	}
+
+	if(!normalized.empty() && (normalized.back() == ' '))
+		normalized.pop_back();
+
+	return normalized;
+
+} // normalize
+
+static size_t getWordEnd(const std::string& _text, size_t _offset)
+{
+	const size_t end = _text.find(' ', _offset);
+	return (end == std::string::npos) ? _text.size() : end;
+
+} // getWordEnd
+
+static void getWords(const std::string& _text, std::vector<std::string>& _words)
+{
+	for(size_t offset = 0; offset < _text.size(); )
+	{
+		const size_t end = getWordEnd(_text, offset);
+		_words.push_back(_text.substr(offset, end - offset));
+		offset = end + 1;
+	}
+
+} // getWords
+
+// The trigrams of every word padded with a space on both ends, so a one letter word has one
+static void getTrigrams(const std::string& _text, size_t _length, std::vector<uint32_t>& _trigrams)
+{
+	for(size_t offset = 0; offset < _length; )
+	{
+		const size_t end = std::min(getWordEnd(_text, offset), _length);
+		uint32_t     trigram = ' ';
+
+		for(size_t i = offset; i <= end; ++i)
+		{
+			trigram = ((trigram << 8) | (unsigned char)((i < end) ? _text[i] : ' ')) & 0xFFFFFF;
+			if(i > offset)
+				_trigrams.push_back(trigram);
+		}
+
+		offset = end + 1;
+	}
+
+	std::sort(_trigrams.begin(), _trigrams.end());
+	_trigrams.erase(std::unique(_trigrams.begin(), _trigrams.end()), _trigrams.end());
+
+} // getTrigrams
+
+struct GameSearchIndex::Index
+{
+	struct Entry
+	{
+		FileData*   game; // nullptr once forgotten
+		SystemData* system;
+		std::string text; // the normalized name, followed by the normalized developer and genre
+		uint32_t    nameLength;
+		uint32_t    trigramCount;
+	};
+
+	// a word of an entry, in place
+	struct Word
+	{
+		uint32_t id;
+		uint32_t offset;
+	};
+
+	struct Match
+	{
+		uint32_t id;
+		int      score;
+	};
+
+	std::vector<Entry>                                  entries;
+	std::unordered_map<FileData*, uint32_t>             ids;
+	std::vector<Word>                                   words; // sorted up to sortedWords, the words of later additions follow
+	size_t                                              sortedWords = 0;
+	std::unordered_map<uint32_t, std::vector<uint32_t>> trigrams; // entry ids in ascending order
+	size_t                                              dead = 0;
+
+	// what a query saw of every entry, valid where the stamp is the one of the query
+	std::vector<uint32_t> stamps;
+	std::vector<uint32_t> counts;
+	uint32_t              stamp = 0;
+
+	// the count of entries already matched by their words
+	static const uint32_t MATCHED = 0xFFFFFFFF;
+
+	void add(const Document& _document)
+	{
+		forget(_document.game);
+
+		const uint32_t id = (uint32_t)entries.size();
+		Entry          entry;
+
+		entry.game       = _document.game;
+		entry.system     = _document.system;
+		entry.text       = normalize(_document.name);
+		entry.nameLength = (uint32_t)entry.text.size();
+
+		const std::string extra = normalize(_document.extra);
+		if(!extra.empty())
+			entry.text += (entry.text.empty() ? "" : " ") + extra;
+
+		for(size_t offset = 0; offset < entry.text.size(); offset = getWordEnd(entry.text, offset) + 1)
+			words.push_back({ id, (uint32_t)offset });
+
+		std::vector<uint32_t> entryTrigrams;
+		getTrigrams(entry.text, entry.nameLength, entryTrigrams);
+		for(auto it = entryTrigrams.cbegin(); it != entryTrigrams.cend(); ++it)
+			trigrams[*it].push_back(id);
+
+		entry.trigramCount = (uint32_t)entryTrigrams.size();
+		entries.push_back(std::move(entry));
+		ids[_document.game] = id;
+	}
+
+	void forget(FileData* _game)
+	{
+		auto it = ids.find(_game);
+		if(it == ids.cend())
+			return;
+
+		entries[it->second].game = nullptr;
+		ids.erase(it);
+
+		if(++dead >= std::max(COMPACT_MIN_DEAD, entries.size() / 2))
+			compact();
+	}
+
+	void forgetSystem(SystemData* _system)
+	{
+		for(auto it = entries.begin(); it != entries.end(); ++it)
+		{
+			if(it->game && (it->system == _system))
+			{
+				ids.erase(it->game);
+				it->game = nullptr;
+				++dead;
+			}
+		}
+
+		if(dead >= std::max(COMPACT_MIN_DEAD, entries.size() / 2))
+			compact();
+	}
+
+	// Indexes the entries that are left again
+	void compact()
+	{
+		std::vector<Entry> left;
+		left.swap(entries);
+
+		ids.clear();
+		words.clear();
+		sortedWords = 0;
+		trigrams.clear();
+		dead = 0;
+
+		for(auto it = left.begin(); it != left.end(); ++it)
+		{
+			if(!it->game)
+				continue;
+
+			const uint32_t id = (uint32_t)entries.size();
+			for(size_t offset = 0; offset < it->text.size(); offset = getWordEnd(it->text, offset) + 1)
+				words.push_back({ id, (uint32_t)offset });
+
+			std::vector<uint32_t> entryTrigrams;
+			getTrigrams(it->text, it->nameLength, entryTrigrams);
+			for(auto trigram = entryTrigrams.cbegin(); trigram != entryTrigrams.cend(); ++trigram)
+				trigrams[*trigram].push_back(id);
+
+			ids[it->game] = id;
+			entries.push_back(std::move(*it));
+		}
+
+		sortWords();
+	}
+
+	// <0, 0 or >0 as the word sorts before, at or after _prefix, a word that starts with _prefix counts as at it
+	int compareWord(const Word& _word, const std::string& _prefix) const
+	{
+		const std::string& text   = entries[_word.id].text;
+		const size_t       length = getWordEnd(text, _word.offset) - _word.offset;
+		const int          result = text.compare(_word.offset, std::min(length, _prefix.size()), _prefix, 0, std::min(length, _prefix.size()));
+
+		if(result != 0)
+			return result;
+
+		return (length < _prefix.size()) ? -1 : 0;
+	}
+
+	void sortWords()
+	{
+		const auto less = [this](const Word& _a, const Word& _b)
+		{
+			const std::string& a = entries[_a.id].text;
+			const std::string& b = entries[_b.id].text;
+			return a.compare(_a.offset, getWordEnd(a, _a.offset) - _a.offset, b, _b.offset, getWordEnd(b, _b.offset) - _b.offset) < 0;
+		};
+
+		if(sortedWords == 0)
+		{
+			std::sort(words.begin(), words.end(), less);
+		}
+		else if(sortedWords < words.size())
+		{
+			std::sort(words.begin() + sortedWords, words.end(), less);
+			std::inplace_merge(words.begin(), words.begin() + sortedWords, words.end(), less);
+		}
+
+		sortedWords = words.size();
+	}
+
+	// Whether every word of _query starts a word of the entry, _inName is set when they all are in the name
+	bool matchesWords(const Entry& _entry, const std::vector<std::string>& _query, bool& _inName) const
+	{
+		_inName = true;
+
+		for(auto word = _query.cbegin(); word != _query.cend(); ++word)
+		{
+			bool found = false;
+			for(size_t offset = 0; !found && (offset < _entry.text.size()); offset = getWordEnd(_entry.text, offset) + 1)
+			{
+				if(_entry.text.compare(offset, word->size(), *word) == 0)
+				{
+					found   = true;
+					_inName = _inName && (offset < _entry.nameLength);
+				}
+			}
+
+			if(!found)
+				return false;
+		}
+
+		return true;
+	}
+
+	// the stamp of a new query, every entry is unseen by it
+	void nextStamp()
+	{
+		stamps.resize(entries.size(), stamp);
+		counts.resize(entries.size(), 0);
+
+		if(++stamp == 0)
+		{
+			std::fill(stamps.begin(), stamps.end(), 0);
+			stamp = 1;
+		}
+	}
+
+	std::vector<FileData*> query(const std::string& _text, size_t _max, const std::function<bool(FileData*)>& _accept)
+	{
+		std::vector<FileData*> found;
+
+		const std::string normalized = normalize(_text);
+		if(normalized.empty() || (_max == 0))
+			return found;
+
+		std::vector<std::string> queryWords;
+		getWords(normalized, queryWords);
+
+		sortWords();
+		nextStamp();
+
+		// every match has each of the words, the one starting the fewest indexed words gives the fewest candidates
+		std::vector<Word>::const_iterator first = words.cend();
+		std::vector<Word>::const_iterator last  = words.cend();
+		size_t                            rarest = 0;
+
+		for(size_t i = 0; i < queryWords.size(); ++i)
+		{
+			const std::string& word = queryWords[i];
+			auto wordFirst = std::lower_bound(words.cbegin(), words.cend(), word, [this](const Word& _word, const std::string& _prefix) { return compareWord(_word, _prefix) < 0; });
+			auto wordLast  = std::upper_bound(wordFirst, words.cend(), word, [this](const std::string& _prefix, const Word& _word) { return compareWord(_word, _prefix) > 0; });
+
+			if((i == 0) || ((wordLast - wordFirst) < (last - first)))
+			{
+				first  = wordFirst;
+				last   = wordLast;
+				rarest = i;
+			}
+		}
+
+		std::vector<std::string> otherWords(queryWords);
+		otherWords.erase(otherWords.begin() + rarest);
+
+		std::vector<Match> matches;
+		for(auto it = first; it != last; ++it)
+		{
+			const Entry& entry = entries[it->id];
+			if(!entry.game || (stamps[it->id] == stamp))
+				continue;
+
+			stamps[it->id] = stamp;
+
+			// the words are looked up from the start of the name, so a word that is also the developer or genre is found there
+			bool inName;
+			if(!matchesWords(entry, (it->offset < entry.nameLength) ? otherWords : queryWords, inName) || (_accept && !_accept(entry.game)))
+				continue;
+
+			const bool start = (entry.text.compare(0, normalized.size(), normalized) == 0) && (normalized.size() <= entry.nameLength);
+			matches.push_back({ it->id, (start ? 3000000 : (inName ? 2000000 : 1000000)) - (int)entry.nameLength });
+		}
+
+		sortMatches(matches, _max);
+		for(auto it = matches.cbegin(); it != matches.cend(); ++it)
+			found.push_back(entries[it->id].game);
+
+		if(found.size() >= _max)
+			return found;
+
+		// close names, by the share of trigrams they have in common with what was typed
+		std::vector<uint32_t> queryTrigrams;
+		getTrigrams(normalized, normalized.size(), queryTrigrams);
+
+		std::vector<uint32_t> touched;
+
+		nextStamp();
+		for(auto it = matches.cbegin(); it != matches.cend(); ++it)
+		{
+			stamps[it->id] = stamp;
+			counts[it->id] = MATCHED;
+		}
+
+		for(auto trigram = queryTrigrams.cbegin(); trigram != queryTrigrams.cend(); ++trigram)
+		{
+			auto list = trigrams.find(*trigram);
+			if(list == trigrams.cend())
+				continue;
+
+			for(auto id = list->second.cbegin(); id != list->second.cend(); ++id)
+			{
+				if(stamps[*id] != stamp)
+				{
+					stamps[*id] = stamp;
+					counts[*id] = 0;
+					touched.push_back(*id);
+				}
+				else if(counts[*id] == MATCHED)
+				{
+					continue;
+				}
+
+				++counts[*id];
+			}
+		}
+
+		std::vector<Match> close;
+		for(auto id = touched.cbegin(); id != touched.cend(); ++id)
+		{
+			const Entry&   entry  = entries[*id];
+			const uint32_t shared = counts[*id];
+
+			if(!entry.game || ((shared * 2) < queryTrigrams.size()) || (_accept && !_accept(entry.game)))
+				continue;
+
+			close.push_back({ *id, (int)((shared * 1000) / (queryTrigrams.size() + entry.trigramCount - shared)) });
+		}
+
+		sortMatches(close, _max - found.size());
+		for(auto it = close.cbegin(); it != close.cend(); ++it)
+			found.push_back(entries[it->id].game);
+
+		return found;
+	}
+
+	// Keeps the best _max of _matches, best first, shorter names first when they score the same
+	void sortMatches(std::vector<Match>& _matches, size_t _max) const
+	{
+		const auto better = [this](const Match& _a, const Match& _b)
+		{
+			if(_a.score != _b.score)
+				return _a.score > _b.score;
+
+			return entries[_a.id].text < entries[_b.id].text;
+		};
+
+		const size_t count = std::min(_max, _matches.size());
+		std::partial_sort(_matches.begin(), _matches.begin() + count, _matches.end(), better);
+		_matches.resize(count);
+	}
+
+}; // GameSearchIndex::Index
+
+GameSearchIndex* GameSearchIndex::sInstance = nullptr;
+
+void GameSearchIndex::init()
+{
+	if(!sInstance)
+		sInstance = new GameSearchIndex();
+
+} // init
+
+void GameSearchIndex::deinit()
+{
+	if(sInstance)
+	{
+		delete sInstance;
+		sInstance = nullptr;
+	}
+
+} // deinit
+
+GameSearchIndex* GameSearchIndex::getInstance()
+{
+	if(!sInstance)
+		sInstance = new GameSearchIndex();
+
+	return sInstance;
+
+} // getInstance
+
+GameSearchIndex::GameSearchIndex() : mIndex(new Index()), mBuilding(false)
+{
+	FileData::addMetaDataListener(this);
+
+} // GameSearchIndex
+
+GameSearchIndex::~GameSearchIndex()
+{
+	FileData::removeMetaDataListener(this);
+
+	if(mThread.joinable())
+		mThread.join();
+
+} // ~GameSearchIndex
+
+GameSearchIndex::Document GameSearchIndex::getDocument(FileData* _game)
+{
+	const std::string developer = _game->metadata.get("developer");
+	const std::string genre     = _game->metadata.get("genre");
+
+	return { _game, _game->getSystem(), _game->getName(), developer + ((developer.empty() || genre.empty()) ? "" : " ") + genre };
+
+} // getDocument
+
+bool GameSearchIndex::isIndexed(FileData* _game)
+{
+	return (_game->getType() == GAME) && !_game->getSystem()->isCollection() && _game->getSystem()->isGameSystem();
+
+} // isIndexed
+
+void GameSearchIndex::build()
+{
+	if(mThread.joinable())
+		mThread.join();
+
+	std::vector<Document> documents;
+	for(auto it = SystemData::sSystemVector.cbegin(); it != SystemData::sSystemVector.cend(); ++it)
+	{
+		if((*it)->isCollection() || !(*it)->isGameSystem())
+			continue;
+
+		(*it)->getRootFolder()->forEachFile(GAME, false, [&documents](FileData* _game)
+		{
+			documents.push_back(getDocument(_game));
+		});
+	}
+
+	{
+		std::unique_lock<std::mutex> lock(mMutex);
+		mBuilding = true;
+		mPending.clear();
+	}
+
+	mThread = std::thread(&GameSearchIndex::buildThread, this, std::move(documents));
+
+} // build
+
+void GameSearchIndex::buildThread(std::vector<Document> _documents)
+{
+	std::unique_ptr<Index> index(new Index());
+	index->entries.reserve(_documents.size());
+
+	for(auto it = _documents.cbegin(); it != _documents.cend(); ++it)
+		index->add(*it);
+
+	index->sortWords();
+
+	std::unique_lock<std::mutex> lock(mMutex);
+
+	// what changed while building happened after the copy was taken
+	for(auto it = mPending.cbegin(); it != mPending.cend(); ++it)
+		(*it)(*index);
+
+	LOG(LogInfo) << "Indexed " << index->ids.size() << " games for searching";
+
+	mIndex.swap(index);
+	mPending.clear();
+	mBuilding = false;
+
+} // buildThread
+
+void GameSearchIndex::apply(const std::function<void(Index&)>& _change)
+{
+	std::unique_lock<std::mutex> lock(mMutex);
+
+	// the index searched until the new one is done has to stay correct as well
+	_change(*mIndex);
+
+	if(mBuilding)
+		mPending.push_back(_change);
+
+} // apply
+
+void GameSearchIndex::update(FileData* _game)
+{
+	if(!isIndexed(_game))
+		return;
+
+	const Document document = getDocument(_game);
+	apply([document](Index& _index) { _index.add(document); });
+
+} // update
+
+void GameSearchIndex::forget(FileData* _game)
+{
+	if(!sInstance || !isIndexed(_game))
+		return;
+
+	sInstance->apply([_game](Index& _index) { _index.forget(_game); });
+
+} // forget
+
+void GameSearchIndex::forgetSystem(SystemData* _system)
+{
+	if(!sInstance)
+		return;
+
+	sInstance->apply([_system](Index& _index) { _index.forgetSystem(_system); });
+
+} // forgetSystem
+
+bool GameSearchIndex::isBuilding()
+{
+	std::unique_lock<std::mutex> lock(mMutex);
+	return mBuilding;
+
+} // isBuilding
+
+std::vector<FileData*> GameSearchIndex::query(const std::string& _text, size_t _max, const std::function<bool(FileData*)>& _accept)
+{
+	std::unique_lock<std::mutex> lock(mMutex);
+	return mIndex->query(_text, _max, _accept);
+
+} // query
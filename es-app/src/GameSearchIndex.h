@@ -0,0 +1,78 @@
+#pragma once
+#ifndef ES_APP_GAME_SEARCH_INDEX_H
+#define ES_APP_GAME_SEARCH_INDEX_H
+
+#include "FileData.h"
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <stdint.h>
+#include <string>
+#include <thread>
+#include <vector>
+
+class SystemData;
+
+// Finds games by what is typed of their name, developer or genre, across every game system. Every word is kept in
+// a sorted list for prefix lookups and every name is split into trigrams for names that are only close to what was
+// typed. The metadata is copied on the main thread and indexed on a background thread, later changes are indexed
+// right away so the index doesn't need to be built again while running.
+class GameSearchIndex : public MetaDataListener
+{
+public:
+
+	static void             init       ();
+	static void             deinit     ();
+	static GameSearchIndex* getInstance();
+
+	// Copies the metadata of every game and indexes it again on a background thread, queries find nothing until that's done
+	void build();
+
+	// Indexes _game again, after it was added. Metadata changes are heard of on their own
+	void update(FileData* _game);
+
+	void onMetaDataChanged(FileData* _game) override { update(_game); }
+
+	// Drop games and systems that are about to be deleted, they do nothing before init()
+	static void forget      (FileData*   _game);
+	static void forgetSystem(SystemData* _system);
+
+	bool isBuilding();
+
+	// The best _max games for _text, words matching the start of a name first. Games _accept returns false for are skipped
+	std::vector<FileData*> query(const std::string& _text, size_t _max, const std::function<bool(FileData*)>& _accept = nullptr);
+
+private:
+
+	struct Document
+	{
+		FileData*   game;
+		SystemData* system;
+		std::string name;
+		std::string extra; // developer and genre
+	};
+
+	struct Index;
+
+	 GameSearchIndex();
+	~GameSearchIndex();
+
+	static Document getDocument(FileData* _game);
+	static bool     isIndexed  (FileData* _game);
+
+	void buildThread(std::vector<Document> _documents);
+
+	// Runs _change on the index, or once the index being built is done
+	void apply(const std::function<void(Index&)>& _change);
+
+	static GameSearchIndex* sInstance;
+
+	std::unique_ptr<Index>                      mIndex;
+	std::vector<std::function<void(Index&)>>    mPending;
+	bool                                        mBuilding;
+	std::thread                                 mThread;
+	std::mutex                                  mMutex;
+
+}; // GameSearchIndex
+
+#endif // ES_APP_GAME_SEARCH_INDEX_H
@@ -1,17 +1,40 @@
 #include "Gamelist.h"
 
+#include <atomic>
 #include <chrono>
-
+#include <fstream>
+#include <functional>
+#include <list>
+#include <map>
+#include <mutex>
+#include <sstream>
+#include <stdint.h>
+#include <string.h>
+
+#include "utils/BinaryUtil.h"
 #include "utils/FileSystemUtil.h"
+#include "utils/TaskScheduler.h"
 #include "FileData.h"
 #include "FileFilterIndex.h"
+#include "GamelistReader.h"
+#include "GamelistWriter.h"
 #include "Log.h"
+#include "platform.h"
 #include "Settings.h"
+#include "SharedCache.h"
 #include "SystemData.h"
 #include <pugixml.hpp>
 
 FileData* findOrCreateFile(SystemData* system, const std::string& path, FileType type)
 {
+	// most entries are games that were already found on disk
+	if(type == GAME)
+	{
+		FileData* game = FileData::findGame(path);
+		if(game && game->getSystem() == system)
+			return game;
+	}
+
 	FileData* root = system->getRootFolder();
 	bool contains = false;
 	const std::string systemPath = root->getPath();
@@ -54,7 +77,7 @@ FileData* findOrCreateFile(SystemData* system, const std::string& path, FileType
 				return NULL;
 			}
 
-			FileData* file = new FileData(type, path, system->getSystemEnvData(), system);
+			FileData* file = new (system->getFileDataPool()) FileData(type, path, system->getSystemEnvData(), system);
 
 			// skipping arcade assets from gamelist and add only to filesystem
 			// (fs) folders, i.e. entriess in gamelist with <folder/> and not to
@@ -88,7 +111,7 @@ FileData* findOrCreateFile(SystemData* system, const std::string& path, FileType
 			}
 			// create folder filedata object
 			std::string absPath = Utils::FileSystem::resolveRelativePath(treeNode->getPath() + "/" + pathSegment, systemPath, false, true);
-			FileData* folder = new FileData(FOLDER, absPath, system->getSystemEnvData(), system);
+			FileData* folder = new (system->getFileDataPool()) FileData(FOLDER, absPath, system->getSystemEnvData(), system);
 			LOG(LogDebug) << "folder not found as FileData, adding: " << folder->getPath();
 
 			treeNode->addChild(folder);
@@ -101,78 +124,535 @@ FileData* findOrCreateFile(SystemData* system, const std::string& path, FileType
 	return NULL;
 }
 
-void parseGamelist(SystemData* system)
+static const char     SNAPSHOT_MAGIC[4] = { 'E', 'S', 'G', 'L' };
+static const uint32_t SNAPSHOT_VERSION  = 1;
+
+// size at which the journal of saved changes is merged back into gamelist.xml
+static const int64_t  JOURNAL_COMPACT_SIZE = 256 * 1024;
+
+// raw content of a <game> or <folder> node, exactly as it is found in gamelist.xml
+struct GamelistEntry
 {
-	bool trustGamelist = Settings::getInstance()->getBool("ParseGamelistOnly");
-	std::string xmlpath = system->getGamelistPath(false);
-	const std::vector<std::string> allowedExtensions = system->getExtensions();
+	GamelistEntry() : descOffset(0) { }
 
-	if(!Utils::FileSystem::exists(xmlpath))
-		return;
+	FileType                                           type;
+	std::string                                        path;
+	std::vector<std::pair<unsigned char, std::string>> values; // MetaDataId, value
+	uint32_t                                           descOffset; // where the description was left in the snapshot
+};
 
-	LOG(LogInfo) << "Parsing XML file \"" << xmlpath << "\"...";
+// longer than any description a scraper hands out, a bigger length can only come from a broken snapshot
+static const uint32_t MAX_DESC_LENGTH = 1024 * 1024;
 
-	pugi::xml_document doc;
-	pugi::xml_parse_result result = doc.load_file(xmlpath.c_str());
+// what readGamelist() found, for applyGamelist()
+struct GamelistData
+{
+	GamelistData() : exists(false), fromSnapshot(false), valid(false), snapshotTime(0) { }
+
+	bool                       exists;       // there is a gamelist.xml
+	bool                       fromSnapshot; // its entries were taken from the snapshot
+	bool                       valid;        // it was parsed without errors, only then a snapshot is taken of it
+	time_t                     snapshotTime;
+	std::vector<GamelistEntry> entries;      // the games, then the folders
+	std::vector<GamelistEntry> journal;
+};
 
-	if(!result)
+static std::string getGamelistSnapshotPath(const SystemData* system)
+{
+	return Utils::FileSystem::getHomePath() + "/.emulationstation/cache/gamelists/" + system->getName() + ".snapshot";
+}
+
+// the file the entry went to, NULL when it was ignored. with skipDesc its description is left for applyDescriptions()
+static FileData* applyGamelistEntry(SystemData* system, const GamelistEntry& entry, const FileMatcher& matcher, const bool trustGamelist, const bool skipDesc)
+{
+	const std::string relativeTo = system->getStartPath();
+	const std::string path       = Utils::FileSystem::resolveRelativePath(entry.path, relativeTo, false, true);
+
+	// the folders of the system were scanned before its gamelist is read, a game the scan found is on disk. only the
+	// entries it didn't find, mostly ones left over from removed games, are looked up one by one
+	if(!trustGamelist && !FileData::findGame(path) && !Utils::FileSystem::exists(path))
 	{
-		LOG(LogError) << "Error parsing XML file \"" << xmlpath << "\"!\n	" << result.description();
-		return;
+		LOG(LogWarning) << "File \"" << path << "\" does not exist! Ignoring.";
+		return NULL;
 	}
 
-	pugi::xml_node root = doc.child("gameList");
-	if(!root)
+	// Check whether the file's name is allowed in the system
+	const Utils::FileSystem::PathView fileName = Utils::FileSystem::getFileNameView(path);
+	if (entry.type == GAME && (!matcher.isGame(fileName.data(), fileName.size(), false) || matcher.isExcluded(fileName.data(), fileName.size(), false)))
 	{
-		LOG(LogError) << "Could not find <gameList> node in gamelist \"" << xmlpath << "\"!";
-		return;
+		LOG(LogDebug) << "file " << path << " found in gamelist, but has unregistered extension or is excluded";
+		return NULL;
 	}
 
-	std::string relativeTo = system->getStartPath();
+	// the same as addGame, nothing inside an excluded folder, a folder entry can be one itself
+	if(matcher.hasExcludes())
+	{
+		bool contains = false;
+		const std::string relative = Utils::FileSystem::removeCommonPath(path, relativeTo, contains, true);
+		const Utils::FileSystem::stringList pathList = Utils::FileSystem::getPathList(relative);
+		const size_t folders = ((entry.type == GAME) && !pathList.empty()) ? (pathList.size() - 1) : pathList.size();
+		size_t index = 0;
 
-	const char* tagList[2] = { "game", "folder" };
-	FileType typeList[2] = { GAME, FOLDER };
-	for(int i = 0; i < 2; i++)
+		for(auto it = pathList.cbegin(); contains && (index < folders); ++it, ++index)
+		{
+			if(matcher.isExcluded(*it, true))
+			{
+				LOG(LogDebug) << "file " << path << " found in gamelist, but is in an excluded folder";
+				return NULL;
+			}
+		}
+	}
+
+	FileData* file = findOrCreateFile(system, path, entry.type);
+	if(!file)
 	{
-		const char* tag = tagList[i];
-		FileType type = typeList[i];
-		for(pugi::xml_node fileNode = root.child(tag); fileNode; fileNode = fileNode.next_sibling(tag))
+		LOG(LogError) << "Error finding/creating FileData for \"" << path << "\", skipping.";
+		return NULL;
+	}
+	else if(!file->isArcadeAsset())
+	{
+		std::string defaultName = file->metadata.get(MD_ID_NAME);
+
+		// same as MetaDataList::createFromXML, values missing from the entry keep their defaults
+		const MetaDataListType type = (file->getType() == GAME) ? GAME_METADATA : FOLDER_METADATA;
+		MetaDataList mdl(type);
+
+		for(auto valueIter = entry.values.cbegin(); valueIter != entry.values.cend(); valueIter++)
 		{
-			std::string path = fileNode.child("path").text().get();
-			path = Utils::FileSystem::resolveRelativePath(path, relativeTo, false, true);
+			if(skipDesc && (valueIter->first == MD_ID_DESC))
+				continue;
 
-			if(!trustGamelist && !Utils::FileSystem::exists(path))
-			{
-				LOG(LogWarning) << "File \"" << path << "\" does not exist! Ignoring.";
+			// NULL for the game keys a folder doesn't have
+			const MetaDataId id = (MetaDataId)valueIter->first;
+			const MetaDataDecl* decl = getMDDById(type, id);
+			if(!decl)
 				continue;
-			}
 
-			// Check whether the file's extension is allowed in the system
-			if (i == 0 /*game*/ && std::find(allowedExtensions.cbegin(), allowedExtensions.cend(), Utils::FileSystem::getExtension(path)) == allowedExtensions.cend())
+			// if it's a path, resolve relative paths
+			if(decl->type == MD_PATH)
+				mdl.set(id, Utils::FileSystem::resolveRelativePath(valueIter->second, relativeTo, true, true));
+			else
+				mdl.set(id, valueIter->second);
+		}
+
+		mdl.setDeferredDesc(entry.descOffset);
+		file->metadata = mdl;
+
+		//make sure name gets set if one didn't exist
+		if(file->metadata.get(MD_ID_NAME).empty())
+			file->metadata.set(MD_ID_NAME, defaultName);
+
+		file->metadata.resetChangedFlag();
+	}
+
+	return file;
+}
+
+// the snapshot is only trusted when it was taken from the very gamelist.xml that is on disk right now,
+// and that gamelist.xml wasn't modified during the second the snapshot was taken in
+static bool readGamelistSnapshot(const SystemData* system, const std::string& xmlpath, std::vector<GamelistEntry>& entries)
+{
+	if(!Settings::getInstance()->getBool("GamelistSnapshots"))
+		return false;
+
+	std::string buffer;
+	if(!Utils::Binary::loadFile(getGamelistSnapshotPath(system), buffer))
+		return false;
+
+	const std::vector<MetaDataDecl>& gameMDD = getMDDByType(GAME_METADATA);
+	Utils::Binary::Reader reader(buffer);
+	char magic[4];
+	uint32_t version;
+	std::string snapshotXmlPath;
+	int64_t modifiedTime;
+	int64_t fileSize;
+	int64_t snapshotTime;
+	uint8_t keyCount;
+
+	if(!reader.read(magic, sizeof(magic)) || memcmp(magic, SNAPSHOT_MAGIC, sizeof(magic)) ||
+	   !reader.read(version) || (version != SNAPSHOT_VERSION) ||
+	   !reader.readString(snapshotXmlPath) || (snapshotXmlPath != xmlpath) ||
+	   !reader.read(modifiedTime) || (modifiedTime != (int64_t)Utils::FileSystem::getModifiedTime(xmlpath)) ||
+	   !reader.read(fileSize) || (fileSize != Utils::FileSystem::getFileSize(xmlpath)) ||
+	   !reader.read(snapshotTime) || (modifiedTime >= snapshotTime) ||
+	   !reader.read(keyCount) || (keyCount != gameMDD.size()))
+		return false;
+
+	// metadata values are stored by index, make sure the declarations didn't change since the snapshot was taken
+	for(auto iter = gameMDD.cbegin(); iter != gameMDD.cend(); iter++)
+	{
+		std::string key;
+		if(!reader.readString(key) || (key != iter->key))
+			return false;
+	}
+
+	// validate the whole snapshot before touching the system, a broken one falls back to the XML as if it wasn't there
+	entries.clear();
+	for(;;)
+	{
+		uint8_t type;
+		uint8_t valueCount;
+
+		if(!reader.read(type))
+		{
+			entries.clear();
+			return false;
+		}
+
+		if(type == 0)
+			break;
+
+		GamelistEntry entry;
+		entry.type = (type == 1) ? GAME : FOLDER;
+
+		if(!reader.readString(entry.path) || !reader.read(valueCount) || (valueCount > keyCount))
+		{
+			entries.clear();
+			return false;
+		}
+
+		entry.values.reserve(valueCount);
+		for(uint8_t i = 0; i < valueCount; i++)
+		{
+			std::pair<unsigned char, std::string> value;
+			if(!reader.read(value.first) || (value.first >= keyCount))
 			{
-				LOG(LogDebug) << "file " << path << " found in gamelist, but has unregistered extension";
-				continue;
+				entries.clear();
+				return false;
 			}
 
-			FileData* file = findOrCreateFile(system, path, type);
-			if(!file)
+			const size_t offset = reader.getOffset();
+			if(!reader.readString(value.second))
 			{
-				LOG(LogError) << "Error finding/creating FileData for \"" << path << "\", skipping.";
-				continue;
+				entries.clear();
+				return false;
 			}
-			else if(!file->isArcadeAsset())
-			{
-				std::string defaultName = file->metadata.get("name");
-				file->metadata = MetaDataList::createFromXML(file->getType() == GAME ? GAME_METADATA : FOLDER_METADATA, fileNode, relativeTo);
 
-				//make sure name gets set if one didn't exist
-				if(file->metadata.get("name").empty())
-					file->metadata.set("name", defaultName);
+			// the description is read from here again when it's shown, instead of being kept for every game
+			if((value.first == MD_ID_DESC) && !value.second.empty() && (value.second.size() <= MAX_DESC_LENGTH))
+				entry.descOffset = (uint32_t)offset;
+			else
+				entry.values.push_back(value);
+		}
+
+		entries.push_back(entry);
+	}
+
+	LOG(LogInfo) << "Loading gamelist snapshot of \"" << xmlpath << "\"...";
+
+	return true;
+}
+
+static bool loadGamelistSnapshot(SystemData* system, const std::string& xmlpath, const FileMatcher& matcher, const bool trustGamelist)
+{
+	std::vector<GamelistEntry> entries;
+	if(!readGamelistSnapshot(system, xmlpath, entries))
+		return false;
+
+	for(auto iter = entries.cbegin(); iter != entries.cend(); iter++)
+		applyGamelistEntry(system, *iter, matcher, trustGamelist, false);
+
+	return true;
+}
+
+// descOffsets gets where the description of every entry went, 0 for the ones without one. false if it couldn't be saved
+static bool saveGamelistSnapshot(SystemData* system, const std::string& xmlpath, const std::vector<GamelistEntry>& entries, const time_t snapshotTime, std::vector<uint32_t>& descOffsets)
+{
+	const std::vector<MetaDataDecl>& gameMDD = getMDDByType(GAME_METADATA);
+	Utils::Binary::Writer writer;
+
+	writer.write(SNAPSHOT_MAGIC, sizeof(SNAPSHOT_MAGIC));
+	writer.write(SNAPSHOT_VERSION);
+	writer.writeString(xmlpath);
+	writer.write((int64_t)Utils::FileSystem::getModifiedTime(xmlpath));
+	writer.write(Utils::FileSystem::getFileSize(xmlpath));
+	writer.write((int64_t)snapshotTime);
+	writer.write((uint8_t)gameMDD.size());
+
+	for(auto iter = gameMDD.cbegin(); iter != gameMDD.cend(); iter++)
+		writer.writeString(iter->key);
+
+	for(auto entryIter = entries.cbegin(); entryIter != entries.cend(); entryIter++)
+	{
+		writer.write((uint8_t)(entryIter->type == GAME ? 1 : 2));
+		writer.writeString(entryIter->path);
+		writer.write((uint8_t)entryIter->values.size());
+
+		uint32_t descOffset = 0;
+		for(auto valueIter = entryIter->values.cbegin(); valueIter != entryIter->values.cend(); valueIter++)
+		{
+			writer.write(valueIter->first);
+
+			if((valueIter->first == MD_ID_DESC) && !valueIter->second.empty() && (valueIter->second.size() <= MAX_DESC_LENGTH))
+				descOffset = (uint32_t)writer.getBuffer().size();
+
+			writer.writeString(valueIter->second);
+		}
+		descOffsets.push_back(descOffset);
+	}
+
+	writer.write((uint8_t)0);
+
+	// the descriptions read from the old one are gone with it
+	forgetGamelistDescriptions(system);
+
+	if(!Utils::Binary::saveFile(getGamelistSnapshotPath(system), writer.getBuffer()))
+	{
+		LOG(LogWarning) << "Could not write gamelist snapshot for system \"" << system->getName() << "\"";
+		descOffsets.clear();
+		return false;
+	}
+
+	SharedCache::publish(getGamelistSnapshotPath(system), writer.getBuffer());
+	return true;
+}
+
+// the descriptions of what readGamelistEntries() applied with skipDesc, left in the snapshot when there is one
+static void applyDescriptions(const std::vector<GamelistEntry>& entries, const std::vector<FileData*>& files, const std::vector<uint32_t>& descOffsets)
+{
+	for(size_t i = 0; i < entries.size(); i++)
+	{
+		FileData* file = files[i];
+		if(!file || file->isArcadeAsset())
+			continue;
+
+		if(!descOffsets.empty())
+		{
+			// 0 for an entry without a description, an earlier entry for the same file doesn't count
+			file->metadata.setDeferredDesc(descOffsets[i]);
+			continue;
+		}
 
+		for(auto valueIter = entries[i].values.cbegin(); valueIter != entries[i].values.cend(); valueIter++)
+		{
+			if(valueIter->first != MD_ID_DESC)
+				continue;
+
+			// what was just read is nothing to save
+			const bool changed = file->metadata.wasChanged();
+			file->metadata.set(MD_ID_DESC, valueIter->second);
+			if(!changed)
 				file->metadata.resetChangedFlag();
+		}
+	}
+}
+
+// hands the entries of a gamelist.xml or journal to onEntry as they're parsed, the games in order and then the folders
+static bool readGamelistEntries(const std::string& path, const bool journal, const std::function<void(const GamelistEntry&)>& onEntry)
+{
+	std::vector<GamelistEntry> folders;
+
+	// only one <game> or <folder> is parsed at a time, the whole document is never held in memory
+	GamelistReader reader(path, journal);
+	while(reader.next())
+	{
+		pugi::xml_node fileNode = reader.getNode();
+
+		GamelistEntry entry;
+		entry.type = (strcmp(fileNode.name(), "game") == 0) ? GAME : FOLDER;
+		entry.path = fileNode.child("path").text().get();
+
+		// one pass over the children, the first one of a key counts like with child()
+		bool found[MD_ID_COUNT] = { false };
+		for(pugi::xml_node md = fileNode.first_child(); md; md = md.next_sibling())
+		{
+			const MetaDataId id = getMDIdByKey(md.name());
+			if(id == MD_ID_COUNT || found[id])
+				continue;
+
+			found[id] = true;
+			entry.values.push_back(std::make_pair((unsigned char)id, std::string(md.text().get())));
+		}
+
+		// folders only get metadata once all games have been added, as games may create the folders they are in
+		if(entry.type == FOLDER)
+		{
+			folders.push_back(entry);
+			continue;
+		}
+
+		onEntry(entry);
+	}
+
+	if(reader.hasError())
+		LOG(LogError) << "Error parsing XML file \"" << path << "\"!\n	" << reader.getError();
+
+	for(auto iter = folders.cbegin(); iter != folders.cend(); iter++)
+		onEntry(*iter);
+
+	return !reader.hasError();
+}
+
+// reads the entries of a gamelist.xml or journal into the system, optionally keeping them and the files they went to
+// for a snapshot. the descriptions of the kept ones are left for applyDescriptions()
+static bool loadGamelistEntries(SystemData* system, const std::string& path, const bool journal, const FileMatcher& matcher, const bool trustGamelist, std::vector<GamelistEntry>* entries, std::vector<FileData*>* files)
+{
+	return readGamelistEntries(path, journal, [&](const GamelistEntry& entry)
+	{
+		FileData* file = applyGamelistEntry(system, entry, matcher, trustGamelist, entries != nullptr);
+
+		if(entries)
+		{
+			entries->push_back(entry);
+			files->push_back(file);
+		}
+	});
+}
+
+void parseGamelist(SystemData* system)
+{
+	bool trustGamelist = Settings::getInstance()->getBool("ParseGamelistOnly");
+	std::string xmlpath = system->getGamelistPath(false);
+	const FileMatcher& matcher = system->getFileMatcher();
+
+	if(Utils::FileSystem::exists(xmlpath) && !loadGamelistSnapshot(system, xmlpath, matcher, trustGamelist))
+	{
+		LOG(LogInfo) << "Parsing XML file \"" << xmlpath << "\"...";
+
+		// taken before reading, so a gamelist.xml modified while it is parsed never matches the snapshot
+		const time_t snapshotTime = time(nullptr);
+		const bool takeSnapshot = Settings::getInstance()->getBool("GamelistSnapshots");
+		std::vector<GamelistEntry> entries;
+		std::vector<FileData*> files;
+		std::vector<uint32_t> descOffsets;
+
+		// a broken gamelist.xml is parsed again next time, so the error keeps being reported
+		if(loadGamelistEntries(system, xmlpath, false, matcher, trustGamelist, takeSnapshot ? &entries : nullptr, takeSnapshot ? &files : nullptr) && takeSnapshot)
+			saveGamelistSnapshot(system, xmlpath, entries, snapshotTime, descOffsets);
+
+		// the descriptions stay in the snapshot that was just written, only without one they're kept in memory
+		if(takeSnapshot)
+			applyDescriptions(entries, files, descOffsets);
+	}
+
+	// metadata saved since gamelist.xml was last compacted overrides what's in it
+	const std::string journalPath = system->getGamelistJournalPath();
+	if(Utils::FileSystem::getFileSize(journalPath) > 0)
+	{
+		LOG(LogInfo) << "Replaying gamelist journal \"" << journalPath << "\"...";
+		loadGamelistEntries(system, journalPath, true, matcher, trustGamelist, nullptr, nullptr);
+	}
+}
+
+std::shared_ptr<GamelistData> readGamelist(const SystemData* system)
+{
+	std::shared_ptr<GamelistData> data = std::make_shared<GamelistData>();
+	const std::string xmlpath = system->getGamelistPath(false);
+
+	data->exists = Utils::FileSystem::exists(xmlpath);
+	data->fromSnapshot = data->exists && readGamelistSnapshot(system, xmlpath, data->entries);
+
+	if(data->exists && !data->fromSnapshot)
+	{
+		LOG(LogInfo) << "Parsing XML file \"" << xmlpath << "\"...";
+
+		// taken before reading, so a gamelist.xml modified while it is parsed never matches the snapshot
+		data->snapshotTime = time(nullptr);
+		data->valid = readGamelistEntries(xmlpath, false, [&data](const GamelistEntry& entry) { data->entries.push_back(entry); });
+	}
+
+	const std::string journalPath = system->getGamelistJournalPath();
+	if(Utils::FileSystem::getFileSize(journalPath) > 0)
+	{
+		LOG(LogInfo) << "Reading gamelist journal \"" << journalPath << "\"...";
+		readGamelistEntries(journalPath, true, [&data](const GamelistEntry& entry) { data->journal.push_back(entry); });
+	}
+
+	return data;
+}
+
+void applyGamelist(SystemData* system, const GamelistData& data)
+{
+	const bool trustGamelist = Settings::getInstance()->getBool("ParseGamelistOnly");
+	const FileMatcher& matcher = system->getFileMatcher();
+
+	if(data.fromSnapshot)
+	{
+		for(auto iter = data.entries.cbegin(); iter != data.entries.cend(); iter++)
+			applyGamelistEntry(system, *iter, matcher, trustGamelist, false);
+	}
+	else if(data.exists)
+	{
+		// the same as parseGamelist() does while it reads
+		const bool takeSnapshot = Settings::getInstance()->getBool("GamelistSnapshots");
+		std::vector<FileData*> files;
+		std::vector<uint32_t> descOffsets;
+
+		for(auto iter = data.entries.cbegin(); iter != data.entries.cend(); iter++)
+		{
+			FileData* file = applyGamelistEntry(system, *iter, matcher, trustGamelist, takeSnapshot);
+			if(takeSnapshot)
+				files.push_back(file);
+		}
+
+		if(data.valid && takeSnapshot)
+			saveGamelistSnapshot(system, system->getGamelistPath(false), data.entries, data.snapshotTime, descOffsets);
+
+		if(takeSnapshot)
+			applyDescriptions(data.entries, files, descOffsets);
+	}
+
+	// metadata saved since gamelist.xml was last compacted overrides what's in it
+	for(auto iter = data.journal.cbegin(); iter != data.journal.cend(); iter++)
+		applyGamelistEntry(system, *iter, matcher, trustGamelist, false);
+}
+
+// the last descriptions read, the one of the game selected before is likely to be shown again. the newest first
+struct LoadedDescription
+{
+	SystemData* system;
+	uint32_t    offset;
+	std::string desc;
+};
+
+static std::list<LoadedDescription> sLoadedDescriptions;
+static std::mutex                   sLoadedDescriptionsMutex;
+static const size_t                 MAX_LOADED_DESCRIPTIONS = 16;
+
+void forgetGamelistDescriptions(SystemData* system)
+{
+	std::unique_lock<std::mutex> lock(sLoadedDescriptionsMutex);
+	sLoadedDescriptions.remove_if([system](const LoadedDescription& loaded) { return loaded.system == system; });
+}
+
+std::string loadGamelistDescription(SystemData* system, uint32_t offset)
+{
+	{
+		std::unique_lock<std::mutex> lock(sLoadedDescriptionsMutex);
+		for(auto it = sLoadedDescriptions.begin(); it != sLoadedDescriptions.end(); ++it)
+		{
+			if((it->system == system) && (it->offset == offset))
+			{
+				sLoadedDescriptions.splice(sLoadedDescriptions.begin(), sLoadedDescriptions, it);
+				return sLoadedDescriptions.front().desc;
 			}
 		}
 	}
+
+	std::ifstream stream(getGamelistSnapshotPath(system).c_str(), std::ios::in | std::ios::binary);
+	uint32_t      length = 0;
+
+	// the snapshot is only written while its system is loaded, the offset is good for as long as the system exists
+	if(!stream.seekg(offset) || !stream.read((char*)&length, sizeof(length)) || (length > MAX_DESC_LENGTH))
+	{
+		LOG(LogError) << "Could not read a description from the gamelist snapshot of system \"" << system->getName() << "\"";
+		return "";
+	}
+
+	std::string desc(length, '\0');
+	if(length && !stream.read(&desc[0], length))
+	{
+		LOG(LogError) << "Could not read a description from the gamelist snapshot of system \"" << system->getName() << "\"";
+		return "";
+	}
+
+	std::unique_lock<std::mutex> lock(sLoadedDescriptionsMutex);
+	const LoadedDescription loaded = { system, offset, desc };
+	sLoadedDescriptions.push_front(loaded);
+	if(sLoadedDescriptions.size() > MAX_LOADED_DESCRIPTIONS)
+		sLoadedDescriptions.pop_back();
+
+	return desc;
 }
 
 void addFileDataNode(pugi::xml_node& parent, const FileData* file, const char* tag, SystemData* system)
@@ -183,37 +663,43 @@ void addFileDataNode(pugi::xml_node& parent, const FileData* file, const char* t
 	//write metadata
 	file->metadata.appendToXML(newNode, true, system->getStartPath());
 
+	// the record replaces the whole entry, a description left in the snapshot has to be in it too
+	if(file->metadata.getDeferredDesc())
+		newNode.append_child("desc").text().set(file->getDescription().c_str());
+
 	if(newNode.children().begin() == newNode.child("name") //first element is name
 		&& ++newNode.children().begin() == newNode.children().end() //theres only one element
 		&& newNode.child("name").text().get() == file->getDisplayName()) //the name is the default
 	{
-		//if the only info is the default name, don't bother with this node
-		//delete it and ultimately do nothing
-		parent.remove_child(newNode);
-	}else{
-		//there's something useful in there so we'll keep the node, add the path
-
-		// try and make the path relative if we can so things still work if we change the rom folder location in the future
-		std::string relPath = Utils::FileSystem::createRelativePath(file->getPath(), system->getStartPath(), false, true);
-		newNode.prepend_child("path").text().set(relPath.c_str());
+		//if the only info is the default name, only the path is kept
+		//the entry then resets the file to its defaults and is left out of gamelist.xml on compaction
+		newNode.remove_child("name");
 	}
+
+	// try and make the path relative if we can so things still work if we change the rom folder location in the future
+	std::string relPath = Utils::FileSystem::createRelativePath(file->getPath(), system->getStartPath(), false, true);
+	newNode.prepend_child("path").text().set(relPath.c_str());
 }
 
-void updateGamelist(SystemData* system)
+// where the gamelist of a system lives, taken at save time so the write doesn't need the system anymore
+struct GamelistPaths
+{
+	std::string systemName;
+	std::string relativeTo;
+	std::string xmlReadPath;
+	std::string xmlWritePath;
+	std::string journalPath;
+};
+
+// merges the journal into gamelist.xml and removes it
+static void compactGamelist(const GamelistPaths& paths)
 {
-	//We do this by reading the XML again, adding changes and then writing it back,
-	//because there might be information missing in our systemdata which would then miss in the new XML.
-	//We have the complete information for every game though, so we can simply remove a game
-	//we already have in the system from the XML, and then add it back from its GameData information...
-
-	if(Settings::getInstance()->getBool("IgnoreGamelist"))
-		return;
-
 	pugi::xml_document doc;
 	pugi::xml_node root;
-	std::string xmlReadPath = system->getGamelistPath(false);
+	const std::string& xmlReadPath = paths.xmlReadPath;
+	const std::string& journalPath = paths.journalPath;
 
-	std::string relativeTo = system->getStartPath();
+	const std::string& relativeTo = paths.relativeTo;
 
 	if(Utils::FileSystem::exists(xmlReadPath))
 	{
@@ -237,110 +723,227 @@ void updateGamelist(SystemData* system)
 		root = doc.append_child("gameList");
 	}
 
+	const auto startTs = std::chrono::system_clock::now();
+
+	// the journal is only ever appended to, so the last record of a file is the one that counts
+	pugi::xml_document journal;
+	std::map<std::string, pugi::xml_node> records;
+
+	GamelistReader reader(journalPath, true);
+	while(reader.next())
+	{
+		pugi::xml_node node = reader.getNode();
+		const std::string key = std::string(node.name()) + ":" + Utils::FileSystem::resolveRelativePath(node.child("path").text().get(), relativeTo, false, true);
+
+		auto it = records.find(key);
+		if(it != records.end())
+			journal.remove_child(it->second);
+
+		records[key] = journal.append_copy(node);
+	}
+
+	if(reader.hasError())
+		LOG(LogWarning) << "Gamelist journal \"" << journalPath << "\" is damaged, only the records before the damage are kept: " << reader.getError();
+
+	// remove the entries the journal replaces
+	for(pugi::xml_node fileNode = root.first_child(); fileNode; )
+	{
+		// we need this as we were deleting the iterator and things would become inconsistent
+		pugi::xml_node nextNode = fileNode.next_sibling();
+
+		std::string xmlpath = fileNode.child("path").text().get();
+		// apply the same transformation as in Gamelist::parseGamelist
+		xmlpath = Utils::FileSystem::resolveRelativePath(xmlpath, relativeTo, false, true);
+
+		if(records.find(std::string(fileNode.name()) + ":" + xmlpath) != records.end())
+			root.remove_child(fileNode);
+
+		fileNode = nextNode;
+	}
+
+	// a record holding nothing but its path is back to defaults and doesn't need an entry at all
+	for(pugi::xml_node node = journal.first_child(); node; node = node.next_sibling())
+	{
+		if(node.first_child().next_sibling())
+			root.append_copy(node);
+	}
+
+	// written next to it and renamed over it, losing power halfway through leaves the old gamelist.xml and the journal.
+	// saveFile() also updates the exists index, gamelist.xml may not have existed before
+	std::ostringstream xml;
+	doc.save(xml);
+
+	if (!Utils::Binary::saveFile(paths.xmlWritePath, xml.str())) {
+		LOG(LogError) << "Error saving gamelist.xml to \"" << paths.xmlWritePath << "\" (for system " << paths.systemName << ")!";
+		return;
+	}
+
+	Utils::FileSystem::removeFile(journalPath);
+
+	const auto endTs = std::chrono::system_clock::now();
+	LOG(LogInfo) << "Compacted " << records.size() << " journal entries into gamelist.xml for system \"" << paths.systemName << "\" in " << std::chrono::duration_cast<std::chrono::milliseconds>(endTs - startTs).count() << " ms";
+}
+
+// runs on the gamelist writer thread
+static void writeGamelistJournal(const GamelistPaths& paths, const std::string& records, const size_t numUpdated)
+{
+	const auto startTs = std::chrono::system_clock::now();
+
+	//make sure the folders leading up to this path exist (or the write will fail)
+	Utils::FileSystem::createDirectory(Utils::FileSystem::getParent(paths.journalPath));
+
+	std::ofstream stream(paths.journalPath.c_str(), std::ios::out | std::ios::binary | std::ios::app);
+	if(!stream.is_open())
+	{
+		LOG(LogError) << "Error opening gamelist journal \"" << paths.journalPath << "\" (for system " << paths.systemName << ")!";
+		return;
+	}
+
+	stream.write(records.data(), records.size());
+	stream.close();
+
+	if(stream.fail())
+	{
+		LOG(LogError) << "Error writing gamelist journal \"" << paths.journalPath << "\" (for system " << paths.systemName << ")!";
+		return;
+	}
+
+	const auto endTs = std::chrono::system_clock::now();
+	LOG(LogInfo) << "Added/Updated " << numUpdated << " entities in '" << paths.journalPath << "' in " << std::chrono::duration_cast<std::chrono::milliseconds>(endTs - startTs).count() << " ms";
+
+	if(Utils::FileSystem::getFileSize(paths.journalPath) >= JOURNAL_COMPACT_SIZE)
+		compactGamelist(paths);
+}
+
+// serializes the changed games and folders of a system and resets their changed flags, false when there are none
+static bool serializeGamelist(SystemData* system, GamelistPaths& paths, std::string& data, size_t& numUpdated)
+{
 	std::vector<FileData*> changedGames;
 	std::vector<FileData*> changedFolders;
 
-	//now we have all the information from the XML. now iterate through all our games and add information from there
 	FileData* rootFolder = system->getRootFolder();
-	if (rootFolder != nullptr)
+	if (rootFolder == nullptr)
 	{
-		int numUpdated = 0;
+		LOG(LogError) << "Found no root folder for system \"" << system->getName() << "\"!";
+		return false;
+	}
 
-		std::vector<FileData*> files = rootFolder->getFilesRecursive(GAME | FOLDER);
+	std::vector<FileData*> files = rootFolder->getFilesRecursive(GAME | FOLDER);
 
-		// Stage 1: iterate through all files in memory, checking for changes
-		for(std::vector<FileData*>::const_iterator fit = files.cbegin(); fit != files.cend(); ++fit)
+	// iterate through all files in memory, checking for changes
+	for(std::vector<FileData*>::const_iterator fit = files.cbegin(); fit != files.cend(); ++fit)
+	{
+		// do not touch if it wasn't changed anyway
+		if (!(*fit)->metadata.wasChanged())
+			continue;
+
+		// adding item to changed list
+		if ((*fit)->getType() == GAME)
 		{
+			changedGames.push_back((*fit));
+		}
+		else
+		{
+			changedFolders.push_back((*fit));
+		}
+	}
 
-			// do not touch if it wasn't changed anyway
-			if (!(*fit)->metadata.wasChanged())
-				continue;
+	if(changedGames.empty() && changedFolders.empty())
+		return false;
 
-			// adding item to changed list
-			if ((*fit)->getType() == GAME)
-			{
-				changedGames.push_back((*fit));
-			}
-			else
-			{
-				changedFolders.push_back((*fit));
-			}
+	// serialize the changes right away, the system may be gone by the time they are written
+	std::ostringstream records;
+	const char* tagList[2] = { "game", "folder" };
+	std::vector<FileData*>* changedList[2] = { &changedGames, &changedFolders };
+
+	for(int i = 0; i < 2; i++)
+	{
+		for(std::vector<FileData*>::const_iterator cfit = changedList[i]->cbegin(); cfit != changedList[i]->cend(); ++cfit)
+		{
+			pugi::xml_document record;
+			addFileDataNode(record, *cfit, tagList[i], system);
+			record.first_child().print(records, "\t");
+			(*cfit)->metadata.resetChangedFlag();
 		}
+	}
 
+	paths.systemName   = system->getName();
+	paths.relativeTo   = system->getStartPath();
+	paths.xmlReadPath  = system->getGamelistPath(false);
+	paths.xmlWritePath = system->getGamelistPath(true);
+	paths.journalPath  = system->getGamelistJournalPath();
 
-		// Stage 2: iterate XML if needed, to remove and add changed items
-		const char* tagList[2] = { "game", "folder" };
-		FileType typeList[2] = { GAME, FOLDER };
-		std::vector<FileData*> changedList[2] = { changedGames, changedFolders };
+	numUpdated = changedGames.size() + changedFolders.size();
+	data = records.str();
+	return true;
+}
 
-		for(int i = 0; i < 2; i++)
-		{
-			const char* tag = tagList[i];
-			std::vector<FileData*> changes = changedList[i];
-
-			// check for changed items of this type
-			if (changes.size() > 0) {
-				// check if the item already exists in the XML
-				// if it does, remove all corresponding items before adding
-				for(pugi::xml_node fileNode = root.child(tag); fileNode; )
-				{
-					pugi::xml_node pathNode = fileNode.child("path");
-
-					// we need this as we were deleting the iterator and things would become inconsistent
-					pugi::xml_node nextNode = fileNode.next_sibling(tag);
-
-					if(!pathNode)
-					{
-						LOG(LogError) << "<" << tag << "> node contains no <path> child!";
-						continue;
-					}
-
-					std::string xmlpath = pathNode.text().get();
-					// apply the same transformation as in Gamelist::parseGamelist
-					xmlpath = Utils::FileSystem::resolveRelativePath(xmlpath, relativeTo, false, true);
-
-					for(std::vector<FileData*>::const_iterator cfit = changes.cbegin(); cfit != changes.cend(); ++cfit)
-					{
-						if(xmlpath == (*cfit)->getPath())
-						{
-							// found it
-							root.remove_child(fileNode);
-							break;
-						}
-					}
-					fileNode = nextNode;
+void updateGamelist(SystemData* system)
+{
+	//Changed games are appended to a journal next to gamelist.xml instead of rewriting all of it,
+	//so saving is as fast as the number of changes. Once the journal grows past a limit it is merged
+	//back into gamelist.xml, keeping whatever information the XML has that we don't.
+	//The disk access itself happens on the gamelist writer thread, only the serializing is done here.
 
-				}
+	if(Settings::getInstance()->getBool("IgnoreGamelist"))
+		return;
 
-				// add items to XML
-				for(std::vector<FileData*>::const_iterator cfit = changes.cbegin(); cfit != changes.cend(); ++cfit)
-				{
-					// it was either removed or never existed to begin with; either way, we can add it now
-					addFileDataNode(root, *cfit, tag, system);
-					++numUpdated;
-				}
-			}
-		}
+	GamelistPaths paths;
+	std::string data;
+	size_t numUpdated = 0;
 
-		// now write the file
+	if(!serializeGamelist(system, paths, data, numUpdated))
+		return;
 
-		if (numUpdated > 0) {
-			const auto startTs = std::chrono::system_clock::now();
+	GamelistWriter::getInstance()->queue([paths, data, numUpdated] { writeGamelistJournal(paths, data, numUpdated); });
+}
 
-			//make sure the folders leading up to this path exist (or the write will fail)
-			std::string xmlWritePath(system->getGamelistPath(true));
-			Utils::FileSystem::createDirectory(Utils::FileSystem::getParent(xmlWritePath));
+void updateGamelists(const std::vector<SystemData*>& systems)
+{
+	if(Settings::getInstance()->getBool("IgnoreGamelist"))
+		return;
 
-			LOG(LogInfo) << "Added/Updated " << numUpdated << " entities in '" << xmlReadPath << "'";
+	// what was queued before goes first, the journals are only ever appended to in order
+	GamelistWriter::getInstance()->flush();
 
-			if (!doc.save_file(xmlWritePath.c_str())) {
-				LOG(LogError) << "Error saving gamelist.xml to \"" << xmlWritePath << "\" (for system " << system->getName() << ")!";
-			}
+	// systems with the same <path> share gamelist.xml and its journal, those are written one after the other and the
+	// files of different paths side by side
+	std::map<std::string, std::vector<SystemData*>> byJournal;
 
-			const auto endTs = std::chrono::system_clock::now();
-			LOG(LogInfo) << "Saved gamelist.xml for system \"" << system->getName() << "\" in " << std::chrono::duration_cast<std::chrono::milliseconds>(endTs - startTs).count() << " ms";
-		}
-	}else{
-		LOG(LogError) << "Found no root folder for system \"" << system->getName() << "\"!";
+	for(auto it = systems.cbegin(); it != systems.cend(); ++it)
+	{
+		if(!(*it)->isCollection())
+			byJournal[(*it)->getGamelistJournalPath()].push_back(*it);
+	}
+
+	Utils::TaskScheduler* scheduler = Utils::TaskScheduler::getInstance();
+	Utils::TaskScheduler::Group pending;
+	std::atomic<int> written(0);
+
+	for(auto it = byJournal.cbegin(); it != byJournal.cend(); ++it)
+	{
+		const std::vector<SystemData*> group = it->second;
+
+		scheduler->queue([group, &written]
+		{
+			for(auto system = group.cbegin(); system != group.cend(); ++system)
+			{
+				GamelistPaths paths;
+				std::string data;
+				size_t numUpdated = 0;
+
+				if(serializeGamelist(*system, paths, data, numUpdated))
+				{
+					writeGamelistJournal(paths, data, numUpdated);
+					written++;
+				}
+			}
+		}, Utils::TaskScheduler::PRIORITY_NORMAL, &pending);
 	}
+
+	pending.wait();
+
+	// once for all of them instead of once per file, the power may be cut right after we exit
+	if(written.load() > 0)
+		syncDisks();
 }
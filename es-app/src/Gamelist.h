@@ -2,12 +2,35 @@
 #ifndef ES_APP_GAME_LIST_H
 #define ES_APP_GAME_LIST_H
 
+#include <memory>
+#include <stdint.h>
+#include <string>
+#include <vector>
+
 class SystemData;
+struct GamelistData;
 
 // Loads gamelist.xml data into a SystemData.
 void parseGamelist(SystemData* system);
 
+// parseGamelist() split up, so gamelist.xml, its snapshot and journal can be read on another thread while the folders
+// of the system are scanned. Nothing of the system is touched until applyGamelist(), which has to come after the scan.
+// All entries are held in memory in between, parseGamelist() only holds one at a time
+std::shared_ptr<GamelistData> readGamelist(const SystemData* system);
+void applyGamelist(SystemData* system, const GamelistData& data);
+
+// Reads a description that was left in the gamelist snapshot of a system, see MetaDataList::setDeferredDesc().
+// The last few read are kept.
+std::string loadGamelistDescription(SystemData* system, uint32_t offset);
+
+// Drops the kept descriptions of a system, its snapshot was written again or the system is gone.
+void forgetGamelistDescriptions(SystemData* system);
+
 // Writes currently loaded metadata for a SystemData to gamelist.xml.
 void updateGamelist(SystemData* system);
 
+// updateGamelist() for every system at once, on the task scheduler instead of the gamelist writer thread, and
+// waits until everything is on the disk. For exiting, when nothing else is going on.
+void updateGamelists(const std::vector<SystemData*>& systems);
+
 #endif // ES_APP_GAME_LIST_H
@@ -0,0 +1,270 @@
+#include "GamelistReader.h"
+
+#include "utils/FileSystemUtil.h"
+#include <algorithm>
+#include <string.h>
+
+// how much of the file is read at once, the buffer only grows past this for elements that are bigger
+static const size_t CHUNK_SIZE = 64 * 1024;
+
+static bool isNameEnd(const char c)
+{
+	return (c == ' ') || (c == '\t') || (c == '\r') || (c == '\n') || (c == '/') || (c == '>');
+}
+
+GamelistReader::GamelistReader(const std::string& path, bool journal)
+	: mStream(Utils::FileSystem::getGenericPath(path).c_str(), std::ios::in | std::ios::binary), mOffset(0), mJournal(journal), mInRoot(journal), mDone(false)
+{
+	if(!mStream.is_open())
+		fail("Could not open file");
+}
+
+bool GamelistReader::next()
+{
+	mDocument.reset();
+
+	if(mDone)
+		return false;
+
+	// drop what was already handled so the buffer stays around the size of a single chunk
+	if(mOffset > CHUNK_SIZE)
+	{
+		mBuffer.erase(0, mOffset);
+		mOffset = 0;
+	}
+
+	for(;;)
+	{
+		const size_t start = find("<", mOffset);
+		if(start == std::string::npos)
+		{
+			// a journal simply ends with the last element appended to it
+			if(mJournal)
+			{
+				mDone = true;
+				return false;
+			}
+
+			return fail(mInRoot ? "Unexpected end of file" : "Could not find <gameList> node");
+		}
+
+		ensure(start + 9);
+
+		// declarations, comments and doctypes are skipped wherever they are
+		if(mBuffer.compare(start, 2, "<?") == 0)
+		{
+			const size_t end = find("?>", start + 2);
+			if(end == std::string::npos)
+				return fail("Unexpected end of file");
+
+			mOffset = end + 2;
+			continue;
+		}
+
+		if(mBuffer.compare(start, 4, "<!--") == 0)
+		{
+			const size_t end = find("-->", start + 4);
+			if(end == std::string::npos)
+				return fail("Unexpected end of file");
+
+			mOffset = end + 3;
+			continue;
+		}
+
+		if(mBuffer.compare(start, 2, "<!") == 0)
+		{
+			const size_t end = findTagEnd(start + 2);
+			if(end == std::string::npos)
+				return fail("Unexpected end of file");
+
+			mOffset = end + 1;
+			continue;
+		}
+
+		// the only closing tag seen at this level is the one of <gameList>
+		if(mBuffer.compare(start, 2, "</") == 0)
+		{
+			if(mJournal)
+				return fail("Unexpected closing tag");
+
+			if(!mInRoot)
+				return fail("Could not find <gameList> node");
+
+			mDone = true;
+			return false;
+		}
+
+		size_t nameEnd = start + 1;
+		while(ensure(nameEnd + 1) && !isNameEnd(mBuffer[nameEnd]))
+			++nameEnd;
+
+		const std::string name   = mBuffer.substr(start + 1, nameEnd - start - 1);
+		const size_t      tagEnd = findTagEnd(nameEnd);
+		if(tagEnd == std::string::npos)
+			return fail("Unexpected end of file");
+
+		const bool selfClosing = (mBuffer[tagEnd - 1] == '/');
+
+		if(!mInRoot)
+		{
+			if(name != "gameList")
+				return fail("Could not find <gameList> node");
+
+			mInRoot = true;
+			mOffset = tagEnd + 1;
+
+			if(selfClosing)
+			{
+				mDone = true;
+				return false;
+			}
+
+			continue;
+		}
+
+		const size_t end = selfClosing ? (tagEnd + 1) : findElementEnd(name, tagEnd + 1);
+		if(end == std::string::npos)
+			return fail("Unexpected end of file");
+
+		mOffset = end;
+
+		if((name != "game") && (name != "folder"))
+			continue;
+
+		pugi::xml_parse_result result = mDocument.load_buffer(mBuffer.data() + start, end - start);
+		if(!result)
+			return fail(result.description());
+
+		return true;
+	}
+}
+
+bool GamelistReader::fill()
+{
+	if(!mStream.good())
+		return false;
+
+	const size_t size = mBuffer.size();
+	mBuffer.resize(size + CHUNK_SIZE);
+	mStream.read(&mBuffer[size], CHUNK_SIZE);
+	mBuffer.resize(size + (size_t)mStream.gcount());
+
+	return (mBuffer.size() > size);
+}
+
+bool GamelistReader::ensure(size_t end)
+{
+	while(mBuffer.size() < end)
+	{
+		if(!fill())
+			return false;
+	}
+
+	return true;
+}
+
+size_t GamelistReader::find(const char* str, size_t from)
+{
+	const size_t length = strlen(str);
+
+	for(;;)
+	{
+		const size_t pos = mBuffer.find(str, from);
+		if(pos != std::string::npos)
+			return pos;
+
+		// the string may start right at the end of what's buffered so far
+		if(mBuffer.size() >= length)
+			from = std::max(from, mBuffer.size() - length + 1);
+
+		if(!fill())
+			return std::string::npos;
+	}
+}
+
+size_t GamelistReader::findTagEnd(size_t from)
+{
+	char quote = 0;
+
+	for(size_t i = from; ensure(i + 1); ++i)
+	{
+		const char c = mBuffer[i];
+
+		if(quote)
+		{
+			if(c == quote)
+				quote = 0;
+		}
+		else if((c == '"') || (c == '\''))
+			quote = c;
+		else if(c == '>')
+			return i;
+	}
+
+	return std::string::npos;
+}
+
+size_t GamelistReader::findElementEnd(const std::string& name, size_t from)
+{
+	const size_t length = name.length();
+	int          depth  = 1;
+	size_t       i      = from;
+
+	while(depth > 0)
+	{
+		const size_t pos = find("<", i);
+		if(pos == std::string::npos)
+			return std::string::npos;
+
+		ensure(pos + length + 10);
+
+		// markup that can contain anything, including something that looks like our closing tag
+		if(mBuffer.compare(pos, 4, "<!--") == 0)
+		{
+			const size_t end = find("-->", pos + 4);
+			if(end == std::string::npos)
+				return std::string::npos;
+
+			i = end + 3;
+		}
+		else if(mBuffer.compare(pos, 9, "<![CDATA[") == 0)
+		{
+			const size_t end = find("]]>", pos + 9);
+			if(end == std::string::npos)
+				return std::string::npos;
+
+			i = end + 3;
+		}
+		else if((mBuffer.compare(pos + 1, length, name) == 0) && ((pos + length + 1) < mBuffer.size()) && isNameEnd(mBuffer[pos + length + 1]))
+		{
+			const size_t end = findTagEnd(pos + length + 1);
+			if(end == std::string::npos)
+				return std::string::npos;
+
+			if(mBuffer[end - 1] != '/')
+				++depth;
+
+			i = end + 1;
+		}
+		else if((mBuffer.compare(pos, 2, "</") == 0) && (mBuffer.compare(pos + 2, length, name) == 0) && ((pos + length + 2) < mBuffer.size()) && isNameEnd(mBuffer[pos + length + 2]))
+		{
+			const size_t end = findTagEnd(pos + length + 2);
+			if(end == std::string::npos)
+				return std::string::npos;
+
+			--depth;
+			i = end + 1;
+		}
+		else
+			i = pos + 1;
+	}
+
+	return i;
+}
+
+bool GamelistReader::fail(const std::string& error)
+{
+	mError = error;
+	mDone  = true;
+	return false;
+}
@@ -0,0 +1,46 @@
+#pragma once
+#ifndef ES_APP_GAMELIST_READER_H
+#define ES_APP_GAMELIST_READER_H
+
+#include <pugixml.hpp>
+#include <fstream>
+#include <string>
+
+// Reads a gamelist.xml one top level element at a time instead of loading the whole document.
+// Only the element being returned is parsed into a DOM, so memory use doesn't grow with the size of the gamelist.
+// A journal is read the same way, it's a plain sequence of <game> and <folder> elements without a <gameList> around them.
+class GamelistReader
+{
+public:
+
+	GamelistReader(const std::string& path, bool journal = false);
+
+	// Moves to the next child of <gameList>, returns false when there are none left or the file is broken.
+	bool next();
+
+	// The element that was just read, only valid until the next call to next().
+	pugi::xml_node getNode() const { return mDocument.document_element(); }
+
+	bool               hasError() const { return !mError.empty(); }
+	const std::string& getError() const { return mError; }
+
+private:
+
+	bool   fill          ();
+	bool   ensure        (size_t end);
+	size_t find          (const char* str, size_t from);
+	size_t findTagEnd    (size_t from);
+	size_t findElementEnd(const std::string& name, size_t from);
+	bool   fail          (const std::string& error);
+
+	std::ifstream      mStream;
+	std::string        mBuffer;
+	size_t             mOffset;
+	bool               mJournal;
+	bool               mInRoot;
+	bool               mDone;
+	std::string        mError;
+	pugi::xml_document mDocument;
+};
+
+#endif // ES_APP_GAMELIST_READER_H
@@ -0,0 +1,101 @@
+#include "GamelistWriter.h"
+
+#include "Log.h"
+
+GamelistWriter* GamelistWriter::sInstance = nullptr;
+
+void GamelistWriter::init()
+{
+	if(!sInstance)
+		sInstance = new GamelistWriter();
+
+} // init
+
+void GamelistWriter::deinit()
+{
+	if(sInstance)
+	{
+		delete sInstance;
+		sInstance = nullptr;
+	}
+
+} // deinit
+
+GamelistWriter* GamelistWriter::getInstance()
+{
+	if(!sInstance)
+		sInstance = new GamelistWriter();
+
+	return sInstance;
+
+} // getInstance
+
+GamelistWriter::GamelistWriter() : mWriting(false), mRunning(true)
+{
+	mThread = std::thread(&GamelistWriter::run, this);
+
+} // GamelistWriter
+
+GamelistWriter::~GamelistWriter()
+{
+	// everything still queued is written before the thread stops, nothing saved on exit gets lost
+	flush();
+
+	{
+		const std::unique_lock<std::mutex> lock(mMutex);
+		mRunning = false;
+	}
+
+	mQueued.notify_one();
+	mThread.join();
+
+} // ~GamelistWriter
+
+void GamelistWriter::queue(const WriteFunction& _write)
+{
+	{
+		const std::unique_lock<std::mutex> lock(mMutex);
+		mWrites.push(_write);
+	}
+
+	mQueued.notify_one();
+
+} // queue
+
+void GamelistWriter::flush()
+{
+	std::unique_lock<std::mutex> lock(mMutex);
+
+	if(!mWrites.empty() || mWriting)
+		LOG(LogInfo) << "Waiting for gamelists to be written...";
+
+	while(!mWrites.empty() || mWriting)
+		mWritten.wait(lock);
+
+} // flush
+
+void GamelistWriter::run()
+{
+	std::unique_lock<std::mutex> lock(mMutex);
+
+	for(;;)
+	{
+		while(mRunning && mWrites.empty())
+			mQueued.wait(lock);
+
+		if(mWrites.empty())
+			return;
+
+		WriteFunction write = mWrites.front();
+		mWrites.pop();
+		mWriting = true;
+
+		lock.unlock();
+		write();
+		lock.lock();
+
+		mWriting = false;
+		mWritten.notify_all();
+	}
+
+} // run
@@ -0,0 +1,47 @@
+#pragma once
+#ifndef ES_APP_GAMELIST_WRITER_H
+#define ES_APP_GAMELIST_WRITER_H
+
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+#include <queue>
+#include <thread>
+
+// Runs gamelist writes on a background thread so saving metadata never makes the UI wait on disk I/O.
+// Writes run one at a time in the order they were queued, so appends to the same journal stay ordered.
+class GamelistWriter
+{
+public:
+
+	typedef std::function<void(void)> WriteFunction;
+
+	static void            init       ();
+	static void            deinit     ();
+	static GamelistWriter* getInstance();
+
+	void queue(const WriteFunction& _write);
+
+	// Blocks until everything queued so far has been written.
+	void flush();
+
+private:
+
+	 GamelistWriter();
+	~GamelistWriter();
+
+	void run();
+
+	static GamelistWriter* sInstance;
+
+	std::queue<WriteFunction> mWrites;
+	std::mutex                mMutex;
+	std::condition_variable   mQueued;
+	std::condition_variable   mWritten;
+	bool                      mWriting;
+	bool                      mRunning;
+	std::thread               mThread;
+
+}; // GamelistWriter
+
+#endif // ES_APP_GAMELIST_WRITER_H
@@ -0,0 +1,303 @@
+#include "LibraryWatcher.h"
+
+#include "utils/FileSystemUtil.h"
+#include "views/gamelist/IGameListView.h"
+#include "views/ViewController.h"
+#include "CollectionSystemManager.h"
+#include "FileData.h"
+#include "GameSearchIndex.h"
+#include "Log.h"
+#include "MediaIndex.h"
+#include "SystemData.h"
+#include <algorithm>
+
+#if defined(__linux__)
+#include <poll.h>
+#include <sys/inotify.h>
+#include <unistd.h>
+#endif // __linux__
+
+LibraryWatcher* LibraryWatcher::sInstance = nullptr;
+
+void LibraryWatcher::init()
+{
+	if(!sInstance)
+		sInstance = new LibraryWatcher();
+
+} // init
+
+void LibraryWatcher::deinit()
+{
+	if(sInstance)
+	{
+		delete sInstance;
+		sInstance = nullptr;
+	}
+
+} // deinit
+
+void LibraryWatcher::update()
+{
+	if(sInstance)
+		sInstance->applyChanges();
+
+} // update
+
+LibraryWatcher::LibraryWatcher() : mRunning(false), mFd(-1)
+{
+	// collect the paths here, the system list can change on the main thread while the watcher is running
+	for(auto it = SystemData::sSystemVector.cbegin(); it != SystemData::sSystemVector.cend(); ++it)
+	{
+		if((*it)->isCollection())
+			continue;
+
+		const std::string path = (*it)->getRootFolder()->getPath();
+
+		if(std::find(mRootPaths.cbegin(), mRootPaths.cend(), path) == mRootPaths.cend())
+			mRootPaths.push_back(path);
+	}
+
+#if defined(__linux__)
+	mFd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+
+	if(mFd < 0)
+	{
+		LOG(LogError) << "Could not start watching ROM folders, inotify_init1 failed";
+		return;
+	}
+
+	mRunning = true;
+	mThread  = std::thread(&LibraryWatcher::run, this);
+#else // __linux__
+	LOG(LogWarning) << "Watching ROM folders for changes isn't supported on this platform";
+#endif // !__linux__
+
+} // LibraryWatcher
+
+LibraryWatcher::~LibraryWatcher()
+{
+	if(mRunning)
+	{
+		mRunning = false;
+		mThread.join();
+	}
+
+#if defined(__linux__)
+	if(mFd >= 0)
+		close(mFd);
+#endif // __linux__
+
+} // ~LibraryWatcher
+
+void LibraryWatcher::run()
+{
+#if defined(__linux__)
+	// setting up the watches walks the whole library, so it's done here instead of delaying startup
+	for(auto it = mRootPaths.cbegin(); it != mRootPaths.cend(); ++it)
+		watchDirectory(*it, false);
+
+	LOG(LogInfo) << "Watching " << mWatches.size() << " ROM folders for changes";
+
+	alignas(struct inotify_event) char buffer[16 * 1024];
+
+	while(mRunning)
+	{
+		// wake up regularly so the thread notices when it has to stop
+		struct pollfd fd = { mFd, POLLIN, 0 };
+
+		if(poll(&fd, 1, 250) <= 0)
+			continue;
+
+		const ssize_t length = read(mFd, buffer, sizeof(buffer));
+
+		if(length <= 0)
+			continue;
+
+		for(const char* ptr = buffer; ptr < (buffer + length); )
+		{
+			const struct inotify_event* event = (const struct inotify_event*)ptr;
+			ptr += sizeof(struct inotify_event) + event->len;
+
+			if(event->mask & IN_Q_OVERFLOW)
+			{
+				LOG(LogWarning) << "Too many changes in the ROM folders at once, some of them will only show up after a restart";
+				continue;
+			}
+
+			// the watch is gone because its directory was removed
+			if(event->mask & IN_IGNORED)
+			{
+				mWatches.erase(event->wd);
+				continue;
+			}
+
+			auto watch = mWatches.find(event->wd);
+
+			if((watch == mWatches.end()) || (event->len == 0))
+				continue;
+
+			const std::string directory   = watch->second;
+			const std::string path        = Utils::FileSystem::getGenericPath(directory + "/" + event->name);
+			const bool        isDirectory = (event->mask & IN_ISDIR) != 0;
+
+			// whatever was known about this path and its directory is outdated now
+			Utils::FileSystem::invalidateExists(path);
+			MediaIndex::getInstance()->invalidate(directory);
+
+			if(event->mask & (IN_DELETE | IN_MOVED_FROM))
+			{
+				if(isDirectory)
+					unwatchDirectory(path);
+
+				queueChange(CHANGE_REMOVED, path);
+			}
+			else if(isDirectory)
+			{
+				// watch the new directory before listing it, so nothing written into it in between gets missed
+				watchDirectory(path, true);
+				queueChange(CHANGE_ADDED, path);
+			}
+			else if(event->mask & (IN_CLOSE_WRITE | IN_MOVED_TO))
+			{
+				// files are picked up once they're completely written, not when they're first created
+				queueChange(CHANGE_ADDED, path);
+			}
+			else if((event->mask & IN_CREATE) && Utils::FileSystem::isSymlink(path))
+			{
+				// symlinks are never written to, they're complete as soon as they're created
+				queueChange(CHANGE_ADDED, path);
+			}
+		}
+	}
+#endif // __linux__
+
+} // run
+
+void LibraryWatcher::watchDirectory(const std::string& _path, const bool _reportContent)
+{
+#if defined(__linux__)
+	const int wd = inotify_add_watch(mFd, _path.c_str(), IN_CREATE | IN_CLOSE_WRITE | IN_DELETE | IN_MOVED_FROM | IN_MOVED_TO | IN_ONLYDIR);
+
+	if(wd < 0)
+	{
+		LOG(LogWarning) << "Could not watch ROM folder \"" << _path << "\" for changes";
+		return;
+	}
+
+	// the same directory reached again, through a symlink or a second system using it
+	if(mWatches.find(wd) != mWatches.end())
+		return;
+
+	mWatches[wd] = _path;
+
+	Utils::FileSystem::DirEntryList entries;
+	Utils::FileSystem::getDirEntries(_path, entries);
+
+	// stop walking a large library early when the watcher is shut down meanwhile
+	for(auto it = entries.cbegin(); (it != entries.cend()) && mRunning; ++it)
+	{
+		const std::string path = Utils::FileSystem::getGenericPath(_path + "/" + it->name);
+
+		if(_reportContent)
+			queueChange(CHANGE_ADDED, path);
+
+		if(it->isDirectory)
+			watchDirectory(path, _reportContent);
+	}
+#endif // __linux__
+
+} // watchDirectory
+
+void LibraryWatcher::unwatchDirectory(const std::string& _path)
+{
+#if defined(__linux__)
+	const std::string prefix = _path + "/";
+
+	// a moved directory keeps its watches, they'd report changes under its old path otherwise
+	for(auto it = mWatches.begin(); it != mWatches.end(); )
+	{
+		if((it->second == _path) || (it->second.compare(0, prefix.length(), prefix) == 0))
+		{
+			inotify_rm_watch(mFd, it->first);
+			it = mWatches.erase(it);
+		}
+		else
+			++it;
+	}
+#endif // __linux__
+
+} // unwatchDirectory
+
+void LibraryWatcher::queueChange(const ChangeType _type, const std::string& _path)
+{
+	const std::unique_lock<std::mutex> lock(mMutex);
+	mChanges.push_back({ _type, _path });
+
+} // queueChange
+
+void LibraryWatcher::applyChanges()
+{
+	ChangeList changes;
+
+	{
+		const std::unique_lock<std::mutex> lock(mMutex);
+		changes.swap(mChanges);
+	}
+
+	for(auto it = changes.cbegin(); it != changes.cend(); ++it)
+	{
+		// several systems can share a folder, each of them picks what matches its extensions
+		for(auto sysIt = SystemData::sSystemVector.cbegin(); sysIt != SystemData::sSystemVector.cend(); ++sysIt)
+		{
+			if((*sysIt)->isCollection())
+				continue;
+
+			switch(it->type)
+			{
+				case CHANGE_ADDED:   { addFile((*sysIt), it->path);    } break;
+				case CHANGE_REMOVED: { removeFile((*sysIt), it->path); } break;
+			}
+		}
+	}
+
+} // applyChanges
+
+void LibraryWatcher::addFile(SystemData* _system, const std::string& _path)
+{
+	FileData* game = _system->addGame(_path);
+
+	if(!game)
+		return;
+
+	LOG(LogInfo) << "Added \"" << _path << "\" to " << _system->getName();
+
+	GameSearchIndex::getInstance()->update(game);
+	CollectionSystemManager::get()->refreshCollectionSystems(game);
+	ViewController::get()->onFileChanged(game, FILE_ADDED);
+
+} // addFile
+
+void LibraryWatcher::removeFile(SystemData* _system, const std::string& _path)
+{
+	FileData* file = _system->findFile(_path);
+
+	if(!file)
+		return;
+
+	LOG(LogInfo) << "Removed \"" << _path << "\" from " << _system->getName();
+
+	// folders stay behind once they're empty, like folders that had all their games deleted from the menu
+	std::vector<FileData*> games;
+
+	if(file->getType() == GAME)
+		games.push_back(file);
+	else
+		games = file->getFilesRecursive(GAME);
+
+	for(auto it = games.cbegin(); it != games.cend(); ++it)
+	{
+		CollectionSystemManager::get()->deleteCollectionFiles(*it);
+		ViewController::get()->getGameListView(_system).get()->remove(*it, false, true);
+	}
+
+} // removeFile
@@ -0,0 +1,69 @@
+#pragma once
+#ifndef ES_APP_LIBRARY_WATCHER_H
+#define ES_APP_LIBRARY_WATCHER_H
+
+#include <atomic>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+class SystemData;
+
+// Watches the ROM folders of all loaded systems and applies files being added, removed or renamed as they happen,
+// only the affected games, filter index entries and collections are updated instead of reloading everything.
+// Changes are picked up on a background thread and applied on the main thread by update().
+// Only systems that were loaded at startup are watched, a system that had no games yet still needs a restart.
+class LibraryWatcher
+{
+public:
+
+	static void init  ();
+	static void deinit();
+
+	// Applies the changes seen since the last call, does nothing when the watcher isn't running.
+	// Must be called from the main thread since it touches the game lists and their views.
+	static void update();
+
+private:
+
+	enum ChangeType
+	{
+		CHANGE_ADDED,
+		CHANGE_REMOVED
+	};
+
+	struct Change
+	{
+		ChangeType  type;
+		std::string path;
+	};
+
+	typedef std::vector<Change> ChangeList;
+
+	 LibraryWatcher();
+	~LibraryWatcher();
+
+	void run             ();
+	void watchDirectory  (const std::string& _path, const bool _reportContent);
+	void unwatchDirectory(const std::string& _path);
+	void queueChange     (const ChangeType _type, const std::string& _path);
+	void applyChanges    ();
+
+	static void addFile   (SystemData* _system, const std::string& _path);
+	static void removeFile(SystemData* _system, const std::string& _path);
+
+	static LibraryWatcher* sInstance;
+
+	std::vector<std::string>             mRootPaths;
+	std::unordered_map<int, std::string> mWatches;
+	ChangeList                           mChanges;
+	std::mutex                           mMutex;
+	std::atomic<bool>                    mRunning;
+	std::thread                          mThread;
+	int                                  mFd;
+
+}; // LibraryWatcher
+
+#endif // ES_APP_LIBRARY_WATCHER_H
@@ -0,0 +1,107 @@
+#include "MediaIndex.h"
+
+#include "utils/FileSystemUtil.h"
+#include "utils/StringUtil.h"
+#include "Log.h"
+
+MediaIndex* MediaIndex::sInstance = nullptr;
+
+void MediaIndex::init()
+{
+	if(!sInstance)
+		sInstance = new MediaIndex();
+
+} // init
+
+void MediaIndex::deinit()
+{
+	if(sInstance)
+	{
+		delete sInstance;
+		sInstance = nullptr;
+	}
+
+} // deinit
+
+MediaIndex* MediaIndex::getInstance()
+{
+	if(!sInstance)
+		sInstance = new MediaIndex();
+
+	return sInstance;
+
+} // getInstance
+
+MediaIndex::MediaIndex()
+{
+
+} // MediaIndex
+
+MediaIndex::~MediaIndex()
+{
+
+} // ~MediaIndex
+
+std::string MediaIndex::getKey(const std::string& _path)
+{
+#if defined(_WIN32)
+	// file names aren't case sensitive on windows
+	return Utils::String::toLower(Utils::FileSystem::getGenericPath(_path));
+#else // _WIN32
+	return Utils::FileSystem::getGenericPath(_path);
+#endif // !_WIN32
+
+} // getKey
+
+bool MediaIndex::exists(const std::string& _path)
+{
+	if(_path.empty())
+		return false;
+
+	const std::string key       = getKey(_path);
+	const std::string directory = Utils::FileSystem::getParent(key);
+	const std::string name      = Utils::FileSystem::getFileName(key);
+
+	{
+		const std::unique_lock<std::mutex> lock(mMutex);
+		DirectoryMap::const_iterator       it = mDirectories.find(directory);
+
+		if(it != mDirectories.cend())
+			return (it->second.find(name) != it->second.cend());
+	}
+
+	// list the directory without holding the lock, a directory that doesn't exist simply ends up empty
+	FileSet                             files;
+	const Utils::FileSystem::stringList dirContent = Utils::FileSystem::getDirContent(directory);
+
+	for(Utils::FileSystem::stringList::const_iterator it = dirContent.cbegin(); it != dirContent.cend(); ++it)
+		files.insert(Utils::FileSystem::getFileName(getKey(*it)));
+
+	LOG(LogDebug) << "MediaIndex: listed " << files.size() << " files in \"" << directory << "\"";
+
+	const std::unique_lock<std::mutex> lock(mMutex);
+	const FileSet&                     indexed = mDirectories.emplace(directory, files).first->second;
+
+	return (indexed.find(name) != indexed.cend());
+
+} // exists
+
+void MediaIndex::add(const std::string& _path)
+{
+	const std::string                  key = getKey(_path);
+	const std::unique_lock<std::mutex> lock(mMutex);
+	DirectoryMap::iterator             it  = mDirectories.find(Utils::FileSystem::getParent(key));
+
+	// directories that weren't listed yet will see the file once they are
+	if(it != mDirectories.end())
+		it->second.insert(Utils::FileSystem::getFileName(key));
+
+} // add
+
+void MediaIndex::invalidate(const std::string& _directory)
+{
+	const std::unique_lock<std::mutex> lock(mMutex);
+
+	mDirectories.erase(getKey(_directory));
+
+} // invalidate
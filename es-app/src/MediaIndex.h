@@ -0,0 +1,46 @@
+#pragma once
+#ifndef ES_APP_MEDIA_INDEX_H
+#define ES_APP_MEDIA_INDEX_H
+
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <unordered_set>
+
+// Answers whether a media file exists from a single listing of its directory instead of one stat per file.
+// A directory is listed the first time a file in it is looked up and the listing is kept for the whole session,
+// so media that is added behind our back needs an invalidate() or a restart to show up.
+class MediaIndex
+{
+public:
+
+	static void        init       ();
+	static void        deinit     ();
+	static MediaIndex* getInstance();
+
+	bool exists(const std::string& _path);
+
+	// Records a file that was just written, its directory doesn't need to be listed again for it.
+	void add(const std::string& _path);
+
+	// Forgets the listing of _directory, it's listed again the next time a file in it is looked up.
+	void invalidate(const std::string& _directory);
+
+private:
+
+	typedef std::unordered_set<std::string>          FileSet;
+	typedef std::unordered_map<std::string, FileSet> DirectoryMap;
+
+	 MediaIndex();
+	~MediaIndex();
+
+	static std::string getKey(const std::string& _path);
+
+	static MediaIndex* sInstance;
+
+	DirectoryMap mDirectories;
+	std::mutex   mMutex;
+
+}; // MediaIndex
+
+#endif // ES_APP_MEDIA_INDEX_H
@@ -1,30 +1,33 @@
 #include "MetaData.h"
 
 #include "utils/FileSystemUtil.h"
+#include "utils/StringUtil.h"
 #include "utils/TimeUtil.h"
 #include "Log.h"
+#include <algorithm>
 #include <pugixml.hpp>
+#include <string.h>
 
 MetaDataDecl gameDecls[] = {
-	// key,         type,                   default,            statistic,  name in GuiMetaDataEd,  prompt in GuiMetaDataEd
-	{"name",        MD_STRING,              "",                 false,      "name",                 "enter game name"},
-	{"sortname",    MD_STRING,              "",                 false,      "sortname",             "enter game sort name"},
-	{"desc",        MD_MULTILINE_STRING,    "",                 false,      "description",          "enter description"},
-	{"image",       MD_PATH,                "",                 false,      "image",                "enter path to image"},
-	{"video",       MD_PATH     ,           "",                 false,      "video",                "enter path to video"},
-	{"marquee",     MD_PATH,                "",                 false,      "marquee",              "enter path to marquee"},
-	{"thumbnail",   MD_PATH,                "",                 false,      "thumbnail",            "enter path to thumbnail"},
-	{"rating",      MD_RATING,              "0",                false,      "rating",               "enter rating"},
-	{"releasedate", MD_DATE,                "not-a-date-time",  false,      "release date",         "enter release date"},
-	{"developer",   MD_STRING,              "unknown",          false,      "developer",            "enter game developer"},
-	{"publisher",   MD_STRING,              "unknown",          false,      "publisher",            "enter game publisher"},
-	{"genre",       MD_STRING,              "unknown",          false,      "genre",                "enter game genre"},
-	{"players",     MD_INT,                 "1",                false,      "players",              "enter number of players"},
-	{"favorite",    MD_BOOL,                "false",            false,      "favorite",             "enter favorite off/on"},
-	{"hidden",      MD_BOOL,                "false",            false,      "hidden",               "enter hidden off/on" },
-	{"kidgame",     MD_BOOL,                "false",            false,      "kidgame",              "enter kidgame off/on" },
-	{"playcount",   MD_INT,                 "0",                true,       "play count",           "enter number of times played"},
-	{"lastplayed",  MD_TIME,                "0",                true,       "last played",          "enter last played date"}
+	// id,              key,         type,                   default,            statistic,  name in GuiMetaDataEd,  prompt in GuiMetaDataEd
+	{MD_ID_NAME,        "name",        MD_STRING,              "",                 false,      "name",                 "enter game name"},
+	{MD_ID_SORTNAME,    "sortname",    MD_STRING,              "",                 false,      "sortname",             "enter game sort name"},
+	{MD_ID_DESC,        "desc",        MD_MULTILINE_STRING,    "",                 false,      "description",          "enter description"},
+	{MD_ID_IMAGE,       "image",       MD_PATH,                "",                 false,      "image",                "enter path to image"},
+	{MD_ID_VIDEO,       "video",       MD_PATH     ,           "",                 false,      "video",                "enter path to video"},
+	{MD_ID_MARQUEE,     "marquee",     MD_PATH,                "",                 false,      "marquee",              "enter path to marquee"},
+	{MD_ID_THUMBNAIL,   "thumbnail",   MD_PATH,                "",                 false,      "thumbnail",            "enter path to thumbnail"},
+	{MD_ID_RATING,      "rating",      MD_RATING,              "0",                false,      "rating",               "enter rating"},
+	{MD_ID_RELEASEDATE, "releasedate", MD_DATE,                "not-a-date-time",  false,      "release date",         "enter release date"},
+	{MD_ID_DEVELOPER,   "developer",   MD_STRING,              "unknown",          false,      "developer",            "enter game developer"},
+	{MD_ID_PUBLISHER,   "publisher",   MD_STRING,              "unknown",          false,      "publisher",            "enter game publisher"},
+	{MD_ID_GENRE,       "genre",       MD_STRING,              "unknown",          false,      "genre",                "enter game genre"},
+	{MD_ID_PLAYERS,     "players",     MD_INT,                 "1",                false,      "players",              "enter number of players"},
+	{MD_ID_FAVORITE,    "favorite",    MD_BOOL,                "false",            false,      "favorite",             "enter favorite off/on"},
+	{MD_ID_HIDDEN,      "hidden",      MD_BOOL,                "false",            false,      "hidden",               "enter hidden off/on" },
+	{MD_ID_KIDGAME,     "kidgame",     MD_BOOL,                "false",            false,      "kidgame",              "enter kidgame off/on" },
+	{MD_ID_PLAYCOUNT,   "playcount",   MD_INT,                 "0",                true,       "play count",           "enter number of times played"},
+	{MD_ID_LASTPLAYED,  "lastplayed",  MD_TIME,                "0",                true,       "last played",          "enter last played date"}
 };
 const std::vector<MetaDataDecl> gameMDD(gameDecls, gameDecls + sizeof(gameDecls) / sizeof(gameDecls[0]));
 
@@ -35,19 +38,19 @@ const inline std::string blankDate() {
 }
 
 MetaDataDecl folderDecls[] = {
-	{"name",        MD_STRING,              "",                 false,      "name",                 "enter game name"},
-	{"sortname",    MD_STRING,              "",                 false,      "sortname",             "enter game sort name"},
-	{"desc",        MD_MULTILINE_STRING,    "",                 false,      "description",          "enter description"},
-	{"image",       MD_PATH,                "",                 false,      "image",                "enter path to image"},
-	{"thumbnail",   MD_PATH,                "",                 false,      "thumbnail",            "enter path to thumbnail"},
-	{"video",       MD_PATH,                "",                 false,      "video",                "enter path to video"},
-	{"marquee",     MD_PATH,                "",                 false,      "marquee",              "enter path to marquee"},
-	{"rating",      MD_RATING,              "0",                false,      "rating",               "enter rating"},
-	{"releasedate", MD_DATE,                blankDate(),        true,       "release date",         "enter release date"},
-	{"developer",   MD_STRING,              "",                 false,      "developer",            "enter game developer"},
-	{"publisher",   MD_STRING,              "",                 false,      "publisher",            "enter game publisher"},
-	{"genre",       MD_STRING,              "",                 false,      "genre",                "enter game genre"},
-	{"players",     MD_INT,                 "",                 false,      "players",              "enter number of players"}
+	{MD_ID_NAME,        "name",        MD_STRING,              "",                 false,      "name",                 "enter game name"},
+	{MD_ID_SORTNAME,    "sortname",    MD_STRING,              "",                 false,      "sortname",             "enter game sort name"},
+	{MD_ID_DESC,        "desc",        MD_MULTILINE_STRING,    "",                 false,      "description",          "enter description"},
+	{MD_ID_IMAGE,       "image",       MD_PATH,                "",                 false,      "image",                "enter path to image"},
+	{MD_ID_THUMBNAIL,   "thumbnail",   MD_PATH,                "",                 false,      "thumbnail",            "enter path to thumbnail"},
+	{MD_ID_VIDEO,       "video",       MD_PATH,                "",                 false,      "video",                "enter path to video"},
+	{MD_ID_MARQUEE,     "marquee",     MD_PATH,                "",                 false,      "marquee",              "enter path to marquee"},
+	{MD_ID_RATING,      "rating",      MD_RATING,              "0",                false,      "rating",               "enter rating"},
+	{MD_ID_RELEASEDATE, "releasedate", MD_DATE,                blankDate(),        true,       "release date",         "enter release date"},
+	{MD_ID_DEVELOPER,   "developer",   MD_STRING,              "",                 false,      "developer",            "enter game developer"},
+	{MD_ID_PUBLISHER,   "publisher",   MD_STRING,              "",                 false,      "publisher",            "enter game publisher"},
+	{MD_ID_GENRE,       "genre",       MD_STRING,              "",                 false,      "genre",                "enter game genre"},
+	{MD_ID_PLAYERS,     "players",     MD_INT,                 "",                 false,      "players",              "enter number of players"}
 };
 const std::vector<MetaDataDecl> folderMDD(folderDecls, folderDecls + sizeof(folderDecls) / sizeof(folderDecls[0]));
 
@@ -67,36 +70,201 @@ const std::vector<MetaDataDecl>& getMDDByType(MetaDataListType type)
 
 
 
-MetaDataList::MetaDataList(MetaDataListType type)
-	: mType(type), mWasChanged(false)
+// every key is a game key, folders only use a subset of them. sorted for a binary search, what gamelists are read with
+static std::vector<std::pair<const char*, MetaDataId>> createKeyTable()
 {
-	const std::vector<MetaDataDecl>& mdd = getMDD();
+	std::vector<std::pair<const char*, MetaDataId>> table;
+	for(auto iter = gameMDD.cbegin(); iter != gameMDD.cend(); iter++)
+		table.push_back(std::make_pair(iter->key.c_str(), iter->id));
+
+	std::sort(table.begin(), table.end(), [](const std::pair<const char*, MetaDataId>& a, const std::pair<const char*, MetaDataId>& b) { return strcmp(a.first, b.first) < 0; });
+	return table;
+}
+
+MetaDataId getMDIdByKey(const char* key)
+{
+	static const std::vector<std::pair<const char*, MetaDataId>> table = createKeyTable();
+
+	auto it = std::lower_bound(table.cbegin(), table.cend(), key, [](const std::pair<const char*, MetaDataId>& entry, const char* k) { return strcmp(entry.first, k) < 0; });
+	if(it != table.cend() && strcmp(it->first, key) == 0)
+		return it->second;
+
+	return MD_ID_COUNT;
+}
+
+MetaDataId getMDIdByKey(const std::string& key)
+{
+	return getMDIdByKey(key.c_str());
+}
+
+struct MetaDataDeclTable
+{
+	const MetaDataDecl* decls[MD_ID_COUNT];
+};
+
+static MetaDataDeclTable createDeclTable(MetaDataListType type)
+{
+	MetaDataDeclTable table;
+	for(int i = 0; i < MD_ID_COUNT; i++)
+		table.decls[i] = NULL;
+
+	const std::vector<MetaDataDecl>& mdd = getMDDByType(type);
 	for(auto iter = mdd.cbegin(); iter != mdd.cend(); iter++)
-		set(iter->key, iter->defaultValue);
+		table.decls[iter->id] = &(*iter);
+
+	return table;
 }
 
+const MetaDataDecl* getMDDById(MetaDataListType type, MetaDataId id)
+{
+	static const MetaDataDeclTable gameTable = createDeclTable(GAME_METADATA);
+	static const MetaDataDeclTable folderTable = createDeclTable(FOLDER_METADATA);
+
+	if(id >= MD_ID_COUNT)
+		return NULL;
 
-MetaDataList MetaDataList::createFromXML(MetaDataListType type, pugi::xml_node& node, const std::string& relativeTo)
+	return ((type == FOLDER_METADATA) ? folderTable : gameTable).decls[id];
+}
+
+static bool isNumericMDType(MetaDataType type)
 {
-	MetaDataList mdl(type);
+	return (type == MD_INT) || (type == MD_FLOAT) || (type == MD_BOOL) || (type == MD_RATING);
+}
 
-	const std::vector<MetaDataDecl>& mdd = mdl.getMDD();
+static bool isDateMDType(MetaDataType type)
+{
+	return (type == MD_DATE) || (type == MD_TIME);
+}
+
+// releasedate and lastplayed are the only dates, each gets its own slot in mTimes
+static int getTimeSlot(MetaDataId id)
+{
+	return (id == MD_ID_LASTPLAYED) ? 1 : 0;
+}
 
+std::atomic<unsigned int> MetaDataList::sChangeCount(0);
+
+static float parseNumber(MetaDataType type, const std::string& value)
+{
+	if(type == MD_BOOL)
+		return (value == "true") ? 1.0f : 0.0f;
+
+	return (float)atof(value.c_str());
+}
+
+struct MetaDataDefaults
+{
+	const std::string* values[MD_ID_COUNT];
+	float numbers[MD_ID_COUNT];
+	time_t times[2];
+};
+
+static MetaDataDefaults createDefaults(MetaDataListType type)
+{
+	MetaDataDefaults defaults;
+
+	for(int i = 0; i < MD_ID_COUNT; i++)
+	{
+		defaults.values[i] = Utils::String::intern("");
+		defaults.numbers[i] = 0.0f;
+	}
+
+	defaults.times[0] = defaults.times[1] = Utils::Time::stringToTime("");
+
+	const std::vector<MetaDataDecl>& mdd = getMDDByType(type);
 	for(auto iter = mdd.cbegin(); iter != mdd.cend(); iter++)
 	{
-		pugi::xml_node md = node.child(iter->key.c_str());
-		if(md)
-		{
-			// if it's a path, resolve relative paths
-			std::string value = md.text().get();
-			if (iter->type == MD_PATH)
-			{
-				value = Utils::FileSystem::resolveRelativePath(value, relativeTo, true, true);
-			}
-			mdl.set(iter->key, value);
-		}else{
-			mdl.set(iter->key, iter->defaultValue);
-		}
+		defaults.values[iter->id] = Utils::String::intern(iter->defaultValue);
+		if(isNumericMDType(iter->type))
+			defaults.numbers[iter->id] = parseNumber(iter->type, iter->defaultValue);
+		else if(isDateMDType(iter->type))
+			defaults.times[getTimeSlot(iter->id)] = Utils::Time::stringToTime(iter->defaultValue);
+	}
+
+	return defaults;
+}
+
+// every list starts out with the defaults of its type, they're interned once instead of for every new list
+static const MetaDataDefaults& getDefaults(MetaDataListType type)
+{
+	static const MetaDataDefaults gameDefaults = createDefaults(GAME_METADATA);
+	static const MetaDataDefaults folderDefaults = createDefaults(FOLDER_METADATA);
+
+	return (type == FOLDER_METADATA) ? folderDefaults : gameDefaults;
+}
+
+MetaDataList::MetaDataList(MetaDataListType type)
+	: mType(type), mDeferredDesc(0), mWasChanged(true) // same as if every default had been set one by one
+{
+	const MetaDataDefaults& defaults = getDefaults(type);
+
+	for(int i = 0; i < MD_ID_COUNT; i++)
+	{
+		mValues[i].store(defaults.values[i], std::memory_order_relaxed);
+		mNumbers[i].store(defaults.numbers[i], std::memory_order_relaxed);
+	}
+
+	mTimes[0].store(defaults.times[0], std::memory_order_relaxed);
+	mTimes[1].store(defaults.times[1], std::memory_order_relaxed);
+}
+
+MetaDataList::MetaDataList(const MetaDataList& other)
+	: mType(other.mType), mDeferredDesc(other.getDeferredDesc()), mWasChanged(other.mWasChanged)
+{
+	// each slot is taken as a whole, other may be read on another thread meanwhile
+	for(int i = 0; i < MD_ID_COUNT; i++)
+	{
+		mValues[i].store(other.mValues[i].load(std::memory_order_acquire), std::memory_order_release);
+		mNumbers[i].store(other.mNumbers[i].load(std::memory_order_relaxed), std::memory_order_relaxed);
+	}
+
+	mTimes[0].store(other.mTimes[0].load(std::memory_order_relaxed), std::memory_order_relaxed);
+	mTimes[1].store(other.mTimes[1].load(std::memory_order_relaxed), std::memory_order_relaxed);
+}
+
+MetaDataList& MetaDataList::operator=(const MetaDataList& other)
+{
+	if(this == &other)
+		return *this;
+
+	mType = other.mType;
+
+	// other threads may be reading this one, every slot is published as a whole
+	for(int i = 0; i < MD_ID_COUNT; i++)
+	{
+		mValues[i].store(other.mValues[i].load(std::memory_order_acquire), std::memory_order_release);
+		mNumbers[i].store(other.mNumbers[i].load(std::memory_order_relaxed), std::memory_order_relaxed);
+	}
+
+	mTimes[0].store(other.mTimes[0].load(std::memory_order_relaxed), std::memory_order_relaxed);
+	mTimes[1].store(other.mTimes[1].load(std::memory_order_relaxed), std::memory_order_relaxed);
+
+	mDeferredDesc.store(other.getDeferredDesc(), std::memory_order_relaxed);
+	mWasChanged = other.mWasChanged;
+	return *this;
+}
+
+MetaDataList MetaDataList::createFromXML(MetaDataListType type, pugi::xml_node& node, const std::string& relativeTo)
+{
+	// starts out with the defaults, only what the node has is set
+	MetaDataList mdl(type);
+	bool found[MD_ID_COUNT] = { false };
+
+	// one pass over the children instead of a search for every key, the first one of a key counts like with child()
+	for(pugi::xml_node md = node.first_child(); md; md = md.next_sibling())
+	{
+		const MetaDataId id = getMDIdByKey(md.name());
+		const MetaDataDecl* decl = getMDDById(type, id);
+		if(!decl || found[id])
+			continue;
+
+		found[id] = true;
+
+		// if it's a path, resolve relative paths
+		if(decl->type == MD_PATH)
+			mdl.set(id, Utils::FileSystem::resolveRelativePath(md.text().get(), relativeTo, true, true));
+		else
+			mdl.set(id, md.text().get());
 	}
 
 	return mdl;
@@ -105,46 +273,115 @@ MetaDataList MetaDataList::createFromXML(MetaDataListType type, pugi::xml_node&
 void MetaDataList::appendToXML(pugi::xml_node& parent, bool ignoreDefaults, const std::string& relativeTo) const
 {
 	const std::vector<MetaDataDecl>& mdd = getMDD();
+	const MetaDataDefaults& defaults = getDefaults(mType);
 
 	for(auto mddIter = mdd.cbegin(); mddIter != mdd.cend(); mddIter++)
 	{
-		auto mapIter = mMap.find(mddIter->key);
-		if(mapIter != mMap.cend())
-		{
-			// we have this value!
-			// if it's just the default (and we ignore defaults), don't write it
-			if(ignoreDefaults && mapIter->second == mddIter->defaultValue)
-				continue;
-
-			// try and make paths relative if we can
-			std::string value = mapIter->second;
-			if (mddIter->type == MD_PATH)
-				value = Utils::FileSystem::createRelativePath(value, relativeTo, true, true);
-
-			parent.append_child(mapIter->first.c_str()).text().set(value.c_str());
-		}
+		// if it's just the default (and we ignore defaults), don't write it. both are interned, the same value is the same string
+		const std::string* value = mValues[mddIter->id].load(std::memory_order_acquire);
+		if(ignoreDefaults && value == defaults.values[mddIter->id])
+			continue;
+
+		// try and make paths relative if we can
+		if (mddIter->type == MD_PATH)
+			parent.append_child(mddIter->key.c_str()).text().set(Utils::FileSystem::createRelativePath(*value, relativeTo, true, true).c_str());
+		else
+			parent.append_child(mddIter->key.c_str()).text().set(value->c_str());
 	}
 }
 
-void MetaDataList::set(const std::string& key, const std::string& value)
+void MetaDataList::set(MetaDataId id, const std::string& value)
 {
-	mMap[key] = value;
+	// values replaced later on stay interned, which only adds up when a whole library is scraped again. that's also
+	// what lets other threads read them without a lock, the string a reader got is never freed under it
+	mValues[id].store(Utils::String::intern(value), std::memory_order_release);
+
+	const MetaDataType type = gameMDD[id].type;
+	if(isNumericMDType(type))
+		mNumbers[id].store(parseNumber(type, value), std::memory_order_relaxed);
+	else if(isDateMDType(type))
+		mTimes[getTimeSlot(id)].store(Utils::Time::stringToTime(value), std::memory_order_relaxed);
+
+	if(id == MD_ID_DESC)
+		mDeferredDesc.store(0, std::memory_order_relaxed);
+
 	mWasChanged = true;
+	sChangeCount++;
+}
+
+const std::string& MetaDataList::get(MetaDataId id) const
+{
+	return *mValues[id].load(std::memory_order_acquire);
+}
+
+int MetaDataList::getInt(MetaDataId id) const
+{
+	if(gameMDD[id].type == MD_INT)
+		return (int)mNumbers[id].load(std::memory_order_relaxed);
+
+	return atoi(get(id).c_str());
+}
+
+float MetaDataList::getFloat(MetaDataId id) const
+{
+	if(isNumericMDType(gameMDD[id].type))
+		return mNumbers[id].load(std::memory_order_relaxed);
+
+	return (float)atof(get(id).c_str());
+}
+
+bool MetaDataList::getBool(MetaDataId id) const
+{
+	if(gameMDD[id].type == MD_BOOL)
+		return mNumbers[id].load(std::memory_order_relaxed) != 0.0f;
+
+	return get(id) == "true";
+}
+
+time_t MetaDataList::getTime(MetaDataId id) const
+{
+	if(isDateMDType(gameMDD[id].type))
+		return mTimes[getTimeSlot(id)].load(std::memory_order_relaxed);
+
+	return Utils::Time::stringToTime(get(id));
+}
+
+void MetaDataList::set(const std::string& key, const std::string& value)
+{
+	const MetaDataId id = getMDIdByKey(key);
+	if(id == MD_ID_COUNT)
+	{
+		LOG(LogError) << "Unknown metadata key \"" << key << "\"";
+		return;
+	}
+
+	set(id, value);
 }
 
 const std::string& MetaDataList::get(const std::string& key) const
 {
-	return mMap.at(key);
+	static const std::string empty;
+
+	const MetaDataId id = getMDIdByKey(key);
+	if(id == MD_ID_COUNT)
+	{
+		LOG(LogError) << "Unknown metadata key \"" << key << "\"";
+		return empty;
+	}
+
+	return get(id);
 }
 
 int MetaDataList::getInt(const std::string& key) const
 {
-	return atoi(get(key).c_str());
+	const MetaDataId id = getMDIdByKey(key);
+	return (id != MD_ID_COUNT) ? getInt(id) : 0;
 }
 
 float MetaDataList::getFloat(const std::string& key) const
 {
-	return (float)atof(get(key).c_str());
+	const MetaDataId id = getMDIdByKey(key);
+	return (id != MD_ID_COUNT) ? getFloat(id) : 0.0f;
 }
 
 bool MetaDataList::wasChanged() const
@@ -156,3 +393,8 @@ void MetaDataList::resetChangedFlag()
 {
 	mWasChanged = false;
 }
+
+void MetaDataList::setDeferredDesc(uint32_t offset)
+{
+	mDeferredDesc.store(offset, std::memory_order_relaxed);
+}
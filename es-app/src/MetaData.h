@@ -2,7 +2,9 @@
 #ifndef ES_APP_META_DATA_H
 #define ES_APP_META_DATA_H
 
-#include <map>
+#include <atomic>
+#include <ctime>
+#include <stdint.h>
 #include <vector>
 #include <string>
 
@@ -24,8 +26,35 @@ enum MetaDataType
 	MD_TIME //used for lastplayed
 };
 
+// slot of every key in a MetaDataList, in the order of the game metadata declarations
+// folder metadata uses the same slots for the keys it shares with games
+enum MetaDataId
+{
+	MD_ID_NAME,
+	MD_ID_SORTNAME,
+	MD_ID_DESC,
+	MD_ID_IMAGE,
+	MD_ID_VIDEO,
+	MD_ID_MARQUEE,
+	MD_ID_THUMBNAIL,
+	MD_ID_RATING,
+	MD_ID_RELEASEDATE,
+	MD_ID_DEVELOPER,
+	MD_ID_PUBLISHER,
+	MD_ID_GENRE,
+	MD_ID_PLAYERS,
+	MD_ID_FAVORITE,
+	MD_ID_HIDDEN,
+	MD_ID_KIDGAME,
+	MD_ID_PLAYCOUNT,
+	MD_ID_LASTPLAYED,
+
+	MD_ID_COUNT
+};
+
 struct MetaDataDecl
 {
+	MetaDataId id;
 	std::string key;
 	MetaDataType type;
 	std::string defaultValue;
@@ -42,6 +71,15 @@ enum MetaDataListType
 
 const std::vector<MetaDataDecl>& getMDDByType(MetaDataListType type);
 
+// returns MD_ID_COUNT for keys that aren't declared
+MetaDataId getMDIdByKey(const std::string& key);
+MetaDataId getMDIdByKey(const char* key);
+// the declaration of id in the metadata of type, NULL if that type doesn't have it
+const MetaDataDecl* getMDDById(MetaDataListType type, MetaDataId id);
+
+// Values are only set on the main thread, but any thread may read them while the list exists, without a lock. Every
+// value is a slot of its own that is replaced as a whole, a reader sees either the old or the new one, never a mix.
+// Nothing ties two slots together, a list assigned while it's read can be seen half old and half new.
 class MetaDataList
 {
 public:
@@ -49,7 +87,19 @@ public:
 	void appendToXML(pugi::xml_node& parent, bool ignoreDefaults, const std::string& relativeTo) const;
 
 	MetaDataList(MetaDataListType type);
+	MetaDataList(const MetaDataList& other);
+	MetaDataList& operator=(const MetaDataList& other);
 
+	void set(MetaDataId id, const std::string& value);
+
+	// interned, the string stays valid for the whole run even once the value is replaced
+	const std::string& get(MetaDataId id) const;
+	int getInt(MetaDataId id) const;
+	float getFloat(MetaDataId id) const;
+	bool getBool(MetaDataId id) const;
+	time_t getTime(MetaDataId id) const; // only for the date keys, releasedate and lastplayed
+
+	// string keyed versions of the above, slower as the key needs to be looked up first
 	void set(const std::string& key, const std::string& value);
 
 	const std::string& get(const std::string& key) const;
@@ -59,12 +109,25 @@ public:
 	bool wasChanged() const;
 	void resetChangedFlag();
 
+	// Where in the gamelist snapshot the description was left to be read when it's shown, 0 when it's in the list like
+	// every other value. Setting the description drops it, see FileData::getDescription()
+	void setDeferredDesc(uint32_t offset);
+	uint32_t getDeferredDesc() const { return mDeferredDesc.load(std::memory_order_relaxed); }
+
+	// goes up with every value set on any list, so anything derived from metadata knows when to refresh
+	static unsigned int getChangeCount() { return sChangeCount; }
+
 	inline MetaDataListType getType() const { return mType; }
 	inline const std::vector<MetaDataDecl>& getMDD() const { return getMDDByType(getType()); }
 
 private:
+	static std::atomic<unsigned int> sChangeCount;
+
 	MetaDataListType mType;
-	std::map<std::string, std::string> mMap;
+	std::atomic<const std::string*> mValues[MD_ID_COUNT]; // interned, lists that hold the same value share its string
+	std::atomic<float> mNumbers[MD_ID_COUNT]; // numeric keys are parsed once when set, so sorting doesn't have to
+	std::atomic<time_t> mTimes[2]; // same for the two date keys, a float can't hold a time to the second
+	std::atomic<uint32_t> mDeferredDesc;
 	bool mWasChanged;
 };
 
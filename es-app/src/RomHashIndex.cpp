@@ -0,0 +1,264 @@
+#include "RomHashIndex.h"
+
+#include "utils/BinaryUtil.h"
+#include "utils/FileSystemUtil.h"
+#include "utils/HashUtil.h"
+#include "Log.h"
+#include "Settings.h"
+#include "SharedCache.h"
+#include <string.h>
+
+RomHashIndex* RomHashIndex::sInstance = nullptr;
+
+static const char     CACHE_MAGIC[4] = { 'E', 'S', 'R', 'H' };
+static const uint32_t CACHE_VERSION  = 1;
+
+// files hashed before the index gets written, so an interrupted run keeps most of its work
+#define SAVE_INTERVAL 32
+
+void RomHashIndex::init()
+{
+	if(!sInstance)
+		sInstance = new RomHashIndex();
+
+} // init
+
+void RomHashIndex::deinit()
+{
+	if(sInstance)
+	{
+		delete sInstance;
+		sInstance = nullptr;
+	}
+
+} // deinit
+
+RomHashIndex* RomHashIndex::getInstance()
+{
+	if(!sInstance)
+		sInstance = new RomHashIndex();
+
+	return sInstance;
+
+} // getInstance
+
+bool RomHashIndex::isEnabled()
+{
+	return Settings::getInstance()->getBool("ScraperHashRoms");
+
+} // isEnabled
+
+RomHashIndex::RomHashIndex() : mExit(false), mDirty(false), mUnsaved(0)
+{
+	if(!load())
+		mEntries.clear();
+
+	mThread = std::thread(&RomHashIndex::threadProc, this);
+
+} // RomHashIndex
+
+RomHashIndex::~RomHashIndex()
+{
+	{
+		const std::unique_lock<std::mutex> lock(mMutex);
+		mExit = true;
+	}
+
+	// a file being hashed is given up on, it's queued again next time
+	mEvent.notify_all();
+	mThread.join();
+
+	save();
+
+} // ~RomHashIndex
+
+std::string RomHashIndex::getCachePath()
+{
+	return Utils::FileSystem::getHomePath() + "/.emulationstation/cache/romhashes.cache";
+
+} // getCachePath
+
+bool RomHashIndex::isCurrent(const Entry& _entry, int64_t _size, int64_t _modifiedTime)
+{
+	return (_entry.hashes.size == _size) && (_entry.modifiedTime == _modifiedTime);
+
+} // isCurrent
+
+bool RomHashIndex::get(const std::string& _path, Hashes& _hashes)
+{
+	const int64_t                      size         = (int64_t)Utils::FileSystem::getFileSize(_path);
+	const int64_t                      modifiedTime = (int64_t)Utils::FileSystem::getModifiedTime(_path);
+	const std::unique_lock<std::mutex> lock(mMutex);
+	EntryMap::iterator                 it           = mEntries.find(_path);
+
+	if((it == mEntries.end()) || !isCurrent(it->second, size, modifiedTime))
+		return false;
+
+	_hashes = it->second.hashes;
+	return true;
+
+} // get
+
+void RomHashIndex::queue(const std::string& _path)
+{
+	// folders and the like can't be looked up by hash
+	if(!Utils::FileSystem::isRegularFile(_path))
+		return;
+
+	Hashes hashes;
+	if(get(_path, hashes))
+		return;
+
+	const std::unique_lock<std::mutex> lock(mMutex);
+
+	if(!mQueued.insert(_path).second)
+		return;
+
+	mQueue.push_back(_path);
+	mEvent.notify_one();
+
+} // queue
+
+bool RomHashIndex::isPending(const std::string& _path)
+{
+	const std::unique_lock<std::mutex> lock(mMutex);
+
+	return (mQueued.find(_path) != mQueued.cend());
+
+} // isPending
+
+void RomHashIndex::threadProc()
+{
+	std::unique_lock<std::mutex> lock(mMutex);
+
+	while(true)
+	{
+		mEvent.wait(lock, [this] { return mExit || !mQueue.empty(); });
+		if(mExit)
+			break;
+
+		const std::string path = mQueue.front();
+		mQueue.pop_front();
+
+		// read the file without holding the lock, the scraper keeps asking for hashes meanwhile
+		lock.unlock();
+
+		Entry                 entry;
+		Utils::Hash::Hasher   hasher;
+		entry.modifiedTime  = (int64_t)Utils::FileSystem::getModifiedTime(path);
+		entry.hashes.size   = (int64_t)Utils::FileSystem::getFileSize(path);
+		const bool hashed   = Utils::Hash::hashFile(path, hasher, &mExit);
+
+		if(hashed)
+		{
+			entry.hashes.crc32 = hasher.getCRC32();
+			entry.hashes.md5   = hasher.getMD5();
+			entry.hashes.sha1  = hasher.getSHA1();
+		}
+		else if(!mExit)
+			LOG(LogWarning) << "Could not hash \"" << path << "\"";
+
+		lock.lock();
+
+		mQueued.erase(path);
+
+		if(hashed)
+		{
+			mEntries[path] = entry;
+			mDirty = true;
+
+			if(++mUnsaved >= SAVE_INTERVAL)
+			{
+				lock.unlock();
+				save();
+				lock.lock();
+			}
+		}
+	}
+
+} // threadProc
+
+bool RomHashIndex::load()
+{
+	const std::string path = getCachePath();
+	std::string       buffer;
+
+	// no index written yet
+	if(!Utils::Binary::loadFile(path, buffer))
+		return false;
+
+	Utils::Binary::Reader reader(buffer);
+	char                  magic[4];
+	uint32_t              version;
+	uint32_t              entryCount;
+
+	if(!reader.read(magic, sizeof(magic)) || memcmp(magic, CACHE_MAGIC, sizeof(magic)) ||
+	   !reader.read(version) || (version != CACHE_VERSION) ||
+	   !reader.read(entryCount))
+	{
+		LOG(LogWarning) << "ROM hash index \"" << path << "\" is invalid or outdated, ignoring it";
+		return false;
+	}
+
+	for(uint32_t i = 0; i < entryCount; ++i)
+	{
+		std::string romPath;
+		Entry       entry;
+
+		if(!reader.readString(romPath) || !reader.read(entry.hashes.size) || !reader.read(entry.modifiedTime) ||
+		   !reader.readString(entry.hashes.crc32) || !reader.readString(entry.hashes.md5) || !reader.readString(entry.hashes.sha1))
+		{
+			LOG(LogWarning) << "ROM hash index \"" << path << "\" is truncated, ignoring it";
+			return false;
+		}
+
+		mEntries[romPath] = entry;
+	}
+
+	LOG(LogInfo) << "Loaded ROM hash index with " << mEntries.size() << " files";
+	return true;
+
+} // load
+
+void RomHashIndex::save()
+{
+	const std::unique_lock<std::mutex> saveLock(mSaveMutex);
+	std::unique_lock<std::mutex>       lock(mMutex);
+
+	if(!mDirty)
+		return;
+
+	const std::string     path       = getCachePath();
+	const uint32_t        entryCount = (uint32_t)mEntries.size();
+	Utils::Binary::Writer writer;
+
+	writer.write(CACHE_MAGIC, sizeof(CACHE_MAGIC));
+	writer.write(CACHE_VERSION);
+	writer.write(entryCount);
+
+	// files that were never asked for are kept, the scraper only sees part of the library at a time
+	for(EntryMap::const_iterator it = mEntries.cbegin(); it != mEntries.cend(); ++it)
+	{
+		writer.writeString(it->first);
+		writer.write(it->second.hashes.size);
+		writer.write(it->second.modifiedTime);
+		writer.writeString(it->second.hashes.crc32);
+		writer.writeString(it->second.hashes.md5);
+		writer.writeString(it->second.hashes.sha1);
+	}
+
+	mDirty   = false;
+	mUnsaved = 0;
+	lock.unlock();
+
+	if(!Utils::Binary::saveFile(path, writer.getBuffer()))
+	{
+		LOG(LogError) << "Could not write ROM hash index \"" << path << "\"";
+		return;
+	}
+
+	LOG(LogInfo) << "Saved ROM hash index with " << entryCount << " files";
+
+	SharedCache::publish(path, writer.getBuffer());
+
+} // save
@@ -0,0 +1,82 @@
+#pragma once
+#ifndef ES_APP_ROM_HASH_INDEX_H
+#define ES_APP_ROM_HASH_INDEX_H
+
+#include <atomic>
+#include <condition_variable>
+#include <list>
+#include <mutex>
+#include <set>
+#include <stdint.h>
+#include <string>
+#include <thread>
+#include <unordered_map>
+
+// Persistent index of the CRC32, MD5 and SHA1 of ROM files, so scrapers can look games up by hash instead of by name.
+// Files are hashed one at a time on a background thread, and a hash is reused for as long as the size and the
+// modification time of its file don't change, so a large ISO only gets read once.
+class RomHashIndex
+{
+public:
+
+	struct Hashes
+	{
+		int64_t     size;
+		std::string crc32;
+		std::string md5;
+		std::string sha1;
+	};
+
+	static void          init       ();
+	static void          deinit     ();
+	static RomHashIndex* getInstance();
+
+	// Whether ROMs get hashed at all
+	static bool isEnabled();
+
+	// Fills _hashes and returns true if _path is hashed and unchanged since
+	bool get(const std::string& _path, Hashes& _hashes);
+
+	// Queues _path to be hashed unless its hashes are current, isPending() stays true until that's done
+	void queue(const std::string& _path);
+	bool isPending(const std::string& _path);
+
+	// Writes the index to disk if anything changed
+	void save();
+
+private:
+
+	struct Entry
+	{
+		int64_t modifiedTime;
+		Hashes  hashes;
+	};
+
+	typedef std::unordered_map<std::string, Entry> EntryMap;
+
+	 RomHashIndex();
+	~RomHashIndex();
+
+	void threadProc();
+	bool load();
+
+	static bool isCurrent(const Entry& _entry, int64_t _size, int64_t _modifiedTime);
+
+	static std::string getCachePath();
+
+	static RomHashIndex* sInstance;
+
+	EntryMap                mEntries;
+	std::list<std::string>  mQueue;
+	std::set<std::string>   mQueued;
+	std::mutex              mMutex;
+	std::mutex              mSaveMutex; // the worker saves now and then too
+	std::condition_variable mEvent;
+	std::thread             mThread;
+	std::atomic<bool>       mExit;
+	bool                    mDirty;
+	int                     mUnsaved;
+
+}; // RomHashIndex
+
+#endif // ES_APP_ROM_HASH_INDEX_H
@@ -0,0 +1,191 @@
+#include "RomPrefetch.h"
+
+#include "math/Misc.h"
+#include "utils/FileSystemUtil.h"
+#include "FileData.h"
+#include "FrameScheduler.h"
+#include "Log.h"
+#include "Settings.h"
+#include <SDL_timer.h>
+#include <algorithm>
+#include <vector>
+
+#if defined(__linux__)
+#include <fcntl.h>
+#include <unistd.h>
+#else // __linux__
+#include <fstream>
+#endif // !__linux__
+
+// read at a time, a cursor that moved on stops the read after one of these
+#define PREFETCH_CHUNK (4 * 1024 * 1024)
+
+static Setting<bool> sPrefetchRoms("PrefetchRoms");
+static Setting<int>  sPrefetchRomsDelay("PrefetchRomsDelay");
+static Setting<int>  sPrefetchRomsMaxSize("PrefetchRomsMaxSize");
+
+RomPrefetch* RomPrefetch::sInstance  = nullptr;
+FileData*    RomPrefetch::sCursor    = nullptr;
+unsigned int RomPrefetch::sRestStart = 0;
+bool         RomPrefetch::sRequested = false;
+
+void RomPrefetch::deinit()
+{
+	if(sInstance)
+	{
+		delete sInstance;
+		sInstance = nullptr;
+	}
+
+	sCursor    = nullptr;
+	sRequested = false;
+
+} // deinit
+
+void RomPrefetch::update(FileData* _cursor)
+{
+	if(!sPrefetchRoms.get())
+		_cursor = nullptr;
+	else if(_cursor && (_cursor->getType() != GAME))
+		_cursor = nullptr;
+
+	if(_cursor != sCursor)
+	{
+		// the game the cursor left isn't going to be launched
+		if(sRequested && sInstance)
+			sInstance->request("", 0);
+
+		sCursor    = _cursor;
+		sRestStart = SDL_GetTicks();
+		sRequested = false;
+	}
+
+	if(!sCursor || sRequested)
+		return;
+
+	const int rested = (int)(SDL_GetTicks() - sRestStart);
+	const int delay  = Math::max(sPrefetchRomsDelay.get(), 0);
+
+	// an idle screen doesn't update on its own
+	if(rested < delay)
+	{
+		FrameScheduler::requestFrame(delay - rested);
+		return;
+	}
+
+	if(!sInstance)
+		sInstance = new RomPrefetch();
+
+	sInstance->request(sCursor->getPath(), (int64_t)Math::max(sPrefetchRomsMaxSize.get(), 0) * 1024 * 1024);
+	sRequested = true;
+
+} // update
+
+RomPrefetch::RomPrefetch() : mMaxSize(0), mGeneration(0), mRunning(true)
+{
+	mThread = std::thread(&RomPrefetch::run, this);
+
+} // RomPrefetch
+
+RomPrefetch::~RomPrefetch()
+{
+	{
+		std::unique_lock<std::mutex> lock(mMutex);
+		mRunning = false;
+		++mGeneration;
+	}
+
+	mCondition.notify_one();
+	mThread.join();
+
+} // ~RomPrefetch
+
+void RomPrefetch::run()
+{
+	std::unique_lock<std::mutex> lock(mMutex);
+
+	while(mRunning)
+	{
+		if(mPath.empty())
+		{
+			mCondition.wait(lock);
+			continue;
+		}
+
+		const std::string  path       = mPath;
+		const int64_t      maxSize    = mMaxSize;
+		const unsigned int generation = mGeneration;
+
+		mPath.clear();
+		lock.unlock();
+
+		prefetch(path, maxSize, generation);
+
+		lock.lock();
+	}
+
+} // run
+
+void RomPrefetch::request(const std::string& _path, const int64_t _maxSize)
+{
+	{
+		std::unique_lock<std::mutex> lock(mMutex);
+		mPath    = _path;
+		mMaxSize = _maxSize;
+		++mGeneration;
+	}
+
+	mCondition.notify_one();
+
+} // request
+
+void RomPrefetch::prefetch(const std::string& _path, const int64_t _maxSize, const unsigned int _generation)
+{
+	const int64_t length = std::min(Utils::FileSystem::getFileSize(_path), _maxSize);
+
+	if(length <= 0)
+		return;
+
+	int64_t offset = 0;
+
+	// kept for the next file, only this thread uses it
+	mBuffer.resize(PREFETCH_CHUNK);
+
+	// the chunks are read for real, what was read stays cached. A read only returns once its chunk is in the page
+	// cache, so a cursor that moved on is noticed between two of them
+#if defined(__linux__)
+	const int fd = open(_path.c_str(), O_RDONLY | O_CLOEXEC);
+
+	if(fd < 0)
+		return;
+
+	while((offset < length) && (_generation == mGeneration))
+	{
+		const size_t  chunk = (size_t)std::min(length - offset, (int64_t)PREFETCH_CHUNK);
+		const ssize_t done  = pread64(fd, mBuffer.data(), chunk, (off64_t)offset);
+
+		if(done <= 0)
+			break;
+
+		offset += done;
+	}
+
+	close(fd);
+#else // __linux__
+	std::ifstream file(_path, std::ios::in | std::ios::binary);
+
+	while(file && (offset < length) && (_generation == mGeneration))
+	{
+		const std::streamsize chunk = (std::streamsize)std::min(length - offset, (int64_t)PREFETCH_CHUNK);
+
+		if(!file.read(mBuffer.data(), chunk))
+			break;
+
+		offset += chunk;
+	}
+#endif // !__linux__
+
+	LOG(LogDebug) << "RomPrefetch::prefetch() - " << (offset / (1024 * 1024)) << " of " << (length / (1024 * 1024)) << " MB of \"" << _path << "\"" <<
+	                 ((offset < length) ? ", stopped" : "");
+
+} // prefetch
@@ -0,0 +1,54 @@
+#pragma once
+#ifndef ES_APP_ROM_PREFETCH_H
+#define ES_APP_ROM_PREFETCH_H
+
+#include <atomic>
+#include <condition_variable>
+#include <mutex>
+#include <stdint.h>
+#include <string>
+#include <thread>
+#include <vector>
+
+class FileData;
+
+// With "PrefetchRoms", once the cursor of a gamelist rested on a game for "PrefetchRomsDelay" ms its file is read into
+// the page cache on a background thread, up to "PrefetchRomsMaxSize" MB, so an emulator launched from an NFS share or
+// a USB stick doesn't stall on its first reads. Moving the cursor stops the read after the chunk in flight. Only the
+// file the gamelist points at is read, not the tracks a .cue or .m3u names
+class RomPrefetch
+{
+public:
+
+	static void deinit();
+
+	// Called by the gamelists on every update with the entry under the cursor
+	static void update(FileData* _cursor);
+
+private:
+
+	 RomPrefetch();
+	~RomPrefetch();
+
+	void run     ();
+	// an empty _path only stops the read in progress
+	void request (const std::string& _path, const int64_t _maxSize);
+	void prefetch(const std::string& _path, const int64_t _maxSize, const unsigned int _generation);
+
+	static RomPrefetch* sInstance;
+	static FileData*    sCursor;
+	static unsigned int sRestStart; // when the cursor came to sCursor
+	static bool         sRequested; // sCursor was handed to the thread
+
+	std::string               mPath; // read next, empty when there's nothing to do
+	std::vector<char>         mBuffer; // the chunks are read into
+	int64_t                   mMaxSize;
+	std::atomic<unsigned int> mGeneration; // bumped by every request, a read of an older one stops
+	std::atomic<bool>         mRunning;
+	std::mutex                mMutex;
+	std::condition_variable   mCondition;
+	std::thread               mThread;
+
+}; // RomPrefetch
+
+#endif // ES_APP_ROM_PREFETCH_H
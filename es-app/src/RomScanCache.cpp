@@ -0,0 +1,250 @@
+#include "RomScanCache.h"
+
+#include "utils/BinaryUtil.h"
+#include "utils/FileSystemUtil.h"
+#include "Log.h"
+#include "Settings.h"
+#include "SharedCache.h"
+#include <stdint.h>
+#include <string.h>
+
+RomScanCache* RomScanCache::sInstance = nullptr;
+
+static const char     CACHE_MAGIC[4] = { 'E', 'S', 'R', 'S' };
+static const uint32_t CACHE_VERSION  = 1;
+
+void RomScanCache::init()
+{
+	if(!sInstance)
+		sInstance = new RomScanCache();
+
+} // init
+
+void RomScanCache::deinit()
+{
+	if(sInstance)
+	{
+		delete sInstance;
+		sInstance = nullptr;
+	}
+
+} // deinit
+
+RomScanCache* RomScanCache::getInstance()
+{
+	if(!sInstance)
+		sInstance = new RomScanCache();
+
+	return sInstance;
+
+} // getInstance
+
+RomScanCache::RomScanCache() : mDirty(false)
+{
+	if(Settings::getInstance()->getBool("RomScanCache") && !load())
+		mDirectories.clear();
+
+} // RomScanCache
+
+RomScanCache::~RomScanCache()
+{
+
+} // ~RomScanCache
+
+std::string RomScanCache::getCachePath()
+{
+	return Utils::FileSystem::getHomePath() + "/.emulationstation/cache/romscan.cache";
+
+} // getCachePath
+
+void RomScanCache::getDirContent(const std::string& _path, EntryList& _entries)
+{
+	if(!Settings::getInstance()->getBool("RomScanCache"))
+	{
+		Directory directory;
+		scanDirectory(_path, directory);
+		_entries.swap(directory.entries);
+		return;
+	}
+
+	const time_t                 modifiedTime = Utils::FileSystem::getModifiedTime(_path);
+	std::unique_lock<std::mutex> lock(mMutex);
+	DirectoryMap::iterator       it           = mDirectories.find(_path);
+
+	// a listing is only trusted if the directory wasn't modified during the second it was scanned in,
+	// otherwise a change made right after the scan could go unnoticed with a one second mtime resolution
+	if((it != mDirectories.end()) && (it->second.modifiedTime == modifiedTime) && (modifiedTime < it->second.scanTime))
+	{
+		it->second.visited = true;
+		_entries = it->second.entries;
+		return;
+	}
+
+	// do the actual disk access without holding the lock, other systems may be loading in parallel
+	lock.unlock();
+
+	Directory directory;
+	directory.modifiedTime = modifiedTime;
+	scanDirectory(_path, directory);
+	_entries = directory.entries;
+
+	lock.lock();
+	mDirectories[_path] = directory;
+	mDirty = true;
+
+} // getDirContent
+
+size_t RomScanCache::getEntryCount(const std::string& _path)
+{
+	const std::string            prefix = _path + "/";
+	std::unique_lock<std::mutex> lock(mMutex);
+	size_t                       count  = 0;
+
+	for(DirectoryMap::const_iterator it = mDirectories.cbegin(); it != mDirectories.cend(); ++it)
+	{
+		if((it->first == _path) || (it->first.compare(0, prefix.size(), prefix) == 0))
+			count += it->second.entries.size();
+	}
+
+	return count;
+
+} // getEntryCount
+
+void RomScanCache::scanDirectory(const std::string& _path, Directory& _directory)
+{
+	_directory.scanTime = time(nullptr);
+	_directory.visited  = true;
+	_directory.entries.clear();
+
+	// the listing brings the type of each entry along, a large folder is no longer stat'ed file by file
+	Utils::FileSystem::DirEntryList dirEntries;
+	Utils::FileSystem::getDirEntries(_path, dirEntries);
+	_directory.entries.reserve(dirEntries.size());
+
+	for(Utils::FileSystem::DirEntryList::const_iterator it = dirEntries.cbegin(); it != dirEntries.cend(); ++it)
+	{
+		Entry entry = { it->name, it->isDirectory };
+		_directory.entries.push_back(entry);
+	}
+
+} // scanDirectory
+
+bool RomScanCache::load()
+{
+	const std::string path = getCachePath();
+	std::string       buffer;
+
+	// no cache written yet
+	if(!Utils::Binary::loadFile(path, buffer))
+		return false;
+
+	Utils::Binary::Reader reader(buffer);
+	char                  magic[4];
+	uint32_t              version;
+	uint32_t              directoryCount;
+
+	if(!reader.read(magic, sizeof(magic)) || memcmp(magic, CACHE_MAGIC, sizeof(magic)) ||
+	   !reader.read(version) || (version != CACHE_VERSION) ||
+	   !reader.read(directoryCount))
+	{
+		LOG(LogWarning) << "ROM scan cache \"" << path << "\" is invalid or outdated, ignoring it";
+		return false;
+	}
+
+	for(uint32_t i = 0; i < directoryCount; ++i)
+	{
+		std::string directoryPath;
+		int64_t     modifiedTime;
+		int64_t     scanTime;
+		uint32_t    entryCount;
+
+		// every entry takes at least 5 bytes, anything claiming more than what's left is garbage
+		if(!reader.readString(directoryPath) || !reader.read(modifiedTime) ||
+		   !reader.read(scanTime) || !reader.read(entryCount) ||
+		   (entryCount > (reader.getRemaining() / 5)))
+		{
+			LOG(LogWarning) << "ROM scan cache \"" << path << "\" is truncated, ignoring it";
+			return false;
+		}
+
+		Directory& directory   = mDirectories[directoryPath];
+		directory.modifiedTime = (time_t)modifiedTime;
+		directory.scanTime     = (time_t)scanTime;
+		directory.visited      = false;
+		directory.entries.resize(entryCount);
+
+		for(EntryList::iterator it = directory.entries.begin(); it != directory.entries.end(); ++it)
+		{
+			uint8_t isDirectory;
+
+			if(!reader.read(isDirectory) || !reader.readString(it->name))
+			{
+				LOG(LogWarning) << "ROM scan cache \"" << path << "\" is truncated, ignoring it";
+				return false;
+			}
+
+			it->isDirectory = (isDirectory != 0);
+		}
+	}
+
+	LOG(LogInfo) << "Loaded ROM scan cache with " << mDirectories.size() << " directories";
+	return true;
+
+} // load
+
+void RomScanCache::save()
+{
+	if(!Settings::getInstance()->getBool("RomScanCache"))
+		return;
+
+	const std::unique_lock<std::mutex> lock(mMutex);
+
+	// forget about directories that belong to systems or folders that are gone
+	for(DirectoryMap::iterator it = mDirectories.begin(); it != mDirectories.end(); )
+	{
+		if(!it->second.visited)
+		{
+			it = mDirectories.erase(it);
+			mDirty = true;
+		}
+		else
+			++it;
+	}
+
+	if(!mDirty)
+		return;
+
+	const std::string     path           = getCachePath();
+	const uint32_t        directoryCount = (uint32_t)mDirectories.size();
+	Utils::Binary::Writer writer;
+
+	writer.write(CACHE_MAGIC, sizeof(CACHE_MAGIC));
+	writer.write(CACHE_VERSION);
+	writer.write(directoryCount);
+
+	for(DirectoryMap::const_iterator it = mDirectories.cbegin(); it != mDirectories.cend(); ++it)
+	{
+		writer.writeString(it->first);
+		writer.write((int64_t)it->second.modifiedTime);
+		writer.write((int64_t)it->second.scanTime);
+		writer.write((uint32_t)it->second.entries.size());
+
+		for(EntryList::const_iterator entryIt = it->second.entries.cbegin(); entryIt != it->second.entries.cend(); ++entryIt)
+		{
+			writer.write((uint8_t)(entryIt->isDirectory ? 1 : 0));
+			writer.writeString(entryIt->name);
+		}
+	}
+
+	if(!Utils::Binary::saveFile(path, writer.getBuffer()))
+	{
+		LOG(LogError) << "Could not write ROM scan cache \"" << path << "\"";
+		return;
+	}
+
+	mDirty = false;
+	LOG(LogInfo) << "Saved ROM scan cache with " << directoryCount << " directories";
+
+	SharedCache::publish(path, writer.getBuffer());
+
+} // save
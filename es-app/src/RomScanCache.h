@@ -0,0 +1,67 @@
+#pragma once
+#ifndef ES_APP_ROM_SCAN_CACHE_H
+#define ES_APP_ROM_SCAN_CACHE_H
+
+#include <mutex>
+#include <string>
+#include <time.h>
+#include <unordered_map>
+#include <vector>
+
+// Persistent cache of the directory listings done by SystemData::populateFolder.
+// A cached listing is reused for as long as the modification time of its directory doesn't change,
+// so an unchanged ROM library can be scanned with a single stat per directory instead of one per file.
+class RomScanCache
+{
+public:
+
+	struct Entry
+	{
+		std::string name;
+		bool        isDirectory;
+	};
+
+	typedef std::vector<Entry> EntryList;
+
+	static void          init       ();
+	static void          deinit     ();
+	static RomScanCache* getInstance();
+
+	// Fills _entries with the sorted content of _path, from the cache if it is still valid or from disk otherwise.
+	void getDirContent(const std::string& _path, EntryList& _entries);
+
+	// How many entries the cached listings of _path and the directories below it hold, 0 if it wasn't scanned before.
+	size_t getEntryCount(const std::string& _path);
+
+	// Writes the cache to disk if anything changed, dropping directories that weren't visited since it was loaded.
+	void save();
+
+private:
+
+	struct Directory
+	{
+		time_t    modifiedTime;
+		time_t    scanTime;
+		EntryList entries;
+		bool      visited;
+	};
+
+	typedef std::unordered_map<std::string, Directory> DirectoryMap;
+
+	 RomScanCache();
+	~RomScanCache();
+
+	bool load();
+	void scanDirectory(const std::string& _path, Directory& _directory);
+
+	static std::string getCachePath();
+
+	static RomScanCache* sInstance;
+
+	DirectoryMap mDirectories;
+	std::mutex   mMutex;
+	bool         mDirty;
+
+}; // RomScanCache
+
+#endif // ES_APP_ROM_SCAN_CACHE_H
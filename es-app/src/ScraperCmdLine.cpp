@@ -1,10 +1,25 @@
 #include "ScraperCmdLine.h"
 
+#include "scrapers/Scraper.h"
+#include "utils/FileSystemUtil.h"
+#include "utils/ProfilingUtil.h"
+#include "FileData.h"
+#include "Gamelist.h"
+#include "GamelistWriter.h"
 #include "Log.h"
 #include "platform.h"
+#include "RomHashIndex.h"
+#include "Settings.h"
 #include "SystemData.h"
+#include <algorithm>
+#include <chrono>
+#include <fstream>
+#include <iomanip>
 #include <iostream>
+#include <list>
+#include <set>
 #include <signal.h>
+#include <thread>
 #if defined(__linux__)
 #include <unistd.h>
 #elif defined(WIN32)
@@ -20,6 +35,7 @@ void handle_interrupt_signal(int /*p*/)
 	LOG(LogInfo) << "Interrupt received during scrape...";
 
 	SystemData::deleteSystems();
+	GamelistWriter::deinit();
 
 	exit(1);
 }
@@ -288,3 +304,297 @@ int run_scraper_cmdline()
 
 	return 0;
 }
+
+//==================================================================================
+//batch mode
+//==================================================================================
+
+// how often progress gets printed and the scraped games get written to the gamelists
+#define BATCH_REPORT_INTERVAL 1
+#define BATCH_SAVE_INTERVAL   30
+
+static volatile sig_atomic_t batch_interrupted = 0;
+
+static void handle_batch_interrupt_signal(int /*p*/)
+{
+	// the games done so far still get written before quitting
+	batch_interrupted = 1;
+}
+
+static std::string getBatchProgressPath()
+{
+	return Utils::FileSystem::getHomePath() + "/.emulationstation/scrape_progress.txt";
+}
+
+static std::string formatDuration(int seconds)
+{
+	std::stringstream ss;
+	ss << std::setfill('0') << std::setw(2) << (seconds / 3600) << ":" << std::setw(2) << ((seconds / 60) % 60) << ":" << std::setw(2) << (seconds % 60);
+	return ss.str();
+}
+
+int run_scraper_batch(const std::vector<std::string>& systemNames, bool all, int workers)
+{
+	if(!isValidConfiguredScraper())
+	{
+		out << "Scraper \"" << Settings::getInstance()->getString("Scraper") << "\" does not exist!\n";
+		return 1;
+	}
+
+	if(workers < 1)
+		workers = 1;
+
+	// a benchmark replays what --scrape-record kept as often as it takes, it leaves the gamelists and the progress alone
+	const bool benchmark = (ScraperCache::getMode() == ScraperCache::MODE_REPLAY);
+
+	// games a previous run got to before it was interrupted, one path per line
+	const std::string progressPath = getBatchProgressPath();
+	std::set<std::string> done;
+	if(!benchmark)
+	{
+		std::ifstream progress(progressPath);
+		std::string line;
+
+		while(std::getline(progress, line))
+		{
+			if(!line.empty())
+				done.insert(line);
+		}
+	}
+
+	std::queue<ScraperSearchParams> searches;
+	int resumed = 0;
+
+	for(auto sys = SystemData::sSystemVector.cbegin(); sys != SystemData::sSystemVector.cend(); sys++)
+	{
+		if(!(*sys)->isGameSystem() || (*sys)->isCollection())
+			continue;
+
+		if(!systemNames.empty() && (std::find(systemNames.cbegin(), systemNames.cend(), (*sys)->getName()) == systemNames.cend()))
+			continue;
+
+		std::vector<FileData*> games = (*sys)->getRootFolder()->getFilesRecursive(GAME);
+		for(auto game = games.cbegin(); game != games.cend(); game++)
+		{
+			if(!all && !(*game)->metadata.get("image").empty())
+				continue;
+
+			if(done.find((*game)->getPath()) != done.cend())
+			{
+				resumed++;
+				continue;
+			}
+
+			ScraperSearchParams params;
+			params.game = *game;
+			params.system = *sys;
+			searches.push(params);
+
+			if(RomHashIndex::isEnabled())
+				RomHashIndex::getInstance()->queue((*game)->getPath());
+		}
+	}
+
+	out << "EmulationStation batch scraper\n";
+	out << "==============================\n";
+	out << searches.size() << " games to scrape with " << Settings::getInstance()->getString("Scraper") << ", " << workers << " at once";
+	if(resumed)
+		out << ", " << resumed << " done by a previous run";
+	out << "\n";
+
+	signal(SIGINT, handle_batch_interrupt_signal);
+
+	struct Scrape
+	{
+		ScraperSearchParams params;
+		std::unique_ptr<ScraperSearchHandle> search;
+		std::unique_ptr<MDResolveHandle> resolve;
+	};
+
+	typedef std::chrono::steady_clock Clock;
+
+	const int maxSearches = getScraperMaxSearches();
+	const int total = (int)searches.size();
+	const Clock::time_point start = Clock::now();
+#if defined(USE_PROFILING)
+	const uint64_t allocationsStart = Utils::Profiling::getAllocationCount();
+#endif // USE_PROFILING
+	Clock::time_point lastReport = start;
+	Clock::time_point lastSave = start;
+	std::list<Scrape> scrapes;
+	std::set<SystemData*> dirty;
+	std::vector<std::string> finished;
+	int current = 0;
+	int successful = 0;
+	int failed = 0;
+
+	// writes the changed gamelists first, so a game only counts as done once its metadata is on disk
+	auto save = [&]()
+	{
+		if(benchmark)
+		{
+			dirty.clear();
+			finished.clear();
+			return;
+		}
+
+		for(auto sys = dirty.cbegin(); sys != dirty.cend(); sys++)
+			updateGamelist(*sys);
+		dirty.clear();
+
+		std::ofstream progress(progressPath, std::ios_base::out | std::ios_base::app);
+		for(auto path = finished.cbegin(); path != finished.cend(); path++)
+			progress << *path << "\n";
+		finished.clear();
+	};
+
+	while(!batch_interrupted && (!searches.empty() || !scrapes.empty()))
+	{
+		int running = 0;
+		for(auto it = scrapes.cbegin(); it != scrapes.cend(); it++)
+		{
+			if(it->search)
+				running++;
+		}
+
+		// same as scraping from the menu, the scraper only takes so many searches at once while the others download their images
+		while(!searches.empty() && ((int)scrapes.size() < workers) && (running < maxSearches))
+		{
+			// nobody's in a hurry here, a game is looked up once its hashes are known since they match far better than names
+			if(RomHashIndex::isEnabled() && RomHashIndex::getInstance()->isPending(searches.front().game->getPath()))
+				break;
+
+			scrapes.push_back(Scrape());
+			Scrape& scrape = scrapes.back();
+			scrape.params = searches.front();
+			scrape.search = startScraperSearch(scrape.params);
+			searches.pop();
+			running++;
+		}
+
+		for(auto it = scrapes.begin(); it != scrapes.end(); )
+		{
+			bool finish = false;
+			bool retry = false;
+
+			if(it->search && (it->search->status() != ASYNC_IN_PROGRESS))
+			{
+				const std::vector<ScraperSearchResult>& results = it->search->getResults();
+
+				if(it->search->status() == ASYNC_ERROR)
+				{
+					out << "   " << it->params.game->getPath() << ": " << it->search->getStatusString() << "\n";
+					failed++;
+					finish = retry = true;
+				}
+				else if(results.empty())
+				{
+					out << "   " << it->params.game->getPath() << ": no results\n";
+					failed++;
+					finish = true;
+				}
+				else if(results.front().imageUrl.empty())
+				{
+					it->params.game->metadata = results.front().mdl;
+					successful++;
+					finish = true;
+				}
+				else
+					it->resolve = resolveMetaDataAssets(results.front(), it->params);
+
+				it->search.reset();
+			}
+			else if(it->resolve && (it->resolve->status() != ASYNC_IN_PROGRESS))
+			{
+				if(it->resolve->status() == ASYNC_DONE)
+				{
+					it->params.game->metadata = it->resolve->getResult().mdl;
+					successful++;
+				}
+				else
+				{
+					out << "   " << it->params.game->getPath() << ": " << it->resolve->getStatusString() << "\n";
+					failed++;
+					retry = true;
+				}
+				finish = true;
+			}
+
+			if(finish)
+			{
+				// errors are left for the next run, a game without results won't have any then either
+				if(!retry)
+				{
+					dirty.insert(it->params.system);
+					finished.push_back(it->params.game->getPath());
+				}
+
+				current++;
+				it = scrapes.erase(it);
+			}
+			else
+				it++;
+		}
+
+		const Clock::time_point now = Clock::now();
+
+		if((now - lastReport) >= std::chrono::seconds(BATCH_REPORT_INTERVAL))
+		{
+			const double elapsed = std::chrono::duration<double>(now - start).count();
+			const double rate = (elapsed > 0.0) ? (current / elapsed) : 0.0;
+
+			out << current << "/" << total << " games, " << scrapes.size() << " in flight, " << std::fixed << std::setprecision(2) << rate << " games/s";
+			if(rate > 0.0)
+				out << ", ETA " << formatDuration((int)((total - current) / rate));
+			out << std::endl;
+
+			lastReport = now;
+		}
+
+		if((now - lastSave) >= std::chrono::seconds(BATCH_SAVE_INTERVAL))
+		{
+			save();
+			lastSave = now;
+		}
+
+		std::this_thread::sleep_for(std::chrono::milliseconds(10));
+	}
+
+	// the games still in flight are dropped, the next run starts them again
+	scrapes.clear();
+	save();
+
+	if(RomHashIndex::isEnabled())
+		RomHashIndex::getInstance()->save();
+
+	const double elapsed = std::chrono::duration<double>(Clock::now() - start).count();
+
+	out << "\n";
+	out << successful << " games scraped, " << failed << " failed in " << formatDuration((int)elapsed) << "\n";
+
+	if(benchmark)
+	{
+		const ScraperTimings& timings = getScraperTimings();
+
+		out << std::fixed << std::setprecision(2);
+		out << "Benchmark: " << ((elapsed > 0.0) ? (current / elapsed) : 0.0) << " games/s\n";
+		out << "   parsing " << (timings.parseMicros / 1000.0) << " ms for " << timings.requests << " requests\n";
+		out << "   resizing " << (timings.resizeMicros / 1000.0) << " ms for " << timings.images << " images\n";
+		out << "   " << timings.replayed << " replies replayed, " << timings.missing << " not recorded\n";
+#if defined(USE_PROFILING)
+		out << "   " << (Utils::Profiling::getAllocationCount() - allocationsStart) << " allocations\n";
+#endif // USE_PROFILING
+	}
+
+	if(batch_interrupted)
+	{
+		out << "Interrupted, run again to continue.\n";
+		return 1;
+	}
+
+	// everything got its turn, the next run starts over
+	if(!benchmark)
+		Utils::FileSystem::removeFile(progressPath);
+
+	return 0;
+}
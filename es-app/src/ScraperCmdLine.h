@@ -2,6 +2,15 @@
 #ifndef ES_APP_SCRAPER_CMD_LINE_H
 #define ES_APP_SCRAPER_CMD_LINE_H
 
+#include <string>
+#include <vector>
+
 int run_scraper_cmdline();
 
+// Scrapes without asking anything, taking the first result for each game and keeping up to workers games in flight.
+// An empty systems list scrapes every system, only games without an image are scraped unless all is set.
+// Games already done are skipped when an interrupted run is started again. With the ScraperCache replaying, the run is
+// a benchmark that doesn't write anything but the images and reports the time spent parsing and resizing
+int run_scraper_batch(const std::vector<std::string>& systems, bool all, int workers);
+
 #endif // ES_APP_SCRAPER_CMD_LINE_H
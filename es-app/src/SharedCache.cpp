@@ -0,0 +1,158 @@
+#include "SharedCache.h"
+
+#include "utils/BinaryUtil.h"
+#include "utils/FileSystemUtil.h"
+#include "Log.h"
+#include "Settings.h"
+#include <algorithm>
+#include <mutex>
+#include <stdint.h>
+#include <string.h>
+
+static const char     MANIFEST_MAGIC[4] = { 'E', 'S', 'S', 'C' };
+static const uint32_t MANIFEST_VERSION  = 1;
+static const char*    MANIFEST_NAME     = "shared.manifest";
+
+// the caches are saved from the loading threads, the manifest is rewritten by one at a time
+static std::mutex sPublishMutex;
+
+std::string SharedCache::getLocalPath()
+{
+	return Utils::FileSystem::getHomePath() + "/.emulationstation/cache";
+
+} // getLocalPath
+
+std::string SharedCache::getSharedPath()
+{
+	const std::string path = Settings::getInstance()->getString("SharedCachePath");
+	return path.empty() ? path : Utils::FileSystem::getGenericPath(path);
+
+} // getSharedPath
+
+bool SharedCache::loadManifest(const std::string& _path, Manifest& _manifest)
+{
+	std::string buffer;
+	if(!Utils::Binary::loadFile(_path, buffer))
+		return false;
+
+	Utils::Binary::Reader reader(buffer);
+	char     magic[4];
+	uint32_t version;
+	uint64_t generation;
+	uint32_t count;
+
+	if(!reader.read(magic, sizeof(magic)) || memcmp(magic, MANIFEST_MAGIC, sizeof(magic)) ||
+	   !reader.read(version) || (version != MANIFEST_VERSION) ||
+	   !reader.read(generation) || !reader.read(count))
+		return false;
+
+	_manifest.generation = generation;
+	_manifest.files.clear();
+
+	for(uint32_t i = 0; i < count; i++)
+	{
+		std::string file;
+		if(!reader.readString(file))
+			return false;
+
+		// written by another machine, it mustn't name anything outside the cache directory
+		if(file.empty() || Utils::FileSystem::isAbsolute(file) || (file.find("..") != std::string::npos))
+			return false;
+
+		_manifest.files.push_back(file);
+	}
+
+	return true;
+
+} // loadManifest
+
+bool SharedCache::saveManifest(const std::string& _path, const Manifest& _manifest)
+{
+	Utils::Binary::Writer writer;
+
+	writer.write(MANIFEST_MAGIC, sizeof(MANIFEST_MAGIC));
+	writer.write(MANIFEST_VERSION);
+	writer.write((uint64_t)_manifest.generation);
+	writer.write((uint32_t)_manifest.files.size());
+
+	for(auto it = _manifest.files.cbegin(); it != _manifest.files.cend(); ++it)
+		writer.writeString(*it);
+
+	return Utils::Binary::saveFile(_path, writer.getBuffer());
+
+} // saveManifest
+
+void SharedCache::fetch()
+{
+	const std::string sharedPath = getSharedPath();
+
+	// the publisher's own caches are the newest there are
+	if(sharedPath.empty() || Settings::getInstance()->getBool("SharedCachePublish"))
+		return;
+
+	Manifest shared;
+	if(!loadManifest(sharedPath + "/" + MANIFEST_NAME, shared))
+	{
+		LOG(LogWarning) << "Nothing was published to the shared cache \"" << sharedPath << "\" yet";
+		return;
+	}
+
+	Manifest local;
+	if(loadManifest(getLocalPath() + "/" + MANIFEST_NAME, local) && (local.generation == shared.generation))
+	{
+		LOG(LogDebug) << "Shared cache generation " << shared.generation << " was fetched before";
+		return;
+	}
+
+	size_t fetched = 0;
+	for(auto it = shared.files.cbegin(); it != shared.files.cend(); ++it)
+	{
+		std::string buffer;
+		if(!Utils::Binary::loadFile(sharedPath + "/" + *it, buffer) || !Utils::Binary::saveFile(getLocalPath() + "/" + *it, buffer))
+		{
+			LOG(LogWarning) << "Could not fetch \"" << *it << "\" from the shared cache";
+			continue;
+		}
+
+		fetched++;
+	}
+
+	// one it couldn't get is only built here, there's no need to try again before the next generation
+	saveManifest(getLocalPath() + "/" + MANIFEST_NAME, shared);
+
+	LOG(LogInfo) << "Fetched " << fetched << " of " << shared.files.size() << " caches of shared cache generation " << shared.generation;
+
+} // fetch
+
+void SharedCache::publish(const std::string& _localPath, const std::string& _buffer)
+{
+	const std::string sharedPath = getSharedPath();
+	if(sharedPath.empty() || !Settings::getInstance()->getBool("SharedCachePublish"))
+		return;
+
+	bool              contains = false;
+	const std::string file     = Utils::FileSystem::removeCommonPath(_localPath, getLocalPath(), contains, true);
+	if(!contains)
+		return;
+
+	const std::unique_lock<std::mutex> lock(sPublishMutex);
+
+	if(!Utils::Binary::saveFile(sharedPath + "/" + file, _buffer))
+	{
+		LOG(LogWarning) << "Could not publish \"" << file << "\" to the shared cache \"" << sharedPath << "\"";
+		return;
+	}
+
+	// the cache is in place before the generation that tells the others to fetch it
+	Manifest manifest;
+	if(!loadManifest(sharedPath + "/" + MANIFEST_NAME, manifest))
+		manifest.generation = 0;
+
+	manifest.generation++;
+	if(std::find(manifest.files.cbegin(), manifest.files.cend(), file) == manifest.files.cend())
+		manifest.files.push_back(file);
+
+	if(!saveManifest(sharedPath + "/" + MANIFEST_NAME, manifest))
+		LOG(LogWarning) << "Could not write the manifest of the shared cache \"" << sharedPath << "\"";
+
+} // publish
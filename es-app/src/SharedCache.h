@@ -0,0 +1,38 @@
+#pragma once
+#ifndef ES_APP_SHARED_CACHE_H
+#define ES_APP_SHARED_CACHE_H
+
+#include <string>
+#include <vector>
+
+// Lets cabinets that mount the same ROM share at the same path use the caches one of them built from it. The one with
+// SharedCachePublish copies every cache it writes to SharedCachePath and bumps the generation in the manifest there,
+// the others copy them into their own cache directory at boot when that generation changed since they last did. Every
+// cache still checks itself against the files it was built from, a fetched one that's out of date is only a miss.
+class SharedCache
+{
+public:
+
+	// Before anything reads its cache, costs a single read of the manifest when nothing was published meanwhile
+	static void fetch();
+
+	// Copies _buffer, just written to _localPath below the local cache directory, to the same place on the share
+	static void publish(const std::string& _localPath, const std::string& _buffer);
+
+private:
+
+	struct Manifest
+	{
+		unsigned long long       generation;
+		std::vector<std::string> files; // relative to the cache directory
+	};
+
+	static std::string getLocalPath ();
+	static std::string getSharedPath();
+
+	static bool loadManifest(const std::string& _path, Manifest& _manifest);
+	static bool saveManifest(const std::string& _path, const Manifest& _manifest);
+
+}; // SharedCache
+
+#endif // ES_APP_SHARED_CACHE_H
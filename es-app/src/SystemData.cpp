@@ -2,55 +2,146 @@
 
 #include "utils/FileSystemUtil.h"
 #include "CollectionSystemManager.h"
+#include "FileDataPool.h"
 #include "FileFilterIndex.h"
 #include "FileSorts.h"
+#include "GameSearchIndex.h"
 #include "Gamelist.h"
+#include "GamelistWriter.h"
 #include "Log.h"
+#include "MameNames.h"
 #include "platform.h"
+#include "RomScanCache.h"
 #include "Settings.h"
 #include "ThemeData.h"
 #include "views/UIModeController.h"
+#include <atomic>
+#include <chrono>
 #include <fstream>
+#include <mutex>
 #include <random>
 #include "utils/StringUtil.h"
-#include "utils/ThreadPool.h"
+#include "utils/TaskScheduler.h"
+#include "utils/TimelineUtil.h"
 #include "Window.h"
 
+// read for every folder and file of the library
+static Setting<bool> sShowHiddenFiles("ShowHiddenFiles");
+
 using namespace Utils;
 
 std::vector<SystemData*> SystemData::sSystemVector;
 std::vector<SystemData*> SystemData::sSystemVectorShuffled;
 std::ranlux48 SystemData::sURNG = std::ranlux48(std::random_device()());
+Utils::TaskScheduler* SystemData::sLoadScheduler = NULL;
+std::string SystemData::sConfigPath;
+
+// A threaded load of the systems, kept past loadConfig while a progressive boot hands them over as they're done
+struct SystemLoad
+{
+	SystemLoad() : totalCost(0), loadedCost(0), lastLoaded(-1) { }
+
+	// any system with games if _name is empty, _name otherwise
+	bool isLoaded(const std::string& _name)
+	{
+		std::unique_lock<std::mutex> lock(mutex);
+		for (size_t i = 0; i < systems.size(); i++)
+		{
+			if (systems[i] != nullptr && (_name.empty() || names[i] == _name))
+				return true;
+		}
+		return false;
+	}
+
+	pugi::xml_document       doc; // the tasks read their <system> from it
+	std::vector<std::string> names;
+	std::vector<std::string> fullNames;
+	std::vector<size_t>      costs;
+	size_t                   totalCost;
+	std::atomic<size_t>      loadedCost;
+	std::atomic<int>         lastLoaded;
+
+	std::mutex               mutex;
+	std::vector<SystemData*> systems;  // in es_systems.cfg order, NULL until loaded or without games
+	std::vector<int>         finished; // indexes of systems that weren't handed over yet
+	std::vector<bool>        handedOver;
+
+	TaskScheduler::Group     group; // last, destroying it waits for the tasks that use the rest
+};
+
+static std::unique_ptr<SystemLoad>        sLoad;
+static std::vector<std::function<void()>> sLoadedCallbacks;
 
 
 SystemData::SystemData(const std::string& name, const std::string& fullName, SystemEnvironmentData* envData, const std::string& themeFolder, bool CollectionSystem) :
-	mName(name), mFullName(fullName), mEnvData(envData), mThemeFolder(themeFolder), mIsCollectionSystem(CollectionSystem), mIsGameSystem(true)
+	mName(name), mFullName(fullName), mEnvData(envData), mThemeFolder(themeFolder), mIsCollectionSystem(CollectionSystem), mIsGameSystem(true), mGamesShuffledNext(0), mGamesShuffledGeneration(0), mGamesShuffledValid(false),
+	mDisplayedGamesGeneration(0), mDisplayedGamesFilterGeneration(0), mDisplayedGamesFiltered(false), mDisplayedGamesValid(false)
 {
 	mFilterIndex = new FileFilterIndex();
+	mFileDataPool = new FileDataPool(CollectionSystem ? MemoryUsage::COLLECTIONS : MemoryUsage::FILE_DATA);
+
+	// the theme only depends on where the system is, when loading threaded it's read while the games are
+	TaskScheduler::Future<std::shared_ptr<ThemeData>> theme;
 
 	// if it's an actual system, initialize it, if not, just create the data structure
 	if(!CollectionSystem)
 	{
-		mRootFolder = new FileData(FOLDER, mEnvData->mStartPath, mEnvData, this);
+		mRootFolder = new (mFileDataPool) FileData(FOLDER, mEnvData->mStartPath, mEnvData, this);
 		mRootFolder->metadata.set("name", mFullName);
 
+		// gamelist.xml is read while the folders are scanned, and only applied to them once that's done. It's all held
+		// in memory in between, with LowMemory it's parsed afterwards one entry at a time instead
+		TaskScheduler::Future<std::shared_ptr<GamelistData>> gamelist;
+		const bool loadGamelist = !Settings::getInstance()->getBool("IgnoreGamelist");
+
+		if(sLoadScheduler != NULL)
+		{
+			const std::string themePath = getThemePath();
+			const std::map<std::string, std::string> variables = getThemeVariables();
+			theme = sLoadScheduler->run<std::shared_ptr<ThemeData>>([themePath, variables] { return prepareTheme(themePath, variables); });
+
+			if(loadGamelist && !Settings::getInstance()->getBool("LowMemory"))
+			{
+				const SystemData* system = this;
+				gamelist = sLoadScheduler->run<std::shared_ptr<GamelistData>>([system] { TimelineScopeDetail("readGamelist", system->getName()); return readGamelist(system); });
+			}
+		}
+
 		if(!Settings::getInstance()->getBool("ParseGamelistOnly"))
+		{
+			TimelineScopeDetail("SystemData::populateFolder", mName);
 			populateFolder(mRootFolder);
+		}
 
-		if(!Settings::getInstance()->getBool("IgnoreGamelist"))
+		if(gamelist.isValid())
+		{
+			std::shared_ptr<GamelistData> data = gamelist.get();
+			TimelineScopeDetail("applyGamelist", mName);
+			applyGamelist(this, *data);
+		}
+		else if(loadGamelist)
+		{
+			TimelineScopeDetail("parseGamelist", mName);
 			parseGamelist(this);
+		}
 
 		mRootFolder->sort(FileSorts::SortTypes.at(0));
 
-		indexAllGameFilters(mRootFolder);
+		// most systems are never filtered, their index is built once a filter or the UI mode needs it, or on an idle screen
+		mFilterIndex->setPendingRoot(mRootFolder);
 	}
 	else
 	{
 		// virtual systems are updated afterwards, we're just creating the data structure
-		mRootFolder = new FileData(FOLDER, "" + name, mEnvData, this);
+		mRootFolder = new (mFileDataPool) FileData(FOLDER, "" + name, mEnvData, this);
 	}
 	setIsGameSystemStatus();
-	loadTheme();
+
+	TimelineScopeDetail("SystemData::loadTheme", mName);
+	if(theme.isValid())
+		mTheme = theme.get();
+	else
+		loadTheme();
 }
 
 SystemData::~SystemData()
@@ -58,8 +149,14 @@ SystemData::~SystemData()
 	if(Settings::getInstance()->getString("SaveGamelistsMode") == "on exit")
 		writeMetaData();
 
+	FileData::forgetGames(this);
+	GameSearchIndex::forgetSystem(this);
+	forgetGamelistDescriptions(this);
 	delete mRootFolder;
 	delete mFilterIndex;
+
+	// the rest of the tree is never deleted node by node, its memory goes away with the pool
+	delete mFileDataPool;
 }
 
 void SystemData::setIsGameSystemStatus()
@@ -91,70 +188,179 @@ void SystemData::populateFolder(FileData* folder)
 	}
 
 	std::string filePath;
-	std::string extension;
 	bool isGame;
-	bool showHidden = Settings::getInstance()->getBool("ShowHiddenFiles");
-	Utils::FileSystem::stringList dirContent = Utils::FileSystem::getDirContent(folderPath);
-	for(Utils::FileSystem::stringList::const_iterator it = dirContent.cbegin(); it != dirContent.cend(); ++it)
+	bool showHidden = sShowHiddenFiles.get();
+	const FileMatcher& matcher = mEnvData->mFileMatcher;
+	TaskScheduler* scheduler = sLoadScheduler;
+	std::vector<FileData*> newFolders;
+	TaskScheduler::Group pendingFolders;
+	RomScanCache::EntryList dirContent;
+	RomScanCache::getInstance()->getDirContent(folderPath, dirContent);
+	for(RomScanCache::EntryList::const_iterator it = dirContent.cbegin(); it != dirContent.cend(); ++it)
 	{
-		filePath = *it;
-
-		// skip hidden files and folders
-		if(!showHidden && Utils::FileSystem::isHidden(filePath))
+		// skip hidden files and folders, only Windows needs more than the name to tell
+		if(!showHidden && !it->name.empty() && (it->name[0] == '.'))
 			continue;
 
-		//this is a little complicated because we allow a list of extensions to be defined (delimited with a space)
-		//we first get the extension of the file itself:
-		extension = Utils::FileSystem::getExtension(filePath);
+		// an excluded folder isn't descended into
+		if(matcher.isExcluded(it->name, it->isDirectory))
+			continue;
 
 		//fyi, folders *can* also match the extension and be added as games - this is mostly just to support higan
 		//see issue #75: https://github.com/Aloshi/EmulationStation/issues/75
+		isGame = matcher.isGame(it->name, it->isDirectory);
 
-		isGame = false;
-		if(std::find(mEnvData->mSearchExtensions.cbegin(), mEnvData->mSearchExtensions.cend(), extension) != mEnvData->mSearchExtensions.cend())
+		// most entries of a large folder are neither, no path is built for them
+		if(!isGame && !it->isDirectory)
+			continue;
+
+		filePath = Utils::FileSystem::getGenericPath(folderPath + "/" + it->name);
+
+#if defined(_WIN32)
+		if(!showHidden && Utils::FileSystem::isHidden(filePath))
+			continue;
+#endif // _WIN32
+
+		if(isGame)
 		{
-			FileData* newGame = new FileData(GAME, filePath, mEnvData, this);
+			FileData* newGame = new (mFileDataPool) FileData(GAME, filePath, mEnvData, this);
 
 			// preventing new arcade assets to be added
 			if(!newGame->isArcadeAsset())
-			{
 				folder->addChild(newGame);
-				isGame = true;
-			}
+			else
+				isGame = false;
 		}
 
 		//add directories that also do not match an extension as folders
-		if(!isGame && Utils::FileSystem::isDirectory(filePath))
+		if(!isGame && it->isDirectory)
 		{
-			FileData* newFolder = new FileData(FOLDER, filePath, mEnvData, this);
-			populateFolder(newFolder);
+			FileData* newFolder = new (mFileDataPool) FileData(FOLDER, filePath, mEnvData, this);
+			newFolders.push_back(newFolder);
 
-			//ignore folders that do not contain games
-			if(newFolder->getChildrenByFilename().size() == 0)
-				delete newFolder;
+			// when loading threaded, scan subfolders side by side so one large system doesn't end up on a single core
+			if(scheduler != NULL)
+				scheduler->queue([this, newFolder] { populateFolder(newFolder); }, TaskScheduler::PRIORITY_NORMAL, &pendingFolders);
 			else
-				folder->addChild(newFolder);
+				populateFolder(newFolder);
 		}
 	}
+
+	// helps with whatever is queued until our own subfolders are done, instead of blocking a scheduler thread
+	pendingFolders.wait();
+
+	for(auto it = newFolders.cbegin(); it != newFolders.cend(); ++it)
+	{
+		//ignore folders that do not contain games
+		if((*it)->getChildrenByFilename().size() == 0)
+			delete *it;
+		else
+			folder->addChild(*it);
+	}
 }
 
-void SystemData::indexAllGameFilters(const FileData* folder)
+void SystemData::indexFiltersOnIdle(Window* window)
 {
-	const std::vector<FileData*>& children = folder->getChildren();
+	if(isLoading() || (window->getTimeSinceLastInput() < IDLE_INDEX_DELAY))
+		return;
 
-	for(std::vector<FileData*>::const_iterator it = children.cbegin(); it != children.cend(); ++it)
+	// one system per frame at most, so input is never held up for long
+	for(auto it = sSystemVector.cbegin(); it != sSystemVector.cend(); it++)
 	{
-		switch((*it)->getType())
+		if(!(*it)->mFilterIndex->isBuilt())
 		{
-			case GAME:   { mFilterIndex->addToIndex(*it); } break;
-			case FOLDER: { indexAllGameFilters(*it);      } break;
-			default:
-				LOG(LogInfo) << "Unknown type: " << (*it)->getType();
-			     break;
+			TimelineScopeDetail("FileFilterIndex::build", (*it)->getName());
+			(*it)->mFilterIndex->build();
+			return;
 		}
 	}
 }
 
+FileData* SystemData::addGame(const std::string& path)
+{
+	bool contains = false;
+	const std::string relative = Utils::FileSystem::removeCommonPath(path, mRootFolder->getPath(), contains, true);
+	if(!contains || relative.empty())
+		return NULL;
+
+	// same rules as populateFolder
+	if(!sShowHiddenFiles.get() && Utils::FileSystem::isHidden(path))
+		return NULL;
+
+	const Utils::FileSystem::PathView fileName = Utils::FileSystem::getFileNameView(path);
+	if(!mEnvData->mFileMatcher.isGame(fileName.data(), fileName.size(), false) || mEnvData->mFileMatcher.isExcluded(fileName.data(), fileName.size(), false))
+		return NULL;
+
+	const std::string stem = Utils::FileSystem::getStem(path);
+	if((hasPlatformId(PlatformIds::ARCADE) || hasPlatformId(PlatformIds::NEOGEO)) && (MameNames::getInstance()->isBios(stem) || MameNames::getInstance()->isDevice(stem)))
+		return NULL;
+
+	const Utils::FileSystem::stringList pathList = Utils::FileSystem::getPathList(relative);
+
+	// the scan doesn't descend into excluded folders either
+	for(auto it = pathList.cbegin(); it != --pathList.cend(); ++it)
+	{
+		if(mEnvData->mFileMatcher.isExcluded(*it, true))
+			return NULL;
+	}
+	FileData* folder = mRootFolder;
+	std::string folderPath = mRootFolder->getPath();
+
+	for(auto it = pathList.cbegin(); it != --pathList.cend(); ++it)
+	{
+		folderPath += "/" + *it;
+
+		const std::unordered_map<std::string, FileData*>& children = folder->getChildrenByFilename();
+		auto child = children.find(*it);
+
+		if(child == children.cend())
+		{
+			FileData* newFolder = new (mFileDataPool) FileData(FOLDER, folderPath, mEnvData, this);
+			folder->addChild(newFolder);
+			folder = newFolder;
+		}
+		else if(child->second->getType() == FOLDER)
+			folder = child->second;
+		else
+			return NULL; // inside a directory that is a game itself
+	}
+
+	if(folder->getChildrenByFilename().find(pathList.back()) != folder->getChildrenByFilename().cend())
+		return NULL;
+
+	FileData* game = new (mFileDataPool) FileData(GAME, path, mEnvData, this);
+	folder->addChild(game);
+	folder->sort(getSortTypeFromString(mRootFolder->getSortDescription()));
+	mFilterIndex->addToIndex(game);
+	setShuffledCacheDirty();
+
+	return game;
+}
+
+FileData* SystemData::findFile(const std::string& path) const
+{
+	bool contains = false;
+	const std::string relative = Utils::FileSystem::removeCommonPath(path, mRootFolder->getPath(), contains, true);
+	if(!contains || relative.empty())
+		return NULL;
+
+	const Utils::FileSystem::stringList pathList = Utils::FileSystem::getPathList(relative);
+	FileData* file = mRootFolder;
+
+	for(auto it = pathList.cbegin(); it != pathList.cend(); ++it)
+	{
+		const std::unordered_map<std::string, FileData*>& children = file->getChildrenByFilename();
+		auto child = children.find(*it);
+
+		if(child == children.cend())
+			return NULL;
+
+		file = child->second;
+	}
+
+	return file;
+}
+
 std::vector<std::string> readList(const std::string& str, const char* delims = " \t\r\n,")
 {
 	std::vector<std::string> ret;
@@ -173,6 +379,50 @@ std::vector<std::string> readList(const std::string& str, const char* delims = "
 }
 
 
+// the ROM folder of a system in es_systems.cfg, with generic separators and ~ expanded
+static std::string readStartPath(pugi::xml_node system)
+{
+	//convert path to generic directory seperators
+	std::string path = Utils::FileSystem::getGenericPath(system.child("path").text().get());
+
+	//expand home symbol if the startpath contains ~
+	if (!path.empty() && path[0] == '~')
+	{
+		path.erase(0, 1);
+		path.insert(0, Utils::FileSystem::getHomePath());
+	}
+
+	return path;
+}
+
+// How long each system likely takes to load, by how many files the ROM scan cache saw in its folders last time
+static void estimateLoadCosts(const std::vector<pugi::xml_node>& systems, std::vector<size_t>& costs)
+{
+	size_t known = 0;
+	size_t knownCost = 0;
+
+	costs.clear();
+	for (auto it = systems.cbegin(); it != systems.cend(); it++)
+	{
+		const size_t cost = RomScanCache::getInstance()->getEntryCount(readStartPath(*it));
+		costs.push_back(cost);
+
+		if (cost > 0)
+		{
+			known++;
+			knownCost += cost;
+		}
+	}
+
+	// a system that wasn't scanned before is guessed to be an average one, nothing to go by counts them all the same
+	const size_t unknownCost = known ? (knownCost / known) : 1;
+	for (auto it = costs.begin(); it != costs.end(); it++)
+	{
+		if (*it == 0)
+			*it = unknownCost;
+	}
+}
+
 SystemData* SystemData::loadSystem(pugi::xml_node system)
 {
 	std::string name, fullname, path, cmd, themeFolder, defaultCore;
@@ -192,6 +442,10 @@ SystemData* SystemData::loadSystem(pugi::xml_node system)
 			extensions.push_back(xt);
 	}
 
+	// globs matched against the names of the entries, an excluded folder isn't scanned at all
+	const std::vector<std::string> include = readList(system.child("include").text().get(), " \t\r\n");
+	const std::vector<std::string> exclude = readList(system.child("exclude").text().get(), " \t\r\n");
+
 	cmd = system.child("command").text().get();
 
 	// platform id list
@@ -230,20 +484,13 @@ SystemData* SystemData::loadSystem(pugi::xml_node system)
 		return nullptr;
 	}
 
-	//convert path to generic directory seperators
-	path = Utils::FileSystem::getGenericPath(path);
-
-	//expand home symbol if the startpath contains ~
-	if (path[0] == '~')
-	{
-		path.erase(0, 1);
-		path.insert(0, Utils::FileSystem::getHomePath());
-	}
+	path = readStartPath(system);
 
 	//create the system runtime environment data
 	SystemEnvironmentData* envData = new SystemEnvironmentData;
 	envData->mStartPath = path;
 	envData->mSearchExtensions = extensions;
+	envData->mFileMatcher = FileMatcher(extensions, include, exclude);
 	envData->mLaunchCommand = cmd;
 	envData->mPlatformIds = platformIds;
 
@@ -260,10 +507,19 @@ SystemData* SystemData::loadSystem(pugi::xml_node system)
 }
 
 //creates systems from information located in a config file
-bool SystemData::loadConfig(Window* window)
+bool SystemData::loadConfig(Window* window, bool progressive)
 {
+	TimelineScope("SystemData::loadConfig");
+
 	deleteSystems();
 
+	const bool threaded = (std::thread::hardware_concurrency() > 2) && Settings::getInstance()->getBool("ThreadedLoading");
+
+	// the arcade names are read beside es_systems.cfg, instead of by the first arcade game while the others wait for it
+	TaskScheduler::Group names;
+	if (threaded)
+		TaskScheduler::getInstance()->queue([] { MameNames::init(); }, TaskScheduler::PRIORITY_HIGH, &names);
+
 	std::string path = getConfigPath(false);
 
 	LOG(LogInfo) << "Loading system config file " << path << "...";
@@ -275,7 +531,8 @@ bool SystemData::loadConfig(Window* window)
 		return false;
 	}
 
-	pugi::xml_document doc;
+	std::unique_ptr<SystemLoad> load(new SystemLoad());
+	pugi::xml_document& doc = load->doc;
 	pugi::xml_parse_result res = doc.load_file(path.c_str());
 
 	if(!res)
@@ -294,100 +551,221 @@ bool SystemData::loadConfig(Window* window)
 		return false;
 	}
 
-	std::vector<std::string> systemsNames;
-
 	int systemCount = 0;
 	for (pugi::xml_node system = systemList.child("system"); system; system = system.next_sibling("system"))
 	{
-		systemsNames.push_back(system.child("fullname").text().get());
+		load->names.push_back(system.child("name").text().get());
+		load->fullNames.push_back(system.child("fullname").text().get());
 		systemCount++;
 	}
 
-	int currentSystem = 0;
-
-	typedef SystemData* SystemDataPtr;
-
-	ThreadPool* pThreadPool = NULL;
-	SystemDataPtr* systems = NULL;
-
-	if (std::thread::hardware_concurrency() > 2 && Settings::getInstance()->getBool("ThreadedLoading"))
+	if (!threaded)
 	{
-		pThreadPool = new ThreadPool();
-
-		systems = new SystemDataPtr[systemCount];
-		for (int i = 0; i < systemCount; i++)
-			systems[i] = nullptr;
-
-		pThreadPool->queueWorkItem([] { CollectionSystemManager::get()->loadCollectionSystems(true); });
-	}
+		int currentSystem = 0;
 
-	int processedSystem = 0;
-
-	for (pugi::xml_node system = systemList.child("system"); system; system = system.next_sibling("system"))
-	{
-		if (pThreadPool != NULL)
-		{
-			pThreadPool->queueWorkItem([system, currentSystem, systems, &processedSystem]
-			{
-				systems[currentSystem] = loadSystem(system);
-				processedSystem++;
-			});
-		}
-		else
+		for (pugi::xml_node system = systemList.child("system"); system; system = system.next_sibling("system"))
 		{
 			std::string fullname = system.child("fullname").text().get();
 
 			if (window != NULL)
 				window->renderLoadingScreen(fullname, systemCount == 0 ? 0 : (float)currentSystem / (float)(systemCount + 1));
 
-			std::string nm = system.child("name").text().get();
-
 			SystemData* pSystem = loadSystem(system);
 			if (pSystem != nullptr)
 				sSystemVector.push_back(pSystem);
+
+			currentSystem++;
 		}
 
-		currentSystem++;
+		if (window != NULL)
+			window->renderLoadingScreen("Favorites", systemCount == 0 ? 0 : currentSystem / systemCount);
+
+		CollectionSystemManager::get()->loadCollectionSystems();
+
+		onLoaded();
+		return true;
 	}
 
-	if (pThreadPool != NULL)
+	TaskScheduler* scheduler = TaskScheduler::getInstance();
+	SystemLoad* pLoad = load.get();
+
+	sLoadScheduler = scheduler;
+	pLoad->systems.resize(systemCount, nullptr);
+	pLoad->handedOver.resize(systemCount, false);
+
+	scheduler->queue([] { CollectionSystemManager::get()->loadCollectionSystems(true); }, TaskScheduler::PRIORITY_NORMAL, &pLoad->group);
+
+	std::vector<pugi::xml_node> nodes;
+	for (pugi::xml_node system = systemList.child("system"); system; system = system.next_sibling("system"))
+		nodes.push_back(system);
+
+	estimateLoadCosts(nodes, pLoad->costs);
+	for (auto it = pLoad->costs.cbegin(); it != pLoad->costs.cend(); it++)
+		pLoad->totalCost += *it;
+
+	// the largest systems first, a big one started last would keep loading while every other thread is idle
+	std::vector<int> order;
+	for (int i = 0; i < systemCount; i++)
+		order.push_back(i);
+	std::stable_sort(order.begin(), order.end(), [pLoad](int a, int b) { return pLoad->costs[a] > pLoad->costs[b]; });
+
+	for (auto it = order.cbegin(); it != order.cend(); it++)
 	{
-		if (window != NULL)
+		const int index = *it;
+		const pugi::xml_node system = nodes[index];
+
+		scheduler->queue([pLoad, system, index]
 		{
-			pThreadPool->wait([window, &processedSystem, systemCount, &systemsNames]
+			SystemData* pSystem = loadSystem(system);
 			{
-				int px = processedSystem - 1;
-				if (px >= 0 && px < systemsNames.size())
-					window->renderLoadingScreen(systemsNames.at(px), (float)px / (float)(systemCount + 1));
-			}, 10);
-		}
-		else
-			pThreadPool->wait();
+				std::unique_lock<std::mutex> lock(pLoad->mutex);
+				pLoad->systems[index] = pSystem;
+				pLoad->finished.push_back(index);
+			}
+
+			pLoad->loadedCost += pLoad->costs[index];
+			pLoad->lastLoaded = index;
+		}, TaskScheduler::PRIORITY_NORMAL, &pLoad->group);
+	}
 
-		for (int i = 0; i < systemCount; i++)
+	sLoad = std::move(load);
+
+	// the bar moves by how much of the library is loaded, one large system is most of it
+	auto renderProgress = [window, pLoad, systemCount]
+	{
+		const int last = pLoad->lastLoaded;
+		if (window != NULL && last >= 0)
+			window->renderLoadingScreen(pLoad->fullNames.at(last), ((float)pLoad->loadedCost / (float)pLoad->totalCost) * ((float)systemCount / (float)(systemCount + 1)));
+	};
+
+	if (progressive)
+	{
+		// the carousel is shown once the system it starts on is there, the others are handed over as they're done
+		std::string startupSystem = Settings::getInstance()->getString("StartupSystem");
+		if (startupSystem == "retropie")
+			startupSystem = "";
+
+		while (!pLoad->group.isDone() && !pLoad->isLoaded(startupSystem))
 		{
-			SystemData* pSystem = systems[i];
-			if (pSystem != nullptr)
-				sSystemVector.push_back(pSystem);
+			renderProgress();
+			std::this_thread::sleep_for(std::chrono::milliseconds(10));
 		}
+	}
+	else if (window != NULL)
+		pLoad->group.wait(renderProgress, 10);
+	else
+		pLoad->group.wait();
+
+	updateLoading(window);
+	return true;
+}
+
+bool SystemData::isLoading()
+{
+	return sLoad != nullptr;
+}
+
+bool SystemData::updateLoading(Window* window)
+{
+	if (!sLoad)
+		return false;
+
+	// looked at first, so every system is in finished once it's true
+	const bool done = sLoad->group.isDone();
 
-		delete[] systems;
-		delete pThreadPool;
+	std::vector<int> finished;
+	{
+		std::unique_lock<std::mutex> lock(sLoad->mutex);
+		finished.swap(sLoad->finished);
+	}
+
+	bool changed = false;
+
+	for (auto it = finished.cbegin(); it != finished.cend(); it++)
+	{
+		const int index = *it;
+		SystemData* pSystem = sLoad->systems[index];
+		if (pSystem == nullptr)
+			continue;
+
+		// in es_systems.cfg order, between the ones handed over before it
+		const int position = (int)std::count(sLoad->handedOver.cbegin(), sLoad->handedOver.cbegin() + index, true);
+		sSystemVector.insert(sSystemVector.cbegin() + position, pSystem);
+		sLoad->handedOver[index] = true;
+		changed = true;
+	}
+
+	if (done)
+	{
+		sLoadScheduler = NULL;
+		sLoad.reset();
 
 		if (window != NULL)
-			window->renderLoadingScreen("Favorites", systemCount == 0 ? 0 : currentSystem / systemCount);
+			window->renderLoadingScreen("Favorites", 1.0f);
 
+		// the collections were loaded beside the systems, they're filled once all of them are there
 		CollectionSystemManager::get()->updateSystemsList();
+
+		onLoaded();
+		changed = true;
 	}
-	else
+
+	return changed;
+}
+
+void SystemData::cancelLoading()
+{
+	if (!sLoad)
+		return;
+
+	sLoad->group.wait();
+
+	// the systems that were handed over are deleted with the others
+	for (size_t i = 0; i < sLoad->systems.size(); i++)
 	{
-		if (window != NULL)
-			window->renderLoadingScreen("Favorites", systemCount == 0 ? 0 : currentSystem / systemCount);
+		if (!sLoad->handedOver[i])
+			delete sLoad->systems[i];
+	}
 
-		CollectionSystemManager::get()->loadCollectionSystems();
+	sLoadScheduler = NULL;
+	sLoad.reset();
+	sLoadedCallbacks.clear();
+}
+
+void SystemData::whenLoaded(const std::function<void()>& func)
+{
+	if (sLoad)
+		sLoadedCallbacks.push_back(func);
+	else
+		func();
+}
+
+void SystemData::onLoaded()
+{
+	RomScanCache::getInstance()->save();
+
+	// every system has its theme now
+	ThemeData::clearCache();
+
+	// only loading gamelists looks up every file by name, the folders changed later on build their maps again
+	if (Settings::getInstance()->getBool("LowMemory"))
+	{
+		for (auto it = sSystemVector.cbegin(); it != sSystemVector.cend(); it++)
+		{
+			if (!(*it)->isCollection())
+				(*it)->getRootFolder()->releaseChildrenByFilename();
+		}
 	}
 
-	return true;
+	size_t existsHits;
+	size_t existsMisses;
+	Utils::FileSystem::getExistsStats(existsHits, existsMisses);
+	LOG(LogInfo) << "Path exists index: " << existsHits << " hits, " << existsMisses << " misses";
+
+	std::vector<std::function<void()>> callbacks;
+	callbacks.swap(sLoadedCallbacks);
+	for (auto it = callbacks.cbegin(); it != callbacks.cend(); it++)
+		(*it)();
 }
 
 void SystemData::writeExampleConfig(const std::string& path)
@@ -438,6 +816,12 @@ void SystemData::writeExampleConfig(const std::string& path)
 
 void SystemData::deleteSystems()
 {
+	cancelLoading();
+
+	// all at once rather than one by one as each system is deleted below, the destructors find nothing left to save
+	if(Settings::getInstance()->getString("SaveGamelistsMode") == "on exit")
+		updateGamelists(sSystemVector);
+
 	for(unsigned int i = 0; i < sSystemVector.size(); i++)
 	{
 		delete sSystemVector.at(i);
@@ -445,8 +829,16 @@ void SystemData::deleteSystems()
 	sSystemVector.clear();
 }
 
+void SystemData::setConfigPath(const std::string& path)
+{
+	sConfigPath = path;
+}
+
 std::string SystemData::getConfigPath(bool forWrite)
 {
+	if(!sConfigPath.empty())
+		return sConfigPath;
+
 	std::string path = Utils::FileSystem::getHomePath() + "/.emulationstation/es_systems.cfg";
 	if(forWrite || Utils::FileSystem::exists(path))
 		return path;
@@ -456,9 +848,11 @@ std::string SystemData::getConfigPath(bool forWrite)
 
 bool SystemData::isVisible()
 {
+   // a collection that isn't populated yet shows no games, the carousel isn't made again once it is
    return (getDisplayedGameCount() > 0 ||
            (UIModeController::getInstance()->isUIModeFull() && mIsCollectionSystem) ||
-           (mIsCollectionSystem && mName == "favorites"));
+           (mIsCollectionSystem && mName == "favorites") ||
+           (mIsCollectionSystem && CollectionSystemManager::get()->needsPopulating(this)));
 }
 
 SystemData* SystemData::getNext() const
@@ -506,6 +900,16 @@ std::string SystemData::getGamelistPath(bool forWrite) const
 	return "/etc/emulationstation/gamelists/" + mName + "/gamelist.xml";
 }
 
+std::string SystemData::getGamelistJournalPath() const
+{
+	// the journal always sits next to the gamelist.xml it will be compacted into
+	std::string filePath = mRootFolder->getPath() + "/gamelist.xml";
+	if(!Utils::FileSystem::exists(filePath))
+		filePath = Utils::FileSystem::getHomePath() + "/.emulationstation/gamelists/" + mName + "/gamelist.xml";
+
+	return filePath + ".journal";
+}
+
 std::string SystemData::getThemePath() const
 {
 	// where we check for themes, in order:
@@ -537,7 +941,7 @@ bool SystemData::hasGamelist() const
 
 unsigned int SystemData::getGameCount() const
 {
-	return (unsigned int)mRootFolder->getFilesRecursive(GAME).size();
+	return mRootFolder->getGameCount();
 }
 
 SystemData* SystemData::getRandomSystem()
@@ -559,50 +963,122 @@ SystemData* SystemData::getRandomSystem()
 
 void SystemData::setShuffledCacheDirty()
 {
-	mGamesShuffled.clear();
+	mGamesShuffledValid = false;
 }
 
 FileData* SystemData::getRandomGame()
 {
-	if (mGamesShuffled.empty())
+	if (!mGamesShuffledValid || (mGamesShuffledGeneration != mRootFolder->getTreeGeneration()) || (mGamesShuffledNext >= mGamesShuffled.size()))
 	{
-		mGamesShuffled = mRootFolder->getFilesRecursive(GAME, true);
-		if (mGamesShuffled.empty()) return NULL;
+		// keeps its capacity, so the games are only collected again without growing the array
+		mGamesShuffled.clear();
+		mRootFolder->forEachFile(GAME, true, [this](FileData* game) { mGamesShuffled.push_back(game); });
 		std::shuffle(mGamesShuffled.begin(), mGamesShuffled.end(), sURNG);
+		mGamesShuffledNext = 0;
+		mGamesShuffledGeneration = mRootFolder->getTreeGeneration();
+		mGamesShuffledValid = true;
+	}
+
+	if (mGamesShuffled.empty())
+		return NULL;
+
+	return mGamesShuffled[mGamesShuffledNext++];
+}
+
+const std::vector<FileData*>& SystemData::getDisplayedGames()
+{
+	// the filters only matter while there are any
+	const bool filtered = mFilterIndex->isFiltered();
+	if (!mDisplayedGamesValid || (mDisplayedGamesGeneration != mRootFolder->getTreeGeneration()) || (mDisplayedGamesFiltered != filtered) ||
+		(filtered && (mDisplayedGamesFilterGeneration != FileFilterIndex::getGeneration())))
+	{
+		mDisplayedGames.clear();
+		mRootFolder->forEachFile(GAME, true, [this](FileData* game) { mDisplayedGames.push_back(game); });
+		mDisplayedGamesGeneration = mRootFolder->getTreeGeneration();
+		mDisplayedGamesFilterGeneration = FileFilterIndex::getGeneration();
+		mDisplayedGamesFiltered = filtered;
+		mDisplayedGamesValid = true;
+	}
+
+	return mDisplayedGames;
+}
+
+FileData* SystemData::getRandomDisplayedGame()
+{
+	const std::vector<FileData*>& games = getDisplayedGames();
+	if (games.empty())
+		return NULL;
+
+	return games[std::uniform_int_distribution<size_t>(0, games.size() - 1)(sURNG)];
+}
+
+FileData* SystemData::getRandomDisplayedGameOfAll()
+{
+	// a system is picked as often as it has games, then any of its games
+	size_t total = 0;
+	for (auto it = sSystemVector.cbegin(); it != sSystemVector.cend(); it++)
+	{
+		if ((*it)->isGameSystem() && !(*it)->isCollection())
+			total += (*it)->getDisplayedGames().size();
 	}
-	FileData* random_game = mGamesShuffled.back();
-	mGamesShuffled.pop_back();
-	return random_game;
+
+	if (total == 0)
+		return NULL;
+
+	size_t pick = std::uniform_int_distribution<size_t>(0, total - 1)(sURNG);
+	for (auto it = sSystemVector.cbegin(); it != sSystemVector.cend(); it++)
+	{
+		if (!(*it)->isGameSystem() || (*it)->isCollection())
+			continue;
+
+		const std::vector<FileData*>& games = (*it)->getDisplayedGames();
+		if (pick < games.size())
+			return games[pick];
+
+		pick -= games.size();
+	}
+
+	return NULL;
 }
 
 unsigned int SystemData::getDisplayedGameCount() const
 {
-	return (unsigned int)mRootFolder->getFilesRecursive(GAME, true).size();
+	return mRootFolder->getGameCount(true);
 }
 
 void SystemData::loadTheme()
 {
-	mTheme = std::make_shared<ThemeData>();
+	mTheme = prepareTheme(getThemePath(), getThemeVariables());
+}
+
+std::map<std::string, std::string> SystemData::getThemeVariables() const
+{
+	// build map with system variables for theme to use,
+	std::map<std::string, std::string> sysData;
+	sysData.insert(std::pair<std::string, std::string>("system.name", getName()));
+	sysData.insert(std::pair<std::string, std::string>("system.theme", getThemeFolder()));
+	sysData.insert(std::pair<std::string, std::string>("system.fullName", getFullName()));
 
-	std::string path = getThemePath();
+	return sysData;
+}
+
+std::shared_ptr<ThemeData> SystemData::prepareTheme(const std::string& path, const std::map<std::string, std::string>& variables)
+{
+	std::shared_ptr<ThemeData> theme = std::make_shared<ThemeData>();
 
 	if(!Utils::FileSystem::exists(path)) // no theme available for this platform
-		return;
+		return theme;
 
 	try
 	{
-		// build map with system variables for theme to use,
-		std::map<std::string, std::string> sysData;
-		sysData.insert(std::pair<std::string, std::string>("system.name", getName()));
-		sysData.insert(std::pair<std::string, std::string>("system.theme", getThemeFolder()));
-		sysData.insert(std::pair<std::string, std::string>("system.fullName", getFullName()));
-
-		mTheme->loadFile(sysData, path);
+		theme->loadFile(variables, path);
 	} catch(ThemeException& e)
 	{
 		LOG(LogError) << e.what();
-		mTheme = std::make_shared<ThemeData>(); // reset to empty
+		theme = std::make_shared<ThemeData>(); // reset to empty
 	}
+
+	return theme;
 }
 
 void SystemData::writeMetaData() {
@@ -613,6 +1089,31 @@ void SystemData::writeMetaData() {
 	updateGamelist(this);
 }
 
+void SystemData::reloadGamelist()
+{
+	if(Settings::getInstance()->getBool("IgnoreGamelist") || mIsCollectionSystem)
+		return;
+
+	// the journal on disk is read back over what's in memory, so it has to have everything first
+	writeMetaData();
+	GamelistWriter::getInstance()->flush();
+
+	// the snapshot may be taken again, the descriptions left in it move
+	forgetGamelistDescriptions(this);
+	parseGamelist(this);
+
+	mRootFolder->sort(FileSorts::SortTypes.at(0));
+	mDisplayedGamesValid = false;
+	mGamesShuffledValid = false;
+
+	// indexed again once it's needed, like after loading
+	mFilterIndex->resetIndex();
+	mFilterIndex->setPendingRoot(mRootFolder);
+
+	// the collections follow the metadata, favorites and last played most of all
+	mRootFolder->forEachFile(GAME, false, [](FileData* game) { CollectionSystemManager::get()->refreshCollectionSystems(game); });
+}
+
 void SystemData::onMetaDataSavePoint() {
 	if(Settings::getInstance()->getString("SaveGamelistsMode") != "always")
 		return;
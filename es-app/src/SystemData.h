@@ -2,8 +2,11 @@
 #ifndef ES_APP_SYSTEM_DATA_H
 #define ES_APP_SYSTEM_DATA_H
 
+#include "FileMatcher.h"
 #include "PlatformId.h"
 #include <algorithm>
+#include <functional>
+#include <map>
 #include <memory>
 #include <random>
 #include <string>
@@ -11,7 +14,10 @@
 
 #include <pugixml.hpp>
 
+namespace Utils { class TaskScheduler; }
+
 class FileData;
+class FileDataPool;
 class FileFilterIndex;
 class ThemeData;
 class Window;
@@ -20,6 +26,7 @@ struct SystemEnvironmentData
 {
 	std::string mStartPath;
 	std::vector<std::string> mSearchExtensions;
+	FileMatcher mFileMatcher; // built from mSearchExtensions and the include and exclude globs
 	std::string mLaunchCommand;
 	std::vector<PlatformIds::PlatformId> mPlatformIds;
 };
@@ -31,10 +38,12 @@ public:
 	~SystemData();
 
 	inline FileData* getRootFolder() const { return mRootFolder; };
+	inline FileDataPool* getFileDataPool() const { return mFileDataPool; };
 	inline const std::string& getName() const { return mName; }
 	inline const std::string& getFullName() const { return mFullName; }
 	inline const std::string& getStartPath() const { return mEnvData->mStartPath; }
 	inline const std::vector<std::string>& getExtensions() const { return mEnvData->mSearchExtensions; }
+	inline const FileMatcher& getFileMatcher() const { return mEnvData->mFileMatcher; }
 	inline const std::string& getThemeFolder() const { return mThemeFolder; }
 	inline SystemEnvironmentData* getSystemEnvData() const { return mEnvData; }
 	inline const std::vector<PlatformIds::PlatformId>& getPlatformIds() const { return mEnvData->mPlatformIds; }
@@ -43,6 +52,7 @@ public:
 	inline const std::shared_ptr<ThemeData>& getTheme() const { return mTheme; }
 
 	std::string getGamelistPath(bool forWrite) const;
+	std::string getGamelistJournalPath() const;
 	bool hasGamelist() const;
 	std::string getThemePath() const;
 
@@ -50,9 +60,18 @@ public:
 	unsigned int getDisplayedGameCount() const;
 
 	static void deleteSystems();
-	static bool loadConfig(Window* window); //Load the system config file at getConfigPath(). Returns true if no errors were encountered. An example will be written if the file doesn't exist.
+	static bool loadConfig(Window* window, bool progressive = false); //Load the system config file at getConfigPath(). Returns true if no errors were encountered. An example will be written if the file doesn't exist.
+
+	// A progressive threaded load returns from loadConfig once the startup system or any system is loaded, the others are
+	// added to sSystemVector by updateLoading on the main thread as they're done and the collections once all of them are.
+	static bool isLoading();
+	static bool updateLoading(Window* window); // true if sSystemVector changed
+	static void cancelLoading(); // waits for the systems still loading and drops them
+	// Runs func once every system is loaded, right away if they are
+	static void whenLoaded(const std::function<void()>& func);
 	static void writeExampleConfig(const std::string& path);
 	static std::string getConfigPath(bool forWrite); // if forWrite, will only return ~/.emulationstation/es_systems.cfg, never /etc/emulationstation/es_systems.cfg
+	static void setConfigPath(const std::string& path); // loads path instead of the usual systems configuration, "" goes back to it
 
 	static std::vector<SystemData*> sSystemVector;
 	static std::vector<SystemData*> sSystemVectorShuffled;
@@ -70,16 +89,48 @@ public:
 
 	static SystemData* getRandomSystem();
 	FileData* getRandomGame();
+	// The displayed games, collected again only after games were added or removed or the filters changed
+	const std::vector<FileData*>& getDisplayedGames();
+	// Any displayed game, they may repeat. Neither collects nor shuffles the games while they stay the same
+	FileData* getRandomDisplayedGame();
+	// Same across the game systems, collections left out, every game as likely as the others
+	static FileData* getRandomDisplayedGameOfAll();
 
 	// Load or re-load theme.
 	void loadTheme();
+	// loadTheme() split up, so the theme can be prepared on another thread from what was taken on the main thread
+	std::map<std::string, std::string> getThemeVariables() const;
+	static std::shared_ptr<ThemeData> prepareTheme(const std::string& path, const std::map<std::string, std::string>& variables);
+	inline void setTheme(const std::shared_ptr<ThemeData>& theme) { mTheme = theme; }
 
 	FileFilterIndex* getIndex() { return mFilterIndex; };
+	// builds the filter index of a system that doesn't have one yet once the UI sits idle, called every frame
+	static void indexFiltersOnIdle(Window* window);
+
+	// the scheduler systems are loaded on, NULL when they aren't being loaded or loading isn't threaded
+	static Utils::TaskScheduler* getLoadScheduler() { return sLoadScheduler; }
+
+	// Adds a game that showed up after loading, with the folders leading up to it. Returns NULL if it isn't a game of this system or is already known.
+	FileData* addGame(const std::string& path);
+	// Returns the game or folder at path, or NULL if there's none.
+	FileData* findFile(const std::string& path) const;
+	// Applies gamelist.xml and its journal again, for when they were edited outside of ES. What was changed and not
+	// saved yet is written first. Games no gamelist entry is left for keep their metadata
+	void reloadGamelist();
+
 	void onMetaDataSavePoint();
 	void setShuffledCacheDirty();
 
 private:
 	static SystemData* loadSystem(pugi::xml_node system);
+	static void onLoaded();
+
+	// set by loadConfig when loading is threaded, so populateFolder can spread large systems across threads
+	static Utils::TaskScheduler* sLoadScheduler;
+
+	static std::string sConfigPath;
+
+	static const unsigned int IDLE_INDEX_DELAY = 3000; // millis
 
 	bool mIsCollectionSystem;
 	bool mIsGameSystem;
@@ -90,15 +141,25 @@ private:
 	std::shared_ptr<ThemeData> mTheme;
 
 	void populateFolder(FileData* folder);
-	void indexAllGameFilters(const FileData* folder);
 	void setIsGameSystemStatus();
 	void writeMetaData();
 
 	FileFilterIndex* mFilterIndex;
+	FileDataPool* mFileDataPool;
 
 	FileData* mRootFolder;
-	// for getRandomGame()
+	// for getRandomGame(), the displayed games in a random order, shuffled again once they were all handed out or the
+	// games of the system changed
 	std::vector<FileData*> mGamesShuffled;
+	size_t mGamesShuffledNext;
+	unsigned int mGamesShuffledGeneration;
+	bool mGamesShuffledValid;
+	// for getDisplayedGames()
+	std::vector<FileData*> mDisplayedGames;
+	unsigned int mDisplayedGamesGeneration;
+	unsigned int mDisplayedGamesFilterGeneration;
+	bool mDisplayedGamesFiltered;
+	bool mDisplayedGamesValid;
 };
 
 #endif // ES_APP_SYSTEM_DATA_H
@@ -1,10 +1,8 @@
 #include "SystemScreenSaver.h"
 #include "components/TextListComponent.h"
 
-#ifdef _OMX_
-#include "components/VideoPlayerComponent.h"
-#endif
-#include "components/VideoVlcComponent.h"
+#include "components/VideoComponent.h"
+#include "resources/TextureResource.h"
 #include "CollectionSystemManager.h"
 #include "utils/FileSystemUtil.h"
 #include "views/gamelist/IGameListView.h"
@@ -12,11 +10,14 @@
 #include "views/ViewController.h"
 #include "FileData.h"
 #include "FileFilterIndex.h"
+#include "FrameScheduler.h"
 #include "Log.h"
+#include "MediaIndex.h"
 #include "PowerSaver.h"
 #include "Scripting.h"
 #include "Sound.h"
 #include "SystemData.h"
+#include "VideoBackend.h"
 #include <algorithm>
 #include <chrono>
 #include <random>
@@ -24,20 +25,26 @@
 #include <unordered_map>
 
 #define FADE_TIME 			300
+// slideshow images that are picked and loaded ahead
+#define UPCOMING_IMAGES			2
 
 static int lastIndex = 0;
 
 SystemScreenSaver::SystemScreenSaver(Window* window) :
 	mVideoScreensaver(NULL),
 	mImageScreensaver(NULL),
+	mFadingImage(NULL),
+	mCrossfade(1.0f),
 	mWindow(window),
 	mState(STATE_INACTIVE),
 	mOpacity(0.0f),
 	mTimer(0),
 	mCurrentGame(NULL),
 	mPreviousGame(NULL),
+	mNextGame(NULL),
 	mStopBackgroundAudio(true),
-	mSystem(NULL)
+	mSystem(NULL),
+	mDisplayOff(false)
 {
 	remove(getTitlePath().c_str());
 	mWindow->setScreenSaver(this);
@@ -54,6 +61,7 @@ SystemScreenSaver::~SystemScreenSaver()
 	mCurrentGame = NULL;
 	delete mVideoScreensaver;
 	delete mImageScreensaver;
+	delete mFadingImage;
 }
 
 bool SystemScreenSaver::allowSleep()
@@ -67,6 +75,15 @@ bool SystemScreenSaver::isScreenSaverActive()
 	return (mState != STATE_INACTIVE);
 }
 
+Window::ScreenSaver::Cover SystemScreenSaver::getCover()
+{
+	if (mState == STATE_INACTIVE)
+		return COVER_NONE;
+
+	// media is shown on black, as is everything renderScreenSaver() has nothing else for
+	return (Settings::getInstance()->getString("ScreenSaverBehavior") == "dim") && !mVideoScreensaver && !mImageScreensaver ? COVER_DIM : COVER_FULL;
+}
+
 bool SystemScreenSaver::inputDuringScreensaver(InputConfig* config, Input input)
 {
 	bool input_consumed = false;
@@ -118,15 +135,8 @@ bool SystemScreenSaver::inputDuringScreensaver(InputConfig* config, Input input)
 
 void SystemScreenSaver::setVideoScreensaver(std::string& path)
 {
-#ifdef _OMX_
 	// Create the correct type of video component
-	if (Settings::getInstance()->getBool("ScreenSaverOmxPlayer"))
-		mVideoScreensaver = new VideoPlayerComponent(mWindow, getTitlePath());
-	else
-		mVideoScreensaver = new VideoVlcComponent(mWindow, getTitlePath());
-#else
-	mVideoScreensaver = new VideoVlcComponent(mWindow, getTitlePath());
-#endif
+	mVideoScreensaver = VideoBackend::create(mWindow, getTitlePath(), true);
 
 	mVideoScreensaver->topWindow(true);
 	mVideoScreensaver->setOrigin(0.5f, 0.5f);
@@ -147,16 +157,68 @@ void SystemScreenSaver::setVideoScreensaver(std::string& path)
 	handleScreenSaverEditingCollection();
 	PowerSaver::runningScreenSaver(true);
 	mTimer = 0;
+
+	if (Settings::getInstance()->getString("ScreenSaverBehavior") == "random video")
+		prefetchNextVideo();
+}
+
+void SystemScreenSaver::prefetchNextVideo()
+{
+	mNextGame = NULL;
+
+	// a few tries for a game with its video really there, the game itself isn't shown twice in a row
+	for (int retry = 0; (retry < 20) && !mNextGame; ++retry)
+	{
+		FileData* game = pickGameListNode("video");
+		if (!game)
+			return;
+
+		if ((game != mCurrentGame) && MediaIndex::getInstance()->exists(game->getVideoPath()))
+			mNextGame = game;
+	}
+
+	if (mNextGame)
+		mVideoScreensaver->prefetch(mNextGame->getVideoPath());
+}
+
+bool SystemScreenSaver::swapVideo()
+{
+	std::string path = "";
+	prepareScreenSaverMedia("video", path);
+
+	if (path.empty() || !MediaIndex::getInstance()->exists(path))
+		return false;
+
+	// the component keeps showing the last frame until the next video has one
+	mVideoScreensaver->setVideo(path);
+	mTimer = 0;
+
+	Scripting::queueEvent("screensaver-game-select", mCurrentGame->getSystem()->getName(), mCurrentGame->getPath(), mCurrentGame->getName(), "randomvideo");
+
+	prefetchNextVideo();
+	return true;
 }
 
 void SystemScreenSaver::setImageScreensaver(std::string& path)
+{
+		loadImageScreensaver(path);
+
+		handleScreenSaverEditingCollection();
+		PowerSaver::runningScreenSaver(true);
+		mTimer = 0;
+
+		prefetchUpcomingImages();
+}
+
+void SystemScreenSaver::loadImageScreensaver(std::string& path)
 {
 		if (!mImageScreensaver)
 		{
-			mImageScreensaver = new ImageComponent(mWindow, false, false);
+			// images are loaded by the texture loader, the upcoming ones are usually done before they're shown
+			mImageScreensaver = new ImageComponent(mWindow);
+			mImageScreensaver->setAsyncLoad(true);
 		}
 
-		mImageScreensaver->setImage(path);
 		mImageScreensaver->setOrigin(0.5f, 0.5f);
 		mImageScreensaver->setPosition(Renderer::getScreenWidth() / 2.0f, Renderer::getScreenHeight() / 2.0f);
 
@@ -169,9 +231,81 @@ void SystemScreenSaver::setImageScreensaver(std::string& path)
 			mImageScreensaver->setMaxSize((float)Renderer::getScreenWidth(), (float)Renderer::getScreenHeight());
 		}
 
-		handleScreenSaverEditingCollection();
-		PowerSaver::runningScreenSaver(true);
-		mTimer = 0;
+		mImageScreensaver->setImage(path);
+}
+
+void SystemScreenSaver::prefetchUpcomingImages()
+{
+	const bool customMedia = Settings::getInstance()->getBool("SlideshowScreenSaverCustomMediaSource");
+
+	while (mUpcomingImages.size() < UPCOMING_IMAGES)
+	{
+		UpcomingImage upcoming;
+		upcoming.game = NULL;
+
+		if (customMedia)
+			pickRandomCustomMedia(upcoming.path);
+		else if ((upcoming.game = pickGameListNode("image")) != NULL)
+			upcoming.path = upcoming.game->getImagePath();
+
+		if (upcoming.path.empty())
+			return;
+
+		// videos are only opened once it's their turn
+		if (!isFileVideo(upcoming.path))
+			upcoming.texture = mImageScreensaver->prefetch(upcoming.path);
+
+		mUpcomingImages.push_back(upcoming);
+	}
+}
+
+bool SystemScreenSaver::takeUpcomingImage(std::string& path)
+{
+	if (mUpcomingImages.empty())
+		return false;
+
+	const UpcomingImage upcoming = mUpcomingImages.front();
+	mUpcomingImages.pop_front();
+
+	if (!Settings::getInstance()->getBool("SlideshowScreenSaverCustomMediaSource"))
+	{
+		if (!upcoming.game)
+			return false;
+
+		mCurrentGame = upcoming.game;
+		prepareScreenSaverMedia("image", path);
+	}
+	else
+		path = upcoming.path;
+
+	return !path.empty();
+}
+
+bool SystemScreenSaver::swapImage()
+{
+	if (!mImageScreensaver || mVideoScreensaver || mUpcomingImages.empty() || isFileVideo(mUpcomingImages.front().path))
+		return false;
+
+	std::string path = "";
+	if (!takeUpcomingImage(path))
+		return false;
+
+	// the current image fades out while the next one fades in over it
+	delete mFadingImage;
+	mFadingImage = mImageScreensaver;
+	mImageScreensaver = NULL;
+	mCrossfade = 0.0f;
+
+	loadImageScreensaver(path);
+	mTimer = 0;
+	prefetchUpcomingImages();
+	FrameScheduler::requestFrame(0);
+
+	if (mCurrentGame != NULL)
+	{
+		Scripting::queueEvent("screensaver-game-select", mCurrentGame->getSystem()->getName(), mCurrentGame->getFileName(), mCurrentGame->getName(), "slideshow");
+	}
+	return true;
 }
 
 bool SystemScreenSaver::isFileVideo(std::string& path)
@@ -215,6 +349,7 @@ void SystemScreenSaver::startScreenSaver(SystemData* system)
 	// if set to index files in background, start thread
 	if (Settings::getInstance()->getBool("BackgroundIndexing"))
 	{
+		collectIndexedMedia();
 		mExit = false;
 		mThread = new std::thread(&SystemScreenSaver::backgroundIndexing, this);
 	}
@@ -234,18 +369,18 @@ void SystemScreenSaver::startScreenSaver(SystemData* system)
 		pickRandomVideo(path, mCurrentGame != NULL);
 
 		int retry = 200;
-		while(retry > 0 && ((path.empty() || !Utils::FileSystem::exists(path)) || mCurrentGame == NULL))
+		while(retry > 0 && ((path.empty() || !MediaIndex::getInstance()->exists(path)) || mCurrentGame == NULL))
 		{
 			retry--;
 			pickRandomVideo(path);
 		}
 
-		if (!path.empty() && Utils::FileSystem::exists(path))
+		if (!path.empty() && MediaIndex::getInstance()->exists(path))
 		{
 			setVideoScreensaver(path);
 			if (mCurrentGame != NULL)
 			{
-				Scripting::fireEvent("screensaver-game-select", mCurrentGame->getSystem()->getName(), mCurrentGame->getPath(), mCurrentGame->getName(), "randomvideo");
+				Scripting::queueEvent("screensaver-game-select", mCurrentGame->getSystem()->getName(), mCurrentGame->getPath(), mCurrentGame->getName(), "randomvideo");
 			}
 			return;
 		}
@@ -259,15 +394,16 @@ void SystemScreenSaver::startScreenSaver(SystemData* system)
 		mSwapTimeout = Settings::getInstance()->getInt("ScreenSaverSwapMediaTimeout");
 		mOpacity = 0.0f;
 
-		// Load a random media
+		// Load a random media, the next one was usually picked already
 		std::string path = "";
 		if (Settings::getInstance()->getBool("SlideshowScreenSaverCustomMediaSource"))
 		{
-			pickRandomCustomMedia(path);
 			// Custom media are not tied to the game list
 			mCurrentGame = NULL;
+			if (!takeUpcomingImage(path))
+				pickRandomCustomMedia(path);
 		}
-		else
+		else if ((mCurrentGame != NULL) || !takeUpcomingImage(path))
 		{
 			pickRandomGameListImage(path, mCurrentGame != NULL);
 		}
@@ -288,13 +424,20 @@ void SystemScreenSaver::startScreenSaver(SystemData* system)
 
 		if (mCurrentGame != NULL)
 		{
-			Scripting::fireEvent("screensaver-game-select", mCurrentGame->getSystem()->getName(), mCurrentGame->getFileName(), mCurrentGame->getName(), "slideshow");
+			Scripting::queueEvent("screensaver-game-select", mCurrentGame->getSystem()->getName(), mCurrentGame->getFileName(), mCurrentGame->getName(), "slideshow");
 		}
 		return;
 	}
 	// No videos. Just use a standard screensaver
 	mState = STATE_SCREENSAVER_ACTIVE;
 	mCurrentGame = NULL;
+
+	// nothing but black is shown, scripts can turn the display off for that (DPMS, CEC, ...)
+	if (screensaver_behavior != "dim" && Settings::getInstance()->getBool("ScreenSaverDisplayOff"))
+	{
+		Scripting::queueEvent("display-off");
+		mDisplayOff = true;
+	}
 }
 
 void SystemScreenSaver::stopScreenSaver(bool toResume)
@@ -315,13 +458,17 @@ void SystemScreenSaver::stopScreenSaver(bool toResume)
 	mVideoScreensaver = NULL;
 	delete mImageScreensaver;
 	mImageScreensaver = NULL;
+	delete mFadingImage;
+	mFadingImage = NULL;
+	mCrossfade = 1.0f;
 
 	if (!toResume) {
 		// if we're not changing videos or images, let's delete the random list
 		// and all the scrensaver session-related variables
 		mCurrentGame = NULL;
 		mPreviousGame = NULL;
-		mAllFiles.clear();
+		mNextGame = NULL;
+		mUpcomingImages.clear();
 		mSystem = NULL;
 	}
 
@@ -334,6 +481,12 @@ void SystemScreenSaver::stopScreenSaver(bool toResume)
 		mThread = NULL;
 	}
 
+	if (mDisplayOff)
+	{
+		Scripting::queueEvent("display-on");
+		mDisplayOff = false;
+	}
+
 	// we need this to loop through different videos
 	mState = STATE_INACTIVE;
 	handleScreenSaverEditingCollection();
@@ -366,12 +519,22 @@ void SystemScreenSaver::renderScreenSaver()
 		setBackground();
 
 		// Only render the image if the state requires it
-		if ((int)mState >= STATE_FADE_IN_VIDEO && mImageScreensaver->hasImage())
+		if ((int)mState >= STATE_FADE_IN_VIDEO)
 		{
-			mImageScreensaver->setOpacity(255- (unsigned char) (mOpacity * 255));
-
+			const float opacity = 255.0f - (mOpacity * 255.0f);
 			Transform4x4f transform = Transform4x4f::Identity();
-			mImageScreensaver->render(transform);
+
+			if (mFadingImage && mFadingImage->hasImage())
+			{
+				mFadingImage->setOpacity((unsigned char)(opacity * (1.0f - mCrossfade)));
+				mFadingImage->render(transform);
+			}
+
+			if (mImageScreensaver->hasImage())
+			{
+				mImageScreensaver->setOpacity((unsigned char)(opacity * mCrossfade));
+				mImageScreensaver->render(transform);
+			}
 		}
 
 		// Check if we need to restart the background audio
@@ -388,85 +551,83 @@ void SystemScreenSaver::renderScreenSaver()
 	}
 }
 
-void SystemScreenSaver::backgroundIndexing()
+void SystemScreenSaver::collectIndexedMedia()
 {
-	LOG(LogDebug) << "Background indexing starting.";
+	// taken here on the main thread, games can be added and removed while the indexing thread runs. metadata values are
+	// interned and never freed, so the thread can hold on to them even when their game is gone
+	mIndexedMedia.clear();
 
-	// get the list of all games
 	SystemData* all = CollectionSystemManager::get()->getAllGamesCollection();
 	std::vector<FileData*> files = all->getRootFolder()->getFilesRecursive(GAME);
 
-	const auto startTs = std::chrono::system_clock::now();
-	for ( ; lastIndex < files.size(); lastIndex++)
+	mIndexedMedia.reserve(files.size() * 4);
+	for (auto it = files.cbegin(); it != files.cend(); ++it)
 	{
-		if(mExit)
-			break;
-		Utils::FileSystem::exists(files.at(lastIndex)->getVideoPath());
-		Utils::FileSystem::exists(files.at(lastIndex)->getMarqueePath());
-		Utils::FileSystem::exists(files.at(lastIndex)->getThumbnailPath());
-		Utils::FileSystem::exists(files.at(lastIndex)->getImagePath());
+		mIndexedMedia.push_back(&(*it)->metadata.get(MD_ID_VIDEO));
+		mIndexedMedia.push_back(&(*it)->metadata.get(MD_ID_MARQUEE));
+		mIndexedMedia.push_back(&(*it)->metadata.get(MD_ID_THUMBNAIL));
+		mIndexedMedia.push_back(&(*it)->metadata.get(MD_ID_IMAGE));
 	}
-	auto endTs = std::chrono::system_clock::now();
-	LOG(LogDebug) << "Indexed a total of " << lastIndex << " entries in " << std::chrono::duration_cast<std::chrono::milliseconds>(endTs - startTs).count() << " ms. Stopping.";
-}
 
-void SystemScreenSaver::getAllGamelistNodesForSystem(SystemData* system) {
-	std::vector<FileData*> subsysFiles {};
-	FileData* rootFileData = system->getRootFolder();
-	subsysFiles = rootFileData->getFilesRecursive(FileType::GAME, true);
-	mAllFiles.insert(mAllFiles.end(), subsysFiles.begin(), subsysFiles.end());
+	// the local art of a system is all in one directory, any name in it lists the whole of it
+	mIndexedFolders.clear();
+	for (auto it = SystemData::sSystemVector.cbegin(); it != SystemData::sSystemVector.cend(); ++it)
+	{
+		if ((*it)->isGameSystem() && !(*it)->isCollection())
+			mIndexedFolders.push_back((*it)->getStartPath() + "/images/index");
+	}
 }
 
-void SystemScreenSaver::getAllGamelistNodes()
+void SystemScreenSaver::backgroundIndexing()
 {
-	std::vector<FileData*> subsysFiles {};
-	for (std::vector<SystemData*>::const_iterator it = SystemData::sSystemVector.cbegin(); it != SystemData::sSystemVector.cend(); ++it)
-	{
-		// We only want nodes from game systems that are not collections
-		if (!(*it)->isGameSystem() || (*it)->isCollection())
-			continue;
+	LOG(LogDebug) << "Background indexing starting.";
+
+	const auto startTs = std::chrono::system_clock::now();
 
-		getAllGamelistNodesForSystem(*it);
+	// lists every media directory once, after that the lookups cost no disk access at all
+	for (auto it = mIndexedFolders.cbegin(); it != mIndexedFolders.cend() && !mExit; ++it)
+		MediaIndex::getInstance()->exists(*it);
+
+	for ( ; lastIndex < mIndexedMedia.size(); lastIndex++)
+	{
+		if(mExit)
+			break;
+		MediaIndex::getInstance()->exists(*mIndexedMedia.at(lastIndex));
 	}
+	auto endTs = std::chrono::system_clock::now();
+	LOG(LogDebug) << "Indexed a total of " << lastIndex / 4 << " entries in " << std::chrono::duration_cast<std::chrono::milliseconds>(endTs - startTs).count() << " ms. Stopping.";
 }
 
-void SystemScreenSaver::pickGameListNode(const char *nodeName)
+FileData* SystemScreenSaver::pickGameListNode(const char *nodeName)
 {
-	FileData *itf = nullptr;
-	bool found =  false;
-	int missCtr = 0;
-	while (!found)
+	// picked at random from the games the systems keep, so nothing is collected or shuffled for a session.
+	// as many tries as there are games keeps it from looping forever when none has an image/video path set
+	size_t candidates = 0;
+	if (mSystem)
+		candidates = mSystem->getDisplayedGames().size();
+	else
 	{
-		if (mAllFiles.empty())
+		for (auto it = SystemData::sSystemVector.cbegin(); it != SystemData::sSystemVector.cend(); ++it)
 		{
-			if (mSystem)
-				getAllGamelistNodesForSystem(mSystem);
-			else
-				getAllGamelistNodes();
-
-			if (mAllFiles.empty()) { return; } // no games at all
-			mAllFilesSize = mAllFiles.size();
-			std::shuffle(std::begin(mAllFiles), std::end(mAllFiles), SystemData::sURNG);
+			if ((*it)->isGameSystem() && !(*it)->isCollection())
+				candidates += (*it)->getDisplayedGames().size();
 		}
+	}
+
+	for (size_t missCtr = 0; missCtr < candidates; ++missCtr)
+	{
+		FileData* itf = mSystem ? mSystem->getRandomDisplayedGame() : SystemData::getRandomDisplayedGameOfAll();
+		if (itf == NULL)
+			break;
 
-		itf = mAllFiles.back();
-		mAllFiles.pop_back();
 		if ((strcmp(nodeName, "video") == 0 && itf->getVideoPath() != "") ||
 			(strcmp(nodeName, "image") == 0 && itf->getImagePath() != ""))
 		{
-			found = true;
-		}
-		else
-		{
-			missCtr++;
-			if (missCtr == mAllFilesSize)
-				// avoid looping forever when no candidate exist
-				// with image/video path set
-				return;
+			return itf;
 		}
 	}
 
-	mCurrentGame = itf;
+	return NULL;
 }
 
 void SystemScreenSaver::prepareScreenSaverMedia(const char *nodeName, std::string& path)
@@ -486,14 +647,22 @@ void SystemScreenSaver::prepareScreenSaverMedia(const char *nodeName, std::strin
 void SystemScreenSaver::pickRandomVideo(std::string& path, bool keepSame)
 {
 	if (!keepSame)
-		pickGameListNode("video");
+	{
+		FileData* game = pickGameListNode("video");
+		if (game)
+			mCurrentGame = game;
+	}
 	prepareScreenSaverMedia("video", path);
 }
 
 void SystemScreenSaver::pickRandomGameListImage(std::string& path, bool keepSame)
 {
 	if (!keepSame)
-		pickGameListNode("image");
+	{
+		FileData* game = pickGameListNode("image");
+		if (game)
+			mCurrentGame = game;
+	}
 	prepareScreenSaverMedia("image", path);
 }
 
@@ -586,6 +755,18 @@ void SystemScreenSaver::update(int deltaTime)
 		}
 	}
 
+	// Crossfade from the previous slideshow image
+	if (mFadingImage)
+	{
+		mCrossfade += (float)deltaTime / FADE_TIME;
+		if (mCrossfade >= 1.0f)
+		{
+			mCrossfade = 1.0f;
+			delete mFadingImage;
+			mFadingImage = NULL;
+		}
+	}
+
 	// If we have a loaded video/image then update it
 	if (mVideoScreensaver)
 		mVideoScreensaver->update(deltaTime);
@@ -603,8 +784,31 @@ void SystemScreenSaver::changeMediaItem(bool next) {
 	else
 	{
 		mPreviousGame = mCurrentGame;
-		mCurrentGame = NULL;
+		mCurrentGame = mNextGame;
+	}
+
+	// the slideshow crossfades to the next image that was loaded ahead
+	if (next && mImageScreensaver && (Settings::getInstance()->getString("ScreenSaverBehavior") == "slideshow"))
+	{
+		if (swapImage())
+		{
+			mState = STATE_SCREENSAVER_ACTIVE;
+			return;
+		}
 	}
+
+	// the random video screensaver switches videos without making a new component, which would show black in between
+	if (mVideoScreensaver && mCurrentGame && (Settings::getInstance()->getString("ScreenSaverBehavior") == "random video"))
+	{
+		if (swapVideo())
+		{
+			mState = STATE_SCREENSAVER_ACTIVE;
+			return;
+		}
+	}
+
+	if (next)
+		mCurrentGame = NULL;
 	mStopBackgroundAudio = false;
 	stopScreenSaver(true);
 	startScreenSaver(mSystem);
@@ -3,10 +3,13 @@
 #define ES_APP_SYSTEM_SCREEN_SAVER_H
 
 #include "Window.h"
+#include <atomic>
+#include <list>
 #include <thread>
 
 class ImageComponent;
 class Sound;
+class TextureResource;
 class VideoComponent;
 
 // Screensaver implementation for main window
@@ -26,20 +29,26 @@ public:
 	virtual FileData* getCurrentGame();
 	virtual void selectGame(bool launch);
 	virtual bool inputDuringScreensaver(InputConfig* config, Input input);
+	virtual Cover getCover();
 
 private:
 	void changeMediaItem(bool next = true);
-	void pickGameListNode(const char *nodeName);
+	FileData* pickGameListNode(const char *nodeName);
 	void prepareScreenSaverMedia(const char *nodeName, std::string& path);
 	void pickRandomVideo(std::string& path, bool keepSame = false);
 	void pickRandomGameListImage(std::string& path, bool keepSame = false);
 	void pickRandomCustomMedia(std::string& path);
+	void prefetchNextVideo();
+	bool swapVideo();
 	void setVideoScreensaver(std::string& path);
 	void setImageScreensaver(std::string& path);
+	void loadImageScreensaver(std::string& path);
+	void prefetchUpcomingImages();
+	bool takeUpcomingImage(std::string& path);
+	bool swapImage();
 	bool isFileVideo(std::string& path);
 	std::vector<std::string> getCustomMediaFiles(const std::string &mediaDir);
-	void getAllGamelistNodes();
-	void getAllGamelistNodesForSystem(SystemData* system);
+	void collectIndexedMedia();
 	void backgroundIndexing();
 	void setBackground();
 	void handleScreenSaverEditingCollection();
@@ -52,9 +61,20 @@ private:
 		STATE_SCREENSAVER_ACTIVE
 	};
 
+	// a slideshow image picked ahead, its texture loads in the background while it's kept
+	struct UpcomingImage
+	{
+		std::string				path;
+		FileData*				game;
+		std::shared_ptr<TextureResource>	texture;
+	};
+
 private:
 	VideoComponent*		mVideoScreensaver;
 	ImageComponent*		mImageScreensaver;
+	ImageComponent*		mFadingImage; // the previous slideshow image, fading out
+	float			mCrossfade;
+	std::list<UpcomingImage> mUpcomingImages;
 	Window*			mWindow;
 	SystemData*		mSystem;
 	STATE			mState;
@@ -62,15 +82,17 @@ private:
 	int			mTimer;
 	FileData*		mCurrentGame;
 	FileData*		mPreviousGame;
+	FileData*		mNextGame; // its video is opened while the current one plays
 	int			mSwapTimeout;
 	std::shared_ptr<Sound>	mBackgroundAudio;
 	bool			mStopBackgroundAudio;
-	std::vector<FileData*>	mAllFiles;
 	std::vector<std::string> mCustomMediaFiles;
-	int			mAllFilesSize;
 	std::thread*		mThread;
-	bool			mExit;
+	std::atomic<bool>	mExit;
+	std::vector<const std::string*> mIndexedMedia; // what backgroundIndexing looks up, it doesn't touch the games
+	std::vector<std::string> mIndexedFolders;
 	std::string 		mRegularEditingCollection;
+	bool			mDisplayOff; // "display-off" was sent, "display-on" goes with stopping
 };
 
 #endif // ES_APP_SYSTEM_SCREEN_SAVER_H
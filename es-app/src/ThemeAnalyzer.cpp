@@ -0,0 +1,434 @@
+#include "ThemeAnalyzer.h"
+
+#include "math/Misc.h"
+#include "resources/Font.h"
+#include "resources/ResourceManager.h"
+#include "resources/TextureVariant.h"
+#include "utils/FileSystemUtil.h"
+#include "utils/StringUtil.h"
+#include "ImageIO.h"
+#include "Settings.h"
+#include "ThemeData.h"
+#include <algorithm>
+#include <cmath>
+#include <iomanip>
+#include <iostream>
+#include <map>
+#include <set>
+#include <sstream>
+
+// the screen the sizes are estimated for without --resolution
+#define DEFAULT_SCREEN_WIDTH  1920
+#define DEFAULT_SCREEN_HEIGHT 1080
+
+// a font renders the printable ASCII as soon as it's used, the text shown adds the rest over time
+#define ESTIMATED_GLYPHS 95
+
+// the pages the glyphs of every font are packed into, see Font::FontTexture. The packing leaves some of it empty
+#define GLYPH_PAGE_WIDTH  2048
+#define GLYPH_PAGE_HEIGHT 512
+#define GLYPH_PAGE_FILL   0.8f
+
+// without autoLayout the tile size decides how many there are, a 4x3 grid is assumed
+#define DEFAULT_GRID_TILES 12
+
+// as SystemView without maxLogoCount
+#define DEFAULT_LOGO_COUNT 3
+
+#define MEGABYTE (1024 * 1024)
+
+// what the elements of one view take
+struct ViewUsage
+{
+	std::map<std::string, size_t>         textures;   // decoded bytes by path, elements showing the same file share it
+	std::set<std::pair<std::string, int>> fonts;      // path and px
+	size_t                                videoBytes; // frames the videos are decoded into
+	unsigned int                          videos;
+	unsigned int                          elements;
+	unsigned int                          extras;
+	unsigned int                          draws;
+	bool                                  overBudget;
+
+	ViewUsage() : videoBytes(0), videos(0), elements(0), extras(0), draws(0), overBudget(false) { }
+};
+
+static Vector2f sScreen;
+
+static std::string formatMegabytes(const size_t _bytes)
+{
+	std::ostringstream stream;
+	stream << std::fixed << std::setprecision(1) << ((double)_bytes / MEGABYTE) << " MB";
+	return stream.str();
+
+} // formatMegabytes
+
+static std::string formatSize(const size_t _width, const size_t _height)
+{
+	return std::to_string(_width) + "x" + std::to_string(_height);
+
+} // formatSize
+
+// _property in px on the screen, zero when the element doesn't have it
+static Vector2f getPixels(const ThemeData::ThemeElement& _elem, const std::string& _property)
+{
+	if(!_elem.has(_property))
+		return Vector2f::Zero();
+
+	const Vector2f value = _elem.get<Vector2f>(_property);
+	return Vector2f(value.x() * sScreen.x(), value.y() * sScreen.y());
+
+} // getPixels
+
+static void printElement(std::ostream& _details, const std::string& _name, const std::string& _property, const std::string& _what)
+{
+	_details << "   " << std::left << std::setw(28) << (_name + "." + _property) << std::right << " " << _what;
+
+} // printElement
+
+static void flag(std::ostream& _details, ViewUsage& _usage, const std::string& _budget)
+{
+	_details << "   ! over the " << _budget;
+	_usage.overBudget = true;
+
+} // flag
+
+// the texture _property of _elem is loaded into, _display is the size it's shown at, zero when it's shown at its own
+static void addImage(const ThemeData::ThemeElement& _elem, const std::string& _name, const std::string& _property, const Vector2f& _display, const bool _fitInside,
+                     ViewUsage& _usage, std::ostream& _details, const ThemeAnalyzer::Options& _options)
+{
+	if(!_elem.has(_property))
+		return;
+
+	const std::string path = _elem.get<std::string>(_property);
+	if(path.empty())
+		return;
+
+	const std::string fileName = Utils::FileSystem::getFileName(path);
+	size_t bytes  = 0;
+
+	printElement(_details, _name, _property, fileName);
+
+	if(Utils::String::toLower(Utils::FileSystem::getExtension(path)) == ".svg")
+	{
+		// rasterized at the size it's shown at, a missing side keeps the aspect the SVG has
+		const float width  = (_display.x() > 0) ? _display.x() : _display.y();
+		const float height = (_display.y() > 0) ? _display.y() : _display.x();
+
+		if((width <= 0) || (height <= 0))
+		{
+			_details << "  rasterized at its own size\n";
+			return;
+		}
+
+		bytes = (size_t)width * (size_t)height * 4;
+		_details << "  " << formatSize((size_t)width, (size_t)height) << " " << formatMegabytes(bytes);
+	}
+	else
+	{
+		size_t width, height;
+		if(!ImageIO::loadSizeFromFile(ResourceManager::getInstance()->getResourcePath(path), width, height))
+		{
+			_details << "  can't be read\n";
+			return;
+		}
+
+		// with "ReduceImages" the image is decoded at a fraction of its size when it's shown smaller
+		const int level = TextureVariant::getLevel(width, height, _display.x(), _display.y(), _fitInside);
+
+		bytes = (width >> level) * (height >> level) * 4;
+		_details << "  " << formatSize(width, height);
+
+		if(level > 0)
+			_details << " reduced to " << formatSize(width >> level, height >> level);
+
+		_details << " " << formatMegabytes(bytes);
+	}
+
+	if(_options.image && (bytes > (size_t)_options.image * MEGABYTE))
+		flag(_details, _usage, "image budget of " + std::to_string(_options.image) + " MB");
+
+	_details << "\n";
+
+	size_t& texture = _usage.textures[path];
+	texture = std::max(texture, bytes);
+
+} // addImage
+
+// _defaultSize is the fraction of the screen the element's font has without fontSize
+static void addFont(const ThemeData::ThemeElement& _elem, const std::string& _name, const float _defaultSize, ViewUsage& _usage, std::ostream& _details,
+                    const ThemeAnalyzer::Options& _options)
+{
+	const std::string path = _elem.has("fontPath") ? _elem.get<std::string>("fontPath") : Font::getDefaultPath();
+	const int         size = _elem.has("fontSize") ? (int)(sScreen.y() * _elem.get<float>("fontSize")) : (int)(_defaultSize * std::min(sScreen.x(), sScreen.y()));
+
+	printElement(_details, _name, "font", Utils::FileSystem::getFileName(path) + "  " + std::to_string(size) + " px");
+
+	if(_options.font && (size > (int)_options.font))
+		flag(_details, _usage, "font budget of " + std::to_string(_options.font) + " px");
+
+	if((size + 2) > GLYPH_PAGE_HEIGHT)
+		_details << "   ! taller than a glyph page, can't be rendered";
+
+	_details << "\n";
+
+	_usage.fonts.insert(std::make_pair(path, size));
+
+} // addFont
+
+static void addElement(const ThemeData::ThemeElement& _elem, const std::string& _name, ViewUsage& _usage, std::ostream& _details, const ThemeAnalyzer::Options& _options)
+{
+	const std::string& type      = _elem.type;
+	const bool         fitInside = !_elem.has("size") && _elem.has("maxSize");
+	const Vector2f     display   = getPixels(_elem, fitInside ? "maxSize" : "size");
+
+	if(type == "image")
+	{
+		const bool tile = _elem.has("tile") && _elem.get<bool>("tile");
+
+		// a tiled image repeats at its own size
+		addImage(_elem, _name, "path",    tile ? Vector2f::Zero() : display, fitInside, _usage, _details, _options);
+		addImage(_elem, _name, "default", tile ? Vector2f::Zero() : display, fitInside, _usage, _details, _options);
+		_usage.draws += 1;
+	}
+	else if(type == "video")
+	{
+		addImage(_elem, _name, "default", display, fitInside, _usage, _details, _options);
+
+		// the frames are converted into a texture of the size it's shown at
+		const size_t width  = (size_t)((display.x() > 0) ? display.x() : sScreen.x());
+		const size_t height = (size_t)((display.y() > 0) ? display.y() : ((width * sScreen.y()) / sScreen.x()));
+		const size_t bytes  = width * height * 4;
+
+		printElement(_details, _name, "video", formatSize(width, height) + " " + formatMegabytes(bytes) + "\n");
+
+		_usage.videoBytes += bytes;
+		_usage.videos     += 1;
+		_usage.draws      += 1;
+	}
+	else if((type == "ninepatch") || (type == "gridtile"))
+	{
+		addImage(_elem, _name, (type == "ninepatch") ? "path" : "backgroundImage", Vector2f::Zero(), false, _usage, _details, _options);
+		_usage.draws += 1;
+	}
+	else if(type == "rating")
+	{
+		// one star is as high as the element
+		const Vector2f star(display.y(), display.y());
+
+		addImage(_elem, _name, "filledPath",   star, false, _usage, _details, _options);
+		addImage(_elem, _name, "unfilledPath", star, false, _usage, _details, _options);
+		_usage.draws += 2;
+	}
+	else if(type == "imagegrid")
+	{
+		const Vector2f layout = _elem.has("autoLayout") ? _elem.get<Vector2f>("autoLayout") : Vector2f::Zero();
+		const int      tiles  = ((layout.x() >= 1) && (layout.y() >= 1)) ? (int)(layout.x() * layout.y()) : DEFAULT_GRID_TILES;
+
+		addImage(_elem, _name, "gameImage",   Vector2f::Zero(), false, _usage, _details, _options);
+		addImage(_elem, _name, "folderImage", Vector2f::Zero(), false, _usage, _details, _options);
+
+		// the background and the image of every tile
+		_usage.draws += tiles * 2;
+	}
+	else if(type == "textlist")
+	{
+		const Vector2f selector(display.x(), _elem.has("selectorHeight") ? (_elem.get<float>("selectorHeight") * sScreen.y()) : 0.0f);
+
+		addImage(_elem, _name, "selectorImagePath", selector, false, _usage, _details, _options);
+		addFont (_elem, _name, 0.045f, _usage, _details, _options); // FONT_SIZE_MEDIUM
+		_usage.draws += 2;
+	}
+	else if((type == "text") || (type == "datetime"))
+	{
+		addFont(_elem, _name, 0.045f, _usage, _details, _options); // FONT_SIZE_MEDIUM
+		_usage.draws += 1;
+	}
+	else if(type == "helpsystem")
+	{
+		addFont(_elem, _name, 0.035f, _usage, _details, _options); // FONT_SIZE_SMALL
+		_usage.draws += 2;
+	}
+	else if(type == "carousel")
+	{
+		const int logos = _elem.has("maxLogoCount") ? (int)Math::round(_elem.get<float>("maxLogoCount")) : DEFAULT_LOGO_COUNT;
+
+		// the background and the logos, the images of which come from the systems' own themes
+		_usage.draws += 1 + std::max(logos, 1);
+	}
+
+} // addElement
+
+// the glyph pages ESTIMATED_GLYPHS of each font take, a glyph is about 0.6 as wide as the font is high with a pixel around it
+static int getGlyphPages(const std::set<std::pair<std::string, int>>& _fonts, float& _fill)
+{
+	double area = 0;
+
+	for(auto it = _fonts.cbegin(); it != _fonts.cend(); ++it)
+		area += ((it->second * 0.6) + 2) * (it->second + 2) * ESTIMATED_GLYPHS;
+
+	const double pageArea = (double)GLYPH_PAGE_WIDTH * GLYPH_PAGE_HEIGHT * GLYPH_PAGE_FILL;
+	const int    pages    = (int)std::ceil(area / pageArea);
+
+	_fill = (pages > 0) ? (float)(area / (pages * pageArea)) : 0.0f;
+	return pages;
+
+} // getGlyphPages
+
+// prints what _view of _system takes, returns the bytes it takes in VRAM
+static size_t analyzeView(const ThemeData& _theme, const std::string& _system, const std::string& _view, bool& _overBudget, const ThemeAnalyzer::Options& _options)
+{
+	ViewUsage          usage;
+	std::ostringstream details;
+
+	const std::vector<std::string> names = _theme.getElementNames(_view);
+
+	for(auto it = names.cbegin(); it != names.cend(); ++it)
+	{
+		const ThemeData::ThemeElement* elem = _theme.getElement(_view, *it, "");
+
+		if(!elem || (elem->has("visible") && !elem->get<bool>("visible")))
+			continue;
+
+		usage.elements += 1;
+		usage.extras   += elem->extra ? 1 : 0;
+
+		addElement(*elem, *it, usage, details, _options);
+	}
+
+	size_t textureBytes = 0;
+	for(auto it = usage.textures.cbegin(); it != usage.textures.cend(); ++it)
+		textureBytes += it->second;
+
+	float        fill  = 0.0f;
+	const int    pages = getGlyphPages(usage.fonts, fill);
+	const size_t glyphBytes = (size_t)pages * GLYPH_PAGE_WIDTH * GLYPH_PAGE_HEIGHT * 4;
+	const size_t total      = textureBytes + glyphBytes + usage.videoBytes;
+
+	std::cout << "\n" << _system << "/" << _view << ": " << usage.elements << " elements, " << usage.extras << " extras, " <<
+	             usage.textures.size() << " textures " << formatMegabytes(textureBytes) << ", " <<
+	             usage.fonts.size() << " fonts on " << pages << " glyph pages " << (int)(fill * 100) << "% full " << formatMegabytes(glyphBytes) << ", " <<
+	             usage.videos << " videos " << formatMegabytes(usage.videoBytes) << ", " <<
+	             usage.draws << " draws, " << formatMegabytes(total) << " VRAM\n";
+
+	if(_options.view && (total > (size_t)_options.view * MEGABYTE))
+		flag(std::cout, usage, "view budget of " + std::to_string(_options.view) + " MB\n");
+
+	if(_options.extras && (usage.extras > _options.extras))
+		flag(std::cout, usage, "budget of " + std::to_string(_options.extras) + " extras\n");
+
+	if(_options.draws && (usage.draws > _options.draws))
+		flag(std::cout, usage, "budget of " + std::to_string(_options.draws) + " draws\n");
+
+	std::cout << details.str();
+
+	_overBudget = usage.overBudget;
+	return total;
+
+} // analyzeView
+
+int ThemeAnalyzer::run(const Options& _options)
+{
+	const int width  = Settings::getInstance()->getInt("WindowWidth");
+	const int height = Settings::getInstance()->getInt("WindowHeight");
+
+	sScreen = Vector2f((float)(width ? width : DEFAULT_SCREEN_WIDTH), (float)(height ? height : DEFAULT_SCREEN_HEIGHT));
+
+	const std::map<std::string, ThemeSet> sets = ThemeData::getThemeSets();
+	auto                                  set  = sets.find(_options.theme);
+	std::string                           path;
+
+	if(set != sets.cend())
+		path = set->second.path;
+	else if(Utils::FileSystem::isDirectory(_options.theme))
+		path = Utils::FileSystem::getAbsolutePath(_options.theme);
+	else
+	{
+		std::cout << "There's no theme set \"" << _options.theme << "\", installed are:\n";
+		for(set = sets.cbegin(); set != sets.cend(); ++set)
+			std::cout << "   " << set->first << "\n";
+		return 1;
+	}
+
+	// the files of a packed set can be read but not listed
+	if(!Utils::FileSystem::isDirectory(path))
+	{
+		std::cout << "\"" << _options.theme << "\" is packed, analyze the directory it was packed from\n";
+		return 1;
+	}
+
+	std::cout << "Theme \"" << path << "\" at " << (int)sScreen.x() << "x" << (int)sScreen.y() << "\n";
+
+	Utils::FileSystem::stringList dirContent = Utils::FileSystem::getDirContent(path);
+	dirContent.sort();
+
+	unsigned int systems    = 0;
+	unsigned int views      = 0;
+	unsigned int failed     = 0;
+	unsigned int overBudget = 0;
+	size_t       heaviest   = 0;
+	std::string  heaviestView;
+
+	for(auto it = dirContent.cbegin(); it != dirContent.cend(); ++it)
+	{
+		const std::string themePath = *it + "/theme.xml";
+
+		if(!Utils::FileSystem::isDirectory(*it) || !Utils::FileSystem::exists(themePath))
+			continue;
+
+		const std::string system = Utils::FileSystem::getFileName(*it);
+
+		// without es_systems.cfg the folder has to do for all of them
+		std::map<std::string, std::string> sysData;
+		sysData["system.name"]     = system;
+		sysData["system.theme"]    = system;
+		sysData["system.fullName"] = system;
+
+		ThemeData theme;
+
+		try
+		{
+			theme.loadFile(sysData, themePath);
+		}
+		catch(ThemeException& e)
+		{
+			std::cout << "\n" << system << ": could not be loaded, " << e.what() << "\n";
+			++failed;
+			continue;
+		}
+
+		++systems;
+
+		const std::vector<std::string> viewNames = theme.getViewNames();
+
+		for(auto view = viewNames.cbegin(); view != viewNames.cend(); ++view)
+		{
+			bool         over  = false;
+			const size_t bytes = analyzeView(theme, system, *view, over, _options);
+
+			if(bytes > heaviest)
+			{
+				heaviest     = bytes;
+				heaviestView = system + "/" + *view;
+			}
+
+			overBudget += over ? 1 : 0;
+			++views;
+		}
+	}
+
+	if(!systems && !failed)
+	{
+		std::cout << "No system themes in \"" << path << "\"\n";
+		return 1;
+	}
+
+	std::cout << "\n" << systems << " systems, " << views << " views, " << failed << " failed to load, " << overBudget << " over budget";
+
+	if(!heaviestView.empty())
+		std::cout << ", the heaviest is " << heaviestView << " with " << formatMegabytes(heaviest);
+
+	std::cout << "\n";
+
+	return (failed || overBudget) ? 1 : 0;
+
+} // run
@@ -0,0 +1,33 @@
+#pragma once
+#ifndef ES_APP_THEME_ANALYZER_H
+#define ES_APP_THEME_ANALYZER_H
+
+#include <string>
+
+// Loads every system theme of a theme set through ThemeData without a window and prints, per view, the images, fonts
+// and videos it uses, what they take once decoded and how many draws its elements make, so a theme that's too heavy
+// for a Raspberry Pi can be found before it's shipped. The sizes are estimates for the screen the theme would be
+// shown on, --resolution or 1920x1080
+class ThemeAnalyzer
+{
+public:
+
+	// what's flagged, 0 for no limit
+	struct Options
+	{
+		std::string  theme;    // name of an installed set or its directory
+		unsigned int image;    // MB one image takes decoded
+		unsigned int view;     // MB of textures, glyph pages and video frames a view takes
+		unsigned int extras;   // extras in a view
+		unsigned int font;     // px of a font
+		unsigned int draws;    // draws the elements of a view make
+
+		Options() : image(8), view(64), extras(30), font(128), draws(100) { }
+	};
+
+	// Prints the report, returns the exit code, 1 when a theme didn't load or anything is over budget
+	static int run(const Options& _options);
+
+}; // ThemeAnalyzer
+
+#endif // ES_APP_THEME_ANALYZER_H
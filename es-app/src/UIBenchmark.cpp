@@ -0,0 +1,322 @@
+#include "UIBenchmark.h"
+
+#include "renderers/Renderer.h"
+#include "resources/Font.h"
+#include "resources/TextureResource.h"
+#include "views/ViewController.h"
+#include "CollectionSystemManager.h"
+#include "FrameScheduler.h"
+#include "InputConfig.h"
+#include "Log.h"
+#include "Metrics.h"
+#include "Settings.h"
+#include "ThemeData.h"
+#include "Window.h"
+#include <SDL_timer.h>
+#include <algorithm>
+#include <iomanip>
+#include <iostream>
+#include <sstream>
+
+std::vector<UIBenchmark::Scenario> UIBenchmark::sScenarios;
+InputConfig*                       UIBenchmark::sInputConfig = nullptr;
+Window*                            UIBenchmark::sWindow      = nullptr;
+bool                               UIBenchmark::sActive      = false;
+size_t                             UIBenchmark::sScenario    = 0;
+size_t                             UIBenchmark::sStep        = 0;
+double                             UIBenchmark::sStepTime    = 0.0;
+double                             UIBenchmark::sFrameTime   = 0.0;
+double                             UIBenchmark::sSampleTime  = 0.0;
+unsigned int                       UIBenchmark::sDrawCalls   = 0;
+unsigned int                       UIBenchmark::sVertices    = 0;
+std::string                        UIBenchmark::sThemeSet;
+std::string                        UIBenchmark::sViewStyle;
+
+// how often the memory high-water marks are sampled, /proc isn't read every frame
+static const double SAMPLE_INTERVAL = 250.0;
+
+static double getMilliseconds()
+{
+	return (SDL_GetPerformanceCounter() * 1000.0) / SDL_GetPerformanceFrequency();
+
+} // getMilliseconds
+
+void UIBenchmark::init()
+{
+	sInputConfig = new InputConfig(DEVICE_KEYBOARD, "Benchmark", "");
+	sInputConfig->mapInput("up",     Input(DEVICE_KEYBOARD, TYPE_KEY, SDLK_UP,     1, true));
+	sInputConfig->mapInput("down",   Input(DEVICE_KEYBOARD, TYPE_KEY, SDLK_DOWN,   1, true));
+	sInputConfig->mapInput("left",   Input(DEVICE_KEYBOARD, TYPE_KEY, SDLK_LEFT,   1, true));
+	sInputConfig->mapInput("right",  Input(DEVICE_KEYBOARD, TYPE_KEY, SDLK_RIGHT,  1, true));
+	sInputConfig->mapInput("a",      Input(DEVICE_KEYBOARD, TYPE_KEY, SDLK_RETURN, 1, true));
+	sInputConfig->mapInput("b",      Input(DEVICE_KEYBOARD, TYPE_KEY, SDLK_ESCAPE, 1, true));
+	sInputConfig->mapInput("start",  Input(DEVICE_KEYBOARD, TYPE_KEY, SDLK_F1,     1, true));
+	sInputConfig->mapInput("select", Input(DEVICE_KEYBOARD, TYPE_KEY, SDLK_F2,     1, true));
+
+	sThemeSet  = Settings::getInstance()->getString("ThemeSet");
+	sViewStyle = Settings::getInstance()->getString("GamelistViewStyle");
+	sActive    = true;
+
+} // init
+
+void UIBenchmark::deinit()
+{
+	if(!sInputConfig)
+		return;
+
+	// stopped halfway, don't leave the settings at what the last scenario switched them to
+	Settings::getInstance()->setString("ThemeSet",          sThemeSet);
+	Settings::getInstance()->setString("GamelistViewStyle", sViewStyle);
+
+	delete sInputConfig;
+	sInputConfig = nullptr;
+	sActive      = false;
+	sScenarios.clear();
+
+} // deinit
+
+bool UIBenchmark::isActive()
+{
+	return sActive;
+
+} // isActive
+
+void UIBenchmark::start(Window* _window)
+{
+	sWindow     = _window;
+	sScenario   = 0;
+	sStep       = 0;
+	sStepTime   = getMilliseconds();
+	sFrameTime  = 0.0;
+	sSampleTime = 0.0;
+
+	const Renderer::Stats stats = Renderer::getTotalStats();
+	sDrawCalls = stats.drawCalls;
+	sVertices  = stats.vertices;
+
+	addScenarios();
+
+} // start
+
+bool UIBenchmark::update()
+{
+	if(!sActive)
+		return false;
+
+	const double now = getMilliseconds();
+
+	// what the frame before this one drew, like its time
+	const Renderer::Stats stats = Renderer::getTotalStats();
+
+	if(sFrameTime > 0.0)
+	{
+		Scenario& scenario = sScenarios[sScenario];
+		scenario.frameTimes.push_back(now - sFrameTime);
+		scenario.drawCalls += stats.drawCalls - sDrawCalls;
+		scenario.vertices  += stats.vertices  - sVertices;
+	}
+
+	sFrameTime = now;
+	sDrawCalls = stats.drawCalls;
+	sVertices  = stats.vertices;
+
+	if((now - sSampleTime) >= SAMPLE_INTERVAL)
+	{
+		Scenario&    scenario = sScenarios[sScenario];
+		const size_t vram     = TextureResource::getTotalMemUsage() + Font::getTotalMemUsage();
+		const size_t resident = Metrics::getResidentMemory();
+
+		scenario.maxVRAM     = std::max(scenario.maxVRAM, vram);
+		scenario.maxResident = std::max(scenario.maxResident, resident);
+		sSampleTime          = now;
+	}
+
+	while(now >= sStepTime)
+	{
+		if(sStep >= sScenarios[sScenario].steps.size())
+		{
+			LOG(LogInfo) << "Benchmark scenario \"" << sScenarios[sScenario].name << "\" done";
+
+			if(++sScenario >= sScenarios.size())
+			{
+				report();
+				deinit();
+				return false;
+			}
+
+			sStep       = 0;
+			sSampleTime = 0.0;
+			continue;
+		}
+
+		const Step& step = sScenarios[sScenario].steps[sStep++];
+
+		switch(step.type)
+		{
+			case Step::PRESS:   { input(step.button, 1); } break;
+			case Step::RELEASE: { input(step.button, 0); } break;
+			case Step::ACTION:  { step.action();         } break;
+		}
+
+		sStepTime = now + step.wait;
+	}
+
+	// every frame is drawn, an unchanged screen would otherwise only be checked and skew the numbers
+	FrameScheduler::requestFrame(0);
+	Renderer::requestRedraw();
+
+	return true;
+
+} // update
+
+void UIBenchmark::addScenarios()
+{
+	sScenarios.clear();
+
+	sScenarios.push_back(Scenario { "carousel", {}, {}, 0, 0, 0, 0 });
+	for(int i = 0; i < 20; ++i)
+		press(sScenarios.back(), "right", 100);
+	action(sScenarios.back(), [] { }, 1000);
+
+	sScenarios.push_back(Scenario { "gamelist", {}, {}, 0, 0, 0, 0 });
+	press(sScenarios.back(), "a", 100);
+	action(sScenarios.back(), [] { }, 1000);
+	press(sScenarios.back(), "down", 5000);
+	press(sScenarios.back(), "up", 3000);
+	for(int i = 0; i < 20; ++i)
+		press(sScenarios.back(), "down", 100);
+	press(sScenarios.back(), "b", 100);
+	action(sScenarios.back(), [] { }, 1000);
+
+	sScenarios.push_back(Scenario { "grid", {}, {}, 0, 0, 0, 0 });
+	action(sScenarios.back(), []
+	{
+		Settings::getInstance()->setString("GamelistViewStyle", "grid");
+		ViewController::get()->reloadAll();
+	}, 500);
+	press(sScenarios.back(), "a", 100);
+	action(sScenarios.back(), [] { }, 1000);
+	press(sScenarios.back(), "down", 5000);
+	press(sScenarios.back(), "right", 2000);
+	press(sScenarios.back(), "up", 3000);
+	press(sScenarios.back(), "b", 100);
+	action(sScenarios.back(), []
+	{
+		Settings::getInstance()->setString("GamelistViewStyle", sViewStyle);
+		ViewController::get()->reloadAll();
+	}, 1000);
+
+	sScenarios.push_back(Scenario { "menu", {}, {}, 0, 0, 0, 0 });
+	press(sScenarios.back(), "start", 100);
+	action(sScenarios.back(), [] { }, 500);
+	press(sScenarios.back(), "down", 2000);
+	press(sScenarios.back(), "up", 2000);
+	press(sScenarios.back(), "b", 100);
+	action(sScenarios.back(), [] { }, 1000);
+
+	// switching is what's measured, the few theme sets first found are enough for that
+	const std::map<std::string, ThemeSet> themeSets = ThemeData::getThemeSets();
+
+	if(!themeSets.empty())
+	{
+		size_t count = 0;
+
+		sScenarios.push_back(Scenario { "themes", {}, {}, 0, 0, 0, 0 });
+
+		for(auto it = themeSets.cbegin(); (it != themeSets.cend()) && (count < 3); ++it, ++count)
+		{
+			const std::string name = it->first;
+
+			action(sScenarios.back(), [name]
+			{
+				Settings::getInstance()->setString("ThemeSet", name);
+				CollectionSystemManager::get()->updateSystemsList();
+				ViewController::get()->reloadAll(true);
+			}, 1000);
+
+			for(int i = 0; i < 5; ++i)
+				press(sScenarios.back(), "right", 100);
+		}
+
+		action(sScenarios.back(), []
+		{
+			Settings::getInstance()->setString("ThemeSet", sThemeSet);
+			CollectionSystemManager::get()->updateSystemsList();
+			ViewController::get()->reloadAll(true);
+		}, 1000);
+	}
+
+} // addScenarios
+
+void UIBenchmark::press(Scenario& _scenario, const std::string& _button, const int _hold)
+{
+	// a short pause after letting go keeps the next press from being taken as part of a repeat
+	_scenario.steps.push_back(Step { Step::PRESS,   _button, nullptr, _hold });
+	_scenario.steps.push_back(Step { Step::RELEASE, _button, nullptr, 150   });
+
+} // press
+
+void UIBenchmark::action(Scenario& _scenario, const std::function<void()>& _action, const int _wait)
+{
+	_scenario.steps.push_back(Step { Step::ACTION, "", _action, _wait });
+
+} // action
+
+void UIBenchmark::input(const std::string& _button, const int _value)
+{
+	Input input;
+
+	if(!sInputConfig->getInputByName(_button, &input))
+		return;
+
+	input.value = _value;
+	sWindow->input(sInputConfig, input);
+
+} // input
+
+void UIBenchmark::report()
+{
+	// frames that took more than twice the interval would have missed a refresh
+	const double      dropLimit = FrameScheduler::getFrameInterval() * 2.0;
+	std::stringstream ss;
+
+	ss << std::fixed << std::setprecision(2);
+	ss << "UI benchmark, frame times in ms, memory high-water in MiB, draw calls and vertices per frame\n";
+	ss << std::left << std::setw(10) << "scenario" << std::right << std::setw(8) << "frames" << std::setw(8) << "p50" <<
+	      std::setw(8) << "p90" << std::setw(8) << "p99" << std::setw(8) << "max" << std::setw(8) << "dropped" <<
+	      std::setw(10) << "vram" << std::setw(10) << "resident" << std::setw(8) << "draws" << std::setw(10) << "vertices" << "\n";
+
+	for(auto it = sScenarios.begin(); it != sScenarios.end(); ++it)
+	{
+		std::vector<double>& frameTimes = it->frameTimes;
+		size_t               dropped    = 0;
+
+		if(frameTimes.empty())
+			frameTimes.push_back(0.0);
+
+		const double frames = (double)frameTimes.size();
+
+		std::sort(frameTimes.begin(), frameTimes.end());
+
+		for(double frameTime : frameTimes)
+		{
+			if(frameTime > dropLimit)
+				++dropped;
+		}
+
+		auto percentile = [&frameTimes](const double _percentile)
+		{
+			return frameTimes[std::min(frameTimes.size() - 1, (size_t)(frameTimes.size() * _percentile))];
+		};
+
+		ss << std::left << std::setw(10) << it->name << std::right << std::setw(8) << frameTimes.size() <<
+		      std::setw(8) << percentile(0.5) << std::setw(8) << percentile(0.9) << std::setw(8) << percentile(0.99) <<
+		      std::setw(8) << frameTimes.back() << std::setw(8) << dropped <<
+		      std::setw(10) << (it->maxVRAM / 1024.0 / 1024.0) << std::setw(10) << (it->maxResident / 1024.0 / 1024.0) <<
+		      std::setw(8) << (it->drawCalls / frames) << std::setw(10) << (it->vertices / frames) << "\n";
+	}
+
+	std::cout << ss.str();
+	LOG(LogInfo) << ss.str();
+
+} // report
@@ -0,0 +1,74 @@
+#pragma once
+#ifndef ES_APP_UI_BENCHMARK_H
+#define ES_APP_UI_BENCHMARK_H
+
+#include <functional>
+#include <stdint.h>
+#include <string>
+#include <vector>
+
+class InputConfig;
+class Window;
+
+// Runs the UI through a fixed set of scenarios and reports how long the frames took. Meant to run on the library of
+// BenchmarkLibrary, so every run scrolls through exactly the same games
+class UIBenchmark
+{
+public:
+
+	static void init  ();
+	static void deinit();
+	static bool isActive();
+
+	// Starts the first scenario once the UI is up
+	static void start(Window* _window);
+
+	// Called for each frame of the main loop, false once every scenario ran and the report was written
+	static bool update();
+
+private:
+
+	struct Step
+	{
+		enum Type { PRESS, RELEASE, ACTION };
+
+		Type                  type;
+		std::string           button;
+		std::function<void()> action;
+		int                   wait;
+	};
+
+	struct Scenario
+	{
+		std::string         name;
+		std::vector<Step>   steps;
+		std::vector<double> frameTimes;
+		size_t              maxVRAM;
+		size_t              maxResident;
+		uint64_t            drawCalls;
+		uint64_t            vertices;
+	};
+
+	static void addScenarios();
+	static void press   (Scenario& _scenario, const std::string& _button, const int _hold);
+	static void action  (Scenario& _scenario, const std::function<void()>& _action, const int _wait);
+	static void input   (const std::string& _button, const int _value);
+	static void report  ();
+
+	static std::vector<Scenario> sScenarios;
+	static InputConfig*          sInputConfig;
+	static Window*               sWindow;
+	static bool                  sActive;
+	static size_t                sScenario;
+	static size_t                sStep;
+	static double                sStepTime;
+	static double                sFrameTime;
+	static double                sSampleTime;
+	static unsigned int          sDrawCalls; // the renderer's totals at the last frame
+	static unsigned int          sVertices;
+	static std::string           sThemeSet;
+	static std::string           sViewStyle;
+
+}; // UIBenchmark
+
+#endif // ES_APP_UI_BENCHMARK_H
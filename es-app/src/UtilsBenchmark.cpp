@@ -0,0 +1,166 @@
+#include "UtilsBenchmark.h"
+
+#include "utils/FileSystemUtil.h"
+#include "utils/StringUtil.h"
+#include "utils/TimeUtil.h"
+#include <chrono>
+#include <iomanip>
+#include <iostream>
+#include <string>
+#include <vector>
+
+// calls per helper, enough for the clock to not matter on a Raspberry Pi and still be quick on a desktop
+static const size_t ITERATIONS = 200000;
+
+// what the helpers return is added up here, so the compiler can't drop the calls
+static volatile size_t sSink = 0;
+
+static const std::vector<std::string> sNames =
+{
+	"Super Mario Bros. 3 (USA) (Rev A)",
+	"Legend of Zelda, The - A Link to the Past (Europe)",
+	"Pok\xC3\xA9mon - Edici\xC3\xB3n Azul (Spain)",
+	"\xE3\x83\x89\xE3\x83\xA9\xE3\x82\xB4\xE3\x83\xB3\xE3\x82\xAF\xE3\x82\xA8\xE3\x82\xB9\xE3\x83\x88 III (Japan)",
+	"Street Fighter II' - Special Champion Edition (USA)",
+};
+
+static const std::vector<std::string> sPaths =
+{
+	"/home/pi/RetroPie/roms/snes/Super Mario World (USA).sfc",
+	"/home/pi/RetroPie/roms/megadrive/Sonic The Hedgehog 2 (World) (Rev A).md",
+	"C:\\Users\\pi\\RetroPie\\roms\\nes\\subfolder\\..\\Mega Man 2 (USA).nes",
+	"/home/pi/RetroPie/roms/psx/./Final Fantasy VII (USA) (Disc 1).cue",
+};
+
+static const std::vector<std::string> sRelativePaths =
+{
+	"./Super Mario World (USA).sfc",
+	"./media/images/Sonic The Hedgehog 2 (World) (Rev A).png",
+	"~/.emulationstation/downloaded_images/nes/Mega Man 2 (USA)-image.jpg",
+	"/home/pi/RetroPie/roms/psx/Final Fantasy VII (USA) (Disc 1).cue",
+};
+
+static const std::vector<std::string> sDates =
+{
+	"19900101T000000",
+	"19960623T000000",
+	"20011121T120000",
+	"not-a-date-time",
+};
+
+template<typename T>
+static void measure(const char* _name, T _function)
+{
+	const std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+
+	for(size_t i = 0; i < ITERATIONS; ++i)
+		sSink = sSink + _function(i);
+
+	const double nanoseconds = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count();
+
+	std::cout << "   " << std::left << std::setw(36) << _name << std::right << std::setw(10) << (nanoseconds / ITERATIONS) << " ns\n";
+
+} // measure
+
+int UtilsBenchmark::run()
+{
+	std::cout << std::fixed << std::setprecision(1);
+	std::cout << "Utils benchmark, " << ITERATIONS << " calls each\n";
+
+	measure("String::toUpper", [](const size_t _i)
+	{
+		return Utils::String::toUpper(sNames[_i % sNames.size()]).size();
+	});
+
+	measure("String::toLower", [](const size_t _i)
+	{
+		return Utils::String::toLower(sNames[_i % sNames.size()]).size();
+	});
+
+	measure("String::replace", [](const size_t _i)
+	{
+		return Utils::String::replace(sPaths[_i % sPaths.size()], "\\", "/").size();
+	});
+
+	measure("String::trim", [](const size_t _i)
+	{
+		return Utils::String::trim(sNames[_i % sNames.size()]).size();
+	});
+
+	measure("String::nextCursor (whole string)", [](const size_t _i)
+	{
+		const std::string& name   = sNames[_i % sNames.size()];
+		size_t             cursor = 0;
+		size_t             count  = 0;
+
+		while(cursor < name.size())
+		{
+			cursor = Utils::String::nextCursor(name, cursor);
+			++count;
+		}
+
+		return count;
+	});
+
+	measure("String::chars2Unicode (whole string)", [](const size_t _i)
+	{
+		const std::string& name   = sNames[_i % sNames.size()];
+		size_t             cursor = 0;
+		size_t             sum    = 0;
+
+		while(cursor < name.size())
+			sum += Utils::String::chars2Unicode(name, cursor);
+
+		return sum;
+	});
+
+	measure("FileSystem::getGenericPath", [](const size_t _i)
+	{
+		return Utils::FileSystem::getGenericPath(sPaths[_i % sPaths.size()]).size();
+	});
+
+	measure("FileSystem::getFileName", [](const size_t _i)
+	{
+		return Utils::FileSystem::getFileName(sPaths[_i % sPaths.size()]).size();
+	});
+
+	measure("FileSystem::getExtension", [](const size_t _i)
+	{
+		return Utils::FileSystem::getExtension(sPaths[_i % sPaths.size()]).size();
+	});
+
+	measure("FileSystem::getExtensionView", [](const size_t _i)
+	{
+		return Utils::FileSystem::getExtensionView(sPaths[_i % sPaths.size()]).size();
+	});
+
+	// directory checks are skipped, the disk would be timed instead of the helpers
+	measure("FileSystem::resolveRelativePath", [](const size_t _i)
+	{
+		return Utils::FileSystem::resolveRelativePath(sRelativePaths[_i % sRelativePaths.size()], "/home/pi/RetroPie/roms/snes", true, true).size();
+	});
+
+	measure("FileSystem::removeCommonPath", [](const size_t _i)
+	{
+		bool contains = false;
+		return Utils::FileSystem::removeCommonPath(sPaths[_i % sPaths.size()], "/home/pi/RetroPie/roms/", contains, true).size() + contains;
+	});
+
+	measure("Time::stringToTime", [](const size_t _i)
+	{
+		return (size_t)Utils::Time::stringToTime(sDates[_i % sDates.size()]);
+	});
+
+	measure("Time::DateTime(string)", [](const size_t _i)
+	{
+		return (size_t)Utils::Time::DateTime(sDates[_i % sDates.size()]).getTime();
+	});
+
+	measure("Time::timeToString", [](const size_t _i)
+	{
+		return Utils::Time::timeToString((time_t)(_i * 86400)).size();
+	});
+
+	return 0;
+
+} // run
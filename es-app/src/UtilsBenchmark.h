@@ -0,0 +1,16 @@
+#pragma once
+#ifndef ES_APP_UTILS_BENCHMARK_H
+#define ES_APP_UTILS_BENCHMARK_H
+
+// Times the string, path and date helpers that loading and sorting call for every game, on fixed input, so a
+// change to one of them can be compared against the numbers from before it
+class UtilsBenchmark
+{
+public:
+
+	// Prints the time per call of each helper, returns the exit code
+	static int run();
+
+}; // UtilsBenchmark
+
+#endif // ES_APP_UTILS_BENCHMARK_H
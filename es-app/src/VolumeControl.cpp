@@ -28,11 +28,14 @@ VolumeControl::VolumeControl()
 #elif defined(WIN32) || defined(_WIN32)
 	, mixerHandle(nullptr), endpointVolume(nullptr)
 #endif
+	, pendingVolume(-1), workerExit(false)
 {
 	init();
 
 	//get original volume levels for system
 	originalVolume = getVolume();
+
+	workerThread = std::thread(&VolumeControl::threadProc, this);
 }
 
 VolumeControl::VolumeControl(const VolumeControl & right):
@@ -44,6 +47,7 @@ VolumeControl::VolumeControl(const VolumeControl & right):
 #elif defined(WIN32) || defined(_WIN32)
 	, mixerHandle(nullptr), endpointVolume(nullptr)
 #endif
+	, pendingVolume(-1), workerExit(false)
 {
 	(void)right;
 	sInstance = right.sInstance;
@@ -63,6 +67,13 @@ VolumeControl::~VolumeControl()
 	//set original volume levels for system
 	//setVolume(originalVolume);
 
+	{
+		std::unique_lock<std::mutex> lock(workerMutex);
+		workerExit = true;
+	}
+	workerEvent.notify_one();
+	workerThread.join();
+
 	deinit();
 }
 
@@ -78,6 +89,93 @@ std::shared_ptr<VolumeControl> & VolumeControl::getInstance()
 }
 
 void VolumeControl::init()
+{
+	std::unique_lock<std::mutex> lock(mixerMutex);
+
+	openMixer();
+	internalVolume = readVolume();
+}
+
+void VolumeControl::deinit()
+{
+	std::unique_lock<std::mutex> lock(mixerMutex);
+
+	//a change the worker didn't get to yet is applied before the mixer goes away
+	{
+		std::unique_lock<std::mutex> workerLock(workerMutex);
+		if (pendingVolume != -1)
+		{
+			writeVolume(pendingVolume);
+			pendingVolume = -1;
+		}
+	}
+
+	closeMixer();
+}
+
+int VolumeControl::getVolume() const
+{
+	return internalVolume;
+}
+
+void VolumeControl::setVolume(int volume)
+{
+	//clamp to 0-100 range
+	if (volume < 0)
+	{
+		volume = 0;
+	}
+	if (volume > 100)
+	{
+		volume = 100;
+	}
+	//store values in internal variables
+	internalVolume = volume;
+
+	{
+		std::unique_lock<std::mutex> lock(workerMutex);
+		pendingVolume = volume;
+	}
+	workerEvent.notify_one();
+}
+
+void VolumeControl::threadProc()
+{
+#if defined(WIN32) || defined(_WIN32)
+	CoInitialize(nullptr);
+#endif
+
+	while (true)
+	{
+		int volume;
+
+		{
+			std::unique_lock<std::mutex> lock(workerMutex);
+			workerEvent.wait(lock, [this] { return workerExit || (pendingVolume != -1); });
+
+			if (workerExit)
+				break;
+
+			volume = pendingVolume;
+		}
+
+		{
+			std::unique_lock<std::mutex> lock(mixerMutex);
+			writeVolume(volume);
+		}
+
+		//done unless the volume changed again while the mixer was set
+		std::unique_lock<std::mutex> lock(workerMutex);
+		if (pendingVolume == volume)
+			pendingVolume = -1;
+	}
+
+#if defined(WIN32) || defined(_WIN32)
+	CoUninitialize();
+#endif
+}
+
+void VolumeControl::openMixer()
 {
 	//initialize audio mixer interface
 #if defined (__APPLE__)
@@ -97,57 +195,57 @@ void VolumeControl::init()
 		//open mixer
 		if (snd_mixer_open(&mixerHandle, 0) >= 0)
 		{
-			LOG(LogDebug) << "VolumeControl::init() - Opened ALSA mixer";
+			LOG(LogDebug) << "VolumeControl::openMixer() - Opened ALSA mixer";
 			//ok. attach to defualt card
 			if (snd_mixer_attach(mixerHandle, mixerCard) >= 0)
 			{
-				LOG(LogDebug) << "VolumeControl::init() - Attached to default card";
+				LOG(LogDebug) << "VolumeControl::openMixer() - Attached to default card";
 				//ok. register simple element class
 				if (snd_mixer_selem_register(mixerHandle, NULL, NULL) >= 0)
 				{
-					LOG(LogDebug) << "VolumeControl::init() - Registered simple element class";
+					LOG(LogDebug) << "VolumeControl::openMixer() - Registered simple element class";
 					//ok. load registered elements
 					if (snd_mixer_load(mixerHandle) >= 0)
 					{
-						LOG(LogDebug) << "VolumeControl::init() - Loaded mixer elements";
+						LOG(LogDebug) << "VolumeControl::openMixer() - Loaded mixer elements";
 						//ok. find elements now
 						mixerElem = snd_mixer_find_selem(mixerHandle, mixerSelemId);
 						if (mixerElem != nullptr)
 						{
 							//wohoo. good to go...
-							LOG(LogDebug) << "VolumeControl::init() - Mixer initialized";
+							LOG(LogDebug) << "VolumeControl::openMixer() - Mixer initialized";
 						}
 						else
 						{
-							LOG(LogError) << "VolumeControl::init() - Failed to find mixer elements!";
+							LOG(LogError) << "VolumeControl::openMixer() - Failed to find mixer elements!";
 							snd_mixer_close(mixerHandle);
 							mixerHandle = nullptr;
 						}
 					}
 					else
 					{
-						LOG(LogError) << "VolumeControl::init() - Failed to load mixer elements!";
+						LOG(LogError) << "VolumeControl::openMixer() - Failed to load mixer elements!";
 						snd_mixer_close(mixerHandle);
 						mixerHandle = nullptr;
 					}
 				}
 				else
 				{
-					LOG(LogError) << "VolumeControl::init() - Failed to register simple element class!";
+					LOG(LogError) << "VolumeControl::openMixer() - Failed to register simple element class!";
 					snd_mixer_close(mixerHandle);
 					mixerHandle = nullptr;
 				}
 			}
 			else
 			{
-				LOG(LogError) << "VolumeControl::init() - Failed to attach to default card!";
+				LOG(LogError) << "VolumeControl::openMixer() - Failed to attach to default card!";
 				snd_mixer_close(mixerHandle);
 				mixerHandle = nullptr;
 			}
 		}
 		else
 		{
-			LOG(LogError) << "VolumeControl::init() - Failed to open ALSA mixer!";
+			LOG(LogError) << "VolumeControl::openMixer() - Failed to open ALSA mixer!";
 		}
 	}
 #elif defined(WIN32) || defined(_WIN32)
@@ -173,14 +271,14 @@ void VolumeControl::init()
 				mixerLineControls.cbmxctrl = sizeof(MIXERCONTROL);
 				if (mixerGetLineControls((HMIXEROBJ)mixerHandle, &mixerLineControls, MIXER_GETLINECONTROLSF_ONEBYTYPE) != MMSYSERR_NOERROR)
 				{
-					LOG(LogError) << "VolumeControl::init() - Failed to get mixer volume control!";
+					LOG(LogError) << "VolumeControl::openMixer() - Failed to get mixer volume control!";
 					mixerClose(mixerHandle);
 					mixerHandle = nullptr;
 				}
 			}
 			else
 			{
-				LOG(LogError) << "VolumeControl::init() - Failed to open mixer!";
+				LOG(LogError) << "VolumeControl::openMixer() - Failed to open mixer!";
 			}
 		}
 	}
@@ -203,21 +301,21 @@ void VolumeControl::init()
 					defaultDevice->Activate(__uuidof(IAudioEndpointVolume), CLSCTX_INPROC_SERVER, nullptr, (LPVOID *)&endpointVolume);
 					if (endpointVolume == nullptr)
 					{
-						LOG(LogError) << "VolumeControl::init() - Failed to get default audio endpoint volume!";
+						LOG(LogError) << "VolumeControl::openMixer() - Failed to get default audio endpoint volume!";
 					}
 					//release default device. we don't need it anymore
 					defaultDevice->Release();
 				}
 				else
 				{
-					LOG(LogError) << "VolumeControl::init() - Failed to get default audio endpoint!";
+					LOG(LogError) << "VolumeControl::openMixer() - Failed to get default audio endpoint!";
 				}
 				//release device enumerator. we don't need it anymore
 				deviceEnumerator->Release();
 			}
 			else
 			{
-				LOG(LogError) << "VolumeControl::init() - Failed to get audio endpoint enumerator!";
+				LOG(LogError) << "VolumeControl::openMixer() - Failed to get audio endpoint enumerator!";
 				CoUninitialize();
 			}
 		}
@@ -225,7 +323,7 @@ void VolumeControl::init()
 #endif
 }
 
-void VolumeControl::deinit()
+void VolumeControl::closeMixer()
 {
 	//deinitialize audio mixer interface
 #if defined (__APPLE__)
@@ -251,7 +349,7 @@ void VolumeControl::deinit()
 #endif
 }
 
-int VolumeControl::getVolume() const
+int VolumeControl::readVolume() const
 {
 	int volume = 0;
 
@@ -279,12 +377,12 @@ int VolumeControl::getVolume() const
 			}
 			else
 			{
-				LOG(LogError) << "VolumeControl::getVolume() - Failed to get mixer volume!";
+				LOG(LogError) << "VolumeControl::readVolume() - Failed to get mixer volume!";
 			}
 		}
 		else
 		{
-			LOG(LogError) << "VolumeControl::getVolume() - Failed to get volume range!";
+			LOG(LogError) << "VolumeControl::readVolume() - Failed to get volume range!";
 		}
 	}
 #elif defined(WIN32) || defined(_WIN32)
@@ -305,7 +403,7 @@ int VolumeControl::getVolume() const
 		}
 		else
 		{
-			LOG(LogError) << "VolumeControl::getVolume() - Failed to get mixer volume!";
+			LOG(LogError) << "VolumeControl::readVolume() - Failed to get mixer volume!";
 		}
 	}
 	else if (endpointVolume != nullptr)
@@ -319,7 +417,7 @@ int VolumeControl::getVolume() const
 		}
 		else
 		{
-			LOG(LogError) << "VolumeControl::getVolume() - Failed to get master volume!";
+			LOG(LogError) << "VolumeControl::readVolume() - Failed to get master volume!";
 		}
 
 	}
@@ -336,19 +434,8 @@ int VolumeControl::getVolume() const
 	return volume;
 }
 
-void VolumeControl::setVolume(int volume)
+void VolumeControl::writeVolume(int volume)
 {
-	//clamp to 0-100 range
-	if (volume < 0)
-	{
-		volume = 0;
-	}
-	if (volume > 100)
-	{
-		volume = 100;
-	}
-	//store values in internal variables
-	internalVolume = volume;
 #if defined (__APPLE__)
 	#error TODO: Not implemented for MacOS yet!!!
 #elif defined(__linux__)
@@ -364,12 +451,12 @@ void VolumeControl::setVolume(int volume)
 			if (snd_mixer_selem_set_playback_volume(mixerElem, SND_MIXER_SCHN_FRONT_LEFT, rawVolume) < 0
 				|| snd_mixer_selem_set_playback_volume(mixerElem, SND_MIXER_SCHN_FRONT_RIGHT, rawVolume) < 0)
 			{
-				LOG(LogError) << "VolumeControl::setVolume() - Failed to set mixer volume!";
+				LOG(LogError) << "VolumeControl::writeVolume() - Failed to set mixer volume!";
 			}
 		}
 		else
 		{
-			LOG(LogError) << "VolumeControl::setVolume() - Failed to get volume range!";
+			LOG(LogError) << "VolumeControl::writeVolume() - Failed to get volume range!";
 		}
 	}
 #elif defined(WIN32) || defined(_WIN32)
@@ -387,7 +474,7 @@ void VolumeControl::setVolume(int volume)
 		mixerControlDetails.cbDetails = sizeof(MIXERCONTROLDETAILS_UNSIGNED);
 		if (mixerSetControlDetails((HMIXEROBJ)mixerHandle, &mixerControlDetails, MIXER_SETCONTROLDETAILSF_VALUE) != MMSYSERR_NOERROR)
 		{
-			LOG(LogError) << "VolumeControl::setVolume() - Failed to set mixer volume!";
+			LOG(LogError) << "VolumeControl::writeVolume() - Failed to set mixer volume!";
 		}
 	}
 	else if (endpointVolume != nullptr)
@@ -399,7 +486,7 @@ void VolumeControl::setVolume(int volume)
 		}
 		if (endpointVolume->SetMasterVolumeLevelScalar(floatVolume, nullptr) != S_OK)
 		{
-			LOG(LogError) << "VolumeControl::setVolume() - Failed to set master volume!";
+			LOG(LogError) << "VolumeControl::writeVolume() - Failed to set master volume!";
 		}
 	}
 #endif
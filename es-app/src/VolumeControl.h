@@ -2,7 +2,11 @@
 #ifndef ES_APP_VOLUME_CONTROL_H
 #define ES_APP_VOLUME_CONTROL_H
 
+#include <atomic>
+#include <condition_variable>
 #include <memory>
+#include <mutex>
+#include <thread>
 
 #if defined (__APPLE__)
     #error TODO: Not implemented for MacOS yet!!!
@@ -18,6 +22,8 @@
 
 /*!
 Singleton pattern. Call getInstance() to get an object.
+The mixer can take a while to answer, so changes are applied by a worker thread and getVolume() returns the last
+volume read or set instead of asking the mixer again.
 */
 class VolumeControl
 {
@@ -37,7 +43,15 @@ class VolumeControl
 #endif
 
 	int originalVolume;
-	int internalVolume;
+	std::atomic<int> internalVolume;
+
+	// mixerMutex guards the mixer handles, workerMutex the volume waiting for the worker (-1 for none)
+	std::mutex mixerMutex;
+	std::mutex workerMutex;
+	std::condition_variable workerEvent;
+	std::thread workerThread;
+	int pendingVolume;
+	bool workerExit;
 
 	static std::weak_ptr<VolumeControl> sInstance;
 
@@ -45,6 +59,14 @@ class VolumeControl
 	VolumeControl(const VolumeControl & right);
     VolumeControl & operator=(const VolumeControl & right);
 
+	void threadProc();
+
+	// These talk to the mixer and expect mixerMutex to be locked
+	void openMixer();
+	void closeMixer();
+	int readVolume() const;
+	void writeVolume(int volume);
+
 public:
 	static std::shared_ptr<VolumeControl> & getInstance();
 
@@ -52,6 +74,8 @@ public:
 	void deinit();
 
 	int getVolume() const;
+
+	// Returns right away, the mixer is set in the background. Only the latest of several quick changes is applied
 	void setVolume(int volume);
 
 	~VolumeControl();
@@ -5,8 +5,8 @@
 
 RatingComponent::RatingComponent(Window* window) : GuiComponent(window), mColorShift(0xFFFFFFFF)
 {
-	mFilledTexture = TextureResource::get(":/star_filled.svg", true);
-	mUnfilledTexture = TextureResource::get(":/star_unfilled.svg", true);
+	mFilledTexture = TextureResource::get(":/star_filled.svg");
+	mUnfilledTexture = TextureResource::get(":/star_unfilled.svg");
 	mValue = 0.5f;
 	mSize = Vector2f(64 * NUM_RATING_STARS, 64);
 	updateVertices();
@@ -73,23 +73,36 @@ void RatingComponent::updateVertices()
 {
 	const float numStars = NUM_RATING_STARS;
 	const float h        = getSize().y(); // is the same as a single star's width
-	const float w        = getSize().y() * mValue * numStars;
-	const float fw       = getSize().y() * numStars;
+	const float filled   = mValue * numStars;
 
-	mVertices[0] = { { 0.0f, 0.0f }, { 0.0f,              1.0f }, 0 };
-	mVertices[1] = { { 0.0f, h    }, { 0.0f,              0.0f }, 0 };
-	mVertices[2] = { { w,    0.0f }, { mValue * numStars, 1.0f }, 0 };
-	mVertices[3] = { { w,    h    }, { mValue * numStars, 0.0f }, 0 };
-
-	mVertices[4] = { { 0.0f, 0.0f }, { 0.0f,              1.0f }, 0 };
-	mVertices[5] = { { 0.0f, h    }, { 0.0f,              0.0f }, 0 };
-	mVertices[6] = { { fw,   0.0f }, { numStars,          1.0f }, 0 };
-	mVertices[7] = { { fw,   h    }, { numStars,          0.0f }, 0 };
+	// a quad per star, the last filled one cut off where the value ends
+	mFilledStars = 0;
+	for(int i = 0; i < NUM_RATING_STARS; ++i)
+	{
+		const float x = h * i;
+
+		Renderer::Vertex* unfilled = &mVertices[(NUM_RATING_STARS + i) * 4];
+		unfilled[0] = { { x,     0.0f }, { 0.0f, 1.0f }, 0 };
+		unfilled[1] = { { x,     h    }, { 0.0f, 0.0f }, 0 };
+		unfilled[2] = { { x + h, 0.0f }, { 1.0f, 1.0f }, 0 };
+		unfilled[3] = { { x + h, h    }, { 1.0f, 0.0f }, 0 };
+
+		const float part = Math::min(filled - i, 1.0f);
+		if(part > 0.0f)
+		{
+			Renderer::Vertex* star = &mVertices[i * 4];
+			star[0] = { { x,            0.0f }, { 0.0f, 1.0f }, 0 };
+			star[1] = { { x,            h    }, { 0.0f, 0.0f }, 0 };
+			star[2] = { { x + h * part, 0.0f }, { part, 1.0f }, 0 };
+			star[3] = { { x + h * part, h    }, { part, 0.0f }, 0 };
+			mFilledStars++;
+		}
+	}
 
 	updateColors();
 
 	// round vertices
-	for(int i = 0; i < 8; ++i)
+	for(int i = 0; i < NUM_RATING_STARS * 2 * 4; ++i)
 		mVertices[i].pos.round();
 }
 
@@ -98,7 +111,7 @@ void RatingComponent::updateColors()
 	const float        opacity = mOpacity / 255.0;
 	const unsigned int color   = Renderer::convertColor(mColorShift & 0xFFFFFF00 | (unsigned char)((mColorShift & 0xFF) * opacity));
 
-	for(int i = 0; i < 8; ++i)
+	for(int i = 0; i < NUM_RATING_STARS * 2 * 4; ++i)
 		mVertices[i].col = color;
 }
 
@@ -110,11 +123,14 @@ void RatingComponent::render(const Transform4x4f& parentTrans)
 	Transform4x4f trans = parentTrans * getTransform();
 	Renderer::setMatrix(trans);
 
+	// small stars share a texture of the atlas, the stars of every rating on screen end up in one batch
 	mUnfilledTexture->bind();
-	Renderer::drawTriangleStrips(&mVertices[4], 4);
+	for(int i = 0; i < NUM_RATING_STARS; ++i)
+		Renderer::drawTriangleStrips(&mVertices[(NUM_RATING_STARS + i) * 4], 4);
 
 	mFilledTexture->bind();
-	Renderer::drawTriangleStrips(&mVertices[0], 4);
+	for(int i = 0; i < mFilledStars; ++i)
+		Renderer::drawTriangleStrips(&mVertices[i * 4], 4);
 
 	renderChildren(trans);
 }
@@ -146,12 +162,12 @@ void RatingComponent::applyTheme(const std::shared_ptr<ThemeData>& theme, const
 	bool imgChanged = false;
 	if(properties & PATH && elem->has("filledPath"))
 	{
-		mFilledTexture = TextureResource::get(elem->get<std::string>("filledPath"), true);
+		mFilledTexture = TextureResource::get(elem->get<std::string>("filledPath"));
 		imgChanged = true;
 	}
 	if(properties & PATH && elem->has("unfilledPath"))
 	{
-		mUnfilledTexture = TextureResource::get(elem->get<std::string>("unfilledPath"), true);
+		mUnfilledTexture = TextureResource::get(elem->get<std::string>("unfilledPath"));
 		imgChanged = true;
 	}
 
@@ -42,7 +42,8 @@ private:
 
 	float mValue;
 
-	Renderer::Vertex mVertices[8];
+	Renderer::Vertex mVertices[NUM_RATING_STARS * 2 * 4]; // the filled stars, then the unfilled ones
+	int mFilledStars;
 
 	unsigned int mColorShift;
 
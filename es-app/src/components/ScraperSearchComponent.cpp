@@ -433,7 +433,7 @@ void ScraperSearchComponent::updateThumbnail()
 {
 	if(mThumbnailReq && mThumbnailReq->status() == HttpReq::REQ_SUCCESS)
 	{
-		std::string content = mThumbnailReq->getContent();
+		const std::string& content = mThumbnailReq->getContent();
 		mResultThumbnail->setImage(content.data(), content.length());
 		mGrid.onSizeChanged(); // a hack to fix the thumbnail position since its size changed
 	}else{
@@ -4,6 +4,7 @@
 
 #include "components/IList.h"
 #include "math/Misc.h"
+#include "renderers/Renderer.h"
 #include "utils/StringUtil.h"
 #include "Log.h"
 #include "Settings.h"
@@ -15,7 +16,8 @@ class TextCache;
 struct TextListData
 {
 	unsigned int colorId;
-	std::shared_ptr<TextCache> textCache;
+	std::shared_ptr<TextCache> textCache; // only kept for rows on or near the screen
+	unsigned int textCacheColor;
 };
 
 //A graphical list. Supports multiple colors for rows and scrolling.
@@ -42,6 +44,7 @@ public:
 	static constexpr int REFRESH_LIST_CURSOR_POS = -1;
 
 	TextListComponent(Window* window);
+	~TextListComponent();
 
 	bool input(InputConfig* config, Input input) override;
 	void update(int deltaTime) override;
@@ -49,6 +52,8 @@ public:
 	void applyTheme(const std::shared_ptr<ThemeData>& theme, const std::string& view, const std::string& element, unsigned int properties) override;
 
 	void add(const std::string& name, const T& obj, unsigned int colorId);
+	// the row add() would append, for updateEntries()
+	static typename IList<TextListData, T>::Entry makeEntry(const std::string& name, const T& obj, unsigned int colorId);
 
 	enum Alignment
 	{
@@ -92,6 +97,24 @@ private:
 	int mMarqueeOffset;
 	int mMarqueeOffset2;
 	int mMarqueeTime;
+	float mMarqueeLength; // the text and the gap before it repeats
+
+	// The scrolling row is drawn into a texture once, followed by as much of its start again as fits on the row, each
+	// frame then draws one quad of it with the texture coordinates moved along. False where the renderer can't draw
+	// into textures or trans scales or rotates, the row is drawn directly then
+	bool renderMarquee(const Transform4x4f& trans, const Vector3f& offset, TextCache* textCache, const std::string& text, unsigned int color);
+	void releaseMarquee();
+	unsigned int mMarqueeTexture = 0;
+	unsigned int mMarqueeTarget = 0;
+	int mMarqueeWidth = 0;
+	int mMarqueeHeight = 0;
+	unsigned int mMarqueeContextCount = 0;
+	bool mMarqueeFailed = false;
+	std::string mMarqueeText; // what's in the texture, drawn again once the row or its color changes
+	unsigned int mMarqueeColor = 0;
+	const Font* mMarqueeFont = nullptr;
+	float mMarqueeTextLength = 0;
+	uint64_t mMarqueeVersion = 0;
 
 	Alignment mAlignment;
 	float mHorizontalMargin;
@@ -114,6 +137,11 @@ private:
 	int mViewportHeight;
 	int mCursorPrev = -1;
 
+	// rows that keep their text cache, the visible ones and a screen above and below them
+	void releaseTextCaches(int first, int last);
+	int mCachedTop = 0;
+	int mCachedBottom = 0;
+
 	ImageComponent mSelectorImage;
 };
 
@@ -124,6 +152,7 @@ TextListComponent<T>::TextListComponent(Window* window) :
 	mMarqueeOffset = 0;
 	mMarqueeOffset2 = 0;
 	mMarqueeTime = 0;
+	mMarqueeLength = 0;
 
 	mHorizontalMargin = 0;
 	mAlignment = ALIGN_CENTER;
@@ -141,6 +170,12 @@ TextListComponent<T>::TextListComponent(Window* window) :
 	mColors[1] = 0x00FF00FF;
 }
 
+template <typename T>
+TextListComponent<T>::~TextListComponent()
+{
+	releaseMarquee();
+}
+
 template <typename T>
 void TextListComponent<T>::render(const Transform4x4f& parentTrans)
 {
@@ -172,6 +207,17 @@ void TextListComponent<T>::render(const Transform4x4f& parentTrans)
 	if(listCutoff > size())
 		listCutoff = size();
 
+	// rows that scrolled far enough away give up their text cache, so a long list only ever holds a few screens of them
+	const int cachedTop = Math::max(mViewportTop - mViewportHeight, 0);
+	const int cachedBottom = Math::min((int)listCutoff + mViewportHeight, size());
+	if((cachedTop != mCachedTop) || (cachedBottom != mCachedBottom))
+	{
+		releaseTextCaches(mCachedTop, Math::min(mCachedBottom, cachedTop));
+		releaseTextCaches(Math::max(mCachedTop, cachedBottom), mCachedBottom);
+		mCachedTop = cachedTop;
+		mCachedBottom = cachedBottom;
+	}
+
 	float y = (mSize.y() - (mViewportHeight * entrySize)) * 0.5f;
 
 	if (mSelectorImage.hasImage()) {
@@ -200,9 +246,17 @@ void TextListComponent<T>::render(const Transform4x4f& parentTrans)
 			color = mColors[entry.data.colorId];
 
 		if(!entry.data.textCache)
-			entry.data.textCache = std::unique_ptr<TextCache>(font->buildTextCache(mUppercase ? Utils::String::toUpper(entry.name) : entry.name, 0, 0, 0x000000FF));
+		{
+			entry.data.textCache = std::unique_ptr<TextCache>(font->buildTextCache(mUppercase ? Utils::String::toUpper(entry.name) : entry.name, 0, 0, color));
+			entry.data.textCacheColor = color;
+		}
 
-		entry.data.textCache->setColor(color);
+		// only the rows the cursor enters or leaves change color
+		if(entry.data.textCacheColor != color)
+		{
+			entry.data.textCache->setColor(color);
+			entry.data.textCacheColor = color;
+		}
 
 		Vector3f offset(0, y, 0);
 
@@ -224,6 +278,13 @@ void TextListComponent<T>::render(const Transform4x4f& parentTrans)
 			break;
 		}
 
+		// currently selected item text might be scrolling, that's one quad of the marquee texture if it can be
+		if((mCursor == i) && (mMarqueeOffset > 0) && renderMarquee(trans, offset, entry.data.textCache.get(), entry.name, color))
+		{
+			y += entrySize;
+			continue;
+		}
+
 		// render text
 		Transform4x4f drawTrans = trans;
 
@@ -257,6 +318,119 @@ void TextListComponent<T>::render(const Transform4x4f& parentTrans)
 }
 
 
+template <typename T>
+void TextListComponent<T>::releaseTextCaches(int first, int last)
+{
+	// the list may have shrunk since the rows were cached
+	last = Math::min(last, size());
+
+	for(int i = Math::max(first, 0); i < last; i++)
+		mEntries.at((unsigned int)i).data.textCache.reset();
+}
+
+template <typename T>
+bool TextListComponent<T>::renderMarquee(const Transform4x4f& trans, const Vector3f& offset, TextCache* textCache, const std::string& text, unsigned int color)
+{
+	const float limit      = mSize.x() - mHorizontalMargin * 2;
+	const int   width      = (int)Math::ceilf(mMarqueeLength + limit);
+	const int   height     = (int)Math::ceilf(textCache->metrics.size.y());
+	const bool  translated = (trans.r0() == Vector4f(1, 0, 0, 0)) && (trans.r1() == Vector4f(0, 1, 0, 0)) && (trans.r2() == Vector4f(0, 0, 1, 0));
+
+	// the renderer was started again since, the texture and target went with the old context
+	if((mMarqueeTarget != 0) && (mMarqueeContextCount != Renderer::getContextCount()))
+	{
+		mMarqueeTexture = 0;
+		mMarqueeTarget  = 0;
+		mMarqueeText.clear();
+	}
+
+	// a texture much larger than the screen costs more memory than the draws it saves
+	if(!translated || mMarqueeFailed || (limit <= 0) || (height <= 0) || (width > Renderer::getScreenWidth() * 2))
+		return false;
+
+	// kept for the next rows as long as they fit, rounded up so most names of a list do
+	if((width > mMarqueeWidth) || (height != mMarqueeHeight))
+	{
+		releaseMarquee();
+
+		mMarqueeWidth        = ((width + 127) / 128) * 128;
+		mMarqueeHeight       = height;
+		mMarqueeTexture      = Renderer::createTexture(Renderer::Texture::RGBA, false, false, false, mMarqueeWidth, mMarqueeHeight, nullptr);
+		mMarqueeTarget       = Renderer::createRenderTarget(mMarqueeTexture);
+		mMarqueeContextCount = Renderer::getContextCount();
+
+		// not tried again for this list
+		if(mMarqueeTarget == 0)
+		{
+			Renderer::destroyTexture(mMarqueeTexture);
+			mMarqueeTexture = 0;
+			mMarqueeFailed  = true;
+			return false;
+		}
+	}
+
+	// glyphs already in the font texture never move, only the row, its color or the loop can change what's drawn
+	if((text != mMarqueeText) || (color != mMarqueeColor) || (mFont.get() != mMarqueeFont) || (mMarqueeLength != mMarqueeTextLength))
+	{
+		Renderer::beginRenderTarget(mMarqueeTarget, mMarqueeWidth, mMarqueeHeight);
+
+		Transform4x4f local = Transform4x4f::Identity();
+		Renderer::setMatrix(local);
+		mFont->renderTextCache(textCache);
+
+		local.translate(Vector3f(Math::floorf(mMarqueeLength), 0, 0));
+		Renderer::setMatrix(local);
+		mFont->renderTextCache(textCache);
+
+		Renderer::endRenderTarget();
+
+		mMarqueeText       = text;
+		mMarqueeColor      = color;
+		mMarqueeFont       = mFont.get();
+		mMarqueeTextLength = mMarqueeLength;
+		++mMarqueeVersion;
+	}
+
+	const float x  = offset.x();
+	const float y  = offset.y();
+	const float u0 = (float)mMarqueeOffset / mMarqueeWidth;
+	const float u1 = ((float)mMarqueeOffset + limit) / mMarqueeWidth;
+	const float v1 = (float)height / mMarqueeHeight;
+
+	// the alpha of the texture is premultiplied
+	const Renderer::Vertex vertices[4] =
+	{
+		{ { x,         y                 }, { u0, 0.0f }, 0xFFFFFFFF },
+		{ { x,         y + (float)height }, { u0, v1   }, 0xFFFFFFFF },
+		{ { x + limit, y                 }, { u1, 0.0f }, 0xFFFFFFFF },
+		{ { x + limit, y + (float)height }, { u1, v1   }, 0xFFFFFFFF }
+	};
+
+	// the same quad can show another row once the texture was drawn again
+	Renderer::setMatrix(trans);
+	Renderer::bindTexture(mMarqueeTexture);
+	Renderer::hashFrameState(&mMarqueeVersion, sizeof(mMarqueeVersion));
+	Renderer::drawTriangleStrips(vertices, 4, Renderer::Blend::ONE, Renderer::Blend::ONE_MINUS_SRC_ALPHA);
+
+	return true;
+}
+
+template <typename T>
+void TextListComponent<T>::releaseMarquee()
+{
+	if((mMarqueeTarget != 0) && (mMarqueeContextCount == Renderer::getContextCount()))
+	{
+		Renderer::destroyRenderTarget(mMarqueeTarget);
+		Renderer::destroyTexture(mMarqueeTexture);
+	}
+
+	mMarqueeTexture = 0;
+	mMarqueeTarget  = 0;
+	mMarqueeWidth   = 0;
+	mMarqueeHeight  = 0;
+	mMarqueeText.clear();
+}
+
 template <typename T>
 int TextListComponent<T>::viewportTop()
 {
@@ -335,8 +509,9 @@ void TextListComponent<T>::update(int deltaTime)
 		mMarqueeOffset2 = 0;
 
 		// if we're not scrolling and this object's text goes outside our size, marquee it!
-		auto name = mEntries.at((unsigned int)mCursor).name;
-		const float textLength = mFont->sizeText(mUppercase ? Utils::String::toUpper(name) : name).x();
+		const TextListData& data = mEntries.at((unsigned int)mCursor).data;
+		const std::string& name = mEntries.at((unsigned int)mCursor).name;
+		const float textLength = data.textCache ? data.textCache->metrics.size.x() : mFont->sizeText(mUppercase ? Utils::String::toUpper(name) : name).x();
 		const float limit      = mSize.x() - mHorizontalMargin * 2;
 
 		if(textLength > limit)
@@ -355,6 +530,7 @@ void TextListComponent<T>::update(int deltaTime)
 			while(mMarqueeTime > maxTime)
 				mMarqueeTime -= maxTime;
 
+			mMarqueeLength = scrollLength + returnLength;
 			mMarqueeOffset = (int)(Math::Scroll::loop(delay, scrollTime + returnTime, (float)mMarqueeTime, scrollLength + returnLength));
 
 			if(mMarqueeOffset > (scrollLength - (limit - returnLength)))
@@ -368,6 +544,12 @@ void TextListComponent<T>::update(int deltaTime)
 //list management stuff
 template <typename T>
 void TextListComponent<T>::add(const std::string& name, const T& obj, unsigned int color)
+{
+	static_cast<IList< TextListData, T >*>(this)->add(makeEntry(name, obj, color));
+}
+
+template <typename T>
+typename IList<TextListData, T>::Entry TextListComponent<T>::makeEntry(const std::string& name, const T& obj, unsigned int color)
 {
 	assert(color < COLOR_ID_COUNT);
 
@@ -375,7 +557,8 @@ void TextListComponent<T>::add(const std::string& name, const T& obj, unsigned i
 	entry.name = name;
 	entry.object = obj;
 	entry.data.colorId = color;
-	static_cast<IList< TextListData, T >*>(this)->add(entry);
+	entry.data.textCacheColor = 0;
+	return entry;
 }
 
 template <typename T>
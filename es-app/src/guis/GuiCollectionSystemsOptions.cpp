@@ -267,8 +267,8 @@ void GuiCollectionSystemsOptions::updateSettings(std::string newAutoSettings, st
 
 	CollectionSystemManager::get()->loadEnabledListFromSettings();
 	CollectionSystemManager::get()->updateSystemsList();
+	ViewController::get()->reloadCollections();
 	ViewController::get()->goToStart();
-	ViewController::get()->reloadAll();
 }
 
 bool GuiCollectionSystemsOptions::input(InputConfig* config, Input input)
@@ -35,7 +35,8 @@ GuiFastSelect::GuiFastSelect(Window* window, IGameListView* gamelist) : GuiCompo
 	mSortId = 0; // TODO
 	updateSortText();
 
-	mLetterId = LETTERS.find(mGameList->getCursor()->getName()[0]);
+	const std::string cursorKey = FileSorts::getNameKey(mGameList->getCursor());
+	mLetterId = cursorKey.empty() ? std::string::npos : LETTERS.find(cursorKey[0]);
 	if(mLetterId == std::string::npos)
 		mLetterId = 0;
 
@@ -142,22 +143,25 @@ void GuiFastSelect::updateGameListSort()
 
 void GuiFastSelect::updateGameListCursor()
 {
-	const std::vector<FileData*>& list = mGameList->getCursor()->getParent()->getChildrenListToDisplay();
+	FileData* parent = mGameList->getCursor()->getParent();
 
 	// only skip by letter when the sort mode is alphabetical
 	const FileData::SortType& sort = FileSorts::SortTypes.at(mSortId);
 	if(sort.comparisonFunction != &FileSorts::compareName)
 		return;
 
-	// find the first entry in the list that either exactly matches our target letter or is beyond our target letter
-	for(auto it = list.cbegin(); it != list.cend(); it++)
+	const std::vector<FileData*>& list = parent->getChildrenListToDisplay();
+	const std::vector<FileData::LetterIndex>& letters = parent->getLetterIndex();
+
+	// find the first letter in the list that either exactly matches our target letter or is beyond our target letter
+	for(auto it = letters.cbegin(); it != letters.cend(); it++)
 	{
-		char check = (*it)->getName().empty() ? 'A' : (*it)->getName()[0];
+		const char check = it->letter;
 
-		// if there's an exact match or we've passed it, set the cursor to this one
+		// if there's an exact match or we've passed it, set the cursor to where it starts
 		if(check == LETTERS[mLetterId] || (sort.ascending && check > LETTERS[mLetterId]) || (!sort.ascending && check < LETTERS[mLetterId]))
 		{
-			mGameList->setCursor(*it);
+			mGameList->setCursor(list.at(it->first));
 			break;
 		}
 	}
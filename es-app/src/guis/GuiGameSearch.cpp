@@ -0,0 +1,121 @@
+#include "guis/GuiGameSearch.h"
+
+#include "components/ComponentList.h"
+#include "components/TextComponent.h"
+#include "components/TextEditComponent.h"
+#include "utils/StringUtil.h"
+#include "views/gamelist/IGameListView.h"
+#include "views/ViewController.h"
+#include "FileData.h"
+#include "FileFilterIndex.h"
+#include "GameSearchIndex.h"
+#include "SystemData.h"
+
+// enough to fill the list, more are one more letter away
+#define MAX_RESULTS 24
+
+GuiGameSearch::GuiGameSearch(Window* window) : GuiComponent(window),
+	mBackground(window, ":/frame.png"), mGrid(window, Vector2i(1, 3)), mSearchPending(false)
+{
+	addChild(&mBackground);
+	addChild(&mGrid);
+
+	mTitle = std::make_shared<TextComponent>(mWindow, "SEARCH GAMES", Font::get(FONT_SIZE_LARGE), 0x555555FF, ALIGN_CENTER);
+
+	mText = std::make_shared<TextEditComponent>(mWindow);
+	mText->setTextChangedCallback([this](const std::string& text) { search(text); });
+
+	mResults = std::make_shared<ComponentList>(mWindow);
+
+	mGrid.setEntry(mTitle, Vector2i(0, 0), false, true);
+	mGrid.setEntry(mText, Vector2i(0, 1), true, false, Vector2i(1, 1), GridFlags::BORDER_TOP | GridFlags::BORDER_BOTTOM);
+	mGrid.setEntry(mResults, Vector2i(0, 2), true, true);
+
+	mText->setSize(0, mText->getFont()->getHeight());
+
+	setSize(Renderer::getScreenWidth() * 0.6f, Renderer::getScreenHeight() * 0.8f);
+	setPosition((Renderer::getScreenWidth() - mSize.x()) / 2, (Renderer::getScreenHeight() - mSize.y()) / 2);
+
+	mText->startEditing();
+}
+
+void GuiGameSearch::onSizeChanged()
+{
+	mBackground.fitTo(mSize, Vector3f::Zero(), Vector2f(-32, -32));
+
+	mText->setSize(mSize.x() - 40, mText->getSize().y());
+
+	// update grid
+	mGrid.setRowHeightPerc(0, mTitle->getFont()->getHeight() / mSize.y());
+	mGrid.setRowHeightPerc(1, (mText->getSize().y() + 20) / mSize.y());
+	mGrid.setSize(mSize);
+}
+
+void GuiGameSearch::search(const std::string& text)
+{
+	mResults->clear();
+
+	GameSearchIndex* index = GameSearchIndex::getInstance();
+	mSearchPending = index->isBuilding();
+
+	// games the filters of their system hide can't be jumped to
+	const std::vector<FileData*> games = index->query(text, MAX_RESULTS, [](FileData* game)
+	{
+		FileFilterIndex* filter = game->getSystem()->getIndex();
+		return !filter->isFiltered() || filter->showFile(game);
+	});
+
+	for(auto it = games.cbegin(); it != games.cend(); it++)
+	{
+		FileData* game = *it;
+
+		ComponentListRow row;
+		row.addElement(std::make_shared<TextComponent>(mWindow, Utils::String::toUpper(game->getName()), Font::get(FONT_SIZE_MEDIUM), 0x777777FF), true);
+		row.addElement(std::make_shared<TextComponent>(mWindow, Utils::String::toUpper(game->getSystem()->getFullName()), Font::get(FONT_SIZE_SMALL), 0x999999FF, ALIGN_RIGHT), false);
+		row.makeAcceptInputHandler([this, game] { select(game); });
+		mResults->addRow(row);
+	}
+
+	updateHelpPrompts();
+}
+
+void GuiGameSearch::select(FileData* game)
+{
+	SystemData* system = game->getSystem();
+
+	ViewController::get()->goToGameList(system);
+	ViewController::get()->getGameListView(system)->setCursor(game);
+
+	delete this;
+}
+
+bool GuiGameSearch::input(InputConfig* config, Input input)
+{
+	if(GuiComponent::input(config, input))
+		return true;
+
+	// pressing back when not text editing closes us
+	if(config->isMappedTo("b", input) && input.value)
+	{
+		delete this;
+		return true;
+	}
+
+	return false;
+}
+
+void GuiGameSearch::update(int deltaTime)
+{
+	// what was typed before the index was done is searched again once it is
+	if(mSearchPending && !GameSearchIndex::getInstance()->isBuilding())
+		search(mText->getValue());
+
+	GuiComponent::update(deltaTime);
+}
+
+std::vector<HelpPrompt> GuiGameSearch::getHelpPrompts()
+{
+	std::vector<HelpPrompt> prompts = mGrid.getHelpPrompts();
+	prompts.push_back(HelpPrompt("b", "back"));
+	return prompts;
+}
@@ -0,0 +1,40 @@
+#pragma once
+#ifndef ES_APP_GUIS_GUI_GAME_SEARCH_H
+#define ES_APP_GUIS_GUI_GAME_SEARCH_H
+
+#include "components/ComponentGrid.h"
+#include "components/NinePatchComponent.h"
+#include "GuiComponent.h"
+
+class ComponentList;
+class FileData;
+class TextComponent;
+class TextEditComponent;
+
+// Lists the games of every system whose name, developer or genre matches what is typed, updated with every key.
+// Picking one jumps to it in the gamelist of its system.
+class GuiGameSearch : public GuiComponent
+{
+public:
+	GuiGameSearch(Window* window);
+
+	bool input(InputConfig* config, Input input) override;
+	void update(int deltaTime) override;
+	void onSizeChanged() override;
+	std::vector<HelpPrompt> getHelpPrompts() override;
+
+private:
+	void search(const std::string& text);
+	void select(FileData* game);
+
+	NinePatchComponent mBackground;
+	ComponentGrid mGrid;
+
+	std::shared_ptr<TextComponent> mTitle;
+	std::shared_ptr<TextEditComponent> mText;
+	std::shared_ptr<ComponentList> mResults;
+
+	bool mSearchPending; // searched while the index was still being built
+};
+
+#endif // ES_APP_GUIS_GUI_GAME_SEARCH_H
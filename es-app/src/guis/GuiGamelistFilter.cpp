@@ -3,6 +3,7 @@
 #include "components/OptionListComponent.h"
 #include "views/UIModeController.h"
 #include "SystemData.h"
+#include <set>
 
 GuiGamelistFilter::GuiGamelistFilter(Window* window, SystemData* system) : GuiComponent(window), mMenu(window, "FILTER GAMELIST BY"), mSystem(system)
 {
@@ -68,12 +69,25 @@ void GuiGamelistFilter::addFiltersToMenu()
 		// add filters (with first one selected)
 		ComponentListRow row;
 
-		// add genres
+		// add genres, the keys are only added once the list is opened, they come sorted from the index
 		optionList = std::make_shared< OptionListComponent<std::string> >(mWindow, menuLabel, true);
-		for(auto it: *allKeys)
+
+		std::vector<std::string>* filteredKeys = (*it).currentFilteredKeys;
+		unsigned int selectedCount = 0;
+		for (std::vector<std::string>::const_iterator key = filteredKeys->cbegin(); key != filteredKeys->cend(); ++key)
 		{
-			optionList->add(it.first, it.first, mFilterIndex->isKeyBeingFilteredBy(it.first, type));
+			if (allKeys->find(*key) != allKeys->cend())
+				selectedCount++;
 		}
+
+		OptionListComponent<std::string>* list = optionList.get();
+		optionList->setPopulator([list, allKeys, filteredKeys]
+		{
+			const std::set<std::string> filtered(filteredKeys->cbegin(), filteredKeys->cend());
+			for (std::map<std::string, int>::const_iterator key = allKeys->cbegin(); key != allKeys->cend(); ++key)
+				list->add(key->first, key->first, filtered.find(key->first) != filtered.cend());
+		}, selectedCount);
+
 		if (allKeys->size() > 0)
 			mMenu.addWithLabel(menuLabel, optionList);
 
@@ -86,6 +100,11 @@ void GuiGamelistFilter::applyFilters()
 	std::vector<FilterDataDecl> decls = mFilterIndex->getFilterDataDecls();
 	for (std::map<FilterIndexType, std::shared_ptr< OptionListComponent<std::string> >>::const_iterator it = mFilterOptions.cbegin(); it != mFilterOptions.cend(); ++it ) {
 		std::shared_ptr< OptionListComponent<std::string> > optionList = it->second;
+
+		// what wasn't opened is still what the index filters by
+		if (!optionList->isPopulated())
+			continue;
+
 		std::vector<std::string> filters = optionList->getSelectedObjects();
 		mFilterIndex->setFilter(it->first, &filters);
 	}
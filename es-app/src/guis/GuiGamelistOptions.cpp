@@ -1,5 +1,6 @@
 #include "GuiGamelistOptions.h"
 
+#include "guis/GuiGameSearch.h"
 #include "guis/GuiGamelistFilter.h"
 #include "scrapers/Scraper.h"
 #include "views/gamelist/IGameListView.h"
@@ -32,7 +33,8 @@ GuiGamelistOptions::GuiGamelistOptions(Window* window, SystemData* system) : Gui
 		// "jump to letter" menuitem only available (and correct jumping) on sort order "name, asc"
 		if (currentSort == reqSort) {
 			bool outOfRange = false;
-			char curChar = (char)toupper(getGamelist()->getCursor()->getSortName()[0]);
+			const std::string cursorKey = FileSorts::getNameKey(getGamelist()->getCursor());
+			char curChar = cursorKey.empty() ? '\0' : cursorKey[0];
 			// define supported character range
 			// this range includes all numbers, capital letters, and most reasonable symbols
 			char startChar = '!';
@@ -43,20 +45,19 @@ GuiGamelistOptions::GuiGamelistOptions(Window* window, SystemData* system) : Gui
 				outOfRange = true;
 			}
 
+			// the letters the current list has, with the folder's letter index instead of a scan per letter
+			bool present[256] = { false };
+			const std::vector<FileData::LetterIndex>& letters = getGamelist()->getCursor()->getParent()->getLetterIndex();
+			for (auto it = letters.cbegin(); it != letters.cend(); it++)
+				present[(unsigned char)it->letter] = true;
+
 			mJumpToLetterList = std::make_shared<LetterList>(mWindow, "JUMP TO ...", false);
 			for (char c = startChar; c <= endChar; c++)
 			{
-				// check if c is a valid first letter in current list
-				const std::vector<FileData*>& files = getGamelist()->getCursor()->getParent()->getChildrenListToDisplay();
-				for (auto file : files)
+				if (present[(unsigned char)c])
 				{
-					char candidate = (char)toupper(file->getSortName()[0]);
-					if (c == candidate)
-					{
-						mJumpToLetterList->add(std::string(1, c), c, (c == curChar) || outOfRange);
-						outOfRange = false; // only override selection on very first c == candidate match
-						break;
-					}
+					mJumpToLetterList->add(std::string(1, c), c, (c == curChar) || outOfRange);
+					outOfRange = false; // only override selection on very first valid letter
 				}
 			}
 
@@ -77,6 +78,12 @@ GuiGamelistOptions::GuiGamelistOptions(Window* window, SystemData* system) : Gui
 			mMenu.addRow(row);
 		}
 
+		row.elements.clear();
+		row.addElement(std::make_shared<TextComponent>(mWindow, "SEARCH GAMES", Font::get(FONT_SIZE_MEDIUM), 0x777777FF), true);
+		row.addElement(makeArrow(mWindow), false);
+		row.makeAcceptInputHandler(std::bind(&GuiGamelistOptions::openGameSearch, this));
+		mMenu.addRow(row);
+
 		// add launch system screensaver
 		std::string screensaver_behavior = Settings::getInstance()->getString("ScreenSaverBehavior");
 		bool useGamelistMedia = screensaver_behavior == "random video" || (screensaver_behavior == "slideshow" && !Settings::getInstance()->getBool("SlideshowScreenSaverCustomMediaSource"));
@@ -201,6 +208,13 @@ bool GuiGamelistOptions::launchSystemScreenSaver()
 	return true;
 }
 
+void GuiGamelistOptions::openGameSearch()
+{
+	Window* window = mWindow;
+	delete this;
+	window->pushGui(new GuiGameSearch(window));
+}
+
 void GuiGamelistOptions::openGamelistFilter()
 {
 	mFiltersChanged = true;
@@ -255,7 +269,6 @@ void GuiGamelistOptions::openMetaDataEd()
 	saveBtnFunc = [this, file] {
 		ViewController::get()->getGameListView(mSystem)->setCursor(file, true);
 		mMetadataChanged = true;
-		ViewController::get()->getGameListView(file->getSystem())->onFileChanged(file, FILE_METADATA_CHANGED);
 	};
 
 	std::function<void()> deleteBtnFunc;
@@ -271,6 +284,8 @@ void GuiGamelistOptions::openMetaDataEd()
 		};
 	}
 
+	// the editor saves every value it shows
+	file->loadDescription();
 	mWindow->pushGui(new GuiMetaDataEd(mWindow, &file->metadata, file->metadata.getMDD(), p, Utils::FileSystem::getFileName(file->getPath()), saveBtnFunc, deleteBtnFunc));
 }
 
@@ -279,33 +294,20 @@ void GuiGamelistOptions::jumpToLetter()
 	char letter = mJumpToLetterList->getSelected();
 	IGameListView* gamelist = getGamelist();
 
-	// this is a really shitty way to get a list of files
-	const std::vector<FileData*>& files = gamelist->getCursor()->getParent()->getChildrenListToDisplay();
+	FileData* parent = gamelist->getCursor()->getParent();
+	const std::vector<FileData*>& files = parent->getChildrenListToDisplay();
+	const std::vector<FileData::LetterIndex>& letters = parent->getLetterIndex();
 
-	long min = 0;
-	long max = (long)files.size() - 1;
-	long mid = 0;
-
-	while(max >= min)
+	// only letters of the list are offered, the index knows where each one starts
+	for(auto it = letters.cbegin(); it != letters.cend(); it++)
 	{
-		mid = ((max - min) / 2) + min;
-
-		// game somehow has no first character to check
-		if(files.at(mid)->getName().empty())
-			continue;
-
-		char checkLetter = (char)toupper(files.at(mid)->getSortName()[0]);
-
-		if(checkLetter < letter)
-			min = mid + 1;
-		else if(checkLetter > letter || (mid > 0 && (letter == toupper(files.at(mid - 1)->getSortName()[0]))))
-			max = mid - 1;
-		else
-			break; //exact match found
+		if(it->letter == letter)
+		{
+			gamelist->setCursor(files.at(it->first));
+			break;
+		}
 	}
 
-	gamelist->setCursor(files.at(mid));
-
 	// flag to force default sort order "name, asc", if user changed the sortorder in the options dialog
 	mJumpToSelected = true;
 
@@ -46,6 +46,12 @@ GuiGeneralScreensaverOptions::GuiGeneralScreensaverOptions(Window* window, const
 		PowerSaver::updateTimeouts();
 	});
 
+	// turn the display off while the screensaver is black, through the "display-off" and "display-on" events
+	auto display_off = std::make_shared<SwitchComponent>(mWindow);
+	display_off->setState(Settings::getInstance()->getBool("ScreenSaverDisplayOff"));
+	addWithLabel("DISPLAY OFF WHEN BLACK", display_off);
+	addSaveFunc([display_off] { Settings::getInstance()->setBool("ScreenSaverDisplayOff", display_off->getState()); });
+
 	ComponentListRow row;
 
 	// show filtered menu
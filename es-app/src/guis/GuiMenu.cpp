@@ -13,6 +13,8 @@
 #include "views/ViewController.h"
 #include "CollectionSystemManager.h"
 #include "EmulationStation.h"
+#include "FrameScheduler.h"
+#include "LibraryWatcher.h"
 #include "Scripting.h"
 #include "SystemData.h"
 #include "VolumeControl.h"
@@ -67,6 +69,33 @@ void GuiMenu::openScraperSettings()
 	s->addWithLabel("SCRAPE RATINGS", scrape_ratings);
 	s->addSaveFunc([scrape_ratings] { Settings::getInstance()->setBool("ScrapeRatings", scrape_ratings->getState()); });
 
+	// games scraped at once when the first result is accepted anyway
+	auto games_in_flight = std::make_shared< OptionListComponent<int> >(mWindow, "GAMES AT ONCE", false);
+	const int gamesInFlight = Settings::getInstance()->getInt("ScraperGamesInFlight");
+	const int inFlightCounts[] = { 1, 2, 4, 8, 16 };
+	bool customInFlight = true;
+	for(auto it = std::begin(inFlightCounts); it != std::end(inFlightCounts); it++)
+	{
+		games_in_flight->add(std::to_string(*it), *it, gamesInFlight == *it);
+		customInFlight &= (gamesInFlight != *it);
+	}
+	if(customInFlight)
+		games_in_flight->add(std::to_string(gamesInFlight), gamesInFlight, true);
+	s->addWithLabel("GAMES SCRAPED AT ONCE", games_in_flight);
+	s->addSaveFunc([games_in_flight] { Settings::getInstance()->setInt("ScraperGamesInFlight", games_in_flight->getSelected()); });
+
+	// answer repeated searches from disk
+	auto scraper_cache = std::make_shared<SwitchComponent>(mWindow);
+	scraper_cache->setState(Settings::getInstance()->getBool("ScraperCache"));
+	s->addWithLabel("CACHE SCRAPER REPLIES", scraper_cache);
+	s->addSaveFunc([scraper_cache] { Settings::getInstance()->setBool("ScraperCache", scraper_cache->getState()); });
+
+	// look games up by the hash of their rom where the scraper supports it
+	auto hash_roms = std::make_shared<SwitchComponent>(mWindow);
+	hash_roms->setState(Settings::getInstance()->getBool("ScraperHashRoms"));
+	s->addWithLabel("IDENTIFY ROMS BY HASH", hash_roms);
+	s->addSaveFunc([hash_roms] { Settings::getInstance()->setBool("ScraperHashRoms", hash_roms->getState()); });
+
 	// scrape now
 	ComponentListRow row;
 	auto openScrapeNow = [this] { mWindow->pushGui(new GuiScraperStart(mWindow)); };
@@ -91,7 +120,8 @@ void GuiMenu::openSoundSettings()
 	auto volume = std::make_shared<SliderComponent>(mWindow, 0.f, 100.f, 1.f, "%");
 	volume->setValue((float)VolumeControl::getInstance()->getVolume());
 	s->addWithLabel("SYSTEM VOLUME", volume);
-	s->addSaveFunc([volume] { VolumeControl::getInstance()->setVolume((int)Math::round(volume->getValue())); });
+	// applied while the slider moves, setVolume() hands it to the mixer thread so holding left or right stays smooth
+	volume->setOnValueChanged([](float value) { VolumeControl::getInstance()->setVolume((int)Math::round(value)); });
 
 	if (UIModeController::getInstance()->isUIModeFull())
 	{
@@ -301,7 +331,7 @@ void GuiMenu::openUISettings()
 			{
 				Scripting::fireEvent("theme-changed", theme_set->getSelected(), oldTheme);
 				CollectionSystemManager::get()->updateSystemsList();
-				ViewController::get()->reloadAll(true); // TODO - replace this with some sort of signal-based implementation
+				ViewController::get()->reloadThemesAsync(); // TODO - replace this with some sort of signal-based implementation
 			}
 		});
 	}
@@ -324,7 +354,7 @@ void GuiMenu::openUISettings()
 			needReload = true;
 		Settings::getInstance()->setString("GamelistViewStyle", gamelist_style->getSelected());
 		if (needReload)
-			ViewController::get()->reloadAll();
+			ViewController::get()->reloadGameListViews();
 	});
 
 	// Optionally ignore leading articles when sorting game titles
@@ -389,7 +419,7 @@ void GuiMenu::openUISettings()
 	s->addSaveFunc([enable_filter] {
 		bool filter_is_enabled = !Settings::getInstance()->getBool("ForceDisableFilters");
 		Settings::getInstance()->setBool("ForceDisableFilters", !enable_filter->getState());
-		if (enable_filter->getState() != filter_is_enabled) ViewController::get()->ReloadAndGoToStart();
+		if (enable_filter->getState() != filter_is_enabled) ViewController::get()->refreshUIModeAndGoToStart();
 	});
 
 	// hide start menu in Kid Mode
@@ -412,6 +442,55 @@ void GuiMenu::openOtherSettings()
 	s->addWithLabel("VRAM LIMIT", max_vram);
 	s->addSaveFunc([max_vram] { Settings::getInstance()->setInt("MaxVRAM", (int)Math::round(max_vram->getValue())); });
 
+	// only images loaded from now on are compressed
+	auto compress_textures = std::make_shared<SwitchComponent>(mWindow);
+	compress_textures->setState(Settings::getInstance()->getBool("CompressTextures"));
+	s->addWithLabel("COMPRESS LARGE IMAGES IN VRAM", compress_textures);
+	s->addSaveFunc([compress_textures] { Settings::getInstance()->setBool("CompressTextures", compress_textures->getState()); });
+
+	// images shown smaller than they are, like in a grid, are kept at a reduced size
+	auto reduce_images = std::make_shared<SwitchComponent>(mWindow);
+	reduce_images->setState(Settings::getInstance()->getBool("ReduceImages"));
+	s->addWithLabel("LOAD IMAGES AT DISPLAY SIZE", reduce_images);
+	s->addSaveFunc([reduce_images] { Settings::getInstance()->setBool("ReduceImages", reduce_images->getState()); });
+
+	// smoother images when they're shown smaller than their texture, at a third more VRAM
+	auto texture_mipmaps = std::make_shared<SwitchComponent>(mWindow);
+	texture_mipmaps->setState(Settings::getInstance()->getBool("TextureMipmaps"));
+	s->addWithLabel("MIPMAP IMAGES", texture_mipmaps);
+	s->addSaveFunc([texture_mipmaps] { Settings::getInstance()->setBool("TextureMipmaps", texture_mipmaps->getState()); });
+
+	// faster return from games, at the cost of the RAM the images take staying in use while the game runs
+	auto keep_images = std::make_shared<SwitchComponent>(mWindow);
+	keep_images->setState(Settings::getInstance()->getBool("KeepImagesDuringGames"));
+	s->addWithLabel("KEEP IMAGES IN RAM DURING GAMES", keep_images);
+	s->addSaveFunc([keep_images] { Settings::getInstance()->setBool("KeepImagesDuringGames", keep_images->getState()); });
+
+	// the opposite of the above for boards where the emulator needs all the RAM it can get, views, images and text are
+	// built again as they're shown after the game
+	auto trim_memory = std::make_shared<SwitchComponent>(mWindow);
+	trim_memory->setState(Settings::getInstance()->getBool("TrimMemoryDuringGames"));
+	s->addWithLabel("FREE MEMORY DURING GAMES", trim_memory);
+	s->addSaveFunc([trim_memory] { Settings::getInstance()->setBool("TrimMemoryDuringGames", trim_memory->getState()); });
+
+	// copies of the same image under different names are loaded once, at the cost of reading those files to compare them
+	auto deduplicate_images = std::make_shared<SwitchComponent>(mWindow);
+	deduplicate_images->setState(Settings::getInstance()->getBool("DeduplicateImages"));
+	s->addWithLabel("SHARE IDENTICAL IMAGES", deduplicate_images);
+	s->addSaveFunc([deduplicate_images] { Settings::getInstance()->setBool("DeduplicateImages", deduplicate_images->getState()); });
+
+	// textures created on the loader threads, taking effect when the renderer starts again, after a game
+	auto background_upload = std::make_shared<SwitchComponent>(mWindow);
+	background_upload->setState(Settings::getInstance()->getBool("BackgroundTextureUpload"));
+	s->addWithLabel("UPLOAD IMAGES IN THE BACKGROUND", background_upload);
+	s->addSaveFunc([background_upload] { Settings::getInstance()->setBool("BackgroundTextureUpload", background_upload->getState()); });
+
+	// fonts loaded from now on scale the glyphs of one distance field per typeface, on renderers with shaders
+	auto font_distance_field = std::make_shared<SwitchComponent>(mWindow);
+	font_distance_field->setState(Settings::getInstance()->getBool("FontDistanceField"));
+	s->addWithLabel("DISTANCE FIELD FONTS", font_distance_field);
+	s->addSaveFunc([font_distance_field] { Settings::getInstance()->setBool("FontDistanceField", font_distance_field->getState()); });
+
 	// power saver
 	auto power_saver = std::make_shared< OptionListComponent<std::string> >(mWindow, "POWER SAVER MODES", false);
 	std::vector<std::string> modes;
@@ -451,6 +530,119 @@ void GuiMenu::openOtherSettings()
 	s->addWithLabel("PARSE GAMESLISTS ONLY", parse_gamelists);
 	s->addSaveFunc([parse_gamelists] { Settings::getInstance()->setBool("ParseGamelistOnly", parse_gamelists->getState()); });
 
+	// themes read from XML again once a file they're made of changes, there's no need to turn this off while editing one
+	auto compile_themes = std::make_shared<SwitchComponent>(mWindow);
+	compile_themes->setState(Settings::getInstance()->getBool("CompileThemes"));
+	s->addWithLabel("COMPILE THEMES", compile_themes);
+	s->addSaveFunc([compile_themes] { Settings::getInstance()->setBool("CompileThemes", compile_themes->getState()); });
+
+	// only with threaded loading, the carousel shows up with the first systems and the others join it as they're loaded
+	auto progressive_boot = std::make_shared<SwitchComponent>(mWindow);
+	progressive_boot->setState(Settings::getInstance()->getBool("ProgressiveBoot"));
+	s->addWithLabel("SHOW SYSTEMS WHILE LOADING", progressive_boot);
+	s->addSaveFunc([progressive_boot] { Settings::getInstance()->setBool("ProgressiveBoot", progressive_boot->getState()); });
+
+	// on 512 MB boards, takes effect with the next start
+	auto low_memory = std::make_shared<SwitchComponent>(mWindow);
+	low_memory->setState(Settings::getInstance()->getBool("LowMemory"));
+	s->addWithLabel("LOW MEMORY MODE", low_memory);
+	s->addSaveFunc([low_memory] { Settings::getInstance()->setBool("LowMemory", low_memory->getState()); });
+
+	auto lazy_views = std::make_shared<SwitchComponent>(mWindow);
+	lazy_views->setState(Settings::getInstance()->getBool("LazyGameListViews"));
+	s->addWithLabel("CREATE GAMELISTS ON DEMAND", lazy_views);
+	s->addSaveFunc([lazy_views] { Settings::getInstance()->setBool("LazyGameListViews", lazy_views->getState()); });
+
+	// views over the limit are dropped, the least recently used first, and remember their cursor
+	auto max_views = std::make_shared< OptionListComponent<int> >(mWindow, "GAMELISTS KEPT LOADED", false);
+	const int maxViews = Settings::getInstance()->getInt("MaxGameListViews");
+	const int viewCounts[] = { 2, 4, 8, 16, 32 };
+	bool customCount = (maxViews != 0);
+	max_views->add("ALL", 0, maxViews == 0);
+	for(auto it = std::begin(viewCounts); it != std::end(viewCounts); it++)
+	{
+		max_views->add(std::to_string(*it), *it, maxViews == *it);
+		customCount &= (maxViews != *it);
+	}
+	if(customCount)
+		max_views->add(std::to_string(maxViews), maxViews, true);
+	s->addWithLabel("GAMELISTS KEPT LOADED", max_views);
+	s->addSaveFunc([max_views] { Settings::getInstance()->setInt("MaxGameListViews", max_views->getSelected()); });
+
+	auto rom_scan_cache = std::make_shared<SwitchComponent>(mWindow);
+	rom_scan_cache->setState(Settings::getInstance()->getBool("RomScanCache"));
+	s->addWithLabel("CACHE ROM FOLDER SCANS", rom_scan_cache);
+	s->addSaveFunc([rom_scan_cache] { Settings::getInstance()->setBool("RomScanCache", rom_scan_cache->getState()); });
+
+	auto gamelist_snapshots = std::make_shared<SwitchComponent>(mWindow);
+	gamelist_snapshots->setState(Settings::getInstance()->getBool("GamelistSnapshots"));
+	s->addWithLabel("CACHE PARSED GAMELISTS", gamelist_snapshots);
+	s->addSaveFunc([gamelist_snapshots] { Settings::getInstance()->setBool("GamelistSnapshots", gamelist_snapshots->getState()); });
+
+	auto watch_library = std::make_shared<SwitchComponent>(mWindow);
+	watch_library->setState(Settings::getInstance()->getBool("WatchLibrary"));
+	s->addWithLabel("WATCH ROM FOLDERS FOR CHANGES", watch_library);
+	s->addSaveFunc([watch_library] {
+		Settings::getInstance()->setBool("WatchLibrary", watch_library->getState());
+		if(watch_library->getState())
+			LibraryWatcher::init();
+		else
+			LibraryWatcher::deinit();
+	});
+
+	auto prefetch_roms = std::make_shared<SwitchComponent>(mWindow);
+	prefetch_roms->setState(Settings::getInstance()->getBool("PrefetchRoms"));
+	s->addWithLabel("PREFETCH THE SELECTED ROM", prefetch_roms);
+	s->addSaveFunc([prefetch_roms] { Settings::getInstance()->setBool("PrefetchRoms", prefetch_roms->getState()); });
+
+	auto lazy_collections = std::make_shared<SwitchComponent>(mWindow);
+	lazy_collections->setState(Settings::getInstance()->getBool("LazyCollections"));
+	s->addWithLabel("LOAD COLLECTIONS ON DEMAND", lazy_collections);
+	s->addSaveFunc([lazy_collections] { Settings::getInstance()->setBool("LazyCollections", lazy_collections->getState()); });
+
+	auto skip_frames = std::make_shared<SwitchComponent>(mWindow);
+	skip_frames->setState(Settings::getInstance()->getBool("SkipUnchangedFrames"));
+	s->addWithLabel("SKIP UNCHANGED FRAMES", skip_frames);
+	s->addSaveFunc([skip_frames] { Settings::getInstance()->setBool("SkipUnchangedFrames", skip_frames->getState()); });
+
+	auto max_fps = std::make_shared< OptionListComponent<int> >(mWindow, "MAX FRAMERATE", false);
+	const int maxFPS = Settings::getInstance()->getInt("MaxFPS");
+	const int rates[] = { 30, 50, 60, 75, 120, 144 };
+	bool customRate = (maxFPS != 0);
+	max_fps->add("UNLIMITED", 0, maxFPS == 0);
+	for(auto it = std::begin(rates); it != std::end(rates); it++)
+	{
+		max_fps->add(std::to_string(*it), *it, maxFPS == *it);
+		customRate &= (maxFPS != *it);
+	}
+	if(customRate)
+		max_fps->add(std::to_string(maxFPS), maxFPS, true);
+	s->addWithLabel("MAX FRAMERATE", max_fps);
+	s->addSaveFunc([max_fps] {
+		Settings::getInstance()->setInt("MaxFPS", max_fps->getSelected());
+		FrameScheduler::init();
+	});
+
+	// fewer pixels to fill on a large screen, taken over with the next frame
+	auto render_scale = std::make_shared< OptionListComponent<int> >(mWindow, "RENDER RESOLUTION", false);
+	const int renderScale = Settings::getInstance()->getInt("RenderScale");
+	const int scales[] = { 100, 90, 75, 66, 50 };
+	bool customScale = true;
+	for(auto it = std::begin(scales); it != std::end(scales); it++)
+	{
+		render_scale->add(std::to_string(*it) + "%", *it, renderScale == *it);
+		customScale &= (renderScale != *it);
+	}
+	if(customScale)
+		render_scale->add(std::to_string(renderScale) + "%", renderScale, true);
+	s->addWithLabel("RENDER RESOLUTION", render_scale);
+	s->addSaveFunc([render_scale] { Settings::getInstance()->setInt("RenderScale", render_scale->getSelected()); });
+
+	auto adaptive_scale = std::make_shared<SwitchComponent>(mWindow);
+	adaptive_scale->setState(Settings::getInstance()->getBool("RenderScaleAdaptive"));
+	s->addWithLabel("LOWER RESOLUTION WHEN SLOW", adaptive_scale);
+	s->addSaveFunc([adaptive_scale] { Settings::getInstance()->setBool("RenderScaleAdaptive", adaptive_scale->getState()); });
+
 	auto local_art = std::make_shared<SwitchComponent>(mWindow);
 	local_art->setState(Settings::getInstance()->getBool("LocalArt"));
 	s->addWithLabel("SEARCH FOR LOCAL ART", local_art);
@@ -482,6 +674,18 @@ void GuiMenu::openOtherSettings()
 
 #endif
 
+	// VLC decodes previews on the GPU when it has a decoder
+	auto hardware_decode = std::make_shared<SwitchComponent>(mWindow);
+	hardware_decode->setState(Settings::getInstance()->getBool("VideoHardwareDecode"));
+	s->addWithLabel("HARDWARE VIDEO DECODING", hardware_decode);
+	s->addSaveFunc([hardware_decode] { Settings::getInstance()->setBool("VideoHardwareDecode", hardware_decode->getState()); });
+
+	// a few seconds of each video are kept small to be shown while it's opened
+	auto video_previews = std::make_shared<SwitchComponent>(mWindow);
+	video_previews->setState(Settings::getInstance()->getBool("VideoPreviews"));
+	s->addWithLabel("INSTANT VIDEO PREVIEWS", video_previews);
+	s->addSaveFunc([video_previews] { Settings::getInstance()->setBool("VideoPreviews", video_previews->getState()); });
+
 	// hidden files
 	auto background_indexing = std::make_shared<SwitchComponent>(mWindow);
 	background_indexing->setState(Settings::getInstance()->getBool("BackgroundIndexing"));
@@ -494,6 +698,18 @@ void GuiMenu::openOtherSettings()
 	s->addWithLabel("SHOW FRAMERATE", framerate);
 	s->addSaveFunc([framerate] { Settings::getInstance()->setBool("DrawFramerate", framerate->getState()); });
 
+	// GPU time per view, shown with the framerate
+	auto profile_gpu = std::make_shared<SwitchComponent>(mWindow);
+	profile_gpu->setState(Settings::getInstance()->getBool("ProfileGPU"));
+	s->addWithLabel("PROFILE GPU", profile_gpu);
+	s->addSaveFunc([profile_gpu] { Settings::getInstance()->setBool("ProfileGPU", profile_gpu->getState()); });
+
+	// time from a press until its frame is on screen, shown with the framerate
+	auto input_latency = std::make_shared<SwitchComponent>(mWindow);
+	input_latency->setState(Settings::getInstance()->getBool("MeasureInputLatency"));
+	s->addWithLabel("MEASURE INPUT LATENCY", input_latency);
+	s->addSaveFunc([input_latency] { Settings::getInstance()->setBool("MeasureInputLatency", input_latency->getState()); });
+
 
 	mWindow->pushGui(s);
 
@@ -15,9 +15,7 @@
 #include "resources/Font.h"
 #include "utils/StringUtil.h"
 #include "views/ViewController.h"
-#include "CollectionSystemManager.h"
 #include "FileData.h"
-#include "FileFilterIndex.h"
 #include "SystemData.h"
 #include "Window.h"
 #include "Log.h"
@@ -192,31 +190,26 @@ void GuiMetaDataEd::onSizeChanged()
 
 void GuiMetaDataEd::save()
 {
-	// remove game from index
-	mScraperParams.system->getIndex()->removeFromIndex(mScraperParams.game);
-
 	assert(mMetaDataDecl.size() >= mEditors.size());
-	// there may be less editfields than metadata entries as
-	// statistic md fields are not shown to the user.
-	// md statistic fields are not necessarily at the end of the md list
-	int edIdx = 0;
-	for(auto &mdd : mMetaDataDecl)
+	// the index, collections and views of the game are updated by changeMetaData()
+	mScraperParams.game->changeMetaData([this](MetaDataList& metadata)
 	{
-		if(!mdd.isStatistic) {
-			mMetaData->set(mdd.key, mEditors.at(edIdx)->getValue());
-			edIdx++;
+		// there may be less editfields than metadata entries as
+		// statistic md fields are not shown to the user.
+		// md statistic fields are not necessarily at the end of the md list
+		int edIdx = 0;
+		for(auto &mdd : mMetaDataDecl)
+		{
+			if(!mdd.isStatistic) {
+				metadata.set(mdd.key, mEditors.at(edIdx)->getValue());
+				edIdx++;
+			}
 		}
-	}
-
-	// enter game in index
-	mScraperParams.system->getIndex()->addToIndex(mScraperParams.game);
+	});
 
 	if(mSavedCallback)
 		mSavedCallback();
 
-	// update respective Collection Entries
-	CollectionSystemManager::get()->refreshCollectionSystems(mScraperParams.game);
-
 	mScraperParams.system->onMetaDataSavePoint();
 }
 
@@ -1,13 +1,17 @@
 #include "guis/GuiScraperMulti.h"
 
+#include "components/BusyComponent.h"
 #include "components/ButtonComponent.h"
 #include "components/MenuComponent.h"
 #include "components/ScraperSearchComponent.h"
 #include "components/TextComponent.h"
 #include "guis/GuiMsgBox.h"
 #include "views/ViewController.h"
+#include "FileData.h"
 #include "Gamelist.h"
+#include "Log.h"
 #include "PowerSaver.h"
+#include "Settings.h"
 #include "SystemData.h"
 #include "Window.h"
 
@@ -38,12 +42,24 @@ GuiScraperMulti::GuiScraperMulti(Window* window, const std::queue<ScraperSearchP
 	mSubtitle = std::make_shared<TextComponent>(mWindow, "subtitle text", Font::get(FONT_SIZE_SMALL), 0x888888FF, ALIGN_CENTER);
 	mGrid.setEntry(mSubtitle, Vector2i(0, 2), false, true);
 
-	mSearchComp = std::make_shared<ScraperSearchComponent>(mWindow,
-		approveResults ? ScraperSearchComponent::ALWAYS_ACCEPT_MATCHING_CRC : ScraperSearchComponent::ALWAYS_ACCEPT_FIRST_RESULT);
-	mSearchComp->setAcceptCallback(std::bind(&GuiScraperMulti::acceptResult, this, std::placeholders::_1));
-	mSearchComp->setSkipCallback(std::bind(&GuiScraperMulti::skip, this));
-	mSearchComp->setCancelCallback(std::bind(&GuiScraperMulti::finish, this));
-	mGrid.setEntry(mSearchComp, Vector2i(0, 3), mSearchComp->getSearchType() != ScraperSearchComponent::ALWAYS_ACCEPT_FIRST_RESULT, true);
+	// nobody looks at the results when the first one is taken anyway, so several games are scraped at once
+	mPipelined = !approveResults && (Settings::getInstance()->getInt("ScraperGamesInFlight") > 1) && isValidConfiguredScraper();
+
+	if(mPipelined)
+	{
+		mBusy = std::make_shared<BusyComponent>(mWindow);
+		mBusy->setText("SCRAPING...");
+		mGrid.setEntry(mBusy, Vector2i(0, 3), false, true);
+	}
+	else
+	{
+		mSearchComp = std::make_shared<ScraperSearchComponent>(mWindow,
+			approveResults ? ScraperSearchComponent::ALWAYS_ACCEPT_MATCHING_CRC : ScraperSearchComponent::ALWAYS_ACCEPT_FIRST_RESULT);
+		mSearchComp->setAcceptCallback(std::bind(&GuiScraperMulti::acceptResult, this, std::placeholders::_1));
+		mSearchComp->setSkipCallback(std::bind(&GuiScraperMulti::skip, this));
+		mSearchComp->setCancelCallback(std::bind(&GuiScraperMulti::finish, this));
+		mGrid.setEntry(mSearchComp, Vector2i(0, 3), mSearchComp->getSearchType() != ScraperSearchComponent::ALWAYS_ACCEPT_FIRST_RESULT, true);
+	}
 
 	std::vector< std::shared_ptr<ButtonComponent> > buttons;
 
@@ -68,7 +84,10 @@ GuiScraperMulti::GuiScraperMulti(Window* window, const std::queue<ScraperSearchP
 	setSize(Renderer::getScreenWidth() * 0.95f, Renderer::getScreenHeight() * 0.849f);
 	setPosition((Renderer::getScreenWidth() - mSize.x()) / 2, (Renderer::getScreenHeight() - mSize.y()) / 2);
 
-	doNextSearch();
+	if(mPipelined)
+		updateScrapes();
+	else
+		doNextSearch();
 }
 
 GuiScraperMulti::~GuiScraperMulti()
@@ -109,16 +128,115 @@ void GuiScraperMulti::doNextSearch()
 	mSearchComp->search(mSearchQueue.front());
 }
 
-void GuiScraperMulti::acceptResult(const ScraperSearchResult& result)
+void GuiScraperMulti::update(int deltaTime)
 {
-	ScraperSearchParams& search = mSearchQueue.front();
+	GuiComponent::update(deltaTime);
 
-	search.game->metadata = result.mdl;
+	if(mPipelined && mIsProcessing)
+		updateScrapes();
+}
+
+void GuiScraperMulti::updateScrapes()
+{
+	const int maxInFlight = Settings::getInstance()->getInt("ScraperGamesInFlight");
+	const int maxSearches = getScraperMaxSearches();
+	int searches = 0;
+
+	for(auto it = mScrapes.cbegin(); it != mScrapes.cend(); it++)
+	{
+		if(it->search)
+			searches++;
+	}
+
+	// start the next games, the scraper only takes so many searches at once while the others download their images
+	while(!mSearchQueue.empty() && ((int)mScrapes.size() < maxInFlight) && (searches < maxSearches))
+	{
+		mScrapes.push_back(Scrape());
+		Scrape& scrape = mScrapes.back();
+		scrape.params = mSearchQueue.front();
+		scrape.search = startScraperSearch(scrape.params);
+		mSearchQueue.pop();
+		searches++;
+
+		mSystem->setText(Utils::String::toUpper(scrape.params.system->getFullName()));
+	}
+
+	for(auto it = mScrapes.begin(); it != mScrapes.end(); )
+	{
+		bool done = false;
+
+		if(it->search && (it->search->status() != ASYNC_IN_PROGRESS))
+		{
+			const std::vector<ScraperSearchResult>& results = it->search->getResults();
+
+			if(it->search->status() == ASYNC_ERROR)
+			{
+				// unattended runs go on with the next game instead of asking
+				LOG(LogWarning) << "Scraping \"" << it->params.game->getPath() << "\" failed: " << it->search->getStatusString();
+				mTotalSkipped++;
+				done = true;
+			}
+			else if(results.empty())
+			{
+				mTotalSkipped++;
+				done = true;
+			}
+			else if(results.front().imageUrl.empty())
+			{
+				saveResult(it->params, results.front());
+				done = true;
+			}
+			else
+				it->resolve = resolveMetaDataAssets(results.front(), it->params);
+
+			it->search.reset();
+		}
+		else if(it->resolve && (it->resolve->status() != ASYNC_IN_PROGRESS))
+		{
+			if(it->resolve->status() == ASYNC_DONE)
+				saveResult(it->params, it->resolve->getResult());
+			else
+			{
+				LOG(LogWarning) << "Downloading the media of \"" << it->params.game->getPath() << "\" failed: " << it->resolve->getStatusString();
+				mTotalSkipped++;
+			}
+			done = true;
+		}
+
+		if(done)
+		{
+			mCurrentGame++;
+			it = mScrapes.erase(it);
+		}
+		else
+			it++;
+	}
+
+	if(mSearchQueue.empty() && mScrapes.empty())
+	{
+		finish();
+		return;
+	}
+
+	std::stringstream ss;
+	ss << "GAME " << mCurrentGame << " OF " << mTotalGames << " DONE - " << mScrapes.size() << " IN PROGRESS";
+	mSubtitle->setText(ss.str());
+}
+
+void GuiScraperMulti::saveResult(const ScraperSearchParams& search, const ScraperSearchResult& result)
+{
+	const MetaDataList& mdl = result.mdl;
+	search.game->changeMetaData([&mdl](MetaDataList& metadata) { metadata = mdl; });
 	updateGamelist(search.system);
+	mTotalSuccessful++;
+}
+
+void GuiScraperMulti::acceptResult(const ScraperSearchResult& result)
+{
+	saveResult(mSearchQueue.front(), result);
 
 	mSearchQueue.pop();
 	mCurrentGame++;
-	mTotalSuccessful++;
 	doNextSearch();
 }
 
@@ -132,6 +250,9 @@ void GuiScraperMulti::skip()
 
 void GuiScraperMulti::finish()
 {
+	// the games still in flight are dropped, the ones done are saved already
+	mScrapes.clear();
+
 	std::stringstream ss;
 	if(mTotalSuccessful == 0)
 	{
@@ -6,7 +6,9 @@
 #include "components/NinePatchComponent.h"
 #include "scrapers/Scraper.h"
 #include "GuiComponent.h"
+#include <list>
 
+class BusyComponent;
 class ScraperSearchComponent;
 class TextComponent;
 
@@ -17,13 +19,25 @@ public:
 	virtual ~GuiScraperMulti();
 
 	void onSizeChanged() override;
+	void update(int deltaTime) override;
 	std::vector<HelpPrompt> getHelpPrompts() override;
 
 private:
+	// a game in flight when the first results are accepted anyway, its images download while other games are searched
+	struct Scrape
+	{
+		ScraperSearchParams params;
+		std::unique_ptr<ScraperSearchHandle> search;
+		std::unique_ptr<MDResolveHandle> resolve;
+	};
+
 	void acceptResult(const ScraperSearchResult& result);
 	void skip();
 	void doNextSearch();
 
+	void saveResult(const ScraperSearchParams& search, const ScraperSearchResult& result);
+	void updateScrapes();
+
 	void finish();
 
 	unsigned int mTotalGames;
@@ -31,6 +45,8 @@ private:
 	unsigned int mTotalSuccessful;
 	unsigned int mTotalSkipped;
 	std::queue<ScraperSearchParams> mSearchQueue;
+	std::list<Scrape> mScrapes;
+	bool mPipelined;
 
 	NinePatchComponent mBackground;
 	ComponentGrid mGrid;
@@ -39,6 +55,7 @@ private:
 	std::shared_ptr<TextComponent> mSystem;
 	std::shared_ptr<TextComponent> mSubtitle;
 	std::shared_ptr<ScraperSearchComponent> mSearchComp;
+	std::shared_ptr<BusyComponent> mBusy;
 	std::shared_ptr<ComponentGrid> mButtonGrid;
 };
 
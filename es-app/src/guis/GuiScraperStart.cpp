@@ -6,6 +6,7 @@
 #include "guis/GuiScraperMulti.h"
 #include "views/ViewController.h"
 #include "FileData.h"
+#include "RomHashIndex.h"
 #include "SystemData.h"
 
 GuiScraperStart::GuiScraperStart(Window* window) : GuiComponent(window),
@@ -78,18 +79,22 @@ std::queue<ScraperSearchParams> GuiScraperStart::getSearches(std::vector<SystemD
 	std::queue<ScraperSearchParams> queue;
 	for(auto sys = systems.cbegin(); sys != systems.cend(); sys++)
 	{
-		std::vector<FileData*> games = (*sys)->getRootFolder()->getFilesRecursive(GAME);
-		for(auto game = games.cbegin(); game != games.cend(); game++)
+		SystemData* system = *sys;
+		system->getRootFolder()->forEachFile(GAME, false, [system, &selector, &queue](FileData* game)
 		{
-			if(selector((*sys), (*game)))
+			if(selector(system, game))
 			{
 				ScraperSearchParams search;
-				search.game = *game;
-				search.system = *sys;
+				search.game = game;
+				search.system = system;
+
+				// hashed in the background, most are done by the time their search starts
+				if(RomHashIndex::isEnabled())
+					RomHashIndex::getInstance()->queue(game->getPath());
 
 				queue.push(search);
 			}
-		}
+		});
 	}
 
 	return queue;
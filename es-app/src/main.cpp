@@ -3,20 +3,46 @@
 
 #include "guis/GuiDetectDevice.h"
 #include "guis/GuiMsgBox.h"
+#include "resources/Font.h"
+#include "resources/ResourceArchive.h"
+#include "resources/TextureResource.h"
+#include "resources/VideoPreview.h"
+#include "scrapers/ScraperCache.h"
 #include "utils/FileSystemUtil.h"
 #include "utils/ProfilingUtil.h"
+#include "utils/StringUtil.h"
+#include "utils/TaskScheduler.h"
+#include "utils/TimelineUtil.h"
 #include "views/ViewController.h"
+#include "BenchmarkLibrary.h"
 #include "CollectionSystemManager.h"
 #include "EmulationStation.h"
+#include "FileFilterIndex.h"
+#include "FrameScheduler.h"
+#include "GamelistWriter.h"
+#include "GameSearchIndex.h"
+#include "InputLatency.h"
 #include "InputManager.h"
+#include "LibraryWatcher.h"
 #include "Log.h"
 #include "MameNames.h"
+#include "MediaIndex.h"
+#include "MemoryUsage.h"
+#include "Metrics.h"
 #include "platform.h"
 #include "PowerSaver.h"
+#include "RomHashIndex.h"
+#include "RomPrefetch.h"
+#include "RomScanCache.h"
 #include "ScraperCmdLine.h"
+#include "Scripting.h"
+#include "SharedCache.h"
 #include "Settings.h"
 #include "SystemData.h"
 #include "SystemScreenSaver.h"
+#include "ThemeAnalyzer.h"
+#include "UIBenchmark.h"
+#include "UtilsBenchmark.h"
 #include <SDL_events.h>
 #include <SDL_main.h>
 #include <SDL_timer.h>
@@ -29,6 +55,18 @@
 #include <FreeImage.h>
 
 bool scrape_cmdline = false;
+bool scrape_batch = false;
+bool scrape_all = false;
+int scrape_workers = 0;
+std::vector<std::string> scrape_systems;
+std::string boot_trace;
+int ui_benchmark = 0;
+int load_benchmark = 0;
+bool utils_benchmark = false;
+std::string pack_directory;
+std::string pack_path;
+BenchmarkLibrary::Options benchmark_library;
+ThemeAnalyzer::Options analyze_theme;
 
 bool parseArgs(int argc, char* argv[])
 {
@@ -145,6 +183,13 @@ bool parseArgs(int argc, char* argv[])
 		}else if(strcmp(argv[i], "--windowed") == 0)
 		{
 			Settings::getInstance()->setBool("Windowed", true);
+		}else if(strcmp(argv[i], "--headless") == 0)
+		{
+			// SDL's offscreen driver draws into an EGL pbuffer, nothing needs a display or sound card
+			SDL_setenv("SDL_VIDEODRIVER", "offscreen", 1);
+			SDL_setenv("SDL_AUDIODRIVER", "dummy", 1);
+			Settings::getInstance()->setBool("Windowed", true);
+			Settings::getInstance()->setBool("VSync", false);
 		}else if(strcmp(argv[i], "--vsync") == 0)
 		{
 			bool vsync = (strcmp(argv[i + 1], "on") == 0 || strcmp(argv[i + 1], "1") == 0) ? true : false;
@@ -153,6 +198,102 @@ bool parseArgs(int argc, char* argv[])
 		}else if(strcmp(argv[i], "--scrape") == 0)
 		{
 			scrape_cmdline = true;
+		}else if(strcmp(argv[i], "--scrape-batch") == 0)
+		{
+			scrape_cmdline = true;
+			scrape_batch = true;
+		}else if(strcmp(argv[i], "--scrape-record") == 0)
+		{
+			scrape_cmdline = true;
+			scrape_batch = true;
+			ScraperCache::setMode(ScraperCache::MODE_RECORD);
+		}else if(strcmp(argv[i], "--scrape-benchmark") == 0)
+		{
+			scrape_cmdline = true;
+			scrape_batch = true;
+			scrape_all = true;
+			ScraperCache::setMode(ScraperCache::MODE_REPLAY);
+		}else if(strcmp(argv[i], "--scrape-all") == 0)
+		{
+			scrape_all = true;
+		}else if(strcmp(argv[i], "--scrape-workers") == 0)
+		{
+			scrape_workers = atoi(argv[i + 1]);
+			i++; // skip worker count
+		}else if(strcmp(argv[i], "--scrape-systems") == 0)
+		{
+			scrape_systems = Utils::String::delimitedStringToVector(argv[i + 1], ",");
+			i++; // skip system names
+		}else if(strcmp(argv[i], "--boot-trace") == 0)
+		{
+			boot_trace = argv[i + 1];
+			i++; // skip trace path
+		}else if(strcmp(argv[i], "--ui-benchmark") == 0)
+		{
+			ui_benchmark = atoi(argv[i + 1]);
+			benchmark_library.games = ui_benchmark;
+			i++; // skip game count
+		}else if(strcmp(argv[i], "--load-benchmark") == 0)
+		{
+			load_benchmark = atoi(argv[i + 1]);
+			benchmark_library.games = load_benchmark;
+			i++; // skip game count
+		}else if(strcmp(argv[i], "--utils-benchmark") == 0)
+		{
+			utils_benchmark = true;
+		}else if(strcmp(argv[i], "--analyze-theme") == 0)
+		{
+			if(i >= argc - 1)
+			{
+				std::cerr << "Invalid analyze-theme supplied.";
+				return false;
+			}
+
+			analyze_theme.theme = argv[i + 1];
+			i++; // skip theme set
+		}else if(strcmp(argv[i], "--theme-budget-image") == 0)
+		{
+			analyze_theme.image = (unsigned int)Math::max(atoi(argv[i + 1]), 0);
+			i++; // skip size
+		}else if(strcmp(argv[i], "--theme-budget-view") == 0)
+		{
+			analyze_theme.view = (unsigned int)Math::max(atoi(argv[i + 1]), 0);
+			i++; // skip size
+		}else if(strcmp(argv[i], "--theme-budget-extras") == 0)
+		{
+			analyze_theme.extras = (unsigned int)Math::max(atoi(argv[i + 1]), 0);
+			i++; // skip count
+		}else if(strcmp(argv[i], "--theme-budget-font") == 0)
+		{
+			analyze_theme.font = (unsigned int)Math::max(atoi(argv[i + 1]), 0);
+			i++; // skip size
+		}else if(strcmp(argv[i], "--theme-budget-draws") == 0)
+		{
+			analyze_theme.draws = (unsigned int)Math::max(atoi(argv[i + 1]), 0);
+			i++; // skip count
+		}else if(strcmp(argv[i], "--pack-resources") == 0)
+		{
+			if(i >= argc - 2)
+			{
+				std::cerr << "Invalid pack-resources supplied.";
+				return false;
+			}
+
+			pack_directory = argv[i + 1];
+			pack_path = argv[i + 2];
+			i += 2; // skip directory and archive path
+		}else if(strcmp(argv[i], "--benchmark-systems") == 0)
+		{
+			benchmark_library.systems = Math::max(atoi(argv[i + 1]), 1);
+			i++; // skip system count
+		}else if(strcmp(argv[i], "--benchmark-metadata") == 0)
+		{
+			benchmark_library.metadata = Math::clamp(atoi(argv[i + 1]), 0, 100);
+			i++; // skip percentage
+		}else if(strcmp(argv[i], "--benchmark-media") == 0)
+		{
+			benchmark_library.media = Math::clamp(atoi(argv[i + 1]), 0, 100);
+			i++; // skip percentage
 		}else if(strcmp(argv[i], "--max-vram") == 0)
 		{
 			int maxVRAM = atoi(argv[i + 1]);
@@ -193,6 +334,8 @@ bool parseArgs(int argc, char* argv[])
 				"--screenoffset X Y             move the canvas by x,y pixels\n"
 				"--fullscreen-borderless        borderless fullscreen window\n"
 				"--windowed                     not fullscreen, should be used with --resolution\n"
+				"--headless                     draw offscreen without a display, for running\n"
+				"                               --ui-benchmark on build servers\n"
 				"--monitor N                    monitor index (0-)\n"
 				"\nGame and settings visibility in ES and behaviour of ES:\n"
 				"--force-disable-filters        force the UI to ignore applied filters on\n"
@@ -220,13 +363,44 @@ bool parseArgs(int argc, char* argv[])
 				"--show-hidden-files            show also hidden files of filesystem, no effect\n"
 				"                               if --gamelist-only is also set (p)\n"
 				"--vsync 1|0                    turn vsync on (1) or off (0) (default is on)\n"
+				"--boot-trace FILE              write how long each step of starting up took to\n"
+				"                               FILE, for chrome://tracing\n"
+				"--ui-benchmark N               scroll through a generated library of N games,\n"
+				"                               print frame times and memory, then quit\n"
+				"--load-benchmark N             load a generated library of N games without a\n"
+				"                               window, print how long each step took, then quit\n"
+				"--utils-benchmark              time the string, path and date helpers, then quit\n"
+				"--benchmark-systems N          systems the games are spread over, default 5\n"
+				"--benchmark-metadata PERCENT   games with full metadata, default 100\n"
+				"--benchmark-media PERCENT      games with an image, default 0\n"
+				"--pack-resources DIR FILE      pack a theme or the resources in DIR into FILE,\n"
+				"                               save as .espack next to DIR to load from it\n"
+				"--analyze-theme NAME|DIR       print the textures, fonts, videos and draws of\n"
+				"                               every view of a theme set at --resolution, then\n"
+				"                               quit, 0 disables any of the budgets below\n"
+				"--theme-budget-image MB        decoded size of one image, default 8\n"
+				"--theme-budget-view MB         VRAM of one view, default 64\n"
+				"--theme-budget-extras N        extras in one view, default 30\n"
+				"--theme-budget-font PX         size of one font, default 128\n"
+				"--theme-budget-draws N         draws of one view, default 100\n"
 				"\nGeneric switches:\n"
 				"--help, -h                     summon a sentient, angry tuba\n\n"
 				"--home PATH                    directory to use as home folder for\n"
 				"                               .emulationstation/es_settings.cfg, aso.\n"
 				"                               Subfolder .emulationstation/ will be created.\n"
 				"\nScrape mode:\n"
-				"--scrape                       scrape using command line interface\n\n"
+				"--scrape                       scrape using command line interface\n"
+				"--scrape-batch                 scrape without asking, taking the first result,\n"
+				"                               an interrupted run continues where it stopped\n"
+				"--scrape-workers N             games scraped at once in batch mode\n"
+				"                               (default is the GAMES SCRAPED AT ONCE setting)\n"
+				"--scrape-systems NAME,...      only scrape these systems in batch mode\n"
+				"--scrape-all                   also scrape games that have an image already\n"
+				"--scrape-record                batch scrape, keeping every reply and image\n"
+				"                               for --scrape-benchmark\n"
+				"--scrape-benchmark             batch scrape every game from what was recorded,\n"
+				"                               without going online or changing the gamelists,\n"
+				"                               and report where the time went\n\n"
 				"Note: Switches marked (p) will be persisted in es_settings.cfg when any\n"
 				"setting is changed via EmulationStation UI.\n\n"
 				"Please refer to the online documentation for additional information:\n"
@@ -258,11 +432,11 @@ bool verifyHomeFolderExists()
 }
 
 // Returns true if everything is OK,
-bool loadSystemConfigFile(Window* window, const char** errorString)
+bool loadSystemConfigFile(Window* window, bool progressive, const char** errorString)
 {
 	*errorString = NULL;
 
-	if(!SystemData::loadConfig(window))
+	if(!SystemData::loadConfig(window, progressive))
 	{
 		LOG(LogError) << "Error while parsing systems configuration file!";
 		*errorString = "IT LOOKS LIKE YOUR SYSTEMS CONFIGURATION FILE HAS NOT BEEN SET UP OR IS INVALID. YOU'LL NEED TO DO THIS BY HAND, UNFORTUNATELY.\n\n"
@@ -289,6 +463,23 @@ void onExit()
 	Log::close();
 }
 
+// the subsystems that aren't counted as they allocate are measured from what they keep track of anyway
+void setMemoryMeasures()
+{
+	MemoryUsage::setMeasure(MemoryUsage::FILTER_INDEX, []() -> size_t
+	{
+		// the systems are only in sSystemVector once they're done loading, their indexes aren't changed by other threads then
+		size_t total = 0;
+		for(auto it = SystemData::sSystemVector.cbegin(); it != SystemData::sSystemVector.cend(); it++)
+			total += (*it)->getIndex()->getMemoryUsage();
+		return total;
+	});
+	MemoryUsage::setMeasure(MemoryUsage::FONT_ATLAS,   [] { return Font::getTotalMemUsage(); });
+	MemoryUsage::setMeasure(MemoryUsage::TEXTURE_RAM,  [] { return TextureResource::getTotalRAMUsage(); });
+	MemoryUsage::setMeasure(MemoryUsage::TEXTURE_VRAM, [] { return TextureResource::getTotalMemUsage(); });
+	MemoryUsage::setMeasure(MemoryUsage::VIDEO,        [] { return VideoPreview::getLoadedSize(); });
+}
+
 int main(int argc, char* argv[])
 {
 	std::locale::global(std::locale("C"));
@@ -296,6 +487,13 @@ int main(int argc, char* argv[])
 	if(!parseArgs(argc, argv))
 		return 0;
 
+	// only needs the helpers themselves, nothing else is started
+	if(utils_benchmark)
+		return UtilsBenchmark::run();
+
+	if(!boot_trace.empty())
+		Utils::Timeline::start();
+
 	// only show the console on Windows if HideConsole is false
 #ifdef WIN32
 	// MSVC has a "SubSystem" option, with two primary options: "WINDOWS" and "CONSOLE".
@@ -346,18 +544,40 @@ int main(int argc, char* argv[])
 	//always close the log on exit
 	atexit(&onExit);
 
+	// only packs the directory, nothing else is started
+	if(!pack_directory.empty())
+	{
+		const bool packed = ResourceArchive::create(pack_directory, pack_path);
+		std::cout << (packed ? "Packed \"" : "Could not pack \"") << pack_directory << "\" into \"" << pack_path << "\"\n";
+		return packed ? 0 : 1;
+	}
+
+	// only loads the theme, nothing else is started
+	if(!analyze_theme.theme.empty())
+		return ThemeAnalyzer::run(analyze_theme);
+
 	Window window;
 	SystemScreenSaver screensaver(&window);
 	PowerSaver::init();
 	ViewController::init(&window);
 	CollectionSystemManager::init(&window);
-	MameNames::init();
+	// the caches below are loaded from what was fetched
+	SharedCache::fetch();
+	RomScanCache::init();
+	GamelistWriter::init();
+	MediaIndex::init();
+	GameSearchIndex::init();
+	Utils::TaskScheduler::init();
 	window.pushGui(ViewController::get());
 
-	bool splashScreen = Settings::getInstance()->getBool("SplashScreen");
+	// nothing is shown when only scraping or timing the load
+	const bool headless = scrape_cmdline || (load_benchmark > 0);
+	bool splashScreen = Settings::getInstance()->getBool("SplashScreen") && !headless;
 
-	if(!scrape_cmdline)
+	if(!headless)
 	{
+		TimelineScope("Window::init");
+
 		if(!window.init())
 		{
 			LOG(LogError) << "Window failed to initialize!";
@@ -371,14 +591,28 @@ int main(int argc, char* argv[])
 		}
 	}
 
+	// loads the generated library instead of the usual systems
+	if(((ui_benchmark > 0) || (load_benchmark > 0)) && !scrape_cmdline)
+	{
+		if(!BenchmarkLibrary::init(benchmark_library))
+			return 1;
+
+		if(load_benchmark > 0)
+			return BenchmarkLibrary::runLoadBenchmark(boot_trace);
+
+		UIBenchmark::init();
+	}
+
 	const char* errorMsg = NULL;
-	if(!loadSystemConfigFile(splashScreen ? &window : nullptr, &errorMsg))
+	// the scraper and the benchmarks need every system, a progressive boot is only for the UI
+	const bool progressive = Settings::getInstance()->getBool("ProgressiveBoot") && !headless;
+	if(!loadSystemConfigFile(splashScreen ? &window : nullptr, progressive, &errorMsg))
 	{
 		// something went terribly wrong
 		if(errorMsg == NULL)
 		{
 			LOG(LogError) << "Unknown error occured while parsing system config file.";
-			if(!scrape_cmdline)
+			if(!headless)
 				Renderer::deinit();
 			return 1;
 		}
@@ -396,6 +630,9 @@ int main(int argc, char* argv[])
 	//run the command line scraper then quit
 	if(scrape_cmdline)
 	{
+		if(scrape_batch)
+			return run_scraper_batch(scrape_systems, scrape_all, (scrape_workers > 0) ? scrape_workers : Settings::getInstance()->getInt("ScraperGamesInFlight"));
+
 		return run_scraper_cmdline();
 	}
 
@@ -403,15 +640,45 @@ int main(int argc, char* argv[])
 	// this makes for no delays when accessing content, but a longer startup time
 	ViewController::get()->preload();
 
+	// both need every system, a progressive boot starts them once the last one is added
+	SystemData::whenLoaded([]
+	{
+		// searching is ready soon after, the names are indexed in the background
+		GameSearchIndex::getInstance()->build();
+
+		// picks up ROMs added or removed while running, once the systems they belong to are loaded
+		if(Settings::getInstance()->getBool("WatchLibrary"))
+			LibraryWatcher::init();
+	});
+
 	if(splashScreen)
 		window.renderLoadingScreen("Done.");
 
 	InputManager::getInstance()->init();
 
+	setMemoryMeasures();
+	Metrics::bootDone();
+
+	// boot is over, the trace only covers how it got here
+	if(Utils::Timeline::isStarted())
+	{
+		Utils::Timeline::stop();
+
+		if(Utils::Timeline::save(boot_trace))
+			LOG(LogInfo) << "Boot timeline written to \"" << boot_trace << "\"";
+		else
+			LOG(LogError) << "Could not write boot timeline to \"" << boot_trace << "\"";
+	}
+
 	//choose which GUI to open depending on if an input configuration already exists
 	if(errorMsg == NULL)
 	{
-		if(Utils::FileSystem::exists(InputManager::getConfigPath()) && InputManager::getInstance()->getNumConfiguredDevices() > 0)
+		if(UIBenchmark::isActive())
+		{
+			// the benchmark brings its own input, there's nothing to configure
+			ViewController::get()->goToStart();
+			UIBenchmark::start(&window);
+		}else if(Utils::FileSystem::exists(InputManager::getConfigPath()) && InputManager::getInstance()->getNumConfiguredDevices() > 0)
 		{
 			ViewController::get()->goToStart();
 		}else{
@@ -419,6 +686,8 @@ int main(int argc, char* argv[])
 		}
 	}
 
+	FrameScheduler::init();
+
 	int lastTime = SDL_GetTicks();
 	int ps_time = SDL_GetTicks();
 
@@ -428,24 +697,39 @@ int main(int argc, char* argv[])
 	{
 		SDL_Event event;
 		bool ps_standby = PowerSaver::getState() && (int) SDL_GetTicks() - ps_time > PowerSaver::getMode();
+		const bool idle = FrameScheduler::isIdle();
+		const int timeout = ps_standby ? PowerSaver::getTimeout() : FrameScheduler::getTimeout();
 
-		if(ps_standby ? SDL_WaitEventTimeout(&event, PowerSaver::getTimeout()) : SDL_PollEvent(&event))
+		if((ps_standby || timeout > 0) ? SDL_WaitEventTimeout(&event, timeout) : SDL_PollEvent(&event))
 		{
+			bool input = false;
+
 			do
 			{
+				// only there to end the wait, a texture finished loading or a video frame was decoded
+				if(FrameScheduler::isWakeUpEvent(event))
+					continue;
+
 				InputManager::getInstance()->parseEvent(event, &window);
+				input = true;
 
 				if(event.type == SDL_QUIT)
 					running = false;
 			} while(SDL_PollEvent(&event));
 
-			// triggered if exiting from SDL_WaitEvent due to event
-			if (ps_standby)
-				// show as if continuing from last event
-				lastTime = SDL_GetTicks();
+			// input or the window needing a repaint, draw the next frame instead of only checking it
+			Renderer::requestRedraw();
 
-			// reset counter
-			ps_time = SDL_GetTicks();
+			if(input)
+			{
+				// triggered if exiting from SDL_WaitEvent due to event
+				if (ps_standby || idle)
+					// show as if continuing from last event
+					lastTime = SDL_GetTicks();
+
+				// reset counter
+				ps_time = SDL_GetTicks();
+			}
 		}
 		else if (ps_standby)
 		{
@@ -457,7 +741,7 @@ int main(int argc, char* argv[])
 		if(window.isSleeping())
 		{
 			lastTime = SDL_GetTicks();
-			SDL_Delay(1); // this doesn't need to be accurate, we're just giving up our CPU time until something wakes us up
+			FrameScheduler::frameDone(false); // nothing is drawn, wait for input like on an idle screen
 			continue;
 		}
 
@@ -469,23 +753,59 @@ int main(int argc, char* argv[])
 		if(deltaTime < 0)
 			deltaTime = 1000;
 
+		LibraryWatcher::update();
+		CollectionSystemManager::get()->populateOnIdle();
+		SystemData::indexFiltersOnIdle(&window);
+
+		if(UIBenchmark::isActive() && !UIBenchmark::update())
+			running = false;
+
 		window.update(deltaTime);
 		window.render();
 		Renderer::swapBuffers();
 
+		// there was no vsync to wait for when the frame was unchanged, the next wait makes up for it
+		FrameScheduler::frameDone(Renderer::isFramePresented());
+		Metrics::frameDone(deltaTime, Renderer::isFramePresented());
+		InputLatency::frameDone(Renderer::isFramePresented());
+
 		Log::flush();
 	}
 
 	while(window.peekGui() != ViewController::get())
 		delete window.peekGui();
 
+	// glyphs rasterized this session load straight from disk next time
+	Font::saveGlyphCaches();
+
+	// the systems a progressive boot was still loading use what's shut down below
+	SystemData::cancelLoading();
+
+	// the scripts of the last selections still run, they may turn off what they turned on
+	Scripting::deinit();
+
+	UIBenchmark::deinit();
+	BenchmarkLibrary::deinit();
 	InputManager::getInstance()->deinit();
 	window.deinit();
 
+	LibraryWatcher::deinit();
+	RomPrefetch::deinit();
+	MediaIndex::deinit();
+	GameSearchIndex::deinit();
+	RomHashIndex::deinit();
+	RomScanCache::deinit();
 	MameNames::deinit();
 	CollectionSystemManager::deinit();
 	SystemData::deleteSystems();
 
+	// systems save their gamelists when deleted, wait for that to hit the disk
+	GamelistWriter::deinit();
+	Settings::getInstance()->flush();
+
+	// last, the systems and indexes above may still have queued tasks
+	Utils::TaskScheduler::deinit();
+
 	// call this ONLY when linking with FreeImage as a static library
 #ifdef FREEIMAGE_LIB
 	FreeImage_DeInitialise();
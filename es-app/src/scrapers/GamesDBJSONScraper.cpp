@@ -1,5 +1,7 @@
 #include <exception>
+#include <limits>
 #include <map>
+#include <string.h>
 
 #include "scrapers/GamesDBJSONScraper.h"
 #include "scrapers/GamesDBJSONScraperResources.h"
@@ -22,8 +24,8 @@
 #endif // RAPIDJSON_ASSERT
 */
 
-#include <rapidjson/document.h>
 #include <rapidjson/error/en.h>
+#include <rapidjson/reader.h>
 
 using namespace PlatformIds;
 using namespace rapidjson;
@@ -179,115 +181,242 @@ void thegamesdb_generate_json_scraper_requests(const ScraperSearchParams& params
 namespace
 {
 
-std::string getStringOrThrow(const Value& v, const std::string& key)
+// What processGame needs of a game in the response
+struct GameFields
 {
-	if (!v.HasMember(key.c_str()) || !v[key.c_str()].IsString())
-	{
-		throw std::runtime_error("rapidjson internal assertion failure: missing or non string key:" + key);
-	}
-	return v[key.c_str()].GetString();
-}
+	int id;
+	bool hasId;
+	std::string title;
+	bool hasTitle;
+	std::string overview;
+	bool hasOverview;
+	std::string releaseDate;
+	bool hasReleaseDate;
+	int players;
+	bool hasPlayers;
+	std::vector<int> developers;
+	bool hasDevelopers;
+	std::vector<int> publishers;
+	bool hasPublishers;
+	std::vector<int> genres;
+	bool hasGenres;
+};
 
-int getIntOrThrow(const Value& v, const std::string& key)
+struct BoxartImage
 {
-	if (!v.HasMember(key.c_str()) || !v[key.c_str()].IsInt())
-	{
-		throw std::runtime_error("rapidjson internal assertion failure: missing or non int key:" + key);
-	}
-	return v[key.c_str()].GetInt();
-}
+	std::string type;
+	std::string side;
+	std::string filename;
+};
 
-int getIntOrThrow(const Value& v)
+// Picks the fields out of the response while it's parsed, nothing else of it is kept. The boxart of the games comes
+// after them, so it's kept by game id until the whole response was read. Every object and array that's open has a
+// frame, objects with the key of the member that's read
+class ResponseHandler : public BaseReaderHandler<UTF8<>, ResponseHandler>
 {
-	if (!v.IsInt())
+public:
+	ResponseHandler() : hasGames(false), hasBoxart(false), hasBoxartData(false), hasBaseUrl(false), hasThumbUrl(false), hasLargeUrl(false) {}
+
+	bool StartObject()
 	{
-		throw std::runtime_error("rapidjson internal assertion failure: not an int");
+		if (at({ "data", "games", "[]" }))
+			games.push_back(GameFields());
+		else if (at({ "include", "boxart", "data", "*", "[]" }))
+			boxart[frames[3].key].push_back(BoxartImage());
+		else if (at({ "include", "boxart", "base_url" }))
+			hasBaseUrl = true;
+		else if (at({ "include", "boxart", "data" }))
+			hasBoxartData = true;
+		else if (at({ "include", "boxart" }))
+			hasBoxart = true;
+
+		push(false);
+		return true;
 	}
-	return v.GetInt();
-}
 
-std::string getBoxartImage(const Value& v)
-{
-	if (!v.IsArray() || v.Size() == 0)
+	bool EndObject(SizeType)
 	{
-		return "";
+		frames.pop_back();
+		return true;
 	}
-	for (int i = 0; i < (int)v.Size(); ++i)
+
+	bool StartArray()
 	{
-		auto& im = v[i];
-		std::string type = getStringOrThrow(im, "type");
-		std::string side = getStringOrThrow(im, "side");
-		if (type == "boxart" && side == "front")
+		if (at({ "data", "games" }))
+			hasGames = true;
+		else if (at({ "data", "games", "[]", "*" }))
 		{
-			return getStringOrThrow(im, "filename");
+			const std::string& key = frames.back().key;
+			games.back().hasDevelopers |= (key == "developers");
+			games.back().hasPublishers |= (key == "publishers");
+			games.back().hasGenres |= (key == "genres");
 		}
+
+		push(true);
+		return true;
 	}
-	return getStringOrThrow(v[0], "filename");
-}
 
-std::string getDeveloperString(const Value& v)
-{
-	if (!v.IsArray())
+	bool EndArray(SizeType)
 	{
-		return "";
+		frames.pop_back();
+		return true;
 	}
-	std::string out = "";
-	bool first = true;
-	for (int i = 0; i < (int)v.Size(); ++i)
+
+	bool Key(const char* str, SizeType length, bool)
+	{
+		frames.back().key.assign(str, length);
+		return true;
+	}
+
+	bool String(const char* str, SizeType length, bool)
 	{
-		auto mapIt = resources.gamesdb_new_developers_map.find(getIntOrThrow(v[i]));
-		if (mapIt == resources.gamesdb_new_developers_map.cend())
+		if (at({ "data", "games", "[]", "*" }))
 		{
-			continue;
+			GameFields& game = games.back();
+			const std::string& key = frames.back().key;
+			if (key == "game_title")
+				set(game.title, game.hasTitle, str, length);
+			else if (key == "overview")
+				set(game.overview, game.hasOverview, str, length);
+			else if (key == "release_date")
+				set(game.releaseDate, game.hasReleaseDate, str, length);
 		}
-		if (!first)
+		else if (at({ "include", "boxart", "base_url", "*" }))
 		{
-			out += ", ";
+			const std::string& key = frames.back().key;
+			if (key == "thumb")
+				set(thumbUrl, hasThumbUrl, str, length);
+			else if (key == "large")
+				set(largeUrl, hasLargeUrl, str, length);
+		}
+		else if (at({ "include", "boxart", "data", "*", "[]", "*" }))
+		{
+			BoxartImage& image = boxart[frames[3].key].back();
+			const std::string& key = frames.back().key;
+			if (key == "type")
+				image.type.assign(str, length);
+			else if (key == "side")
+				image.side.assign(str, length);
+			else if (key == "filename")
+				image.filename.assign(str, length);
 		}
-		out += mapIt->second;
-		first = false;
-	}
-	return out;
-}
 
-std::string getPublisherString(const Value& v)
-{
-	if (!v.IsArray())
-	{
-		return "";
+		return true;
 	}
-	std::string out = "";
-	bool first = true;
-	for (int i = 0; i < (int)v.Size(); ++i)
+
+	bool Int(int i)
 	{
-		auto mapIt = resources.gamesdb_new_publishers_map.find(getIntOrThrow(v[i]));
-		if (mapIt == resources.gamesdb_new_publishers_map.cend())
+		if (at({ "data", "games", "[]", "*" }))
 		{
-			continue;
+			GameFields& game = games.back();
+			const std::string& key = frames.back().key;
+			if (key == "id")
+			{
+				game.id = i;
+				game.hasId = true;
+			}
+			else if (key == "players")
+			{
+				game.players = i;
+				game.hasPlayers = true;
+			}
 		}
-		if (!first)
+		else if (at({ "data", "games", "[]", "*", "[]" }))
 		{
-			out += ", ";
+			GameFields& game = games.back();
+			const std::string& key = frames[3].key;
+			if (key == "developers")
+				game.developers.push_back(i);
+			else if (key == "publishers")
+				game.publishers.push_back(i);
+			else if (key == "genres")
+				game.genres.push_back(i);
 		}
-		out += mapIt->second;
-		first = false;
+
+		return true;
+	}
+
+	bool Uint(unsigned u)
+	{
+		// the reader reports every positive number this way
+		return (u <= (unsigned)std::numeric_limits<int>::max()) ? Int((int)u) : true;
+	}
+
+	std::vector<GameFields> games;
+	std::map<std::string, std::vector<BoxartImage>> boxart; // by game id
+	std::string thumbUrl;
+	std::string largeUrl;
+	bool hasGames;
+	bool hasBoxart;
+	bool hasBoxartData;
+	bool hasBaseUrl;
+	bool hasThumbUrl;
+	bool hasLargeUrl;
+
+private:
+	struct Frame
+	{
+		bool array;
+		std::string key;
+	};
+
+	void push(bool array)
+	{
+		const Frame frame = { array, std::string() };
+		frames.push_back(frame);
+	}
+
+	static void set(std::string& value, bool& has, const char* str, SizeType length)
+	{
+		value.assign(str, length);
+		has = true;
+	}
+
+	// whether what's read now is at path from the root object, "[]" for the elements of an array and "*" for any key
+	bool at(std::initializer_list<const char*> path) const
+	{
+		if (path.size() != frames.size())
+			return false;
+
+		auto key = path.begin();
+		for (auto it = frames.cbegin(); it != frames.cend(); ++it, ++key)
+		{
+			if (it->array ? (strcmp(*key, "[]") != 0) : ((strcmp(*key, "*") != 0) && (it->key != *key)))
+				return false;
+		}
+
+		return true;
 	}
-	return out;
-}
 
-std::string getGenreString(const Value& v)
+	std::vector<Frame> frames;
+};
+
+std::string getBoxartImage(const std::vector<BoxartImage>& images)
 {
-	if (!v.IsArray())
+	if (images.empty())
 	{
 		return "";
 	}
+	for (auto it = images.cbegin(); it != images.cend(); ++it)
+	{
+		if (it->type == "boxart" && it->side == "front")
+		{
+			return it->filename;
+		}
+	}
+	return images.front().filename;
+}
+
+std::string getNamesString(const std::vector<int>& ids, const std::unordered_map<int, std::string>& names)
+{
 	std::string out = "";
 	bool first = true;
-	for (int i = 0; i < (int)v.Size(); ++i)
+	for (auto it = ids.cbegin(); it != ids.cend(); ++it)
 	{
-		auto mapIt = resources.gamesdb_new_genres_map.find(getIntOrThrow(v[i]));
-		if (mapIt == resources.gamesdb_new_genres_map.cend())
+		auto mapIt = names.find(*it);
+		if (mapIt == names.cend())
 		{
+			resources.noteMissing();
 			continue;
 		}
 		if (!first)
@@ -300,50 +429,51 @@ std::string getGenreString(const Value& v)
 	return out;
 }
 
-void processGame(const Value& game, const Value& boxart, std::vector<ScraperSearchResult>& results)
+void processGame(const GameFields& game, const ResponseHandler& response, std::vector<ScraperSearchResult>& results)
 {
-	std::string baseImageUrlThumb = getStringOrThrow(boxart["base_url"], "thumb");
-	std::string baseImageUrlLarge = getStringOrThrow(boxart["base_url"], "large");
+	if (!game.hasTitle)
+	{
+		LOG(LogError) << "Error while processing game: missing or non string key: game_title";
+		return;
+	}
 
 	ScraperSearchResult result;
 
-	result.mdl.set("name", getStringOrThrow(game, "game_title"));
-	if (game.HasMember("overview") && game["overview"].IsString())
+	result.mdl.set("name", game.title);
+	if (game.hasOverview)
 	{
-		result.mdl.set("desc", game["overview"].GetString());
+		result.mdl.set("desc", game.overview);
 	}
-	if (game.HasMember("release_date") && game["release_date"].IsString())
+	if (game.hasReleaseDate)
 	{
 		result.mdl.set(
-			"releasedate", Utils::Time::DateTime(Utils::Time::stringToTime(game["release_date"].GetString(), "%Y-%m-%d")));
+			"releasedate", Utils::Time::DateTime(Utils::Time::stringToTime(game.releaseDate, "%Y-%m-%d")));
 	}
-	if (game.HasMember("developers") && game["developers"].IsArray())
+	if (game.hasDevelopers)
 	{
-		result.mdl.set("developer", getDeveloperString(game["developers"]));
+		result.mdl.set("developer", getNamesString(game.developers, resources.gamesdb_new_developers_map));
 	}
-	if (game.HasMember("publishers") && game["publishers"].IsArray())
+	if (game.hasPublishers)
 	{
-		result.mdl.set("publisher", getPublisherString(game["publishers"]));
+		result.mdl.set("publisher", getNamesString(game.publishers, resources.gamesdb_new_publishers_map));
 	}
-	if (game.HasMember("genres") && game["genres"].IsArray())
+	if (game.hasGenres)
 	{
-
-		result.mdl.set("genre", getGenreString(game["genres"]));
+		result.mdl.set("genre", getNamesString(game.genres, resources.gamesdb_new_genres_map));
 	}
-	if (game.HasMember("players") && game["players"].IsInt())
+	if (game.hasPlayers)
 	{
-		result.mdl.set("players", std::to_string(game["players"].GetInt()));
+		result.mdl.set("players", std::to_string(game.players));
 	}
 
-
-	if (boxart.HasMember("data") && boxart["data"].IsObject())
+	if (game.hasId)
 	{
-		std::string id = std::to_string(getIntOrThrow(game, "id"));
-		if (boxart["data"].HasMember(id.c_str()))
+		auto boxartIt = response.boxart.find(std::to_string(game.id));
+		if (boxartIt != response.boxart.cend())
 		{
-		    std::string image = getBoxartImage(boxart["data"][id.c_str()]);
-		    result.thumbnailUrl = baseImageUrlThumb + "/" + image;
-		    result.imageUrl = baseImageUrlLarge + "/" + image;
+		    std::string image = getBoxartImage(boxartIt->second);
+		    result.thumbnailUrl = response.thumbUrl + "/" + image;
+		    result.imageUrl = response.largeUrl + "/" + image;
 		}
 	}
 
@@ -351,40 +481,36 @@ void processGame(const Value& game, const Value& boxart, std::vector<ScraperSear
 }
 } // namespace
 
-void TheGamesDBJSONRequest::process(const std::unique_ptr<HttpReq>& req, std::vector<ScraperSearchResult>& results)
+void TheGamesDBJSONRequest::process(const std::string& content, std::vector<ScraperSearchResult>& results)
 {
-	assert(req->status() == HttpReq::REQ_SUCCESS);
-
-	Document doc;
-	doc.Parse(req->getContent().c_str());
+	ResponseHandler response;
+	Reader reader;
+	StringStream stream(content.c_str());
 
-	if (doc.HasParseError())
+	if (!reader.Parse(stream, response))
 	{
 		std::string err =
-			std::string("TheGamesDBJSONRequest - Error parsing JSON. \n\t") + GetParseError_En(doc.GetParseError());
+			std::string("TheGamesDBJSONRequest - Error parsing JSON. \n\t") + GetParseError_En(reader.GetParseErrorCode());
 		setError(err);
 		LOG(LogError) << err;
 		return;
 	}
 
-	if (!doc.HasMember("data") || !doc["data"].HasMember("games") || !doc["data"]["games"].IsArray())
+	if (!response.hasGames)
 	{
 		std::string warn = "TheGamesDBJSONRequest - Response had no game data.\n";
 		LOG(LogWarning) << warn;
 		return;
 	}
-	const Value& games = doc["data"]["games"];
 
-	if (!doc.HasMember("include") || !doc["include"].HasMember("boxart"))
+	if (!response.hasBoxart)
 	{
 		std::string warn = "TheGamesDBJSONRequest - Response had no include boxart data.\n";
 		LOG(LogWarning) << warn;
 		return;
 	}
 
-	const Value& boxart = doc["include"]["boxart"];
-
-	if (!boxart.HasMember("base_url") || !boxart.HasMember("data") || !boxart.IsObject())
+	if (!response.hasBaseUrl || !response.hasBoxartData || !response.hasThumbUrl || !response.hasLargeUrl)
 	{
 		std::string warn = "TheGamesDBJSONRequest - Response include had no usable boxart data.\n";
 		LOG(LogWarning) << warn;
@@ -393,17 +519,6 @@ void TheGamesDBJSONRequest::process(const std::unique_ptr<HttpReq>& req, std::ve
 
 	resources.ensureResources();
 
-
-	for (int i = 0; i < (int)games.Size(); ++i)
-	{
-		auto& v = games[i];
-		try
-		{
-			processGame(v, boxart, results);
-		}
-		catch (std::runtime_error& e)
-		{
-			LOG(LogError) << "Error while processing game: " << e.what();
-		}
-	}
+	for (auto it = response.games.cbegin(); it != response.games.cend(); ++it)
+		processGame(*it, response, results);
 }
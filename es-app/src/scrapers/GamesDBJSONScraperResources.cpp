@@ -1,11 +1,15 @@
 #include <chrono>
 #include <fstream>
 #include <memory>
+#include <sstream>
+#include <string.h>
 #include <thread>
+#include <time.h>
 
 #include "Log.h"
 
 #include "scrapers/GamesDBJSONScraperResources.h"
+#include "utils/BinaryUtil.h"
 #include "utils/FileSystemUtil.h"
 
 
@@ -21,10 +25,15 @@ constexpr char GamesDBAPIKey[] = "445fcbc3f32bb2474bc27016b99eb963d318ee3a608212
 
 
 constexpr int MAX_WAIT_MS = 90000;
-constexpr int POLL_TIME_MS = 500;
+constexpr int POLL_TIME_MS = 50;
 constexpr int MAX_WAIT_ITER = MAX_WAIT_MS / POLL_TIME_MS;
 
+// names are refreshed once they're this old, or a day after the last refresh when a game refers to an unknown id
+constexpr int64_t REFRESH_AGE = 30 * 24 * 60 * 60;
+constexpr int64_t MISSING_REFRESH_AGE = 24 * 60 * 60;
+
 constexpr char SCRAPER_RESOURCES_DIR[] = "scrapers";
+constexpr char CACHE_FILE[] = "gamesdb_resources.cache";
 constexpr char DEVELOPERS_JSON_FILE[] = "gamesdb_developers.json";
 constexpr char PUBLISHERS_JSON_FILE[] = "gamesdb_publishers.json";
 constexpr char GENRES_JSON_FILE[] = "gamesdb_genres.json";
@@ -32,18 +41,14 @@ constexpr char DEVELOPERS_ENDPOINT[] = "/Developers";
 constexpr char PUBLISHERS_ENDPOINT[] = "/Publishers";
 constexpr char GENRES_ENDPOINT[] = "/Genres";
 
+constexpr char CACHE_MAGIC[4] = { 'E', 'S', 'G', 'R' };
+constexpr uint32_t CACHE_VERSION = 1;
+
 std::string genFilePath(const std::string& file_name)
 {
 	return Utils::FileSystem::getGenericPath(getScrapersResouceDir() + "/" + file_name);
 }
 
-void ensureScrapersResourcesDir()
-{
-	std::string path = getScrapersResouceDir();
-	if (!Utils::FileSystem::exists(path))
-		Utils::FileSystem::createDirectory(path);
-}
-
 } // namespace
 
 
@@ -53,135 +58,289 @@ std::string getScrapersResouceDir()
 		Utils::FileSystem::getHomePath() + "/.emulationstation/" + SCRAPER_RESOURCES_DIR);
 }
 
+TheGamesDBJSONRequestResources::TheGamesDBJSONRequestResources() : mStored(0), mLoaded(false), mChanged(false)
+{
+	mResources[0].name = "developers";
+	mResources[0].endpoint = DEVELOPERS_ENDPOINT;
+	mResources[0].jsonFile = DEVELOPERS_JSON_FILE;
+	mResources[0].map = &gamesdb_new_developers_map;
+
+	mResources[1].name = "publishers";
+	mResources[1].endpoint = PUBLISHERS_ENDPOINT;
+	mResources[1].jsonFile = PUBLISHERS_JSON_FILE;
+	mResources[1].map = &gamesdb_new_publishers_map;
+
+	mResources[2].name = "genres";
+	mResources[2].endpoint = GENRES_ENDPOINT;
+	mResources[2].jsonFile = GENRES_JSON_FILE;
+	mResources[2].map = &gamesdb_new_genres_map;
+}
+
 std::string TheGamesDBJSONRequestResources::getApiKey() const { return GamesDBAPIKey; }
 
 
 void TheGamesDBJSONRequestResources::prepare()
 {
-	if (checkLoaded())
+	if (!mLoaded)
 	{
-		return;
-	}
+		mLoaded = true;
 
-	if (loadResource(gamesdb_new_developers_map, "developers", genFilePath(DEVELOPERS_JSON_FILE)) &&
-		!gamesdb_developers_resource_request)
-	{
-		gamesdb_developers_resource_request = fetchResource(DEVELOPERS_ENDPOINT);
-	}
-	if (loadResource(gamesdb_new_publishers_map, "publishers", genFilePath(PUBLISHERS_JSON_FILE)) &&
-		!gamesdb_publishers_resource_request)
-	{
-		gamesdb_publishers_resource_request = fetchResource(PUBLISHERS_ENDPOINT);
-	}
-	if (loadResource(gamesdb_new_genres_map, "genres", genFilePath(GENRES_JSON_FILE)) && !gamesdb_genres_resource_request)
-	{
-		gamesdb_genres_resource_request = fetchResource(GENRES_ENDPOINT);
+		if (!loadCache() && importJson())
+			saveCache();
+
+		if (!checkLoaded() || ((time(NULL) - mStored) > REFRESH_AGE))
+			startRefresh();
 	}
+
+	update();
 }
 
 void TheGamesDBJSONRequestResources::ensureResources()
 {
+	update();
 
+	// names that are a bit old are still better than holding up the scrape
 	if (checkLoaded())
 	{
 		return;
 	}
 
-
+	// nothing to go on yet, the first scrape ever waits for the downloads
 	for (int i = 0; i < MAX_WAIT_ITER; ++i)
 	{
-		if (gamesdb_developers_resource_request &&
-			saveResource(gamesdb_developers_resource_request.get(), gamesdb_new_developers_map, "developers",
-				genFilePath(DEVELOPERS_JSON_FILE)))
-		{
-
-			gamesdb_developers_resource_request.reset(nullptr);
-		}
-		if (gamesdb_publishers_resource_request &&
-			saveResource(gamesdb_publishers_resource_request.get(), gamesdb_new_publishers_map, "publishers",
-				genFilePath(PUBLISHERS_JSON_FILE)))
-		{
-			gamesdb_publishers_resource_request.reset(nullptr);
-		}
-		if (gamesdb_genres_resource_request && saveResource(gamesdb_genres_resource_request.get(), gamesdb_new_genres_map,
-												   "genres", genFilePath(GENRES_JSON_FILE)))
-		{
-			gamesdb_genres_resource_request.reset(nullptr);
-		}
+		bool downloading = false;
+		for (int r = 0; r < RESOURCE_COUNT; ++r)
+			downloading |= (mResources[r].request != nullptr);
 
-		if (!gamesdb_developers_resource_request && !gamesdb_publishers_resource_request && !gamesdb_genres_resource_request)
+		if (!downloading)
 		{
 			return;
 		}
+
 		std::this_thread::sleep_for(std::chrono::milliseconds(POLL_TIME_MS));
+		update();
 	}
 	LOG(LogError) << "Timed out while waiting for resources\n";
 }
 
+void TheGamesDBJSONRequestResources::noteMissing()
+{
+	if ((time(NULL) - mStored) > MISSING_REFRESH_AGE)
+		startRefresh();
+}
+
 bool TheGamesDBJSONRequestResources::checkLoaded()
 {
 	return !gamesdb_new_genres_map.empty() && !gamesdb_new_developers_map.empty() && !gamesdb_new_publishers_map.empty();
 }
 
-bool TheGamesDBJSONRequestResources::saveResource(HttpReq* req, std::unordered_map<int, std::string>& resource,
-	const std::string& resource_name, const std::string& file_name)
+void TheGamesDBJSONRequestResources::startRefresh()
 {
-
-	if (req == nullptr)
+	for (int r = 0; r < RESOURCE_COUNT; ++r)
 	{
-		LOG(LogError) << "Http request pointer was null\n";
-		return true;
+		if (!mResources[r].request)
+			mResources[r].request = fetchResource(mResources[r]);
 	}
-	if (req->status() == HttpReq::REQ_IN_PROGRESS)
+
+	// a refresh that fails isn't tried again right away
+	mStored = time(NULL);
+}
+
+void TheGamesDBJSONRequestResources::update()
+{
+	bool downloading = false;
+
+	for (int r = 0; r < RESOURCE_COUNT; ++r)
 	{
-		return false; // Not ready: wait some more
+		Resource& resource = mResources[r];
+
+		if (!resource.request)
+			continue;
+
+		const HttpReq::Status status = resource.request->status();
+
+		if (status == HttpReq::REQ_IN_PROGRESS)
+		{
+			downloading = true;
+			continue;
+		}
+
+		if (status != HttpReq::REQ_SUCCESS)
+		{
+			LOG(LogError) << "Resource request for " << resource.name << " failed:\n\t" << resource.request->getErrorMsg();
+		}
+		else if (resource.request->getResponseCode() != 304)
+		{
+			// only replace what's there with a list that parsed
+			std::unordered_map<int, std::string> map;
+			if (parseResource(resource.request->getContent(), map, resource.name))
+			{
+				resource.map->swap(map);
+				resource.etag = resource.request->getHeader("etag");
+				resource.lastModified = resource.request->getHeader("last-modified");
+				mChanged = true;
+			}
+		}
+		else
+		{
+			// unchanged, but it counts as refreshed
+			mChanged = true;
+		}
+
+		resource.request.reset(nullptr);
 	}
-	if (req->status() != HttpReq::REQ_SUCCESS)
+
+	if (!downloading && mChanged)
 	{
-		LOG(LogError) << "Resource request for " << file_name << " failed:\n\t" << req->getErrorMsg();
-		return true; // Request failed, resetting request.
+		mStored = time(NULL);
+		saveCache();
+		mChanged = false;
 	}
-
-	ensureScrapersResourcesDir();
-
-	std::ofstream fout(file_name);
-	fout << req->getContent();
-	fout.close();
-	loadResource(resource, resource_name, file_name);
-	return true;
 }
 
-std::unique_ptr<HttpReq> TheGamesDBJSONRequestResources::fetchResource(const std::string& endpoint)
+std::unique_ptr<HttpReq> TheGamesDBJSONRequestResources::fetchResource(const Resource& resource)
 {
 	std::string path = "https://api.thegamesdb.net/v1";
-	path += endpoint;
+	path += resource.endpoint;
 	path += "?apikey=" + getApiKey();
 
-	return std::unique_ptr<HttpReq>(new HttpReq(path));
+	// the lists rarely change, an unchanged one doesn't have to be sent again
+	std::vector<std::string> headers;
+	if (!resource.map->empty())
+	{
+		if (!resource.etag.empty())
+			headers.push_back("If-None-Match: " + resource.etag);
+		if (!resource.lastModified.empty())
+			headers.push_back("If-Modified-Since: " + resource.lastModified);
+	}
+
+	return std::unique_ptr<HttpReq>(new HttpReq(path, headers));
 }
 
+bool TheGamesDBJSONRequestResources::loadCache()
+{
+	std::string buffer;
+
+	if (!Utils::Binary::loadFile(genFilePath(CACHE_FILE), buffer))
+		return false;
+
+	Utils::Binary::Reader reader(buffer);
+	char magic[4];
+	uint32_t version;
+	int64_t stored;
+
+	if (!reader.read(magic, sizeof(magic)) || memcmp(magic, CACHE_MAGIC, sizeof(magic)) ||
+		!reader.read(version) || (version != CACHE_VERSION) || !reader.read(stored))
+	{
+		LOG(LogWarning) << "TheGamesDB resource cache is invalid or outdated, ignoring it";
+		return false;
+	}
+
+	for (int r = 0; r < RESOURCE_COUNT; ++r)
+	{
+		Resource& resource = mResources[r];
+		std::string name;
+		uint32_t count;
+
+		// every entry takes at least 8 bytes, anything claiming more than what's left is garbage
+		if (!reader.readString(name) || (name != resource.name) || !reader.readString(resource.etag) ||
+			!reader.readString(resource.lastModified) || !reader.read(count) || (count > (reader.getRemaining() / 8)))
+		{
+			LOG(LogWarning) << "TheGamesDB resource cache is truncated, ignoring it";
+			return false;
+		}
+
+		resource.map->clear();
+		resource.map->reserve(count);
+
+		for (uint32_t i = 0; i < count; ++i)
+		{
+			int32_t id;
+			std::string value;
+
+			if (!reader.read(id) || !reader.readString(value))
+			{
+				LOG(LogWarning) << "TheGamesDB resource cache is truncated, ignoring it";
+				return false;
+			}
+
+			(*resource.map)[id] = value;
+		}
+	}
+
+	mStored = stored;
+	return true;
+}
 
-int TheGamesDBJSONRequestResources::loadResource(
-	std::unordered_map<int, std::string>& resource, const std::string& resource_name, const std::string& file_name)
+void TheGamesDBJSONRequestResources::saveCache()
 {
+	Utils::Binary::Writer writer;
 
+	writer.write(CACHE_MAGIC, sizeof(CACHE_MAGIC));
+	writer.write(CACHE_VERSION);
+	writer.write(mStored);
 
-	std::ifstream fin(file_name);
-	if (!fin.good())
+	for (int r = 0; r < RESOURCE_COUNT; ++r)
 	{
-		return 1;
+		const Resource& resource = mResources[r];
+
+		writer.writeString(resource.name);
+		writer.writeString(resource.etag);
+		writer.writeString(resource.lastModified);
+		writer.write((uint32_t)resource.map->size());
+
+		for (auto it = resource.map->cbegin(); it != resource.map->cend(); ++it)
+		{
+			writer.write((int32_t)it->first);
+			writer.writeString(it->second);
+		}
 	}
-	std::stringstream buffer;
-	buffer << fin.rdbuf();
+
+	if (!Utils::Binary::saveFile(genFilePath(CACHE_FILE), writer.getBuffer()))
+		LOG(LogError) << "Could not write TheGamesDB resource cache";
+}
+
+bool TheGamesDBJSONRequestResources::importJson()
+{
+	bool imported = false;
+
+	for (int r = 0; r < RESOURCE_COUNT; ++r)
+	{
+		const std::string file_name = genFilePath(mResources[r].jsonFile);
+		std::ifstream fin(file_name);
+		if (!fin.good())
+		{
+			continue;
+		}
+
+		std::stringstream buffer;
+		buffer << fin.rdbuf();
+		fin.close();
+
+		if (parseResource(buffer.str(), *mResources[r].map, mResources[r].name))
+		{
+			imported = true;
+			Utils::FileSystem::removeFile(file_name);
+		}
+	}
+
+	// their age is unknown, so they get refreshed right away
+	mStored = 0;
+	return imported;
+}
+
+bool TheGamesDBJSONRequestResources::parseResource(
+	const std::string& json, std::unordered_map<int, std::string>& resource, const std::string& resource_name)
+{
 	Document doc;
-	doc.Parse(buffer.str().c_str());
+	doc.Parse(json.c_str());
 
 	if (doc.HasParseError())
 	{
-		std::string err = std::string("TheGamesDBJSONRequest - Error parsing JSON for resource file ") + file_name +
+		std::string err = std::string("TheGamesDBJSONRequest - Error parsing JSON for resource ") + resource_name +
 						  ":\n\t" + GetParseError_En(doc.GetParseError());
 		LOG(LogError) << err;
-		return 1;
+		return false;
 	}
 
 	if (!doc.HasMember("data") || !doc["data"].HasMember(resource_name.c_str()) ||
@@ -189,7 +348,7 @@ int TheGamesDBJSONRequestResources::loadResource(
 	{
 		std::string err = "TheGamesDBJSONRequest - Response had no resource data.\n";
 		LOG(LogError) << err;
-		return 1;
+		return false;
 	}
 	auto& data = doc["data"][resource_name.c_str()];
 
@@ -203,5 +362,5 @@ int TheGamesDBJSONRequestResources::loadResource(
 		}
 		resource[entry["id"].GetInt()] = entry["name"].GetString();
 	}
-	return resource.empty();
+	return !resource.empty();
 }
@@ -2,39 +2,64 @@
 #ifndef ES_APP_SCRAPERS_GAMES_DB_JSON_SCRAPER_RESOURCES_H
 #define ES_APP_SCRAPERS_GAMES_DB_JSON_SCRAPER_RESOURCES_H
 
-#include <fstream>
 #include <memory>
+#include <stdint.h>
 #include <string>
 #include <unordered_map>
 
 #include "HttpReq.h"
 
 
+// The developer, publisher and genre names TheGamesDB refers to by id. They're kept on disk in a binary cache that
+// loads in no time, and refreshed in the background once it gets old or a game refers to an id it doesn't know.
+// Only the very first scrape has to wait for them to download.
 struct TheGamesDBJSONRequestResources
 {
-	TheGamesDBJSONRequestResources() = default;
+	TheGamesDBJSONRequestResources();
 
 	void prepare();
 	void ensureResources();
 	std::string getApiKey() const;
 
+	// a game referred to a name that isn't known, there may be new ones on the server
+	void noteMissing();
+
 	std::unordered_map<int, std::string> gamesdb_new_developers_map;
 	std::unordered_map<int, std::string> gamesdb_new_publishers_map;
 	std::unordered_map<int, std::string> gamesdb_new_genres_map;
 
   private:
+	struct Resource
+	{
+		const char* name;
+		const char* endpoint;
+		const char* jsonFile; // how the maps used to be kept, imported when there's no cache yet
+		std::unordered_map<int, std::string>* map;
+		std::unique_ptr<HttpReq> request;
+		std::string etag;
+		std::string lastModified;
+	};
+
+	static const int RESOURCE_COUNT = 3;
+
 	bool checkLoaded();
 
-	bool saveResource(HttpReq* req, std::unordered_map<int, std::string>& resource, const std::string& resource_name,
-		const std::string& file_name);
-	std::unique_ptr<HttpReq> fetchResource(const std::string& endpoint);
+	// polls the downloads, the ones that are done replace their map and get saved
+	void update();
+	void startRefresh();
+	std::unique_ptr<HttpReq> fetchResource(const Resource& resource);
+
+	bool loadCache();
+	void saveCache();
+	bool importJson();
 
-	int loadResource(
-		std::unordered_map<int, std::string>& resource, const std::string& resource_name, const std::string& file_name);
+	static bool parseResource(
+		const std::string& json, std::unordered_map<int, std::string>& resource, const std::string& resource_name);
 
-	std::unique_ptr<HttpReq> gamesdb_developers_resource_request;
-	std::unique_ptr<HttpReq> gamesdb_publishers_resource_request;
-	std::unique_ptr<HttpReq> gamesdb_genres_resource_request;
+	Resource mResources[RESOURCE_COUNT];
+	int64_t mStored;
+	bool mLoaded;
+	bool mChanged;
 };
 
 std::string getScrapersResouceDir();
@@ -1,12 +1,18 @@
 #include "scrapers/Scraper.h"
 
+#include "scrapers/ScraperRateLimiter.h"
+#include "utils/ProfilingUtil.h"
+#include "utils/TaskScheduler.h"
 #include "FileData.h"
 #include "GamesDBJSONScraper.h"
 #include "ScreenScraper.h"
 #include "Log.h"
+#include "MediaIndex.h"
+#include "RomHashIndex.h"
 #include "Settings.h"
 #include "SystemData.h"
 #include <FreeImage.h>
+#include <time.h>
 #include <fstream>
 
 const std::map<std::string, generate_scraper_requests_func> scraper_request_funcs {
@@ -14,6 +20,12 @@ const std::map<std::string, generate_scraper_requests_func> scraper_request_func
 	{ "ScreenScraper", &screenscraper_generate_scraper_requests }
 };
 
+// ScreenScraper only gives anonymous clients a single thread, TheGamesDB limits by requests per month instead
+const std::map<std::string, int> scraper_max_searches {
+	{ "TheGamesDB", 4 },
+	{ "ScreenScraper", 1 }
+};
+
 std::unique_ptr<ScraperSearchHandle> startScraperSearch(const ScraperSearchParams& params)
 {
 	const std::string& name = Settings::getInstance()->getString("Scraper");
@@ -26,7 +38,24 @@ std::unique_ptr<ScraperSearchHandle> startScraperSearch(const ScraperSearchParam
 	}
 	else
 	{
-		scraper_request_funcs.at(name)(params, handle->mRequestQueue, handle->mResults);
+		ScraperSearchParams search = params;
+		RomHashIndex::Hashes hashes;
+
+		// hashes identify the ROM where the file name doesn't, games not hashed yet are queued for the next search
+		if(RomHashIndex::isEnabled())
+		{
+			if(RomHashIndex::getInstance()->get(search.game->getPath(), hashes))
+			{
+				search.crc32 = hashes.crc32;
+				search.md5 = hashes.md5;
+				search.sha1 = hashes.sha1;
+				search.romSize = hashes.size;
+			}
+			else
+				RomHashIndex::getInstance()->queue(search.game->getPath());
+		}
+
+		scraper_request_funcs.at(name)(search, handle->mRequestQueue, handle->mResults);
 	}
 
 	return handle;
@@ -49,6 +78,12 @@ bool isValidConfiguredScraper()
 	return scraper_request_funcs.find(name) != scraper_request_funcs.end();
 }
 
+int getScraperMaxSearches()
+{
+	auto it = scraper_max_searches.find(Settings::getInstance()->getString("Scraper"));
+	return (it != scraper_max_searches.cend()) ? it->second : 1;
+}
+
 // ScraperSearchHandle
 ScraperSearchHandle::ScraperSearchHandle()
 {
@@ -104,33 +139,179 @@ ScraperRequest::ScraperRequest(std::vector<ScraperSearchResult>& resultsWrite) :
 }
 
 
+// Retry-After holds either seconds or a date, -1 when there is none
+static int getRetryAfter(const std::string& value)
+{
+	if(value.empty())
+		return -1;
+
+	if(value.find_first_not_of("0123456789") == std::string::npos)
+		return atoi(value.c_str());
+
+	const time_t date = curl_getdate(value.c_str(), NULL);
+	if(date == -1)
+		return -1;
+
+	const time_t now = time(NULL);
+	return (date > now) ? (int)(date - now) : 0;
+}
+
+ScraperTimings& getScraperTimings()
+{
+	static ScraperTimings timings;
+	return timings;
+}
+
+static uint64_t getMicrosSince(const std::chrono::steady_clock::time_point& start)
+{
+	return (uint64_t)std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - start).count();
+}
+
 // ScraperHttpRequest
 ScraperHttpRequest::ScraperHttpRequest(std::vector<ScraperSearchResult>& resultsWrite, const std::string& url)
-	: ScraperRequest(resultsWrite)
+	: ScraperRequest(resultsWrite), mUrl(url), mHost(ScraperRateLimiter::getHost(url)), mPending(true), mMissing(false), mRetries(0)
 {
 	setStatus(ASYNC_IN_PROGRESS);
-	mReq = std::unique_ptr<HttpReq>(new HttpReq(url));
+	getScraperTimings().requests++;
+
+	if(ScraperCache::isEnabled() && ScraperCache::load(mUrl, mCached))
+	{
+		// a recent reply is used as it is, update() processes it
+		if(ScraperCache::isFresh(mCached))
+		{
+			if(ScraperCache::getMode() == ScraperCache::MODE_REPLAY)
+				getScraperTimings().replayed++;
+
+			mPending = false;
+			return;
+		}
+
+		// an older one is only sent again when it changed
+		if(!mCached.etag.empty())
+			mHeaders.push_back("If-None-Match: " + mCached.etag);
+		if(!mCached.lastModified.empty())
+			mHeaders.push_back("If-Modified-Since: " + mCached.lastModified);
+	}
+
+	// a replay never goes online, update() fails it instead
+	if(ScraperCache::getMode() == ScraperCache::MODE_REPLAY)
+	{
+		getScraperTimings().missing++;
+		mMissing = true;
+		mPending = false;
+		return;
+	}
+
+	start();
+}
+
+ScraperHttpRequest::~ScraperHttpRequest()
+{
+	// still in flight, the limiter would wait for it forever
+	if(mReq && (mStatus == ASYNC_IN_PROGRESS))
+		ScraperRateLimiter::cancelled(mHost);
+}
+
+void ScraperHttpRequest::start()
+{
+	if(!ScraperRateLimiter::tryAcquire(mHost))
+		return;
+
+	mReq = std::unique_ptr<HttpReq>(mHeaders.empty() ? new HttpReq(mUrl) : new HttpReq(mUrl, mHeaders));
+	mStartTime = std::chrono::steady_clock::now();
+	mPending = false;
 }
 
 void ScraperHttpRequest::update()
 {
-	HttpReq::Status status = mReq->status();
-	if(status == HttpReq::REQ_SUCCESS)
+	if(mStatus != ASYNC_IN_PROGRESS)
+		return;
+
+	if(mMissing)
+	{
+		setError("Reply was not recorded");
+		return;
+	}
+
+	if(mPending)
+	{
+		start();
+		if(mPending)
+			return;
+	}
+
+	if(!mReq)
 	{
 		setStatus(ASYNC_DONE); // if process() has an error, status will be changed to ASYNC_ERROR
-		process(mReq, mResults);
+		parse(mCached.content);
 		return;
 	}
 
+	HttpReq::Status status = mReq->status();
+
 	// not ready yet
 	if(status == HttpReq::REQ_IN_PROGRESS)
 		return;
 
+	const double latency = std::chrono::duration<double>(std::chrono::steady_clock::now() - mStartTime).count();
+
+	if(status == HttpReq::REQ_SUCCESS)
+	{
+		const long code = mReq->getResponseCode();
+
+		ScraperRateLimiter::finished(mHost, code, latency, getRetryAfter(mReq->getHeader("retry-after")));
+
+		// the server was too busy, ask again once the limiter lets it through
+		if(ScraperRateLimiter::isThrottled(code) && (mRetries < MAX_SCRAPER_RETRIES))
+		{
+			mRetries++;
+			mReq.reset();
+			mPending = true;
+			return;
+		}
+
+		if((code == 304) && (mCached.stored != 0))
+		{
+			// still the same, the cached reply counts as recent again
+			mCached.stored = time(NULL);
+			ScraperCache::save(mUrl, mCached);
+
+			setStatus(ASYNC_DONE);
+			parse(mCached.content);
+			return;
+		}
+
+		setStatus(ASYNC_DONE); // if process() has an error, status will be changed to ASYNC_ERROR
+		parse(mReq->getContent());
+
+		// only replies that made sense are worth keeping, errors get asked for again
+		if((code == 200) && (mStatus == ASYNC_DONE) && ScraperCache::isEnabled())
+		{
+			ScraperCache::Entry entry;
+			entry.content = mReq->getContent();
+			entry.etag = mReq->getHeader("etag");
+			entry.lastModified = mReq->getHeader("last-modified");
+			entry.stored = time(NULL);
+			ScraperCache::save(mUrl, entry);
+		}
+		return;
+	}
+
 	// everything else is some sort of error
+	ScraperRateLimiter::finished(mHost, 0, latency, -1);
 	LOG(LogError) << "ScraperHttpRequest network error (status: " << status << ") - " << mReq->getErrorMsg();
 	setError(mReq->getErrorMsg());
 }
 
+void ScraperHttpRequest::parse(const std::string& content)
+{
+	ProfileScope(__PRETTY_FUNCTION__);
+
+	const std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+	process(content, mResults);
+	getScraperTimings().parseMicros += getMicrosSince(start);
+}
+
 
 // metadata resolving stuff
 
@@ -200,50 +381,147 @@ std::unique_ptr<ImageDownloadHandle> downloadImageAsync(const std::string& url,
 }
 
 ImageDownloadHandle::ImageDownloadHandle(const std::string& url, const std::string& path, int maxWidth, int maxHeight) :
-	mSavePath(path), mMaxWidth(maxWidth), mMaxHeight(maxHeight), mReq(new HttpReq(url))
+	mUrl(url), mSavePath(path), mMaxWidth(maxWidth), mMaxHeight(maxHeight), mStreamed(false)
 {
+	getScraperTimings().images++;
+
+	const ScraperCache::Mode mode = ScraperCache::getMode();
+
+	if(mode == ScraperCache::MODE_REPLAY)
+	{
+		ScraperCache::Entry cached;
+
+		if(!ScraperCache::load(url, cached))
+		{
+			getScraperTimings().missing++;
+			setError("Image was not recorded");
+			return;
+		}
+
+		getScraperTimings().replayed++;
+		startResize(std::move(cached.content));
+		return;
+	}
+
+	// an image that gets resized is decoded straight from memory, there's no point in writing it twice.
+	// A recording needs it in memory as well
+	mStreamed = (mMaxWidth == 0) && (mMaxHeight == 0) && (mode != ScraperCache::MODE_RECORD);
+
+	if(mStreamed)
+		mReq = std::unique_ptr<HttpReq>(new HttpReq(url, path));
+	else
+		mReq = std::unique_ptr<HttpReq>(new HttpReq(url));
 }
 
 void ImageDownloadHandle::update()
 {
-	if(mReq->status() == HttpReq::REQ_IN_PROGRESS)
+	if(mStatus != ASYNC_IN_PROGRESS)
 		return;
 
-	if(mReq->status() != HttpReq::REQ_SUCCESS)
+	if(mResizeJob)
 	{
-		std::stringstream ss;
-		ss << "Network error: " << mReq->getErrorMsg();
-		setError(ss.str());
-		return;
+		if(!mResizeJob->done)
+			return;
 	}
-
-	// download is done, save it to disk
-	std::ofstream stream(mSavePath, std::ios_base::out | std::ios_base::binary);
-	if(stream.bad())
+	else
 	{
-		setError("Failed to open image path to write. Permission error? Disk full?");
-		return;
-	}
+		if(mReq->status() == HttpReq::REQ_IN_PROGRESS)
+			return;
 
-	const std::string& content = mReq->getContent();
-	stream.write(content.data(), content.length());
-	stream.close();
-	if(stream.bad())
-	{
-		setError("Failed to save image. Disk full?");
-		return;
+		if(mReq->status() != HttpReq::REQ_SUCCESS)
+		{
+			std::stringstream ss;
+			ss << "Network error: " << mReq->getErrorMsg();
+			setError(ss.str());
+			return;
+		}
+
+		if(ScraperCache::getMode() == ScraperCache::MODE_RECORD)
+		{
+			ScraperCache::Entry entry;
+			entry.content = mReq->getContent();
+			entry.stored = time(NULL);
+			ScraperCache::save(mUrl, entry);
+		}
+
+		// download is done, resize it beside the ui and the other downloads
+		if(mStreamed)
+		{
+			mResizeJob = std::make_shared<ResizeJob>();
+			mResizeJob->resized = true;
+			mResizeJob->done = true;
+		}
+		else
+		{
+			startResize(mReq->takeContent());
+			return;
+		}
 	}
 
-	// resize it
-	if(!resizeImage(mSavePath, mMaxWidth, mMaxHeight))
+	if(!mResizeJob->resized)
 	{
 		setError("Error saving resized image. Out of memory? Disk full?");
 		return;
 	}
 
+	// the file was written behind the back of both indexes
+	Utils::FileSystem::invalidateExists(mSavePath);
+	MediaIndex::getInstance()->add(mSavePath);
+
 	setStatus(ASYNC_DONE);
 }
 
+void ImageDownloadHandle::startResize(std::string content)
+{
+	mResizeJob = std::make_shared<ResizeJob>();
+
+	std::shared_ptr<ResizeJob> job = mResizeJob;
+	std::shared_ptr<std::string> data = std::make_shared<std::string>(std::move(content));
+	const std::string path = mSavePath;
+	const int maxWidth = mMaxWidth;
+	const int maxHeight = mMaxHeight;
+
+	auto resize = [job, data, path, maxWidth, maxHeight]
+	{
+		ProfileScope("resizeImageData");
+
+		const std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+		job->resized = resizeImageData(*data, path, maxWidth, maxHeight);
+		getScraperTimings().resizeMicros += getMicrosSince(start);
+		job->done = true;
+	};
+
+	// nothing waits for it but the handle polling done, a handle dropped before that leaves the job to finish alone
+	Utils::TaskScheduler::getInstance()->queue(resize, Utils::TaskScheduler::PRIORITY_LOW);
+}
+
+// scales image to fit maxWidth x maxHeight and unloads it, 0 for either keeps the aspect ratio
+static FIBITMAP* rescaleImage(FIBITMAP* image, int maxWidth, int maxHeight)
+{
+	float width = (float)FreeImage_GetWidth(image);
+	float height = (float)FreeImage_GetHeight(image);
+
+	if(maxWidth == 0)
+	{
+		maxWidth = (int)((maxHeight / height) * width);
+	}else if(maxHeight == 0)
+	{
+		maxHeight = (int)((maxWidth / width) * height);
+	}
+
+	// libjpeg may have decoded it at the right size already
+	if(((int)width == maxWidth) && ((int)height == maxHeight))
+		return image;
+
+	FIBITMAP* imageRescaled = FreeImage_Rescale(image, maxWidth, maxHeight, FILTER_BILINEAR);
+	FreeImage_Unload(image);
+
+	if(imageRescaled == NULL)
+		LOG(LogError) << "Could not resize image! (not enough memory? invalid bitdepth?)";
+
+	return imageRescaled;
+}
+
 //you can pass 0 for width or height to keep aspect ratio
 bool resizeImage(const std::string& path, int maxWidth, int maxHeight)
 {
@@ -273,31 +551,112 @@ bool resizeImage(const std::string& path, int maxWidth, int maxHeight)
 		return false;
 	}
 
-	float width = (float)FreeImage_GetWidth(image);
-	float height = (float)FreeImage_GetHeight(image);
+	if(image == NULL)
+	{
+		LOG(LogError) << "Error - could not load image \"" << path << "\"!";
+		return false;
+	}
+
+	FIBITMAP* imageRescaled = rescaleImage(image, maxWidth, maxHeight);
+
+	if(imageRescaled == NULL)
+		return false;
+
+	bool saved = (FreeImage_Save(format, imageRescaled, path.c_str()) != 0);
+	FreeImage_Unload(imageRescaled);
+
+	if(!saved)
+		LOG(LogError) << "Failed to save resized image!";
+
+	return saved;
+}
+
+// writes data next to path and moves it in place once it's complete, like a download straight to disk
+static bool saveImageData(const std::string& data, const std::string& path)
+{
+	const std::string partPath = path + ".part";
+	bool saved = false;
 
-	if(maxWidth == 0)
 	{
-		maxWidth = (int)((maxHeight / height) * width);
-	}else if(maxHeight == 0)
+		std::ofstream file(partPath, std::ios::binary);
+		saved = file.write(data.data(), data.size()).good();
+	}
+
+	if(saved)
 	{
-		maxHeight = (int)((maxWidth / width) * height);
+#if defined(_WIN32)
+		Utils::FileSystem::removeFile(path);
+#endif // _WIN32
+		saved = (rename(partPath.c_str(), path.c_str()) == 0);
 	}
 
-	FIBITMAP* imageRescaled = FreeImage_Rescale(image, maxWidth, maxHeight, FILTER_BILINEAR);
-	FreeImage_Unload(image);
+	if(!saved)
+	{
+		LOG(LogError) << "Failed to save image \"" << path << "\"!";
+		remove(partPath.c_str());
+	}
 
-	if(imageRescaled == NULL)
+	return saved;
+}
+
+bool resizeImageData(const std::string& data, const std::string& path, int maxWidth, int maxHeight)
+{
+	if((maxWidth == 0) && (maxHeight == 0))
+		return saveImageData(data, path);
+
+	FIMEMORY* memory = FreeImage_OpenMemory((BYTE*)data.data(), (DWORD)data.size());
+
+	if(memory == NULL)
+		return false;
+
+	FREE_IMAGE_FORMAT format = FreeImage_GetFileTypeFromMemory(memory, 0);
+	if(format == FIF_UNKNOWN)
+		format = FreeImage_GetFIFFromFilename(path.c_str());
+	if((format == FIF_UNKNOWN) || !FreeImage_FIFSupportsReading(format))
 	{
-		LOG(LogError) << "Could not resize image! (not enough memory? invalid bitdepth?)";
+		LOG(LogError) << "Error - could not detect filetype for image \"" << path << "\"!";
+		FreeImage_CloseMemory(memory);
 		return false;
 	}
 
-	bool saved = (FreeImage_Save(format, imageRescaled, path.c_str()) != 0);
+	// libjpeg can decode at 1/2, 1/4 or 1/8 the size for almost nothing, as long as the longer side stays above the
+	// size asked for. Asking for twice the target keeps portrait boxart from getting too narrow
+	int flags = 0;
+	if(format == FIF_JPEG)
+		flags = (((maxWidth > maxHeight) ? maxWidth : maxHeight) * 2) << 16;
+
+	FIBITMAP* image = FreeImage_LoadFromMemory(format, memory, flags);
+	FreeImage_CloseMemory(memory);
+
+	if(image == NULL)
+	{
+		LOG(LogError) << "Error - could not load image \"" << path << "\"!";
+		return false;
+	}
+
+	FIBITMAP* imageRescaled = rescaleImage(image, maxWidth, maxHeight);
+
+	if(imageRescaled == NULL)
+		return false;
+
+	// written next to path first, like a download straight to disk
+	const std::string partPath = path + ".part";
+	bool saved = (FreeImage_Save(format, imageRescaled, partPath.c_str()) != 0);
 	FreeImage_Unload(imageRescaled);
 
+	if(saved)
+	{
+#if defined(_WIN32)
+		Utils::FileSystem::removeFile(path);
+#endif // _WIN32
+		saved = (rename(partPath.c_str(), path.c_str()) == 0);
+	}
+
 	if(!saved)
+	{
 		LOG(LogError) << "Failed to save resized image!";
+		remove(partPath.c_str());
+	}
 
 	return saved;
 }
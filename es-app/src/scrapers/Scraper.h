@@ -5,23 +5,36 @@
 #include "AsyncHandle.h"
 #include "HttpReq.h"
 #include "MetaData.h"
+#include "scrapers/ScraperCache.h"
+#include <atomic>
+#include <chrono>
 #include <functional>
 #include <memory>
 #include <queue>
 #include <utility>
 #include <assert.h>
+#include <stdint.h>
 
 #define MAX_SCRAPER_RESULTS 7
+#define MAX_SCRAPER_RETRIES 5
 
 class FileData;
 class SystemData;
 
 struct ScraperSearchParams
 {
+	ScraperSearchParams() : system(nullptr), game(nullptr), romSize(0) {};
+
 	SystemData* system;
 	FileData* game;
 
 	std::string nameOverride;
+
+	// filled in by startScraperSearch once the RomHashIndex has hashed the game, empty until then
+	std::string crc32;
+	std::string md5;
+	std::string sha1;
+	int64_t romSize;
 };
 
 struct ScraperSearchResult
@@ -77,20 +90,50 @@ protected:
 };
 
 
-// a single HTTP request that needs to be processed to get the results
+// a single HTTP request that needs to be processed to get the results, answered from the ScraperCache when it can be
 class ScraperHttpRequest : public ScraperRequest
 {
 public:
 	ScraperHttpRequest(std::vector<ScraperSearchResult>& resultsWrite, const std::string& url);
+	virtual ~ScraperHttpRequest();
 	virtual void update() override;
 
 protected:
-	virtual void process(const std::unique_ptr<HttpReq>& req, std::vector<ScraperSearchResult>& results) = 0;
+	virtual void process(const std::string& content, std::vector<ScraperSearchResult>& results) = 0;
 
 private:
+	// the request only starts once the ScraperRateLimiter lets it, and starts again when the server was too busy
+	void start();
+
+	// runs process() and counts the time it took
+	void parse(const std::string& content);
+
 	std::unique_ptr<HttpReq> mReq;
+	std::string mUrl;
+	std::string mHost;
+	std::vector<std::string> mHeaders;
+	ScraperCache::Entry mCached;
+	std::chrono::steady_clock::time_point mStartTime;
+	bool mPending;
+	bool mMissing;
+	int mRetries;
+};
+
+// What the scraper spent its time on, summed over every thread. The batch scraper reports them after a benchmark
+struct ScraperTimings
+{
+	ScraperTimings() : parseMicros(0), resizeMicros(0), requests(0), replayed(0), missing(0), images(0) { }
+
+	std::atomic<uint64_t> parseMicros;
+	std::atomic<uint64_t> resizeMicros;
+	std::atomic<uint64_t> requests;
+	std::atomic<uint64_t> replayed;
+	std::atomic<uint64_t> missing;
+	std::atomic<uint64_t> images;
 };
 
+ScraperTimings& getScraperTimings();
+
 // a request to get a list of results
 class ScraperSearchHandle : public AsyncHandle
 {
@@ -116,6 +159,9 @@ std::vector<std::string> getScraperList();
 // returns true if the scraper configured in the settings is still valid
 bool isValidConfiguredScraper();
 
+// returns how many searches the configured scraper takes at once, more get it to refuse or ban the client
+int getScraperMaxSearches();
+
 typedef void (*generate_scraper_requests_func)(const ScraperSearchParams& params, std::queue< std::unique_ptr<ScraperRequest> >& requests, std::vector<ScraperSearchResult>& results);
 
 // -------------------------------------------------------------------------
@@ -146,10 +192,25 @@ public:
 	void update() override;
 
 private:
+	// written by the scheduler thread resizing the image, read once done is set
+	struct ResizeJob
+	{
+		ResizeJob() : done(false), resized(false) { }
+
+		std::atomic<bool> done;
+		bool resized;
+	};
+
+	// hands data over to be resized or written as it is
+	void startResize(std::string data);
+
 	std::unique_ptr<HttpReq> mReq;
+	std::shared_ptr<ResizeJob> mResizeJob;
+	std::string mUrl;
 	std::string mSavePath;
 	int mMaxWidth;
 	int mMaxHeight;
+	bool mStreamed;
 };
 
 //About the same as "~/.emulationstation/downloaded_images/[system_name]/[game_name].[url's extension]".
@@ -167,4 +228,8 @@ std::unique_ptr<MDResolveHandle> resolveMetaDataAssets(const ScraperSearchResult
 //Returns true if successful, false otherwise.
 bool resizeImage(const std::string& path, int maxWidth, int maxHeight);
 
+//Same as resizeImage, but decodes the image from data and saves it to [path]. JPEGs get decoded at a reduced size.
+//Passing 0 for both writes data as it is. Safe to call from any thread.
+bool resizeImageData(const std::string& data, const std::string& path, int maxWidth, int maxHeight);
+
 #endif // ES_APP_SCRAPERS_SCRAPER_H
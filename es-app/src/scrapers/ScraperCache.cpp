@@ -0,0 +1,124 @@
+#include "scrapers/ScraperCache.h"
+
+#include "utils/BinaryUtil.h"
+#include "utils/FileSystemUtil.h"
+#include "utils/StringUtil.h"
+#include "Log.h"
+#include "Settings.h"
+#include <string.h>
+#include <time.h>
+#include <functional>
+#include <iomanip>
+#include <sstream>
+
+static const char     CACHE_MAGIC[4] = { 'E', 'S', 'H', 'C' };
+static const uint32_t CACHE_VERSION  = 1;
+
+// query parameters that identify the client or the user rather than what's asked for
+static const char* CREDENTIAL_PARAMS[] = { "apikey", "devid", "devpassword", "softname", "ssid", "sspassword" };
+
+ScraperCache::Mode ScraperCache::sMode = ScraperCache::MODE_NORMAL;
+
+void ScraperCache::setMode(Mode mode)
+{
+	sMode = mode;
+}
+
+ScraperCache::Mode ScraperCache::getMode()
+{
+	return sMode;
+}
+
+bool ScraperCache::isEnabled()
+{
+	return (sMode != MODE_NORMAL) || Settings::getInstance()->getBool("ScraperCache");
+}
+
+std::string ScraperCache::getKey(const std::string& url)
+{
+	const size_t query = url.find('?');
+
+	if(query == std::string::npos)
+		return url;
+
+	std::string key = url.substr(0, query);
+	std::vector<std::string> params = Utils::String::delimitedStringToVector(url.substr(query + 1), "&");
+	char separator = '?';
+
+	for(auto it = params.cbegin(); it != params.cend(); it++)
+	{
+		const std::string name = it->substr(0, it->find('='));
+		bool credential = false;
+
+		for(size_t i = 0; i < (sizeof(CREDENTIAL_PARAMS) / sizeof(CREDENTIAL_PARAMS[0])); i++)
+			credential |= (name == CREDENTIAL_PARAMS[i]);
+
+		if(credential)
+			continue;
+
+		key += separator + *it;
+		separator = '&';
+	}
+
+	return key;
+}
+
+bool ScraperCache::load(const std::string& url, Entry& entry)
+{
+	const std::string key = getKey(url);
+	std::string buffer;
+
+	if(!Utils::Binary::loadFile(getCachePath(key), buffer))
+		return false;
+
+	Utils::Binary::Reader reader(buffer);
+	char magic[4];
+	uint32_t version;
+	std::string cachedKey;
+	Entry cached;
+
+	if(!reader.read(magic, sizeof(magic)) || memcmp(magic, CACHE_MAGIC, sizeof(magic)) ||
+		!reader.read(version) || (version != CACHE_VERSION) ||
+		!reader.readString(cachedKey) || !reader.read(cached.stored) ||
+		!reader.readString(cached.etag) || !reader.readString(cached.lastModified) || !reader.readString(cached.content))
+		return false;
+
+	// another url with the same hash, or a reply that is too old to be worth revalidating
+	if((cachedKey != key) || ((sMode != MODE_REPLAY) && ((time(NULL) - cached.stored) > MAX_AGE)))
+		return false;
+
+	entry = cached;
+	return true;
+}
+
+void ScraperCache::save(const std::string& url, const Entry& entry)
+{
+	const std::string key = getKey(url);
+	Utils::Binary::Writer writer;
+
+	writer.write(CACHE_MAGIC, sizeof(CACHE_MAGIC));
+	writer.write(CACHE_VERSION);
+	writer.writeString(key);
+	writer.write(entry.stored);
+	writer.writeString(entry.etag);
+	writer.writeString(entry.lastModified);
+	writer.writeString(entry.content);
+
+	if(!Utils::Binary::saveFile(getCachePath(key), writer.getBuffer()))
+		LOG(LogWarning) << "Could not cache scraper reply for \"" << key << "\"";
+}
+
+bool ScraperCache::isFresh(const Entry& entry)
+{
+	const int64_t age = time(NULL) - entry.stored;
+
+	return (sMode == MODE_REPLAY) || ((age >= 0) && (age < FRESH_TIME));
+}
+
+std::string ScraperCache::getCachePath(const std::string& key)
+{
+	std::stringstream ss;
+	ss << std::hex << std::setw(16) << std::setfill('0') << (uint64_t)std::hash<std::string>()(key);
+
+	return Utils::FileSystem::getHomePath() + "/.emulationstation/scraper_cache/" + ss.str() + ".http";
+}
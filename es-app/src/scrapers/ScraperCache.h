@@ -0,0 +1,58 @@
+#pragma once
+#ifndef ES_APP_SCRAPERS_SCRAPER_CACHE_H
+#define ES_APP_SCRAPERS_SCRAPER_CACHE_H
+
+#include <stdint.h>
+#include <string>
+
+// Keeps the replies of the scraper APIs on disk, keyed by the request url without the credentials in it.
+// A reply younger than FRESH_TIME is used without asking the server, an older one is sent back to the server with
+// its ETag and Last-Modified, so an unchanged reply only costs a 304. Replies older than MAX_AGE are dropped.
+class ScraperCache
+{
+public:
+	struct Entry
+	{
+		Entry() : stored(0) { }
+
+		std::string content;
+		std::string etag;
+		std::string lastModified;
+		int64_t     stored;
+	};
+
+	// MODE_RECORD keeps every reply including images no matter the settings, MODE_REPLAY answers every request from
+	// what was recorded and fails the others without going online. Together they let the batch scraper benchmark
+	// the same run over and over
+	enum Mode
+	{
+		MODE_NORMAL,
+		MODE_RECORD,
+		MODE_REPLAY
+	};
+
+	static void setMode(Mode mode);
+	static Mode getMode();
+
+	// Whether replies are cached at all
+	static bool isEnabled();
+
+	// The url with the api keys, user names and passwords taken out
+	static std::string getKey(const std::string& url);
+
+	static bool load(const std::string& url, Entry& entry);
+	static void save(const std::string& url, const Entry& entry);
+
+	// Whether the entry can be used without revalidating it
+	static bool isFresh(const Entry& entry);
+
+	static const int64_t FRESH_TIME = 7 * 24 * 60 * 60;
+	static const int64_t MAX_AGE    = 90 * 24 * 60 * 60;
+
+private:
+	static std::string getCachePath(const std::string& key);
+
+	static Mode sMode;
+};
+
+#endif // ES_APP_SCRAPERS_SCRAPER_CACHE_H
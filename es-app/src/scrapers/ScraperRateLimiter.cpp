@@ -0,0 +1,149 @@
+#include "scrapers/ScraperRateLimiter.h"
+
+#include "Log.h"
+
+// the longest the limiter backs off on its own, and how much slower than the fastest reply counts as overloaded
+#define MAX_BACKOFF       60
+#define OVERLOAD_LATENCY  2.0
+
+struct HostLimits
+{
+	const char* host;
+	double      rate;
+	double      burst;
+	int         cap;
+};
+
+// ScreenScraper gives anonymous clients a single thread, TheGamesDB counts requests per month instead
+static const HostLimits host_limits[] = {
+	{ "www.screenscraper.fr", 2.0,  4.0,  1 },
+	{ "api.thegamesdb.net",   5.0,  10.0, 4 }
+};
+
+static const HostLimits default_limits = { "", 10.0, 10.0, 4 };
+
+std::map<std::string, ScraperRateLimiter::Host> ScraperRateLimiter::sHosts;
+
+bool ScraperRateLimiter::tryAcquire(const std::string& host)
+{
+	Host& limits = getLimits(host);
+	const Clock::time_point now = Clock::now();
+
+	limits.tokens += std::chrono::duration<double>(now - limits.refilled).count() * limits.rate;
+	if(limits.tokens > limits.burst)
+		limits.tokens = limits.burst;
+	limits.refilled = now;
+
+	if((now < limits.blockedUntil) || (limits.inFlight >= (int)limits.maxInFlight) || (limits.tokens < 1.0))
+		return false;
+
+	limits.tokens -= 1.0;
+	limits.inFlight++;
+	return true;
+}
+
+void ScraperRateLimiter::finished(const std::string& host, long code, double latency, int retryAfter)
+{
+	Host& limits = getLimits(host);
+
+	if(limits.inFlight > 0)
+		limits.inFlight--;
+
+	if(isThrottled(code))
+	{
+		// back off exponentially unless the server says how long, and halve what's in flight
+		limits.throttled++;
+		int delay = retryAfter;
+		if(delay < 0)
+			delay = (limits.throttled < 7) ? (1 << (limits.throttled - 1)) : MAX_BACKOFF;
+
+		limits.blockedUntil = Clock::now() + std::chrono::seconds(delay);
+		limits.maxInFlight /= 2.0;
+		if(limits.maxInFlight < 1.0)
+			limits.maxInFlight = 1.0;
+
+		LOG(LogWarning) << "Scraper requests to " << host << " throttled (status " << code << "), waiting " << delay << "s with " << (int)limits.maxInFlight << " in flight";
+		return;
+	}
+
+	// a request that failed without a reply tells nothing about the server's load
+	if(code == 0)
+		return;
+
+	limits.throttled = 0;
+
+	// the fastest reply slowly counts for less, one lucky reply shouldn't hold the limit down for good
+	limits.minLatency *= 1.01;
+	if((limits.minLatency == 0.0) || (latency < limits.minLatency))
+		limits.minLatency = latency;
+	limits.avgLatency = (limits.avgLatency == 0.0) ? latency : ((limits.avgLatency * 0.8) + (latency * 0.2));
+
+	// requests queuing up on the server take longer, one less in flight gets them through faster
+	if(limits.avgLatency > (limits.minLatency * OVERLOAD_LATENCY))
+	{
+		limits.maxInFlight -= 0.5;
+		if(limits.maxInFlight < 1.0)
+			limits.maxInFlight = 1.0;
+	}
+	else
+	{
+		limits.maxInFlight += 1.0 / limits.maxInFlight;
+		if(limits.maxInFlight > limits.cap)
+			limits.maxInFlight = limits.cap;
+	}
+}
+
+void ScraperRateLimiter::cancelled(const std::string& host)
+{
+	Host& limits = getLimits(host);
+
+	if(limits.inFlight > 0)
+		limits.inFlight--;
+}
+
+bool ScraperRateLimiter::isThrottled(long code)
+{
+	// ScreenScraper answers 429 when all threads of the client are busy, and 430 once the daily quota is used up.
+	// The quota won't come back any time soon, so that one is an error like any other
+	return (code == 429) || (code == 503);
+}
+
+std::string ScraperRateLimiter::getHost(const std::string& url)
+{
+	size_t start = url.find("://");
+	start = (start != std::string::npos) ? (start + 3) : 0;
+
+	const size_t end = url.find_first_of(":/?", start);
+
+	return url.substr(start, (end != std::string::npos) ? (end - start) : std::string::npos);
+}
+
+ScraperRateLimiter::Host& ScraperRateLimiter::getLimits(const std::string& host)
+{
+	auto it = sHosts.find(host);
+
+	if(it != sHosts.cend())
+		return it->second;
+
+	const HostLimits* defaults = &default_limits;
+	for(size_t i = 0; i < (sizeof(host_limits) / sizeof(host_limits[0])); i++)
+	{
+		if(host == host_limits[i].host)
+			defaults = &host_limits[i];
+	}
+
+	Host limits;
+	limits.rate         = defaults->rate;
+	limits.burst        = defaults->burst;
+	limits.tokens       = defaults->burst;
+	limits.refilled     = Clock::now();
+	limits.blockedUntil = limits.refilled;
+	limits.cap          = defaults->cap;
+	limits.maxInFlight  = defaults->cap;
+	limits.inFlight     = 0;
+	limits.minLatency   = 0.0;
+	limits.avgLatency   = 0.0;
+	limits.throttled    = 0;
+
+	return sHosts.insert(std::make_pair(host, limits)).first->second;
+}
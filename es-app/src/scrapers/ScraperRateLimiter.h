@@ -0,0 +1,52 @@
+#pragma once
+#ifndef ES_APP_SCRAPERS_SCRAPER_RATE_LIMITER_H
+#define ES_APP_SCRAPERS_SCRAPER_RATE_LIMITER_H
+
+#include <chrono>
+#include <map>
+#include <string>
+
+// Decides when scraper requests to a host may start, so a scraper with many games in flight stays within what the
+// server allows instead of getting its requests refused. Every host has a token bucket for the request rate and a
+// limit on requests in flight. That limit shrinks when replies slow down or the server asks to back off, and grows
+// back while they stay fast. A Retry-After from the server holds all requests to it until then.
+// Only used from the thread updating the scraper requests.
+class ScraperRateLimiter
+{
+public:
+	// Whether a request to host may start now, it then counts as in flight until finished() or cancelled()
+	static bool tryAcquire(const std::string& host);
+
+	// code is the HTTP status code or 0 when the request failed, latency in seconds, retryAfter in seconds or -1
+	static void finished(const std::string& host, long code, double latency, int retryAfter);
+	static void cancelled(const std::string& host);
+
+	// Whether code asks to slow down, the request can be made again later
+	static bool isThrottled(long code);
+
+	static std::string getHost(const std::string& url);
+
+private:
+	typedef std::chrono::steady_clock Clock;
+
+	struct Host
+	{
+		double            rate;        // tokens added per second
+		double            burst;       // most tokens the bucket holds
+		double            tokens;
+		Clock::time_point refilled;
+		Clock::time_point blockedUntil;
+		int               cap;         // most requests in flight
+		double            maxInFlight; // the current limit, between 1 and cap
+		int               inFlight;
+		double            minLatency;
+		double            avgLatency;
+		int               throttled;   // throttled replies in a row
+	};
+
+	static Host& getLimits(const std::string& host);
+
+	static std::map<std::string, Host> sHosts;
+};
+
+#endif // ES_APP_SCRAPERS_SCRAPER_RATE_LIMITER_H
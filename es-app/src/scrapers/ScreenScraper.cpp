@@ -105,36 +105,36 @@ const std::map<PlatformId, unsigned short> screenscraper_platformid_map{
 };
 
 
-// Helper XML parsing method, finding a node-by-name recursively.
-pugi::xml_node find_node_by_name_re(const pugi::xml_node& node, const std::vector<std::string> node_names) {
-
-	for (const std::string& _val : node_names)
-	{
-		pugi::xpath_query query_node_name((static_cast<std::string>("//") + _val).c_str());
-		pugi::xpath_node_set results = node.select_nodes(query_node_name);
-
-		if (results.size() > 0)
-			return results.first().node();
-	}
-
-	return pugi::xml_node();
-}
-
 // Help XML parsing method, finding an direct child XML node starting from the parent and filtering by an attribute value list.
-pugi::xml_node find_child_by_attribute_list(const pugi::xml_node& node_parent, const std::string& node_name, const std::string& attribute_name, const std::vector<std::string> attribute_values)
+// The child whose attribute comes first in the list wins, the children are walked only once however long the list is.
+// Children can also be required to have filter_value in their filter_name attribute.
+pugi::xml_node find_child_by_attribute_list(const pugi::xml_node& node_parent, const char* node_name, const char* attribute_name, const std::vector<std::string>& attribute_values,
+	const char* filter_name = NULL, const char* filter_value = NULL)
 {
-	for (auto _val : attribute_values)
+	pugi::xml_node found(NULL);
+	size_t foundRank = attribute_values.size();
+
+	for (pugi::xml_node node : node_parent.children(node_name))
 	{
-		for (pugi::xml_node node : node_parent.children(node_name.c_str()))
-		{
+		if (filter_name && (strcmp(node.attribute(filter_name).value(), filter_value) != 0))
+			continue;
 
-			if (strcmp(node.attribute(attribute_name.c_str()).value(), _val.c_str()) == 0)
-				return node;
+		const char* value = node.attribute(attribute_name).value();
+		for (size_t rank = 0; rank < foundRank; rank++)
+		{
+			if (attribute_values[rank] == value)
+			{
+				found = node;
+				foundRank = rank;
+				break;
+			}
 		}
-	}
 
-	return pugi::xml_node(NULL);
+		if (foundRank == 0)
+			break;
+	}
 
+	return found;
 }
 
 void screenscraper_generate_scraper_requests(const ScraperSearchParams& params,
@@ -148,6 +148,15 @@ void screenscraper_generate_scraper_requests(const ScraperSearchParams& params,
 	// Check if the user has overridden the file name
 	path = ssConfig.getGameSearchUrl(params.nameOverride.empty() ? params.game->getFileName() : params.nameOverride);
 
+	// a hash finds the exact dump even when the file was renamed, a name typed in by the user wins over it though
+	if(params.nameOverride.empty() && !params.crc32.empty())
+	{
+		path += "&crc=" + params.crc32
+			+ "&md5=" + params.md5
+			+ "&sha1=" + params.sha1
+			+ "&romtaille=" + std::to_string(params.romSize);
+	}
+
 	auto& platforms = params.system->getPlatformIds();
 	std::vector<unsigned short> p_ids;
 
@@ -180,12 +189,10 @@ void screenscraper_generate_scraper_requests(const ScraperSearchParams& params,
 
 }
 
-void ScreenScraperRequest::process(const std::unique_ptr<HttpReq>& req, std::vector<ScraperSearchResult>& results)
+void ScreenScraperRequest::process(const std::string& content, std::vector<ScraperSearchResult>& results)
 {
-	assert(req->status() == HttpReq::REQ_SUCCESS);
-
 	pugi::xml_document doc;
-	pugi::xml_parse_result parseResult = doc.load_string(req->getContent().c_str());
+	pugi::xml_parse_result parseResult = doc.load_string(content.c_str());
 
 	if (!parseResult)
 	{
@@ -274,32 +281,11 @@ void ScreenScraperRequest::processGame(const pugi::xml_document& xmldoc, std::ve
 
 		if (media_list)
 		{
-			pugi::xml_node art = pugi::xml_node(NULL);
-
-			// Do an XPath query for media[type='$media_type'], then filter by region
-			// We need to do this because any child of 'medias' has the form
+			// Any child of 'medias' has the form
 			// <media type="..." region="..." format="...">
-			// and we need to find the right media for the region.
-			pugi::xpath_node_set results = media_list.select_nodes((static_cast<std::string>("media[@type='") + ssConfig.media_name + "']").c_str());
-
-			if (results.size())
-			{
-				// Region fallback: WOR(LD), US, CUS(TOM?), JP, EU
-				for (auto _region : std::vector<std::string>{ region, "wor", "us", "cus", "jp", "eu" })
-				{
-					if (art)
-						break;
-
-					for (auto node : results)
-					{
-						if (node.node().attribute("region").value() == _region)
-						{
-							art = node.node();
-							break;
-						}
-					}
-				}
-			} // results
+			// and we need to find the media of our type for the region.
+			// Region fallback: WOR(LD), US, CUS(TOM?), JP, EU
+			pugi::xml_node art = find_child_by_attribute_list(media_list, "media", "region", { region, "wor", "us", "cus", "jp", "eu" }, "type", ssConfig.media_name.c_str());
 
 			if (art)
 			{
@@ -57,7 +57,7 @@ public:
 	} configuration;
 
 protected:
-	void process(const std::unique_ptr<HttpReq>& req, std::vector<ScraperSearchResult>& results) override;
+	void process(const std::string& content, std::vector<ScraperSearchResult>& results) override;
 
 	void processList(const pugi::xml_document& xmldoc, std::vector<ScraperSearchResult>& results);
 	void processGame(const pugi::xml_document& xmldoc, std::vector<ScraperSearchResult>& results);
@@ -2,8 +2,10 @@
 
 #include "animations/LambdaAnimation.h"
 #include "guis/GuiMsgBox.h"
+#include "renderers/GpuProfiler.h"
 #include "views/UIModeController.h"
 #include "views/ViewController.h"
+#include "CollectionSystemManager.h"
 #include "Log.h"
 #include "Scripting.h"
 #include "Settings.h"
@@ -28,6 +30,11 @@ SystemView::SystemView(Window* window) : IList<SystemViewData, SystemData*>(wind
 
 void SystemView::populate()
 {
+	for (auto it = mEntries.begin(); it != mEntries.end(); it++)
+	{
+		for (auto extra : it->data.backgroundExtras)
+			delete extra;
+	}
 	mEntries.clear();
 
 	for(auto it = SystemData::sSystemVector.cbegin(); it != SystemData::sSystemVector.cend(); it++)
@@ -43,76 +50,6 @@ void SystemView::populate()
 			e.name = (*it)->getName();
 			e.object = *it;
 
-			// make logo
-			const ThemeData::ThemeElement* logoElem = theme->getElement("system", "logo", "image");
-			if(logoElem)
-			{
-				std::string path = logoElem->get<std::string>("path");
-				std::string defaultPath = logoElem->has("default") ? logoElem->get<std::string>("default") : "";
-				if((!path.empty() && ResourceManager::getInstance()->fileExists(path))
-				   || (!defaultPath.empty() && ResourceManager::getInstance()->fileExists(defaultPath)))
-				{
-					ImageComponent* logo = new ImageComponent(mWindow, false, false);
-					logo->setMaxSize(mCarousel.logoSize * mCarousel.logoScale);
-					logo->applyTheme(theme, "system", "logo", ThemeFlags::PATH | ThemeFlags::COLOR);
-					logo->setRotateByTargetSize(true);
-					e.data.logo = std::shared_ptr<GuiComponent>(logo);
-				}
-			}
-			if (!e.data.logo)
-			{
-				// no logo in theme; use text
-				TextComponent* text = new TextComponent(mWindow,
-					(*it)->getName(),
-					Font::get(FONT_SIZE_LARGE),
-					0x000000FF,
-					ALIGN_CENTER);
-				text->setSize(mCarousel.logoSize * mCarousel.logoScale);
-				text->applyTheme((*it)->getTheme(), "system", "logoText", ThemeFlags::FONT_PATH | ThemeFlags::FONT_SIZE | ThemeFlags::COLOR | ThemeFlags::FORCE_UPPERCASE | ThemeFlags::LINE_SPACING | ThemeFlags::TEXT);
-				e.data.logo = std::shared_ptr<GuiComponent>(text);
-
-				if (mCarousel.type == VERTICAL || mCarousel.type == VERTICAL_WHEEL)
-				{
-					text->setHorizontalAlignment(mCarousel.logoAlignment);
-					text->setVerticalAlignment(ALIGN_CENTER);
-				} else {
-					text->setHorizontalAlignment(ALIGN_CENTER);
-					text->setVerticalAlignment(mCarousel.logoAlignment);
-				}
-			}
-
-			if (mCarousel.type == VERTICAL || mCarousel.type == VERTICAL_WHEEL)
-			{
-				if (mCarousel.logoAlignment == ALIGN_LEFT)
-					e.data.logo->setOrigin(0, 0.5);
-				else if (mCarousel.logoAlignment == ALIGN_RIGHT)
-					e.data.logo->setOrigin(1.0, 0.5);
-				else
-					e.data.logo->setOrigin(0.5, 0.5);
-			} else {
-				if (mCarousel.logoAlignment == ALIGN_TOP)
-					e.data.logo->setOrigin(0.5, 0);
-				else if (mCarousel.logoAlignment == ALIGN_BOTTOM)
-					e.data.logo->setOrigin(0.5, 1);
-				else
-					e.data.logo->setOrigin(0.5, 0.5);
-			}
-
-			Vector2f denormalized = mCarousel.logoSize * e.data.logo->getOrigin();
-			e.data.logo->setPosition(denormalized.x(), denormalized.y(), 0.0);
-			// delete any existing extras
-			for (auto extra : e.data.backgroundExtras)
-				delete extra;
-			e.data.backgroundExtras.clear();
-
-			// make background extras
-			e.data.backgroundExtras = ThemeData::makeExtras((*it)->getTheme(), "system", mWindow);
-
-			// sort the extras by z-index
-			std::stable_sort(e.data.backgroundExtras.begin(), e.data.backgroundExtras.end(),  [](GuiComponent* a, GuiComponent* b) {
-				return b->getZIndex() > a->getZIndex();
-			});
-
 			this->add(e);
 		}
 	}
@@ -127,6 +64,111 @@ void SystemView::populate()
 	}
 }
 
+void SystemView::reloadSystem(SystemData* system)
+{
+	for (auto it = mEntries.begin(); it != mEntries.end(); it++)
+	{
+		if (it->object != system)
+			continue;
+
+		for (auto extra : it->data.backgroundExtras)
+			delete extra;
+
+		it->data.backgroundExtras.clear();
+		it->data.extrasLoaded = false;
+		it->data.logo.reset();
+		break;
+	}
+}
+
+const std::shared_ptr<GuiComponent>& SystemView::getLogo(int index)
+{
+	SystemViewData& data = mEntries.at(index).data;
+	if (data.logo)
+		return data.logo;
+
+	SystemData* system = mEntries.at(index).object;
+	const std::shared_ptr<ThemeData>& theme = system->getTheme();
+
+	// make logo
+	const ThemeData::ThemeElement* logoElem = theme->getElement("system", "logo", "image");
+	if(logoElem)
+	{
+		std::string path = logoElem->get<std::string>("path");
+		std::string defaultPath = logoElem->has("default") ? logoElem->get<std::string>("default") : "";
+		if((!path.empty() && ResourceManager::getInstance()->fileExists(path))
+		   || (!defaultPath.empty() && ResourceManager::getInstance()->fileExists(defaultPath)))
+		{
+			ImageComponent* logo = new ImageComponent(mWindow, false, false);
+			logo->setMaxSize(mCarousel.logoSize * mCarousel.logoScale);
+			logo->applyTheme(theme, "system", "logo", ThemeFlags::PATH | ThemeFlags::COLOR);
+			logo->setRotateByTargetSize(true);
+			data.logo = std::shared_ptr<GuiComponent>(logo);
+		}
+	}
+	if (!data.logo)
+	{
+		// no logo in theme; use text
+		TextComponent* text = new TextComponent(mWindow,
+			system->getName(),
+			Font::get(FONT_SIZE_LARGE),
+			0x000000FF,
+			ALIGN_CENTER);
+		text->setSize(mCarousel.logoSize * mCarousel.logoScale);
+		text->applyTheme(system->getTheme(), "system", "logoText", ThemeFlags::FONT_PATH | ThemeFlags::FONT_SIZE | ThemeFlags::COLOR | ThemeFlags::FORCE_UPPERCASE | ThemeFlags::LINE_SPACING | ThemeFlags::TEXT);
+		data.logo = std::shared_ptr<GuiComponent>(text);
+
+		if (mCarousel.type == VERTICAL || mCarousel.type == VERTICAL_WHEEL)
+		{
+			text->setHorizontalAlignment(mCarousel.logoAlignment);
+			text->setVerticalAlignment(ALIGN_CENTER);
+		} else {
+			text->setHorizontalAlignment(ALIGN_CENTER);
+			text->setVerticalAlignment(mCarousel.logoAlignment);
+		}
+	}
+
+	if (mCarousel.type == VERTICAL || mCarousel.type == VERTICAL_WHEEL)
+	{
+		if (mCarousel.logoAlignment == ALIGN_LEFT)
+			data.logo->setOrigin(0, 0.5);
+		else if (mCarousel.logoAlignment == ALIGN_RIGHT)
+			data.logo->setOrigin(1.0, 0.5);
+		else
+			data.logo->setOrigin(0.5, 0.5);
+	} else {
+		if (mCarousel.logoAlignment == ALIGN_TOP)
+			data.logo->setOrigin(0.5, 0);
+		else if (mCarousel.logoAlignment == ALIGN_BOTTOM)
+			data.logo->setOrigin(0.5, 1);
+		else
+			data.logo->setOrigin(0.5, 0.5);
+	}
+
+	Vector2f denormalized = mCarousel.logoSize * data.logo->getOrigin();
+	data.logo->setPosition(denormalized.x(), denormalized.y(), 0.0);
+
+	return data.logo;
+}
+
+const std::vector<GuiComponent*>& SystemView::getExtras(int index)
+{
+	SystemViewData& data = mEntries.at(index).data;
+	if (data.extrasLoaded)
+		return data.backgroundExtras;
+
+	// make background extras
+	data.backgroundExtras = ThemeData::makeExtras(mEntries.at(index).object->getTheme(), "system", mWindow);
+
+	// sort the extras by z-index
+	std::stable_sort(data.backgroundExtras.begin(), data.backgroundExtras.end(),  [](GuiComponent* a, GuiComponent* b) {
+		return b->getZIndex() > a->getZIndex();
+	});
+
+	data.extrasLoaded = true;
+	return data.backgroundExtras;
+}
+
 void SystemView::goToSystem(SystemData* system, bool animate)
 {
 	setCursor(system);
@@ -196,7 +238,7 @@ bool SystemView::input(InputConfig* config, Input input)
 			config->isMappedLike("up", input) ||
 			config->isMappedLike("down", input))
 			listInput(0);
-		Scripting::fireEvent("system-select", this->IList::getSelected()->getName(), "input");
+		Scripting::queueEvent("system-select", this->IList::getSelected()->getName(), "input");
 		if(!UIModeController::getInstance()->isUIModeKid() && config->isMappedTo("select", input) && Settings::getInstance()->getBool("ScreenSaverControls"))
 		{
 			mWindow->startScreenSaver();
@@ -219,6 +261,8 @@ void SystemView::onCursorChanged(const CursorState& /*state*/)
 	// update help style
 	updateHelpPrompts();
 
+	ViewController::get()->playSystemMusic(getSelected());
+
 	float startPos = mCamOffset;
 
 	float posMax = (float)mEntries.size();
@@ -251,6 +295,8 @@ void SystemView::onCursorChanged(const CursorState& /*state*/)
 		mSystemInfo.setOpacity((unsigned char)(Math::lerp(infoStartOpacity, 0.f, t) * 255));
 	}, (int)(infoStartOpacity * (goFast ? 10 : 150)));
 
+	// a collection populated on demand needs its games to tell how many there are
+	CollectionSystemManager::get()->populateIfNeeded(getSelected());
 	unsigned int gameCount = getSelected()->getDisplayedGameCount();
 
 	// also change the text after we've fully faded out
@@ -353,23 +399,33 @@ void SystemView::render(const Transform4x4f& parentTrans)
 	auto systemInfoZIndex = mSystemInfo.getZIndex();
 	auto minMax = std::minmax(mCarousel.zIndex, systemInfoZIndex);
 
-	renderExtras(trans, INT16_MIN, minMax.first);
+	{
+		GpuProfilerScope("SystemView::renderExtras");
+		renderExtras(trans, INT16_MIN, minMax.first);
+	}
+
 	renderFade(trans);
 
 	if (mCarousel.zIndex > mSystemInfo.getZIndex()) {
 		renderInfoBar(trans);
 	} else {
+		GpuProfilerScope("SystemView::renderCarousel");
 		renderCarousel(trans);
 	}
 
-	renderExtras(trans, minMax.first, minMax.second);
+	{
+		GpuProfilerScope("SystemView::renderExtras");
+		renderExtras(trans, minMax.first, minMax.second);
+	}
 
 	if (mCarousel.zIndex > mSystemInfo.getZIndex()) {
+		GpuProfilerScope("SystemView::renderCarousel");
 		renderCarousel(trans);
 	} else {
 		renderInfoBar(trans);
 	}
 
+	GpuProfilerScope("SystemView::renderExtras");
 	renderExtras(trans, minMax.second, INT16_MAX);
 }
 
@@ -501,6 +557,10 @@ void SystemView::renderCarousel(const Transform4x4f& trans)
 		bufferRight = 0;
 	}
 
+	// logos in the buffers are made ahead of time so their textures load, but only the ones on the carousel are drawn
+	const bool wheel = (mCarousel.type == VERTICAL_WHEEL || mCarousel.type == HORIZONTAL_WHEEL);
+	const float visibleDistance = (logoCount + 1) / 2.0f;
+
 	for (int i = center - logoCount / 2 + bufferLeft; i <= center + logoCount / 2 + bufferRight; i++)
 	{
 		int index = i;
@@ -509,6 +569,10 @@ void SystemView::renderCarousel(const Transform4x4f& trans)
 		while (index >= (int)mEntries.size())
 			index -= (int)mEntries.size();
 
+		const std::shared_ptr<GuiComponent> &comp = getLogo(index);
+		if (!wheel && fabs(i - mCamOffset) > visibleDistance)
+			continue;
+
 		Transform4x4f logoTrans = carouselTrans;
 		logoTrans.translate(Vector3f(i * logoSpacing[0] + xOff, i * logoSpacing[1] + yOff, 0));
 
@@ -521,8 +585,7 @@ void SystemView::renderCarousel(const Transform4x4f& trans)
 		int opacity = (int)Math::round(0x80 + ((0xFF - 0x80) * (1.0f - fabs(distance))));
 		opacity = Math::max((int) 0x80, opacity);
 
-		const std::shared_ptr<GuiComponent> &comp = mEntries.at(index).data.logo;
-		if (mCarousel.type == VERTICAL_WHEEL || mCarousel.type == HORIZONTAL_WHEEL) {
+		if (wheel) {
 			comp->setRotationDegrees(mCarousel.logoRotation * distance);
 			comp->setRotationOrigin(mCarousel.logoRotationOrigin);
 		}
@@ -560,6 +623,11 @@ void SystemView::renderExtras(const Transform4x4f& trans, float lower, float upp
 		//Only render selected system when not showing
 		if (mShowing || index == mCursor)
 		{
+			// extras in the buffers are only made so their textures load, a full screen away they can't be seen
+			const std::vector<GuiComponent*>& extras = getExtras(index);
+			if (fabs(i - mExtrasCamOffset) >= 1.0f)
+				continue;
+
 			Transform4x4f extrasTrans = trans;
 			if (mCarousel.type == HORIZONTAL || mCarousel.type == HORIZONTAL_WHEEL)
 				extrasTrans.translate(Vector3f((i - mExtrasCamOffset) * mSize.x(), 0, 0));
@@ -568,9 +636,8 @@ void SystemView::renderExtras(const Transform4x4f& trans, float lower, float upp
 
 			Renderer::pushClipRect(Vector2i((int)extrasTrans.translation()[0], (int)extrasTrans.translation()[1]),
 								   Vector2i((int)mSize.x(), (int)mSize.y()));
-			SystemViewData data = mEntries.at(index).data;
-			for (unsigned int j = 0; j < data.backgroundExtras.size(); j++) {
-				GuiComponent *extra = data.backgroundExtras[j];
+			for (unsigned int j = 0; j < extras.size(); j++) {
+				GuiComponent *extra = extras[j];
 				if (extra->getZIndex() >= lower && extra->getZIndex() < upper) {
 					extra->render(extrasTrans);
 				}
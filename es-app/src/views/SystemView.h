@@ -20,10 +20,12 @@ enum CarouselType : unsigned int
 	HORIZONTAL_WHEEL = 3
 };
 
+// logo and extras are only made once the system comes close to the screen
 struct SystemViewData
 {
 	std::shared_ptr<GuiComponent> logo;
 	std::vector<GuiComponent*> backgroundExtras;
+	bool extrasLoaded = false;
 };
 
 struct SystemViewCarousel
@@ -54,6 +56,11 @@ public:
 
 	void goToSystem(SystemData* system, bool animate);
 
+	// one entry per visible system of SystemData::sSystemVector, called again when systems were added
+	void populate();
+	// drops the logo and extras of system, they're made again from its theme when they come close to the screen
+	void reloadSystem(SystemData* system);
+
 	bool input(InputConfig* config, Input input) override;
 	void update(int deltaTime) override;
 	void render(const Transform4x4f& parentTrans) override;
@@ -68,11 +75,13 @@ protected:
 	void onCursorChanged(const CursorState& state) override;
 
 private:
-	void populate();
 	void getViewElements(const std::shared_ptr<ThemeData>& theme);
 	void getDefaultElements(void);
 	void getCarouselFromTheme(const ThemeData::ThemeElement* elem);
 
+	const std::shared_ptr<GuiComponent>& getLogo(int index);
+	const std::vector<GuiComponent*>& getExtras(int index);
+
 	void renderCarousel(const Transform4x4f& parentTrans);
 	void renderExtras(const Transform4x4f& parentTrans, float lower, float upper);
 	void renderInfoBar(const Transform4x4f& trans);
@@ -3,8 +3,13 @@
 #include "utils/StringUtil.h"
 #include "views/ViewController.h"
 #include "Log.h"
+#include "Settings.h"
 #include "Window.h"
 
+// the modes are asked for by every filter and menu
+static Setting<bool> sForceKid("ForceKid");
+static Setting<bool> sForceKiosk("ForceKiosk");
+
 UIModeController *  UIModeController::sInstance = NULL;
 
 UIModeController * UIModeController::getInstance()
@@ -28,7 +33,7 @@ void UIModeController::monitorUIMode()
 	if (uimode != mCurrentUIMode) // UIMODE HAS CHANGED
 	{
 		mCurrentUIMode = uimode;
-		ViewController::get()->ReloadAndGoToStart();
+		ViewController::get()->refreshUIModeAndGoToStart();
 	}
 }
 
@@ -85,19 +90,19 @@ void UIModeController::unlockUIMode()
 
 bool UIModeController::isUIModeFull()
 {
-	return ((mCurrentUIMode == "Full") && !Settings::getInstance()->getBool("ForceKiosk"));
+	return ((mCurrentUIMode == "Full") && !sForceKiosk.get());
 }
 
 bool UIModeController::isUIModeKid()
 {
-	return (Settings::getInstance()->getBool("ForceKid") ||
-		((mCurrentUIMode == "Kid") && !Settings::getInstance()->getBool("ForceKiosk")));
+	return (sForceKid.get() ||
+		((mCurrentUIMode == "Kid") && !sForceKiosk.get()));
 }
 
 bool UIModeController::isUIModeKiosk()
 {
-	return (Settings::getInstance()->getBool("ForceKiosk") ||
-		((mCurrentUIMode == "Kiosk") && !Settings::getInstance()->getBool("ForceKid")));
+	return (sForceKiosk.get() ||
+		((mCurrentUIMode == "Kiosk") && !sForceKid.get()));
 }
 
 std::string UIModeController::getFormattedPassKeyStr()
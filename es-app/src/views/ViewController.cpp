@@ -4,19 +4,27 @@
 #include "animations/LambdaAnimation.h"
 #include "animations/LaunchAnimation.h"
 #include "animations/MoveCameraAnimation.h"
+#include "components/BusyComponent.h"
 #include "guis/GuiMenu.h"
+#include "utils/TimelineUtil.h"
 #include "views/gamelist/DetailedGameListView.h"
 #include "views/gamelist/IGameListView.h"
 #include "views/gamelist/GridGameListView.h"
 #include "views/gamelist/VideoGameListView.h"
 #include "views/SystemView.h"
 #include "views/UIModeController.h"
+#include "AudioManager.h"
+#include "CollectionSystemManager.h"
 #include "FileFilterIndex.h"
+#include "FrameScheduler.h"
 #include "Log.h"
 #include "Scripting.h"
 #include "Settings.h"
 #include "SystemData.h"
 #include "Window.h"
+#include <SDL_timer.h>
+#include <atomic>
+#include <thread>
 
 ViewController* ViewController::sInstance = NULL;
 
@@ -33,13 +41,39 @@ void ViewController::init(Window* window)
 }
 
 ViewController::ViewController(Window* window)
-	: GuiComponent(window), mCurrentView(nullptr), mCamera(Transform4x4f::Identity()), mFadeOpacity(0), mLockInput(false)
+	: GuiComponent(window), mCurrentView(nullptr), mCamera(Transform4x4f::Identity()), mFadeOpacity(0), mLockInput(false), mPreloadPending(false),
+	mGameListColumnsDirty(true)
 {
 	mState.viewing = NOTHING;
+	FileData::addMetaDataListener(this);
 }
 
+// the thread only works on the copies taken when it started, the systems themselves are left alone until the swap
+struct ViewController::ThemeLoad
+{
+	ThemeLoad(Window* window) : loaded(0), cancelled(false), shown(0), busy(window) {}
+
+	std::vector<SystemData*> systems;
+	std::vector<std::string> paths;
+	std::vector< std::map<std::string, std::string> > variables;
+	std::vector< std::shared_ptr<ThemeData> > themes;
+	std::atomic<size_t> loaded;
+	std::atomic<bool> cancelled;
+	std::thread thread;
+	size_t shown; // themes counted on the busy indicator
+	BusyComponent busy;
+};
+
 ViewController::~ViewController()
 {
+	if(mThemeLoad)
+	{
+		mThemeLoad->cancelled = true;
+		mThemeLoad->thread.join();
+	}
+
+	FileData::removeMetaDataListener(this);
+
 	assert(sInstance == this);
 	sInstance = NULL;
 }
@@ -54,15 +88,15 @@ void ViewController::goToStart()
 			if ((*it)->getName() == requestedSystem)
 			{
 				goToGameList(*it);
-				Scripting::fireEvent("system-select", requestedSystem, "requestedsystem");
+				Scripting::queueEvent("system-select", requestedSystem, "requestedsystem");
 				FileData* cursor = getGameListView(*it)->getCursor();
 				if (cursor != NULL)
 				{
-					Scripting::fireEvent("game-select", requestedSystem, cursor->getPath(), cursor->getName(), "requestedgame");
+					Scripting::queueEvent("game-select", requestedSystem, cursor->getPath(), cursor->getName(), "requestedgame");
 				}
 				else
 				{
-					Scripting::fireEvent("game-select", "NULL", "NULL", "NULL", "requestedgame");
+					Scripting::queueEvent("game-select", "NULL", "NULL", "NULL", "requestedgame");
 				}
 				return;
 			}
@@ -72,14 +106,25 @@ void ViewController::goToStart()
 		Settings::getInstance()->setString("StartupSystem", "");
 	}
 	goToSystemView(SystemData::sSystemVector.at(0));
-	Scripting::fireEvent("system-select", SystemData::sSystemVector.at(0)->getName(), "gotostart");
+	Scripting::queueEvent("system-select", SystemData::sSystemVector.at(0)->getName(), "gotostart");
 }
 
-void ViewController::ReloadAndGoToStart()
+void ViewController::refreshUIModeAndGoToStart()
 {
-	mWindow->renderLoadingScreen("Loading...");
-	ViewController::get()->reloadAll();
-	ViewController::get()->goToStart();
+	// the games each mode hides are sets the filter indexes keep anyway, a mode only picks which of them apply. The
+	// other filters are reset like a reload did
+	for(auto it = SystemData::sSystemVector.cbegin(); it != SystemData::sSystemVector.cend(); it++)
+		(*it)->getIndex()->resetFilters();
+
+	// only the entries that are shown or hidden now change, the views and their themes stay
+	for(auto it = mGameListViews.cbegin(); it != mGameListViews.cend(); it++)
+		it->second->onFileChanged(it->first->getRootFolder(), FILE_SORTED);
+
+	// the systems without games to show are left out
+	mSystemListView.reset();
+	getSystemListView();
+
+	goToStart();
 }
 
 int ViewController::getSystemId(SystemData* system)
@@ -98,6 +143,7 @@ void ViewController::goToSystemView(SystemData* system)
 
 	mState.viewing = SYSTEM_SELECT;
 	mState.system = system;
+	playSystemMusic(system);
 
 	auto systemList = getSystemListView();
 	systemList->setPosition(getSystemId(system) * (float)Renderer::getScreenWidth(), systemList->getPosition().y());
@@ -110,6 +156,27 @@ void ViewController::goToSystemView(SystemData* system)
 	playViewTransition();
 }
 
+void ViewController::playSystemMusic(SystemData* system)
+{
+	// the instance only exists with sounds enabled
+	const std::shared_ptr<AudioManager>& audio = AudioManager::getInstance();
+
+	if(!audio)
+		return;
+
+	std::string path;
+
+	if(system && system->getTheme() && Settings::getInstance()->getBool("BackgroundMusic"))
+	{
+		const ThemeData::ThemeElement* elem = system->getTheme()->getElement("system", "music", "sound");
+
+		if(elem && elem->has("path"))
+			path = elem->get<std::string>("path");
+	}
+
+	audio->playMusic(path);
+}
+
 void ViewController::goToNextGameList()
 {
 	assert(mState.viewing == GAME_LIST);
@@ -141,6 +208,7 @@ void ViewController::goToGameList(SystemData* system)
 
 	mState.viewing = GAME_LIST;
 	mState.system = system;
+	playSystemMusic(system);
 
 	if (mCurrentView)
 	{
@@ -223,12 +291,14 @@ void ViewController::playViewTransition()
 			{
 				positionOrig = Vector3f(mCurrentView->getPosition());
 				mCurrentView->setPosition(tgt.x(), tgt.y());
+				mGameListColumnsDirty = true;
 			}
 		}
 
 		setAnimation(new MoveCameraAnimation(mCamera, tgt), 0, [this, positionOrig] {
 			if (mLockInput) {
 				mCurrentView->setPosition(positionOrig);
+				mGameListColumnsDirty = true;
 				mCamera.translation() = -positionOrig;
 			}
 			mLockInput = false;
@@ -283,9 +353,9 @@ void ViewController::launch(FileData* game, Vector3f center)
 		};
 		setAnimation(new LambdaAnimation(fadeFunc, 800), 0, [this, game, fadeFunc]
 		{
+			releaseForGame();
 			game->launchGame(mWindow);
 			setAnimation(new LambdaAnimation(fadeFunc, 800), 0, [this, game] { mLockInput = false; }, true);
-			this->onFileChanged(game, FILE_METADATA_CHANGED);
 			if (mCurrentView) {
 				this->getGameListView(game->getSystem())->setCursor(game, true);
 				mCurrentView->onShow();
@@ -295,10 +365,10 @@ void ViewController::launch(FileData* game, Vector3f center)
 		// move camera to zoom in on center + fade out, launch game, come back in
 		setAnimation(new LaunchAnimation(mCamera, mFadeOpacity, center, 1500), 0, [this, origCamera, center, game]
 		{
+			releaseForGame();
 			game->launchGame(mWindow);
 			mCamera = origCamera;
 			setAnimation(new LaunchAnimation(mCamera, mFadeOpacity, center, 600), 0, [this, game] { mLockInput = false; }, true);
-			this->onFileChanged(game, FILE_METADATA_CHANGED);
 			if (mCurrentView) {
 				this->getGameListView(game->getSystem())->setCursor(game, true);
 				mCurrentView->onShow();
@@ -307,10 +377,10 @@ void ViewController::launch(FileData* game, Vector3f center)
 	} else { // instant
 		setAnimation(new LaunchAnimation(mCamera, mFadeOpacity, center, 10), 0, [this, origCamera, center, game]
 		{
+			releaseForGame();
 			game->launchGame(mWindow);
 			mCamera = origCamera;
 			setAnimation(new LaunchAnimation(mCamera, mFadeOpacity, center, 10), 0, [this, game] { mLockInput = false; }, true);
-			this->onFileChanged(game, FILE_METADATA_CHANGED);
 			if (mCurrentView) {
 				this->getGameListView(game->getSystem())->setCursor(game, true);
 				mCurrentView->onShow();
@@ -327,6 +397,66 @@ void ViewController::removeGameListView(SystemData* system)
 	{
 		exists->second.reset();
 		mGameListViews.erase(system);
+		mGameListColumnsDirty = true;
+	}
+
+	mGameListViewOrder.remove(system);
+	mGameListViewStates.erase(system);
+}
+
+int ViewController::getMaxGameListViews() const
+{
+	int maxViews = Settings::getInstance()->getInt("MaxGameListViews");
+	if(Settings::getInstance()->getBool("LowMemory") && ((maxViews == 0) || (maxViews > LOW_MEMORY_GAMELIST_VIEWS)))
+		maxViews = LOW_MEMORY_GAMELIST_VIEWS;
+
+	// the view left behind is still on screen while the camera moves to the next one
+	return (maxViews > 0) ? Math::max(maxViews, 2) : 0;
+}
+
+void ViewController::touchGameListView(SystemData* system)
+{
+	if(!mGameListViewOrder.empty() && mGameListViewOrder.front() == system)
+		return;
+
+	mGameListViewOrder.remove(system);
+	mGameListViewOrder.push_front(system);
+}
+
+void ViewController::evictGameListViews()
+{
+	const int maxViews = getMaxGameListViews();
+	if(maxViews == 0)
+		return;
+
+	dropGameListViews(maxViews);
+}
+
+void ViewController::releaseForGame()
+{
+	if(Settings::getInstance()->getBool("TrimMemoryDuringGames"))
+		dropGameListViews(1);
+}
+
+void ViewController::dropGameListViews(int maxViews)
+{
+	// the most recently used view always stays, it's the one just asked for
+	auto it = mGameListViewOrder.end();
+	while((int)mGameListViews.size() > maxViews && it != mGameListViewOrder.begin() && --it != mGameListViewOrder.begin())
+	{
+		auto view = mGameListViews.find(*it);
+		if(view == mGameListViews.cend() || view->second == mCurrentView)
+			continue;
+
+		FileData* cursor = view->second->getCursor();
+		if(cursor && !cursor->isPlaceHolder())
+			mGameListViewStates[*it] = { cursor->getPath(), view->second->getViewportTop() };
+
+		LOG(LogDebug) << "Dropping gamelist view of " << (*it)->getName();
+
+		mGameListViews.erase(view);
+		mGameListColumnsDirty = true;
+		it = mGameListViewOrder.erase(it);
 	}
 }
 
@@ -353,7 +483,12 @@ std::shared_ptr<IGameListView> ViewController::getGameListView(SystemData* syste
 	//if we already made one, return that one
 	auto exists = mGameListViews.find(system);
 	if(exists != mGameListViews.cend())
+	{
+		touchGameListView(system);
 		return exists->second;
+	}
+
+	CollectionSystemManager::get()->populateIfNeeded(system);
 
 	system->getIndex()->setUIModeFilters();
 	//if we didn't, make it, remember it, and return it
@@ -409,6 +544,27 @@ std::shared_ptr<IGameListView> ViewController::getGameListView(SystemData* syste
 	addChild(view.get());
 
 	mGameListViews[system] = view;
+	mGameListColumnsDirty = true;
+	touchGameListView(system);
+
+	// a view dropped earlier picks up where it was left
+	auto state = mGameListViewStates.find(system);
+	if(state != mGameListViewStates.cend())
+	{
+		std::vector<FileData*> files = system->getRootFolder()->getFilesRecursive(GAME | FOLDER);
+		for(auto it = files.cbegin(); it != files.cend(); it++)
+		{
+			if((*it)->getPath() == state->second.cursor)
+			{
+				view->setCursor(*it);
+				view->setViewportTop(state->second.viewportTop);
+				break;
+			}
+		}
+		mGameListViewStates.erase(state);
+	}
+
+	evictGameListViews();
 	return view;
 }
 
@@ -457,33 +613,38 @@ void ViewController::update(int deltaTime)
 	}
 
 	updateSelf(deltaTime);
+
+	updateThemeLoad(deltaTime);
+
+	updateSystemLoad();
+
+	preloadOnIdle();
 }
 
 void ViewController::render(const Transform4x4f& parentTrans)
 {
 	Transform4x4f trans = mCamera * parentTrans;
-	Transform4x4f transInverse;
-	transInverse.invert(trans);
-
-	// camera position, position + size
-	Vector3f viewStart = transInverse.translation();
-	Vector3f viewEnd = transInverse * Vector3f((float)Renderer::getScreenWidth(), (float)Renderer::getScreenHeight(), 0);
 
 	// Keep track of UI mode changes.
 	UIModeController::getInstance()->monitorUIMode();
 
-	// draw systemview
-	getSystemListView()->render(trans);
+	// only the views the camera is on are drawn, in a gamelist the system view is a screen away. A view that isn't
+	// rendered doesn't walk its components either
+	SystemView* systemListView = getSystemListView().get();
+	if(systemListView->isOnScreen(trans))
+		systemListView->render(trans);
 
-	// draw gamelists
-	for(auto it = mGameListViews.cbegin(); it != mGameListViews.cend(); it++)
-	{
-		// clipping
-		Vector3f guiStart = it->second->getPosition();
-		Vector3f guiEnd = it->second->getPosition() + Vector3f(it->second->getSize().x(), it->second->getSize().y(), 0);
+	if(mGameListColumnsDirty)
+		updateGameListColumns();
+
+	// the camera overlaps the column it starts in and the next one, the one before it is checked as well since a view
+	// ending right where the camera starts still counts as on screen
+	const int column = (int)Math::floorf(-trans.translation().x() / (float)Renderer::getScreenWidth());
+	const auto end = mGameListColumns.upper_bound(column + 1);
 
-		if(guiEnd.x() >= viewStart.x() && guiEnd.y() >= viewStart.y() &&
-			guiStart.x() <= viewEnd.x() && guiStart.y() <= viewEnd.y())
+	for(auto it = mGameListColumns.lower_bound(column - 1); it != end; it++)
+	{
+		if(it->second->isOnScreen(trans))
 			it->second->render(trans);
 	}
 
@@ -497,10 +658,141 @@ void ViewController::render(const Transform4x4f& parentTrans)
 		Renderer::setMatrix(parentTrans);
 		Renderer::drawRect(0.0f, 0.0f, Renderer::getScreenWidth(), Renderer::getScreenHeight(), fadeColor, fadeColor);
 	}
+
+	if(mThemeLoad)
+		mThemeLoad->busy.render(parentTrans);
+}
+
+void ViewController::updateGameListColumns()
+{
+	const float screenWidth = (float)Renderer::getScreenWidth();
+
+	mGameListColumns.clear();
+	for(auto it = mGameListViews.cbegin(); it != mGameListViews.cend(); it++)
+		mGameListColumns.insert(std::make_pair((int)Math::floorf(it->second->getPosition().x() / screenWidth), it->second.get()));
+
+	mGameListColumnsDirty = false;
+}
+
+void ViewController::reloadThemesAsync()
+{
+	// a theme set picked while another one loads replaces it
+	if(mThemeLoad)
+	{
+		mThemeLoad->cancelled = true;
+		mThemeLoad->thread.join();
+	}
+
+	mThemeLoad = std::unique_ptr<ThemeLoad>(new ThemeLoad(mWindow));
+	ThemeLoad* load = mThemeLoad.get();
+
+	// the settings and systems are only read here, on the main thread
+	for(auto it = SystemData::sSystemVector.cbegin(); it != SystemData::sSystemVector.cend(); it++)
+	{
+		load->systems.push_back(*it);
+		load->paths.push_back((*it)->getThemePath());
+		load->variables.push_back((*it)->getThemeVariables());
+	}
+	load->themes.resize(load->systems.size());
+
+	load->busy.setSize((float)Renderer::getScreenWidth(), (float)Renderer::getScreenHeight());
+	load->busy.setText("LOADING THEME 0/" + std::to_string(load->systems.size()));
+
+	load->thread = std::thread([load]
+	{
+		for(size_t i = 0; (i < load->themes.size()) && !load->cancelled; i++)
+		{
+			load->themes[i] = SystemData::prepareTheme(load->paths[i], load->variables[i]);
+			load->loaded++;
+			FrameScheduler::wakeUp();
+		}
+	});
+}
+
+void ViewController::updateThemeLoad(int deltaTime)
+{
+	if(!mThemeLoad)
+		return;
+
+	const size_t loaded = mThemeLoad->loaded;
+	if(loaded != mThemeLoad->shown)
+	{
+		mThemeLoad->busy.setText("LOADING THEME " + std::to_string(loaded) + "/" + std::to_string(mThemeLoad->systems.size()));
+		mThemeLoad->shown = loaded;
+	}
+	mThemeLoad->busy.update(deltaTime);
+
+	if(loaded < mThemeLoad->systems.size())
+		return;
+
+	mThemeLoad->thread.join();
+
+	// systems removed meanwhile are gone from the list, the ones added get their theme with reloadAll
+	std::vector<SystemData*>& systems = SystemData::sSystemVector;
+	for(size_t i = 0; i < mThemeLoad->systems.size(); i++)
+	{
+		if(std::find(systems.cbegin(), systems.cend(), mThemeLoad->systems[i]) != systems.cend())
+			mThemeLoad->systems[i]->setTheme(mThemeLoad->themes[i]);
+	}
+
+	mThemeLoad.reset();
+	reloadAll(true, false);
+}
+
+void ViewController::updateSystemLoad()
+{
+	if (!SystemData::isLoading())
+		return;
+
+	FrameScheduler::requestFrame(SYSTEM_LOAD_POLL);
+
+	const std::vector<SystemData*> shown = SystemData::sSystemVector;
+	if (!SystemData::updateLoading(nullptr))
+		return;
+
+	// like preload(), the views are made once they're opened or the screen is idle
+	for(auto it = SystemData::sSystemVector.cbegin(); it != SystemData::sSystemVector.cend(); it++)
+	{
+		if (std::find(shown.cbegin(), shown.cend(), *it) == shown.cend())
+			(*it)->getIndex()->resetFilters();
+	}
+	mPreloadPending = true;
+
+	// the systems after a new one moved, their views move along and the camera with the one on screen
+	const float width = (float)Renderer::getScreenWidth();
+	const float currentX = mCurrentView ? mCurrentView->getPosition().x() : 0;
+
+	for(auto it = mGameListViews.cbegin(); it != mGameListViews.cend(); it++)
+		it->second->setPosition(getSystemId(it->first) * width, it->second->getPosition().y());
+
+	if (mSystemListView)
+	{
+		SystemData* selected = (mSystemListView->size() > 0) ? mSystemListView->getSelected() : nullptr;
+		mSystemListView->populate();
+		if (selected)
+			mSystemListView->goToSystem(selected, false);
+
+		if (mState.viewing == SYSTEM_SELECT)
+			mSystemListView->setPosition(getSystemId(mState.getSystem()) * width, mSystemListView->getPosition().y());
+	}
+
+	if (mCurrentView)
+		mCamera.translation().x() -= mCurrentView->getPosition().x() - currentX;
 }
 
 void ViewController::preload()
 {
+	TimelineScope("ViewController::preload");
+
+	if (Settings::getInstance()->getBool("LazyGameListViews") || Settings::getInstance()->getBool("LowMemory"))
+	{
+		for(auto it = SystemData::sSystemVector.cbegin(); it != SystemData::sSystemVector.cend(); it++)
+			(*it)->getIndex()->resetFilters();
+
+		mPreloadPending = true;
+		return;
+	}
+
 	int i = 1;
 	int max = SystemData::sSystemVector.size() + 1;
 
@@ -516,9 +808,78 @@ void ViewController::preload()
 			mWindow->renderLoadingScreen("Preloading UI", (float)i / (float)max);
 		}
 
+		TimelineScopeDetail("ViewController::getGameListView", (*it)->getName());
+
 		(*it)->getIndex()->resetFilters();
+		// collections populated on demand get their view once they're opened
+		if (!CollectionSystemManager::get()->needsPopulating(*it))
+			getGameListView(*it);
+	}
+}
+
+void ViewController::preloadOnIdle()
+{
+	// a view created during a transition would make it stutter
+	if (!mPreloadPending || mWindow->getTimeSinceLastInput() < IDLE_PRELOAD_DELAY || isAnimationPlaying(0))
+		return;
+
+	const unsigned int start = SDL_GetTicks();
+
+	const int maxViews = getMaxGameListViews();
+
+	for(auto it = SystemData::sSystemVector.cbegin(); it != SystemData::sSystemVector.cend(); it++)
+	{
+		if (mGameListViews.find(*it) != mGameListViews.cend() || CollectionSystemManager::get()->needsPopulating(*it))
+			continue;
+
+		// views warmed past the cap would only push out the ones actually visited
+		if (maxViews > 0 && (int)mGameListViews.size() >= maxViews)
+			break;
+
+		// a view can't be split up, so there's always at least one per frame
+		if (SDL_GetTicks() - start >= IDLE_PRELOAD_BUDGET)
+		{
+			// an idle screen waits long between frames, the next view shouldn't wait with it
+			FrameScheduler::requestFrame(0);
+			return;
+		}
+
 		getGameListView(*it);
 	}
+
+	mPreloadPending = false;
+}
+
+void ViewController::rebuildGameListView(SystemData* system, bool reloadTheme)
+{
+	auto it = mGameListViews.find(system);
+	if(it == mGameListViews.cend())
+		return;
+
+	std::shared_ptr<IGameListView> view = it->second;
+	bool isCurrent = (mCurrentView == view);
+	FileData* cursor = view->getCursor();
+	int viewportTop = view->getViewportTop();
+	mGameListViews.erase(it);
+	mGameListColumnsDirty = true;
+
+	if(reloadTheme)
+	{
+		system->loadTheme();
+		// the carousel entry was made from the old theme
+		if(mSystemListView)
+			mSystemListView->reloadSystem(system);
+	}
+	system->getIndex()->setUIModeFilters();
+	std::shared_ptr<IGameListView> newView = getGameListView(system);
+
+	// to counter having come from a placeholder
+	if (!cursor->isPlaceHolder()) {
+		newView->setCursor(cursor);
+		newView->setViewportTop(viewportTop);
+	}
+	if(isCurrent)
+		mCurrentView = newView;
 }
 
 void ViewController::reloadGameListView(IGameListView* view, bool reloadTheme)
@@ -527,25 +888,7 @@ void ViewController::reloadGameListView(IGameListView* view, bool reloadTheme)
 	{
 		if(it->second.get() == view)
 		{
-			bool isCurrent = (mCurrentView == it->second);
-			SystemData* system = it->first;
-			FileData* cursor = view->getCursor();
-			int viewportTop = view->getViewportTop();
-			mGameListViews.erase(it);
-
-			if(reloadTheme)
-				system->loadTheme();
-			system->getIndex()->setUIModeFilters();
-			std::shared_ptr<IGameListView> newView = getGameListView(system);
-
-			// to counter having come from a placeholder
-			if (!cursor->isPlaceHolder()) {
-				newView->setCursor(cursor);
-				newView->setViewportTop(viewportTop);
-			}
-			if(isCurrent)
-				mCurrentView = newView;
-
+			rebuildGameListView(it->first, reloadTheme);
 			break;
 		}
 	}
@@ -555,7 +898,78 @@ void ViewController::reloadGameListView(IGameListView* view, bool reloadTheme)
 
 }
 
-void ViewController::reloadAll(bool themeChanged)
+void ViewController::reloadSystem(SystemData* system, bool reloadTheme, bool reloadGamelist)
+{
+	if(reloadGamelist)
+		system->reloadGamelist();
+
+	if(mGameListViews.find(system) != mGameListViews.cend())
+		rebuildGameListView(system, reloadTheme);
+	else if(reloadTheme)
+	{
+		// made with the new theme once it's opened
+		system->loadTheme();
+		if(mSystemListView)
+			mSystemListView->reloadSystem(system);
+	}
+
+	if(reloadTheme)
+		ThemeData::clearCache();
+
+	if(mCurrentView)
+		mCurrentView->onShow();
+
+	updateHelpPrompts();
+}
+
+void ViewController::reloadCollections()
+{
+	const std::vector<SystemData*>& systems = SystemData::sSystemVector;
+	std::vector<SystemData*> removed;
+	std::vector<SystemData*> collections;
+
+	for(auto it = mGameListViews.cbegin(); it != mGameListViews.cend(); it++)
+	{
+		if(std::find(systems.cbegin(), systems.cend(), it->first) == systems.cend())
+			removed.push_back(it->first);
+		else if(it->first->isCollection())
+			collections.push_back(it->first);
+	}
+
+	for(auto it = removed.cbegin(); it != removed.cend(); it++)
+		removeGameListView(*it);
+
+	// their names and sorting follow the settings
+	for(auto it = collections.cbegin(); it != collections.cend(); it++)
+		rebuildGameListView(*it, false);
+
+	// the systems after a collection that came or went moved
+	const float width = (float)Renderer::getScreenWidth();
+	for(auto it = mGameListViews.cbegin(); it != mGameListViews.cend(); it++)
+		it->second->setPosition(getSystemId(it->first) * width, it->second->getPosition().y());
+
+	if(mSystemListView)
+		mSystemListView->populate();
+
+	updateHelpPrompts();
+}
+
+void ViewController::reloadGameListViews()
+{
+	std::vector<SystemData*> systems;
+	for(auto it = mGameListViews.cbegin(); it != mGameListViews.cend(); it++)
+		systems.push_back(it->first);
+
+	for(auto it = systems.cbegin(); it != systems.cend(); it++)
+		rebuildGameListView(*it, false);
+
+	if(mCurrentView)
+		mCurrentView->onShow();
+
+	updateHelpPrompts();
+}
+
+void ViewController::reloadAll(bool themeChanged, bool loadThemes)
 {
 	// clear all gamelistviews
 	std::map<SystemData*, FileData*> cursorMap;
@@ -566,11 +980,14 @@ void ViewController::reloadAll(bool themeChanged)
 		viewportTopMap[it->first] = it->second->getViewportTop();
 	}
 	mGameListViews.clear();
+	mGameListColumnsDirty = true;
+	mGameListViewOrder.clear();
 
 	// load themes, create gamelistviews and reset filters
 	for(auto it = cursorMap.cbegin(); it != cursorMap.cend(); it++)
 	{
-		it->first->loadTheme();
+		if(loadThemes)
+			it->first->loadTheme();
 		it->first->getIndex()->resetFilters();
 		getGameListView(it->first)->setCursor(it->second);
 	}
@@ -588,6 +1005,9 @@ void ViewController::reloadAll(bool themeChanged)
 	mSystemListView.reset();
 	getSystemListView();
 
+	// the themes are loaded, their files can go
+	ThemeData::clearCache();
+
 	// update mCurrentView since the pointers changed
 	if(mState.viewing == GAME_LIST)
 	{
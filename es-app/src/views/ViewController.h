@@ -5,6 +5,8 @@
 #include "renderers/Renderer.h"
 #include "FileData.h"
 #include "GuiComponent.h"
+#include <list>
+#include <map>
 #include <vector>
 
 class IGameListView;
@@ -12,7 +14,7 @@ class SystemData;
 class SystemView;
 
 // Used to smoothly transition the camera between multiple views (e.g. from system to system, from gamelist to gamelist).
-class ViewController : public GuiComponent
+class ViewController : public GuiComponent, public MetaDataListener
 {
 public:
 	static void init(Window* window);
@@ -22,13 +24,26 @@ public:
 
 	// Try to completely populate the GameListView map.
 	// Caches things so there's no pauses during transitions.
+	// With "LazyGameListViews" the views are only created once they're opened or the UI sits idle.
 	void preload();
 
 	// If a basic view detected a metadata change, it can request to recreate
 	// the current gamelist view (as it may change to be detailed).
 	void reloadGameListView(IGameListView* gamelist, bool reloadTheme = false);
 	inline void reloadGameListView(SystemData* system, bool reloadTheme = false) { reloadGameListView(getGameListView(system).get(), reloadTheme); }
-	void reloadAll(bool themeChanged = false); // Reload everything with a theme.  When the "ThemeSet" setting changes, themeChanged is true.
+	void reloadAll(bool themeChanged = false, bool loadThemes = true); // Reload everything with a theme.  When the "ThemeSet" setting changes, themeChanged is true.
+	// Only what a change to one system touches, its theme, its gamelist view if there is one and its carousel entry,
+	// with reloadGamelist its games are read again from its gamelist as well. The other systems' views stay as they are
+	void reloadSystem(SystemData* system, bool reloadTheme = true, bool reloadGamelist = false);
+	// After the collection settings changed, the views of the collections are built again and the ones no longer
+	// shown dropped, the carousel is made again. The views of the game systems stay as they are
+	void reloadCollections();
+	// Every gamelist view is built again with the themes it has, for settings that change how they're laid out. The
+	// carousel stays
+	void reloadGameListViews();
+	// The themes of all systems are loaded on another thread while the old ones stay on screen with a busy indicator,
+	// then everything is reloaded with them at once like reloadAll(true).
+	void reloadThemesAsync();
 
 	// Navigation.
 	void goToNextGameList();
@@ -36,9 +51,14 @@ public:
 	void goToGameList(SystemData* system);
 	void goToSystemView(SystemData* system);
 	void goToStart();
-	void ReloadAndGoToStart();
+	// Filters every system for the UI mode again and updates the gamelists in place, then goes to the start
+	void refreshUIModeAndGoToStart();
+
+	// Crossfades to the background music the theme has for system, if any
+	void playSystemMusic(SystemData* system);
 
 	void onFileChanged(FileData* file, FileChangeType change);
+	void onMetaDataChanged(FileData* file) override { onFileChanged(file, FILE_METADATA_CHANGED); }
 
 	// Plays a nice launch effect and launches the game at the end of it.
 	// Once the game terminates, plays a return effect.
@@ -92,15 +112,59 @@ private:
 	static ViewController* sInstance;
 
 	void playViewTransition();
+	// replaces the view of system by a new one at the same cursor, without showing it
+	void rebuildGameListView(SystemData* system, bool reloadTheme);
+	// creates the views preload() left out, a few per frame once there was no input for a while
+	void preloadOnIdle();
+
+	// swaps the themes in once reloadThemesAsync() got all of them
+	void updateThemeLoad(int deltaTime);
+
+	// adds the systems a progressive boot loaded since the last frame to the carousel
+	void updateSystemLoad();
+
+	// "MaxGameListViews" caps the views kept alive, 0 when there's no cap
+	int getMaxGameListViews() const;
+	// drops the least recently used views over the cap, remembering where their cursor was
+	void evictGameListViews();
+	void dropGameListViews(int maxViews);
+	// with "TrimMemoryDuringGames" only the view the game is launched from stays while it runs
+	void releaseForGame();
+	void touchGameListView(SystemData* system);
 	int getSystemId(SystemData* system);
+	void updateGameListColumns();
 
 	std::shared_ptr<GuiComponent> mCurrentView;
 	std::map< SystemData*, std::shared_ptr<IGameListView> > mGameListViews;
+
+	// the gamelist views by the screen column they're in, so rendering only looks at the ones next to the camera.
+	// Built again when a view is added, dropped or moved
+	std::multimap<int, IGameListView*> mGameListColumns;
+	bool mGameListColumnsDirty;
+
+	// what's left of a dropped view, so it comes back the way it was left
+	struct GameListViewState
+	{
+		std::string cursor;
+		int viewportTop;
+	};
+
+	struct ThemeLoad;
+	std::unique_ptr<ThemeLoad> mThemeLoad;
+
+	std::list<SystemData*> mGameListViewOrder; // most recently used first
+	std::map<SystemData*, GameListViewState> mGameListViewStates;
 	std::shared_ptr<SystemView> mSystemListView;
 
 	Transform4x4f mCamera;
 	float mFadeOpacity;
 	bool mLockInput;
+	bool mPreloadPending;
+
+	static const unsigned int IDLE_PRELOAD_DELAY = 1000; // millis
+	static const unsigned int IDLE_PRELOAD_BUDGET = 8; // millis per frame
+	static const int SYSTEM_LOAD_POLL = 100; // millis between looking for loaded systems on an idle screen
+	static const int LOW_MEMORY_GAMELIST_VIEWS = 2; // kept loaded with LowMemory, whatever MaxGameListViews says
 
 	State mState;
 };
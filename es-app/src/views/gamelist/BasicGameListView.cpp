@@ -6,6 +6,8 @@
 #include "CollectionSystemManager.h"
 #include "Settings.h"
 #include "SystemData.h"
+#include "ThemeData.h"
+#include <string.h>
 
 BasicGameListView::BasicGameListView(Window* window, FileData* root)
 	: ISimpleGameListView(window, root), mList(window)
@@ -29,11 +31,15 @@ void BasicGameListView::onThemeChanged(const std::shared_ptr<ThemeData>& theme)
 
 void BasicGameListView::onFileChanged(FileData* file, FileChangeType change)
 {
-	if(change == FILE_METADATA_CHANGED)
+	if(change == FILE_METADATA_CHANGED && ViewController::get()->getGameListViewType() == ViewController::AUTOMATIC)
 	{
-		// might switch to a detailed view
-		ViewController::get()->reloadGameListView(this);
-		return;
+		// new media might switch to a detailed or video view, anything else is updated in place
+		const bool video = mRoot->getSystem()->getTheme()->hasView("video") && !file->getVideoPath().empty();
+		if((video && strcmp(getName(), "video") != 0) || (strcmp(getName(), "basic") == 0 && !file->getThumbnailPath().empty()))
+		{
+			ViewController::get()->reloadGameListView(this);
+			return;
+		}
 	}
 
 	ISimpleGameListView::onFileChanged(file, change);
@@ -56,6 +62,15 @@ void BasicGameListView::populateList(const std::vector<FileData*>& files)
 	}
 }
 
+void BasicGameListView::updateList(const std::vector<FileData*>& files, FileData* changed)
+{
+	mHeaderText.setText(mRoot->getSystem()->getFullName());
+	mList.updateEntries(files, changed, [](FileData* file)
+	{
+		return TextListComponent<FileData*>::makeEntry(file->getName(), file, (file->getType() == FOLDER));
+	});
+}
+
 FileData* BasicGameListView::getCursor()
 {
 	return mList.getSelected();
@@ -31,6 +31,7 @@ protected:
 	virtual std::string getQuickSystemSelectRightButton() override;
 	virtual std::string getQuickSystemSelectLeftButton() override;
 	virtual void populateList(const std::vector<FileData*>& files) override;
+	virtual void updateList(const std::vector<FileData*>& files, FileData* changed) override;
 	virtual void remove(FileData* game, bool deleteFile, bool refreshView=true) override;
 	virtual void addPlaceholder();
 
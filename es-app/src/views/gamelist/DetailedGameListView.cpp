@@ -1,8 +1,13 @@
 #include "views/gamelist/DetailedGameListView.h"
 
 #include "animations/LambdaAnimation.h"
+#include "resources/TextureResource.h"
 #include "views/ViewController.h"
 
+// how long the cursor has to rest on a game before its images are loaded and its description is wrapped,
+// shorter than the repeat delay of a held button but longer than a frame or two of quick presses
+static const int MEDIA_SETTLE_TIME = 150;
+
 DetailedGameListView::DetailedGameListView(Window* window, FileData* root) :
 	BasicGameListView(window, root),
 	mDescContainer(window, DESCRIPTION_SCROLL_DELAY), mDescription(window),
@@ -15,7 +20,7 @@ DetailedGameListView::DetailedGameListView(Window* window, FileData* root) :
 
 	mRating(window), mReleaseDate(window), mDeveloper(window), mPublisher(window),
 	mGenre(window), mPlayers(window), mLastPlayed(window), mPlayCount(window),
-	mName(window)
+	mName(window), mMediaDelay(0)
 {
 	//mHeaderImage.setPosition(mSize.x() * 0.25f, 0);
 
@@ -26,6 +31,11 @@ DetailedGameListView::DetailedGameListView(Window* window, FileData* root) :
 	mList.setAlignment(TextListComponent<FileData*>::ALIGN_LEFT);
 	mList.setCursorChangedCallback([&](const CursorState& /*state*/) { updateInfoPanel(); });
 
+	// Moving the cursor mustn't wait for the images of the game it moves to
+	mImage.setAsyncLoad(true);
+	mThumbnail.setAsyncLoad(true);
+	mMarquee.setAsyncLoad(true);
+
 	// Image
 	mImage.setOrigin(0.5f, 0.5f);
 	mImage.setPosition(mSize.x() * 0.25f, mList.getPosition().y() + mSize.y() * 0.2125f);
@@ -220,15 +230,15 @@ void DetailedGameListView::updateInfoPanel()
 		//mImage.setImage("");
 		//mDescription.setText("");
 		fadingOut = true;
+
+		// they'd be outdated by the time scrolling stops
+		mPrefetched.clear();
 	}else{
-		mThumbnail.setImage(file->getThumbnailPath());
-		mMarquee.setImage(file->getMarqueePath());
-		mImage.setImage(file->getImagePath());
-		mDescription.setText(file->metadata.get("desc"));
-		mDescContainer.reset();
+		// the text is cheap and follows the cursor right away, the images and the description wait for it to rest
+		mMediaDelay = MEDIA_SETTLE_TIME;
 
 		mRating.setValue(file->metadata.get("rating"));
-		mReleaseDate.setValue(file->metadata.get("releasedate"));
+		mReleaseDate.setTime(file->metadata.getTime(MD_ID_RELEASEDATE));
 		mDeveloper.setValue(file->metadata.get("developer"));
 		mPublisher.setValue(file->metadata.get("publisher"));
 		mGenre.setValue(file->metadata.get("genre"));
@@ -237,7 +247,7 @@ void DetailedGameListView::updateInfoPanel()
 
 		if(file->getType() == GAME)
 		{
-			mLastPlayed.setValue(file->metadata.get("lastplayed"));
+			mLastPlayed.setTime(file->metadata.getTime(MD_ID_LASTPLAYED));
 			mPlayCount.setValue(file->metadata.get("playcount"));
 		}
 
@@ -272,6 +282,53 @@ void DetailedGameListView::updateInfoPanel()
 	}
 }
 
+void DetailedGameListView::updateMedia()
+{
+	if(mList.size() == 0 || mList.isScrolling())
+		return;
+
+	FileData* file = mList.getSelected();
+
+	mThumbnail.setImage(file->getThumbnailPath());
+	mMarquee.setImage(file->getMarqueePath());
+	mImage.setImage(file->getImagePath());
+
+	// the games next to it are likely shown next, the new list is filled first so images still needed aren't dropped
+	std::vector<std::shared_ptr<TextureResource>> prefetched;
+	for(int offset = -1; offset <= 1; offset += 2)
+	{
+		const int index = mList.getCursorIndex() + offset;
+		if((index < 0) || (index >= mList.size()))
+			continue;
+
+		FileData* next = mList.getObjectAt(index);
+		if(mImage.isVisible())
+			prefetched.push_back(mImage.prefetch(next->getImagePath()));
+		if(mThumbnail.isVisible())
+			prefetched.push_back(mThumbnail.prefetch(next->getThumbnailPath()));
+		if(mMarquee.isVisible())
+			prefetched.push_back(mMarquee.prefetch(next->getMarqueePath()));
+	}
+	mPrefetched.swap(prefetched);
+	mDescription.setText(file->getDescription());
+	mDescContainer.reset();
+}
+
+void DetailedGameListView::update(int deltaTime)
+{
+	BasicGameListView::update(deltaTime);
+
+	if(mMediaDelay > 0)
+	{
+		mMediaDelay -= deltaTime;
+		if(mMediaDelay <= 0)
+		{
+			mMediaDelay = 0;
+			updateMedia();
+		}
+	}
+}
+
 void DetailedGameListView::launch(FileData* game)
 {
 	Vector3f target(Renderer::getScreenWidth() / 2.0f, Renderer::getScreenHeight() / 2.0f, 0);
@@ -20,8 +20,12 @@ public:
 
 	void onFocusLost() override;
 
+protected:
+	virtual void update(int deltaTime) override;
+
 private:
 	void updateInfoPanel();
+	void updateMedia(); // the images and the description, only once the cursor rests
 
 	void initMDLabels();
 	void initMDValues();
@@ -47,6 +51,11 @@ private:
 
 	ScrollableContainer mDescContainer;
 	TextComponent mDescription;
+
+	// The images of the games next to the selected one, kept while they're loaded in the background
+	std::vector<std::shared_ptr<TextureResource>> mPrefetched;
+
+	int mMediaDelay; // ms until updateMedia() runs, 0 when it ran for the selected game
 };
 
 #endif // ES_APP_VIEWS_GAME_LIST_DETAILED_GAME_LIST_VIEW_H
@@ -1,15 +1,13 @@
 #include "views/gamelist/GridGameListView.h"
 
 #include "animations/LambdaAnimation.h"
+#include "components/VideoComponent.h"
 #include "views/UIModeController.h"
 #include "views/ViewController.h"
 #include "CollectionSystemManager.h"
 #include "Settings.h"
 #include "SystemData.h"
-#ifdef _OMX_
-#include "components/VideoPlayerComponent.h"
-#endif
-#include "components/VideoVlcComponent.h"
+#include "VideoBackend.h"
 
 GridGameListView::GridGameListView(Window* window, FileData* root) :
 	ISimpleGameListView(window, root),
@@ -28,15 +26,8 @@ GridGameListView::GridGameListView(Window* window, FileData* root) :
 {
 	const float padding = 0.01f;
 
-// Create the correct type of video window
-#ifdef _OMX_
-	if (Settings::getInstance()->getBool("VideoOmxPlayer"))
-		mVideo = new VideoPlayerComponent(window, "");
-	else
-		mVideo = new VideoVlcComponent(window, getTitlePath());
-#else
-	mVideo = new VideoVlcComponent(window, getTitlePath());
-#endif
+	// Create the correct type of video window
+	mVideo = VideoBackend::create(window, getTitlePath(), false);
 
 	mGrid.setPosition(mSize.x() * 0.1f, mSize.y() * 0.1f);
 	mGrid.setDefaultZIndex(20);
@@ -170,6 +161,15 @@ const std::string GridGameListView::getImagePath(FileData* file)
 	return file->getThumbnailPath();
 }
 
+void GridGameListView::updateList(const std::vector<FileData*>& files, FileData* changed)
+{
+	mHeaderText.setText(mRoot->getSystem()->getFullName());
+	mGrid.updateEntries(files, changed, [this](FileData* file)
+	{
+		return ImageGridComponent<FileData*>::makeEntry(file->getName(), getImagePath(file), file);
+	});
+}
+
 void GridGameListView::populateList(const std::vector<FileData*>& files)
 {
 	mGrid.clear();
@@ -327,11 +327,11 @@ void GridGameListView::updateInfoPanel()
 		mMarquee.setImage(file->getMarqueePath());
 		mImage.setImage(file->getImagePath());
 
-		mDescription.setText(file->metadata.get("desc"));
+		mDescription.setText(file->getDescription());
 		mDescContainer.reset();
 
 		mRating.setValue(file->metadata.get("rating"));
-		mReleaseDate.setValue(file->metadata.get("releasedate"));
+		mReleaseDate.setTime(file->metadata.getTime(MD_ID_RELEASEDATE));
 		mDeveloper.setValue(file->metadata.get("developer"));
 		mPublisher.setValue(file->metadata.get("publisher"));
 		mGenre.setValue(file->metadata.get("genre"));
@@ -340,7 +340,7 @@ void GridGameListView::updateInfoPanel()
 
 		if(file->getType() == GAME)
 		{
-			mLastPlayed.setValue(file->metadata.get("lastplayed"));
+			mLastPlayed.setTime(file->metadata.getTime(MD_ID_LASTPLAYED));
 			mPlayCount.setValue(file->metadata.get("playcount"));
 		}
 
@@ -1,9 +1,11 @@
 #include "views/gamelist/IGameListView.h"
 
 #include "guis/GuiGamelistOptions.h"
+#include "renderers/GpuProfiler.h"
 #include "views/UIModeController.h"
 #include "views/ViewController.h"
 #include "Sound.h"
+#include "SystemData.h"
 #include "Window.h"
 
 bool IGameListView::input(InputConfig* config, Input input)
@@ -20,7 +22,7 @@ bool IGameListView::input(InputConfig* config, Input input)
 		(SDL_GetModState() & (KMOD_LCTRL | KMOD_RCTRL)) && input.id == SDLK_r && input.value != 0)
 	{
 		LOG(LogDebug) << "reloading view";
-		ViewController::get()->reloadGameListView(this, true);
+		ViewController::get()->reloadSystem(mRoot->getSystem(), true, true);
 		return true;
 	}
 
@@ -42,6 +44,8 @@ HelpStyle IGameListView::getHelpStyle()
 
 void IGameListView::render(const Transform4x4f& parentTrans)
 {
+	GpuProfilerScopeDetail("IGameListView::render", mRoot->getSystem()->getName());
+
 	Transform4x4f trans = parentTrans * getTransform();
 
 	float scaleX = trans.r0().x();
@@ -3,6 +3,7 @@
 #include "views/UIModeController.h"
 #include "views/ViewController.h"
 #include "CollectionSystemManager.h"
+#include "RomPrefetch.h"
 #include "Scripting.h"
 #include "Settings.h"
 #include "Sound.h"
@@ -61,14 +62,22 @@ void ISimpleGameListView::onThemeChanged(const std::shared_ptr<ThemeData>& theme
 	}
 }
 
-void ISimpleGameListView::onFileChanged(FileData* /*file*/, FileChangeType /*change*/)
+void ISimpleGameListView::onFileChanged(FileData* file, FileChangeType /*change*/)
 {
-	// we could be tricky here to be efficient;
-	// but this shouldn't happen very often so we'll just always repopulate
 	FileData* cursor = getCursor();
 	if (!cursor->isPlaceHolder()) {
-		populateList(cursor->getParent()->getChildrenListToDisplay());
-		setCursor(cursor);
+		// only what was added, removed, moved or changed is touched, the rest of a big list stays as it is
+		const std::vector<FileData*>& files = cursor->getParent()->getChildrenListToDisplay();
+		if (files.empty())
+		{
+			populateList(files);
+			setCursor(cursor);
+		}
+		else
+		{
+			updateList(files, file);
+			setCursor(getCursor()); // on the entry that took its place if the cursor's is gone
+		}
 	}
 	else
 	{
@@ -140,7 +149,7 @@ bool ISimpleGameListView::input(InputConfig* config, Input input)
 			if (mRoot->getSystem()->isGameSystem())
 			{
 				// go to random system game
-				FileData* randomGame = getCursor()->getSystem()->getRandomGame();
+				FileData* randomGame = getCursor()->getSystem()->getRandomDisplayedGame();
 				if (randomGame)
 				{
 					setCursor(randomGame);
@@ -162,11 +171,19 @@ bool ISimpleGameListView::input(InputConfig* config, Input input)
 	FileData* cursor = getCursor();
 	SystemData* system = this->mRoot->getSystem();
     	if (system != NULL) {
-            Scripting::fireEvent("game-select", system->getName(), cursor->getPath(), cursor->getName(), "input");
+            Scripting::queueEvent("game-select", system->getName(), cursor->getPath(), cursor->getName(), "input");
         }
 	else
 	{
-	    Scripting::fireEvent("game-select", "NULL", "NULL", "NULL", "input");
+	    Scripting::queueEvent("game-select", "NULL", "NULL", "NULL", "input");
 	}
 	return IGameListView::input(config, input);
-}
\ No newline at end of file
+}
+
+void ISimpleGameListView::update(int deltaTime)
+{
+	// the game the cursor rests on is likely to be launched next
+	RomPrefetch::update(getCursor());
+
+	IGameListView::update(deltaTime);
+}
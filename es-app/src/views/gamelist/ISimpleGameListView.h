@@ -28,6 +28,7 @@ public:
 	virtual void setViewportTop(int index) override = 0;
 
 	virtual bool input(InputConfig* config, Input input) override;
+	virtual void update(int deltaTime) override;
 	virtual void launch(FileData* game) override = 0;
 
 protected:
@@ -36,6 +37,8 @@ protected:
 	virtual std::string getQuickSystemSelectRightButton() = 0;
 	virtual std::string getQuickSystemSelectLeftButton() = 0;
 	virtual void populateList(const std::vector<FileData*>& files) = 0;
+	// like populateList(), but only the entries of files that weren't listed and of changed are built
+	virtual void updateList(const std::vector<FileData*>& files, FileData* changed) = 0;
 
 	TextComponent mHeaderText;
 	ImageComponent mHeaderImage;
@@ -1,15 +1,14 @@
 #include "views/gamelist/VideoGameListView.h"
 
 #include "animations/LambdaAnimation.h"
-#ifdef _OMX_
-#include "components/VideoPlayerComponent.h"
-#endif
-#include "components/VideoVlcComponent.h"
+#include "components/VideoComponent.h"
 #include "utils/FileSystemUtil.h"
 #include "views/ViewController.h"
-#ifdef _OMX_
-#include "Settings.h"
-#endif
+#include "VideoBackend.h"
+
+// how long the cursor has to rest on a game before its video is opened, when the theme's own delay is shorter.
+// Opening one parses the file and sets up a decoder, which is wasted on the games passed while tapping through a list
+static const int VIDEO_SETTLE_TIME = 150;
 
 VideoGameListView::VideoGameListView(Window* window, FileData* root) :
 	BasicGameListView(window, root),
@@ -25,20 +24,15 @@ VideoGameListView::VideoGameListView(Window* window, FileData* root) :
 
 	mRating(window), mReleaseDate(window), mDeveloper(window), mPublisher(window),
 	mGenre(window), mPlayers(window), mLastPlayed(window), mPlayCount(window),
-	mName(window)
+	mName(window), mVideoFile(nullptr), mVideoDelay(0)
 {
 	const float padding = 0.01f;
 
 	// Create the correct type of video window
 #ifdef _OMX_
 	Utils::FileSystem::removeFile(getTitlePath());
-	if (Settings::getInstance()->getBool("VideoOmxPlayer"))
-		mVideo = new VideoPlayerComponent(window, "");
-	else
-		mVideo = new VideoVlcComponent(window, getTitlePath());
-#else
-	mVideo = new VideoVlcComponent(window, getTitlePath());
 #endif
+	mVideo = VideoBackend::create(window, getTitlePath(), false);
 
 	mList.setPosition(mSize.x() * (0.50f + padding), mList.getPosition().y());
 	mList.setSize(mSize.x() * (0.50f - padding), mList.getSize().y());
@@ -254,14 +248,28 @@ void VideoGameListView::updateInfoPanel()
 		mVideo->setVideo("");
 		mVideo->setImage("");
 		mVideoPlaying = false;
+		mVideoFile = nullptr;
+		mVideoDelay = 0;
 		//mMarquee.setImage("");
 		//mDescription.setText("");
 		fadingOut = true;
 
 	}else{
-		if (!mVideo->setVideo(file->getVideoPath()))
+		if(file != mVideoFile)
 		{
-			mVideo->setDefaultVideo();
+			// the video of the game left stops right away, the next one waits for the cursor to rest. The theme's
+			// delay already has the video component wait, and a video moved away from during it is never opened
+			mVideoFile = file;
+			mVideoDelay = Math::max(VIDEO_SETTLE_TIME - (int)mVideo->getStartDelay(), 0);
+			if(mVideoDelay > 0)
+				mVideo->setVideo("");
+			else
+				updateVideo();
+		}
+		else if(mVideoDelay == 0)
+		{
+			// the same game again, its video may have just been scraped
+			updateVideo();
 		}
 		mVideoPlaying = true;
 
@@ -270,11 +278,11 @@ void VideoGameListView::updateInfoPanel()
 		mMarquee.setImage(file->getMarqueePath());
 		mImage.setImage(file->getImagePath());
 
-		mDescription.setText(file->metadata.get("desc"));
+		mDescription.setText(file->getDescription());
 		mDescContainer.reset();
 
 		mRating.setValue(file->metadata.get("rating"));
-		mReleaseDate.setValue(file->metadata.get("releasedate"));
+		mReleaseDate.setTime(file->metadata.getTime(MD_ID_RELEASEDATE));
 		mDeveloper.setValue(file->metadata.get("developer"));
 		mPublisher.setValue(file->metadata.get("publisher"));
 		mGenre.setValue(file->metadata.get("genre"));
@@ -283,7 +291,7 @@ void VideoGameListView::updateInfoPanel()
 
 		if(file->getType() == GAME)
 		{
-			mLastPlayed.setValue(file->metadata.get("lastplayed"));
+			mLastPlayed.setTime(file->metadata.getTime(MD_ID_LASTPLAYED));
 			mPlayCount.setValue(file->metadata.get("playcount"));
 		}
 
@@ -387,9 +395,36 @@ std::vector<GuiComponent*> VideoGameListView::getMDValues()
 	return ret;
 }
 
+void VideoGameListView::updateVideo()
+{
+	if(!mVideo->setVideo(mVideoFile->getVideoPath()))
+	{
+		mVideo->setDefaultVideo();
+	}
+
+	// the games next to it are likely played next
+	for(int offset = -1; offset <= 1; offset += 2)
+	{
+		const int index = mList.getCursorIndex() + offset;
+		if((index >= 0) && (index < mList.size()))
+			mVideo->prefetch(mList.getObjectAt(index)->getVideoPath());
+	}
+}
+
 void VideoGameListView::update(int deltaTime)
 {
 	BasicGameListView::update(deltaTime);
+
+	if(mVideoDelay > 0)
+	{
+		mVideoDelay -= deltaTime;
+		if(mVideoDelay <= 0)
+		{
+			mVideoDelay = 0;
+			updateVideo();
+		}
+	}
+
 	mVideo->update(deltaTime);
 }
 
@@ -29,6 +29,7 @@ protected:
 
 private:
 	void updateInfoPanel();
+	void updateVideo();
 
 	void initMDLabels();
 	void initMDValues();
@@ -57,6 +58,8 @@ private:
 	TextComponent mDescription;
 
 	bool		mVideoPlaying;
+	FileData*	mVideoFile; // whose video is playing or waits for the cursor to rest
+	int			mVideoDelay;
 
 };
 
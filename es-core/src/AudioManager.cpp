@@ -9,48 +9,191 @@ std::vector<std::shared_ptr<Sound>> AudioManager::sSoundVector;
 SDL_AudioSpec AudioManager::sAudioFormat;
 std::shared_ptr<AudioManager> AudioManager::sInstance;
 
+AudioManager::Command AudioManager::sCommands[MAX_COMMANDS];
+std::atomic<unsigned int> AudioManager::sCommandHead(0);
+std::atomic<unsigned int> AudioManager::sCommandTail(0);
+AudioManager::Voice AudioManager::sVoices[MAX_VOICES];
+unsigned int AudioManager::sVoiceCount = 0;
+AudioManager::MusicChannel AudioManager::sMusic[2];
+int AudioManager::sMusicChannel = -1;
+
+//time a crossfade between two music streams takes
+#define MUSIC_FADE_MS 1000.0f
 
 void AudioManager::mixAudio(void* /*unused*/, Uint8 *stream, int len)
 {
-	bool stillPlaying = false;
-
 	//initialize the buffer to "silence"
 	SDL_memset(stream, 0, len);
 
-	//iterate through all our samples
-	std::vector<std::shared_ptr<Sound>>::const_iterator soundIt = sSoundVector.cbegin();
-	while (soundIt != sSoundVector.cend())
+	//pick up what the UI thread asked for since the last buffer
+	processCommands();
+
+	//iterate through all our voices, the ones that end are replaced by the last one
+	unsigned int i = 0;
+	while (i < sVoiceCount)
 	{
-		std::shared_ptr<Sound> sound = *soundIt;
-		if(sound->isPlaying())
+		Voice& voice = sVoices[i];
+
+		//calculate rest length of current sample
+		Uint32 restLength = voice.length - voice.position;
+		if (restLength > (Uint32)len) {
+			//if stream length is smaller than sample length, clip it
+			restLength = len;
+		}
+		//mix sample into stream
+		SDL_MixAudio(stream, &voice.data[voice.position], restLength, SDL_MIX_MAXVOLUME);
+		voice.position += restLength;
+
+		if (voice.position >= voice.length)
 		{
-			//calculate rest length of current sample
-			Uint32 restLength = (sound->getLength() - sound->getPosition());
-			if (restLength > (Uint32)len) {
-				//if stream length is smaller than smaple lenght, clip it
-				restLength = len;
-			}
-			//mix sample into stream
-			SDL_MixAudio(stream, &(sound->getData()[sound->getPosition()]), restLength, SDL_MIX_MAXVOLUME);
-			if (sound->getPosition() + restLength < sound->getLength())
-			{
-				//sample hasn't ended yet
-				stillPlaying = true;
-			}
-			//set new sound position. if this is at or beyond the end of the sample, it will stop automatically
-			sound->setPosition(sound->getPosition() + restLength);
+			//sample has ended
+			voice.sound->mPlaying = false;
+			removeVoice(i);
 		}
-		//advance to next sound
-		++soundIt;
+		else
+			++i;
 	}
 
+	mixMusic(stream, len);
+
 	//we have processed all samples. check if some will still be playing
-	if (!stillPlaying) {
+	if ((sVoiceCount == 0) && !sMusic[0].active && !sMusic[1].active && (sCommandHead.load(std::memory_order_acquire) == sCommandTail.load(std::memory_order_relaxed))) {
 		//no. pause audio till a Sound::play() wakes us up
 		SDL_PauseAudio(1);
 	}
 }
 
+bool AudioManager::pushCommand(const Command& command)
+{
+	const unsigned int head = sCommandHead.load(std::memory_order_relaxed);
+	const unsigned int next = (head + 1) % MAX_COMMANDS;
+
+	//the mixer is behind by a whole queue, which only happens while the device isn't running. drop it
+	if (next == sCommandTail.load(std::memory_order_acquire))
+		return false;
+
+	sCommands[head] = command;
+	sCommandHead.store(next, std::memory_order_release);
+	return true;
+}
+
+void AudioManager::processCommands()
+{
+	const unsigned int head = sCommandHead.load(std::memory_order_acquire);
+	unsigned int       tail = sCommandTail.load(std::memory_order_relaxed);
+
+	while (tail != head)
+	{
+		const Command& command = sCommands[tail];
+
+		switch (command.type)
+		{
+			case Command::PLAY:
+			{
+				command.sound->mPlaying = true;
+
+				//already playing, replay from start. rewind the voice to the beginning
+				unsigned int i = 0;
+				while ((i < sVoiceCount) && (sVoices[i].sound != command.sound))
+					++i;
+
+				if (i < sVoiceCount)
+					sVoices[i].position = 0;
+				else if (sVoiceCount < MAX_VOICES)
+					sVoices[sVoiceCount++] = { command.sound, command.data, command.length, 0 };
+				else
+					command.sound->mPlaying = false;
+			}
+			break;
+
+			case Command::STOP:
+			{
+				for (unsigned int i = 0; i < sVoiceCount; ++i)
+				{
+					if (sVoices[i].sound == command.sound)
+					{
+						removeVoice(i);
+						break;
+					}
+				}
+			}
+			break;
+
+			case Command::STOP_ALL:
+			{
+				sVoiceCount = 0;
+			}
+			break;
+
+			case Command::MUSIC:
+			{
+				for (int i = 0; i < 2; ++i)
+				{
+					if (i == command.channel)
+					{
+						sMusic[i].active = true;
+						sMusic[i].gain   = 0.0f;
+						sMusic[i].fade   = 1;
+					}
+					else if (sMusic[i].active)
+						sMusic[i].fade = -1;
+				}
+			}
+			break;
+		}
+
+		tail = (tail + 1) % MAX_COMMANDS;
+	}
+
+	sCommandTail.store(tail, std::memory_order_release);
+}
+
+void AudioManager::removeVoice(unsigned int index)
+{
+	sVoices[index] = sVoices[--sVoiceCount];
+}
+
+void AudioManager::mixMusic(Uint8 *stream, int len)
+{
+	//the gain changes once per buffer, small enough steps with the buffer sizes allowed
+	const float step = ((len / 4) * 1000.0f / 44100.0f) / MUSIC_FADE_MS;
+
+	for (int i = 0; i < 2; ++i)
+	{
+		MusicChannel& music = sMusic[i];
+
+		if (!music.active)
+			continue;
+
+		music.stream.mix(stream, (Uint32)len, (int)(music.gain * SDL_MIX_MAXVOLUME));
+		music.gain += music.fade * step;
+
+		if (music.gain >= 1.0f)
+		{
+			music.gain = 1.0f;
+			music.fade = 0;
+		}
+		else if (music.gain <= 0.0f)
+		{
+			//faded out, VLC keeps decoding into the full ring until the channel is used again
+			music.active = false;
+		}
+	}
+}
+
+void AudioManager::stopMusic()
+{
+	SDL_LockAudio();
+	processCommands();
+	sMusic[0].active = false;
+	sMusic[1].active = false;
+	SDL_UnlockAudio();
+
+	sMusic[0].stream.close();
+	sMusic[1].stream.close();
+	sMusicChannel = -1;
+}
+
 AudioManager::AudioManager()
 {
 	init();
@@ -79,19 +222,18 @@ void AudioManager::init()
 	}
 
 	//stop playing all Sounds
-	for(unsigned int i = 0; i < sSoundVector.size(); i++)
-	{
-		if(sSoundVector.at(i)->isPlaying())
-		{
-			sSoundVector[i]->stop();
-		}
-	}
+	stop();
+
+	//the buffer is what a sound lags behind the input, keep it a power of two SDL is happy with
+	int samples = 256;
+	while ((samples < 8192) && (samples < Settings::getInstance()->getInt("AudioBufferSize")))
+		samples *= 2;
 
 	//Set up format and callback. Play 16-bit stereo audio at 44.1Khz
 	sAudioFormat.freq = 44100;
 	sAudioFormat.format = AUDIO_S16;
 	sAudioFormat.channels = 2;
-	sAudioFormat.samples = 4096;
+	sAudioFormat.samples = (Uint16)samples;
 	sAudioFormat.callback = mixAudio;
 	sAudioFormat.userdata = NULL;
 
@@ -142,14 +284,76 @@ void AudioManager::play()
 
 void AudioManager::stop()
 {
-	//stop playing all Sounds
+	//stop playing all Sounds. the mixer may be paused already, so its voices are dropped right here
+	SDL_LockAudio();
+	processCommands();
+	sVoiceCount = 0;
+	SDL_UnlockAudio();
+
 	for(unsigned int i = 0; i < sSoundVector.size(); i++)
+		sSoundVector[i]->mPlaying = false;
+
+	stopMusic();
+
+	//pause audio
+	SDL_PauseAudio(1);
+}
+
+void AudioManager::playSound(Sound* sound)
+{
+	Command command = { Command::PLAY, sound, sound->getData(), sound->getLength(), -1 };
+
+	if(!pushCommand(command))
+		sound->mPlaying = false;
+
+	//unpause audio, the mixer will figure out if samples need to be played...
+	SDL_PauseAudio(0);
+}
+
+void AudioManager::stopSound(Sound* sound)
+{
+	Command command = { Command::STOP, sound, NULL, 0, -1 };
+	pushCommand(command);
+}
+
+void AudioManager::removeSound(Sound* sound)
+{
+	//with the device locked the mixer can't run, so this thread may catch up on the queue itself
+	SDL_LockAudio();
+	processCommands();
+
+	for(unsigned int i = 0; i < sVoiceCount; ++i)
 	{
-		if(sSoundVector.at(i)->isPlaying())
+		if(sVoices[i].sound == sound)
 		{
-			sSoundVector[i]->stop();
+			removeVoice(i);
+			break;
 		}
 	}
-	//pause audio
-	SDL_PauseAudio(1);
+
+	SDL_UnlockAudio();
+}
+
+void AudioManager::playMusic(const std::string& path)
+{
+	const std::string& playing = (sMusicChannel != -1) ? sMusic[sMusicChannel].stream.getPath() : "";
+
+	if(path == playing)
+		return;
+
+	//the other channel is free, or still fading out from the switch before and cut short
+	const int channel = (sMusicChannel == 0) ? 1 : 0;
+
+	SDL_LockAudio();
+	processCommands();
+	sMusic[channel].active = false;
+	SDL_UnlockAudio();
+
+	sMusicChannel = sMusic[channel].stream.open(path) ? channel : -1;
+
+	Command command = { Command::MUSIC, NULL, NULL, 0, sMusicChannel };
+	pushCommand(command);
+
+	//unpause audio, the mixer will figure out if samples need to be played...
+	SDL_PauseAudio(0);
 }
@@ -2,20 +2,70 @@
 #ifndef ES_CORE_AUDIO_MANAGER_H
 #define ES_CORE_AUDIO_MANAGER_H
 
+#include "MusicStream.h"
 #include <SDL_audio.h>
+#include <atomic>
 #include <memory>
+#include <string>
 #include <vector>
 
 class Sound;
 
 class AudioManager
 {
+	// what the UI thread asks the mixer to do, passed through a lock free queue
+	struct Command
+	{
+		enum Type { PLAY, STOP, STOP_ALL, MUSIC };
+
+		Type         type;
+		Sound*       sound;
+		const Uint8* data;
+		Uint32       length;
+		int          channel; // MUSIC only, the music channel fading in or -1 to fade all of them out
+	};
+
+	// a sound being mixed, only ever touched by the mixer or with the audio device locked
+	struct Voice
+	{
+		Sound*       sound;
+		const Uint8* data;
+		Uint32       length;
+		Uint32       position;
+	};
+
+	// a music stream with the crossfade state, gain and fade only ever touched by the mixer or with the device locked
+	struct MusicChannel
+	{
+		MusicStream stream;
+		float       gain;
+		int         fade; // 1 fading in, -1 fading out
+		bool        active;
+	};
+
+	static const unsigned int MAX_COMMANDS = 64;
+	static const unsigned int MAX_VOICES   = 16;
+
 	static SDL_AudioSpec sAudioFormat;
 	static std::vector<std::shared_ptr<Sound>> sSoundVector;
 	static std::shared_ptr<AudioManager> sInstance;
 
+	static Command                   sCommands[MAX_COMMANDS];
+	static std::atomic<unsigned int> sCommandHead; // written by the UI thread
+	static std::atomic<unsigned int> sCommandTail; // written by the mixer
+	static Voice                     sVoices[MAX_VOICES];
+	static unsigned int              sVoiceCount;
+	static MusicChannel              sMusic[2];
+	static int                       sMusicChannel; // UI thread, the channel playing or fading in
+
 	static void mixAudio(void *unused, Uint8 *stream, int len);
 
+	static bool pushCommand(const Command& command);
+	static void processCommands();
+	static void removeVoice(unsigned int index);
+	static void mixMusic(Uint8 *stream, int len);
+	static void stopMusic();
+
 	AudioManager();
 
 public:
@@ -30,6 +80,16 @@ public:
 	void play();
 	void stop();
 
+	// Called by Sound, from the UI thread only
+	void playSound(Sound* sound);
+	static void stopSound(Sound* sound);
+	// Stops the sound and waits for the mixer to let go of its data, so it can be freed
+	static void removeSound(Sound* sound);
+
+	// Crossfades from the music playing to the one in path, which loops until other music is played. An empty
+	// path fades out the music
+	void playMusic(const std::string& path);
+
 	virtual ~AudioManager();
 };
 
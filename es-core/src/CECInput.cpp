@@ -51,6 +51,12 @@ static void onLogMessage(void* /*cbParam*/, const CEC::cec_log_message* message)
 
 } // onLogMessage
 
+// the adapter may keep the callbacks, they have to outlive the function opening it
+static CEC::ICECCallbacks sCallbacks;
+
+// longest the TV gets to answer when the adapter is opened
+#define OPEN_TIMEOUT_MS 5000
+
 #ifdef _RPI_
 static void vchi_tv_and_cec_init()
 {
@@ -75,8 +81,14 @@ static void vchi_tv_and_cec_deinit()
 void CECInput::init()
 {
 	if(!sInstance)
+	{
 		sInstance = new CECInput();
 
+#ifdef HAVE_LIBCEC
+		sInstance->mThread = std::thread(&CECInput::open, sInstance);
+#endif // HAVE_LIBCEC
+	}
+
 } // init
 
 void CECInput::deinit()
@@ -91,6 +103,10 @@ void CECInput::deinit()
 
 CECInput::CECInput() : mlibCEC(nullptr)
 {
+} // CECInput
+
+void CECInput::open()
+{
 
 #ifdef HAVE_LIBCEC
 #ifdef _RPI_
@@ -99,20 +115,19 @@ CECInput::CECInput() : mlibCEC(nullptr)
 	vchi_tv_and_cec_init();
 #endif // _RPI_
 
-	CEC::ICECCallbacks        callbacks;
 	CEC::libcec_configuration config;
-	callbacks.Clear();
+	sCallbacks.Clear();
 	config.Clear();
 
-	callbacks.alert           = &onAlert;
-	callbacks.commandReceived = &onCommand;
-	callbacks.keyPress        = &onKeyPress;
-	callbacks.logMessage      = &onLogMessage;
+	sCallbacks.alert           = &onAlert;
+	sCallbacks.commandReceived = &onCommand;
+	sCallbacks.keyPress        = &onKeyPress;
+	sCallbacks.logMessage      = &onLogMessage;
 
 	sprintf(config.strDeviceName, "RetroPie ES");
 	config.clientVersion   = CEC::LIBCEC_VERSION_CURRENT;
 	config.bActivateSource = 0;
-	config.callbacks       = &callbacks;
+	config.callbacks       = &sCallbacks;
 	config.deviceTypes.Add(CEC::CEC_DEVICE_TYPE_PLAYBACK_DEVICE);
 
 	mlibCEC = LibCecInitialise(&config);
@@ -137,19 +152,24 @@ CECInput::CECInput() : mlibCEC(nullptr)
 	for(int i = 0; i < numAdapters; ++i)
 		LOG(LogDebug) << "CEC adapter: " << i << " path: " << adapters[i].strComPath << " name: " << adapters[i].strComName;
 
-	if(!mlibCEC->Open(adapters[0].strComName))
+	if(!mlibCEC->Open(adapters[0].strComName, OPEN_TIMEOUT_MS))
 	{
 		LOG(LogError) << "CECInput::mAdapter->Open failed";
 		UnloadLibCec(mlibCEC);
 		mlibCEC = nullptr;
 		return;
 	}
+
+	LOG(LogInfo) << "CEC adapter " << adapters[0].strComName << " ready";
 #endif // HAVE_LIBCEC
 
-} // CECInput
+} // open
 
 CECInput::~CECInput()
 {
+	// the adapter can't be closed halfway through opening it, at worst this waits for OPEN_TIMEOUT_MS
+	if(mThread.joinable())
+		mThread.join();
 
 #ifdef HAVE_LIBCEC
 	if(mlibCEC)
@@ -3,6 +3,7 @@
 #define ES_CORE_CECINPUT_H
 
 #include <string>
+#include <thread>
 
 namespace CEC { class ICECAdapter; }
 
@@ -21,9 +22,14 @@ private:
 	 CECInput();
 	~CECInput();
 
+	// Finds and opens the adapter, which can take seconds without one or with a slow TV, so it runs on mThread
+	// and the keys work as soon as it is done
+	void open();
+
 	static CECInput*  sInstance;
 
 	CEC::ICECAdapter* mlibCEC;
+	std::thread       mThread;
 
 }; // CECInput
 
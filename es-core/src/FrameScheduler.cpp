@@ -0,0 +1,161 @@
+#include "FrameScheduler.h"
+
+#include "animations/AnimationScheduler.h"
+#include "renderers/Renderer.h"
+#include "Settings.h"
+#include <SDL_timer.h>
+#include <SDL_video.h>
+
+// unchanged frames in a row before the screen counts as idle, and the longest wait once it is
+#define IDLE_FRAMES   30
+#define IDLE_INTERVAL 100.0
+
+std::atomic<Uint32> FrameScheduler::sWakeUpEvent((Uint32)-1);
+std::atomic<bool>   FrameScheduler::sWakeUpPending(false);
+double              FrameScheduler::sFrameInterval     = 0.0;
+double              FrameScheduler::sRefreshInterval   = 1000.0 / 60.0;
+double              FrameScheduler::sFrameStart        = 0.0;
+double              FrameScheduler::sPresentedInterval = 0.0;
+double              FrameScheduler::sRequestedTime     = 0.0;
+bool                FrameScheduler::sVSync             = false;
+bool                FrameScheduler::sPolled            = false;
+int                 FrameScheduler::sSkippedFrames     = 0;
+
+void FrameScheduler::init()
+{
+	if(sWakeUpEvent == (Uint32)-1)
+		sWakeUpEvent = SDL_RegisterEvents(1);
+
+	SDL_DisplayMode mode;
+	int             refreshRate = 60;
+
+	if(Renderer::getSDLWindow() && (SDL_GetWindowDisplayMode(Renderer::getSDLWindow(), &mode) == 0) && (mode.refresh_rate > 0))
+		refreshRate = mode.refresh_rate;
+
+	const int maxFPS = Settings::getInstance()->getInt("MaxFPS");
+
+	sFrameInterval     = (maxFPS > 0) ? (1000.0 / maxFPS) : 0.0;
+	sRefreshInterval   = 1000.0 / refreshRate;
+	sVSync             = Settings::getInstance()->getBool("VSync") && (SDL_GL_GetSwapInterval() != 0);
+	sPresentedInterval = sRefreshInterval; // trust vsync to block until the frame times say otherwise
+	sFrameStart        = getTime();
+	sRequestedTime     = 0.0;
+	sPolled            = false;
+	sSkippedFrames     = 0;
+
+} // init
+
+void FrameScheduler::wakeUp()
+{
+	const Uint32 type = sWakeUpEvent;
+
+	// one pending event is enough to end the wait, the loader threads would flood the queue otherwise
+	if((type == (Uint32)-1) || sWakeUpPending.exchange(true))
+		return;
+
+	SDL_Event event;
+	SDL_zero(event);
+	event.type = type;
+	SDL_PushEvent(&event);
+
+} // wakeUp
+
+bool FrameScheduler::isWakeUpEvent(const SDL_Event& _event)
+{
+	if(_event.type != sWakeUpEvent)
+		return false;
+
+	sWakeUpPending = false;
+	return true;
+
+} // isWakeUpEvent
+
+void FrameScheduler::requestFrame(const int _delay)
+{
+	const double time = getTime() + _delay;
+
+	if((sRequestedTime == 0.0) || (time < sRequestedTime))
+		sRequestedTime = time;
+
+} // requestFrame
+
+int FrameScheduler::getTimeout()
+{
+	const double now = getTime();
+	const double base = (sFrameInterval > 0.0) ? sFrameInterval : sRefreshInterval;
+	double       wait;
+
+	sPolled = false;
+
+	// an animation waiting for its delay leaves the frames unchanged, it still has to start on time
+	if((sSkippedFrames > IDLE_FRAMES) && !AnimationScheduler::isAnimating())
+	{
+		// nothing moved for a while, check back less and less often
+		const double interval = base * (sSkippedFrames - IDLE_FRAMES + 1);
+		wait = sFrameStart + ((interval < IDLE_INTERVAL) ? interval : IDLE_INTERVAL) - now;
+	}
+	else if(sSkippedFrames > 0)
+	{
+		// a skipped frame didn't wait for vsync, it has to be paced even without a frame limit
+		wait = sFrameStart + base - now;
+	}
+	else if(sVSync && (sPresentedInterval > (sRefreshInterval * 0.75)))
+	{
+		// swapping already waited for the display, waiting any longer would miss the next refresh
+		if(sFrameInterval <= sRefreshInterval)
+		{
+			sPolled = true;
+			wait    = 0.0;
+		}
+		else
+			wait = sFrameStart + sFrameInterval - (sRefreshInterval * 0.5) - now;
+	}
+	else
+		wait = sFrameStart + sFrameInterval - now;
+
+	if((sRequestedTime != 0.0) && ((sRequestedTime - now) < wait))
+		wait = sRequestedTime - now;
+
+	return (wait > 0.0) ? (int)wait : 0;
+
+} // getTimeout
+
+void FrameScheduler::frameDone(const bool _presented)
+{
+	const double now = getTime();
+
+	// only frames that went straight from one swap to the next tell whether the swap blocks
+	if(_presented && sPolled && (sSkippedFrames == 0))
+		sPresentedInterval = (sPresentedInterval * 0.9) + ((now - sFrameStart) * 0.1);
+
+	if(_presented)
+		sSkippedFrames = 0;
+	else if(sSkippedFrames < (IDLE_FRAMES * 1000))
+		++sSkippedFrames;
+
+	if((sRequestedTime != 0.0) && (now >= sRequestedTime))
+		sRequestedTime = 0.0;
+
+	sFrameStart = now;
+
+} // frameDone
+
+bool FrameScheduler::isIdle()
+{
+	return (sSkippedFrames > IDLE_FRAMES) && !AnimationScheduler::isAnimating();
+
+} // isIdle
+
+int FrameScheduler::getFrameInterval()
+{
+	const double interval = (sFrameInterval > 0.0) ? sFrameInterval : sRefreshInterval;
+
+	return (int)interval + 1;
+
+} // getFrameInterval
+
+double FrameScheduler::getTime()
+{
+	return (SDL_GetPerformanceCounter() * 1000.0) / SDL_GetPerformanceFrequency();
+
+} // getTime
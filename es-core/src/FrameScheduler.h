@@ -0,0 +1,54 @@
+#pragma once
+#ifndef ES_CORE_FRAME_SCHEDULER_H
+#define ES_CORE_FRAME_SCHEDULER_H
+
+#include <SDL_events.h>
+#include <atomic>
+
+// Decides how long the main loop may wait for events before it has to draw the next frame.
+// Frames are paced to the "MaxFPS" setting while something changes on screen, vsync does the pacing when it
+// actually blocks. Once frames stop changing the wait grows, so an idle screen uses next to no CPU.
+// Input, textures finished loading on another thread and requested deadlines end a wait early.
+class FrameScheduler
+{
+public:
+
+	// Reloads the settings and the display refresh rate, needs the renderer to be initialized
+	static void init();
+
+	// Ends the wait of the main loop, can be called from any thread
+	static void wakeUp();
+	// True when _event was pushed by wakeUp(), such events carry no input
+	static bool isWakeUpEvent(const SDL_Event& _event);
+
+	// Makes sure a frame gets updated within _delay ms, for animations or timers starting later on
+	static void requestFrame(const int _delay);
+
+	// Time in ms the main loop may wait for events before starting the next frame, 0 to only poll them
+	static int getTimeout();
+	// Called once the frame was finished, _presented is false when the frame was skipped
+	static void frameDone(const bool _presented);
+
+	// True while nothing changed on screen for a while
+	static bool isIdle();
+	// Time a frame is supposed to take, in ms
+	static int getFrameInterval();
+
+private:
+
+	static double getTime();
+
+	static std::atomic<Uint32> sWakeUpEvent;
+	static std::atomic<bool>   sWakeUpPending;
+	static double              sFrameInterval;
+	static double              sRefreshInterval;
+	static double              sFrameStart;
+	static double              sPresentedInterval;
+	static double              sRequestedTime;
+	static bool                sVSync;
+	static bool                sPolled;
+	static int                 sSkippedFrames;
+
+}; // FrameScheduler
+
+#endif // ES_CORE_FRAME_SCHEDULER_H
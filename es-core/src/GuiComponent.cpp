@@ -2,6 +2,7 @@
 
 #include "animations/Animation.h"
 #include "animations/AnimationController.h"
+#include "animations/AnimationScheduler.h"
 #include "renderers/Renderer.h"
 #include "Log.h"
 #include "ThemeData.h"
@@ -10,7 +11,8 @@
 
 GuiComponent::GuiComponent(Window* window) : mWindow(window), mParent(NULL), mOpacity(255),
 	mPosition(Vector3f::Zero()), mOrigin(Vector2f::Zero()), mRotationOrigin(0.5, 0.5),
-	mSize(Vector2f::Zero()), mTransform(Transform4x4f::Identity()), mIsProcessing(false), mVisible(true)
+	mSize(Vector2f::Zero()), mTransform(Transform4x4f::Identity()), mIsProcessing(false), mVisible(true),
+	mTransformValid(false)
 {
 	for(unsigned char i = 0; i < MAX_ANIMATIONS; i++)
 		mAnimationMap[i] = NULL;
@@ -42,8 +44,10 @@ bool GuiComponent::input(InputConfig* config, Input input)
 
 void GuiComponent::updateSelf(int deltaTime)
 {
+	const int step = AnimationScheduler::getStep(deltaTime);
+
 	for(unsigned char i = 0; i < MAX_ANIMATIONS; i++)
-		advanceAnimation(i, deltaTime);
+		advanceAnimation(i, step);
 }
 
 void GuiComponent::updateChildren(int deltaTime)
@@ -256,6 +260,19 @@ void GuiComponent::setOpacity(unsigned char opacity)
 
 const Transform4x4f& GuiComponent::getTransform()
 {
+	// most components don't move between frames, the members are set directly all over the subclasses so instead of
+	// a dirty flag the values the transform was built from are compared. Rotated ones are always built again, their
+	// rotation size comes from a virtual
+	if(mTransformValid && mRotation == 0.0 && mScale == mTransformScale && mPosition == mTransformPosition &&
+		mOrigin == mTransformOrigin && mSize == mTransformSize)
+		return mTransform;
+
+	mTransformPosition = mPosition;
+	mTransformOrigin = mOrigin;
+	mTransformSize = mSize;
+	mTransformScale = mScale;
+	mTransformValid = (mRotation == 0.0);
+
 	mTransform = Transform4x4f::Identity();
 	mTransform.translate(mPosition);
 	if (mScale != 1.0)
@@ -284,6 +301,28 @@ const Transform4x4f& GuiComponent::getTransform()
 	return mTransform;
 }
 
+bool GuiComponent::isOnScreen(const Transform4x4f& parentTrans)
+{
+	if(mSize.x() == 0 || mSize.y() == 0)
+		return true;
+
+	const Transform4x4f trans = parentTrans * getTransform();
+	const Vector3f corners[4] = { trans * Vector3f(0, 0, 0), trans * Vector3f(mSize.x(), 0, 0),
+	                              trans * Vector3f(0, mSize.y(), 0), trans * Vector3f(mSize.x(), mSize.y(), 0) };
+
+	Vector2f boundsMin(corners[0].x(), corners[0].y());
+	Vector2f boundsMax(boundsMin);
+
+	for(int i = 1; i < 4; i++)
+	{
+		boundsMin = Vector2f(Math::min(boundsMin.x(), corners[i].x()), Math::min(boundsMin.y(), corners[i].y()));
+		boundsMax = Vector2f(Math::max(boundsMax.x(), corners[i].x()), Math::max(boundsMax.y(), corners[i].y()));
+	}
+
+	return boundsMax.x() >= 0 && boundsMax.y() >= 0 &&
+		boundsMin.x() <= Renderer::getScreenWidth() && boundsMin.y() <= Renderer::getScreenHeight();
+}
+
 void GuiComponent::setValue(const std::string& /*value*/)
 {
 }
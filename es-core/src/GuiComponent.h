@@ -109,6 +109,10 @@ public:
 
 	const Transform4x4f& getTransform();
 
+	// True if the screen-space bounds of this component, under parentTrans, touch the screen. Components without a
+	// size can draw anywhere, those are always on screen
+	bool isOnScreen(const Transform4x4f& parentTrans);
+
 	virtual std::string getValue() const;
 	virtual void setValue(const std::string& value);
 
@@ -167,6 +171,13 @@ public:
 
 private:
 	Transform4x4f mTransform; //Don't access this directly! Use getTransform()!
+
+	// what mTransform was last built from, it's only built again when one of them changed
+	Vector3f mTransformPosition;
+	Vector2f mTransformOrigin;
+	Vector2f mTransformSize;
+	float mTransformScale;
+	bool mTransformValid;
 	AnimationController* mAnimationMap[MAX_ANIMATIONS];
 };
 
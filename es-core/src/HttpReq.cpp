@@ -1,12 +1,72 @@
 #include "HttpReq.h"
 
 #include "utils/FileSystemUtil.h"
+#include "utils/StringUtil.h"
 #include "Log.h"
 #include <assert.h>
 
-CURLM* HttpReq::s_multi_handle = curl_multi_init();
+// more idle handles than requests run at once would only hold memory
+#define MAX_FREE_HANDLES 16
+
+CURLM* HttpReq::s_multi_handle = HttpReq::initMulti();
+CURLSH* HttpReq::s_share_handle = HttpReq::initShare();
 
 std::map<CURL*, HttpReq*> HttpReq::s_requests;
+std::vector<CURL*> HttpReq::s_free_handles;
+
+CURLM* HttpReq::initMulti()
+{
+	CURLM* multi = curl_multi_init();
+
+	if(multi == NULL)
+		return NULL;
+
+	// requests to the same host go over one HTTP/2 connection where the server speaks it
+#if CURL_AT_LEAST_VERSION(7,47,0)
+	curl_multi_setopt(multi, CURLMOPT_PIPELINING, CURLPIPE_MULTIPLEX);
+#endif
+
+	// keep a few connections per host open, enough for the searches and image downloads running at once
+	curl_multi_setopt(multi, CURLMOPT_MAX_HOST_CONNECTIONS, 4L);
+	curl_multi_setopt(multi, CURLMOPT_MAXCONNECTS, 16L);
+
+	return multi;
+}
+
+CURLSH* HttpReq::initShare()
+{
+	CURLSH* share = curl_share_init();
+
+	if(share == NULL)
+		return NULL;
+
+	// every request is made from the same thread, so the share needs no locking
+	curl_share_setopt(share, CURLSHOPT_SHARE, CURL_LOCK_DATA_DNS);
+	curl_share_setopt(share, CURLSHOPT_SHARE, CURL_LOCK_DATA_SSL_SESSION);
+
+	return share;
+}
+
+CURL* HttpReq::takeHandle()
+{
+	if(s_free_handles.empty())
+		return curl_easy_init();
+
+	// a reset handle forgets its options, but keeps its share and the connections it made
+	CURL* handle = s_free_handles.back();
+	s_free_handles.pop_back();
+	curl_easy_reset(handle);
+
+	return handle;
+}
+
+void HttpReq::returnHandle(CURL* handle)
+{
+	if(s_free_handles.size() < MAX_FREE_HANDLES)
+		s_free_handles.push_back(handle);
+	else
+		curl_easy_cleanup(handle);
+}
 
 std::string HttpReq::urlEncode(const std::string &s)
 {
@@ -38,9 +98,38 @@ bool HttpReq::isUrl(const std::string& str)
 }
 
 HttpReq::HttpReq(const std::string& url)
-	: mStatus(REQ_IN_PROGRESS), mHandle(NULL)
+	: mStatus(REQ_IN_PROGRESS), mHandle(NULL), mFile(NULL), mReserved(false), mRequestHeaders(NULL)
 {
-	mHandle = curl_easy_init();
+	init(url);
+}
+
+HttpReq::HttpReq(const std::string& url, const std::vector<std::string>& headers)
+	: mStatus(REQ_IN_PROGRESS), mHandle(NULL), mFile(NULL), mReserved(false), mRequestHeaders(NULL)
+{
+	for(auto it = headers.cbegin(); it != headers.cend(); it++)
+		mRequestHeaders = curl_slist_append(mRequestHeaders, it->c_str());
+
+	init(url);
+}
+
+HttpReq::HttpReq(const std::string& url, const std::string& savePath)
+	: mStatus(REQ_IN_PROGRESS), mHandle(NULL), mSavePath(savePath), mFile(NULL), mReserved(false), mRequestHeaders(NULL)
+{
+	mFile = fopen((mSavePath + ".part").c_str(), "wb");
+
+	if(mFile == NULL)
+	{
+		mStatus = REQ_IO_ERROR;
+		onError("Failed to open file to write. Permission error? Disk full?");
+		return;
+	}
+
+	init(url);
+}
+
+void HttpReq::init(const std::string& url)
+{
+	mHandle = takeHandle();
 
 	if(mHandle == NULL)
 	{
@@ -91,6 +180,58 @@ HttpReq::HttpReq(const std::string& url)
 		return;
 	}
 
+	//share the dns and tls session caches with the other requests
+	if(s_share_handle)
+	{
+		err = curl_easy_setopt(mHandle, CURLOPT_SHARE, s_share_handle);
+		if(err != CURLE_OK)
+		{
+			mStatus = REQ_IO_ERROR;
+			onError(curl_easy_strerror(err));
+			return;
+		}
+	}
+
+	//prefer waiting for a connection that can be multiplexed over opening another one, and ask for http/2 over tls
+#if CURL_AT_LEAST_VERSION(7,47,0)
+	curl_easy_setopt(mHandle, CURLOPT_PIPEWAIT, 1L);
+	curl_easy_setopt(mHandle, CURLOPT_HTTP_VERSION, (long)CURL_HTTP_VERSION_2TLS);
+#endif
+
+	//let the server compress the json and xml replies, an empty string accepts whatever curl supports
+	curl_easy_setopt(mHandle, CURLOPT_ACCEPT_ENCODING, "");
+
+	//keep idle connections alive between scraper requests
+	curl_easy_setopt(mHandle, CURLOPT_TCP_KEEPALIVE, 1L);
+
+	//an error page is no use as a file
+	if(mFile)
+	{
+		err = curl_easy_setopt(mHandle, CURLOPT_FAILONERROR, 1L);
+		if(err != CURLE_OK)
+		{
+			mStatus = REQ_IO_ERROR;
+			onError(curl_easy_strerror(err));
+			return;
+		}
+	}
+
+	//send the extra headers, curl only keeps a pointer to the list
+	if(mRequestHeaders)
+	{
+		err = curl_easy_setopt(mHandle, CURLOPT_HTTPHEADER, mRequestHeaders);
+		if(err != CURLE_OK)
+		{
+			mStatus = REQ_IO_ERROR;
+			onError(curl_easy_strerror(err));
+			return;
+		}
+	}
+
+	//collect the response headers
+	curl_easy_setopt(mHandle, CURLOPT_HEADERFUNCTION, &HttpReq::write_header);
+	curl_easy_setopt(mHandle, CURLOPT_HEADERDATA, this);
+
 	//tell curl how to write the data
 	err = curl_easy_setopt(mHandle, CURLOPT_WRITEFUNCTION, &HttpReq::write_content);
 	if(err != CURLE_OK)
@@ -123,6 +264,10 @@ HttpReq::HttpReq(const std::string& url)
 
 HttpReq::~HttpReq()
 {
+	// a transfer that never finished leaves nothing behind
+	if(mFile)
+		finishFile(false);
+
 	if(mHandle)
 	{
 		s_requests.erase(mHandle);
@@ -130,10 +275,16 @@ HttpReq::~HttpReq()
 		CURLMcode merr = curl_multi_remove_handle(s_multi_handle, mHandle);
 
 		if(merr != CURLM_OK)
+		{
 			LOG(LogError) << "Error removing curl_easy handle from curl_multi: " << curl_multi_strerror(merr);
-
-		curl_easy_cleanup(mHandle);
+			curl_easy_cleanup(mHandle);
+		}
+		else
+			returnHandle(mHandle);
 	}
+
+	if(mRequestHeaders)
+		curl_slist_free_all(mRequestHeaders);
 }
 
 HttpReq::Status HttpReq::status()
@@ -165,8 +316,15 @@ HttpReq::Status HttpReq::status()
 
 				if(msg->data.result == CURLE_OK)
 				{
-					req->mStatus = REQ_SUCCESS;
+					if(req->finishFile(true))
+						req->mStatus = REQ_SUCCESS;
+					else
+					{
+						req->mStatus = REQ_IO_ERROR;
+						req->onError("Failed to save file. Disk full?");
+					}
 				}else{
+					req->finishFile(false);
 					req->mStatus = REQ_IO_ERROR;
 					req->onError(curl_easy_strerror(msg->data.result));
 				}
@@ -177,10 +335,63 @@ HttpReq::Status HttpReq::status()
 	return mStatus;
 }
 
-std::string HttpReq::getContent() const
+const std::string& HttpReq::getContent() const
+{
+	assert(mStatus == REQ_SUCCESS);
+	return mContent;
+}
+
+std::string HttpReq::takeContent()
+{
+	assert(mStatus == REQ_SUCCESS);
+
+	std::string content;
+	content.swap(mContent);
+	return content;
+}
+
+long HttpReq::getResponseCode() const
 {
 	assert(mStatus == REQ_SUCCESS);
-	return mContent.str();
+
+	long code = 0;
+	curl_easy_getinfo(mHandle, CURLINFO_RESPONSE_CODE, &code);
+	return code;
+}
+
+std::string HttpReq::getHeader(const std::string& name) const
+{
+	auto it = mHeaders.find(name);
+	return (it != mHeaders.cend()) ? it->second : "";
+}
+
+bool HttpReq::finishFile(bool success)
+{
+	if(mFile == NULL)
+		return mSavePath.empty() && success;
+
+	const std::string partPath = mSavePath + ".part";
+	const bool written = (fclose(mFile) == 0);
+	mFile = NULL;
+
+	if(!success || !written)
+	{
+		remove(partPath.c_str());
+		return false;
+	}
+
+#if defined(_WIN32)
+	Utils::FileSystem::removeFile(mSavePath);
+#endif // _WIN32
+
+	if(rename(partPath.c_str(), mSavePath.c_str()) != 0)
+	{
+		remove(partPath.c_str());
+		return false;
+	}
+
+	Utils::FileSystem::invalidateExists(mSavePath);
+	return true;
 }
 
 void HttpReq::onError(const char* msg)
@@ -198,10 +409,59 @@ std::string HttpReq::getErrorMsg()
 //return value is number of elements successfully read
 size_t HttpReq::write_content(void* buff, size_t size, size_t nmemb, void* req_ptr)
 {
-	std::stringstream& ss = ((HttpReq*)req_ptr)->mContent;
-	ss.write((char*)buff, size * nmemb);
+	HttpReq* req = (HttpReq*)req_ptr;
+	const size_t length = size * nmemb;
+
+	// anything short of length makes curl fail the transfer with a write error
+	if(req->mFile)
+		return fwrite(buff, 1, length, req->mFile);
+
+	// the headers are in by the first write, grow the buffer once rather than every few kilobytes
+	if(!req->mReserved)
+	{
+		req->mReserved = true;
+
+#if CURL_AT_LEAST_VERSION(7,55,0)
+		curl_off_t contentLength = -1;
+		if((curl_easy_getinfo(req->mHandle, CURLINFO_CONTENT_LENGTH_DOWNLOAD_T, &contentLength) == CURLE_OK) && (contentLength > 0))
+			req->mContent.reserve((size_t)contentLength);
+#else
+		double contentLength = -1.0;
+		if((curl_easy_getinfo(req->mHandle, CURLINFO_CONTENT_LENGTH_DOWNLOAD, &contentLength) == CURLE_OK) && (contentLength > 0.0))
+			req->mContent.reserve((size_t)contentLength);
+#endif
+	}
+
+	req->mContent.append((const char*)buff, length);
+
+	return length;
+}
+
+//used as a curl callback, called once for every header line of every response
+size_t HttpReq::write_header(char* buff, size_t size, size_t nmemb, void* req_ptr)
+{
+	HttpReq* req = (HttpReq*)req_ptr;
+	const size_t length = size * nmemb;
+	std::string line(buff, length);
+
+	while(!line.empty() && ((line.back() == '\r') || (line.back() == '\n')))
+		line.pop_back();
+
+	// a redirect starts another response, only the headers of the last one count
+	if(line.compare(0, 5, "HTTP/") == 0)
+	{
+		req->mHeaders.clear();
+		return length;
+	}
+
+	const size_t colon = line.find(':');
+	if(colon == std::string::npos)
+		return length;
+
+	const std::string name = Utils::String::toLower(Utils::String::trim(line.substr(0, colon)));
+	req->mHeaders[name] = Utils::String::trim(line.substr(colon + 1));
 
-	return nmemb;
+	return length;
 }
 
 //used as a curl callback
@@ -3,8 +3,10 @@
 #define ES_CORE_HTTP_REQ_H
 
 #include <curl/curl.h>
+#include <stdio.h>
 #include <map>
-#include <sstream>
+#include <string>
+#include <vector>
 
 /* Usage:
  * HttpReq myRequest("www.google.com", "/index.html");
@@ -28,6 +30,13 @@ class HttpReq
 public:
 	HttpReq(const std::string& url);
 
+	// Streams the body straight into the file at savePath instead of keeping it in memory, getContent() stays empty.
+	// It's written next to savePath first and only replaces what was there once the whole body arrived
+	HttpReq(const std::string& url, const std::string& savePath);
+
+	// Sends extra headers like "If-None-Match: ..." along with the request
+	HttpReq(const std::string& url, const std::vector<std::string>& headers);
+
 	~HttpReq();
 
 	enum Status
@@ -44,29 +53,56 @@ public:
 
 	std::string getErrorMsg();
 
-	std::string getContent() const; // mStatus must be REQ_SUCCESS
+	const std::string& getContent() const; // mStatus must be REQ_SUCCESS
+	std::string takeContent(); // mStatus must be REQ_SUCCESS, moves the content out and leaves it empty
+
+	// The HTTP status code and the headers of the last response, header names are lowercase
+	long getResponseCode() const; // mStatus must be REQ_SUCCESS
+	std::string getHeader(const std::string& name) const;
 
 	static std::string urlEncode(const std::string &s);
 	static bool isUrl(const std::string& s);
 
 private:
 	static size_t write_content(void* buff, size_t size, size_t nmemb, void* req_ptr);
+	static size_t write_header(char* buff, size_t size, size_t nmemb, void* req_ptr);
 	//static int update_progress(void* req_ptr, double dlTotal, double dlNow, double ulTotal, double ulNow);
 
 	//god dammit libcurl why can't you have some way to check the status of an individual handle
 	//why do I have to handle ALL messages at once
 	static std::map<CURL*, HttpReq*> s_requests;
 
+	// all requests share the connections of the multi handle, and the DNS and TLS session caches of the share handle,
+	// so a scraper talking to the same host over and over only connects and shakes hands once.
+	// Finished easy handles are kept for the next request instead of being set up from scratch
+	static CURLM* initMulti();
+	static CURLSH* initShare();
+	static CURL* takeHandle();
+	static void returnHandle(CURL* handle);
+
 	static CURLM* s_multi_handle;
+	static CURLSH* s_share_handle;
+	static std::vector<CURL*> s_free_handles;
 
+	void init(const std::string& url);
 	void onError(const char* msg);
 
+	// called once the transfer ended, moves the streamed file into place or throws it away
+	bool finishFile(bool success);
+
 	CURL* mHandle;
 
 	Status mStatus;
 
-	std::stringstream mContent;
+	std::string mContent;
 	std::string mErrorMsg;
+
+	std::string mSavePath;
+	FILE* mFile;
+	bool mReserved;
+
+	curl_slist* mRequestHeaders;
+	std::map<std::string, std::string> mHeaders;
 };
 
 #endif // ES_CORE_HTTP_REQ_H
@@ -1,62 +1,195 @@
 #include "ImageIO.h"
 
+#include "resources/PixelBufferPool.h"
 #include "Log.h"
 #include <FreeImage.h>
+#include <algorithm>
+#include <stdio.h>
 #include <string.h>
 
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#elif defined(__ARM_NEON) || defined(__ARM_NEON__)
+#include <arm_neon.h>
+#endif
+
+// FreeImage keeps the channels in BGR(A) order on little endian machines, the SIMD paths only handle that order
+#if (FI_RGBA_RED == 2) && (FI_RGBA_GREEN == 1) && (FI_RGBA_BLUE == 0) && (FI_RGBA_ALPHA == 3)
+#define BGRA_ORDER
+#endif
+
+static void copyPixels32(unsigned char* _dst, const unsigned char* _src, const size_t _count)
+{
+	size_t i = 0;
+
+#if defined(BGRA_ORDER) && defined(__SSE2__)
+	// red and blue trade places within each 32 bit pixel, four pixels at a time
+	const __m128i maskGA = _mm_set1_epi32((int)0xFF00FF00);
+	const __m128i maskFF = _mm_set1_epi32(0x000000FF);
+
+	for(; (i + 4) <= _count; i += 4)
+	{
+		const __m128i bgra = _mm_loadu_si128((const __m128i*)(_src + (i * 4)));
+		const __m128i r    = _mm_and_si128(_mm_srli_epi32(bgra, 16), maskFF);
+		const __m128i b    = _mm_slli_epi32(_mm_and_si128(bgra, maskFF), 16);
+
+		_mm_storeu_si128((__m128i*)(_dst + (i * 4)), _mm_or_si128(_mm_and_si128(bgra, maskGA), _mm_or_si128(r, b)));
+	}
+#elif defined(BGRA_ORDER) && (defined(__ARM_NEON) || defined(__ARM_NEON__))
+	for(; (i + 16) <= _count; i += 16)
+	{
+		uint8x16x4_t    pixels = vld4q_u8(_src + (i * 4));
+		const uint8x16_t blue  = pixels.val[0];
+
+		pixels.val[0] = pixels.val[2];
+		pixels.val[2] = blue;
+		vst4q_u8(_dst + (i * 4), pixels);
+	}
+#endif
+
+	for(; i < _count; ++i)
+	{
+		const unsigned char* src = _src + (i * 4);
+		unsigned char*       dst = _dst + (i * 4);
+
+		dst[0] = src[FI_RGBA_RED];
+		dst[1] = src[FI_RGBA_GREEN];
+		dst[2] = src[FI_RGBA_BLUE];
+		dst[3] = src[FI_RGBA_ALPHA];
+	}
+
+} // copyPixels32
+
+static void copyPixels24(unsigned char* _dst, const unsigned char* _src, const size_t _count)
+{
+	size_t i = 0;
+
+#if defined(BGRA_ORDER) && (defined(__ARM_NEON) || defined(__ARM_NEON__))
+	for(; (i + 16) <= _count; i += 16)
+	{
+		const uint8x16x3_t bgr = vld3q_u8(_src + (i * 3));
+		uint8x16x4_t       rgba;
+
+		rgba.val[0] = bgr.val[2];
+		rgba.val[1] = bgr.val[1];
+		rgba.val[2] = bgr.val[0];
+		rgba.val[3] = vdupq_n_u8(255);
+		vst4q_u8(_dst + (i * 4), rgba);
+	}
+#endif
+
+	for(; i < _count; ++i)
+	{
+		const unsigned char* src = _src + (i * 3);
+		unsigned char*       dst = _dst + (i * 4);
+
+		dst[0] = src[FI_RGBA_RED];
+		dst[1] = src[FI_RGBA_GREEN];
+		dst[2] = src[FI_RGBA_BLUE];
+		dst[3] = 255;
+	}
+
+} // copyPixels24
+
 std::vector<unsigned char> ImageIO::loadFromMemoryRGBA32(const unsigned char * data, const size_t size, size_t & width, size_t & height)
 {
 	std::vector<unsigned char> rawData;
+	loadFromMemoryRGBA32(data, size, rawData, width, height);
+	return rawData;
+}
+
+bool ImageIO::loadFromMemoryRGBA32(const unsigned char * data, const size_t size, std::vector<unsigned char> & dataRGBA, size_t & width, size_t & height)
+{
+	size_t sourceWidth, sourceHeight;
+	int level;
+	return loadFromMemoryRGBA32(data, size, nullptr, dataRGBA, sourceWidth, sourceHeight, width, height, level);
+}
+
+bool ImageIO::loadFromMemoryRGBA32(const unsigned char * data, const size_t size, const LevelFunction& getLevel, std::vector<unsigned char> & dataRGBA, size_t & sourceWidth, size_t & sourceHeight, size_t & width, size_t & height, int & level)
+{
+	bool loaded = false;
+	sourceWidth = 0;
+	sourceHeight = 0;
 	width = 0;
 	height = 0;
+	level = 0;
 	FIMEMORY * fiMemory = FreeImage_OpenMemory((BYTE *)data, (DWORD)size);
 	if (fiMemory != nullptr) {
 		//detect the filetype from data
 		FREE_IMAGE_FORMAT format = FreeImage_GetFileTypeFromMemory(fiMemory);
 		if (format != FIF_UNKNOWN && FreeImage_FIFSupportsReading(format))
 		{
+			//libjpeg can scale the DCT blocks down by up to 8 while it decodes, FreeImage asks for that when the flags
+			//hold the size of the longer side in their upper 16 bits
+			int flags = 0;
+			int jpegLevel = 0;
+			if ((format == FIF_JPEG) && getLevel)
+			{
+				FIBITMAP * fiHeader = FreeImage_LoadFromMemory(format, fiMemory, FIF_LOAD_NOPIXELS);
+				FreeImage_SeekMemory(fiMemory, 0, SEEK_SET);
+				if (fiHeader != nullptr)
+				{
+					sourceWidth = FreeImage_GetWidth(fiHeader);
+					sourceHeight = FreeImage_GetHeight(fiHeader);
+					FreeImage_Unload(fiHeader);
+					jpegLevel = std::min(getLevel(sourceWidth, sourceHeight), MAX_DECODE_LEVEL);
+					if (jpegLevel > 0)
+						flags = (int)((std::max(sourceWidth, sourceHeight) >> jpegLevel) << 16);
+				}
+			}
 			//file type is supported. load image
-			FIBITMAP * fiBitmap = FreeImage_LoadFromMemory(format, fiMemory);
+			FIBITMAP * fiBitmap = FreeImage_LoadFromMemory(format, fiMemory, flags);
+			if ((fiBitmap != nullptr) && (jpegLevel > 0))
+			{
+				//libjpeg rounds the scaled size up, anything else means the plugin didn't scale as asked
+				const size_t decodedWidth = FreeImage_GetWidth(fiBitmap);
+				for (int i = jpegLevel; (i > 0) && (level == 0); --i)
+				{
+					if ((decodedWidth == (sourceWidth >> i)) || (decodedWidth == ((sourceWidth + (1 << i) - 1) >> i)))
+						level = i;
+				}
+				if ((level == 0) && (decodedWidth != sourceWidth))
+				{
+					FreeImage_Unload(fiBitmap);
+					FreeImage_SeekMemory(fiMemory, 0, SEEK_SET);
+					fiBitmap = FreeImage_LoadFromMemory(format, fiMemory, 0);
+				}
+			}
 			if (fiBitmap != nullptr)
 			{
-				//loaded. convert to 32bit if necessary
-				if (FreeImage_GetBPP(fiBitmap) != 32)
+				//24 and 32 bit images are converted while they're copied, only the others need a 32 bit copy first
+				unsigned int bpp = FreeImage_GetBPP(fiBitmap);
+				if ((FreeImage_GetImageType(fiBitmap) != FIT_BITMAP) || ((bpp != 24) && (bpp != 32)))
 				{
 					FIBITMAP * fiConverted = FreeImage_ConvertTo32Bits(fiBitmap);
-					if (fiConverted != nullptr)
-					{
-						//free original bitmap data
-						FreeImage_Unload(fiBitmap);
-						fiBitmap = fiConverted;
-					}
+					//free original bitmap data
+					FreeImage_Unload(fiBitmap);
+					fiBitmap = fiConverted;
+					bpp = 32;
 				}
 				if (fiBitmap != nullptr)
 				{
 					width = FreeImage_GetWidth(fiBitmap);
 					height = FreeImage_GetHeight(fiBitmap);
-					//loop through scanlines and add all pixel data to the return vector
-					//this is necessary, because width*height*bpp might not be == pitch
-					unsigned char * tempData = new unsigned char[width * height * 4];
-					for (size_t i = 0; i < height; i++)
+					if (level == 0)
 					{
-						const BYTE * scanLine = FreeImage_GetScanLine(fiBitmap, (int)i);
-						memcpy(tempData + (i * width * 4), scanLine, width * 4);
+						sourceWidth = width;
+						sourceHeight = height;
 					}
-					//convert from BGRA to RGBA
-					for(size_t i = 0; i < width*height; i++)
+					//scanlines go into the buffer one by one, because width*height*bpp might not be == pitch. they're kept
+					//bottom up like FreeImage has them, which is the order textures are uploaded in
+					PixelBufferPool::acquire(dataRGBA, width * height * 4);
+					for (size_t i = 0; i < height; i++)
 					{
-						RGBQUAD bgra = ((RGBQUAD *)tempData)[i];
-						RGBQUAD rgba;
-						rgba.rgbBlue = bgra.rgbRed;
-						rgba.rgbGreen = bgra.rgbGreen;
-						rgba.rgbRed = bgra.rgbBlue;
-						rgba.rgbReserved = bgra.rgbReserved;
-						((RGBQUAD *)tempData)[i] = rgba;
+						const BYTE * scanLine = FreeImage_GetScanLine(fiBitmap, (int)i);
+						if (bpp == 32)
+							copyPixels32(dataRGBA.data() + (i * width * 4), scanLine, width);
+						else
+							copyPixels24(dataRGBA.data() + (i * width * 4), scanLine, width);
 					}
-					rawData = std::vector<unsigned char>(tempData, tempData + width * height * 4);
 					//free bitmap data
 					FreeImage_Unload(fiBitmap);
-					delete[] tempData;
+					loaded = true;
 				}
 			}
 			else
@@ -71,6 +204,71 @@ std::vector<unsigned char> ImageIO::loadFromMemoryRGBA32(const unsigned char * d
 		//free FIMEMORY again
 		FreeImage_CloseMemory(fiMemory);
 	}
+	if (!loaded)
+		PixelBufferPool::release(dataRGBA);
+	return loaded;
+}
+
+bool ImageIO::loadSizeFromFile(const std::string& path, size_t & width, size_t & height)
+{
+	width = 0;
+	height = 0;
+	FREE_IMAGE_FORMAT format = FreeImage_GetFileType(path.c_str(), 0);
+	if (format == FIF_UNKNOWN || !FreeImage_FIFSupportsReading(format))
+		return false;
+
+	//the plugins that can't skip the pixels decode the whole image, that's still correct, only slower
+	FIBITMAP * fiBitmap = FreeImage_Load(format, path.c_str(), FIF_LOAD_NOPIXELS);
+	if (fiBitmap == nullptr)
+		return false;
+
+	width = FreeImage_GetWidth(fiBitmap);
+	height = FreeImage_GetHeight(fiBitmap);
+	FreeImage_Unload(fiBitmap);
+	return (width != 0) && (height != 0);
+}
+
+std::vector<unsigned char> ImageIO::saveToMemory(const unsigned char * dataRGBA, const size_t width, const size_t height)
+{
+	std::vector<unsigned char> rawData;
+	bool opaque = true;
+	for (size_t i = 0; (i < width * height) && opaque; i++)
+		opaque = (dataRGBA[(i * 4) + 3] == 255);
+
+	//JPEG has no alpha channel, keep it for the opaque images only which make up most of the boxart
+	const FREE_IMAGE_FORMAT format = opaque ? FIF_JPEG : FIF_PNG;
+	const int bytesPerPixel = opaque ? 3 : 4;
+	FIBITMAP * fiBitmap = FreeImage_Allocate((int)width, (int)height, bytesPerPixel * 8);
+	if (fiBitmap == nullptr)
+		return rawData;
+
+	//scanlines are stored in the same order loadFromMemoryRGBA32 returns them in
+	for (size_t i = 0; i < height; i++)
+	{
+		const unsigned char * pixel = dataRGBA + (i * width * 4);
+		BYTE * scanLine = FreeImage_GetScanLine(fiBitmap, (int)i);
+		for (size_t x = 0; x < width; x++, pixel += 4, scanLine += bytesPerPixel)
+		{
+			scanLine[FI_RGBA_RED] = pixel[0];
+			scanLine[FI_RGBA_GREEN] = pixel[1];
+			scanLine[FI_RGBA_BLUE] = pixel[2];
+			if (!opaque)
+				scanLine[FI_RGBA_ALPHA] = pixel[3];
+		}
+	}
+
+	FIMEMORY * fiMemory = FreeImage_OpenMemory();
+	if (fiMemory != nullptr)
+	{
+		BYTE * data = nullptr;
+		DWORD size = 0;
+		if (FreeImage_SaveToMemory(format, fiBitmap, fiMemory, opaque ? JPEG_QUALITYGOOD : PNG_Z_BEST_SPEED) && FreeImage_AcquireMemory(fiMemory, &data, &size))
+			rawData = std::vector<unsigned char>(data, data + size);
+		else
+			LOG(LogError) << "Error - Failed to save image to memory!";
+		FreeImage_CloseMemory(fiMemory);
+	}
+	FreeImage_Unload(fiBitmap);
 	return rawData;
 }
 
@@ -2,13 +2,30 @@
 #ifndef ES_CORE_IMAGE_IO
 #define ES_CORE_IMAGE_IO
 
+#include <functional>
 #include <stdlib.h>
+#include <string>
 #include <vector>
 
 class ImageIO
 {
 public:
+	// Returns how many times an image of sourceWidth x sourceHeight may be halved
+	typedef std::function<int(size_t sourceWidth, size_t sourceHeight)> LevelFunction;
+
 	static std::vector<unsigned char> loadFromMemoryRGBA32(const unsigned char * data, const size_t size, size_t & width, size_t & height);
+	// Decodes straight into dataRGBA, which is resized to fit, false and empty when the data isn't an image. The pixels
+	// are RGBA with the bottom row first, as they're uploaded, and are copied only once on the way out of FreeImage
+	static bool loadFromMemoryRGBA32(const unsigned char * data, const size_t size, std::vector<unsigned char> & dataRGBA, size_t & width, size_t & height);
+	// Same, but formats which can leave out detail while they're decoded, like JPEG, come out halved up to
+	// MAX_DECODE_LEVEL of the getLevel(sourceWidth, sourceHeight) times already, which is a lot faster than halving them
+	// afterwards. level is set to how many times the image was halved, the caller halves it the rest of the way
+	static bool loadFromMemoryRGBA32(const unsigned char * data, const size_t size, const LevelFunction& getLevel, std::vector<unsigned char> & dataRGBA, size_t & sourceWidth, size_t & sourceHeight, size_t & width, size_t & height, int & level);
+	static const int MAX_DECODE_LEVEL = 3;
+	// Reads only as much of the file as needed for the size of the image, without decoding it
+	static bool loadSizeFromFile(const std::string& path, size_t & width, size_t & height);
+	// Encodes data as returned by loadFromMemoryRGBA32, as JPEG when it's opaque and as PNG otherwise
+	static std::vector<unsigned char> saveToMemory(const unsigned char * dataRGBA, const size_t width, const size_t height);
 	static void flipPixelsVert(unsigned char* imagePx, const size_t& width, const size_t& height);
 };
 
@@ -3,6 +3,7 @@
 #include "Log.h"
 #include "utils/StringUtil.h"
 #include <pugixml.hpp>
+#include <unordered_map>
 
 //some util functions
 std::string inputTypeToString(InputType type)
@@ -40,15 +41,101 @@ InputType stringToInputType(const std::string& type)
 }
 
 
+// the names components ask for, isMappedLike() also accepts the analog sticks and the page buttons for some of them
+enum Action
+{
+	ACTION_UP, ACTION_DOWN, ACTION_LEFT, ACTION_RIGHT,
+	ACTION_A, ACTION_B, ACTION_X, ACTION_Y, ACTION_START, ACTION_SELECT,
+	ACTION_LEFTSHOULDER, ACTION_RIGHTSHOULDER, ACTION_PAGEUP, ACTION_PAGEDOWN,
+	ACTION_LEFTTRIGGER, ACTION_RIGHTTRIGGER, ACTION_LEFTTHUMB, ACTION_RIGHTTHUMB,
+	ACTION_LEFTANALOGUP, ACTION_LEFTANALOGDOWN, ACTION_LEFTANALOGLEFT, ACTION_LEFTANALOGRIGHT,
+	ACTION_RIGHTANALOGUP, ACTION_RIGHTANALOGDOWN, ACTION_RIGHTANALOGLEFT, ACTION_RIGHTANALOGRIGHT,
+	ACTION_HOTKEYENABLE,
+	ACTION_COUNT,
+	ACTION_NONE = -1
+};
+
+static const struct
+{
+	const char* name;
+	int         like[2];
+
+} ACTIONS[ACTION_COUNT] =
+{
+	{ "up",               { ACTION_LEFTANALOGUP,    ACTION_RIGHTANALOGUP    } },
+	{ "down",             { ACTION_LEFTANALOGDOWN,  ACTION_RIGHTANALOGDOWN  } },
+	{ "left",             { ACTION_LEFTANALOGLEFT,  ACTION_RIGHTANALOGLEFT  } },
+	{ "right",            { ACTION_LEFTANALOGRIGHT, ACTION_RIGHTANALOGRIGHT } },
+	{ "a",                { ACTION_NONE,            ACTION_NONE             } },
+	{ "b",                { ACTION_NONE,            ACTION_NONE             } },
+	{ "x",                { ACTION_NONE,            ACTION_NONE             } },
+	{ "y",                { ACTION_NONE,            ACTION_NONE             } },
+	{ "start",            { ACTION_NONE,            ACTION_NONE             } },
+	{ "select",           { ACTION_NONE,            ACTION_NONE             } },
+	{ "leftshoulder",     { ACTION_PAGEUP,          ACTION_NONE             } },
+	{ "rightshoulder",    { ACTION_PAGEDOWN,        ACTION_NONE             } },
+	{ "pageup",           { ACTION_NONE,            ACTION_NONE             } },
+	{ "pagedown",         { ACTION_NONE,            ACTION_NONE             } },
+	{ "lefttrigger",      { ACTION_NONE,            ACTION_NONE             } },
+	{ "righttrigger",     { ACTION_NONE,            ACTION_NONE             } },
+	{ "leftthumb",        { ACTION_NONE,            ACTION_NONE             } },
+	{ "rightthumb",       { ACTION_NONE,            ACTION_NONE             } },
+	{ "leftanalogup",     { ACTION_NONE,            ACTION_NONE             } },
+	{ "leftanalogdown",   { ACTION_NONE,            ACTION_NONE             } },
+	{ "leftanalogleft",   { ACTION_NONE,            ACTION_NONE             } },
+	{ "leftanalogright",  { ACTION_NONE,            ACTION_NONE             } },
+	{ "rightanalogup",    { ACTION_NONE,            ACTION_NONE             } },
+	{ "rightanalogdown",  { ACTION_NONE,            ACTION_NONE             } },
+	{ "rightanalogleft",  { ACTION_NONE,            ACTION_NONE             } },
+	{ "rightanalogright", { ACTION_NONE,            ACTION_NONE             } },
+	{ "hotkeyenable",     { ACTION_NONE,            ACTION_NONE             } },
+};
+
+static int getAction(const std::string& name)
+{
+	static const std::unordered_map<std::string, int> actions = []
+	{
+		std::unordered_map<std::string, int> names;
+
+		for(int i = 0; i < ACTION_COUNT; i++)
+			names[ACTIONS[i].name] = i;
+
+		return names;
+	}();
+
+	auto it = actions.find(name);
+	if(it != actions.cend())
+		return it->second;
+
+	// the names are lower case, the components ask for them like that anyway
+	it = actions.find(Utils::String::toLower(name));
+	return (it != actions.cend()) ? it->second : ACTION_NONE;
+}
+
 InputConfig::InputConfig(int deviceId, const std::string& deviceName, const std::string& deviceGUID) : mDeviceId(deviceId), mDeviceName(deviceName), mDeviceGUID(deviceGUID)
 {
 	mVendorId   =  0;
 	mProductId  =  0;
+
+	updateActions();
 }
 
 void InputConfig::clear()
 {
 	mNameMap.clear();
+	updateActions();
+}
+
+void InputConfig::updateActions()
+{
+	mActions.assign(ACTION_COUNT, Input());
+
+	for(int i = 0; i < ACTION_COUNT; i++)
+	{
+		auto it = mNameMap.find(ACTIONS[i].name);
+		if(it != mNameMap.cend())
+			mActions[i] = it->second;
+	}
 }
 
 bool InputConfig::isConfigured()
@@ -59,13 +146,17 @@ bool InputConfig::isConfigured()
 void InputConfig::mapInput(const std::string& name, Input input)
 {
 	mNameMap[Utils::String::toLower(name)] = input;
+	updateActions();
 }
 
 void InputConfig::unmapInput(const std::string& name)
 {
 	auto it = mNameMap.find(Utils::String::toLower(name));
 	if(it != mNameMap.cend())
+	{
 		mNameMap.erase(it);
+		updateActions();
+	}
 }
 
 bool InputConfig::getInputByName(const std::string& name, Input* result)
@@ -80,46 +171,59 @@ bool InputConfig::getInputByName(const std::string& name, Input* result)
 	return false;
 }
 
-bool InputConfig::isMappedTo(const std::string& name, Input input)
+bool InputConfig::matches(const Input& mapped, const Input& input) const
 {
-	Input comp;
-	if(!getInputByName(name, &comp))
-		return false;
-
-	if(comp.configured && comp.type == input.type && comp.id == input.id)
+	if(mapped.configured && mapped.type == input.type && mapped.id == input.id)
 	{
-		if(comp.type == TYPE_HAT)
+		if(mapped.type == TYPE_HAT)
 		{
-			return (input.value == 0 || input.value & comp.value);
+			return (input.value == 0 || input.value & mapped.value);
 		}
 
-		if(comp.type == TYPE_AXIS)
+		if(mapped.type == TYPE_AXIS)
 		{
-			return input.value == 0 || comp.value == input.value;
+			return input.value == 0 || mapped.value == input.value;
 		}else{
 			return true;
 		}
 	}
+
 	return false;
 }
 
+bool InputConfig::isMappedTo(const std::string& name, Input input)
+{
+	const int action = getAction(name);
+
+	if(action != ACTION_NONE)
+		return matches(mActions[action], input);
+
+	Input comp;
+	if(!getInputByName(name, &comp))
+		return false;
+
+	return matches(comp, input);
+}
+
 bool InputConfig::isMappedLike(const std::string& name, Input input)
 {
-	if(name == "left")
+	const int action = getAction(name);
+
+	if(action == ACTION_NONE)
+		return isMappedTo(name, input);
+
+	if(matches(mActions[action], input))
+		return true;
+
+	for(int i = 0; i < 2; i++)
 	{
-		return isMappedTo("left", input) || isMappedTo("leftanalogleft", input) || isMappedTo("rightanalogleft", input);
-	}else if(name == "right"){
-		return isMappedTo("right", input) || isMappedTo("leftanalogright", input) || isMappedTo("rightanalogright", input);
-	}else if(name == "up"){
-		return isMappedTo("up", input) || isMappedTo("leftanalogup", input) || isMappedTo("rightanalogup", input);
-	}else if(name == "down"){
-		return isMappedTo("down", input) || isMappedTo("leftanalogdown", input) || isMappedTo("rightanalogdown", input);
-	}else if(name == "leftshoulder"){
-		return isMappedTo("leftshoulder", input) || isMappedTo("pageup", input);
-	}else if(name == "rightshoulder"){
-		return isMappedTo("rightshoulder", input) || isMappedTo("pagedown", input);
+		const int like = ACTIONS[action].like[i];
+
+		if((like != ACTION_NONE) && matches(mActions[like], input))
+			return true;
 	}
-	return isMappedTo(name, input);
+
+	return false;
 }
 
 std::vector<std::string> InputConfig::getMappedTo(Input input)
@@ -182,6 +286,8 @@ void InputConfig::loadFromXML(pugi::xml_node& node)
 
 		mNameMap[Utils::String::toLower(name)] = Input(mDeviceId, typeEnum, id, value, true);
 	}
+
+	updateActions();
 }
 
 void InputConfig::writeToXML(pugi::xml_node& parent)
@@ -128,7 +128,13 @@ public:
 	bool isConfigured();
 
 private:
+	// The inputs of the names a component can ask for, by their index in the table of InputConfig.cpp, so asking
+	// isMappedTo() doesn't have to take the name apart and look it up in mNameMap for every input
+	void updateActions();
+	bool matches(const Input& mapped, const Input& input) const;
+
 	std::map<std::string, Input> mNameMap;
+	std::vector<Input> mActions;
 	const int mDeviceId;
 	const std::string mDeviceName;
 	const std::string mDeviceGUID;
@@ -0,0 +1,164 @@
+#include "InputLatency.h"
+
+#include "Log.h"
+#include "Settings.h"
+#include <SDL_timer.h>
+#include <algorithm>
+
+// presses a report is made of
+#define REPORT_SAMPLES 100
+
+// a press that changed nothing on screen is never presented, it's dropped after this many ms
+#define MAX_LATENCY 1000.0
+
+static Setting<bool> sMeasureInputLatency("MeasureInputLatency");
+
+std::vector<InputLatency::Press> InputLatency::sPending;
+std::vector<float>               InputLatency::sTotals;
+double                           InputLatency::sStages[4]       = { 0.0, 0.0, 0.0, 0.0 };
+InputLatency::Report             InputLatency::sReport          = { 0, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f };
+double                           InputLatency::sEventReceived   = 0.0;
+double                           InputLatency::sEventDispatched = 0.0;
+bool                             InputLatency::sActive          = false;
+
+//////////////////////////////////////////////////////////////////////////
+
+InputLatency::Scope::Scope(const bool _pressed) : mMeasured(sActive && _pressed && (sEventReceived != 0.0))
+{
+
+} // Scope
+
+//////////////////////////////////////////////////////////////////////////
+
+InputLatency::Scope::~Scope()
+{
+	if(mMeasured)
+		sPending.push_back(Press { sEventReceived, sEventDispatched, getTime(), 0.0 });
+
+} // ~Scope
+
+//////////////////////////////////////////////////////////////////////////
+
+void InputLatency::eventStarted(const unsigned int _timestamp)
+{
+	if(!sActive)
+		return;
+
+	// the timestamp only has whole ms, the time the event waited in the queue is taken from it
+	const unsigned int ticks  = SDL_GetTicks();
+	const double       queued = (ticks > _timestamp) ? (double)(ticks - _timestamp) : 0.0;
+
+	sEventDispatched = getTime();
+	sEventReceived   = sEventDispatched - queued;
+
+} // eventStarted
+
+//////////////////////////////////////////////////////////////////////////
+
+void InputLatency::eventDone()
+{
+	sEventReceived = 0.0;
+
+} // eventDone
+
+//////////////////////////////////////////////////////////////////////////
+
+void InputLatency::updateDone()
+{
+	if(sPending.empty())
+		return;
+
+	const double now = getTime();
+
+	for(auto it = sPending.begin(); it != sPending.end(); ++it)
+	{
+		if(it->updated == 0.0)
+			it->updated = now;
+	}
+
+} // updateDone
+
+//////////////////////////////////////////////////////////////////////////
+
+void InputLatency::frameDone(const bool _presented)
+{
+	sActive = sMeasureInputLatency.get();
+
+	if(!sActive)
+	{
+		sPending.clear();
+		return;
+	}
+
+	if(sPending.empty())
+		return;
+
+	const double now = getTime();
+
+	for(auto it = sPending.begin(); it != sPending.end(); )
+	{
+		if(_presented && (it->updated != 0.0))
+		{
+			addSample(*it, now);
+			it = sPending.erase(it);
+		}
+		else if((now - it->received) > MAX_LATENCY)
+			it = sPending.erase(it);
+		else
+			++it;
+	}
+
+} // frameDone
+
+//////////////////////////////////////////////////////////////////////////
+
+bool InputLatency::getReport(Report& _report)
+{
+	_report = sReport;
+	return (sReport.count > 0);
+
+} // getReport
+
+//////////////////////////////////////////////////////////////////////////
+
+double InputLatency::getTime()
+{
+	return (SDL_GetPerformanceCounter() * 1000.0) / SDL_GetPerformanceFrequency();
+
+} // getTime
+
+//////////////////////////////////////////////////////////////////////////
+
+void InputLatency::addSample(const Press& _press, const double _presented)
+{
+	sTotals.push_back((float)(_presented - _press.received));
+	sStages[0] += _press.dispatched - _press.received;
+	sStages[1] += _press.handled    - _press.dispatched;
+	sStages[2] += _press.updated    - _press.handled;
+	sStages[3] += _presented        - _press.updated;
+
+	if(sTotals.size() < REPORT_SAMPLES)
+		return;
+
+	std::sort(sTotals.begin(), sTotals.end());
+
+	const size_t count = sTotals.size();
+
+	sReport.count   = (unsigned int)count;
+	sReport.p50     = sTotals[(count * 50) / 100];
+	sReport.p90     = sTotals[(count * 90) / 100];
+	sReport.p99     = sTotals[(count * 99) / 100];
+	sReport.max     = sTotals.back();
+	sReport.queued  = (float)(sStages[0] / count);
+	sReport.input   = (float)(sStages[1] / count);
+	sReport.update  = (float)(sStages[2] / count);
+	sReport.present = (float)(sStages[3] / count);
+
+	LOG(LogInfo) << "Input latency of the last " << count << " presses: p50 " << sReport.p50 << "ms p90 " << sReport.p90 <<
+	                "ms p99 " << sReport.p99 << "ms max " << sReport.max << "ms, on average queued " << sReport.queued <<
+	                "ms input " << sReport.input << "ms update " << sReport.update << "ms present " << sReport.present << "ms";
+
+	sTotals.clear();
+	std::fill(sStages, sStages + 4, 0.0);
+
+} // addSample
@@ -0,0 +1,78 @@
+#pragma once
+#ifndef ES_CORE_INPUT_LATENCY_H
+#define ES_CORE_INPUT_LATENCY_H
+
+#include <vector>
+
+// With "MeasureInputLatency" every press is followed from the time SDL got it, through InputManager::parseEvent(),
+// Window::input() and Window::update(), to the swap that presented the first frame drawn after it. A press nothing
+// on screen changed for is dropped after a second. The percentiles are logged every 100 presses, shown with the
+// framerate and written to metrics.prom
+class InputLatency
+{
+public:
+
+	// what the last 100 presses took, in ms
+	struct Report
+	{
+		unsigned int count;
+		float        p50;
+		float        p90;
+		float        p99;
+		float        max;
+		float        queued;    // average from SDL to parseEvent()
+		float        input;     // average in Window::input()
+		float        update;    // average until the frame's update was done
+		float        present;   // average from then until the swap returned
+
+	}; // Report
+
+	// Follows a press through Window::input(), one that didn't come from an event isn't measured
+	class Scope
+	{
+	public:
+
+		 Scope(const bool _pressed);
+		~Scope();
+
+	private:
+
+		bool mMeasured;
+
+	}; // Scope
+
+	// Called by InputManager::parseEvent() around dispatching an event, _timestamp is the SDL one
+	static void eventStarted(const unsigned int _timestamp);
+	static void eventDone   ();
+
+	static void updateDone();
+	// Called once the frame was swapped, _presented is false when it was skipped
+	static void frameDone (const bool _presented);
+
+	// False until there are samples
+	static bool getReport(Report& _report);
+
+private:
+
+	struct Press
+	{
+		double received;
+		double dispatched;
+		double handled;
+		double updated; // 0 until the update after it
+	};
+
+	static double getTime();
+	static void   addSample(const Press& _press, const double _presented);
+
+	static std::vector<Press> sPending;
+	static std::vector<float> sTotals;
+	static double             sStages[4];
+	static Report             sReport;
+	static double             sEventReceived; // 0 outside of an event
+	static double             sEventDispatched;
+	static bool               sActive;
+
+}; // InputLatency
+
+#endif // ES_CORE_INPUT_LATENCY_H
@@ -2,6 +2,7 @@
 
 #include "utils/FileSystemUtil.h"
 #include "CECInput.h"
+#include "InputLatency.h"
 #include "Log.h"
 #include "platform.h"
 #include "Scripting.h"
@@ -31,7 +32,7 @@ int SDL_USER_CECBUTTONUP   = -1;
 
 InputManager* InputManager::mInstance = NULL;
 
-InputManager::InputManager() : mKeyboardInputConfig(NULL)
+InputManager::InputManager() : mKeyboardInputConfig(NULL), mEventTime(0)
 {
 }
 
@@ -212,6 +213,25 @@ InputConfig* InputManager::getInputConfigByDevice(int device)
 }
 
 bool InputManager::parseEvent(const SDL_Event& ev, Window* window)
+{
+	// the components see when the event happened, not when the frame got to it
+	mEventTime = ev.common.timestamp;
+	InputLatency::eventStarted(ev.common.timestamp);
+
+	const bool causedEvent = dispatchEvent(ev, window);
+
+	InputLatency::eventDone();
+	mEventTime = 0;
+
+	return causedEvent;
+}
+
+unsigned int InputManager::getEventTime() const
+{
+	return (mEventTime != 0) ? mEventTime : SDL_GetTicks();
+}
+
+bool InputManager::dispatchEvent(const SDL_Event& ev, Window* window)
 {
 	bool causedEvent = false;
 	switch(ev.type)
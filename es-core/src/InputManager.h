@@ -29,11 +29,14 @@ private:
 
 	std::map<SDL_JoystickID, int*> mPrevAxisValues;
 
+	unsigned int mEventTime; // of the event being parsed, 0 outside of parseEvent()
+
 	bool initialized() const;
 
 	void addJoystickByDeviceIndex(int id);
 	void removeJoystickByJoystickID(SDL_JoystickID id);
 	bool loadInputConfig(InputConfig* config); // returns true if successfully loaded, false if not (or didn't exist)
+	bool dispatchEvent(const SDL_Event& ev, Window* window);
 
 public:
 	virtual ~InputManager();
@@ -58,6 +61,10 @@ public:
 	InputConfig* getInputConfigByDevice(int deviceId);
 
 	bool parseEvent(const SDL_Event& ev, Window* window);
+
+	// SDL ticks the input being handled happened at, which can be well before the frame handling it started.
+	// Inputs that don't come from an event, like the ones of the UI benchmark, happen now
+	unsigned int getEventTime() const;
 };
 
 #endif // ES_CORE_INPUT_MANAGER_H
@@ -0,0 +1,64 @@
+#include "InputRepeat.h"
+
+#include "InputManager.h"
+#include <SDL_timer.h>
+
+int InputRepeat::sUpdateTime = 0;
+
+InputRepeat::InputRepeat(const ScrollTierList& _tiers) : mTiers(_tiers), mTime(0), mTierTime(0), mRepeatTime(0), mTier(0), mActive(false)
+{
+} // InputRepeat
+
+void InputRepeat::start()
+{
+	mTime       = InputManager::getInstance()->getEventTime();
+	mTierTime   = 0;
+	mRepeatTime = 0;
+	mTier       = 0;
+	mActive     = true;
+
+} // start
+
+void InputRepeat::stop()
+{
+	mTier   = 0;
+	mActive = false;
+
+} // stop
+
+int InputRepeat::update()
+{
+	// the input may have come in after the update started
+	const int elapsed = sUpdateTime - mTime;
+
+	if(!mActive || (elapsed <= 0))
+		return 0;
+
+	mTime        = sUpdateTime;
+	mRepeatTime += elapsed;
+	mTierTime   += elapsed;
+
+	// the repeats are counted before the tier moves up, it would not catch the scrollDelay == tier length case otherwise
+	int count = 0;
+	while(mRepeatTime >= mTiers.tiers[mTier].scrollDelay)
+	{
+		mRepeatTime -= mTiers.tiers[mTier].scrollDelay;
+		count++;
+	}
+
+	// are we ready to go even FASTER?
+	while(mTier < mTiers.count - 1 && mTierTime >= mTiers.tiers[mTier].length)
+	{
+		mTierTime -= mTiers.tiers[mTier].length;
+		mTier++;
+	}
+
+	return count;
+
+} // update
+
+void InputRepeat::frameStarted()
+{
+	sUpdateTime = (int)SDL_GetTicks();
+
+} // frameStarted
@@ -0,0 +1,67 @@
+#pragma once
+#ifndef ES_CORE_INPUT_REPEAT_H
+#define ES_CORE_INPUT_REPEAT_H
+
+struct ScrollTier
+{
+	int length; // how long we stay on this level before going to the next
+	int scrollDelay; // how long between scrolls
+};
+
+struct ScrollTierList
+{
+	const int count;
+	const ScrollTier* tiers;
+};
+
+// default scroll tiers
+const ScrollTier QUICK_SCROLL_TIERS[] = {
+	{500, 500},
+	{2000, 114},
+	{4000, 32},
+	{0, 16}
+};
+const ScrollTierList LIST_SCROLL_STYLE_QUICK = { 4, QUICK_SCROLL_TIERS };
+
+const ScrollTier SLOW_SCROLL_TIERS[] = {
+	{500, 500},
+	{0, 200}
+};
+const ScrollTierList LIST_SCROLL_STYLE_SLOW = { 2, SLOW_SCROLL_TIERS };
+
+// Repeats a held input on the timing of a ScrollTierList. The time it is held is measured from when its input event
+// happened to when the current update started, instead of being added up from the frame times, so repeats come at
+// the same rate however long the frames take and a press isn't credited with the frame that came before it
+class InputRepeat
+{
+public:
+
+	InputRepeat(const ScrollTierList& _tiers);
+
+	// Starts counting at the time of the input being handled, see InputManager::getEventTime()
+	void start();
+	void stop ();
+
+	// Repeats that came due since the last call
+	int update();
+
+	bool isActive() const { return mActive; }
+	int  getTier () const { return mTier; }
+
+	// Called by Window before the components are updated
+	static void frameStarted();
+
+private:
+
+	static int sUpdateTime;
+
+	const ScrollTierList& mTiers;
+	int                   mTime; // ticks accounted for so far
+	int                   mTierTime;
+	int                   mRepeatTime;
+	int                   mTier;
+	bool                  mActive;
+
+}; // InputRepeat
+
+#endif // ES_CORE_INPUT_REPEAT_H
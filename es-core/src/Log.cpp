@@ -2,12 +2,67 @@
 
 #include "utils/FileSystemUtil.h"
 #include "platform.h"
+#include <condition_variable>
 #include <iostream>
 #include <iomanip>
+#include <mutex>
+#include <thread>
+#include <time.h>
+#include <vector>
 
 LogLevel Log::reportingLevel = LogInfo;
 FILE* Log::file = NULL; //fopen(getLogPath().c_str(), "w");
 
+// Messages are handed to a writer thread, so whoever logs only pays for the formatting and not for the file.
+// The writer takes everything queued in one go and writes it without holding the lock
+struct LogMessage
+{
+	std::string text;
+	bool console;
+};
+
+static std::mutex              sQueueMutex;
+static std::condition_variable sQueueCondition;
+static std::vector<LogMessage> sQueue;
+static std::thread             sWriter;
+static bool                    sWriterRunning = false;
+static bool                    sFlushRequested = false;
+
+static void writeMessages(FILE* output)
+{
+	std::unique_lock<std::mutex> lock(sQueueMutex);
+	std::vector<LogMessage> messages;
+
+	while(true)
+	{
+		sQueueCondition.wait(lock, [] { return !sQueue.empty() || sFlushRequested || !sWriterRunning; });
+
+		const bool running = sWriterRunning;
+		const bool flush = sFlushRequested;
+		messages.swap(sQueue);
+		sFlushRequested = false;
+		lock.unlock();
+
+		for(auto it = messages.cbegin(); it != messages.cend(); ++it)
+		{
+			fputs(it->text.c_str(), output);
+
+			if(it->console)
+				fputs(it->text.c_str(), stderr);
+		}
+		messages.clear();
+
+		if(flush || !running)
+			fflush(output);
+
+		lock.lock();
+
+		// close() waits for everything queued before it
+		if(!running && sQueue.empty())
+			return;
+	}
+}
+
 LogLevel Log::getReportingLevel()
 {
 	return reportingLevel;
@@ -35,12 +90,34 @@ void Log::init()
 void Log::open()
 {
 	file = fopen(getLogPath().c_str(), "w");
+
+	if(file != NULL)
+	{
+		sWriterRunning = true;
+		sWriter = std::thread(writeMessages, file);
+	}
 }
 
 std::ostringstream& Log::get(LogLevel level)
 {
-	time_t t = time(nullptr);
-	os << std::put_time(localtime(&t), "%b %d %T ") << "lvl" << level << ": \t";
+	// localtime isn't safe on the loader threads, and the time only changes once a second anyway
+	static thread_local time_t lastTime = 0;
+	static thread_local char   timeString[32] = "";
+	const time_t t = time(nullptr);
+
+	if(t != lastTime)
+	{
+		struct tm local;
+#if defined(_WIN32)
+		localtime_s(&local, &t);
+#else
+		localtime_r(&t, &local);
+#endif
+		strftime(timeString, sizeof(timeString), "%b %d %H:%M:%S ", &local);
+		lastTime = t;
+	}
+
+	os << timeString << "lvl" << level << ": \t";
 	messageLevel = level;
 
 	return os;
@@ -48,14 +125,31 @@ std::ostringstream& Log::get(LogLevel level)
 
 void Log::flush()
 {
-	fflush(getOutput());
+	// called every frame, the writer flushes once it's done with what's queued
+	std::unique_lock<std::mutex> lock(sQueueMutex);
+
+	if(!sWriterRunning)
+		return;
+
+	sFlushRequested = true;
+	sQueueCondition.notify_one();
 }
 
 void Log::close()
 {
 	if(file == NULL) return;
-	fclose(file);
+
+	{
+		std::unique_lock<std::mutex> lock(sQueueMutex);
+		sWriterRunning = false;
+		sQueueCondition.notify_one();
+	}
+
+	sWriter.join();
+
+	FILE* output = file;
 	file = NULL;
+	fclose(output);
 }
 
 FILE* Log::getOutput()
@@ -65,9 +159,11 @@ FILE* Log::getOutput()
 
 Log::~Log()
 {
-	os << std::endl;
+	os << '\n';
 
-	if(getOutput() == NULL)
+	std::unique_lock<std::mutex> lock(sQueueMutex);
+
+	if(!sWriterRunning)
 	{
 		// not open yet, print to stdout
 		std::cerr << "ERROR - tried to write to log file before it was open! The following won't be logged:\n";
@@ -75,10 +171,12 @@ Log::~Log()
 		return;
 	}
 
-	fprintf(getOutput(), "%s", os.str().c_str());
-
 	//if it's an error, also print to console
 	//print all messages if using --debug
-	if(messageLevel == LogError || reportingLevel >= LogDebug)
-		fprintf(stderr, "%s", os.str().c_str());
+	LogMessage message = { os.str(), (messageLevel == LogError || reportingLevel >= LogDebug) };
+	sQueue.push_back(std::move(message));
+
+	// the writer gets woken once per batch, not for every line
+	if(sQueue.size() == 1)
+		sQueueCondition.notify_one();
 }
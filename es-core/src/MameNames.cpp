@@ -1,25 +1,32 @@
 #include "MameNames.h"
 
 #include "resources/ResourceManager.h"
+#include "utils/BinaryUtil.h"
 #include "utils/FileSystemUtil.h"
 #include "Log.h"
 #include <pugixml.hpp>
 #include <string.h>
+#include <algorithm>
 
-MameNames* MameNames::sInstance = nullptr;
+std::atomic<MameNames*> MameNames::sInstance(nullptr);
+std::mutex              MameNames::sMutex;
+
+static const char     CACHE_MAGIC[4] = { 'E', 'S', 'M', 'N' };
+static const uint32_t CACHE_VERSION  = 1;
 
 void MameNames::init()
 {
-	if(!sInstance)
-		sInstance = new MameNames();
+	getInstance();
 
 } // init
 
 void MameNames::deinit()
 {
+	std::unique_lock<std::mutex> lock(sMutex);
+
 	if(sInstance)
 	{
-		delete sInstance;
+		delete sInstance.load();
 		sInstance = nullptr;
 	}
 
@@ -27,6 +34,14 @@ void MameNames::deinit()
 
 MameNames* MameNames::getInstance()
 {
+	MameNames* instance = sInstance;
+
+	if(instance)
+		return instance;
+
+	// the systems load in parallel, whichever arcade system comes first creates it
+	std::unique_lock<std::mutex> lock(sMutex);
+
 	if(!sInstance)
 		sInstance = new MameNames();
 
@@ -36,92 +51,220 @@ MameNames* MameNames::getInstance()
 
 MameNames::MameNames()
 {
-	std::string xmlpath = ResourceManager::getInstance()->getResourcePath(":/mamenames.xml");
+	std::vector<std::string> paths;
+	paths.push_back(ResourceManager::getInstance()->getResourcePath(":/mamenames.xml"));
+	paths.push_back(ResourceManager::getInstance()->getResourcePath(":/mamebioses.xml"));
+	paths.push_back(ResourceManager::getInstance()->getResourcePath(":/mamedevices.xml"));
 
-	if(!Utils::FileSystem::exists(xmlpath))
+	if(loadCache(paths))
 		return;
 
-	LOG(LogInfo) << "Parsing XML file \"" << xmlpath << "\"...";
+	mNamePool.clear();
+	mNamePairs.clear();
+	mMameBioses.clear();
+	mMameDevices.clear();
+
+	if(parseXML(paths))
+		saveCache(paths);
 
-	pugi::xml_document doc;
-	pugi::xml_parse_result result = doc.load_file(xmlpath.c_str());
+} // MameNames
+
+MameNames::~MameNames()
+{
+
+} // ~MameNames
+
+bool MameNames::parseXML(const std::vector<std::string>& _paths)
+{
+	const char* nodeNames[] = { "game", "bios", "device" };
 
-	if(!result)
+	for(size_t i = 0; i < _paths.size(); ++i)
 	{
-		LOG(LogError) << "Error parsing XML file \"" << xmlpath << "\"!\n	" << result.description();
-		return;
+		const std::string& xmlpath = _paths[i];
+
+		if(!ResourceManager::getInstance()->fileExists(xmlpath))
+			return true;
+
+		LOG(LogInfo) << "Parsing XML file \"" << xmlpath << "\"...";
+
+		pugi::xml_document doc;
+		const ResourceData data = ResourceManager::getInstance()->getFileData(xmlpath);
+		pugi::xml_parse_result result = doc.load_buffer(data.ptr.get(), data.length);
+
+		if(!result)
+		{
+			LOG(LogError) << "Error parsing XML file \"" << xmlpath << "\"!\n	" << result.description();
+			return false;
+		}
+
+		for(pugi::xml_node node = doc.child(nodeNames[i]); node; node = node.next_sibling(nodeNames[i]))
+		{
+			if(i == 0)
+			{
+				NamePair namePair;
+				namePair.mameName = (uint32_t)mNamePool.size();
+				mNamePool.append(node.child("mamename").text().get()).push_back('\0');
+				namePair.realName = (uint32_t)mNamePool.size();
+				mNamePool.append(node.child("realname").text().get()).push_back('\0');
+				mNamePairs.push_back(namePair);
+			}
+			else if(i == 1)
+				mMameBioses.insert(node.text().get());
+			else
+				mMameDevices.insert(node.text().get());
+		}
 	}
 
-	for(pugi::xml_node gameNode = doc.child("game"); gameNode; gameNode = gameNode.next_sibling("game"))
+	// getRealName searches them, the file is sorted already but nothing made sure of it
+	const char* pool = mNamePool.c_str();
+	std::stable_sort(mNamePairs.begin(), mNamePairs.end(), [pool](const NamePair& _a, const NamePair& _b)
+	{
+		return strcmp(pool + _a.mameName, pool + _b.mameName) < 0;
+	});
+
+	return true;
+
+} // parseXML
+
+bool MameNames::loadCache(const std::vector<std::string>& _paths)
+{
+	std::string buffer;
+
+	if(!Utils::Binary::loadFile(getCachePath(), buffer))
+		return false;
+
+	Utils::Binary::Reader reader(buffer);
+	char                  magic[4];
+	uint32_t              version;
+
+	if(!reader.read(magic, sizeof(magic)) || memcmp(magic, CACHE_MAGIC, sizeof(magic)) ||
+	   !reader.read(version) || (version != CACHE_VERSION))
+		return false;
+
+	// any of the files changed, been added or removed
+	for(auto it = _paths.cbegin(); it != _paths.cend(); ++it)
 	{
-		NamePair namePair = { gameNode.child("mamename").text().get(), gameNode.child("realname").text().get() };
-		mNamePairs.push_back(namePair);
+		std::string path;
+		int64_t     size;
+		int64_t     modifiedTime;
+
+		int64_t     fileSize;
+		int64_t     fileModifiedTime;
+
+		if(!reader.readString(path) || !reader.read(size) || !reader.read(modifiedTime) || (path != *it))
+			return false;
+
+		ResourceManager::getInstance()->getFileStats(path, fileSize, fileModifiedTime);
+
+		if((size != fileSize) || (modifiedTime != fileModifiedTime))
+			return false;
 	}
 
-	// Read bios
-	xmlpath = ResourceManager::getInstance()->getResourcePath(":/mamebioses.xml");
+	uint32_t pairCount;
 
-	if(!Utils::FileSystem::exists(xmlpath))
-		return;
+	if(!reader.readString(mNamePool) || !reader.read(pairCount) || ((size_t)pairCount * sizeof(NamePair) > reader.getRemaining()))
+		return false;
 
-	LOG(LogInfo) << "Parsing XML file \"" << xmlpath << "\"...";
+	mNamePairs.resize(pairCount);
 
-	result = doc.load_file(xmlpath.c_str());
+	if(pairCount && !reader.read(&mNamePairs[0], pairCount * sizeof(NamePair)))
+		return false;
 
-	if(!result)
+	for(auto it = mNamePairs.cbegin(); it != mNamePairs.cend(); ++it)
 	{
-		LOG(LogError) << "Error parsing XML file \"" << xmlpath << "\"!\n	" << result.description();
-		return;
+		if((it->mameName >= mNamePool.size()) || (it->realName >= mNamePool.size()))
+			return false;
 	}
 
-	for(pugi::xml_node biosNode = doc.child("bios"); biosNode; biosNode = biosNode.next_sibling("bios"))
+	// the pool ends with a terminator, so every offset in it points at a terminated name
+	if(!mNamePool.empty() && (mNamePool.back() != '\0'))
+		return false;
+
+	nameSet* sets[] = { &mMameBioses, &mMameDevices };
+
+	for(nameSet* set : sets)
 	{
-		std::string bios = biosNode.text().get();
-		mMameBioses.push_back(bios);
+		uint32_t count;
+
+		if(!reader.read(count))
+			return false;
+
+		set->reserve(count);
+
+		for(uint32_t i = 0; i < count; ++i)
+		{
+			std::string name;
+
+			if(!reader.readString(name))
+				return false;
+
+			set->insert(name);
+		}
 	}
 
-	// Read devices
-	xmlpath = ResourceManager::getInstance()->getResourcePath(":/mamedevices.xml");
+	return true;
 
-	if(!Utils::FileSystem::exists(xmlpath))
-		return;
+} // loadCache
 
-	LOG(LogInfo) << "Parsing XML file \"" << xmlpath << "\"...";
+void MameNames::saveCache(const std::vector<std::string>& _paths)
+{
+	Utils::Binary::Writer writer;
 
-	result = doc.load_file(xmlpath.c_str());
+	writer.write(CACHE_MAGIC, sizeof(CACHE_MAGIC));
+	writer.write(CACHE_VERSION);
 
-	if(!result)
+	for(auto it = _paths.cbegin(); it != _paths.cend(); ++it)
 	{
-		LOG(LogError) << "Error parsing XML file \"" << xmlpath << "\"!\n	" << result.description();
-		return;
+		int64_t size;
+		int64_t modifiedTime;
+
+		ResourceManager::getInstance()->getFileStats(*it, size, modifiedTime);
+
+		writer.writeString(*it);
+		writer.write(size);
+		writer.write(modifiedTime);
 	}
 
-	for(pugi::xml_node deviceNode = doc.child("device"); deviceNode; deviceNode = deviceNode.next_sibling("device"))
+	writer.writeString(mNamePool);
+	writer.write((uint32_t)mNamePairs.size());
+	if(!mNamePairs.empty())
+		writer.write(&mNamePairs[0], mNamePairs.size() * sizeof(NamePair));
+
+	const nameSet* sets[] = { &mMameBioses, &mMameDevices };
+
+	for(const nameSet* set : sets)
 	{
-		std::string device = deviceNode.text().get();
-		mMameDevices.push_back(device);
+		writer.write((uint32_t)set->size());
+
+		for(auto it = set->cbegin(); it != set->cend(); ++it)
+			writer.writeString(*it);
 	}
 
-} // MameNames
+	if(!Utils::Binary::saveFile(getCachePath(), writer.getBuffer()))
+		LOG(LogWarning) << "Could not save MAME names cache \"" << getCachePath() << "\"";
 
-MameNames::~MameNames()
+} // saveCache
+
+std::string MameNames::getCachePath()
 {
+	return Utils::FileSystem::getHomePath() + "/.emulationstation/cache/mamenames.cache";
 
-} // ~MameNames
+} // getCachePath
 
 std::string MameNames::getRealName(const std::string& _mameName)
 {
-	size_t start = 0;
-	size_t end   = mNamePairs.size();
+	const char* pool  = mNamePool.c_str();
+	size_t      start = 0;
+	size_t      end   = mNamePairs.size();
 
 	while(start < end)
 	{
 		const size_t index   = (start + end) / 2;
-		const int    compare = strcmp(mNamePairs[index].mameName.c_str(), _mameName.c_str());
+		const int    compare = strcmp(pool + mNamePairs[index].mameName, _mameName.c_str());
 
 		if(compare < 0)       start = index + 1;
 		else if( compare > 0) end   = index;
-		else                  return mNamePairs[index].realName;
+		else                  return pool + mNamePairs[index].realName;
 	}
 
 	return _mameName;
@@ -130,31 +273,12 @@ std::string MameNames::getRealName(const std::string& _mameName)
 
 const bool MameNames::isBios(const std::string& _biosName)
 {
-	return MameNames::find(mMameBioses, _biosName);
+	return (mMameBioses.find(_biosName) != mMameBioses.cend());
 
 } // isBios
 
 const bool MameNames::isDevice(const std::string& _deviceName)
 {
-	return MameNames::find(mMameDevices, _deviceName);
+	return (mMameDevices.find(_deviceName) != mMameDevices.cend());
 
 } // isDevice
-
-const bool MameNames::find(std::vector<std::string> devices, const std::string& name)
-{
-	size_t start = 0;
-	size_t end   = devices.size();
-
-	while(start < end)
-	{
-		const size_t index   = (start + end) / 2;
-		const int    compare = strcmp(devices[index].c_str(), name.c_str());
-
-		if(compare < 0)       start = index + 1;
-		else if( compare > 0) end   = index;
-		else                  return true;
-	}
-
-	return false;
-
-}
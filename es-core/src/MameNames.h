@@ -2,9 +2,15 @@
 #ifndef ES_CORE_MAMENAMES_H
 #define ES_CORE_MAMENAMES_H
 
+#include <atomic>
+#include <mutex>
 #include <string>
+#include <unordered_set>
 #include <vector>
+#include <stdint.h>
 
+// Only created once an arcade system asks for it. The parsed XML files are kept in a binary cache, so later starts
+// only read the names back in one go
 class MameNames
 {
 public:
@@ -18,10 +24,11 @@ public:
 
 private:
 
+	// offsets of null terminated names in mNamePool, sorted by mameName
 	struct NamePair
 	{
-		std::string mameName;
-		std::string realName;
+		uint32_t mameName;
+		uint32_t realName;
 	};
 
 	typedef std::vector<NamePair> namePairVector;
@@ -29,13 +36,21 @@ private:
 	 MameNames();
 	~MameNames();
 
-	static MameNames* sInstance;
+	static std::atomic<MameNames*> sInstance;
+	static std::mutex sMutex;
 
-	namePairVector mNamePairs;
-	std::vector<std::string> mMameBioses;
-	std::vector<std::string> mMameDevices;
+	bool        parseXML  (const std::vector<std::string>& _paths);
+	bool        loadCache (const std::vector<std::string>& _paths);
+	void        saveCache (const std::vector<std::string>& _paths);
+	std::string getCachePath();
+
+	typedef std::unordered_set<std::string> nameSet;
 
-	const bool find(const std::vector<std::string> devices, const std::string& name);
+	// every file of an arcade system gets checked against these, a hash lookup keeps that from showing up in the scan
+	std::string    mNamePool;
+	namePairVector mNamePairs;
+	nameSet        mMameBioses;
+	nameSet        mMameDevices;
 
 }; // MameNames
 
@@ -0,0 +1,84 @@
+#include "MemoryUsage.h"
+
+std::atomic<size_t>     MemoryUsage::sCurrent[SUBSYSTEM_COUNT];
+std::atomic<size_t>     MemoryUsage::sPeak[SUBSYSTEM_COUNT];
+std::function<size_t()> MemoryUsage::sMeasures[SUBSYSTEM_COUNT];
+
+//////////////////////////////////////////////////////////////////////////
+
+static void raisePeak(std::atomic<size_t>& _peak, const size_t _current)
+{
+	size_t peak = _peak.load(std::memory_order_relaxed);
+
+	// another thread may raise it in between, the larger of the two stays
+	while((_current > peak) && !_peak.compare_exchange_weak(peak, _current, std::memory_order_relaxed));
+
+} // raisePeak
+
+//////////////////////////////////////////////////////////////////////////
+
+void MemoryUsage::add(const Subsystem _subsystem, const size_t _bytes)
+{
+	const size_t current = sCurrent[_subsystem].fetch_add(_bytes, std::memory_order_relaxed) + _bytes;
+
+	raisePeak(sPeak[_subsystem], current);
+
+} // add
+
+//////////////////////////////////////////////////////////////////////////
+
+void MemoryUsage::remove(const Subsystem _subsystem, const size_t _bytes)
+{
+	sCurrent[_subsystem].fetch_sub(_bytes, std::memory_order_relaxed);
+
+} // remove
+
+//////////////////////////////////////////////////////////////////////////
+
+void MemoryUsage::setMeasure(const Subsystem _subsystem, const std::function<size_t()>& _measure)
+{
+	sMeasures[_subsystem] = _measure;
+
+} // setMeasure
+
+//////////////////////////////////////////////////////////////////////////
+
+void MemoryUsage::read(Counter* _counters)
+{
+	for(int i = 0; i < SUBSYSTEM_COUNT; ++i)
+	{
+		// the peak of a measured subsystem is the most it was when read
+		if(sMeasures[i])
+		{
+			const size_t current = sMeasures[i]();
+
+			sCurrent[i].store(current, std::memory_order_relaxed);
+			raisePeak(sPeak[i], current);
+		}
+
+		_counters[i].current = sCurrent[i].load(std::memory_order_relaxed);
+		_counters[i].peak    = sPeak[i].load(std::memory_order_relaxed);
+	}
+
+} // read
+
+//////////////////////////////////////////////////////////////////////////
+
+const char* MemoryUsage::getName(const Subsystem _subsystem)
+{
+	switch(_subsystem)
+	{
+		case FILE_DATA:    return "file_data";
+		case METADATA:     return "metadata";
+		case FILTER_INDEX: return "filter_index";
+		case COLLECTIONS:  return "collections";
+		case THEMES:       return "themes";
+		case TEXT_CACHES:  return "text_caches";
+		case FONT_ATLAS:   return "font_atlas";
+		case TEXTURE_RAM:  return "texture_ram";
+		case TEXTURE_VRAM: return "texture_vram";
+		case VIDEO:        return "video";
+		default:           return "unknown";
+	}
+
+} // getName
@@ -0,0 +1,62 @@
+#pragma once
+#ifndef ES_CORE_MEMORY_USAGE_H
+#define ES_CORE_MEMORY_USAGE_H
+
+#include <atomic>
+#include <functional>
+#include <stddef.h>
+
+// The memory of the program by what it's for, each with the most it took since start. Subsystems whose objects come
+// and go in many places count their bytes as they're allocated and freed, the others are measured when they're read,
+// from the totals they keep anyway. The bytes are close estimates, allocator overhead isn't known. Shown with the
+// framerate and written to metrics.prom
+class MemoryUsage
+{
+public:
+
+	enum Subsystem
+	{
+		FILE_DATA = 0,    // the games and folders of the systems
+		METADATA,         // interned metadata strings
+		FILTER_INDEX,     // the filter indexes of the systems
+		COLLECTIONS,      // the games and folders of the collections
+		THEMES,           // the elements and properties of loaded themes
+		TEXT_CACHES,      // the vertices of text laid out for drawing
+		FONT_ATLAS,       // glyph pages and font files
+		TEXTURE_RAM,      // pixels waiting for an upload or kept for reloading, and the pooled decode buffers
+		TEXTURE_VRAM,
+		VIDEO,            // loaded video previews
+
+		SUBSYSTEM_COUNT
+
+	}; // Subsystem
+
+	struct Counter
+	{
+		size_t current;
+		size_t peak;
+
+	}; // Counter
+
+	// Counted subsystems, safe to call from any thread
+	static void add   (const Subsystem _subsystem, const size_t _bytes);
+	static void remove(const Subsystem _subsystem, const size_t _bytes);
+
+	// Measured subsystems, _measure is called on the thread reading the counters
+	static void setMeasure(const Subsystem _subsystem, const std::function<size_t()>& _measure);
+
+	// Fills SUBSYSTEM_COUNT counters, taking the measures
+	static void read(Counter* _counters);
+
+	// lowercase with underscores, as in the metrics label
+	static const char* getName(const Subsystem _subsystem);
+
+private:
+
+	static std::atomic<size_t>     sCurrent[SUBSYSTEM_COUNT];
+	static std::atomic<size_t>     sPeak[SUBSYSTEM_COUNT];
+	static std::function<size_t()> sMeasures[SUBSYSTEM_COUNT];
+
+}; // MemoryUsage
+
+#endif // ES_CORE_MEMORY_USAGE_H
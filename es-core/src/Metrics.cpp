@@ -0,0 +1,185 @@
+#include "Metrics.h"
+
+#include "resources/Font.h"
+#include "resources/TextureResource.h"
+#include "utils/BinaryUtil.h"
+#include "utils/FileSystemUtil.h"
+#include "FrameScheduler.h"
+#include "InputLatency.h"
+#include "Log.h"
+#include "MemoryUsage.h"
+#include "Settings.h"
+#include <chrono>
+#include <sstream>
+#if defined(__linux__)
+#include <fstream>
+#include <stdlib.h>
+#include <unistd.h>
+#endif
+
+// the program start as far as we can tell, static initialization runs right before main
+static const std::chrono::steady_clock::time_point sStartTime = std::chrono::steady_clock::now();
+
+double       Metrics::sBootTime        = 0.0;
+double       Metrics::sLastWrite       = 0.0;
+unsigned int Metrics::sFrames          = 0;
+unsigned int Metrics::sPresentedFrames = 0;
+unsigned int Metrics::sSlowFrames      = 0;
+int          Metrics::sMaxFrameTime    = 0;
+
+static double getSeconds()
+{
+	return std::chrono::duration<double>(std::chrono::steady_clock::now() - sStartTime).count();
+
+} // getSeconds
+
+void Metrics::bootDone()
+{
+	sBootTime  = getSeconds();
+	sLastWrite = 0.0;
+
+	if(Settings::getInstance()->getInt("MetricsInterval") > 0)
+		write();
+
+} // bootDone
+
+void Metrics::frameDone(const int _deltaTime, const bool _presented)
+{
+	sFrames++;
+
+	if(_presented)
+	{
+		sPresentedFrames++;
+
+		// an idle screen waits on purpose, only frames that should have been on time count as dropped
+		if(!FrameScheduler::isIdle() && (_deltaTime > (FrameScheduler::getFrameInterval() * 2)))
+			sSlowFrames++;
+
+		if(_deltaTime > sMaxFrameTime)
+			sMaxFrameTime = _deltaTime;
+	}
+
+	const int interval = Settings::getInstance()->getInt("MetricsInterval");
+
+	if((interval > 0) && ((getSeconds() - sLastWrite) >= interval))
+		write();
+
+} // frameDone
+
+std::string Metrics::getPath()
+{
+	return Utils::FileSystem::getHomePath() + "/.emulationstation/metrics.prom";
+
+} // getPath
+
+size_t Metrics::getResidentMemory()
+{
+#if defined(__linux__)
+	// the second field is the resident set, in pages
+	std::ifstream statm("/proc/self/statm");
+	size_t        size;
+	size_t        resident;
+
+	if(statm >> size >> resident)
+		return resident * (size_t)sysconf(_SC_PAGESIZE);
+#endif // __linux__
+
+	return 0;
+
+} // getResidentMemory
+
+size_t Metrics::getPeakResidentMemory()
+{
+#if defined(__linux__)
+	// the high-water mark of the resident set, in kB
+	std::ifstream status("/proc/self/status");
+	std::string   line;
+
+	while(std::getline(status, line))
+	{
+		if(line.compare(0, 6, "VmHWM:") == 0)
+			return (size_t)strtoull(line.c_str() + 6, nullptr, 10) * 1024;
+	}
+#endif // __linux__
+
+	return 0;
+
+} // getPeakResidentMemory
+
+void Metrics::write()
+{
+	std::stringstream ss;
+
+	// counters keep counting until restart, gauges are what it was at the time of writing
+	ss << "# HELP es_boot_seconds Time from start until the UI was up.\n";
+	ss << "# TYPE es_boot_seconds gauge\n";
+	ss << "es_boot_seconds " << sBootTime << "\n";
+	ss << "# HELP es_uptime_seconds Time since start.\n";
+	ss << "# TYPE es_uptime_seconds gauge\n";
+	ss << "es_uptime_seconds " << getSeconds() << "\n";
+	ss << "# HELP es_frames_total Frames of the main loop, presented or skipped because nothing changed.\n";
+	ss << "# TYPE es_frames_total counter\n";
+	ss << "es_frames_total " << sFrames << "\n";
+	ss << "# HELP es_frames_presented_total Frames that were drawn and presented.\n";
+	ss << "# TYPE es_frames_presented_total counter\n";
+	ss << "es_frames_presented_total " << sPresentedFrames << "\n";
+	ss << "# HELP es_frames_dropped_total Presented frames that took more than twice the frame interval.\n";
+	ss << "# TYPE es_frames_dropped_total counter\n";
+	ss << "es_frames_dropped_total " << sSlowFrames << "\n";
+	ss << "# HELP es_frame_time_max_milliseconds Longest presented frame since the last write.\n";
+	ss << "# TYPE es_frame_time_max_milliseconds gauge\n";
+	ss << "es_frame_time_max_milliseconds " << sMaxFrameTime << "\n";
+	ss << "# HELP es_texture_vram_bytes Texture memory in VRAM.\n";
+	ss << "# TYPE es_texture_vram_bytes gauge\n";
+	ss << "es_texture_vram_bytes " << TextureResource::getTotalMemUsage() << "\n";
+	ss << "# HELP es_texture_total_bytes Texture memory if every texture was loaded.\n";
+	ss << "# TYPE es_texture_total_bytes gauge\n";
+	ss << "es_texture_total_bytes " << TextureResource::getTotalTextureSize() << "\n";
+	ss << "# HELP es_texture_load_queue Textures waiting for the loader threads.\n";
+	ss << "# TYPE es_texture_load_queue gauge\n";
+	ss << "es_texture_load_queue " << TextureResource::getLoadQueueLength() << "\n";
+	ss << "# HELP es_font_vram_bytes Font memory, glyph pages and font files.\n";
+	ss << "# TYPE es_font_vram_bytes gauge\n";
+	ss << "es_font_vram_bytes " << Font::getTotalMemUsage() << "\n";
+
+	MemoryUsage::Counter memory[MemoryUsage::SUBSYSTEM_COUNT];
+	MemoryUsage::read(memory);
+
+	ss << "# HELP es_memory_bytes Memory by subsystem, estimated.\n";
+	ss << "# TYPE es_memory_bytes gauge\n";
+	for(int i = 0; i < MemoryUsage::SUBSYSTEM_COUNT; ++i)
+		ss << "es_memory_bytes{subsystem=\"" << MemoryUsage::getName((MemoryUsage::Subsystem)i) << "\"} " << memory[i].current << "\n";
+	ss << "# HELP es_memory_peak_bytes Most memory by subsystem since start, estimated.\n";
+	ss << "# TYPE es_memory_peak_bytes gauge\n";
+	for(int i = 0; i < MemoryUsage::SUBSYSTEM_COUNT; ++i)
+		ss << "es_memory_peak_bytes{subsystem=\"" << MemoryUsage::getName((MemoryUsage::Subsystem)i) << "\"} " << memory[i].peak << "\n";
+
+	InputLatency::Report latency;
+
+	if(InputLatency::getReport(latency))
+	{
+		ss << "# HELP es_input_latency_milliseconds Time from a press until the frame it changed was presented, of the last presses measured.\n";
+		ss << "# TYPE es_input_latency_milliseconds summary\n";
+		ss << "es_input_latency_milliseconds{quantile=\"0.5\"} " << latency.p50 << "\n";
+		ss << "es_input_latency_milliseconds{quantile=\"0.9\"} " << latency.p90 << "\n";
+		ss << "es_input_latency_milliseconds{quantile=\"0.99\"} " << latency.p99 << "\n";
+		ss << "es_input_latency_milliseconds{quantile=\"1\"} " << latency.max << "\n";
+	}
+
+	const size_t resident = getResidentMemory();
+
+	if(resident > 0)
+	{
+		ss << "# HELP es_resident_bytes Resident memory of the process.\n";
+		ss << "# TYPE es_resident_bytes gauge\n";
+		ss << "es_resident_bytes " << resident << "\n";
+	}
+
+	// written next to it and renamed, a scrape never sees half a file
+	if(!Utils::Binary::saveFile(getPath(), ss.str()))
+		LOG(LogWarning) << "Could not write metrics to \"" << getPath() << "\"";
+
+	sLastWrite    = getSeconds();
+	sMaxFrameTime = 0;
+
+} // write
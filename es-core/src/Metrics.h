@@ -0,0 +1,40 @@
+#pragma once
+#ifndef ES_CORE_METRICS_H
+#define ES_CORE_METRICS_H
+
+#include <stddef.h>
+#include <string>
+
+// Keeps a few counters about boot, frames and memory and writes them every "MetricsInterval" seconds to
+// ~/.emulationstation/metrics.prom in the Prometheus text format, for node_exporter's textfile collector or
+// anything else that polls it. Nothing is written while the interval is 0
+class Metrics
+{
+public:
+
+	// Called once the UI is up, the boot time counts from when the program was started
+	static void bootDone();
+	// Called for each frame of the main loop, writes the file once the interval is up
+	static void frameDone(const int _deltaTime, const bool _presented);
+
+	static std::string getPath();
+
+	// Resident memory of the process in bytes, 0 where it isn't known
+	static size_t getResidentMemory();
+	// Most resident memory the process had at any point, 0 where it isn't known
+	static size_t getPeakResidentMemory();
+
+private:
+
+	static void write();
+
+	static double       sBootTime;
+	static double       sLastWrite;
+	static unsigned int sFrames;
+	static unsigned int sPresentedFrames;
+	static unsigned int sSlowFrames;
+	static int          sMaxFrameTime;
+
+}; // Metrics
+
+#endif // ES_CORE_METRICS_H
@@ -0,0 +1,130 @@
+#include "MusicStream.h"
+
+#include "utils/FileSystemUtil.h"
+#include "Log.h"
+#include <string.h>
+#include <vlc/vlc.h>
+
+// 16 bit stereo at 44.1kHz like every other sound, the ring holds about 0.75 seconds of it
+#define BUFFER_SIZE (1 << 17)
+
+libvlc_instance_t* MusicStream::sVLC = NULL;
+
+MusicStream::MusicStream() : mPlayer(NULL), mBuffer(BUFFER_SIZE), mReadPos(0), mWritePos(0)
+{
+} // MusicStream
+
+MusicStream::~MusicStream()
+{
+	close();
+
+	if(mPlayer)
+		libvlc_media_player_release(mPlayer);
+
+} // ~MusicStream
+
+bool MusicStream::open(const std::string& _path)
+{
+	close();
+
+	if(_path.empty() || !Utils::FileSystem::exists(_path))
+		return false;
+
+	if(!sVLC)
+	{
+		const char* args[] = { "--quiet", "--no-video" };
+		sVLC = libvlc_new(sizeof(args) / sizeof(args[0]), args);
+	}
+
+	if(!sVLC)
+		return false;
+
+	if(!mPlayer)
+	{
+		if(!(mPlayer = libvlc_media_player_new(sVLC)))
+			return false;
+
+		// VLC hands over the samples already converted to the format of the mixer
+		libvlc_audio_set_callbacks(mPlayer, play, NULL, NULL, NULL, NULL, this);
+		libvlc_audio_set_format(mPlayer, "S16N", 44100, 2);
+	}
+
+	libvlc_media_t* media = libvlc_media_new_path(sVLC, _path.c_str());
+
+	if(!media)
+	{
+		LOG(LogError) << "Could not open music \"" << _path << "\"";
+		return false;
+	}
+
+	libvlc_media_add_option(media, ":input-repeat=65535");
+	libvlc_media_add_option(media, ":no-video");
+	libvlc_media_player_set_media(mPlayer, media);
+	libvlc_media_release(media);
+
+	if(libvlc_media_player_play(mPlayer) != 0)
+	{
+		LOG(LogError) << "Could not play music \"" << _path << "\"";
+		return false;
+	}
+
+	mPath = _path;
+
+	return true;
+
+} // open
+
+void MusicStream::close()
+{
+	// returns once VLC stopped calling play()
+	if(mPlayer && !mPath.empty())
+		libvlc_media_player_stop(mPlayer);
+
+	mPath.clear();
+	mReadPos  = 0;
+	mWritePos = 0;
+
+} // close
+
+void MusicStream::mix(Uint8* _stream, const Uint32 _length, const int _volume)
+{
+	const Uint32 readPos   = mReadPos.load(std::memory_order_relaxed);
+	const Uint32 available = mWritePos.load(std::memory_order_acquire) - readPos;
+	const Uint32 length    = ((available < _length) ? available : _length) & ~3;
+	const Uint32 index     = readPos & (BUFFER_SIZE - 1);
+	const Uint32 first     = ((BUFFER_SIZE - index) < length) ? (BUFFER_SIZE - index) : length;
+
+	if(_volume > 0)
+	{
+		SDL_MixAudio(_stream, &mBuffer[index], first, _volume);
+
+		if(length > first)
+			SDL_MixAudio(_stream + first, &mBuffer[0], length - first, _volume);
+	}
+
+	mReadPos.store(readPos + length, std::memory_order_release);
+
+} // mix
+
+void MusicStream::play(void* _data, const void* _samples, unsigned int _count, int64_t /*_pts*/)
+{
+	MusicStream* stream   = (MusicStream*)_data;
+	const Uint32 writePos = stream->mWritePos.load(std::memory_order_relaxed);
+	const Uint32 free     = BUFFER_SIZE - (writePos - stream->mReadPos.load(std::memory_order_acquire));
+	Uint32       length   = _count * 4;
+
+	// VLC delivers in real time, the ring only fills up once the mixer stopped reading, like after a fade out
+	if(length > free)
+		length = free;
+
+	const Uint32 index = writePos & (BUFFER_SIZE - 1);
+	const Uint32 first = ((BUFFER_SIZE - index) < length) ? (BUFFER_SIZE - index) : length;
+
+	memcpy(&stream->mBuffer[index], _samples, first);
+
+	if(length > first)
+		memcpy(&stream->mBuffer[0], (const Uint8*)_samples + first, length - first);
+
+	stream->mWritePos.store(writePos + length, std::memory_order_release);
+
+} // play
@@ -0,0 +1,46 @@
+#pragma once
+#ifndef ES_CORE_MUSIC_STREAM_H
+#define ES_CORE_MUSIC_STREAM_H
+
+#include <SDL_audio.h>
+#include <atomic>
+#include <string>
+#include <vector>
+
+struct libvlc_instance_t;
+struct libvlc_media_player_t;
+
+// Plays a music file in a loop through the mixer of AudioManager. VLC decodes it on its own threads into a ring
+// buffer of about a second, so a track of any length only ever takes that much memory. The mixer reads the ring
+// without locking, once it runs dry (VLC fell behind) it plays silence instead of waiting.
+class MusicStream
+{
+public:
+
+	MusicStream();
+	~MusicStream();
+
+	// UI thread only, and only while the mixer doesn't read from the stream
+	bool open (const std::string& _path);
+	void close();
+
+	const std::string& getPath() const { return mPath; }
+
+	// Mixer only, adds up to _length bytes of the decoded samples to _stream at _volume (0 - SDL_MIX_MAXVOLUME)
+	void mix(Uint8* _stream, const Uint32 _length, const int _volume);
+
+private:
+
+	static void play(void* _data, const void* _samples, unsigned int _count, int64_t _pts);
+
+	static libvlc_instance_t* sVLC;
+
+	libvlc_media_player_t* mPlayer;
+	std::string            mPath;
+	std::vector<Uint8>     mBuffer;
+	std::atomic<Uint32>    mReadPos;  // written by the mixer
+	std::atomic<Uint32>    mWritePos; // written by VLC
+
+}; // MusicStream
+
+#endif // ES_CORE_MUSIC_STREAM_H
@@ -1,69 +1,406 @@
 #include "Scripting.h"
 #include "Log.h"
 #include "platform.h"
+#include "Settings.h"
 #include "utils/FileSystemUtil.h"
+#include <condition_variable>
+#include <deque>
+#include <map>
+#include <mutex>
+#include <thread>
 #ifndef WIN32
+#include <SDL_timer.h>
 #include <errno.h>
+#include <fcntl.h>
+#include <signal.h>
 #include <string.h>
+#include <sys/wait.h>
+#include <unistd.h>
+#else
+#define popen _popen
+#define pclose _pclose
 #endif
 
 namespace Scripting
 {
-    int fireEvent(const std::string& eventName, const std::string& arg1, const std::string& arg2, const std::string& arg3, const std::string& arg4)
+    // the scripts found for an event, listed again only when one of its directories changed
+    struct ScriptList
     {
-        LOG(LogDebug) << "fireEvent: " << eventName << " " << arg1 << " " << arg2;
+        time_t                 modified[2];
+        std::list<std::string> scripts;
+        std::list<std::string> notExecutable; // checked again every time, that's fixed without touching the directory
+    };
 
-        std::list<std::string> scriptDirList;
-        std::string test;
+    struct Event
+    {
+        std::string name;
+        std::string args[4];
+        std::string helper; // the ScriptHelper setting when it was queued, only the main thread reads the settings
+    };
 
-        // check in exepath
-        test = Utils::FileSystem::getExePath() + "/scripts/" + eventName;
-        if(Utils::FileSystem::exists(test))
-            scriptDirList.push_back(test);
+    static std::map<std::string, ScriptList> sScriptLists;
+    static std::mutex                        sScriptListsMutex;
 
-        // check in homepath
-        test = Utils::FileSystem::getHomePath() + "/.emulationstation/scripts/" + eventName;
-        if(Utils::FileSystem::exists(test))
-            scriptDirList.push_back(test);
-        int ret = 0;
-        // loop over found script paths per event and over scripts found in eventName folder.
-        for(std::list<std::string>::const_iterator dirIt = scriptDirList.cbegin(); dirIt != scriptDirList.cend(); ++dirIt) {
-            std::list<std::string> scripts = Utils::FileSystem::getDirContent(*dirIt);
-            for (std::list<std::string>::const_iterator it = scripts.cbegin(); it != scripts.cend(); ++it) {
-#ifndef WIN32 // osx / linux
-                if (!Utils::FileSystem::isExecutable(*it)) {
-                    LOG(LogWarning) << *it << " is not executable. Review file permissions.";
-                    continue;
+    static std::deque<Event>       sEvents;
+    static std::mutex              sEventsMutex;
+    static std::condition_variable sEventsQueued;
+    static std::condition_variable sEventsDone;
+    static std::thread             sThread;
+    static bool                    sRunning = false; // an event taken from sEvents is being run
+    static bool                    sExit    = false;
+
+    static FILE*       sHelper = nullptr;
+    static std::string sHelperCommand;
+    static std::mutex  sHelperMutex;
+#ifndef WIN32
+    static pid_t       sHelperPid = -1;
+
+    // how long a helper gets to exit once its stdin is closed, and then once it was asked to terminate
+    static const unsigned int HELPER_EXIT_TIMEOUT = 1000;
+    static const unsigned int HELPER_TERM_TIMEOUT = 500;
+
+    // like popen(helper, "w"), but no other process started by us inherits the pipe, so only closing it here makes
+    // the helper see the end of its stdin, and the pid is kept for closeHelper()
+    static FILE* openHelper(const std::string& helper)
+    {
+        int fds[2];
+#if defined(__linux__)
+        // atomically, another thread may start a process at any time
+        if(pipe2(fds, O_CLOEXEC) != 0)
+            return nullptr;
+#else
+        if(pipe(fds) != 0)
+            return nullptr;
+
+        fcntl(fds[0], F_SETFD, FD_CLOEXEC);
+        fcntl(fds[1], F_SETFD, FD_CLOEXEC);
+#endif
+
+        const pid_t pid = fork();
+        if(pid == 0)
+        {
+            // dup2() leaves the new stdin open across exec
+            dup2(fds[0], STDIN_FILENO);
+            execl("/bin/sh", "sh", "-c", helper.c_str(), (char*)nullptr);
+            _exit(127);
+        }
+
+        close(fds[0]);
+
+        if(pid < 0)
+        {
+            close(fds[1]);
+            return nullptr;
+        }
+
+        FILE* file = fdopen(fds[1], "w");
+        if(!file)
+        {
+            close(fds[1]);
+            kill(pid, SIGKILL);
+            waitpid(pid, nullptr, 0);
+            return nullptr;
+        }
+
+        sHelperPid = pid;
+        return file;
+    }
+
+    static bool waitForHelper(const unsigned int timeout)
+    {
+        const unsigned int start = SDL_GetTicks();
+
+        for(;;)
+        {
+            const pid_t done = waitpid(sHelperPid, nullptr, WNOHANG);
+            if(done == sHelperPid || (done < 0 && errno != EINTR))
+                return true;
+
+            if((SDL_GetTicks() - start) >= timeout)
+                return false;
+
+            SDL_Delay(10);
+        }
+    }
+#endif // !WIN32
+
+    static void closeHelper()
+    {
+        if(sHelper)
+        {
+            // it reads until stdin is closed, then exits
+#ifndef WIN32
+            fclose(sHelper);
+
+            // one that doesn't is asked to, then killed, exiting never waits on it for long
+            if(!waitForHelper(HELPER_EXIT_TIMEOUT))
+            {
+                LOG(LogWarning) << "Script helper " << sHelperCommand << " didn't exit, terminating it";
+                kill(sHelperPid, SIGTERM);
+
+                if(!waitForHelper(HELPER_TERM_TIMEOUT))
+                {
+                    kill(sHelperPid, SIGKILL);
+                    waitpid(sHelperPid, nullptr, 0);
                 }
+            }
+            sHelperPid = -1;
+#else
+            pclose(sHelper);
+#endif
+            sHelper = nullptr;
+        }
+        sHelperCommand.clear();
+    }
+
+    // One line per event, the name and the arguments that were given separated by tabs. Tabs and line breaks in the
+    // arguments are replaced by spaces
+    static void sendToHelper(const std::string& helper, const std::string& eventName, const std::string args[4])
+    {
+        std::unique_lock<std::mutex> lock(sHelperMutex);
+
+        if(helper != sHelperCommand)
+            closeHelper();
+
+        if(helper.empty())
+            return;
+
+        if(!sHelper)
+        {
+#ifndef WIN32
+            // a helper that exited makes the next write fail instead of killing us
+            signal(SIGPIPE, SIG_IGN);
+#endif
+            LOG(LogInfo) << "Starting script helper: " << helper;
+#ifndef WIN32
+            sHelper = openHelper(helper);
+#else
+            sHelper = popen(helper.c_str(), "w");
+#endif
+            if(!sHelper)
+            {
+                LOG(LogError) << "Could not start script helper " << helper;
+                return;
+            }
+            sHelperCommand = helper;
+        }
+
+        std::string line = eventName;
+        int count = 0;
+        while(count < 4 && !args[count].empty())
+            count++;
+
+        for(int i = 0; i < count; i++)
+        {
+            std::string arg = args[i];
+            for(size_t j = 0; j < arg.size(); j++)
+            {
+                if(arg[j] == '\t' || arg[j] == '\n' || arg[j] == '\r')
+                    arg[j] = ' ';
+            }
+            line += '\t' + arg;
+        }
+        line += '\n';
+
+        // started again with the next event
+        if(fputs(line.c_str(), sHelper) < 0 || fflush(sHelper) != 0)
+        {
+            LOG(LogWarning) << "Script helper " << helper << " stopped reading events";
+            closeHelper();
+        }
+    }
+
+    static std::list<std::string> getScripts(const std::string& eventName)
+    {
+        const std::string dirs[2] =
+        {
+            Utils::FileSystem::getExePath() + "/scripts/" + eventName,
+            Utils::FileSystem::getHomePath() + "/.emulationstation/scripts/" + eventName
+        };
+
+        // 0 for a directory that doesn't exist
+        const time_t modified[2] = { Utils::FileSystem::getModifiedTime(dirs[0]), Utils::FileSystem::getModifiedTime(dirs[1]) };
+
+        std::unique_lock<std::mutex> lock(sScriptListsMutex);
+
+        auto listIt = sScriptLists.find(eventName);
+        if(listIt == sScriptLists.end() || listIt->second.modified[0] != modified[0] || listIt->second.modified[1] != modified[1])
+        {
+            ScriptList list;
+            list.modified[0] = modified[0];
+            list.modified[1] = modified[1];
+
+            // loop over found script paths per event and over scripts found in eventName folder.
+            for(int i = 0; i < 2; i++)
+            {
+                if(!modified[i])
+                    continue;
+
+                std::list<std::string> scripts = Utils::FileSystem::getDirContent(dirs[i]);
+                for (std::list<std::string>::const_iterator it = scripts.cbegin(); it != scripts.cend(); ++it) {
+#ifndef WIN32 // osx / linux
+                    if (!Utils::FileSystem::isExecutable(*it)) {
+                        list.notExecutable.push_back(*it);
+                        continue;
+                    }
 #endif
-                std::string script = *it;
-                if (arg1.length() > 0) {
-                    script += " \"" + arg1 + "\"";
-                    if (arg2.length() > 0) {
-                        script += " \"" + arg2 + "\"";
-			if (arg3.length() > 0) {
-			    script += " \"" + arg3 + "\"";
-                            if (arg4.length() > 0) {
-                                script += " \"" + arg4 + "\"";
-			    }
+                    list.scripts.push_back(*it);
+                }
+            }
+
+            listIt = sScriptLists.insert(std::make_pair(eventName, list)).first;
+        }
+
+        ScriptList& list = listIt->second;
+        for (std::list<std::string>::iterator it = list.notExecutable.begin(); it != list.notExecutable.end(); ) {
+            if (Utils::FileSystem::isExecutable(*it)) {
+                list.scripts.push_back(*it);
+                it = list.notExecutable.erase(it);
+            } else {
+                LOG(LogWarning) << *it << " is not executable. Review file permissions.";
+                ++it;
+            }
+        }
+
+        return list.scripts;
+    }
+
+    static int runScripts(const Event& event)
+    {
+        const std::string& eventName = event.name;
+        const std::string& arg1      = event.args[0];
+        const std::string& arg2      = event.args[1];
+        const std::string& arg3      = event.args[2];
+        const std::string& arg4      = event.args[3];
+
+        LOG(LogDebug) << "fireEvent: " << eventName << " " << arg1 << " " << arg2;
+
+        sendToHelper(event.helper, eventName, event.args);
+
+        int ret = 0;
+        std::list<std::string> scripts = getScripts(eventName);
+        for (std::list<std::string>::const_iterator it = scripts.cbegin(); it != scripts.cend(); ++it) {
+            std::string script = *it;
+            if (arg1.length() > 0) {
+                script += " \"" + arg1 + "\"";
+                if (arg2.length() > 0) {
+                    script += " \"" + arg2 + "\"";
+                    if (arg3.length() > 0) {
+                        script += " \"" + arg3 + "\"";
+                        if (arg4.length() > 0) {
+                            script += " \"" + arg4 + "\"";
                         }
                     }
                 }
-                LOG(LogDebug) << "executing: " << script;
-                ret = runSystemCommand(script);
-                if (ret != 0) {
-                    LOG(LogWarning) << script << " failed with exit code != 0. Terminating processing for this event.";
+            }
+            LOG(LogDebug) << "executing: " << script;
+            ret = runSystemCommand(script);
+            if (ret != 0) {
+                LOG(LogWarning) << script << " failed with exit code != 0. Terminating processing for this event.";
 #ifndef WIN32
-                    if (ENOENT == errno) {
-                        LOG(LogWarning) << "Exit code: " << errno << " (" << strerror(errno) << ")";
-                        LOG(LogWarning) << "It is not executable by the current user (usually 'pi'). Review file permissions.";
-                    }
-#endif
-                    return ret;
+                if (ENOENT == errno) {
+                    LOG(LogWarning) << "Exit code: " << errno << " (" << strerror(errno) << ")";
+                    LOG(LogWarning) << "It is not executable by the current user (usually 'pi'). Review file permissions.";
                 }
+#endif
+                return ret;
             }
         }
         return ret;
     }
 
+    static void threadProc()
+    {
+        std::unique_lock<std::mutex> lock(sEventsMutex);
+
+        while(true)
+        {
+            sEventsQueued.wait(lock, [] { return sExit || !sEvents.empty(); });
+
+            // the ones queued before deinit() still run
+            if(sEvents.empty())
+                return;
+
+            const Event event = sEvents.front();
+            sEvents.pop_front();
+            sRunning = true;
+
+            lock.unlock();
+            runScripts(event);
+            lock.lock();
+
+            sRunning = false;
+            if(sEvents.empty())
+                sEventsDone.notify_all();
+        }
+    }
+
+    void deinit()
+    {
+        {
+            std::unique_lock<std::mutex> lock(sEventsMutex);
+            sExit = true;
+        }
+        sEventsQueued.notify_all();
+
+        if(sThread.joinable())
+            sThread.join();
+
+        std::unique_lock<std::mutex> lock(sHelperMutex);
+        closeHelper();
+    }
+
+    static Event createEvent(const std::string& eventName, const std::string& arg1, const std::string& arg2, const std::string& arg3, const std::string& arg4)
+    {
+        Event event;
+        event.name    = eventName;
+        event.args[0] = arg1;
+        event.args[1] = arg2;
+        event.args[2] = arg3;
+        event.args[3] = arg4;
+        event.helper  = Settings::getInstance()->getString("ScriptHelper");
+        return event;
+    }
+
+    int fireEvent(const std::string& eventName, const std::string& arg1, const std::string& arg2, const std::string& arg3, const std::string& arg4)
+    {
+        // the queued ones happened first, their scripts finish before these start
+        {
+            std::unique_lock<std::mutex> lock(sEventsMutex);
+            sEventsDone.wait(lock, [] { return sEvents.empty() && !sRunning; });
+        }
+
+        return runScripts(createEvent(eventName, arg1, arg2, arg3, arg4));
+    }
+
+    void queueEvent(const std::string& eventName, const std::string& arg1, const std::string& arg2, const std::string& arg3, const std::string& arg4)
+    {
+        const Event event = createEvent(eventName, arg1, arg2, arg3, arg4);
+
+        {
+            std::unique_lock<std::mutex> lock(sEventsMutex);
+
+            if(sExit)
+                return;
+
+            if(!sThread.joinable())
+                sThread = std::thread(&threadProc);
+
+            // scrolling through a list only needs the scripts to hear where it stopped, an event that hasn't started yet
+            // is dropped for the newer one, and that goes last as if the dropped one had never been queued
+            for(auto it = sEvents.begin(); it != sEvents.end(); ++it)
+            {
+                if(it->name == eventName)
+                {
+                    sEvents.erase(it);
+                    break;
+                }
+            }
+
+            sEvents.push_back(event);
+        }
+
+        sEventsQueued.notify_one();
+    }
+
 } // Scripting::
@@ -6,7 +6,20 @@
 
 namespace Scripting
 {
+	// Runs what's still queued, then stops the thread queueEvent() started and closes the ScriptHelper
+	void deinit();
+
+	// Every event is also written to the stdin of the ScriptHelper command when that setting isn't empty, one line
+	// each: the event name and its arguments separated by tabs, see sendToHelper(). The helper is started with the
+	// first event and keeps running, it's started again if it stops reading
+
+	// Runs the scripts of eventName right away, after the ones of the events queued before. Returns the exit code of the
+	// first one that failed, 0 if none did
 	int fireEvent(const std::string& eventName, const std::string& arg1="", const std::string& arg2="", const std::string& arg3="", const std::string& arg4="");
+
+	// Runs the scripts of eventName on a thread of their own, in the order the events were queued. Queueing one while
+	// another of the same name is still waiting replaces that one, for the events that fire with every move of a cursor
+	void queueEvent(const std::string& eventName, const std::string& arg1="", const std::string& arg2="", const std::string& arg3="", const std::string& arg4="");
 } // Scripting::
 
 #endif //ES_CORE_SCRIPTING_H
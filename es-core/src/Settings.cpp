@@ -6,9 +6,13 @@
 #include "platform.h"
 #include <pugixml.hpp>
 #include <algorithm>
+#include <fstream>
+#include <sstream>
+#include <thread>
 #include <vector>
 
 Settings* Settings::sInstance = NULL;
+unsigned int Settings::sChangeCount = 0;
 
 // these values are NOT saved to es_settings.xml
 // since they're set through command-line arguments, and not the in-program settings menu
@@ -37,7 +41,7 @@ std::vector<const char*> settings_dont_save {
 	"MonitorID"
 };
 
-Settings::Settings()
+Settings::Settings() : mSavePending(false), mSaving(false), mFlushing(false), mSaveThreadStarted(false)
 {
 	setDefaults();
 	loadFile();
@@ -58,6 +62,8 @@ void Settings::setDefaults()
 
 	mBoolMap["BackgroundJoystickInput"] = false;
 	mBoolMap["ParseGamelistOnly"] = false;
+	mBoolMap["LazyGameListViews"] = false;
+	mBoolMap["CompileThemes"] = true;
 	mBoolMap["ShowHiddenFiles"] = false;
 	mBoolMap["DrawFramerate"] = false;
 	mBoolMap["ShowExit"] = true;
@@ -69,8 +75,31 @@ void Settings::setDefaults()
 	mBoolMap["DisableKidStartMenu"] = true;
 
 	mBoolMap["VSync"] = true;
+	mIntMap["MaxFPS"] = 60; // 0 == no limit
+	mIntMap["RenderScale"] = 100; // percent of the screen's size frames are drawn at before they're stretched onto it
+	mBoolMap["RenderScaleAdaptive"] = false; // drops the scale down to 50% while frames take longer than they should
+	mIntMap["MaxGameListViews"] = 0; // 0 == no limit
+	// for 512 MB boards, trades speed for memory wherever the two can be traded, see README.md
+	mBoolMap["LowMemory"] = false;
+	mBoolMap["CompressTextures"] = false;
+	mBoolMap["ReduceImages"] = true;
+	mBoolMap["CacheSVGs"] = true;
+	mBoolMap["TextureMipmaps"] = false;
+	mBoolMap["KeepImagesDuringGames"] = false;
+	mBoolMap["TrimMemoryDuringGames"] = false; // gives the emulator what ES can build again once the game ends, overrides KeepImagesDuringGames
+	mBoolMap["DeduplicateImages"] = false; // identical files at different paths share a texture, each file of a size that's already loaded is hashed
+	mBoolMap["BackgroundTextureUpload"] = false; // needs a platform that lets a second GL context share the textures
+	mIntMap["TextureUploadBudget"] = 4096; // KiB of textures uploaded per frame while drawing, 0 == unlimited
+	mBoolMap["FontDistanceField"] = false;
+	mIntMap["TextureLoaderThreads"] = 0; // 0 == all cores but one
+	mIntMap["MetricsInterval"] = 0; // seconds between writes of metrics.prom, 0 == off
+	mBoolMap["ProfileGPU"] = false; // GPU time per view in the framerate overlay and timelines, costs draw calls
+	mBoolMap["MeasureInputLatency"] = false; // time from a press until its frame was presented, logged and in the framerate overlay
 
 	mBoolMap["EnableSounds"] = true;
+	mBoolMap["BackgroundMusic"] = true; // played when the theme has music for the system
+	mBoolMap["CacheSounds"] = true; // keep sounds converted to the mixer format in sound_cache/
+	mIntMap["AudioBufferSize"] = 1024; // samples the mixer fills at a time, smaller plays sounds sooner but may crackle
 	mBoolMap["ShowHelpPrompts"] = true;
 	mBoolMap["DoublePressRemovesFromFavs"] = false;
 	mBoolMap["ScrapeRatings"] = true;
@@ -80,6 +109,15 @@ void Settings::setDefaults()
 	mBoolMap["MoveCarousel"] = true;
 
 	mBoolMap["ThreadedLoading"] = false;
+	mBoolMap["ProgressiveBoot"] = false;
+	mBoolMap["RomScanCache"] = true;
+	mBoolMap["GamelistSnapshots"] = true;
+	mBoolMap["WatchLibrary"] = false;
+	mBoolMap["PrefetchRoms"] = false; // reads the ROM the cursor rests on into the page cache, for slow shares and USB sticks
+	mIntMap["PrefetchRomsDelay"] = 1500; // ms the cursor has to rest on a game
+	mIntMap["PrefetchRomsMaxSize"] = 1024; // MB read of a ROM at most
+	mBoolMap["LazyCollections"] = false;
+	mBoolMap["SkipUnchangedFrames"] = true;
 
 	mBoolMap["Debug"] = false;
 	mBoolMap["DebugGrid"] = false;
@@ -91,6 +129,9 @@ void Settings::setDefaults()
 	mBoolMap["SystemSleepTimeHintDisplayed"] = false;
 	mIntMap["ScraperResizeWidth"] = 400;
 	mIntMap["ScraperResizeHeight"] = 0;
+	mIntMap["ScraperGamesInFlight"] = 4;
+	mBoolMap["ScraperCache"] = true;
+	mBoolMap["ScraperHashRoms"] = true;
 	#ifdef _RPI_
 		mIntMap["MaxVRAM"] = 80;
 	#else
@@ -105,6 +146,7 @@ void Settings::setDefaults()
 	mStringMap["SaveGamelistsMode"] = "on exit";
 
 	mBoolMap["ScreenSaverControls"] = true;
+	mBoolMap["ScreenSaverDisplayOff"] = false;
 	mStringMap["ScreenSaverGameInfo"] = "never";
 	mBoolMap["StretchVideoOnScreenSaver"] = false;
 	mStringMap["PowerSaverMode"] = "disabled";
@@ -133,6 +175,9 @@ void Settings::setDefaults()
 		mBoolMap["ScreenSaverOmxPlayer"] = false;
 	#endif
 
+	mBoolMap["VideoHardwareDecode"] = true;
+	mBoolMap["VideoPreviews"] = true;
+
 	mIntMap["ScreenSaverSwapVideoTimeout"] = 30000;
 
 	mBoolMap["VideoAudio"] = true;
@@ -156,6 +201,13 @@ void Settings::setDefaults()
 	mBoolMap["UseCustomCollectionsSystem"] = true;
 	mBoolMap["BackgroundIndexing"] = false;
 
+	// a directory on the ROM share that one cabinet publishes its caches to and the others fetch them from
+	mStringMap["SharedCachePath"] = "";
+	mBoolMap["SharedCachePublish"] = false;
+
+	// a command started once that gets every event on its stdin, for scripts too slow to be started for each one
+	mStringMap["ScriptHelper"] = "";
+
 	mBoolMap["LocalArt"] = false;
 
 	// Audio out device for volume control
@@ -207,7 +259,6 @@ void saveMap(pugi::xml_document& doc, std::map<K, V>& map, const char* type)
 void Settings::saveFile()
 {
 	LOG(LogDebug) << "Settings::saveFile() : Saving Settings to file.";
-	const std::string path = Utils::FileSystem::getHomePath() + "/.emulationstation/es_settings.cfg";
 
 	pugi::xml_document doc;
 
@@ -237,10 +288,108 @@ void Settings::saveFile()
 		}
 	}
 
-	doc.save_file(path.c_str());
+	// the maps belong to the UI thread, the worker only gets the finished document
+	std::stringstream data;
+	doc.save(data);
+
+	{
+		std::unique_lock<std::mutex> lock(mSaveMutex);
+
+		mSaveData    = data.str();
+		mSaveTime    = std::chrono::steady_clock::now();
+		mSavePending = true;
+
+		if(!mSaveThreadStarted)
+		{
+			// runs for as long as the program does, flush() is what makes sure nothing is lost on exit
+			std::thread(&Settings::saveThread, this).detach();
+			mSaveThreadStarted = true;
+		}
+	}
+
+	mSaveEvent.notify_all();
+}
+
+void Settings::flush()
+{
+	std::unique_lock<std::mutex> lock(mSaveMutex);
+
+	mFlushing = true;
+	mSaveEvent.notify_all();
+
+	while(mSavePending || mSaving)
+		mSaveEvent.wait(lock);
+
+	mFlushing = false;
+}
+
+void Settings::saveThread()
+{
+	const std::string path = Utils::FileSystem::getHomePath() + "/.emulationstation/es_settings.cfg";
+	const std::chrono::milliseconds delay(SAVE_DELAY_MS);
+
+	std::unique_lock<std::mutex> lock(mSaveMutex);
+
+	for(;;)
+	{
+		while(!mSavePending)
+			mSaveEvent.wait(lock);
+
+		// every save in between starts the wait over
+		while(!mFlushing && (std::chrono::steady_clock::now() < (mSaveTime + delay)))
+			mSaveEvent.wait_until(lock, mSaveTime + delay);
+
+		std::string data;
+		data.swap(mSaveData);
+		mSavePending = false;
+		mSaving      = true;
+
+		lock.unlock();
+
+		if(writeFile(path, data))
+		{
+			Scripting::fireEvent("config-changed");
+			Scripting::fireEvent("settings-changed");
+		}
+		else
+		{
+			LOG(LogError) << "Could not write Settings file \"" << path << "\"!";
+		}
+
+		lock.lock();
+
+		mSaving = false;
+		mSaveEvent.notify_all();
+	}
+}
+
+bool Settings::writeFile(const std::string& path, const std::string& data)
+{
+	// written next to it and renamed, cutting the power halfway through leaves the old file instead of half of one
+	const std::string partPath = path + ".part";
+
+	std::ofstream file(partPath.c_str(), std::ios::out | std::ios::trunc | std::ios::binary);
+	file.write(data.c_str(), data.size());
+	file.close();
+
+	if(file.fail())
+	{
+		remove(partPath.c_str());
+		return false;
+	}
+
+#if defined(_WIN32)
+	Utils::FileSystem::removeFile(path);
+#endif // _WIN32
 
-	Scripting::fireEvent("config-changed");
-	Scripting::fireEvent("settings-changed");
+	if(rename(partPath.c_str(), path.c_str()) != 0)
+	{
+		remove(partPath.c_str());
+		return false;
+	}
+
+	Utils::FileSystem::invalidateExists(path);
+	return true;
 }
 
 void Settings::loadFile()
@@ -345,10 +494,31 @@ void Settings::processBackwardCompatibility()
 } \
 void Settings::setMethodName(const std::string& name, type value) \
 { \
-	mapName[name] = value; \
+	auto it = mapName.find(name); \
+	if(it == mapName.end()) \
+		mapName[name] = value; \
+	else if(it->second != value) \
+		it->second = value; \
+	else \
+		return; \
+	++sChangeCount; \
 }
 
 SETTINGS_GETSET(bool, mBoolMap, getBool, setBool);
 SETTINGS_GETSET(int, mIntMap, getInt, setInt);
 SETTINGS_GETSET(float, mFloatMap, getFloat, setFloat);
 SETTINGS_GETSET(const std::string&, mStringMap, getString, setString);
+
+template<typename T, typename Map>
+static T* findSetting(Map& map, const std::string& name)
+{
+	if(map.find(name) == map.cend())
+		LOG(LogError) << "Tried to use unset setting " << name << "!";
+
+	return &map[name];
+}
+
+template<> bool*        Settings::find<bool>       (const std::string& name) { return findSetting<bool>(mBoolMap, name); }
+template<> int*         Settings::find<int>        (const std::string& name) { return findSetting<int>(mIntMap, name); }
+template<> float*       Settings::find<float>      (const std::string& name) { return findSetting<float>(mFloatMap, name); }
+template<> std::string* Settings::find<std::string>(const std::string& name) { return findSetting<std::string>(mStringMap, name); }
@@ -2,9 +2,15 @@
 #ifndef ES_CORE_SETTINGS_H
 #define ES_CORE_SETTINGS_H
 
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
 #include <map>
+#include <mutex>
 #include <string>
 
+template<typename T> class Setting;
+
 //This is a singleton for storing settings.
 class Settings
 {
@@ -13,8 +19,16 @@ public:
 	static Settings* getInstance();
 
 	void loadFile();
+
+	// Returns right away, the file is written in the background once no save was asked for in SAVE_DELAY_MS.
+	// A burst of saves from a menu ends up as one write, of the settings as they were on the last save
 	void saveFile();
 
+	// Blocks until a save still waiting or running is written, call before quitting
+	void flush();
+
+	static const int SAVE_DELAY_MS = 500;
+
 	//You will get a warning if you try a get on a key that is not already present.
 	bool getBool(const std::string& name);
 	int getInt(const std::string& name);
@@ -28,11 +42,23 @@ public:
 	void setString(const std::string& name, const std::string& value);
 	void setMap(const std::string& name, const std::map<std::string, int>& map);
 
+	// Bumped by every set that changes a value
+	static unsigned int getChangeCount() { return sChangeCount; }
+
 private:
+	template<typename T> friend class Setting;
+
+	// The stored value of a setting, it stays where it is for as long as the program runs
+	template<typename T> T* find(const std::string& name);
+
 	static Settings* sInstance;
+	static unsigned int sChangeCount;
 
 	Settings();
 
+	void saveThread();
+	static bool writeFile(const std::string& path, const std::string& data);
+
 	void setDefaults();		//Clear everything and load default values.
 	void processBackwardCompatibility();
 	template<typename Map>
@@ -43,6 +69,70 @@ private:
 	std::map<std::string, float> mFloatMap;
 	std::map<std::string, std::string> mStringMap;
 	std::map<std::string, std::map<std::string, int>> mMapIntMap;
+
+	std::string                           mSaveData; // the document of the last save, waiting to be written
+	std::chrono::steady_clock::time_point mSaveTime;
+	std::mutex                            mSaveMutex;
+	std::condition_variable               mSaveEvent;
+	bool                                  mSavePending;
+	bool                                  mSaving;
+	bool                                  mFlushing;
+	bool                                  mSaveThreadStarted;
 };
 
+template<> bool*        Settings::find<bool>       (const std::string& name);
+template<> int*         Settings::find<int>        (const std::string& name);
+template<> float*       Settings::find<float>      (const std::string& name);
+template<> std::string* Settings::find<std::string>(const std::string& name);
+
+// A setting looked up once, reads after the first one cost a pointer instead of a map lookup. Meant for settings
+// read every frame or for every file, kept as a static or a member. Only for settings which have a default
+template<typename T>
+class Setting
+{
+public:
+	explicit Setting(const std::string& _name) : mName(_name), mValue(nullptr), mLast(), mChangeCount(0), mHasLast(false) { }
+
+	const T& get()
+	{
+		const T* value = mValue.load(std::memory_order_relaxed);
+
+		if(!value)
+		{
+			value = Settings::getInstance()->find<T>(mName);
+			mValue.store(value, std::memory_order_relaxed);
+		}
+
+		return *value;
+
+	} // get
+
+	// True when the value differs from what it was on the last call, the first call only remembers it
+	bool changed()
+	{
+		if(mHasLast && (mChangeCount == Settings::getChangeCount()))
+			return false;
+
+		mChangeCount = Settings::getChangeCount();
+
+		const T&   value   = get();
+		const bool changed = mHasLast && (value != mLast);
+
+		mLast    = value;
+		mHasLast = true;
+
+		return changed;
+
+	} // changed
+
+private:
+
+	const std::string     mName;
+	std::atomic<const T*> mValue;
+	T                     mLast;
+	unsigned int          mChangeCount;
+	bool                  mHasLast;
+
+}; // Setting
+
 #endif // ES_CORE_SETTINGS_H
@@ -1,9 +1,19 @@
 #include "Sound.h"
 
+#include "utils/BinaryUtil.h"
+#include "utils/FileSystemUtil.h"
 #include "AudioManager.h"
 #include "Log.h"
 #include "Settings.h"
 #include "ThemeData.h"
+#include <stdint.h>
+#include <string.h>
+#include <functional>
+#include <iomanip>
+#include <sstream>
+
+static const char     CACHE_MAGIC[4] = { 'E', 'S', 'S', 'D' };
+static const uint32_t CACHE_VERSION  = 1;
 
 std::map< std::string, std::shared_ptr<Sound> > Sound::sMap;
 
@@ -13,8 +23,19 @@ std::shared_ptr<Sound> Sound::get(const std::string& path)
 	if(it != sMap.cend())
 		return it->second;
 
-	std::shared_ptr<Sound> sound = std::shared_ptr<Sound>(new Sound(path));
+	//the themes of the systems reach the same file through different paths, those share one sample
+	const std::string canonicalPath = path.empty() ? path : Utils::FileSystem::getCanonicalPath(path);
+
+	it = sMap.find(canonicalPath);
+	if(it != sMap.cend())
+	{
+		sMap[path] = it->second;
+		return it->second;
+	}
+
+	std::shared_ptr<Sound> sound = std::shared_ptr<Sound>(new Sound(canonicalPath));
 	AudioManager::getInstance()->registerSound(sound);
+	sMap[canonicalPath] = sound;
 	sMap[path] = sound;
 	return sound;
 }
@@ -33,7 +54,7 @@ std::shared_ptr<Sound> Sound::getFromTheme(const std::shared_ptr<ThemeData>& the
 	return get(elem->get<std::string>("path"));
 }
 
-Sound::Sound(const std::string & path) : mSampleData(NULL), mSamplePos(0), mSampleLength(0), playing(false)
+Sound::Sound(const std::string & path) : mSampleData(NULL), mSampleLength(0), mPlaying(false)
 {
 	loadFile(path);
 }
@@ -57,6 +78,10 @@ void Sound::init()
 	if(mPath.empty())
 		return;
 
+	//converted before, skip decoding and converting the wav file
+	if(loadCache())
+		return;
+
 	//load wav file via SDL
 	SDL_AudioSpec wave;
 	Uint8 * data = NULL;
@@ -78,32 +103,98 @@ void Sound::init()
 		delete[] cvt.buf;
 	}
 	else {
-		//worked. set up member data
-		SDL_LockAudio();
+		//worked. set up member data, the mixer only sees it once the sound is played
 		mSampleData = cvt.buf;
 		mSampleLength = cvt.len_cvt;
-		mSamplePos = 0;
 		mSampleFormat.channels = 2;
 		mSampleFormat.freq = 44100;
 		mSampleFormat.format = AUDIO_S16;
-		SDL_UnlockAudio();
+
+		//a file already in the mixer format loads just as fast without the cache
+		if(cvt.needed)
+			saveCache();
 	}
 	//free wav data now
     SDL_FreeWAV(data);
 }
 
+bool Sound::loadCache()
+{
+	if(!Settings::getInstance()->getBool("CacheSounds"))
+		return false;
+
+	std::string buffer;
+
+	if(!Utils::Binary::loadFile(getCachePath(), buffer))
+		return false;
+
+	Utils::Binary::Reader reader(buffer);
+	char magic[4];
+	uint32_t version;
+	std::string cachedPath;
+	int64_t cachedSize;
+	int64_t cachedTime;
+	uint32_t cachedLength;
+
+	if(!reader.read(magic, sizeof(magic)) || memcmp(magic, CACHE_MAGIC, sizeof(magic)) ||
+		!reader.read(version) || (version != CACHE_VERSION) ||
+		!reader.readString(cachedPath) || !reader.read(cachedSize) || !reader.read(cachedTime) ||
+		!reader.read(cachedLength) || (cachedLength == 0) || (cachedLength != reader.getRemaining()))
+		return false;
+
+	//another sound with the same hash or a changed sound
+	if((cachedPath != mPath) ||
+		(cachedSize != Utils::FileSystem::getFileSize(mPath)) || (cachedTime != (int64_t)Utils::FileSystem::getModifiedTime(mPath)))
+		return false;
+
+	mSampleData = new Uint8[cachedLength];
+	reader.read(mSampleData, cachedLength);
+	mSampleLength = cachedLength;
+	mSampleFormat.channels = 2;
+	mSampleFormat.freq = 44100;
+	mSampleFormat.format = AUDIO_S16;
+
+	return true;
+}
+
+void Sound::saveCache() const
+{
+	if(!Settings::getInstance()->getBool("CacheSounds"))
+		return;
+
+	Utils::Binary::Writer writer;
+
+	writer.write(CACHE_MAGIC, sizeof(CACHE_MAGIC));
+	writer.write(CACHE_VERSION);
+	writer.writeString(mPath);
+	writer.write((int64_t)Utils::FileSystem::getFileSize(mPath));
+	writer.write((int64_t)Utils::FileSystem::getModifiedTime(mPath));
+	writer.write((uint32_t)mSampleLength);
+	writer.write(mSampleData, mSampleLength);
+
+	if(!Utils::Binary::saveFile(getCachePath(), writer.getBuffer()))
+		LOG(LogWarning) << "Could not save converted copy of sound \"" << mPath << "\"";
+}
+
+std::string Sound::getCachePath() const
+{
+	std::stringstream ss;
+	ss << std::hex << std::setw(16) << std::setfill('0') << (uint64_t)std::hash<std::string>()(mPath);
+
+	return Utils::FileSystem::getHomePath() + "/.emulationstation/sound_cache/" + ss.str() + ".pcm";
+}
+
 void Sound::deinit()
 {
-	playing = false;
+	mPlaying = false;
 
 	if(mSampleData != NULL)
 	{
-		SDL_LockAudio();
+		//the mixer must be done with the data before it goes
+		AudioManager::removeSound(this);
 		delete[] mSampleData;
 		mSampleData = NULL;
 		mSampleLength = 0;
-		mSamplePos = 0;
-		SDL_UnlockAudio();
 	}
 }
 
@@ -115,37 +206,26 @@ void Sound::play()
 	if(!Settings::getInstance()->getBool("EnableSounds"))
 		return;
 
-	AudioManager::getInstance();
+	//flag our sample as playing, the mixer rewinds it when it already is
+	mPlaying = true;
 
-	SDL_LockAudio();
-	if (playing)
-	{
-		//replay from start. rewind the sample to the beginning
-		mSamplePos = 0;
-
-	}
-	else
-	{
-		//flag our sample as playing
-		playing = true;
-	}
-	SDL_UnlockAudio();
-	//tell the AudioManager to start playing samples
-	AudioManager::getInstance()->play();
+	//tell the AudioManager to start playing the sample
+	AudioManager::getInstance()->playSound(this);
 }
 
 bool Sound::isPlaying() const
 {
-	return playing;
+	return mPlaying;
 }
 
 void Sound::stop()
 {
-	//flag our sample as playing and rewind its position
-	SDL_LockAudio();
-	playing = false;
-	mSamplePos = 0;
-	SDL_UnlockAudio();
+	if(!mPlaying)
+		return;
+
+	//flag our sample as not playing, the mixer drops it with the next buffer
+	mPlaying = false;
+	AudioManager::stopSound(this);
 }
 
 const Uint8 * Sound::getData() const
@@ -153,21 +233,6 @@ const Uint8 * Sound::getData() const
 	return mSampleData;
 }
 
-Uint32 Sound::getPosition() const
-{
-	return mSamplePos;
-}
-
-void Sound::setPosition(Uint32 newPosition)
-{
-	mSamplePos = newPosition;
-	if (mSamplePos >= mSampleLength) {
-		//got to or beyond the end of the sample. stop playing
-		playing = false;
-		mSamplePos = 0;
-	}
-}
-
 Uint32 Sound::getLength() const
 {
 	return mSampleLength;
@@ -3,6 +3,7 @@
 #define ES_CORE_SOUND_H
 
 #include "SDL_audio.h"
+#include <atomic>
 #include <map>
 #include <memory>
 #include <string>
@@ -11,12 +12,13 @@ class ThemeData;
 
 class Sound
 {
+	friend class AudioManager;
+
 	std::string mPath;
     SDL_AudioSpec mSampleFormat;
 	Uint8 * mSampleData;
-    Uint32 mSamplePos;
     Uint32 mSampleLength;
-	bool playing;
+	std::atomic<bool> mPlaying; // cleared by the mixer once the sample ended
 
 public:
 	static std::shared_ptr<Sound> get(const std::string& path);
@@ -34,13 +36,17 @@ public:
 	void stop();
 
 	const Uint8 * getData() const;
-	Uint32 getPosition() const;
-	void setPosition(Uint32 newPosition);
 	Uint32 getLength() const;
 	Uint32 getLengthMS() const;
 
 private:
 	Sound(const std::string & path = "");
+
+	// Samples converted to the mixer format, kept next to the other caches in ~/.emulationstation/
+	bool loadCache();
+	void saveCache() const;
+	std::string getCachePath() const;
+
 	static std::map< std::string, std::shared_ptr<Sound> > sMap;
 };
 
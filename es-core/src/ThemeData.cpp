@@ -2,13 +2,22 @@
 
 #include "components/ImageComponent.h"
 #include "components/TextComponent.h"
+#include "resources/ResourceArchive.h"
+#include "utils/BinaryUtil.h"
 #include "utils/FileSystemUtil.h"
 #include "utils/StringUtil.h"
 #include "Log.h"
+#include "MemoryUsage.h"
 #include "platform.h"
 #include "Settings.h"
 #include <pugixml.hpp>
+#include <assert.h>
+#include <stdint.h>
+#include <string.h>
 #include <algorithm>
+#include <functional>
+#include <iomanip>
+#include <mutex>
 
 std::vector<std::string> ThemeData::sSupportedViews { { "system" }, { "basic" }, { "detailed" }, { "grid" }, { "video" } };
 std::vector<std::string> ThemeData::sSupportedFeatures { { "video" }, { "carousel" }, { "z-index" }, { "visible" } };
@@ -219,35 +228,203 @@ std::string ThemeData::resolvePlaceholders(const char* in)
 	return prefix + mVariables[replace] + suffix;
 }
 
+// the ids are handed out once, from then on the tables are only read, from any thread
+struct PropertyKeys
+{
+	std::unordered_map<std::string, unsigned int> ids;
+	std::vector<std::string> names;
+};
+
+static const PropertyKeys& getPropertyKeys(const std::map< std::string, std::map<std::string, ThemeData::ElementPropertyType> >& elementMap)
+{
+	static const PropertyKeys keys = [&elementMap]
+	{
+		PropertyKeys k;
+		for(auto element = elementMap.cbegin(); element != elementMap.cend(); element++)
+		{
+			for(auto property = element->second.cbegin(); property != element->second.cend(); property++)
+			{
+				if(k.ids.insert(std::make_pair(property->first, (unsigned int)k.names.size())).second)
+					k.names.push_back(property->first);
+			}
+		}
+		return k;
+	}();
+
+	return keys;
+}
+
+unsigned int ThemeData::getPropertyId(const std::string& name)
+{
+	const PropertyKeys& keys = getPropertyKeys(sElementMap);
+	auto it = keys.ids.find(name);
+
+	return (it != keys.ids.cend()) ? it->second : INVALID_PROPERTY_ID;
+}
+
+const std::string& ThemeData::getPropertyName(unsigned int id)
+{
+	return getPropertyKeys(sElementMap).names.at(id);
+}
+
+static bool comparePropertyId(const std::pair<unsigned int, ThemeData::ThemeElement::Property>& property, unsigned int id)
+{
+	return property.first < id;
+}
+
+const ThemeData::ThemeElement::Property* ThemeData::ThemeElement::find(const std::string& prop) const
+{
+	const unsigned int id = getPropertyId(prop);
+	auto it = std::lower_bound(properties.cbegin(), properties.cend(), id, comparePropertyId);
+
+	return ((it != properties.cend()) && (it->first == id)) ? &it->second : nullptr;
+}
+
+const ThemeData::ThemeElement::Property& ThemeData::ThemeElement::at(const std::string& prop) const
+{
+	const Property* property = find(prop);
+	if(!property)
+		throw std::out_of_range("ThemeElement::at");
+
+	return *property;
+}
+
+ThemeData::ThemeElement::Property& ThemeData::ThemeElement::add(const std::string& prop)
+{
+	const unsigned int id = getPropertyId(prop);
+	assert(id != INVALID_PROPERTY_ID);
+
+	auto it = std::lower_bound(properties.begin(), properties.end(), id, comparePropertyId);
+	if((it == properties.end()) || (it->first != id))
+		it = properties.insert(it, std::make_pair(id, Property()));
+
+	return it->second;
+}
+
+// systems load their themes on several threads at once
+struct ThemeDocument
+{
+	std::shared_ptr<const pugi::xml_document> document;
+	int64_t modified;
+	int64_t size;
+};
+
+static std::map<std::string, ThemeDocument> sDocumentCache;
+static std::mutex sDocumentCacheMutex;
+
+std::shared_ptr<const pugi::xml_document> ThemeData::getDocument(const std::string& path)
+{
+	ThemeException error;
+	error.setFiles(mPaths);
+
+	int64_t size, modified;
+	ResourceManager::getInstance()->getFileStats(path, size, modified);
+
+	if(std::find(mSourceFiles.cbegin(), mSourceFiles.cend(), path) == mSourceFiles.cend())
+		mSourceFiles.push_back(path);
+
+	{
+		const std::unique_lock<std::mutex> lock(sDocumentCacheMutex);
+		auto it = sDocumentCache.find(path);
+		if((it != sDocumentCache.cend()) && (it->second.modified == modified) && (it->second.size == size))
+			return it->second.document;
+	}
+
+	// parsed outside of the lock, two threads parsing the same file at once only costs the time
+	std::shared_ptr<pugi::xml_document> document = std::make_shared<pugi::xml_document>();
+	const ResourceData data = ResourceManager::getInstance()->getFileData(path);
+	pugi::xml_parse_result result = document->load_buffer(data.ptr.get(), data.length);
+	if(!result)
+		throw error << "XML parsing error: \n    " << result.description();
+
+	const std::unique_lock<std::mutex> lock(sDocumentCacheMutex);
+	sDocumentCache[path] = { document, modified, size };
+
+	return document;
+}
+
+void ThemeData::clearCache()
+{
+	const std::unique_lock<std::mutex> lock(sDocumentCacheMutex);
+	sDocumentCache.clear();
+}
+
 ThemeData::ThemeData()
 {
 	mVersion = 0;
 	mResolution = { 1, 1 };
+	mCountedBytes = 0;
+}
+
+ThemeData::~ThemeData()
+{
+	MemoryUsage::remove(MemoryUsage::THEMES, mCountedBytes);
+}
+
+void ThemeData::countMemory()
+{
+	// the entries of a map or unordered_map are nodes, with about two pointers next to the value
+	const size_t nodeSize = 2 * sizeof(void*);
+	size_t total = 0;
+
+	for(auto view = mViews.cbegin(); view != mViews.cend(); view++)
+	{
+		total += sizeof(*view) + nodeSize + Utils::String::getHeapSize(view->first);
+
+		for(auto elem = view->second.elements.cbegin(); elem != view->second.elements.cend(); elem++)
+		{
+			total += sizeof(*elem) + nodeSize + Utils::String::getHeapSize(elem->first) + Utils::String::getHeapSize(elem->second.type);
+			total += elem->second.properties.capacity() * sizeof(elem->second.properties[0]);
+
+			for(auto prop = elem->second.properties.cbegin(); prop != elem->second.properties.cend(); prop++)
+				total += Utils::String::getHeapSize(prop->second.s);
+		}
+
+		total += view->second.orderedKeys.capacity() * sizeof(std::string);
+		for(auto key = view->second.orderedKeys.cbegin(); key != view->second.orderedKeys.cend(); key++)
+			total += Utils::String::getHeapSize(*key);
+	}
+
+	for(auto var = mVariables.cbegin(); var != mVariables.cend(); var++)
+		total += sizeof(*var) + nodeSize + Utils::String::getHeapSize(var->first) + Utils::String::getHeapSize(var->second);
+
+	MemoryUsage::remove(MemoryUsage::THEMES, mCountedBytes);
+	MemoryUsage::add(MemoryUsage::THEMES, total);
+	mCountedBytes = total;
 }
 
 void ThemeData::loadFile(std::map<std::string, std::string> sysDataMap, const std::string& path)
 {
+	// what was loaded when this returns or throws is counted, a theme loaded again replaces its last count
+	struct CountOnExit
+	{
+		ThemeData* theme;
+		~CountOnExit() { theme->countMemory(); }
+	} countOnExit = { this };
+
 	mPaths.push_back(path);
 
 	ThemeException error;
 	error.setFiles(mPaths);
 
-	if(!Utils::FileSystem::exists(path))
+	if(!ResourceManager::getInstance()->fileExists(path))
 		throw error << "File does not exist!";
 
 	mVersion = 0;
 	mResolution = { 1, 1 };
 	mViews.clear();
 	mVariables.clear();
+	mSourceFiles.clear();
 
 	mVariables.insert(sysDataMap.cbegin(), sysDataMap.cend());
 
-	pugi::xml_document doc;
-	pugi::xml_parse_result res = doc.load_file(path.c_str());
-	if(!res)
-		throw error << "XML parsing error: \n    " << res.description();
+	const bool compile = Settings::getInstance()->getBool("CompileThemes");
+	if(compile && loadCompiled(sysDataMap, path))
+		return;
+
+	std::shared_ptr<const pugi::xml_document> doc = getDocument(path);
 
-	pugi::xml_node root = doc.child("theme");
+	pugi::xml_node root = doc->child("theme");
 	if(!root)
 		throw error << "Missing <theme> tag!";
 
@@ -280,6 +457,273 @@ void ThemeData::loadFile(std::map<std::string, std::string> sysDataMap, const st
 	parseIncludes(root);
 	parseViews(root);
 	parseFeatures(root);
+
+	if(compile)
+		saveCompiled(sysDataMap, path);
+}
+
+static const char     COMPILED_MAGIC[4] = { 'E', 'S', 'T', 'H' };
+static const uint32_t COMPILED_VERSION  = 1;
+
+bool ThemeData::loadCompiled(const std::map<std::string, std::string>& sysDataMap, const std::string& path)
+{
+	std::string buffer;
+
+	if(!Utils::Binary::loadFile(getCompiledPath(sysDataMap, path), buffer))
+		return false;
+
+	Utils::Binary::Reader reader(buffer);
+	char magic[4];
+	uint32_t version;
+	std::string cachedPath;
+	uint32_t count;
+
+	if(!reader.read(magic, sizeof(magic)) || memcmp(magic, COMPILED_MAGIC, sizeof(magic)) ||
+		!reader.read(version) || (version != COMPILED_VERSION) ||
+		!reader.readString(cachedPath) || (cachedPath != path) || !reader.read(count) || (count != sysDataMap.size()))
+		return false;
+
+	// another theme or system with the same hash
+	for(auto it = sysDataMap.cbegin(); it != sysDataMap.cend(); it++)
+	{
+		std::string key, value;
+		if(!reader.readString(key) || !reader.readString(value) || (key != it->first) || (value != it->second))
+			return false;
+	}
+
+	// any file the theme was parsed from changed
+	std::vector<std::string> sourceFiles;
+	if(!reader.read(count))
+		return false;
+	for(uint32_t i = 0; i < count; i++)
+	{
+		std::string file;
+		int64_t size, modified, fileSize, fileModified;
+		if(!reader.readString(file) || !reader.read(size) || !reader.read(modified))
+			return false;
+		ResourceManager::getInstance()->getFileStats(file, fileSize, fileModified);
+		if((size != fileSize) || (modified != fileModified))
+			return false;
+		sourceFiles.push_back(file);
+	}
+
+	float cachedVersion;
+	float resolutionX, resolutionY;
+	std::unordered_map<std::string, ThemeView> views;
+
+	if(!reader.read(cachedVersion) || !reader.read(resolutionX) || !reader.read(resolutionY) || !reader.read(count))
+		return false;
+
+	for(uint32_t v = 0; v < count; v++)
+	{
+		std::string viewName;
+		uint32_t keyCount, elementCount;
+
+		if(!reader.readString(viewName) || !reader.read(keyCount))
+			return false;
+
+		ThemeView& view = views[viewName];
+		for(uint32_t k = 0; k < keyCount; k++)
+		{
+			std::string key;
+			if(!reader.readString(key))
+				return false;
+			view.orderedKeys.push_back(key);
+		}
+
+		if(!reader.read(elementCount))
+			return false;
+
+		for(uint32_t e = 0; e < elementCount; e++)
+		{
+			std::string elementName;
+			uint8_t extra;
+			uint32_t propertyCount;
+
+			if(!reader.readString(elementName))
+				return false;
+
+			ThemeElement& element = view.elements[elementName];
+			if(!reader.readString(element.type) || !reader.read(extra) || !reader.read(propertyCount))
+				return false;
+			element.extra = (extra != 0);
+
+			auto typeMap = sElementMap.find(element.type);
+			if(typeMap == sElementMap.cend())
+				return false;
+
+			for(uint32_t p = 0; p < propertyCount; p++)
+			{
+				std::string propertyName;
+				if(!reader.readString(propertyName))
+					return false;
+
+				auto type = typeMap->second.find(propertyName);
+				if(type == typeMap->second.cend())
+					return false;
+
+				ThemeElement::Property& property = element.add(propertyName);
+				bool ok;
+
+				switch(type->second)
+				{
+				case RESOLUTION_RECT:
+				case NORMALIZED_RECT:
+				{
+					float r[4];
+					ok = reader.read(r, sizeof(r));
+					property = Vector4f(r[0], r[1], r[2], r[3]);
+					break;
+				}
+				case RESOLUTION_PAIR:
+				case NORMALIZED_PAIR:
+				{
+					float v[2];
+					ok = reader.read(v, sizeof(v));
+					property = Vector2f(v[0], v[1]);
+					break;
+				}
+				case RESOLUTION_FLOAT:
+				case FLOAT:
+					ok = reader.read(property.f);
+					break;
+				case PATH:
+				case STRING:
+					ok = reader.readString(property.s);
+					break;
+				case COLOR:
+				{
+					uint32_t color;
+					ok = reader.read(color);
+					property = (unsigned int)color;
+					break;
+				}
+				case BOOLEAN:
+				{
+					uint8_t b;
+					ok = reader.read(b);
+					property = (b != 0);
+					break;
+				}
+				default:
+					ok = false;
+					break;
+				}
+
+				if(!ok)
+					return false;
+			}
+		}
+	}
+
+	mVersion = cachedVersion;
+	mResolution = Vector2f(resolutionX, resolutionY);
+	mViews.swap(views);
+	mSourceFiles.swap(sourceFiles);
+
+	return true;
+}
+
+void ThemeData::saveCompiled(const std::map<std::string, std::string>& sysDataMap, const std::string& path) const
+{
+	Utils::Binary::Writer writer;
+
+	writer.write(COMPILED_MAGIC, sizeof(COMPILED_MAGIC));
+	writer.write(COMPILED_VERSION);
+	writer.writeString(path);
+	writer.write((uint32_t)sysDataMap.size());
+	for(auto it = sysDataMap.cbegin(); it != sysDataMap.cend(); it++)
+	{
+		writer.writeString(it->first);
+		writer.writeString(it->second);
+	}
+
+	writer.write((uint32_t)mSourceFiles.size());
+	for(auto it = mSourceFiles.cbegin(); it != mSourceFiles.cend(); it++)
+	{
+		int64_t size, modified;
+		ResourceManager::getInstance()->getFileStats(*it, size, modified);
+		writer.writeString(*it);
+		writer.write(size);
+		writer.write(modified);
+	}
+
+	writer.write(mVersion);
+	writer.write(mResolution.x());
+	writer.write(mResolution.y());
+	writer.write((uint32_t)mViews.size());
+
+	for(auto view = mViews.cbegin(); view != mViews.cend(); view++)
+	{
+		writer.writeString(view->first);
+		writer.write((uint32_t)view->second.orderedKeys.size());
+		for(auto key = view->second.orderedKeys.cbegin(); key != view->second.orderedKeys.cend(); key++)
+			writer.writeString(*key);
+
+		writer.write((uint32_t)view->second.elements.size());
+		for(auto element = view->second.elements.cbegin(); element != view->second.elements.cend(); element++)
+		{
+			writer.writeString(element->first);
+			writer.writeString(element->second.type);
+			writer.write((uint8_t)(element->second.extra ? 1 : 0));
+			writer.write((uint32_t)element->second.properties.size());
+
+			// only the field the property type uses is stored
+			const std::map<std::string, ElementPropertyType>& typeMap = sElementMap.at(element->second.type);
+			for(auto property = element->second.properties.cbegin(); property != element->second.properties.cend(); property++)
+			{
+				const std::string& propertyName = getPropertyName(property->first);
+				writer.writeString(propertyName);
+
+				switch(typeMap.at(propertyName))
+				{
+				case RESOLUTION_RECT:
+				case NORMALIZED_RECT:
+				{
+					const float r[4] = { property->second.r.x(), property->second.r.y(), property->second.r.z(), property->second.r.w() };
+					writer.write(r, sizeof(r));
+					break;
+				}
+				case RESOLUTION_PAIR:
+				case NORMALIZED_PAIR:
+				{
+					const float v[2] = { property->second.v.x(), property->second.v.y() };
+					writer.write(v, sizeof(v));
+					break;
+				}
+				case RESOLUTION_FLOAT:
+				case FLOAT:
+					writer.write(property->second.f);
+					break;
+				case PATH:
+				case STRING:
+					writer.writeString(property->second.s);
+					break;
+				case COLOR:
+					writer.write((uint32_t)property->second.i);
+					break;
+				case BOOLEAN:
+					writer.write((uint8_t)(property->second.b ? 1 : 0));
+					break;
+				}
+			}
+		}
+	}
+
+	if(!Utils::Binary::saveFile(getCompiledPath(sysDataMap, path), writer.getBuffer()))
+		LOG(LogWarning) << "Could not save compiled theme \"" << path << "\"";
+}
+
+std::string ThemeData::getCompiledPath(const std::map<std::string, std::string>& sysDataMap, const std::string& path)
+{
+	std::string key = path;
+	for(auto it = sysDataMap.cbegin(); it != sysDataMap.cend(); it++)
+		key += "|" + it->first + "=" + it->second;
+
+	std::stringstream ss;
+	ss << std::hex << std::setw(16) << std::setfill('0') << (uint64_t)std::hash<std::string>()(key);
+
+	return Utils::FileSystem::getHomePath() + "/.emulationstation/theme_cache/" + ss.str() + ".bin";
 }
 
 void ThemeData::parseIncludes(const pugi::xml_node& root)
@@ -298,12 +742,9 @@ void ThemeData::parseIncludes(const pugi::xml_node& root)
 
 		mPaths.push_back(path);
 
-		pugi::xml_document includeDoc;
-		pugi::xml_parse_result result = includeDoc.load_file(path.c_str());
-		if(!result)
-			throw error << "Error parsing file: \n    " << result.description();
+		std::shared_ptr<const pugi::xml_document> includeDoc = getDocument(path);
 
-		pugi::xml_node theme = includeDoc.child("theme");
+		pugi::xml_node theme = includeDoc->child("theme");
 		if(!theme)
 			throw error << "Missing <theme> tag!";
 
@@ -454,7 +895,7 @@ void ThemeData::parseElement(const pugi::xml_node& root, const std::map<std::str
 					(float)atof(splits.at(2).c_str()), (float)atof(splits.at(3).c_str()));
 			}
 
-			element.properties[node.name()] = val / Vector4f(mResolution.x(), mResolution.y(), mResolution.x(), mResolution.y());
+			element.add(node.name()) = val / Vector4f(mResolution.x(), mResolution.y(), mResolution.x(), mResolution.y());
 			break;
 		}
 		case RESOLUTION_PAIR:
@@ -468,13 +909,13 @@ void ThemeData::parseElement(const pugi::xml_node& root, const std::map<std::str
 
 			Vector2f val((float)atof(first.c_str()), (float)atof(second.c_str()));
 
-			element.properties[node.name()] = val / mResolution;
+			element.add(node.name()) = val / mResolution;
 			break;
 		}
 		case RESOLUTION_FLOAT:
 		{
 			float val = static_cast<float>(strtod(str.c_str(), 0));
-			element.properties[node.name()] = val / mResolution.y();
+			element.add(node.name()) = val / mResolution.y();
 			break;
 		}
 		case NORMALIZED_RECT:
@@ -493,7 +934,7 @@ void ThemeData::parseElement(const pugi::xml_node& root, const std::map<std::str
 					(float)atof(splits.at(2).c_str()), (float)atof(splits.at(3).c_str()));
 			}
 
-			element.properties[node.name()] = val;
+			element.add(node.name()) = val;
 			break;
 		}
 		case NORMALIZED_PAIR:
@@ -507,11 +948,11 @@ void ThemeData::parseElement(const pugi::xml_node& root, const std::map<std::str
 
 			Vector2f val((float)atof(first.c_str()), (float)atof(second.c_str()));
 
-			element.properties[node.name()] = val;
+			element.add(node.name()) = val;
 			break;
 		}
 		case STRING:
-			element.properties[node.name()] = str;
+			element.add(node.name()) = str;
 			break;
 		case PATH:
 		{
@@ -525,16 +966,16 @@ void ThemeData::parseElement(const pugi::xml_node& root, const std::map<std::str
 					ss << "(which resolved to \"" << path << "\") ";
 				LOG(LogWarning) << ss.str();
 			}
-			element.properties[node.name()] = path;
+			element.add(node.name()) = path;
 			break;
 		}
 		case COLOR:
-			element.properties[node.name()] = getHexColor(str.c_str());
+			element.add(node.name()) = getHexColor(str.c_str());
 			break;
 		case FLOAT:
 		{
 			float floatVal = static_cast<float>(strtod(str.c_str(), 0));
-			element.properties[node.name()] = floatVal;
+			element.add(node.name()) = floatVal;
 			break;
 		}
 
@@ -545,7 +986,7 @@ void ThemeData::parseElement(const pugi::xml_node& root, const std::map<std::str
 			// 1*, t* (true), T* (True), y* (yes), Y* (YES)
 			bool boolVal = (first == '1' || first == 't' || first == 'T' || first == 'y' || first == 'Y');
 
-			element.properties[node.name()] = boolVal;
+			element.add(node.name()) = boolVal;
 			break;
 		}
 		default:
@@ -579,6 +1020,25 @@ const ThemeData::ThemeElement* ThemeData::getElement(const std::string& view, co
 	return &elemIt->second;
 }
 
+std::vector<std::string> ThemeData::getViewNames() const
+{
+	std::vector<std::string> names;
+	for(auto it = mViews.cbegin(); it != mViews.cend(); ++it)
+		names.push_back(it->first);
+
+	std::sort(names.begin(), names.end());
+	return names;
+}
+
+std::vector<std::string> ThemeData::getElementNames(const std::string& view) const
+{
+	auto viewIt = mViews.find(view);
+	if(viewIt == mViews.cend())
+		return std::vector<std::string>();
+
+	return viewIt->second.orderedKeys;
+}
+
 const std::shared_ptr<ThemeData>& ThemeData::getDefault()
 {
 	static std::shared_ptr<ThemeData> theme = nullptr;
@@ -620,7 +1080,13 @@ std::vector<GuiComponent*> ThemeData::makeExtras(const std::shared_ptr<ThemeData
 			GuiComponent* comp = NULL;
 			const std::string& t = elem.type;
 			if(t == "image")
-				comp = new ImageComponent(window);
+			{
+				// extras of systems not on screen don't load anything, the ones that are only read the image size up front
+				ImageComponent* image = new ImageComponent(window);
+				image->setDeferLoad(true);
+				image->setAsyncLoad(true);
+				comp = image;
+			}
 			else if(t == "text")
 				comp = new TextComponent(window);
 
@@ -658,6 +1124,13 @@ std::map<std::string, ThemeSet> ThemeData::getThemeSets()
 				ThemeSet set = {*it};
 				sets[set.getName()] = set;
 			}
+			else if(Utils::FileSystem::getExtension(*it) == ResourceArchive::EXTENSION)
+			{
+				// a packed theme stands in for the directory it was packed from, its files win over loose ones there
+				ThemeSet set = {it->substr(0, it->size() - strlen(ResourceArchive::EXTENSION))};
+				if(ResourceManager::getInstance()->mountArchive(set.path, *it))
+					sets[set.getName()] = set;
+			}
 		}
 	}
 
@@ -9,9 +9,10 @@
 #include <map>
 #include <memory>
 #include <sstream>
+#include <unordered_map>
 #include <vector>
 
-namespace pugi { class xml_node; }
+namespace pugi { class xml_document; class xml_node; }
 
 template<typename T>
 class TextListComponent;
@@ -110,34 +111,50 @@ public:
 			bool         b;
 		};
 
-		std::map< std::string, Property > properties;
+		// Property names are turned into ids once, the few properties of an element are kept sorted by id
+		std::vector< std::pair<unsigned int, Property> > properties;
 
 		template<typename T>
 		const T get(const std::string& prop) const
 		{
-			if(     std::is_same<T, Vector2f>::value)     return *(const T*)&properties.at(prop).v;
-			else if(std::is_same<T, std::string>::value)  return *(const T*)&properties.at(prop).s;
-			else if(std::is_same<T, unsigned int>::value) return *(const T*)&properties.at(prop).i;
-			else if(std::is_same<T, float>::value)        return *(const T*)&properties.at(prop).f;
-			else if(std::is_same<T, bool>::value)         return *(const T*)&properties.at(prop).b;
-			else if(std::is_same<T, Vector4f>::value)     return *(const T*)&properties.at(prop).r;
+			const Property& property = at(prop);
+
+			if(     std::is_same<T, Vector2f>::value)     return *(const T*)&property.v;
+			else if(std::is_same<T, std::string>::value)  return *(const T*)&property.s;
+			else if(std::is_same<T, unsigned int>::value) return *(const T*)&property.i;
+			else if(std::is_same<T, float>::value)        return *(const T*)&property.f;
+			else if(std::is_same<T, bool>::value)         return *(const T*)&property.b;
+			else if(std::is_same<T, Vector4f>::value)     return *(const T*)&property.r;
 			return T();
 		}
 
-		inline bool has(const std::string& prop) const { return (properties.find(prop) != properties.cend()); }
+		inline bool has(const std::string& prop) const { return (find(prop) != nullptr); }
+
+		const Property* find(const std::string& prop) const;
+		// throws std::out_of_range when the element doesn't have prop
+		const Property& at(const std::string& prop) const;
+		// the property named prop, added when the element doesn't have it yet
+		Property& add(const std::string& prop);
 	};
 
+	// Every property name known to sElementMap has an id, INVALID_PROPERTY_ID for any other name
+	static unsigned int getPropertyId(const std::string& name);
+	static const std::string& getPropertyName(unsigned int id);
+	static const unsigned int INVALID_PROPERTY_ID = (unsigned int)-1;
+
 private:
 	class ThemeView
 	{
 	public:
-		std::map<std::string, ThemeElement> elements;
+		std::unordered_map<std::string, ThemeElement> elements;
 		std::vector<std::string> orderedKeys;
 	};
 
 public:
 
 	ThemeData();
+	ThemeData(const ThemeData&) = delete;
+	~ThemeData();
 
 	// throws ThemeException
 	void loadFile(std::map<std::string, std::string> sysDataMap, const std::string& path);
@@ -161,10 +178,18 @@ public:
 	// If expectedType is an empty string, will do no type checking.
 	const ThemeElement* getElement(const std::string& view, const std::string& element, const std::string& expectedType) const;
 
+	// the views the theme has, and the elements of one in the order they were parsed
+	std::vector<std::string> getViewNames() const;
+	std::vector<std::string> getElementNames(const std::string& view) const;
+
 	static std::vector<GuiComponent*> makeExtras(const std::shared_ptr<ThemeData>& theme, const std::string& view, Window* window);
 
 	static const std::shared_ptr<ThemeData>& getDefault();
 
+	// Every system parses the same theme files, each file is only read once as long as it doesn't change.
+	// The variables are still resolved per system while the elements are parsed. Drops the parsed files.
+	static void clearCache();
+
 	static std::map<std::string, ThemeSet> getThemeSets();
 	static std::string getThemeFromCurrentSet(const std::string& system);
 
@@ -173,7 +198,17 @@ private:
 	static std::vector<std::string> sSupportedFeatures;
 	static std::vector<std::string> sSupportedViews;
 
+	// the parsed file at path, shared by all themes loading it, throws ThemeException
+	std::shared_ptr<const pugi::xml_document> getDocument(const std::string& path);
+
+	// With "CompileThemes" the resolved views are kept on disk per theme and system variables, so loading a theme
+	// takes no XML at all while none of the files it was parsed from changed
+	bool loadCompiled(const std::map<std::string, std::string>& sysDataMap, const std::string& path);
+	void saveCompiled(const std::map<std::string, std::string>& sysDataMap, const std::string& path) const;
+	static std::string getCompiledPath(const std::map<std::string, std::string>& sysDataMap, const std::string& path);
+
 	std::deque<std::string> mPaths;
+	std::vector<std::string> mSourceFiles; // every file the theme was parsed from
 	float mVersion;
 	Vector2f mResolution;
 
@@ -184,10 +219,14 @@ private:
 	void parseView(const pugi::xml_node& viewNode, ThemeView& view);
 	void parseElement(const pugi::xml_node& elementNode, const std::map<std::string, ElementPropertyType>& typeMap, ThemeElement& element);
 
-	std::map<std::string, ThemeView> mViews;
+	std::unordered_map<std::string, ThemeView> mViews;
 
 	std::string resolvePlaceholders(const char* in);
 	std::map<std::string, std::string> mVariables;
+
+	// estimates what the views and variables hold and counts it in MemoryUsage::THEMES instead of the last estimate
+	void countMemory();
+	size_t mCountedBytes;
 };
 
 #endif // ES_CORE_THEME_DATA_H
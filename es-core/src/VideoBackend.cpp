@@ -0,0 +1,149 @@
+#include "VideoBackend.h"
+
+#include "components/VideoVlcComponent.h"
+#ifdef _OMX_
+#include "components/VideoPlayerComponent.h"
+#endif
+#include "utils/FileSystemUtil.h"
+#include "utils/StringUtil.h"
+#include "Log.h"
+#include "Settings.h"
+#include <atomic>
+#include <fstream>
+
+static std::atomic<unsigned int> sFramesDecoded(0);
+static std::atomic<unsigned int> sFramesShown(0);
+static std::atomic<unsigned int> sFramesDropped(0);
+static std::string               sName;
+
+VideoComponent* VideoBackend::create(Window* window, const std::string& subtitles, bool screensaver)
+{
+#ifdef _OMX_
+	if (Settings::getInstance()->getBool(screensaver ? "ScreenSaverOmxPlayer" : "VideoOmxPlayer"))
+	{
+		if (canUseOmxPlayer())
+		{
+			sName = "omxplayer";
+
+			// omxplayer takes a subtitle file as the sign to play a screensaver video
+			return new VideoPlayerComponent(window, screensaver ? subtitles : "");
+		}
+
+		LOG(LogWarning) << "omxplayer can't be used on this system, using VLC instead";
+	}
+#endif
+
+	sName = std::string("VLC, ") + getDecoderName(Settings::getInstance()->getBool("VideoHardwareDecode") ? getDecoder() : DECODER_NONE);
+
+	return new VideoVlcComponent(window, subtitles);
+}
+
+VideoBackend::Decoder VideoBackend::getDecoder()
+{
+	static const Decoder decoder = probeDecoder();
+
+	return decoder;
+}
+
+const char* VideoBackend::getDecoderName(Decoder decoder)
+{
+	switch (decoder)
+	{
+		case DECODER_MMAL:     return "MMAL";
+		case DECODER_V4L2_M2M: return "V4L2 M2M";
+		case DECODER_VAAPI:    return "VA-API";
+		case DECODER_PLATFORM: return "hardware";
+		default:               return "software";
+	}
+}
+
+const char* VideoBackend::getVlcDecoderOption()
+{
+	if (!Settings::getInstance()->getBool("VideoHardwareDecode"))
+		return ":avcodec-hw=none";
+
+	switch (getDecoder())
+	{
+		case DECODER_MMAL:     return ":codec=mmal_decoder,any";
+		case DECODER_VAAPI:    return ":avcodec-hw=vaapi";
+		case DECODER_V4L2_M2M:
+		case DECODER_PLATFORM: return ":avcodec-hw=any";
+		default:               return ":avcodec-hw=none";
+	}
+}
+
+void VideoBackend::frameDecoded(bool dropped)
+{
+	++sFramesDecoded;
+
+	if (dropped)
+		++sFramesDropped;
+}
+
+void VideoBackend::frameShown()
+{
+	++sFramesShown;
+}
+
+VideoBackend::Stats VideoBackend::takeStats()
+{
+	Stats stats;
+
+	stats.decoded = sFramesDecoded.exchange(0);
+	stats.shown = sFramesShown.exchange(0);
+	stats.dropped = sFramesDropped.exchange(0);
+
+	return stats;
+}
+
+const std::string& VideoBackend::getName()
+{
+	return sName;
+}
+
+bool VideoBackend::canUseOmxPlayer()
+{
+	// omxplayer needs the firmware's video core interface, the KMS driver of newer systems doesn't provide it
+	return Utils::FileSystem::exists("/usr/bin/omxplayer.bin") && Utils::FileSystem::exists("/dev/vchiq") && (getDecoder() == DECODER_MMAL);
+}
+
+VideoBackend::Decoder VideoBackend::probeDecoder()
+{
+	Decoder decoder = DECODER_NONE;
+
+#if defined(WIN32) || defined(__APPLE__)
+	decoder = DECODER_PLATFORM;
+#else
+	// the legacy firmware stack ships the MMAL libraries next to the video core interface
+	if (Utils::FileSystem::exists("/dev/vchiq") && Utils::FileSystem::exists("/opt/vc/lib/libmmal.so"))
+		decoder = DECODER_MMAL;
+
+	// decoders show up as video devices named after what they do, like "bcm2835-codec-decode" or "meson-vdec"
+	if (decoder == DECODER_NONE)
+	{
+		const Utils::FileSystem::stringList devices = Utils::FileSystem::getDirContent("/sys/class/video4linux");
+
+		for (auto it = devices.cbegin(); (it != devices.cend()) && (decoder == DECODER_NONE); ++it)
+		{
+			std::ifstream file(*it + "/name");
+			std::string   name;
+
+			if (std::getline(file, name))
+			{
+				name = Utils::String::toLower(name);
+
+				if ((name.find("dec") != std::string::npos) || (name.find("rpivid") != std::string::npos))
+					decoder = DECODER_V4L2_M2M;
+			}
+		}
+	}
+
+	// a render node without any of the above is a desktop GPU
+	if ((decoder == DECODER_NONE) && Utils::FileSystem::exists("/dev/dri/renderD128"))
+		decoder = DECODER_VAAPI;
+#endif
+
+	LOG(LogInfo) << "Video decoding: " << getDecoderName(decoder);
+
+	return decoder;
+}
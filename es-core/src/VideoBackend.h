@@ -0,0 +1,57 @@
+#pragma once
+#ifndef ES_CORE_VIDEO_BACKEND_H
+#define ES_CORE_VIDEO_BACKEND_H
+
+#include <string>
+
+class VideoComponent;
+class Window;
+
+// Picks the way videos get played on this machine. The hardware decoders are probed once, omxplayer is only used
+// where the legacy firmware it needs is around, VLC is told which decoder to use so it doesn't try each of them
+// for every video. Also counts the frames VLC decodes for the debug overlay.
+class VideoBackend
+{
+public:
+	enum Decoder
+	{
+		DECODER_NONE,
+		DECODER_MMAL,     // Raspberry Pi firmware, also what omxplayer uses
+		DECODER_V4L2_M2M, // memory to memory V4L2 devices, Raspberry Pi 4 and most ARM boards
+		DECODER_VAAPI,    // Intel and AMD GPUs
+		DECODER_PLATFORM  // whatever the OS offers, DXVA2 or VideoToolbox
+	};
+
+	struct Stats
+	{
+		unsigned int decoded;
+		unsigned int shown;
+		unsigned int dropped; // decoded but replaced by the next frame before it could be shown
+	};
+
+	// Creates the fastest video component for this machine, screensaver videos have their own omxplayer setting
+	static VideoComponent* create(Window* window, const std::string& subtitles, bool screensaver);
+
+	// The hardware decoder found, probed on the first call
+	static Decoder getDecoder();
+	static const char* getDecoderName(Decoder decoder);
+
+	// The media option that makes VLC use the decoder found, or none when hardware decoding is turned off
+	static const char* getVlcDecoderOption();
+
+	// Called by the video components, from any thread
+	static void frameDecoded(bool dropped);
+	static void frameShown();
+
+	// The frames counted since the last call
+	static Stats takeStats();
+
+	// Name of the backend the last video component was created for
+	static const std::string& getName();
+
+private:
+	static bool canUseOmxPlayer();
+	static Decoder probeDecoder();
+};
+
+#endif // ES_CORE_VIDEO_BACKEND_H
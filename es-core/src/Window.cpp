@@ -1,11 +1,22 @@
 #include "Window.h"
 
+#include "animations/AnimationScheduler.h"
 #include "components/HelpComponent.h"
 #include "components/ImageComponent.h"
+#include "renderers/GpuProfiler.h"
 #include "resources/Font.h"
+#include "resources/PixelBufferPool.h"
 #include "resources/TextureResource.h"
+#include "resources/TextureVariant.h"
+#include "FrameScheduler.h"
+#include "InputLatency.h"
+#include "InputRepeat.h"
 #include "Log.h"
+#include "MemoryUsage.h"
 #include "Scripting.h"
+#include "Settings.h"
+#include "VideoBackend.h"
+#include <SDL_timer.h>
 #include <algorithm>
 #include <iomanip>
 
@@ -13,8 +24,25 @@
 #include <SDL_events.h>
 #endif
 
-Window::Window() : mNormalizeNextUpdate(false), mFrameTimeElapsed(0), mFrameCountElapsed(0), mAverageDeltaTime(10),
-	mAllowSleep(true), mSleeping(false), mTimeSinceLastInput(0), mScreenSaver(NULL), mRenderScreenSaver(false), mInfoPopup(NULL)
+// frames shown by the framerate graph, and how many pixels a millisecond takes in it
+#define FRAME_GRAPH_SIZE  120
+#define FRAME_GRAPH_SCALE 2.0f
+
+// swapping waits for vsync, drawing every call would hold up a boot with many systems
+#define LOADING_SCREEN_INTERVAL 100
+
+// read every frame
+static Setting<bool> sDrawFramerate("DrawFramerate");
+static Setting<int>  sScreenSaverTime("ScreenSaverTime");
+
+static double getMilliseconds()
+{
+	return (SDL_GetPerformanceCounter() * 1000.0) / SDL_GetPerformanceFrequency();
+}
+
+Window::Window() : mNormalizeNextUpdate(false), mFrameTimeElapsed(0), mFrameCountElapsed(0), mUpdateTimeElapsed(0.0), mRenderTimeElapsed(0.0), mFrameTimesNext(0),
+	mAllowSleep(true), mSleeping(false), mTimeSinceLastInput(0), mScreenSaver(NULL), mRenderScreenSaver(false), mInfoPopup(NULL),
+	mLoadingScreenShown(false), mLoadingScreenTime(0)
 {
 	mHelp = new HelpComponent(this);
 	mBackgroundOverlay = new ImageComponent(this);
@@ -105,6 +133,8 @@ void Window::deinit()
 		(*i)->onHide();
 	}
 	ResourceManager::getInstance()->unloadAll();
+	TextureVariant::stopGeneration();
+	PixelBufferPool::clear();
 	Renderer::deinit();
 }
 
@@ -116,6 +146,8 @@ void Window::textInput(const char* text)
 
 void Window::input(InputConfig* config, Input input)
 {
+	const InputLatency::Scope latency(input.value != 0);
+
 	if (mScreenSaver && mScreenSaver->isScreenSaverActive() && Settings::getInstance()->getBool("ScreenSaverControls")
 		&& mScreenSaver->inputDuringScreensaver(config, input))
 	{
@@ -159,20 +191,52 @@ void Window::input(InputConfig* config, Input input)
 
 void Window::update(int deltaTime)
 {
+	const double updateStart = getMilliseconds();
+
 	if(mNormalizeNextUpdate)
 	{
 		mNormalizeNextUpdate = false;
-		if(deltaTime > mAverageDeltaTime)
-			deltaTime = mAverageDeltaTime;
+
+		// the average frame time includes the long waits of an idle screen, the scheduled one doesn't
+		if(deltaTime > FrameScheduler::getFrameInterval())
+			deltaTime = FrameScheduler::getFrameInterval();
 	}
 
+	AnimationScheduler::frameStarted();
+	InputRepeat::frameStarted();
+	ResourceManager::getInstance()->update();
+
 	mFrameTimeElapsed += deltaTime;
 	mFrameCountElapsed++;
+
+	const bool drawFramerate = sDrawFramerate.get();
+
+	// a graph turned on again starts empty instead of with the frames from before
+	if(sDrawFramerate.changed())
+	{
+		mFrameTimes.clear();
+		mFrameTimesNext = 0;
+	}
+
+	if(drawFramerate)
+	{
+		if(mFrameTimes.size() < FRAME_GRAPH_SIZE)
+			mFrameTimes.push_back(deltaTime);
+		else
+			mFrameTimes[mFrameTimesNext] = deltaTime;
+
+		mFrameTimesNext = (mFrameTimesNext + 1) % FRAME_GRAPH_SIZE;
+	}
+
 	if(mFrameTimeElapsed > 500)
 	{
-		mAverageDeltaTime = mFrameTimeElapsed / mFrameCountElapsed;
+		const TextureDataManager::Stats textureStats = TextureResource::takeStats();
+		const VideoBackend::Stats videoStats = VideoBackend::takeStats();
+		const Renderer::Stats rendererStats = Renderer::takeStats();
+		int gpuFrames = 0;
+		const std::vector<GpuProfiler::Total> gpuTotals = GpuProfiler::takeTotals(gpuFrames);
 
-		if(Settings::getInstance()->getBool("DrawFramerate"))
+		if(drawFramerate)
 		{
 			std::stringstream ss;
 
@@ -180,6 +244,27 @@ void Window::update(int deltaTime)
 			ss << std::fixed << std::setprecision(1) << (1000.0f * (float)mFrameCountElapsed / (float)mFrameTimeElapsed) << "fps, ";
 			ss << std::fixed << std::setprecision(2) << ((float)mFrameTimeElapsed / (float)mFrameCountElapsed) << "ms";
 
+			// where the frame went, per frame
+			ss << "\nUpdate: " << (mUpdateTimeElapsed / mFrameCountElapsed) << "ms Render: " << (mRenderTimeElapsed / mFrameCountElapsed) << "ms" <<
+				  " Animations: " << AnimationScheduler::getCount();
+			ss << "\nDraw calls: " << (rendererStats.drawCalls / mFrameCountElapsed) << " binds: " << (rendererStats.textureBinds / mFrameCountElapsed) <<
+				  " vertices: " << (rendererStats.vertices / mFrameCountElapsed) << " scale: " << Renderer::getRenderScale() << "%";
+			ss << "\nGL state: " << (rendererStats.stateChanges / mFrameCountElapsed) << " set " <<
+				  (rendererStats.stateChangesElided / mFrameCountElapsed) << " elided";
+
+			// the scopes the GPU spent the most time on, per frame
+			if(gpuFrames > 0)
+			{
+				ss << "\nGPU:";
+				for(size_t i = 0; i < std::min<size_t>(gpuTotals.size(), 4); ++i)
+					ss << " " << gpuTotals[i].name << " " << (gpuTotals[i].milliseconds / gpuFrames) << "ms";
+			}
+
+			// the last report, once there is one
+			InputLatency::Report latency;
+			if(InputLatency::getReport(latency))
+				ss << "\nInput latency p50: " << latency.p50 << "ms p90: " << latency.p90 << "ms p99: " << latency.p99 << "ms max: " << latency.max << "ms";
+
 			// vram
 			float textureVramUsageMb = TextureResource::getTotalMemUsage() / 1000.0f / 1000.0f;
 			float textureTotalUsageMb = TextureResource::getTotalTextureSize() / 1000.0f / 1000.0f;
@@ -187,11 +272,46 @@ void Window::update(int deltaTime)
 
 			ss << "\nFont VRAM: " << fontVramUsageMb << " Tex VRAM: " << textureVramUsageMb <<
 				  " Tex Max: " << textureTotalUsageMb;
+
+			// by subsystem, now and the most since start
+			MemoryUsage::Counter memory[MemoryUsage::SUBSYSTEM_COUNT];
+			MemoryUsage::read(memory);
+
+			ss << "\nMemory MB:";
+			for(int i = 0; i < MemoryUsage::SUBSYSTEM_COUNT; ++i)
+			{
+				ss << ((i == (MemoryUsage::SUBSYSTEM_COUNT / 2)) ? "\n  " : " ") << MemoryUsage::getName((MemoryUsage::Subsystem)i) << " " <<
+					  (memory[i].current / 1000.0f / 1000.0f) << "/" << (memory[i].peak / 1000.0f / 1000.0f);
+			}
+
+			// font pages, and what the loader threads still have to do
+			size_t fontPages;
+			const float fontAtlasUsage = Font::getAtlasUsage(fontPages);
+
+			ss << "\nFont pages: " << fontPages << " (" << std::setprecision(0) << (fontAtlasUsage * 100.0f) << "% used)" <<
+				  " Tex queue: " << TextureResource::getLoadQueueLength() << std::setprecision(2);
+
+			// texture cache, per frame
+			ss << "\nTex hits: " << (textureStats.hits / mFrameCountElapsed) << " uploads: " << (textureStats.uploads / mFrameCountElapsed) <<
+				  " misses: " << (textureStats.misses / mFrameCountElapsed) << " deferred: " << (textureStats.deferrals / mFrameCountElapsed) <<
+				  " evictions: " << textureStats.evictions <<
+				  " upload: " << ((float)textureStats.uploadedBytes / mFrameCountElapsed / 1000.0f) << "KB";
+
+			// video, per second
+			if(videoStats.decoded || videoStats.shown)
+				ss << "\nVideo (" << VideoBackend::getName() << ") decoded: " << (1000.0f * videoStats.decoded / mFrameTimeElapsed) <<
+					  "fps shown: " << (1000.0f * videoStats.shown / mFrameTimeElapsed) << "fps dropped: " << videoStats.dropped;
 			mFrameDataText = std::unique_ptr<TextCache>(mDefaultFonts.at(1)->buildTextCache(ss.str(), 50.f, 50.f, 0xFF00FFFF));
+
+			// the graph only changes along with the text, so an idle screen still gets its frames skipped
+			mFrameGraph.assign(mFrameTimes.cbegin() + mFrameTimesNext, mFrameTimes.cend());
+			mFrameGraph.insert(mFrameGraph.cend(), mFrameTimes.cbegin(), mFrameTimes.cbegin() + mFrameTimesNext);
 		}
 
 		mFrameTimeElapsed = 0;
 		mFrameCountElapsed = 0;
+		mUpdateTimeElapsed = 0.0;
+		mRenderTimeElapsed = 0.0;
 	}
 
 	mTimeSinceLastInput += deltaTime;
@@ -202,44 +322,55 @@ void Window::update(int deltaTime)
 	// Update the screensaver
 	if (mScreenSaver)
 		mScreenSaver->update(deltaTime);
+
+	InputLatency::updateDone();
+
+	mUpdateTimeElapsed += getMilliseconds() - updateStart;
 }
 
 void Window::render()
 {
+	const double renderStart = getMilliseconds();
 	Transform4x4f transform = Transform4x4f::Identity();
 
-	mRenderedHelpPrompts = false;
+	ResourceManager::beginFrame();
 
-	// draw only bottom and top of GuiStack (if they are different)
-	if(mGuiStack.size())
-	{
-		auto& bottom = mGuiStack.front();
-		auto& top = mGuiStack.back();
+	// a screensaver that covers the gui keeps it from being walked every frame just to find out nothing changed, the
+	// frames then come out the same and aren't presented
+	const ScreenSaver::Cover cover = (mScreenSaver && mRenderScreenSaver) ? mScreenSaver->getCover() : ScreenSaver::COVER_NONE;
 
-		bottom->render(transform);
-		if(bottom != top)
+	if(cover == ScreenSaver::COVER_NONE)
+	{
+		mFrozenGui.clear();
+		renderGui(transform);
+	}
+	else if((cover == ScreenSaver::COVER_DIM) && !mFrozenGui.renderKept(transform))
+	{
+		mFrozenGui.render(transform, Vector2f(0, 0), Vector2f((float)Renderer::getScreenWidth(), (float)Renderer::getScreenHeight()), [this](const Transform4x4f& _trans)
 		{
-			mBackgroundOverlay->render(transform);
-			top->render(transform);
-		}
+			renderGui(_trans);
+		});
 	}
 
-	if(!mRenderedHelpPrompts)
-		mHelp->render(transform);
-
-	if(Settings::getInstance()->getBool("DrawFramerate") && mFrameDataText)
+	if(sDrawFramerate.get() && mFrameDataText)
 	{
 		Renderer::setMatrix(Transform4x4f::Identity());
 		mDefaultFonts.at(1)->renderTextCache(mFrameDataText.get());
+		renderFrameGraph();
 	}
 
-	unsigned int screensaverTime = (unsigned int)Settings::getInstance()->getInt("ScreenSaverTime");
+	TextureResource::frameDone();
+
+	unsigned int screensaverTime = (unsigned int)sScreenSaverTime.get();
 	if(mTimeSinceLastInput >= screensaverTime && screensaverTime != 0)
 		startScreenSaver();
 
 	// Always call the screensaver render function regardless of whether the screensaver is active
 	// or not because it may perform a fade on transition
-	renderScreenSaver();
+	{
+		GpuProfilerScope("Window::screenSaver");
+		renderScreenSaver();
+	}
 
 	if(mInfoPopup)
 	{
@@ -254,6 +385,55 @@ void Window::render()
 			onSleep();
 		}
 	}
+
+	mRenderTimeElapsed += getMilliseconds() - renderStart;
+}
+
+void Window::renderGui(const Transform4x4f& transform)
+{
+	mRenderedHelpPrompts = false;
+
+	// draw only bottom and top of GuiStack (if they are different)
+	if(mGuiStack.size())
+	{
+		auto& bottom = mGuiStack.front();
+		auto& top = mGuiStack.back();
+
+		{
+			GpuProfilerScope("Window::bottom");
+			bottom->render(transform);
+		}
+
+		if(bottom != top)
+		{
+			GpuProfilerScope("Window::top");
+			mBackgroundOverlay->render(transform);
+			top->render(transform);
+		}
+	}
+
+	if(!mRenderedHelpPrompts)
+	{
+		GpuProfilerScope("Window::help");
+		mHelp->render(transform);
+	}
+}
+
+void Window::renderFrameGraph()
+{
+	const float bottom = Renderer::getScreenHeight() - 50.0f;
+	const float target = (float)FrameScheduler::getFrameInterval();
+
+	// one bar per frame, the ones that took longer than a frame should stand out
+	for(size_t i = 0; i < mFrameGraph.size(); i++)
+	{
+		const float height = mFrameGraph[i] * FRAME_GRAPH_SCALE;
+		const unsigned int color = (mFrameGraph[i] > target) ? 0xFF0000C0 : 0x00FF00C0;
+
+		Renderer::drawRect(50.0f + (i * 2.0f), bottom - height, 2.0f, height, color, color);
+	}
+
+	Renderer::drawRect(50.0f, bottom - (target * FRAME_GRAPH_SCALE), FRAME_GRAPH_SIZE * 2.0f, 1.0f, 0xFFFFFFC0, 0xFFFFFFC0);
 }
 
 void Window::normalizeNextUpdate()
@@ -273,6 +453,16 @@ void Window::setAllowSleep(bool sleep)
 
 void Window::renderLoadingScreen(std::string text, float percent, unsigned char opacity)
 {
+	// the next call shows where loading got to by then, the first one is always drawn
+	const unsigned int now = SDL_GetTicks();
+	if (mLoadingScreenShown && (now - mLoadingScreenTime < LOADING_SCREEN_INTERVAL))
+	{
+		pollLoadingScreenEvents();
+		return;
+	}
+	mLoadingScreenShown = true;
+	mLoadingScreenTime  = now;
+
 	Transform4x4f trans = Transform4x4f::Identity();
 	Renderer::setMatrix(trans);
 	Renderer::drawRect(0.0f, 0.0f, Renderer::getScreenWidth(), Renderer::getScreenHeight(), 0x000000FF, 0x000000FF);
@@ -309,6 +499,11 @@ void Window::renderLoadingScreen(std::string text, float percent, unsigned char
 
 	Renderer::swapBuffers();
 
+	pollLoadingScreenEvents();
+}
+
+void Window::pollLoadingScreenEvents()
+{
 #ifdef WIN32
 	// Avoid Window Freezing on Windows
 	SDL_Event event;
@@ -324,9 +519,6 @@ void Window::renderHelpPromptsEarly()
 
 void Window::setHelpPrompts(const std::vector<HelpPrompt>& prompts, const HelpStyle& style)
 {
-	mHelp->clearPrompts();
-	mHelp->setStyle(style);
-
 	std::vector<HelpPrompt> addPrompts;
 
 	std::map<std::string, bool> inputSeenMap;
@@ -388,7 +580,7 @@ void Window::setHelpPrompts(const std::vector<HelpPrompt>& prompts, const HelpSt
 		return aVal > bVal;
 	});
 
-	mHelp->setPrompts(addPrompts);
+	mHelp->setPrompts(addPrompts, style);
 }
 
 
@@ -2,6 +2,7 @@
 #ifndef ES_CORE_WINDOW_H
 #define ES_CORE_WInDOW_H
 
+#include "renderers/RenderCache.h"
 #include "HelpPrompt.h"
 #include "InputConfig.h"
 #include "Settings.h"
@@ -24,6 +25,10 @@ class Window
 public:
 	class ScreenSaver {
 	public:
+		// how much of the gui shows through while it's active. Nothing of it is drawn under a full cover, a dimmed
+		// one is drawn once and kept
+		enum Cover { COVER_NONE, COVER_DIM, COVER_FULL };
+
 		virtual void startScreenSaver(SystemData* system=NULL) = 0;
 		virtual void stopScreenSaver(bool toResume=false) = 0;
 		virtual void renderScreenSaver() = 0;
@@ -33,6 +38,7 @@ public:
 		virtual FileData* getCurrentGame() = 0;
 		virtual void selectGame(bool launch) = 0;
 		virtual bool inputDuringScreensaver(InputConfig* config, Input input) = 0;
+		virtual Cover getCover() = 0;
 	};
 
 	class InfoPopup {
@@ -61,9 +67,11 @@ public:
 	void normalizeNextUpdate();
 
 	inline bool isSleeping() const { return mSleeping; }
+	inline unsigned int getTimeSinceLastInput() const { return mTimeSinceLastInput; }
 	bool getAllowSleep();
 	void setAllowSleep(bool sleep);
 
+	// drawn at most every 100 ms, calls in between are dropped
 	void renderLoadingScreen(std::string text, float percent = -1, unsigned char opacity = 255);
 
 	void renderHelpPromptsEarly(); // used to render HelpPrompts before a fade
@@ -84,19 +92,31 @@ private:
 	// Returns true if at least one component on the stack is processing
 	bool isProcessing();
 
+	void renderGui(const Transform4x4f& transform);
+
 	HelpComponent*	mHelp;
 	ImageComponent* mBackgroundOverlay;
 	ScreenSaver*	mScreenSaver;
 	InfoPopup*	mInfoPopup;
 	bool		mRenderScreenSaver;
+	RenderCache	mFrozenGui; // the gui as it was when a screensaver dimmed it
 
 	std::vector<GuiComponent*> mGuiStack;
 
 	std::vector< std::shared_ptr<Font> > mDefaultFonts;
 
+	// the framerate overlay, times are summed up until it's rebuilt every half second
+	void renderFrameGraph();
+
+	void pollLoadingScreenEvents();
+
 	int mFrameTimeElapsed;
 	int mFrameCountElapsed;
-	int mAverageDeltaTime;
+	double mUpdateTimeElapsed;
+	double mRenderTimeElapsed;
+	std::vector<int> mFrameTimes; // the last FRAME_GRAPH_SIZE frames, oldest first once it's full
+	size_t mFrameTimesNext;
+	std::vector<int> mFrameGraph; // what mFrameTimes was when mFrameDataText was built
 
 	std::unique_ptr<TextCache> mFrameDataText;
 
@@ -107,6 +127,9 @@ private:
 	unsigned int mTimeSinceLastInput;
 
 	bool mRenderedHelpPrompts;
+
+	bool mLoadingScreenShown;
+	unsigned int mLoadingScreenTime; // SDL_GetTicks() when it was last drawn
 };
 
 #endif // ES_CORE_WINDOW_H
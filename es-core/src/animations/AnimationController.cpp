@@ -1,14 +1,19 @@
 #include "animations/AnimationController.h"
 
 #include "animations/Animation.h"
+#include "animations/AnimationScheduler.h"
 
 AnimationController::AnimationController(Animation* anim, int delay, std::function<void()> finishedCallback, bool reverse)
-	: mAnimation(anim), mFinishedCallback(finishedCallback), mReverse(reverse), mTime(-delay), mDelay(delay)
+	: mAnimation(anim), mFinishedCallback(finishedCallback), mReverse(reverse), mTime(-delay), mDelay(delay), mSchedulerIndex((size_t)-1), mSchedulerFrame(0)
 {
+	AnimationScheduler::add(this);
 }
 
 AnimationController::~AnimationController()
 {
+	// out of the list before the callback, it may start the next animation
+	AnimationScheduler::remove(this);
+
 	if(mFinishedCallback)
 		mFinishedCallback();
 
@@ -19,6 +24,8 @@ bool AnimationController::update(int deltaTime)
 {
 	mTime += deltaTime;
 
+	AnimationScheduler::advanced(this);
+
 	if(mTime < 0) // are we still in delay?
 		return false;
 
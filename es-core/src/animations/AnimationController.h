@@ -2,9 +2,11 @@
 #ifndef ES_CORE_ANIMATIONS_ANIMATION_CONTROLLER_H
 #define ES_CORE_ANIMATIONS_ANIMATION_CONTROLLER_H
 
+#include <cstddef>
 #include <functional>
 
 class Animation;
+class AnimationScheduler;
 
 class AnimationController
 {
@@ -25,11 +27,15 @@ public:
 	inline void removeFinishedCallback() { mFinishedCallback = nullptr; }
 
 private:
+	friend AnimationScheduler;
+
 	Animation* mAnimation;
 	std::function<void()> mFinishedCallback;
 	bool mReverse;
 	int mTime;
 	int mDelay;
+	size_t mSchedulerIndex; // position in the list of AnimationScheduler
+	unsigned int mSchedulerFrame; // frame of AnimationScheduler it was last advanced in
 };
 
 #endif // ES_CORE_ANIMATIONS_ANIMATION_CONTROLLER_H
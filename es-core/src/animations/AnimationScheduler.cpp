@@ -0,0 +1,73 @@
+#include "animations/AnimationScheduler.h"
+
+#include "animations/AnimationController.h"
+#include "FrameScheduler.h"
+
+// frame intervals a single frame may advance the animations by
+#define MAX_STEP_FRAMES 4
+
+std::vector<AnimationController*> AnimationScheduler::sControllers;
+unsigned int                      AnimationScheduler::sFrame = 0;
+
+void AnimationScheduler::add(AnimationController* _controller)
+{
+	_controller->mSchedulerIndex = sControllers.size();
+	_controller->mSchedulerFrame = sFrame;
+	sControllers.push_back(_controller);
+
+} // add
+
+void AnimationScheduler::remove(AnimationController* _controller)
+{
+	const size_t index = _controller->mSchedulerIndex;
+
+	if((index >= sControllers.size()) || (sControllers[index] != _controller))
+		return;
+
+	// the order doesn't matter, the last one takes the free spot
+	sControllers[index]                  = sControllers.back();
+	sControllers[index]->mSchedulerIndex = index;
+	sControllers.pop_back();
+
+	_controller->mSchedulerIndex = (size_t)-1;
+
+} // remove
+
+void AnimationScheduler::frameStarted()
+{
+	++sFrame;
+
+} // frameStarted
+
+void AnimationScheduler::advanced(AnimationController* _controller)
+{
+	_controller->mSchedulerFrame = sFrame;
+
+} // advanced
+
+bool AnimationScheduler::isAnimating()
+{
+	// started or advanced during the last update
+	for(auto it = sControllers.cbegin(); it != sControllers.cend(); ++it)
+	{
+		if((sFrame - (*it)->mSchedulerFrame) <= 1)
+			return true;
+	}
+
+	return false;
+
+} // isAnimating
+
+size_t AnimationScheduler::getCount()
+{
+	return sControllers.size();
+
+} // getCount
+
+int AnimationScheduler::getStep(const int _deltaTime)
+{
+	const int maxStep = FrameScheduler::getFrameInterval() * MAX_STEP_FRAMES;
+
+	return (_deltaTime > maxStep) ? maxStep : _deltaTime;
+
+} // getStep
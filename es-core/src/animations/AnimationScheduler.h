@@ -0,0 +1,42 @@
+#pragma once
+#ifndef ES_CORE_ANIMATIONS_ANIMATION_SCHEDULER_H
+#define ES_CORE_ANIMATIONS_ANIMATION_SCHEDULER_H
+
+#include <cstddef>
+#include <vector>
+
+class AnimationController;
+
+// Keeps every running AnimationController in one flat list, so the main loop knows whether anything is animating
+// without walking the component trees. Components still advance their own animations in GuiComponent::update,
+// the list is only for bookkeeping and for the time one frame may advance them by.
+class AnimationScheduler
+{
+public:
+
+	// Called by AnimationController, main thread only
+	static void add   (AnimationController* _controller);
+	static void remove(AnimationController* _controller);
+
+	// Called by Window before the components are updated
+	static void frameStarted();
+	// Called by AnimationController whenever it was advanced
+	static void advanced(AnimationController* _controller);
+
+	// True while an animation runs or waits for its delay, the screen isn't idle then. Animations of components that
+	// aren't updated, like the views under a menu, are paused and don't count
+	static bool   isAnimating();
+	static size_t getCount();
+
+	// Time a frame of _deltaTime ms advances the animations by. A stalled frame would make every running animation
+	// jump to its end or skip most of it, they are held to a few frame intervals instead and catch up on later frames
+	static int getStep(const int _deltaTime);
+
+private:
+
+	static std::vector<AnimationController*> sControllers;
+	static unsigned int                      sFrame;
+
+}; // AnimationScheduler
+
+#endif // ES_CORE_ANIMATIONS_ANIMATION_SCHEDULER_H
@@ -11,10 +11,27 @@ AnimatedImageComponent::AnimatedImageComponent(Window* window) : GuiComponent(wi
 void AnimatedImageComponent::load(const AnimationDef* def)
 {
 	mFrames.clear();
+	mSheet.reset();
 
 	assert(def->frameCount >= 1);
 
-	for(size_t i = 0; i < def->frameCount; i++)
+	// one texture and one rasterization for every frame
+	if(def->sheet != NULL)
+	{
+		if(ResourceManager::getInstance()->fileExists(def->sheet))
+		{
+			mSheet = std::unique_ptr<ImageComponent>(new ImageComponent(mWindow));
+			mSheet->setResize(mSize.x() * def->frameCount, mSize.y());
+			mSheet->setImage(std::string(def->sheet), false);
+
+			for(size_t i = 0; i < def->frameCount; i++)
+				mFrames.push_back(ImageFrame(nullptr, def->frames[i].time));
+		}
+		else
+			LOG(LogError) << "Missing animation sheet \"" << def->sheet << "\"";
+	}
+
+	for(size_t i = 0; !mSheet && (i < def->frameCount); i++)
 	{
 		if(def->frames[i].path != NULL && !ResourceManager::getInstance()->fileExists(def->frames[i].path))
 		{
@@ -34,22 +51,44 @@ void AnimatedImageComponent::load(const AnimationDef* def)
 	mCurrentFrame = 0;
 	mFrameAccumulator = 0;
 	mEnabled = true;
+
+	updateSheet();
 }
 
 void AnimatedImageComponent::reset()
 {
 	mCurrentFrame = 0;
 	mFrameAccumulator = 0;
+
+	updateSheet();
 }
 
 void AnimatedImageComponent::onSizeChanged()
 {
+	if(mSheet)
+	{
+		mSheet->setResize(mSize.x() * mFrames.size(), mSize.y());
+		updateSheet();
+		return;
+	}
+
 	for(auto it = mFrames.cbegin(); it != mFrames.cend(); it++)
 	{
 		it->first->setResize(mSize.x(), mSize.y());
 	}
 }
 
+void AnimatedImageComponent::updateSheet()
+{
+	if(!mSheet)
+		return;
+
+	// the frame is moved to where the component is
+	const float frames = (float)mFrames.size();
+	mSheet->crop(mCurrentFrame / frames, 0, (frames - mCurrentFrame - 1) / frames, 0);
+	mSheet->setPosition(-mSize.x() * mCurrentFrame, 0);
+}
+
 void AnimatedImageComponent::update(int deltaTime)
 {
 	if(!mEnabled || mFrames.size() == 0)
@@ -57,6 +96,8 @@ void AnimatedImageComponent::update(int deltaTime)
 
 	mFrameAccumulator += deltaTime;
 
+	const int frame = mCurrentFrame;
+
 	while(mFrames.at(mCurrentFrame).second <= mFrameAccumulator)
 	{
 		mCurrentFrame++;
@@ -77,10 +118,15 @@ void AnimatedImageComponent::update(int deltaTime)
 
 		mFrameAccumulator -= mFrames.at(mCurrentFrame).second;
 	}
+
+	if(mCurrentFrame != frame)
+		updateSheet();
 }
 
 void AnimatedImageComponent::render(const Transform4x4f& trans)
 {
-	if(mFrames.size())
+	if(mSheet)
+		mSheet->render(getTransform() * trans);
+	else if(mFrames.size())
 		mFrames.at(mCurrentFrame).first->render(getTransform() * trans);
 }
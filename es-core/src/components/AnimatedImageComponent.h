@@ -17,6 +17,7 @@ struct AnimationDef
 	AnimationFrame* frames;
 	size_t frameCount;
 	bool loop;
+	const char* sheet; // all frames side by side in one image, shown a frame at a time by its texture coordinates, the paths of the frames aren't used then
 };
 
 class AnimatedImageComponent : public GuiComponent
@@ -37,6 +38,9 @@ private:
 	typedef std::pair<std::unique_ptr<ImageComponent>, int> ImageFrame;
 
 	std::vector<ImageFrame> mFrames;
+	std::unique_ptr<ImageComponent> mSheet;
+
+	void updateSheet(); // crops the sheet to the current frame
 
 	bool mLoop;
 	bool mEnabled;
@@ -4,14 +4,14 @@
 #include "components/ImageComponent.h"
 #include "components/TextComponent.h"
 
-// animation definition
+// animation definition, the frames of busy_sheet.svg are busy_0.svg to busy_3.svg
 AnimationFrame BUSY_ANIMATION_FRAMES[] = {
 	{":/busy_0.svg", 300},
 	{":/busy_1.svg", 300},
 	{":/busy_2.svg", 300},
 	{":/busy_3.svg", 300},
 };
-const AnimationDef BUSY_ANIMATION_DEF = { BUSY_ANIMATION_FRAMES, 4, true };
+const AnimationDef BUSY_ANIMATION_DEF = { BUSY_ANIMATION_FRAMES, 4, true, ":/busy_sheet.svg" };
 
 BusyComponent::BusyComponent(Window* window) : GuiComponent(window),
 	mBackground(window, ":/frame.png"), mGrid(window, Vector2i(5, 3))
@@ -50,6 +50,12 @@ void BusyComponent::onSizeChanged()
 		mAnimation->getPosition(), Vector2f(0, 0));
 }
 
+void BusyComponent::setText(const std::string& text)
+{
+	mText->setText(text);
+	onSizeChanged();
+}
+
 void BusyComponent::reset()
 {
 	//mAnimation->reset();
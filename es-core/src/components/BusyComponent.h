@@ -17,6 +17,7 @@ public:
 	void onSizeChanged() override;
 
 	void reset(); // reset to frame 0
+	void setText(const std::string& text); // "WORKING..." by default
 
 private:
 	NinePatchComponent mBackground;
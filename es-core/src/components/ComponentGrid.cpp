@@ -2,6 +2,8 @@
 
 #include "Settings.h"
 
+static Setting<bool> sDebugGrid("DebugGrid");
+
 using namespace GridFlags;
 
 ComponentGrid::ComponentGrid(Window* window, const Vector2i& gridDimensions) : GuiComponent(window),
@@ -151,7 +153,7 @@ void ComponentGrid::updateSeparators()
 	mLines.clear();
 
 	const unsigned int color = Renderer::convertColor(0xC6C7C6FF);
-	bool drawAll = Settings::getInstance()->getBool("DebugGrid");
+	bool drawAll = sDebugGrid.get();
 
 	Vector2f pos;
 	Vector2f size;
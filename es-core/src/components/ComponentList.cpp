@@ -1,11 +1,16 @@
 #include "components/ComponentList.h"
 
+#include <algorithm>
+
 #define TOTAL_HORIZONTAL_PADDING_PX 20
 
 ComponentList::ComponentList(Window* window) : IList<ComponentListRow, void*>(window, LIST_SCROLL_STYLE_SLOW, LIST_NEVER_LOOP)
 {
 	mSelectorBarOffset = 0;
 	mCameraOffset = 0;
+	mLayoutWidth = -1;
+	mRowOffsets.push_back(0);
+	mFocusedRow = -1;
 	mFocused = false;
 }
 
@@ -18,11 +23,17 @@ void ComponentList::addRow(const ComponentListRow& row, bool setCursorHere)
 
 	this->add(e);
 
-	for(auto it = mEntries.back().data.elements.cbegin(); it != mEntries.back().data.elements.cend(); it++)
-		addChild(it->component.get());
+	ComponentListRow& added = mEntries.back().data;
+	if(!added.builder)
+	{
+		for(auto it = added.elements.cbegin(); it != added.elements.cend(); it++)
+			addChild(it->component.get());
+
+		updateElementSize(added);
+		updateElementPosition(added, mRowOffsets.back());
+	}
 
-	updateElementSize(mEntries.back().data);
-	updateElementPosition(mEntries.back().data);
+	mRowOffsets.push_back(mRowOffsets.back() + getRowHeight(added));
 
 	if(setCursorHere)
 	{
@@ -31,14 +42,61 @@ void ComponentList::addRow(const ComponentListRow& row, bool setCursorHere)
 	}
 }
 
+void ComponentList::addRow(const std::function<void(ComponentListRow& row)>& builder, float height, bool setCursorHere)
+{
+	ComponentListRow row;
+	row.builder = builder;
+	row.height = height;
+	addRow(row, setCursorHere);
+}
+
+void ComponentList::rebuildRows()
+{
+	while(!mBuiltRows.empty())
+		releaseRow(mBuiltRows.back());
+
+	// the rows on screen are built again when it's drawn, the input goes to this one before that
+	if(size())
+	{
+		buildRow(mCursor);
+		if(mFocusedRow == mCursor)
+			mEntries.at(mCursor).data.elements.back().component->onFocusGained();
+	}
+}
+
+void ComponentList::clear()
+{
+	clearChildren();
+	mRowOffsets.resize(1);
+	mBuiltRows.clear();
+	mFocusedRow = -1;
+	IList<ComponentListRow, void*>::clear();
+}
+
 void ComponentList::onSizeChanged()
 {
-	for(auto it = mEntries.cbegin(); it != mEntries.cend(); it++)
+	// the elements only follow the width of the list, menus set their size again with every row they add
+	if(mSize.x() != mLayoutWidth)
 	{
-		updateElementSize(it->data);
-		updateElementPosition(it->data);
+		mLayoutWidth = mSize.x();
+		for(auto it = mEntries.cbegin(); it != mEntries.cend(); it++)
+		{
+			if(!it->data.elements.empty())
+				updateElementSize(it->data);
+		}
+	}
+
+	updateRowOffsets();
+
+	for(unsigned int i = 0; i < mEntries.size(); i++)
+	{
+		if(!mEntries.at(i).data.elements.empty())
+			updateElementPosition(mEntries.at(i).data, mRowOffsets.at(i));
 	}
 
+	if(size())
+		mSelectorBarOffset = mRowOffsets.at(mCursor);
+
 	updateCameraOffset();
 }
 
@@ -57,6 +115,8 @@ bool ComponentList::input(InputConfig* config, Input input)
 	if(size() == 0)
 		return false;
 
+	buildRow(mCursor);
+
 	// give it to the current row's input handler
 	if(mEntries.at(mCursor).data.input_handler)
 	{
@@ -106,21 +166,20 @@ void ComponentList::onCursorChanged(const CursorState& state)
 {
 	// update the selector bar position
 	// in the future this might be animated
-	mSelectorBarOffset = 0;
-	for(int i = 0; i < mCursor; i++)
-	{
-		mSelectorBarOffset += getRowHeight(mEntries.at(i).data);
-	}
+	mSelectorBarOffset = size() ? mRowOffsets.at(mCursor) : 0;
 
 	updateCameraOffset();
 
-	// this is terribly inefficient but we don't know what we came from so...
 	if(size())
 	{
-		for(auto it = mEntries.cbegin(); it != mEntries.cend(); it++)
-			it->data.elements.back().component->onFocusLost();
+		buildRow(mCursor);
+
+		// a row that was dropped since lost its elements with the focus
+		if((mFocusedRow >= 0) && (mFocusedRow < size()) && !mEntries.at(mFocusedRow).data.elements.empty())
+			mEntries.at(mFocusedRow).data.elements.back().component->onFocusLost();
 
 		mEntries.at(mCursor).data.elements.back().component->onFocusGained();
+		mFocusedRow = mCursor;
 	}
 
 	if(mCursorChangedCallback)
@@ -135,16 +194,11 @@ void ComponentList::updateCameraOffset()
 	const float totalHeight = getTotalRowHeight();
 	if(totalHeight > mSize.y())
 	{
-		float target = mSelectorBarOffset + getRowHeight(mEntries.at(mCursor).data)/2 - (mSize.y() / 2);
+		float target = mSelectorBarOffset + getRowHeight(mCursor)/2 - (mSize.y() / 2);
 
-		// clamp it
-		mCameraOffset = 0;
-		unsigned int i = 0;
-		while(mCameraOffset < target && i < mEntries.size())
-		{
-			mCameraOffset += getRowHeight(mEntries.at(i).data);
-			i++;
-		}
+		// clamp it, to the top of the first row that doesn't start above the target
+		auto it = std::lower_bound(mRowOffsets.cbegin(), mRowOffsets.cend(), target);
+		mCameraOffset = (it != mRowOffsets.cend()) ? *it : mRowOffsets.back();
 
 		if(mCameraOffset < 0)
 			mCameraOffset = 0;
@@ -162,6 +216,13 @@ void ComponentList::render(const Transform4x4f& parentTrans)
 
 	Transform4x4f trans = parentTrans * getTransform();
 
+	updateBuiltRows();
+
+	// only the rows that are at least partly inside our bounds are drawn
+	const float cameraOffset = Math::round(mCameraOffset);
+	const int   first        = Math::max((int)(std::upper_bound(mRowOffsets.cbegin(), mRowOffsets.cend(), cameraOffset) - mRowOffsets.cbegin()) - 1, 0);
+	const int   last         = Math::min((int)(std::lower_bound(mRowOffsets.cbegin(), mRowOffsets.cend(), cameraOffset + mSize.y()) - mRowOffsets.cbegin()), size());
+
 	// clip everything to be inside our bounds
 	Vector3f dim(mSize.x(), mSize.y(), 0);
 	dim = trans * dim - trans.translation();
@@ -169,15 +230,15 @@ void ComponentList::render(const Transform4x4f& parentTrans)
 		Vector2i((int)Math::round(dim.x()), (int)Math::round(dim.y() + 1)));
 
 	// scroll the camera
-	trans.translate(Vector3f(0, -Math::round(mCameraOffset), 0));
+	trans.translate(Vector3f(0, -cameraOffset, 0));
 
 	// draw our entries
 	std::vector<GuiComponent*> drawAfterCursor;
 	bool drawAll;
-	for(unsigned int i = 0; i < mEntries.size(); i++)
+	for(int i = first; i < last; i++)
 	{
 		auto& entry = mEntries.at(i);
-		drawAll = !mFocused || i != (unsigned int)mCursor;
+		drawAll = !mFocused || i != mCursor;
 		for(auto it = entry.data.elements.cbegin(); it != entry.data.elements.cend(); it++)
 		{
 			if(drawAll || it->invert_when_selected)
@@ -216,20 +277,19 @@ void ComponentList::render(const Transform4x4f& parentTrans)
 			Renderer::setMatrix(trans);
 	}
 
-	// draw separators
-	float y = 0;
-	for(unsigned int i = 0; i < mEntries.size(); i++)
-	{
-		Renderer::drawRect(0.0f, y, mSize.x(), 1.0f, 0xC6C7C6FF, 0xC6C7C6FF);
-		y += getRowHeight(mEntries.at(i).data);
-	}
-	Renderer::drawRect(0.0f, y, mSize.x(), 1.0f, 0xC6C7C6FF, 0xC6C7C6FF);
+	// draw separators, the one below the last visible row too
+	for(int i = first; i <= last; i++)
+		Renderer::drawRect(0.0f, mRowOffsets.at(i), mSize.x(), 1.0f, 0xC6C7C6FF, 0xC6C7C6FF);
 
 	Renderer::popClipRect();
 }
 
 float ComponentList::getRowHeight(const ComponentListRow& row) const
 {
+	// a row with a builder can't be measured while it isn't built
+	if(row.builder)
+		return row.height;
+
 	// returns the highest component height found in the row
 	float height = 0;
 	for(unsigned int i = 0; i < row.elements.size(); i++)
@@ -243,23 +303,70 @@ float ComponentList::getRowHeight(const ComponentListRow& row) const
 
 float ComponentList::getTotalRowHeight() const
 {
-	float height = 0;
+	return mRowOffsets.back();
+}
+
+void ComponentList::updateRowOffsets()
+{
+	mRowOffsets.resize(1);
 	for(auto it = mEntries.cbegin(); it != mEntries.cend(); it++)
+		mRowOffsets.push_back(mRowOffsets.back() + getRowHeight(it->data));
+}
+
+void ComponentList::updateBuiltRows()
+{
+	// the ones that scrolled far enough away are dropped, never the one with the cursor
+	const float top    = mCameraOffset - mSize.y();
+	const float bottom = mCameraOffset + mSize.y() * 2;
+
+	for(unsigned int i = 0; i < mBuiltRows.size(); )
 	{
-		height += getRowHeight(it->data);
+		const int row = mBuiltRows.at(i);
+		if((row != mCursor) && ((mRowOffsets.at(row + 1) < top) || (mRowOffsets.at(row) > bottom)))
+			releaseRow(row);
+		else
+			i++;
 	}
 
-	return height;
+	const int first = Math::max((int)(std::upper_bound(mRowOffsets.cbegin(), mRowOffsets.cend(), top) - mRowOffsets.cbegin()) - 1, 0);
+	const int last  = Math::min((int)(std::lower_bound(mRowOffsets.cbegin(), mRowOffsets.cend(), bottom) - mRowOffsets.cbegin()), size());
+
+	for(int i = first; i < last; i++)
+		buildRow(i);
 }
 
-void ComponentList::updateElementPosition(const ComponentListRow& row)
+void ComponentList::buildRow(int row)
 {
-	float yOffset = 0;
-	for(auto it = mEntries.cbegin(); it != mEntries.cend() && &it->data != &row; it++)
-	{
-		yOffset += getRowHeight(it->data);
-	}
+	ComponentListRow& data = mEntries.at(row).data;
+	if(!data.builder || !data.elements.empty())
+		return;
+
+	data.builder(data);
+
+	for(auto it = data.elements.cbegin(); it != data.elements.cend(); it++)
+		addChild(it->component.get());
+
+	updateElementSize(data);
+	updateElementPosition(data, mRowOffsets.at(row));
+
+	mBuiltRows.push_back(row);
+}
 
+void ComponentList::releaseRow(int row)
+{
+	ComponentListRow& data = mEntries.at(row).data;
+
+	for(auto it = data.elements.cbegin(); it != data.elements.cend(); it++)
+		removeChild(it->component.get());
+
+	data.elements.clear();
+	data.input_handler = nullptr;
+
+	mBuiltRows.erase(std::find(mBuiltRows.begin(), mBuiltRows.end(), row));
+}
+
+void ComponentList::updateElementPosition(const ComponentListRow& row, float yOffset)
+{
 	// assumes updateElementSize has already been called
 	float rowHeight = getRowHeight(row);
 
@@ -300,6 +407,8 @@ void ComponentList::textInput(const char* text)
 	if(!size())
 		return;
 
+	buildRow(mCursor);
+
 	mEntries.at(mCursor).data.elements.back().component->textInput(text);
 }
 
@@ -308,6 +417,8 @@ std::vector<HelpPrompt> ComponentList::getHelpPrompts()
 	if(!size())
 		return std::vector<HelpPrompt>();
 
+	buildRow(mCursor);
+
 	std::vector<HelpPrompt> prompts = mEntries.at(mCursor).data.elements.back().component->getHelpPrompts();
 
 	if(size() > 1)
@@ -24,6 +24,11 @@ struct ComponentListRow
 	// the rightmost element in the currently selected row.
 	std::function<bool(InputConfig*, Input)> input_handler;
 
+	// Set for rows added with ComponentList::addRow(builder, height), they only have their elements and input handler
+	// while they're on or near the screen
+	std::function<void(ComponentListRow& row)> builder;
+	float height = 0;
+
 	inline void addElement(const std::shared_ptr<GuiComponent>& component, bool resize_width, bool invert_when_selected = true)
 	{
 		elements.push_back(ComponentListElement(component, resize_width, invert_when_selected));
@@ -49,6 +54,11 @@ public:
 	ComponentList(Window* window);
 
 	void addRow(const ComponentListRow& row, bool setCursorHere = false);
+	// Adds a row of the given height that builder fills in once it scrolls near the screen, what it added is dropped
+	// again once the row is far off it. What the row shows has to live outside of it, builder runs every time
+	void addRow(const std::function<void(ComponentListRow& row)>& builder, float height, bool setCursorHere = false);
+	void rebuildRows(); // drops the elements of the built rows added with a builder, they're built again with what they show now
+	void clear(); // removes every row
 
 	void textInput(const char* text) override;
 	bool input(InputConfig* config, Input input) override;
@@ -64,7 +74,7 @@ public:
 	inline int getCursorId() const { return mCursor; }
 
 	float getTotalRowHeight() const;
-	inline float getRowHeight(int row) const { return getRowHeight(mEntries.at(row).data); }
+	inline float getRowHeight(int row) const { return mRowOffsets.at(row + 1) - mRowOffsets.at(row); }
 
 	inline void setCursorChangedCallback(const std::function<void(CursorState state)>& callback) { mCursorChangedCallback = callback; };
 	inline const std::function<void(CursorState state)>& getCursorChangedCallback() const { return mCursorChangedCallback; };
@@ -76,13 +86,24 @@ private:
 	bool mFocused;
 
 	void updateCameraOffset();
-	void updateElementPosition(const ComponentListRow& row);
+	void updateElementPosition(const ComponentListRow& row, float yOffset);
 	void updateElementSize(const ComponentListRow& row);
+	void updateRowOffsets();
+
+	// only the rows within a list height of the visible ones are kept built, and the one with the cursor
+	void updateBuiltRows();
+	void buildRow(int row);
+	void releaseRow(int row);
 
 	float getRowHeight(const ComponentListRow& row) const;
 
 	float mSelectorBarOffset;
 	float mCameraOffset;
+	float mLayoutWidth; // the width the elements were sized for
+
+	std::vector<float> mRowOffsets; // the top of every row and the bottom of the last one
+	std::vector<int> mBuiltRows; // the rows with a builder that have their elements
+	int mFocusedRow;
 
 	std::function<void(CursorState state)> mCursorChangedCallback;
 };
@@ -20,6 +20,9 @@ public:
 	void setValue(const std::string& val) override;
 	std::string getValue() const override;
 
+	// skips parsing the ISO string, for times that were parsed already
+	void setTime(const time_t& time);
+
 	void setFormat(const std::string& format);
 	void setDisplayRelative(bool displayRelative);
 
@@ -24,6 +24,8 @@ GridTileComponent::GridTileComponent(Window* window) : GuiComponent(window), mBa
 
 	mImage = std::make_shared<ImageComponent>(mWindow);
 	mImage->setOrigin(0.5f, 0.5f);
+	// Scrolling mustn't wait for the images of the tiles coming into view
+	mImage->setAsyncLoad(true);
 
 	mBackground.setOrigin(0.5f, 0.5f);
 
@@ -151,8 +153,17 @@ void GridTileComponent::reset()
 	setImage("");
 }
 
+Vector2f GridTileComponent::getImageMaxSize() const
+{
+	// the size of a selected tile, so the image isn't kept smaller than the tile zooms to
+	const Vector2f defaultSize = mDefaultProperties.mSize - mDefaultProperties.mPadding * 2;
+	const Vector2f selectedSize = mSelectedProperties.mSize - mSelectedProperties.mPadding * 2;
+	return Vector2f(Math::max(defaultSize.x(), selectedSize.x()), Math::max(defaultSize.y(), selectedSize.y()));
+}
+
 void GridTileComponent::setImage(const std::string& path)
 {
+	mImage->setMaxSize(getImageMaxSize());
 	mImage->setImage(path);
 
 	// Resize now to prevent flickering images when scrolling
@@ -167,6 +178,12 @@ void GridTileComponent::setImage(const std::shared_ptr<TextureResource>& texture
 	resize();
 }
 
+std::shared_ptr<TextureResource> GridTileComponent::prefetch(const std::string& path, TextureLoader::Priority priority)
+{
+	// the image is already sized for this tile by setImage()
+	return mImage->prefetch(path, priority);
+}
+
 void GridTileComponent::setSelected(bool selected, bool allowAnimation, Vector3f* pPosition, bool force)
 {
 	if (mSelected == selected && !force)
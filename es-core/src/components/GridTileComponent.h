@@ -28,12 +28,14 @@ public:
 	// to calculate the grid dimension before it instantiate the GridTileComponents
 	static Vector2f getDefaultTileSize();
 	Vector2f getSelectedTileSize() const;
+	Vector2f getImageMaxSize() const; // what images are sized to fit into
 	bool isSelected() const;
 
 	void reset();
 
 	void setImage(const std::string& path);
 	void setImage(const std::shared_ptr<TextureResource>& texture);
+	std::shared_ptr<TextureResource> prefetch(const std::string& path, TextureLoader::Priority priority); // see ImageComponent::prefetch
 	void setSelected(bool selected, bool allowAnimation = true, Vector3f* pPosition = NULL, bool force=false);
 	void setVisible(bool visible);
 
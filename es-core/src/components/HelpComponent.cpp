@@ -7,6 +7,9 @@
 #include "utils/StringUtil.h"
 #include "Log.h"
 #include "Settings.h"
+#include <sstream>
+
+static Setting<bool> sShowHelpPrompts("ShowHelpPrompts");
 
 #define OFFSET_X 12 // move the entire thing right by this amount (px)
 #define OFFSET_Y 12 // move the entire thing up by this amount (px)
@@ -45,23 +48,70 @@ void HelpComponent::setPrompts(const std::vector<HelpPrompt>& prompts)
 	updateGrid();
 }
 
+void HelpComponent::setPrompts(const std::vector<HelpPrompt>& prompts, const HelpStyle& style)
+{
+	mPrompts = prompts;
+	mStyle = style;
+	updateGrid();
+}
+
 void HelpComponent::setStyle(const HelpStyle& style)
 {
 	mStyle = style;
 	updateGrid();
 }
 
+std::string HelpComponent::getGridKey() const
+{
+	// the font is told apart by its address, the cached bars keep it alive
+	std::stringstream ss;
+	ss << mStyle.position.x() << "," << mStyle.position.y() << "," << mStyle.origin.x() << "," << mStyle.origin.y() << ","
+	   << mStyle.iconColor << "," << mStyle.textColor << "," << (size_t)mStyle.font.get();
+	for(auto it = mPrompts.cbegin(); it != mPrompts.cend(); it++)
+		ss << "\n" << it->first << "\t" << it->second;
+
+	return ss.str();
+}
+
 void HelpComponent::updateGrid()
 {
-	if(!Settings::getInstance()->getBool("ShowHelpPrompts") || mPrompts.empty())
+	if(!sShowHelpPrompts.get() || mPrompts.empty())
 	{
 		mGrid.reset();
+		mGridKey.clear();
 		return;
 	}
 
+	const std::string key = getGridKey();
+	if(mGrid && (key == mGridKey))
+		return;
+
+	auto it = mGridCache.begin();
+	while((it != mGridCache.end()) && (it->key != key))
+		it++;
+
+	if(it != mGridCache.end())
+		mGridCache.splice(mGridCache.begin(), mGridCache, it);
+	else
+	{
+		const CachedGrid cached = { key, buildGrid() };
+		mGridCache.push_front(cached);
+		if(mGridCache.size() > MAX_CACHED_GRIDS)
+			mGridCache.pop_back();
+	}
+
+	mGrid = mGridCache.front().grid;
+	mGridKey = key;
+
+	// it may have been built or last shown at another opacity
+	setOpacity(getOpacity());
+}
+
+std::shared_ptr<ComponentGrid> HelpComponent::buildGrid()
+{
 	std::shared_ptr<Font>& font = mStyle.font;
 
-	mGrid = std::make_shared<ComponentGrid>(mWindow, Vector2i((int)mPrompts.size() * 4, 1));
+	std::shared_ptr<ComponentGrid> grid = std::make_shared<ComponentGrid>(mWindow, Vector2i((int)mPrompts.size() * 4, 1));
 	// [icon] [spacer1] [text] [spacer2]
 
 	std::vector< std::shared_ptr<ImageComponent> > icons;
@@ -83,21 +133,23 @@ void HelpComponent::updateGrid()
 		width += icon->getSize().x() + lbl->getSize().x() + ICON_TEXT_SPACING + ENTRY_SPACING;
 	}
 
-	mGrid->setSize(width, height);
+	grid->setSize(width, height);
 	for(unsigned int i = 0; i < icons.size(); i++)
 	{
 		const int col = i*4;
-		mGrid->setColWidthPerc(col, icons.at(i)->getSize().x() / width);
-		mGrid->setColWidthPerc(col + 1, ICON_TEXT_SPACING / width);
-		mGrid->setColWidthPerc(col + 2, labels.at(i)->getSize().x() / width);
+		grid->setColWidthPerc(col, icons.at(i)->getSize().x() / width);
+		grid->setColWidthPerc(col + 1, ICON_TEXT_SPACING / width);
+		grid->setColWidthPerc(col + 2, labels.at(i)->getSize().x() / width);
 
-		mGrid->setEntry(icons.at(i), Vector2i(col, 0), false, false);
-		mGrid->setEntry(labels.at(i), Vector2i(col + 2, 0), false, false);
+		grid->setEntry(icons.at(i), Vector2i(col, 0), false, false);
+		grid->setEntry(labels.at(i), Vector2i(col + 2, 0), false, false);
 	}
 
-	mGrid->setPosition(Vector3f(mStyle.position.x(), mStyle.position.y(), 0.0f));
-	//mGrid->setPosition(OFFSET_X, Renderer::getScreenHeight() - mGrid->getSize().y() - OFFSET_Y);
-	mGrid->setOrigin(mStyle.origin);
+	grid->setPosition(Vector3f(mStyle.position.x(), mStyle.position.y(), 0.0f));
+	//grid->setPosition(OFFSET_X, Renderer::getScreenHeight() - grid->getSize().y() - OFFSET_Y);
+	grid->setOrigin(mStyle.origin);
+
+	return grid;
 }
 
 std::shared_ptr<TextureResource> HelpComponent::getIconTexture(const char* name)
@@ -127,6 +179,9 @@ void HelpComponent::setOpacity(unsigned char opacity)
 {
 	GuiComponent::setOpacity(opacity);
 
+	if(!mGrid)
+		return;
+
 	for(unsigned int i = 0; i < mGrid->getChildCount(); i++)
 	{
 		mGrid->getChild(i)->setOpacity(opacity);
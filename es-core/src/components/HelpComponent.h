@@ -4,6 +4,7 @@
 
 #include "GuiComponent.h"
 #include "HelpStyle.h"
+#include <list>
 
 class ComponentGrid;
 class ImageComponent;
@@ -16,6 +17,8 @@ public:
 
 	void clearPrompts();
 	void setPrompts(const std::vector<HelpPrompt>& prompts);
+	// Both at once, so the bar is only looked up or built once
+	void setPrompts(const std::vector<HelpPrompt>& prompts, const HelpStyle& style);
 
 	void render(const Transform4x4f& parent) override;
 	void setOpacity(unsigned char opacity) override;
@@ -28,6 +31,20 @@ private:
 
 	std::shared_ptr<ComponentGrid> mGrid;
 	void updateGrid();
+	std::shared_ptr<ComponentGrid> buildGrid();
+	std::string getGridKey() const;
+
+	// Bars built before, by their prompts and style. Scrolling through a list asks for the same few again and again,
+	// those are swapped in instead of being built again
+	struct CachedGrid
+	{
+		std::string key;
+		std::shared_ptr<ComponentGrid> grid;
+	};
+	std::list<CachedGrid> mGridCache; // most recently used first
+	std::string mGridKey;
+
+	static const size_t MAX_CACHED_GRIDS = 16;
 
 	std::vector<HelpPrompt> mPrompts;
 	HelpStyle mStyle;
@@ -4,7 +4,10 @@
 
 #include "components/ImageComponent.h"
 #include "resources/Font.h"
+#include "InputRepeat.h"
 #include "PowerSaver.h"
+#include <iterator>
+#include <unordered_map>
 
 enum CursorState
 {
@@ -19,33 +22,6 @@ enum ListLoopType
 	LIST_NEVER_LOOP
 };
 
-struct ScrollTier
-{
-	int length; // how long we stay on this level before going to the next
-	int scrollDelay; // how long between scrolls
-};
-
-struct ScrollTierList
-{
-	const int count;
-	const ScrollTier* tiers;
-};
-
-// default scroll tiers
-const ScrollTier QUICK_SCROLL_TIERS[] = {
-	{500, 500},
-	{2000, 114},
-	{4000, 32},
-	{0, 16}
-};
-const ScrollTierList LIST_SCROLL_STYLE_QUICK = { 4, QUICK_SCROLL_TIERS };
-
-const ScrollTier SLOW_SCROLL_TIERS[] = {
-	{500, 500},
-	{0, 200}
-};
-const ScrollTierList LIST_SCROLL_STYLE_SLOW = { 2, SLOW_SCROLL_TIERS };
-
 template <typename EntryData, typename UserData>
 class IList : public GuiComponent
 {
@@ -66,8 +42,7 @@ protected:
 	int mScrollTier;
 	int mScrollVelocity;
 
-	int mScrollTierAccumulator;
-	int mScrollCursorAccumulator;
+	InputRepeat mScrollRepeat;
 
 	unsigned char mTitleOverlayOpacity;
 	unsigned int mTitleOverlayColor;
@@ -81,14 +56,12 @@ protected:
 
 public:
 	IList(Window* window, const ScrollTierList& tierList = LIST_SCROLL_STYLE_QUICK, const ListLoopType& loopType = LIST_PAUSE_AT_END) : GuiComponent(window),
-		mGradient(window), mTierList(tierList), mLoopType(loopType)
+		mScrollRepeat(tierList), mGradient(window), mTierList(tierList), mLoopType(loopType)
 	{
 		mCursor = 0;
 		mViewportTop = 0;
 		mScrollTier = 0;
 		mScrollVelocity = 0;
-		mScrollTierAccumulator = 0;
-		mScrollCursorAccumulator = 0;
 
 		mTitleOverlayOpacity = 0x00;
 		mTitleOverlayColor = 0xFFFFFF00;
@@ -192,8 +165,89 @@ public:
 		return false;
 	}
 
+	// Makes the entries the ones of objects, in that order. Only the entries between the first and the last object
+	// that differs are moved, the others keep their data. makeEntry(obj) builds the entries of objects that weren't
+	// listed and of refresh, which changed. The cursor stays on its object if that's still listed.
+	template<typename MakeEntry>
+	void updateEntries(const std::vector<UserData>& objects, const UserData& refresh, MakeEntry makeEntry)
+	{
+		const size_t oldSize = mEntries.size();
+		const size_t newSize = objects.size();
+
+		size_t prefix = 0;
+		while(prefix < oldSize && prefix < newSize && mEntries[prefix].object == objects[prefix])
+			prefix++;
+
+		size_t suffix = 0;
+		while(suffix < oldSize - prefix && suffix < newSize - prefix && mEntries[oldSize - 1 - suffix].object == objects[newSize - 1 - suffix])
+			suffix++;
+
+		const bool hadCursor = mCursor >= 0 && (size_t)mCursor < oldSize;
+		const UserData cursorObject = hadCursor ? mEntries[mCursor].object : UserData();
+		bool refreshed = false;
+
+		if(prefix + suffix < oldSize || prefix + suffix < newSize)
+		{
+			std::unordered_map<UserData, size_t> oldMiddle;
+			for(size_t i = prefix; i < oldSize - suffix; i++)
+				oldMiddle[mEntries[i].object] = i;
+
+			std::vector<Entry> middle;
+			middle.reserve(newSize - prefix - suffix);
+			for(size_t i = prefix; i < newSize - suffix; i++)
+			{
+				auto it = oldMiddle.find(objects[i]);
+				if(it != oldMiddle.cend() && objects[i] != refresh)
+					middle.push_back(std::move(mEntries[it->second]));
+				else
+					middle.push_back(makeEntry(objects[i]));
+
+				refreshed = refreshed || objects[i] == refresh;
+			}
+
+			mEntries.erase(mEntries.begin() + prefix, mEntries.end() - suffix);
+			mEntries.insert(mEntries.begin() + prefix, std::make_move_iterator(middle.begin()), std::make_move_iterator(middle.end()));
+		}
+
+		// refresh didn't move, it's only rebuilt
+		for(auto it = mEntries.begin(); !refreshed && it != mEntries.end(); it++)
+		{
+			if(it->object == refresh)
+			{
+				*it = makeEntry(refresh);
+				refreshed = true;
+			}
+		}
+
+		if(hadCursor && (size_t)mCursor >= oldSize - suffix)
+		{
+			mCursor += (int)newSize - (int)oldSize;
+		}
+		else if(hadCursor && (size_t)mCursor >= prefix)
+		{
+			// the cursor's entry moved, or it's gone and whatever took its place gets the cursor
+			for(size_t i = prefix; i < newSize - suffix; i++)
+			{
+				if(mEntries[i].object == cursorObject)
+				{
+					mCursor = (int)i;
+					break;
+				}
+			}
+		}
+
+		if(mCursor >= (int)mEntries.size())
+			mCursor = std::max(0, (int)mEntries.size() - 1);
+
+		onCursorChanged(CURSOR_STOPPED);
+	}
+
 	inline int size() const { return (int)mEntries.size(); }
 
+	// For what's around the cursor, like loading the images shown next
+	inline int getCursorIndex() const { return mCursor; }
+	inline const UserData& getObjectAt(int index) const { return mEntries.at(index).object; }
+
 protected:
 	void remove(typename std::vector<Entry>::const_iterator& it)
 	{
@@ -217,8 +271,11 @@ protected:
 
 		mScrollVelocity = velocity;
 		mScrollTier = 0;
-		mScrollTierAccumulator = 0;
-		mScrollCursorAccumulator = 0;
+
+		if(velocity != 0)
+			mScrollRepeat.start();
+		else
+			mScrollRepeat.stop();
 
 		int prevCursor = mCursor;
 		scroll(mScrollVelocity);
@@ -240,24 +297,9 @@ protected:
 		if(mScrollVelocity == 0 || size() < 2)
 			return;
 
-		mScrollCursorAccumulator += deltaTime;
-		mScrollTierAccumulator += deltaTime;
-
 		// we delay scrolling until after scroll tier has updated so isScrolling() returns accurately during onCursorChanged callbacks
-		// we don't just do scroll tier first because it would not catch the scrollDelay == tier length case
-		int scrollCount = 0;
-		while(mScrollCursorAccumulator >= mTierList.tiers[mScrollTier].scrollDelay)
-		{
-			mScrollCursorAccumulator -= mTierList.tiers[mScrollTier].scrollDelay;
-			scrollCount++;
-		}
-
-		// are we ready to go even FASTER?
-		while(mScrollTier < mTierList.count - 1 && mScrollTierAccumulator >= mTierList.tiers[mScrollTier].length)
-		{
-			mScrollTierAccumulator -= mTierList.tiers[mScrollTier].length;
-			mScrollTier++;
-		}
+		const int scrollCount = mScrollRepeat.update();
+		mScrollTier = mScrollRepeat.getTier();
 
 		// actually perform the scrolling
 		for(int i = 0; i < scrollCount; i++)
@@ -5,6 +5,8 @@
 #include "Settings.h"
 #include "ThemeData.h"
 
+static Setting<bool> sDebugImage("DebugImage");
+
 Vector2i ImageComponent::getTextureSize() const
 {
 	if(mTexture)
@@ -21,7 +23,7 @@ Vector2f ImageComponent::getSize() const
 ImageComponent::ImageComponent(Window* window, bool forceLoad, bool dynamic) : GuiComponent(window),
 	mTargetIsMax(false), mTargetIsMin(false), mFlipX(false), mFlipY(false), mTargetSize(0, 0), mColorShift(0xFFFFFFFF),
 	mColorShiftEnd(0xFFFFFFFF), mColorGradientHorizontal(true), mForceLoad(forceLoad), mDynamic(dynamic),
-	mFadeOpacity(0), mFading(false), mRotateByTargetSize(false), mTopLeftCrop(0.0f, 0.0f), mBottomRightCrop(1.0f, 1.0f)
+	mFadeOpacity(0), mFading(false), mRotateByTargetSize(false), mAsync(false), mDefer(false), mDeferredPending(false), mDeferredTile(false), mTopLeftCrop(0.0f, 0.0f), mBottomRightCrop(1.0f, 1.0f)
 {
 	updateColors();
 }
@@ -132,14 +134,30 @@ void ImageComponent::setDefaultImage(std::string path)
 
 void ImageComponent::setImage(std::string path, bool tile)
 {
+	if(mDefer)
+	{
+		mTexture.reset();
+		mDeferredPath = path;
+		mDeferredTile = tile;
+		mDeferredPending = true;
+		return;
+	}
+
+	loadImage(path, tile);
+}
+
+void ImageComponent::loadImage(const std::string& path, bool tile)
+{
+	mDeferredPending = false;
+
 	if(path.empty() || !ResourceManager::getInstance()->fileExists(path))
 	{
 		if(mDefaultPath.empty() || !ResourceManager::getInstance()->fileExists(mDefaultPath))
 			mTexture.reset();
 		else
-			mTexture = TextureResource::get(mDefaultPath, tile, mForceLoad, mDynamic);
+			mTexture = TextureResource::get(mDefaultPath, tile, mForceLoad, mDynamic, mTargetSize, mTargetIsMax, mAsync);
 	} else {
-		mTexture = TextureResource::get(path, tile, mForceLoad, mDynamic);
+		mTexture = TextureResource::get(path, tile, mForceLoad, mDynamic, mTargetSize, mTargetIsMax, mAsync);
 	}
 
 	resize();
@@ -147,6 +165,7 @@ void ImageComponent::setImage(std::string path, bool tile)
 
 void ImageComponent::setImage(const char* path, size_t length, bool tile)
 {
+	mDeferredPending = false;
 	mTexture.reset();
 
 	mTexture = TextureResource::get("", tile);
@@ -157,6 +176,7 @@ void ImageComponent::setImage(const char* path, size_t length, bool tile)
 
 void ImageComponent::setImage(const std::shared_ptr<TextureResource>& texture)
 {
+	mDeferredPending = false;
 	mTexture = texture;
 	resize();
 }
@@ -195,6 +215,26 @@ void ImageComponent::setRotateByTargetSize(bool rotate)
 	mRotateByTargetSize = rotate;
 }
 
+void ImageComponent::setAsyncLoad(bool async)
+{
+	mAsync = async;
+}
+
+void ImageComponent::setDeferLoad(bool defer)
+{
+	mDefer = defer;
+}
+
+std::shared_ptr<TextureResource> ImageComponent::prefetch(const std::string& path, TextureLoader::Priority priority)
+{
+	if(path.empty() || !ResourceManager::getInstance()->fileExists(path))
+		return nullptr;
+
+	std::shared_ptr<TextureResource> texture = TextureResource::get(path, false, false, mDynamic, mTargetSize, mTargetIsMax, true);
+	texture->prefetch(priority);
+	return texture;
+}
+
 void ImageComponent::cropLeft(float percent)
 {
 	assert(percent >= 0.0f && percent <= 1.0f);
@@ -225,6 +265,9 @@ void ImageComponent::crop(float left, float top, float right, float bot)
 	cropTop(top);
 	cropRight(right);
 	cropBot(bot);
+
+	// in place right away, resize() sets them again once it's done with the size
+	updateVertices();
 }
 
 void ImageComponent::uncrop()
@@ -322,12 +365,16 @@ void ImageComponent::render(const Transform4x4f& parentTrans)
 	if (!isVisible())
 		return;
 
+	// the size comes with the texture, it has to be there before the transform is taken
+	if(mDeferredPending)
+		loadImage(mDeferredPath, mDeferredTile);
+
 	Transform4x4f trans = parentTrans * getTransform();
 	Renderer::setMatrix(trans);
 
 	if(mTexture && mOpacity > 0)
 	{
-		if(Settings::getInstance()->getBool("DebugImage")) {
+		if(sDebugImage.get()) {
 			Vector2f targetSizePos = (mTargetSize - mSize) * mOrigin * -1;
 			Renderer::drawRect(targetSizePos.x(), targetSizePos.y(), mTargetSize.x(), mTargetSize.y(), 0xFF000033, 0xFF000033);
 			Renderer::drawRect(0.0f, 0.0f, mSize.x(), mSize.y(), 0x00000033, 0x00000033);
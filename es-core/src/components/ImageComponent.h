@@ -3,6 +3,7 @@
 #define ES_CORE_COMPONENTS_IMAGE_COMPONENT_H
 
 #include "renderers/Renderer.h"
+#include "resources/TextureDataManager.h"
 #include "math/Vector2i.h"
 #include "GuiComponent.h"
 
@@ -62,6 +63,12 @@ public:
 	void setFlipY(bool flip); // Mirror on the Y axis.
 
 	void setRotateByTargetSize(bool rotate);  // Flag indicating if rotation should be based on target size vs. actual size.
+	void setAsyncLoad(bool async); // Load images set from now on in the background, they fade in once they're loaded.
+	void setDeferLoad(bool defer); // Images set from now on are only looked up once they're rendered, the size isn't known until then.
+
+	// Starts loading an image that's likely shown next at the size this component would show it at.
+	// It's only queued while the returned texture is kept.
+	std::shared_ptr<TextureResource> prefetch(const std::string& path, TextureLoader::Priority priority = TextureLoader::PRIORITY_NEXT);
 
 	// Returns the size of the current texture, or (0, 0) if none is loaded.  May be different than drawn size (use getSize() for that).
 	Vector2i getTextureSize() const;
@@ -91,6 +98,7 @@ private:
 	void updateVertices();
 	void updateColors();
 	void fadeIn(bool textureLoaded);
+	void loadImage(const std::string& path, bool tile);
 
 	unsigned int mColorShift;
 	unsigned int mColorShiftEnd;
@@ -104,6 +112,11 @@ private:
 	bool					mForceLoad;
 	bool					mDynamic;
 	bool					mRotateByTargetSize;
+	bool					mAsync;
+	bool					mDefer;
+	bool					mDeferredPending;
+	bool					mDeferredTile;
+	std::string				mDeferredPath;
 
 	Vector2f mTopLeftCrop;
 	Vector2f mBottomRightCrop;
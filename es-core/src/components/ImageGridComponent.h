@@ -6,11 +6,16 @@
 #include "animations/LambdaAnimation.h"
 #include "components/IList.h"
 #include "resources/TextureResource.h"
+#include "resources/TextureVariant.h"
 #include "GridTileComponent.h"
 #include "Sound.h"
 
 #define EXTRAITEMS 2
 
+// rows prefetched past the buffered ones in the scroll direction, by scroll tier
+#define PREFETCH_ROWS_SLOW 1
+#define PREFETCH_ROWS_FAST 3
+
 enum ScrollDirection
 {
 	SCROLL_VERTICALLY,
@@ -52,6 +57,16 @@ public:
 	ImageGridComponent(Window* window);
 
 	void add(const std::string& name, const std::string& imagePath, const T& obj);
+	// the tile add() would append, for updateEntries()
+	static typename IList<ImageGridData, T>::Entry makeEntry(const std::string& name, const std::string& imagePath, const T& obj);
+
+	// IList::updateEntries(), the tiles show the new entries from the next frame on
+	template<typename MakeEntry>
+	void updateEntries(const std::vector<T>& objects, const T& refresh, MakeEntry makeEntry)
+	{
+		IList<ImageGridData, T>::updateEntries(objects, refresh, makeEntry);
+		mEntriesDirty = true;
+	}
 
 	bool input(InputConfig* config, Input input) override;
 	void update(int deltaTime) override;
@@ -72,6 +87,7 @@ private:
 	void buildTiles();
 	void updateTiles(bool allowAnimation = true, bool updateSelectedState = true);
 	void updateTileAtPos(int tilePos, int imgPos, bool allowAnimation, bool updateSelectedState);
+	void prefetchRows();
 	void calcGridDimension();
 	bool isScrollLoop();
 
@@ -95,6 +111,9 @@ private:
 	Vector2i mGridDimension;
 	std::shared_ptr<ThemeData> mTheme;
 	std::vector< std::shared_ptr<GridTileComponent> > mTiles;
+	std::vector<std::string> mTileImages; // the image each tile shows, empty for none or a default one
+	std::map< std::string, std::shared_ptr<TextureResource> > mRecycledTextures; // the textures the tiles showed before they moved on
+	std::vector< std::shared_ptr<TextureResource> > mPrefetched;
 
 	int mStartPosition;
 
@@ -143,14 +162,19 @@ ImageGridComponent<T>::ImageGridComponent(Window* window) : IList<ImageGridData,
 
 template<typename T>
 void ImageGridComponent<T>::add(const std::string& name, const std::string& imagePath, const T& obj)
+{
+	static_cast<IList< ImageGridData, T >*>(this)->add(makeEntry(name, imagePath, obj));
+	mEntriesDirty = true;
+}
+
+template<typename T>
+typename IList<ImageGridData, T>::Entry ImageGridComponent<T>::makeEntry(const std::string& name, const std::string& imagePath, const T& obj)
 {
 	typename IList<ImageGridData, T>::Entry entry;
 	entry.name = name;
 	entry.object = obj;
 	entry.data.texturePath = imagePath;
-
-	static_cast<IList< ImageGridData, T >*>(this)->add(entry);
-	mEntriesDirty = true;
+	return entry;
 }
 
 template<typename T>
@@ -211,8 +235,19 @@ void ImageGridComponent<T>::render(const Transform4x4f& parentTrans)
 
 	if(mEntriesDirty)
 	{
+		// the entries changed, an image may be shown for another entry now
+		mTileImages.assign(mTiles.size(), std::string());
 		updateTiles();
 		mEntriesDirty = false;
+
+		// the reduced copies of the other images are written in the background, before they're scrolled to
+		TextureVariant::cancelGeneration();
+		if (!mTiles.empty())
+		{
+			const Vector2f imageSize = mTiles.front()->getImageMaxSize();
+			for (auto it = mEntries.cbegin(); it != mEntries.cend(); ++it)
+				TextureVariant::generate(it->data.texturePath, imageSize.x(), imageSize.y(), true);
+		}
 	}
 
 	// Create a clipRect to hide tiles used to buffer texture loading
@@ -232,7 +267,25 @@ void ImageGridComponent<T>::render(const Transform4x4f& parentTrans)
 
 		// If it's the selected image, keep it for later, otherwise render it now
 		if(tile->isSelected())
+		{
 			selectedTile = tile;
+			continue;
+		}
+
+		// Tiles buffering the rows next to the screen are clipped anyway, their images only have to be loaded
+		// next, the row after those only in the background
+		const Vector2f center(tile->getPosition().x() + offsetX, tile->getPosition().y() + offsetY);
+		const Vector2f distance(Math::max(Math::max(-center.x(), center.x() - mSize.x()) - (mTileSize.x() / 2), 0.0f),
+		                        Math::max(Math::max(-center.y(), center.y() - mSize.y()) - (mTileSize.y() / 2), 0.0f));
+
+		if((distance.x() > 0.0f) || (distance.y() > 0.0f))
+		{
+			std::shared_ptr<TextureResource> texture = tile->getTexture();
+			const bool next = (distance.x() <= (mTileSize.x() + mMargin.x())) && (distance.y() <= (mTileSize.y() + mMargin.y()));
+
+			if(texture)
+				texture->prefetch(next ? TextureLoader::PRIORITY_NEXT : TextureLoader::PRIORITY_PRELOAD);
+		}
 		else
 			tile->render(tileTrans);
 	}
@@ -524,6 +577,8 @@ void ImageGridComponent<T>::buildTiles()
 {
 	mStartPosition = 0;
 	mTiles.clear();
+	mTileImages.clear();
+	mPrefetched.clear();
 
 	calcGridDimension();
 
@@ -576,6 +631,7 @@ void ImageGridComponent<T>::buildTiles()
 				tile->forceSize(mTileSize, mAutoLayoutZoom);
 
 			mTiles.push_back(tile);
+			mTileImages.push_back(std::string());
 		}
 	}
 }
@@ -596,16 +652,18 @@ void ImageGridComponent<T>::updateTiles(bool allowAnimation, bool updateSelected
 			tile->setSelected(false);
 			tile->setImage(mDefaultGameTexture);
 			tile->setVisible(false);
+			mTileImages[ti].clear();
 		}
+		mPrefetched.clear();
 		return;
 	}
 
-	// Temporary store previous textures so they can't be unloaded
-	std::vector<std::shared_ptr<TextureResource>> previousTextures;
+	// Tiles keep the images that only moved to another tile, so a scroll by one row only looks up the new row.
+	// This also keeps the previous textures from being unloaded
 	for (int ti = 0; ti < (int)mTiles.size(); ti++)
 	{
-		std::shared_ptr<GridTileComponent> tile = mTiles.at(ti);
-		previousTextures.push_back(tile->getTexture());
+		if (!mTileImages[ti].empty())
+			mRecycledTextures[mTileImages[ti]] = mTiles.at(ti)->getTexture();
 	}
 
 	// Update the tiles
@@ -613,6 +671,10 @@ void ImageGridComponent<T>::updateTiles(bool allowAnimation, bool updateSelected
 	for (int ti = 0; ti < (int)mTiles.size(); ti++)
 		updateTileAtPos(ti, firstImg + ti, allowAnimation, updateSelectedState);
 
+	mRecycledTextures.clear();
+
+	prefetchRows();
+
 	if (updateSelectedState)
 		mLastCursor = mCursor;
 
@@ -640,19 +702,31 @@ void ImageGridComponent<T>::updateTileAtPos(int tilePos, int imgPos, bool allowA
 
 		tile->reset();
 		tile->setVisible(false);
+		mTileImages[tilePos].clear();
 	}
 	else
 	{
 		tile->setVisible(true);
 
-		std::string imagePath = mEntries.at(imgPos).data.texturePath;
+		const std::string& imagePath = mEntries.at(imgPos).data.texturePath;
+		auto recycled = imagePath.empty() ? mRecycledTextures.end() : mRecycledTextures.find(imagePath);
 
-		if (ResourceManager::getInstance()->fileExists(imagePath))
+		if (recycled != mRecycledTextures.end())
+		{
+			if (tile->getTexture() != recycled->second)
+				tile->setImage(recycled->second);
+			mTileImages[tilePos] = imagePath;
+		}
+		else if (ResourceManager::getInstance()->fileExists(imagePath))
+		{
 			tile->setImage(imagePath);
-		else if (mEntries.at(imgPos).object->getType() == 2)
-			tile->setImage(mDefaultFolderTexture);
+			mTileImages[tilePos] = imagePath;
+		}
 		else
-			tile->setImage(mDefaultGameTexture);
+		{
+			tile->setImage((mEntries.at(imgPos).object->getType() == 2) ? mDefaultFolderTexture : mDefaultGameTexture);
+			mTileImages[tilePos].clear();
+		}
 
 		if (updateSelectedState)
 		{
@@ -674,6 +748,39 @@ void ImageGridComponent<T>::updateTileAtPos(int tilePos, int imgPos, bool allowA
 	}
 }
 
+// Start loading the images of the rows about to scroll into the buffered ones, the faster the list scrolls the further ahead
+template<typename T>
+void ImageGridComponent<T>::prefetchRows()
+{
+	const int dimOpposite = isVertical() ? mGridDimension.x() : mGridDimension.y();
+	const int rows = (mScrollTier > 0) ? PREFETCH_ROWS_FAST : PREFETCH_ROWS_SLOW;
+	const bool forward = mCameraDirection < 0.0f;
+	const int firstImg = mStartPosition - EXTRAITEMS * dimOpposite;
+	const int start = forward ? (firstImg + (int)mTiles.size()) : (firstImg - (rows * dimOpposite));
+
+	// the new list is filled first so images still needed aren't dropped
+	std::vector< std::shared_ptr<TextureResource> > prefetched;
+	for (int i = 0; i < rows * dimOpposite; i++)
+	{
+		int imgPos = start + i;
+
+		if (isScrollLoop() && size() > 0)
+			imgPos = ((imgPos % size()) + size()) % size();
+
+		if (imgPos < 0 || imgPos >= size())
+			continue;
+
+		// the row right after the buffered ones is next, the others only load in the background
+		const int row = forward ? (i / dimOpposite) : (rows - 1 - (i / dimOpposite));
+		std::shared_ptr<TextureResource> texture = mTiles.front()->prefetch(mEntries.at(imgPos).data.texturePath,
+			(row == 0) ? TextureLoader::PRIORITY_NEXT : TextureLoader::PRIORITY_PRELOAD);
+
+		if (texture)
+			prefetched.push_back(texture);
+	}
+	mPrefetched.swap(prefetched);
+}
+
 // Calculate how much tiles of size mTileSize we can fit in a grid of size mSize using a margin of size mMargin
 template<typename T>
 void ImageGridComponent<T>::calcGridDimension()
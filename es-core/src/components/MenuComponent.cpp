@@ -66,6 +66,20 @@ void MenuComponent::updateSize()
 	setSize(width, height);
 }
 
+void MenuComponent::render(const Transform4x4f& parentTrans)
+{
+	if(!isVisible())
+		return;
+
+	// a menu mostly sits there while it's open, the frame's shadow reaches past its size
+	const Transform4x4f trans = parentTrans * getTransform();
+
+	mRenderCache.render(trans, mBackground.getPosition().v2(), mBackground.getSize(), [this](const Transform4x4f& _trans)
+	{
+		renderChildren(_trans);
+	});
+}
+
 void MenuComponent::onSizeChanged()
 {
 	mBackground.fitTo(mSize, Vector3f::Zero(), Vector2f(-32, -32));
@@ -6,6 +6,7 @@
 #include "components/ComponentList.h"
 #include "components/NinePatchComponent.h"
 #include "components/TextComponent.h"
+#include "renderers/RenderCache.h"
 #include "utils/StringUtil.h"
 
 class ButtonComponent;
@@ -22,8 +23,11 @@ public:
 	MenuComponent(Window* window, const char* title, const std::shared_ptr<Font>& titleFont = Font::get(FONT_SIZE_LARGE));
 
 	void onSizeChanged() override;
+	void render(const Transform4x4f& parentTrans) override;
 
 	inline void addRow(const ComponentListRow& row, bool setCursorHere = false) { mList->addRow(row, setCursorHere); updateSize(); }
+	inline void addRow(const std::function<void(ComponentListRow& row)>& builder, float height, bool setCursorHere = false) { mList->addRow(builder, height, setCursorHere); updateSize(); }
+	inline void rebuildRows() { mList->rebuildRows(); }
 
 	inline void addWithLabel(const std::string& label, const std::shared_ptr<GuiComponent>& comp, bool setCursorHere = false, bool invert_when_selected = true)
 	{
@@ -49,6 +53,7 @@ private:
 
 	NinePatchComponent mBackground;
 	ComponentGrid mGrid;
+	RenderCache mRenderCache;
 
 	std::shared_ptr<TextComponent> mTitle;
 	std::shared_ptr<ComponentList> mList;
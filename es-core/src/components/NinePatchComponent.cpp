@@ -8,7 +8,8 @@ NinePatchComponent::NinePatchComponent(Window* window, const std::string& path,
 	mCornerSize(16, 16),
 	mEdgeColor(edgeColor), mCenterColor(centerColor),
 	mPath(path),
-	mVertices(NULL)
+	mVertices(NULL),
+	mVerticesSize(Vector2f::Zero())
 {
 	if(!mPath.empty())
 		buildVertices();
@@ -25,6 +26,9 @@ void NinePatchComponent::updateColors()
 	const unsigned int edgeColor   = Renderer::convertColor(mEdgeColor);
 	const unsigned int centerColor = Renderer::convertColor(mCenterColor);
 
+	if(mVertices == NULL)
+		return;
+
 	for(int i = 0; i < 6*9; ++i)
 		mVertices[i].col = edgeColor;
 
@@ -34,19 +38,23 @@ void NinePatchComponent::updateColors()
 
 void NinePatchComponent::buildVertices()
 {
-	if(mVertices != NULL)
-		delete[] mVertices;
-
 	mTexture = TextureResource::get(mPath);
 
 	if(mTexture->getSize() == Vector2i::Zero())
 	{
+		if(mVertices != NULL)
+			delete[] mVertices;
+
 		mVertices = NULL;
 		LOG(LogWarning) << "NinePatchComponent missing texture!";
 		return;
 	}
 
-	mVertices = new Renderer::Vertex[6 * 9];
+	// the vertices are only ever rewritten in place, the count never changes
+	if(mVertices == NULL)
+		mVertices = new Renderer::Vertex[6 * 9];
+
+	mVerticesSize = mSize;
 
 	const Vector2f texSize = Vector2f((float)mTexture->getSize().x(), (float)mTexture->getSize().y());
 
@@ -110,6 +118,10 @@ void NinePatchComponent::render(const Transform4x4f& parentTrans)
 
 void NinePatchComponent::onSizeChanged()
 {
+	// setSize() calls this even when the size stays the same, like the grid tiles do every frame
+	if((mVertices != NULL) && (mSize == mVerticesSize))
+		return;
+
 	buildVertices();
 }
 
@@ -120,7 +132,12 @@ const Vector2f& NinePatchComponent::getCornerSize() const
 
 void NinePatchComponent::setCornerSize(int sizeX, int sizeY)
 {
-	mCornerSize = Vector2f(sizeX, sizeY);
+	const Vector2f cornerSize = Vector2f(sizeX, sizeY);
+
+	if((mVertices != NULL) && (cornerSize == mCornerSize))
+		return;
+
+	mCornerSize = cornerSize;
 	buildVertices();
 }
 
@@ -137,18 +154,27 @@ void NinePatchComponent::fitTo(Vector2f size, Vector3f position, Vector2f paddin
 
 void NinePatchComponent::setImagePath(const std::string& path)
 {
+	if((mVertices != NULL) && (path == mPath))
+		return;
+
 	mPath = path;
 	buildVertices();
 }
 
 void NinePatchComponent::setEdgeColor(unsigned int edgeColor)
 {
+	if(edgeColor == mEdgeColor)
+		return;
+
 	mEdgeColor = edgeColor;
 	updateColors();
 }
 
 void NinePatchComponent::setCenterColor(unsigned int centerColor)
 {
+	if(centerColor == mCenterColor)
+		return;
+
 	mCenterColor = centerColor;
 	updateColors();
 }
@@ -45,6 +45,7 @@ private:
 	void updateColors();
 
 	Renderer::Vertex* mVertices;
+	Vector2f mVerticesSize; // mSize the vertices were built for
 
 	std::string mPath;
 	Vector2f mCornerSize;
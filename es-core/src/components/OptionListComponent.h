@@ -40,72 +40,64 @@ private:
 			mMenu(window, title.c_str()), mParent(parent)
 		{
 			auto font = Font::get(FONT_SIZE_MEDIUM);
-			ComponentListRow row;
-
-			// for select all/none
-			std::vector<ImageComponent*> checkboxes;
 
+			// filter lists can run into the thousands, only the rows near the screen are made
 			for(auto it = mParent->mEntries.begin(); it != mParent->mEntries.end(); it++)
 			{
-				row.elements.clear();
-				row.addElement(std::make_shared<TextComponent>(mWindow, Utils::String::toUpper(it->name), font, 0x777777FF), true);
-
 				OptionListData& e = *it;
 
-				if(mParent->mMultiSelect)
+				mMenu.addRow([this, font, &e](ComponentListRow& row)
 				{
-					// add checkbox
-					auto checkbox = std::make_shared<ImageComponent>(mWindow);
-					checkbox->setImage(it->selected ? CHECKED_PATH : UNCHECKED_PATH);
-					checkbox->setResize(0, font->getLetterHeight());
-					row.addElement(checkbox, false);
-
-					// input handler
-					// update checkbox state & selected value
-					row.makeAcceptInputHandler([this, &e, checkbox]
+					row.addElement(std::make_shared<TextComponent>(mWindow, Utils::String::toUpper(e.name), font, 0x777777FF), true);
+
+					if(mParent->mMultiSelect)
 					{
-						e.selected = !e.selected;
+						// add checkbox
+						auto checkbox = std::make_shared<ImageComponent>(mWindow);
 						checkbox->setImage(e.selected ? CHECKED_PATH : UNCHECKED_PATH);
-						mParent->onSelectedChanged();
-					});
-
-					// for select all/none
-					checkboxes.push_back(checkbox.get());
-				}else{
-					// input handler for non-multiselect
-					// update selected value and close
-					row.makeAcceptInputHandler([this, &e]
-					{
-						mParent->mEntries.at(mParent->getSelectedId()).selected = false;
-						e.selected = true;
-						mParent->onSelectedChanged();
-						delete this;
-					});
-				}
-
+						checkbox->setResize(0, font->getLetterHeight());
+						row.addElement(checkbox, false);
+
+						// input handler
+						// update checkbox state & selected value
+						row.makeAcceptInputHandler([this, &e, checkbox]
+						{
+							e.selected = !e.selected;
+							checkbox->setImage(e.selected ? CHECKED_PATH : UNCHECKED_PATH);
+							mParent->onSelectedChanged();
+						});
+					}else{
+						// input handler for non-multiselect
+						// update selected value and close
+						row.makeAcceptInputHandler([this, &e]
+						{
+							mParent->mEntries.at(mParent->getSelectedId()).selected = false;
+							e.selected = true;
+							mParent->onSelectedChanged();
+							delete this;
+						});
+					}
+				}, font->getHeight(),
 				// also set cursor to this row if we're not multi-select and this row is selected
-				mMenu.addRow(row, (!mParent->mMultiSelect && it->selected));
+				(!mParent->mMultiSelect && it->selected));
 			}
 
 			mMenu.addButton("BACK", "accept", [this] { delete this; });
 
 			if(mParent->mMultiSelect)
 			{
-				mMenu.addButton("SELECT ALL", "select all", [this, checkboxes] {
+				// the checkboxes of the built rows are made again with the new state
+				mMenu.addButton("SELECT ALL", "select all", [this] {
 					for(unsigned int i = 0; i < mParent->mEntries.size(); i++)
-					{
 						mParent->mEntries.at(i).selected = true;
-						checkboxes.at(i)->setImage(CHECKED_PATH);
-					}
+					mMenu.rebuildRows();
 					mParent->onSelectedChanged();
 				});
 
-				mMenu.addButton("SELECT NONE", "select none", [this, checkboxes] {
+				mMenu.addButton("SELECT NONE", "select none", [this] {
 					for(unsigned int i = 0; i < mParent->mEntries.size(); i++)
-					{
 						mParent->mEntries.at(i).selected = false;
-						checkboxes.at(i)->setImage(UNCHECKED_PATH);
-					}
+					mMenu.rebuildRows();
 					mParent->onSelectedChanged();
 				});
 			}
@@ -221,6 +213,8 @@ public:
 
 	std::vector<T> getSelectedObjects()
 	{
+		populate();
+
 		std::vector<T> ret;
 		for(auto it = mEntries.cbegin(); it != mEntries.cend(); it++)
 		{
@@ -247,11 +241,29 @@ public:
 		e.selected = selected;
 
 		mEntries.push_back(e);
+
+		// counted once they're all there
+		if(!mPopulating)
+			onSelectedChanged();
+	}
+
+	// The entries of long lists, like the filters of a large library, are only added by populate once the list is
+	// opened or what's selected is asked for, until then selectedCount is shown as selected. Multi-select only
+	void setPopulator(const std::function<void()>& populate, unsigned int selectedCount)
+	{
+		assert(mMultiSelect);
+		mEntries.clear();
+		mPopulate = populate;
+		mSelectedCount = selectedCount;
 		onSelectedChanged();
 	}
 
+	bool isPopulated() const { return !mPopulate; }
+
 	void selectAll()
 	{
+		populate();
+
 		for(unsigned int i = 0; i < mEntries.size(); i++)
 		{
 			mEntries.at(i).selected = true;
@@ -261,6 +273,21 @@ public:
 
 	void selectNone()
 	{
+		// still not populated until it's needed, none of what's added then is selected
+		if(mPopulate)
+		{
+			const std::function<void()> populate = mPopulate;
+			mPopulate = [this, populate]
+			{
+				populate();
+				for(unsigned int i = 0; i < mEntries.size(); i++)
+					mEntries.at(i).selected = false;
+			};
+			mSelectedCount = 0;
+			onSelectedChanged();
+			return;
+		}
+
 		for(unsigned int i = 0; i < mEntries.size(); i++)
 		{
 			mEntries.at(i).selected = false;
@@ -284,16 +311,43 @@ private:
 
 	void open()
 	{
+		populate();
 		mWindow->pushGui(new OptionListPopup(mWindow, this, mName));
 	}
 
+	void populate()
+	{
+		if(!mPopulate)
+			return;
+
+		const std::function<void()> populate = mPopulate;
+		mPopulate = nullptr;
+
+		mPopulating = true;
+		populate();
+		mPopulating = false;
+
+		onSelectedChanged();
+	}
+
 	void onSelectedChanged()
 	{
 		if(mMultiSelect)
 		{
+			unsigned int selectedCount = mSelectedCount;
+			if(!mPopulate)
+			{
+				selectedCount = 0;
+				for(auto it = mEntries.cbegin(); it != mEntries.cend(); it++)
+				{
+					if(it->selected)
+						selectedCount++;
+				}
+			}
+
 			// display # selected
 			std::stringstream ss;
-			ss << getSelectedObjects().size() << " SELECTED";
+			ss << selectedCount << " SELECTED";
 			mText.setText(ss.str());
 			mText.setSize(0, mText.getSize().y());
 			setSize(mText.getSize().x() + mRightArrow.getSize().x() + 24, mText.getSize().y());
@@ -334,6 +388,10 @@ private:
 	ImageComponent mRightArrow;
 
 	std::vector<OptionListData> mEntries;
+
+	std::function<void()> mPopulate; // set until the entries are added
+	unsigned int mSelectedCount = 0; // shown until then
+	bool mPopulating = false;
 };
 
 #endif // ES_CORE_COMPONENTS_OPTION_LIST_COMPONENT_H
@@ -5,8 +5,14 @@
 #define MOVE_REPEAT_DELAY 500
 #define MOVE_REPEAT_RATE 40
 
+static const ScrollTier MOVE_REPEAT_TIERS[] = {
+	{MOVE_REPEAT_DELAY + MOVE_REPEAT_RATE, MOVE_REPEAT_DELAY + MOVE_REPEAT_RATE},
+	{0, MOVE_REPEAT_RATE}
+};
+static const ScrollTierList MOVE_REPEAT_STYLE = { 2, MOVE_REPEAT_TIERS };
+
 SliderComponent::SliderComponent(Window* window, float min, float max, float increment, const std::string& suffix) : GuiComponent(window),
-	mMin(min), mMax(max), mSingleIncrement(increment), mMoveRate(0), mKnob(window), mSuffix(suffix)
+	mMin(min), mMax(max), mSingleIncrement(increment), mMoveRate(0), mMoveRepeat(MOVE_REPEAT_STYLE), mKnob(window), mSuffix(suffix)
 {
 	assert((min - max) != 0);
 
@@ -27,7 +33,7 @@ bool SliderComponent::input(InputConfig* config, Input input)
 			setValue(mValue - mSingleIncrement);
 
 		mMoveRate = input.value ? -mSingleIncrement : 0;
-		mMoveAccumulator = -MOVE_REPEAT_DELAY;
+		mMoveRepeat.start();
 		return true;
 	}
 	if(config->isMappedLike("right", input))
@@ -36,7 +42,7 @@ bool SliderComponent::input(InputConfig* config, Input input)
 			setValue(mValue + mSingleIncrement);
 
 		mMoveRate = input.value ? mSingleIncrement : 0;
-		mMoveAccumulator = -MOVE_REPEAT_DELAY;
+		mMoveRepeat.start();
 		return true;
 	}
 
@@ -47,12 +53,9 @@ void SliderComponent::update(int deltaTime)
 {
 	if(mMoveRate != 0)
 	{
-		mMoveAccumulator += deltaTime;
-		while(mMoveAccumulator >= MOVE_REPEAT_RATE)
-		{
+		const int count = mMoveRepeat.update();
+		for(int i = 0; i < count; i++)
 			setValue(mValue + mMoveRate);
-			mMoveAccumulator -= MOVE_REPEAT_RATE;
-		}
 	}
 
 	GuiComponent::update(deltaTime);
@@ -81,6 +84,8 @@ void SliderComponent::render(const Transform4x4f& parentTrans)
 
 void SliderComponent::setValue(float value)
 {
+	const float previous = mValue;
+
 	mValue = value;
 	if(mValue < mMin)
 		mValue = mMin;
@@ -88,6 +93,9 @@ void SliderComponent::setValue(float value)
 		mValue = mMax;
 
 	onValueChanged();
+
+	if(mValueChangedCallback && (mValue != previous))
+		mValueChangedCallback(mValue);
 }
 
 float SliderComponent::getValue()
@@ -4,6 +4,7 @@
 
 #include "components/ImageComponent.h"
 #include "GuiComponent.h"
+#include "InputRepeat.h"
 
 class Font;
 class TextCache;
@@ -18,6 +19,9 @@ public:
 	void setValue(float val);
 	float getValue();
 
+	// Called with the new value whenever it changes, not for the value set before the callback
+	inline void setOnValueChanged(const std::function<void(float value)>& callback) { mValueChangedCallback = callback; }
+
 	bool input(InputConfig* config, Input input) override;
 	void update(int deltaTime) override;
 	void render(const Transform4x4f& parentTrans) override;
@@ -33,13 +37,15 @@ private:
 	float mValue;
 	float mSingleIncrement;
 	float mMoveRate;
-	int mMoveAccumulator;
+	InputRepeat mMoveRepeat;
 
 	ImageComponent mKnob;
 
 	std::string mSuffix;
 	std::shared_ptr<Font> mFont;
 	std::shared_ptr<TextCache> mValueCache;
+
+	std::function<void(float value)> mValueChangedCallback;
 };
 
 #endif // ES_CORE_COMPONENTS_SLIDER_COMPONENT_H
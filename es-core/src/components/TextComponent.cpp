@@ -4,6 +4,8 @@
 #include "Log.h"
 #include "Settings.h"
 
+static Setting<bool> sDebugText("DebugText");
+
 TextComponent::TextComponent(Window* window) : GuiComponent(window),
 	mFont(Font::get(FONT_SIZE_MEDIUM)), mUppercase(false), mColor(0x000000FF), mAutoCalcExtent(true, true),
 	mHorizontalAlignment(ALIGN_LEFT), mVerticalAlignment(ALIGN_CENTER), mLineSpacing(1.5f), mBgColor(0),
@@ -126,7 +128,7 @@ void TextComponent::render(const Transform4x4f& parentTrans)
 		}
 		Vector3f off(0, yOff, 0);
 
-		if(Settings::getInstance()->getBool("DebugText"))
+		if(sDebugText.get())
 		{
 			// draw the "textbox" area, what we are aligned within
 			Renderer::setMatrix(trans);
@@ -137,7 +139,7 @@ void TextComponent::render(const Transform4x4f& parentTrans)
 		Renderer::setMatrix(trans);
 
 		// draw the text area, where the text actually is going
-		if(Settings::getInstance()->getBool("DebugText"))
+		if(sDebugText.get())
 		{
 			switch(mHorizontalAlignment)
 			{
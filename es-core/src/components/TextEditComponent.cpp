@@ -9,10 +9,16 @@
 #define CURSOR_REPEAT_START_DELAY 500
 #define CURSOR_REPEAT_SPEED 28 // lower is faster
 
+static const ScrollTier CURSOR_REPEAT_TIERS[] = {
+	{CURSOR_REPEAT_START_DELAY, CURSOR_REPEAT_START_DELAY},
+	{0, CURSOR_REPEAT_SPEED}
+};
+static const ScrollTierList CURSOR_REPEAT_STYLE = { 2, CURSOR_REPEAT_TIERS };
+
 TextEditComponent::TextEditComponent(Window* window) : GuiComponent(window),
 	mBox(window, ":/textinput_ninepatch.png"), mFocused(false),
 	mScrollOffset(0.0f, 0.0f), mCursor(0), mEditing(false), mFont(Font::get(FONT_SIZE_MEDIUM, FONT_PATH_LIGHT)),
-	mCursorRepeatDir(0)
+	mCursorRepeatDir(0), mCursorRepeat(CURSOR_REPEAT_STYLE)
 {
 	addChild(&mBox);
 
@@ -71,6 +77,9 @@ void TextEditComponent::textInput(const char* text)
 
 	onTextChanged();
 	onCursorChanged();
+
+	if(mEditing && mTextChangedCallback)
+		mTextChangedCallback(mText);
 }
 
 void TextEditComponent::startEditing()
@@ -137,7 +146,7 @@ bool TextEditComponent::input(InputConfig* config, Input input)
 		}else if(cursor_left || cursor_right)
 		{
 			mCursorRepeatDir = cursor_left ? -1 : 1;
-			mCursorRepeatTimer = -(CURSOR_REPEAT_START_DELAY - CURSOR_REPEAT_SPEED);
+			mCursorRepeat.start();
 			moveCursor(mCursorRepeatDir);
 		} else if(config->getDeviceId() == DEVICE_KEYBOARD)
 		{
@@ -180,12 +189,9 @@ void TextEditComponent::updateCursorRepeat(int deltaTime)
 	if(mCursorRepeatDir == 0)
 		return;
 
-	mCursorRepeatTimer += deltaTime;
-	while(mCursorRepeatTimer >= CURSOR_REPEAT_SPEED)
-	{
+	const int count = mCursorRepeat.update();
+	for(int i = 0; i < count; i++)
 		moveCursor(mCursorRepeatDir);
-		mCursorRepeatTimer -= CURSOR_REPEAT_SPEED;
-	}
 }
 
 void TextEditComponent::moveCursor(int amt)
@@ -4,6 +4,7 @@
 
 #include "components/NinePatchComponent.h"
 #include "GuiComponent.h"
+#include "InputRepeat.h"
 
 class Font;
 class TextCache;
@@ -31,11 +32,14 @@ public:
 	inline const std::shared_ptr<Font>& getFont() const { return mFont; }
 
 	void setCursor(size_t pos);
+	void startEditing(); // takes the typed text until it's accepted or cancelled
+
+	// called with the new text whenever some is typed or erased
+	inline void setTextChangedCallback(const std::function<void(const std::string&)>& callback) { mTextChangedCallback = callback; };
 
 	virtual std::vector<HelpPrompt> getHelpPrompts() override;
 
 private:
-	void startEditing();
 	void stopEditing();
 
 	void onTextChanged();
@@ -53,8 +57,8 @@ private:
 	bool mEditing;
 	unsigned int mCursor; // cursor position in characters
 
-	int mCursorRepeatTimer;
 	int mCursorRepeatDir;
+	InputRepeat mCursorRepeat;
 
 	Vector2f mScrollOffset;
 
@@ -62,6 +66,8 @@ private:
 
 	std::shared_ptr<Font> mFont;
 	std::unique_ptr<TextCache> mTextCache;
+
+	std::function<void(const std::string&)> mTextChangedCallback;
 };
 
 #endif // ES_CORE_COMPONENTS_TEXT_EDIT_COMPONENT_H
@@ -2,6 +2,7 @@
 
 #include "resources/ResourceManager.h"
 #include "utils/FileSystemUtil.h"
+#include "FrameScheduler.h"
 #include "PowerSaver.h"
 #include "ThemeData.h"
 #include "Window.h"
@@ -258,6 +259,8 @@ void VideoComponent::startVideoWithDelay()
 			mStartDelayed = true;
 			mFadeIn = 0.0f;
 			mStartTime = SDL_GetTicks() + mConfig.startDelay;
+			// the snapshot starts fading before the video, an idle screen would notice that late
+			FrameScheduler::requestFrame(mConfig.startDelay > FADE_TIME_MS ? mConfig.startDelay - FADE_TIME_MS : 0);
 		}
 		mIsPlaying = true;
 	}
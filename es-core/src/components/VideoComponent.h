@@ -35,6 +35,12 @@ public:
 	// Configures the component to show the default video
 	void setDefaultVideo();
 
+	// How long the theme has a new video wait before it is opened, in milliseconds
+	unsigned getStartDelay() const { return mConfig.startDelay; }
+
+	// Starts opening a video that's likely played next, so it starts sooner once it is. Players that can't do that ignore it
+	virtual void prefetch(const std::string& /*path*/) { }
+
 	// sets whether it's going to render in screensaver mode
 	void setScreensaverMode(bool isScreensaver);
 
@@ -1,10 +1,13 @@
 #include "components/VideoVlcComponent.h"
 
 #include "renderers/Renderer.h"
-#include "resources/TextureResource.h"
+#include "resources/TextureVariant.h"
+#include "utils/FileSystemUtil.h"
 #include "utils/StringUtil.h"
+#include "FrameScheduler.h"
 #include "PowerSaver.h"
 #include "Settings.h"
+#include "VideoBackend.h"
 #ifdef WIN32
 #include <basetsd.h>
 #include <codecvt>
@@ -14,23 +17,51 @@ typedef SSIZE_T ssize_t;
 #endif
 #include <vlc/vlc.h>
 #include <SDL_mutex.h>
+#include <SDL_timer.h>
+#include <list>
+
+// videos kept open, and players kept for the next video
+#define MAX_OPEN_MEDIA   4
+#define PLAYER_POOL_SIZE 2
 
 libvlc_instance_t* VideoVlcComponent::mVLC = NULL;
 
+struct OpenMedia
+{
+	std::string     path;
+	bool            muted;
+	const char*     decoder;
+	libvlc_media_t* media;
+};
+
+static std::list<OpenMedia>                sOpenMedia; // most recently used first
+static std::vector<libvlc_media_player_t*> sPlayerPool;
+
 // VLC prepares to render a video frame.
 static void *lock(void *data, void **p_pixels) {
 	struct VideoContext *c = (struct VideoContext *)data;
 	SDL_LockMutex(c->mutex);
-	SDL_LockSurface(c->surface);
-	*p_pixels = c->surface->pixels;
+	// with three frames there's always one that's neither shown nor waiting to be
+	int frame = 0;
+	while((frame == c->latest) || (frame == c->displayed))
+		++frame;
+	c->decoding = frame;
+	SDL_UnlockMutex(c->mutex);
+	*p_pixels = c->frames[frame].data();
 	return NULL; // Picture identifier, not needed here.
 }
 
 // VLC just rendered a video frame.
 static void unlock(void *data, void* /*id*/, void *const* /*p_pixels*/) {
 	struct VideoContext *c = (struct VideoContext *)data;
-	SDL_UnlockSurface(c->surface);
+	SDL_LockMutex(c->mutex);
+	const bool dropped = c->newFrame;
+	c->latest = c->decoding;
+	c->decoding = -1;
+	c->newFrame = true;
 	SDL_UnlockMutex(c->mutex);
+	VideoBackend::frameDecoded(dropped);
+	FrameScheduler::wakeUp();
 }
 
 // VLC wants to display a video frame.
@@ -38,14 +69,39 @@ static void display(void* /*data*/, void* /*id*/) {
 	//Data to be displayed
 }
 
+static void drawTexture(const unsigned int texture, const Vector2f& offset, const Vector2f& size, const unsigned int color)
+{
+	Renderer::Vertex vertices[4];
+
+	vertices[0] = { { offset.x()           , offset.y()            }, { 0.0f, 0.0f }, color };
+	vertices[1] = { { offset.x()           , offset.y() + size.y() }, { 0.0f, 1.0f }, color };
+	vertices[2] = { { offset.x() + size.x(), offset.y()            }, { 1.0f, 0.0f }, color };
+	vertices[3] = { { offset.x() + size.x(), offset.y() + size.y() }, { 1.0f, 1.0f }, color };
+
+	// round vertices
+	for(int i = 0; i < 4; ++i)
+		vertices[i].pos.round();
+
+	Renderer::bindTexture(texture);
+	Renderer::drawTriangleStrips(&vertices[0], 4);
+}
+
 VideoVlcComponent::VideoVlcComponent(Window* window, std::string subtitles) :
 	VideoComponent(window),
-	mMediaPlayer(nullptr)
+	mMediaPlayer(nullptr),
+	mTexture(0),
+	mTextureWidth(0),
+	mTextureHeight(0),
+	mHeldTexture(0),
+	mPreviewMissing(false),
+	mPreviewShown(false),
+	mPreviewFrame(-1),
+	mPreviewTexture(0),
+	mPreviewStart(0),
+	mCaptureStart(0)
 {
-	memset(&mContext, 0, sizeof(mContext));
-
-	// Get an empty texture for rendering the video
-	mTexture = TextureResource::get("");
+	mContext.mutex = nullptr;
+	mContext.valid = false;
 
 	// Make sure VLC has been initialised
 	setupVLC(subtitles);
@@ -54,6 +110,10 @@ VideoVlcComponent::VideoVlcComponent(Window* window, std::string subtitles) :
 VideoVlcComponent::~VideoVlcComponent()
 {
 	stopVideo();
+	freePreview();
+
+	if(mHeldTexture)
+		Renderer::destroyTexture(mHeldTexture);
 }
 
 void VideoVlcComponent::setResize(float width, float height)
@@ -74,9 +134,6 @@ void VideoVlcComponent::setMaxSize(float width, float height)
 
 void VideoVlcComponent::resize()
 {
-	if(!mTexture)
-		return;
-
 	const Vector2f textureSize((float)mVideoWidth, (float)mVideoHeight);
 
 	if(textureSize == Vector2f::Zero())
@@ -126,9 +183,6 @@ void VideoVlcComponent::resize()
 			}
 		}
 
-	// mSize.y() should already be rounded
-	mTexture->rasterizeAt((size_t)Math::round(mSize.x()), (size_t)Math::round(mSize.y()));
-
 	onSizeChanged();
 }
 
@@ -146,37 +200,180 @@ void VideoVlcComponent::render(const Transform4x4f& parentTrans)
 	{
 		const unsigned int fadeIn = (unsigned int)(Math::clamp(0.0f, mFadeIn, 1.0f) * 255.0f);
 		const unsigned int color  = Renderer::convertColor((fadeIn << 24) | (fadeIn << 16) | (fadeIn << 8) | 255);
-		Renderer::Vertex   vertices[4];
 
-		vertices[0] = { { 0.0f     , 0.0f      }, { 0.0f, 0.0f }, color };
-		vertices[1] = { { 0.0f     , mSize.y() }, { 0.0f, 1.0f }, color };
-		vertices[2] = { { mSize.x(), 0.0f      }, { 1.0f, 0.0f }, color };
-		vertices[3] = { { mSize.x(), mSize.y() }, { 1.0f, 1.0f }, color };
+		// pick up the newest frame, VLC leaves it alone while it's shown so it's uploaded without holding the mutex
+		int frame = -1;
+		SDL_LockMutex(mContext.mutex);
+		if(mContext.newFrame)
+		{
+			mContext.displayed = mContext.latest;
+			mContext.latest = -1;
+			mContext.newFrame = false;
+			frame = mContext.displayed;
+		}
+		SDL_UnlockMutex(mContext.mutex);
+
+		if(frame >= 0)
+		{
+			VideoBackend::frameShown();
+
+			if(mCapture)
+				capturePreview(mContext.frames[frame]);
+
+			// the texture is only made once, every frame after that replaces its contents
+			if(!mTexture)
+			{
+				// the video takes over from its preview without fading in again
+				if(mPreviewShown)
+				{
+					mFadeIn = 1.0f;
+					mPreviewShown = false;
+					mPreviewFrame = -1;
+				}
 
-		// round vertices
-		for(int i = 0; i < 4; ++i)
-			vertices[i].pos.round();
+				if(mHeldTexture)
+				{
+					Renderer::destroyTexture(mHeldTexture);
+					mHeldTexture = 0;
+				}
 
-		// Build a texture for the video frame
-		mTexture->initFromPixels((unsigned char*)mContext.surface->pixels, mContext.surface->w, mContext.surface->h);
-		mTexture->bind();
+				mTextureWidth = mVideoWidth;
+				mTextureHeight = mVideoHeight;
+				mTexture = Renderer::createTexture(Renderer::Texture::RGBA, true, false, false, mTextureWidth, mTextureHeight, mContext.frames[frame].data());
+			}
+			else
+				Renderer::updateTexture(mTexture, Renderer::Texture::RGBA, 0, 0, mTextureWidth, mTextureHeight, mContext.frames[frame].data());
+		}
 
-		// Render it
-		Renderer::drawTriangleStrips(&vertices[0], 4);
+		// Render it, the last video or the preview stands in until the first frame was decoded
+		if(mTexture)
+			drawTexture(mTexture, Vector2f::Zero(), mSize, color);
+		else if(mHeldTexture)
+			drawTexture(mHeldTexture, (mSize - mHeldSize) * mOrigin, mHeldSize, Renderer::convertColor(0xFFFFFFFF));
+		else
+			renderPreview();
 	}
-	else
+	else if(!mStartDelayed || !renderPreview())
 	{
 		VideoComponent::renderSnapshot(parentTrans);
 	}
 }
 
+void VideoVlcComponent::update(int deltaTime)
+{
+	updatePreview();
+	VideoComponent::update(deltaTime);
+}
+
+void VideoVlcComponent::updatePreview()
+{
+	if(mVideoPath != mPreviewPath)
+	{
+		freePreview();
+		mPreviewPath = mVideoPath;
+		mPreviewMissing = false;
+	}
+
+	if(mPreview || mPreviewMissing || mPreviewPath.empty() || mScreensaverMode || !VideoPreview::isEnabled())
+		return;
+
+	mPreview = VideoPreview::get(mPreviewPath, mPreviewMissing);
+
+	// the preview knows the size of the video before it's opened
+	if(mPreview && !mContext.valid)
+	{
+		mVideoWidth = mPreview->videoWidth;
+		mVideoHeight = mPreview->videoHeight;
+		resize();
+	}
+}
+
+bool VideoVlcComponent::renderPreview()
+{
+	if(!mPreview || (mSize == Vector2f::Zero()))
+		return false;
+
+	const unsigned int now = SDL_GetTicks();
+
+	if(mPreviewFrame < 0)
+		mPreviewStart = now;
+
+	// the preview loops until the video takes over
+	const unsigned int elapsed = now - mPreviewStart;
+	const int frame = (int)((elapsed / VideoPreview::FRAME_INTERVAL) % mPreview->frames.size());
+
+	if(!mPreviewTexture)
+		mPreviewTexture = Renderer::createTexture(Renderer::Texture::RGBA, true, false, false, mPreview->width, mPreview->height, mPreview->frames[frame].data());
+	else if(frame != mPreviewFrame)
+		Renderer::updateTexture(mPreviewTexture, Renderer::Texture::RGBA, 0, 0, mPreview->width, mPreview->height, mPreview->frames[frame].data());
+
+	mPreviewFrame = frame;
+	mPreviewShown = true;
+
+	drawTexture(mPreviewTexture, Vector2f::Zero(), mSize, Renderer::convertColor(0xFFFFFFFF));
+
+	// an idle screen has to wake up for the next frame of the preview
+	FrameScheduler::requestFrame((int)(VideoPreview::FRAME_INTERVAL - (elapsed % VideoPreview::FRAME_INTERVAL)));
+
+	return true;
+}
+
+void VideoVlcComponent::capturePreview(const std::vector<unsigned char>& frame)
+{
+	const unsigned int now = SDL_GetTicks();
+
+	if(mCapture->frames.empty())
+		mCaptureStart = now;
+	else if((now - mCaptureStart) < (mCapture->frames.size() * VideoPreview::FRAME_INTERVAL))
+		return;
+
+	int level = 0;
+	while((mVideoHeight >> (level + 1)) >= VideoPreview::HEIGHT)
+		++level;
+
+	std::vector<unsigned char> reduced(frame);
+	size_t width = mVideoWidth;
+	size_t height = mVideoHeight;
+
+	TextureVariant::reduce(reduced, width, height, level);
+	mCapture->width = (unsigned int)width;
+	mCapture->height = (unsigned int)height;
+	mCapture->frames.push_back(std::vector<unsigned char>());
+	mCapture->frames.back().swap(reduced);
+
+	if(mCapture->frames.size() >= VideoPreview::FRAME_COUNT)
+	{
+		VideoPreview::add(mPlayingVideoPath, mCapture);
+		mCapture.reset();
+		mPreviewMissing = false;
+	}
+}
+
+void VideoVlcComponent::freePreview()
+{
+	if(mPreviewTexture)
+	{
+		Renderer::destroyTexture(mPreviewTexture);
+		mPreviewTexture = 0;
+	}
+
+	mPreview.reset();
+	mPreviewShown = false;
+	mPreviewFrame = -1;
+}
+
 void VideoVlcComponent::setupContext()
 {
 	if (!mContext.valid)
 	{
-		// Create an RGBA surface to render the video into
-		mContext.surface = SDL_CreateRGBSurface(SDL_SWSURFACE, (int)mVideoWidth, (int)mVideoHeight, 32, 0xff000000, 0x00ff0000, 0x0000ff00, 0x000000ff);
+		// Create the RGBA frames to render the video into
+		for(int i = 0; i < VideoContext::FRAME_COUNT; ++i)
+			mContext.frames[i].assign((size_t)mVideoWidth * mVideoHeight * 4, 0);
 		mContext.mutex = SDL_CreateMutex();
+		mContext.decoding = -1;
+		mContext.latest = -1;
+		mContext.displayed = -1;
+		mContext.newFrame = false;
 		mContext.valid = true;
 		resize();
 	}
@@ -186,9 +383,26 @@ void VideoVlcComponent::freeContext()
 {
 	if (mContext.valid)
 	{
-		SDL_FreeSurface(mContext.surface);
+		for(int i = 0; i < VideoContext::FRAME_COUNT; ++i)
+			std::vector<unsigned char>().swap(mContext.frames[i]);
 		SDL_DestroyMutex(mContext.mutex);
+		mContext.mutex = nullptr;
 		mContext.valid = false;
+
+		if(mTexture)
+		{
+			// a screensaver shows the last frame until the next video has one, so there's no black gap in between
+			if(mScreensaverMode)
+			{
+				if(mHeldTexture)
+					Renderer::destroyTexture(mHeldTexture);
+				mHeldTexture = mTexture;
+				mHeldSize = mSize;
+			}
+			else
+				Renderer::destroyTexture(mTexture);
+			mTexture = 0;
+		}
 	}
 }
 
@@ -213,6 +427,95 @@ void VideoVlcComponent::setupVLC(std::string subtitles)
 			args = singleargs;
 		}
 		mVLC = libvlc_new(argslen, args);
+
+		// the first previews shouldn't wait for their players either
+		for (int i = 0; mVLC && (i < PLAYER_POOL_SIZE); ++i)
+		{
+			libvlc_media_player_t* player = libvlc_media_player_new(mVLC);
+			if (player)
+				sPlayerPool.push_back(player);
+		}
+	}
+}
+
+libvlc_media_t* VideoVlcComponent::openMedia(const std::string& path, bool muted)
+{
+	const char* decoder = VideoBackend::getVlcDecoderOption();
+
+	for (auto it = sOpenMedia.begin(); it != sOpenMedia.end(); ++it)
+	{
+		// an option can't be taken back once it's added, a muted video is opened again to get its sound
+		if ((it->path == path) && (it->muted == muted) && (it->decoder == decoder))
+		{
+			sOpenMedia.splice(sOpenMedia.begin(), sOpenMedia, it);
+			libvlc_media_retain(it->media);
+			return it->media;
+		}
+	}
+
+	libvlc_media_t* media = libvlc_media_new_path(mVLC, path.c_str());
+	if (!media)
+		return NULL;
+
+	if (muted)
+		libvlc_media_add_option(media, ":no-audio");
+	libvlc_media_add_option(media, decoder);
+
+	// parsing goes on in the background, startVideo() only waits for what's left of it
+	libvlc_media_parse_with_options(media, libvlc_media_fetch_local, -1);
+
+	sOpenMedia.push_front({ path, muted, decoder, media });
+	while (sOpenMedia.size() > MAX_OPEN_MEDIA)
+	{
+		libvlc_media_release(sOpenMedia.back().media);
+		sOpenMedia.pop_back();
+	}
+
+	libvlc_media_retain(media);
+	return media;
+}
+
+libvlc_media_player_t* VideoVlcComponent::acquirePlayer()
+{
+	if (sPlayerPool.empty())
+		return libvlc_media_player_new(mVLC);
+
+	libvlc_media_player_t* player = sPlayerPool.back();
+	sPlayerPool.pop_back();
+	return player;
+}
+
+void VideoVlcComponent::releasePlayer(libvlc_media_player_t* player)
+{
+	libvlc_media_player_stop(player);
+
+	if (sPlayerPool.size() < PLAYER_POOL_SIZE)
+	{
+		libvlc_media_player_set_media(player, NULL);
+		sPlayerPool.push_back(player);
+	}
+	else
+		libvlc_media_player_release(player);
+}
+
+void VideoVlcComponent::prefetch(const std::string& path)
+{
+	if (!mVLC || path.empty() || !Utils::FileSystem::exists(path))
+		return;
+
+#ifdef WIN32
+	libvlc_media_t* media = openMedia(Utils::String::replace(path, "/", "\\"), isMuted());
+#else
+	libvlc_media_t* media = openMedia(path, isMuted());
+#endif
+	if (media)
+		libvlc_media_release(media);
+
+	// its preview should be there before the video is shown
+	if (VideoPreview::isEnabled())
+	{
+		bool missing;
+		VideoPreview::get(Utils::FileSystem::getAbsolutePath(path), missing);
 	}
 }
 
@@ -223,7 +526,6 @@ void VideoVlcComponent::handleLooping()
 		libvlc_state_t state = libvlc_media_player_get_state(mMediaPlayer);
 		if (state == libvlc_Ended)
 		{
-			setMuteMode();
 			//libvlc_media_player_set_position(mMediaPlayer, 0.0f);
 			libvlc_media_player_set_media(mMediaPlayer, mMedia);
 			libvlc_media_player_play(mMediaPlayer);
@@ -248,15 +550,14 @@ void VideoVlcComponent::startVideo()
 			// Set the video that we are going to be playing so we don't attempt to restart it
 			mPlayingVideoPath = mVideoPath;
 
-			// Open the media
-			mMedia = libvlc_media_new_path(mVLC, path.c_str());
+			// Open the media, it's likely been prefetched already
+			mMedia = openMedia(path, isMuted());
 			if (mMedia)
 			{
 				unsigned track_count;
 				// Get the media metadata so we can find the aspect ratio
-				libvlc_media_parse_with_options(mMedia, libvlc_media_fetch_local, -1);
 				while (libvlc_media_get_parsed_status(mMedia) == 0)
-					;
+					SDL_Delay(1);
 				libvlc_media_track_t** tracks;
 				track_count = libvlc_media_tracks_get(mMedia, &tracks);
 				for (unsigned track = 0; track < track_count; ++track)
@@ -307,19 +608,30 @@ void VideoVlcComponent::startVideo()
 					PowerSaver::pause();
 					setupContext();
 
-					// Setup the media player
-					mMediaPlayer = libvlc_media_player_new_from_media(mMedia);
-
-					setMuteMode();
+					// the first seconds are kept as the preview of a video that has none yet
+					if (mPreviewMissing && (mPlayingVideoPath == mPreviewPath) && !mScreensaverMode && VideoPreview::isEnabled())
+					{
+						mCapture = std::make_shared<VideoPreview::Data>();
+						mCapture->videoWidth = mVideoWidth;
+						mCapture->videoHeight = mVideoHeight;
+					}
 
-					libvlc_media_player_play(mMediaPlayer);
+					// Setup the media player, the frames have to go to this component before it starts
+					mMediaPlayer = acquirePlayer();
+					libvlc_media_player_set_media(mMediaPlayer, mMedia);
 					libvlc_video_set_callbacks(mMediaPlayer, lock, unlock, display, (void*)&mContext);
 					libvlc_video_set_format(mMediaPlayer, "RGBA", (int)mVideoWidth, (int)mVideoHeight, (int)mVideoWidth * 4);
+					libvlc_media_player_play(mMediaPlayer);
 
 					// Update the playing state
 					mIsPlaying = true;
 					mFadeIn = 0.0f;
 				}
+				else
+				{
+					libvlc_media_release(mMedia);
+					mMedia = NULL;
+				}
 			}
 		}
 	}
@@ -329,11 +641,11 @@ void VideoVlcComponent::stopVideo()
 {
 	mIsPlaying = false;
 	mStartDelayed = false;
+	mCapture.reset();
 	// Release the media player so it stops calling back to us
 	if (mMediaPlayer)
 	{
-		libvlc_media_player_stop(mMediaPlayer);
-		libvlc_media_player_release(mMediaPlayer);
+		releasePlayer(mMediaPlayer);
 		libvlc_media_release(mMedia);
 		mMediaPlayer = NULL;
 		freeContext();
@@ -341,10 +653,8 @@ void VideoVlcComponent::stopVideo()
 	}
 }
 
-void VideoVlcComponent::setMuteMode()
+bool VideoVlcComponent::isMuted() const
 {
 	Settings *cfg = Settings::getInstance();
-	if (!cfg->getBool("VideoAudio") || (cfg->getBool("ScreenSaverVideoMute") && mScreensaverMode)) {
-		libvlc_media_add_option(mMedia, ":no-audio");
-	}
+	return (!cfg->getBool("VideoAudio") || (cfg->getBool("ScreenSaverVideoMute") && mScreensaverMode));
 }
@@ -2,17 +2,25 @@
 #ifndef ES_CORE_COMPONENTS_VIDEO_VLC_COMPONENT_H
 #define ES_CORE_COMPONENTS_VIDEO_VLC_COMPONENT_H
 
+#include "resources/VideoPreview.h"
 #include "VideoComponent.h"
+#include <vector>
 
 struct SDL_mutex;
-struct SDL_Surface;
 struct libvlc_instance_t;
 struct libvlc_media_t;
 struct libvlc_media_player_t;
 
+// VLC decodes into one of three frames while another one is shown, the mutex is only held to pick the frames
 struct VideoContext {
-	SDL_Surface*		surface;
+	static const int	FRAME_COUNT = 3;
+
+	std::vector<unsigned char>	frames[FRAME_COUNT];
 	SDL_mutex*			mutex;
+	int					decoding;  // written by VLC, -1 in between frames
+	int					latest;    // the newest complete frame, -1 before the first one
+	int					displayed; // uploaded to the texture, -1 before the first one
+	bool				newFrame;
 	bool				valid;
 };
 
@@ -34,7 +42,7 @@ public:
 	virtual ~VideoVlcComponent();
 
 	void render(const Transform4x4f& parentTrans) override;
-
+	void update(int deltaTime) override;
 
 	// Resize the video to fit this size. If one axis is zero, scale that axis to maintain aspect ratio.
 	// If both are non-zero, potentially break the aspect ratio.  If both are zero, no resizing.
@@ -47,6 +55,9 @@ public:
 	// Never breaks the aspect ratio. setMaxSize() and setResize() are mutually exclusive.
 	void setMaxSize(float width, float height) override;
 
+	// Opens and parses the video in the background, the last few videos opened stay open
+	void prefetch(const std::string& path) override;
+
 private:
 	// Calculates the correct mSize from our resizing information (set by setResize/setMaxSize).
 	// Used internally whenever the resizing parameters or texture change.
@@ -58,16 +69,42 @@ private:
 	// Handle looping the video. Must be called periodically
 	virtual void handleLooping() override;
 
-	void setMuteMode();
+	bool isMuted() const;
 	void setupContext();
 	void freeContext();
 
+	// The preview of the video is shown until its first frame is decoded, one is taken while it plays if there's none
+	void updatePreview();
+	bool renderPreview();
+	void capturePreview(const std::vector<unsigned char>& frame);
+	void freePreview();
+
 private:
+	// the media stays open for a while after being played or prefetched, it's released with libvlc_media_release
+	static libvlc_media_t* openMedia(const std::string& path, bool muted);
+	// players are kept for the next video instead of being made for every one
+	static libvlc_media_player_t* acquirePlayer();
+	static void releasePlayer(libvlc_media_player_t* player);
+
 	static libvlc_instance_t*		mVLC;
 	libvlc_media_t*					mMedia;
 	libvlc_media_player_t*			mMediaPlayer;
 	VideoContext					mContext;
-	std::shared_ptr<TextureResource> mTexture;
+	unsigned int					mTexture; // made once per video, frames are uploaded into it
+	unsigned int					mTextureWidth;
+	unsigned int					mTextureHeight;
+	unsigned int					mHeldTexture; // the last frame of the previous video
+	Vector2f						mHeldSize;
+
+	std::string								mPreviewPath;
+	std::shared_ptr<const VideoPreview::Data>	mPreview;
+	std::shared_ptr<VideoPreview::Data>		mCapture;
+	bool									mPreviewMissing;
+	bool									mPreviewShown;
+	int										mPreviewFrame; // in mPreviewTexture, -1 before the first one
+	unsigned int							mPreviewTexture;
+	unsigned int							mPreviewStart;
+	unsigned int							mCaptureStart;
 };
 
 #endif // ES_CORE_COMPONENTS_VIDEO_VLC_COMPONENT_H
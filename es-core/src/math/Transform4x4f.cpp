@@ -1,5 +1,33 @@
 #include "math/Transform4x4f.h"
 
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#elif defined(__ARM_NEON) || defined(__ARM_NEON__)
+#include <arm_neon.h>
+#endif
+
+//////////////////////////////////////////////////////////////////////////
+
+#if defined(__SSE2__)
+
+// one row of a product, the rows of the left matrix weighted by three or four values of the right one
+static inline __m128 combine(const __m128& _r0, const __m128& _r1, const __m128& _r2, const float* _weights)
+{
+	return _mm_add_ps(_mm_add_ps(_mm_mul_ps(_r0, _mm_set1_ps(_weights[0])), _mm_mul_ps(_r1, _mm_set1_ps(_weights[1]))), _mm_mul_ps(_r2, _mm_set1_ps(_weights[2])));
+
+} // combine
+
+#elif defined(__ARM_NEON) || defined(__ARM_NEON__)
+
+// one row of a product, the rows of the left matrix weighted by three or four values of the right one
+static inline float32x4_t combine(const float32x4_t& _r0, const float32x4_t& _r1, const float32x4_t& _r2, const float* _weights)
+{
+	return vmlaq_n_f32(vmlaq_n_f32(vmulq_n_f32(_r0, _weights[0]), _r1, _weights[1]), _r2, _weights[2]);
+
+} // combine
+
+#endif // __SSE2__ || __ARM_NEON
+
 //////////////////////////////////////////////////////////////////////////
 
 const Transform4x4f Transform4x4f::operator*(const Transform4x4f& _other) const
@@ -7,6 +35,43 @@ const Transform4x4f Transform4x4f::operator*(const Transform4x4f& _other) const
 	const float* tm = (float*)this;
 	const float* om = (float*)&_other;
 
+#if defined(__SSE2__)
+	// every component renders with one of these, the rows are done 4 floats at once in the same order of operations
+	// as the plain version below so the results are the same to the bit
+	const __m128 r0   = _mm_loadu_ps(tm);
+	const __m128 r1   = _mm_loadu_ps(tm + 4);
+	const __m128 r2   = _mm_loadu_ps(tm + 8);
+	const __m128 r3   = _mm_loadu_ps(tm + 12);
+	const __m128 xyz  = _mm_castsi128_ps(_mm_set_epi32(0, -1, -1, -1));
+	const __m128 w    = _mm_set_ps(1, 0, 0, 0);
+
+	Transform4x4f result;
+	float*        rm = (float*)&result;
+
+	_mm_storeu_ps(rm,      _mm_and_ps(combine(r0, r1, r2, om), xyz));
+	_mm_storeu_ps(rm +  4, _mm_and_ps(combine(r0, r1, r2, om + 4), xyz));
+	_mm_storeu_ps(rm +  8, _mm_and_ps(combine(r0, r1, r2, om + 8), xyz));
+	_mm_storeu_ps(rm + 12, _mm_or_ps(_mm_and_ps(_mm_add_ps(combine(r0, r1, r2, om + 12), r3), xyz), w));
+
+	return result;
+#elif defined(__ARM_NEON) || defined(__ARM_NEON__)
+	// every component renders with one of these, the rows are done 4 floats at once in the same order of operations
+	// as the plain version below so the results are the same to the bit
+	const float32x4_t r0 = vld1q_f32(tm);
+	const float32x4_t r1 = vld1q_f32(tm + 4);
+	const float32x4_t r2 = vld1q_f32(tm + 8);
+	const float32x4_t r3 = vld1q_f32(tm + 12);
+
+	Transform4x4f result;
+	float*        rm = (float*)&result;
+
+	vst1q_f32(rm,      vsetq_lane_f32(0, combine(r0, r1, r2, om), 3));
+	vst1q_f32(rm +  4, vsetq_lane_f32(0, combine(r0, r1, r2, om + 4), 3));
+	vst1q_f32(rm +  8, vsetq_lane_f32(0, combine(r0, r1, r2, om + 8), 3));
+	vst1q_f32(rm + 12, vsetq_lane_f32(1, vaddq_f32(combine(r0, r1, r2, om + 12), r3), 3));
+
+	return result;
+#else
 	return
 	{
 		{
@@ -34,6 +99,7 @@ const Transform4x4f Transform4x4f::operator*(const Transform4x4f& _other) const
 			1
 		}
 	};
+#endif // __SSE2__ || __ARM_NEON
 
 } // operator*
 
@@ -44,16 +110,30 @@ const Vector3f Transform4x4f::operator*(const Vector3f& _other) const
 	const float* tm = (float*)this;
 	const float* ov = (float*)&_other;
 
+#if defined(__SSE2__)
+	float result[4];
+
+	_mm_storeu_ps(result, _mm_add_ps(combine(_mm_loadu_ps(tm), _mm_loadu_ps(tm + 4), _mm_loadu_ps(tm + 8), ov), _mm_loadu_ps(tm + 12)));
+
+	return { result[0], result[1], result[2] };
+#elif defined(__ARM_NEON) || defined(__ARM_NEON__)
+	float result[4];
+
+	vst1q_f32(result, vaddq_f32(combine(vld1q_f32(tm), vld1q_f32(tm + 4), vld1q_f32(tm + 8), ov), vld1q_f32(tm + 12)));
+
+	return { result[0], result[1], result[2] };
+#else
 	return
 	{
 		tm[ 0] * ov[0] + tm[ 4] * ov[1] + tm[ 8] * ov[2] + tm[12],
 		tm[ 1] * ov[0] + tm[ 5] * ov[1] + tm[ 9] * ov[2] + tm[13],
 		tm[ 2] * ov[0] + tm[ 6] * ov[1] + tm[10] * ov[2] + tm[14]
 	};
+#endif // __SSE2__ || __ARM_NEON
 
 } // operator*
 
-//////////////////////////////////////////////////////////////////////////
+//////////
 
 Transform4x4f& Transform4x4f::orthoProjection(float _left, float _right, float _bottom, float _top, float _near, float _far)
 {
@@ -6,6 +6,9 @@
 #else
 #include <unistd.h>
 #endif
+#ifdef __GLIBC__
+#include <malloc.h>
+#endif
 #include <fcntl.h>
 
 #include "Log.h"
@@ -92,3 +95,18 @@ void processQuitMode()
 		break;
 	}
 }
+
+void trimHeap()
+{
+#ifdef __GLIBC__
+	// freed blocks otherwise stay with the process until it needs them again
+	malloc_trim(0);
+#endif
+}
+
+void syncDisks()
+{
+#ifndef WIN32
+	sync();
+#endif
+}
@@ -20,5 +20,7 @@ enum QuitMode
 int runSystemCommand(const std::string& cmd_utf8); // run a utf-8 encoded in the shell (requires wstring conversion on Windows)
 int quitES(QuitMode mode = QuitMode::QUIT);
 void processQuitMode();
+void trimHeap(); // returns the memory freed so far to the system, where the C library allows it
+void syncDisks(); // blocks until everything written so far is on the disk, where the system allows it
 
 #endif // ES_CORE_PLATFORM_H
@@ -0,0 +1,249 @@
+#include "renderers/GpuProfiler.h"
+
+#include "renderers/Renderer.h"
+#include "utils/TimelineUtil.h"
+#include "Log.h"
+#include "Settings.h"
+#include <algorithm>
+
+// frames still waiting for their results beyond this are dropped, the GPU isn't going to catch up with them
+#define MAX_PENDING_FRAMES 4
+
+// the row of the timeline the GPU's scopes are shown in
+#define TIMELINE_GPU_THREAD 1000
+
+std::vector<unsigned int>                    GpuProfiler::sQueries;
+std::vector<GpuProfiler::Sample>             GpuProfiler::sSamples;
+std::vector<int>                             GpuProfiler::sOpen;
+std::deque<std::vector<GpuProfiler::Sample>> GpuProfiler::sPending;
+std::map<std::string, GpuProfiler::Total>    GpuProfiler::sTotals;
+int                                          GpuProfiler::sFrames       = 0;
+unsigned int                                 GpuProfiler::sContextCount = 0;
+bool                                         GpuProfiler::sActive       = false;
+bool                                         GpuProfiler::sSupported    = true;
+
+//////////////////////////////////////////////////////////////////////////
+
+GpuProfiler::Scope::Scope(const char* _name) : mBegun(sActive)
+{
+	if(mBegun)
+		begin(_name, "");
+
+} // Scope
+
+//////////////////////////////////////////////////////////////////////////
+
+GpuProfiler::Scope::Scope(const char* _name, const std::string& _detail) : mBegun(sActive)
+{
+	if(mBegun)
+		begin(_name, _detail);
+
+} // Scope
+
+//////////////////////////////////////////////////////////////////////////
+
+GpuProfiler::Scope::~Scope()
+{
+	if(mBegun)
+		end();
+
+} // ~Scope
+
+//////////////////////////////////////////////////////////////////////////
+
+void GpuProfiler::begin(const char* _name, const std::string& _detail)
+{
+	const unsigned int beginQuery = takeQuery();
+	const unsigned int endQuery   = takeQuery();
+
+	if(!beginQuery || !endQuery)
+	{
+		if(beginQuery) sQueries.push_back(beginQuery);
+		if(endQuery)   sQueries.push_back(endQuery);
+
+		sOpen.push_back(-1);
+		return;
+	}
+
+	// what was batched before belongs to the scope around this one
+	Renderer::flush();
+	Renderer::queryTimestamp(beginQuery);
+
+	sOpen.push_back((int)sSamples.size());
+	sSamples.push_back(Sample { _name, _detail, beginQuery, endQuery, Utils::Timeline::getTime() });
+
+} // begin
+
+//////////////////////////////////////////////////////////////////////////
+
+void GpuProfiler::end()
+{
+	// begun before the frame it ends in
+	if(sOpen.empty())
+		return;
+
+	const int index = sOpen.back();
+	sOpen.pop_back();
+
+	if(index < 0)
+		return;
+
+	Renderer::flush();
+	Renderer::queryTimestamp(sSamples[index].endQuery);
+
+} // end
+
+//////////////////////////////////////////////////////////////////////////
+
+unsigned int GpuProfiler::takeQuery()
+{
+	if(!sQueries.empty())
+	{
+		const unsigned int query = sQueries.back();
+		sQueries.pop_back();
+		return query;
+	}
+
+	const unsigned int query = Renderer::createTimerQuery();
+
+	if(!query)
+	{
+		LOG(LogWarning) << "GPU profiling needs timestamp queries, the renderer has none";
+		sSupported = false;
+		sActive    = false;
+	}
+
+	return query;
+
+} // takeQuery
+
+//////////////////////////////////////////////////////////////////////////
+
+void GpuProfiler::releaseFrame(std::vector<Sample>& _samples)
+{
+	for(auto it = _samples.cbegin(); it != _samples.cend(); ++it)
+	{
+		sQueries.push_back(it->beginQuery);
+		sQueries.push_back(it->endQuery);
+	}
+
+	_samples.clear();
+
+} // releaseFrame
+
+//////////////////////////////////////////////////////////////////////////
+
+bool GpuProfiler::readFrame(std::vector<Sample>& _samples, const bool _disjoint)
+{
+	std::vector<uint64_t> times(_samples.size() * 2);
+
+	// the results of a frame come back together, the last one to be drawn decides
+	for(size_t i = 0; i < _samples.size(); ++i)
+	{
+		if(!Renderer::getTimestamp(_samples[i].beginQuery, times[i * 2]) || !Renderer::getTimestamp(_samples[i].endQuery, times[(i * 2) + 1]))
+			return false;
+	}
+
+	// the GPU's clock jumped while they were taken, the times can't be compared
+	if(!_disjoint)
+	{
+		for(size_t i = 0; i < _samples.size(); ++i)
+		{
+			const Sample&  sample   = _samples[i];
+			const uint64_t duration = (times[(i * 2) + 1] > times[i * 2]) ? (times[(i * 2) + 1] - times[i * 2]) : 0;
+			const std::string name  = sample.detail.empty() ? sample.name : (std::string(sample.name) + " " + sample.detail);
+
+			Total& total = sTotals[name];
+			total.name          = name;
+			total.milliseconds += duration / 1000000.0;
+			total.count++;
+
+			Utils::Timeline::add(sample.name, sample.detail, sample.begin, (int64_t)(duration / 1000), TIMELINE_GPU_THREAD);
+		}
+
+		++sFrames;
+	}
+
+	releaseFrame(_samples);
+	return true;
+
+} // readFrame
+
+//////////////////////////////////////////////////////////////////////////
+
+void GpuProfiler::frameDone(const bool _drawn)
+{
+	// the queries went with the old context
+	if(sContextCount != Renderer::getContextCount())
+	{
+		sQueries.clear();
+		sSamples.clear();
+		sPending.clear();
+		sContextCount = Renderer::getContextCount();
+	}
+
+	sOpen.clear();
+
+	// nothing was drawn in a frame that was only checked, there's nothing to time
+	if(_drawn && !sSamples.empty())
+	{
+		sPending.push_back(std::vector<Sample>());
+		sPending.back().swap(sSamples);
+	}
+	else
+		releaseFrame(sSamples);
+
+	if(!sPending.empty())
+	{
+		const bool disjoint = Renderer::checkTimerDisjoint();
+
+		while(!sPending.empty() && readFrame(sPending.front(), disjoint))
+			sPending.pop_front();
+	}
+
+	while(sPending.size() > MAX_PENDING_FRAMES)
+	{
+		releaseFrame(sPending.front());
+		sPending.pop_front();
+	}
+
+	sActive = sSupported && Settings::getInstance()->getBool("ProfileGPU");
+
+	// turned off, nothing's going to use them for a while
+	if(!sActive && sPending.empty())
+	{
+		for(auto it = sQueries.cbegin(); it != sQueries.cend(); ++it)
+			Renderer::destroyTimerQuery(*it);
+
+		sQueries.clear();
+	}
+
+} // frameDone
+
+//////////////////////////////////////////////////////////////////////////
+
+std::vector<GpuProfiler::Total> GpuProfiler::takeTotals(int& _frames)
+{
+	std::vector<Total> totals;
+	totals.reserve(sTotals.size());
+
+	for(auto it = sTotals.cbegin(); it != sTotals.cend(); ++it)
+		totals.push_back(it->second);
+
+	std::sort(totals.begin(), totals.end(), [](const Total& _a, const Total& _b) { return _a.milliseconds > _b.milliseconds; });
+
+	_frames = sFrames;
+	sTotals.clear();
+	sFrames = 0;
+
+	return totals;
+
+} // takeTotals
+
+//////////////////////////////////////////////////////////////////////////
+
+bool GpuProfiler::isActive()
+{
+	return sActive;
+
+} // isActive
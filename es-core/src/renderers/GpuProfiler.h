@@ -0,0 +1,87 @@
+#pragma once
+#ifndef ES_CORE_RENDERERS_GPU_PROFILER_H
+#define ES_CORE_RENDERERS_GPU_PROFILER_H
+
+#include <deque>
+#include <map>
+#include <stdint.h>
+#include <string>
+#include <vector>
+
+// With "ProfileGPU" and an API that has timestamp queries, times how long the GPU took for what was drawn within each
+// scope. The results come back a few frames later, they're summed per scope for the framerate overlay and added to
+// the timeline while one is recorded. A scope flushes the batched draws on both ends, so there are more draw calls
+// while it's on
+class GpuProfiler
+{
+public:
+
+	struct Total
+	{
+		std::string name; // and the detail, if there was one
+		double      milliseconds;
+		int         count;
+
+	}; // Total
+
+	class Scope
+	{
+	public:
+
+		 Scope(const char* _name);
+		 Scope(const char* _name, const std::string& _detail);
+		~Scope();
+
+	private:
+
+		bool mBegun;
+
+	}; // Scope
+
+	// Called by the renderer once a frame is done, _drawn is false when it was only checked
+	static void frameDone(const bool _drawn);
+
+	// What came back since the last call, the most expensive first, and how many frames that was
+	static std::vector<Total> takeTotals(int& _frames);
+
+	static bool isActive();
+
+private:
+
+	// one scope of a frame, between two timestamps
+	struct Sample
+	{
+		const char*  name;
+		std::string  detail;
+		unsigned int beginQuery;
+		unsigned int endQuery;
+		int64_t      begin; // timeline time it was drawn at
+
+	}; // Sample
+
+	static void         begin       (const char* _name, const std::string& _detail);
+	static void         end         ();
+	static unsigned int takeQuery   ();
+	static void         releaseFrame(std::vector<Sample>& _samples);
+	static bool         readFrame   (std::vector<Sample>& _samples, const bool _disjoint);
+
+	static std::vector<unsigned int>        sQueries;   // free ones
+	static std::vector<Sample>              sSamples;   // of the frame being drawn
+	static std::vector<int>                 sOpen;      // index in sSamples of each scope that hasn't ended, -1 when it isn't timed
+	static std::deque<std::vector<Sample>>  sPending;   // drawn frames waiting for their results, oldest first
+	static std::map<std::string, Total>     sTotals;
+	static int                              sFrames;
+	static unsigned int                     sContextCount;
+	static bool                             sActive;
+	static bool                             sSupported;
+
+}; // GpuProfiler
+
+#define _gpuProfilerUnique(_name, _line) _name ## _line
+#define _gpuProfilerUniqueScope(_line)   _gpuProfilerUnique(gpuProfilerScope, _line)
+
+// _name has to outlive the profiler, a string literal. _detail tells apart the calls of the same scope, like a system name
+#define GpuProfilerScope(_name)                const GpuProfiler::Scope _gpuProfilerUniqueScope(__LINE__)(_name)
+#define GpuProfilerScopeDetail(_name, _detail) const GpuProfiler::Scope _gpuProfilerUniqueScope(__LINE__)(_name, _detail)
+
+#endif // ES_CORE_RENDERERS_GPU_PROFILER_H
@@ -0,0 +1,147 @@
+#include "renderers/RenderCache.h"
+
+#include "math/Transform4x4f.h"
+#include "renderers/Renderer.h"
+
+//////////////////////////////////////////////////////////////////////////
+
+RenderCache::RenderCache() : mStart(0, 0), mTexture(0), mTarget(0), mWidth(0), mHeight(0), mHash(0), mInvalidationCount(0), mContextCount(0), mValid(false), mFailed(false)
+{
+
+} // RenderCache
+
+//////////////////////////////////////////////////////////////////////////
+
+RenderCache::~RenderCache()
+{
+	clear();
+
+} // ~RenderCache
+
+//////////////////////////////////////////////////////////////////////////
+
+void RenderCache::render(const Transform4x4f& _trans, const Vector2f& _offset, const Vector2f& _size, const std::function<void(const Transform4x4f&)>& _render)
+{
+	// only whole pixels are cached, the texture is drawn without being filtered
+	const Vector2f start      = Vector2f(Math::floorf(_offset.x()), Math::floorf(_offset.y()));
+	const int      width      = (int)Math::ceilf(_offset.x() + _size.x() - start.x());
+	const int      height     = (int)Math::ceilf(_offset.y() + _size.y() - start.y());
+	const bool     translated = (_trans.r0() == Vector4f(1, 0, 0, 0)) && (_trans.r1() == Vector4f(0, 1, 0, 0)) && (_trans.r2() == Vector4f(0, 0, 1, 0));
+
+	// the renderer was started again since, the texture and target went with the old context
+	if((mTarget != 0) && (mContextCount != Renderer::getContextCount()))
+	{
+		mTexture = 0;
+		mTarget  = 0;
+		mValid   = false;
+	}
+
+	if((width != mWidth) || (height != mHeight))
+	{
+		clear();
+		mWidth  = width;
+		mHeight = height;
+	}
+
+	// a texture much larger than the screen costs more memory than the draws it saves
+	if(!translated || mFailed || (width <= 0) || (height <= 0) || (width > Renderer::getScreenWidth() * 2) || (height > Renderer::getScreenHeight() * 2))
+	{
+		_render(_trans);
+		return;
+	}
+
+	if(mTarget == 0)
+	{
+		mTexture      = Renderer::createTexture(Renderer::Texture::RGBA, false, false, false, width, height, nullptr);
+		mTarget       = Renderer::createRenderTarget(mTexture);
+		mContextCount = Renderer::getContextCount();
+
+		// remembered for this size, it isn't tried again every frame
+		if(mTarget == 0)
+		{
+			Renderer::destroyTexture(mTexture);
+			mTexture = 0;
+			mFailed  = true;
+			_render(_trans);
+			return;
+		}
+	}
+
+	Transform4x4f local = Transform4x4f::Identity();
+	local.translate(Vector3f(-start.x(), -start.y(), 0));
+
+	// a texture that changed since the last time can't be told from the hash, that's drawn again right away
+	bool draw = !mValid || (mInvalidationCount != Renderer::getInvalidationCount());
+
+	if(!draw)
+	{
+		Renderer::beginRenderTarget(0, width, height);
+		_render(local);
+		draw = (Renderer::endRenderTarget() != mHash);
+	}
+
+	if(draw)
+	{
+		Renderer::beginRenderTarget(mTarget, width, height);
+		_render(local);
+		mHash              = Renderer::endRenderTarget();
+		mInvalidationCount = Renderer::getInvalidationCount();
+		mValid             = true;
+	}
+
+	mStart = start;
+	drawTexture(_trans);
+
+} // render
+
+//////////////////////////////////////////////////////////////////////////
+
+bool RenderCache::renderKept(const Transform4x4f& _trans)
+{
+	// the texture went with the old context
+	if(!mValid || (mTarget == 0) || (mContextCount != Renderer::getContextCount()))
+		return false;
+
+	drawTexture(_trans);
+	return true;
+
+} // renderKept
+
+//////////////////////////////////////////////////////////////////////////
+
+void RenderCache::drawTexture(const Transform4x4f& _trans)
+{
+	// the alpha of the texture is premultiplied
+	const Renderer::Vertex vertices[4] =
+	{
+		{ { mStart.x(),                 mStart.y()                  }, { 0.0f, 0.0f }, 0xFFFFFFFF },
+		{ { mStart.x(),                 mStart.y() + (float)mHeight }, { 0.0f, 1.0f }, 0xFFFFFFFF },
+		{ { mStart.x() + (float)mWidth, mStart.y()                  }, { 1.0f, 0.0f }, 0xFFFFFFFF },
+		{ { mStart.x() + (float)mWidth, mStart.y() + (float)mHeight }, { 1.0f, 1.0f }, 0xFFFFFFFF }
+	};
+
+	Renderer::setMatrix(_trans);
+	Renderer::bindTexture(mTexture);
+	Renderer::hashFrameState(&mHash, sizeof(mHash));
+	Renderer::drawTriangleStrips(vertices, 4, Renderer::Blend::ONE, Renderer::Blend::ONE_MINUS_SRC_ALPHA);
+
+} // drawTexture
+
+//////////////////////////////////////////////////////////////////////////
+
+void RenderCache::clear()
+{
+	if((mTarget != 0) && (mContextCount == Renderer::getContextCount()))
+	{
+		Renderer::destroyRenderTarget(mTarget);
+		Renderer::destroyTexture(mTexture);
+	}
+
+	mTexture = 0;
+	mTarget  = 0;
+	mWidth   = 0;
+	mHeight  = 0;
+	mValid   = false;
+	mFailed  = false;
+
+} // clear
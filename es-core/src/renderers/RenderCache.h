@@ -0,0 +1,49 @@
+#pragma once
+#ifndef ES_CORE_RENDERERS_RENDER_CACHE_H
+#define ES_CORE_RENDERERS_RENDER_CACHE_H
+
+#include "math/Vector2f.h"
+#include <functional>
+#include <stdint.h>
+
+class Transform4x4f;
+
+// Keeps what a component and its children draw in a texture, so a frame where they come out the same draws one quad
+// instead of all of them. Each frame the drawing is only hashed first, it's drawn into the texture again once the
+// hash differs or a texture changed. Menus are the main users, lots of draws that rarely change
+class RenderCache
+{
+public:
+
+	 RenderCache();
+	~RenderCache();
+
+	// Renders what _render draws within _offset and _size of the component, that's passed the transform to draw
+	// with. Draws directly with _trans where the renderer can't draw into textures or _trans scales or rotates
+	void render(const Transform4x4f& _trans, const Vector2f& _offset, const Vector2f& _size, const std::function<void(const Transform4x4f&)>& _render);
+
+	// Draws what the last render() kept without hashing it again, for something that's known not to change. False when
+	// nothing is kept, render() has to be called then
+	bool renderKept(const Transform4x4f& _trans);
+
+	// Drops the texture, the next render() starts over
+	void clear();
+
+private:
+
+	void drawTexture(const Transform4x4f& _trans);
+
+	Vector2f     mStart;
+	unsigned int mTexture;
+	unsigned int mTarget;
+	int          mWidth;
+	int          mHeight;
+	uint64_t     mHash;
+	unsigned int mInvalidationCount;
+	unsigned int mContextCount;
+	bool         mValid;
+	bool         mFailed;
+
+}; // RenderCache
+
+#endif // ES_CORE_RENDERERS_RENDER_CACHE_H
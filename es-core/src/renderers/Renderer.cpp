@@ -2,13 +2,20 @@
 
 #include "math/Transform4x4f.h"
 #include "math/Vector2i.h"
+#include "renderers/GpuProfiler.h"
 #include "resources/ResourceManager.h"
+#include "FrameScheduler.h"
 #include "ImageIO.h"
 #include "Log.h"
 #include "Settings.h"
 
 #include <SDL.h>
+#include <algorithm>
+#include <atomic>
+#include <mutex>
+#include <string.h>
 #include <stack>
+#include <vector>
 
 //////////////////////////////////////////////////////////////////////////
 
@@ -25,6 +32,74 @@ namespace Renderer
 	static int              screenRotate       = 0;
 	static bool             initialCursorState = 1;
 
+	static std::vector<Vertex> batchVertices;
+	static Blend::Factor       batchSrcBlendFactor = Blend::SRC_ALPHA;
+	static Blend::Factor       batchDstBlendFactor = Blend::ONE_MINUS_SRC_ALPHA;
+	static Transform4x4f       worldViewMatrix     = Transform4x4f::Identity();
+	static Vector2f            textureOffset       = Vector2f(0.0f, 0.0f);
+	static Vector2f            textureSize         = Vector2f(1.0f, 1.0f);
+
+	static const uint64_t      FRAME_HASH_SEED     = 14695981039346656037ULL;
+	static uint64_t            frameHash           = FRAME_HASH_SEED;
+	static uint64_t            lastFrameHash       = 0;
+	static bool                frameInvalidated    = true;
+	static bool                drawingFrame        = true;
+	static Stats               stats               = { 0, 0, 0, 0, 0 };
+	static Stats               totalStats          = { 0, 0, 0, 0, 0 }; // what takeStats() handed out so far
+	static bool                framePresented      = true;
+	static unsigned int        invalidationCount   = 0;
+	static std::atomic<unsigned int> contextCount  { 0 }; // read by the texture loader threads too
+
+	// what the API specific code last set, see changeState()
+	struct StateValue
+	{
+		unsigned char data[32];
+		size_t        size;
+		bool          known;
+
+	}; // StateValue
+
+	static StateValue          stateValues[State::COUNT];
+
+	// what beginRenderTarget() replaced, endRenderTarget() puts it back
+	struct RenderTargetState
+	{
+		unsigned int     target;
+		int              width;
+		int              height;
+		std::stack<Rect> clipStack;
+		uint64_t         frameHash;
+		bool             drawingFrame;
+
+	}; // RenderTargetState
+
+	static SDL_GLContext                  uploadContext = nullptr;
+	static std::mutex                     uploadMutex;
+
+	static std::vector<RenderTargetState> renderTargets;
+	static Rect                           windowViewport   = Rect(0, 0, 0, 0);
+	static Transform4x4f                  windowProjection = Transform4x4f::Identity();
+
+	// below a "RenderScale" of 100 frames are drawn into the scene target at that scale, unrotated, and stretched onto
+	// the window when they're presented. Fewer pixels to fill where the GPU can't keep up with a large screen
+	static const int                      MIN_RENDER_SCALE = 25;
+	static const int                      ADAPTIVE_MIN     = 50;
+	static const int                      ADAPTIVE_STEP    = 10;
+	static unsigned int                   sceneTexture     = 0;
+	static unsigned int                   sceneTarget      = 0;
+	static int                            sceneScale       = 100;
+	static int                            sceneWidth       = 0;
+	static int                            sceneHeight      = 0;
+	static bool                           sceneFailed      = false; // the API can't draw into textures, not tried again
+	static Transform4x4f                  sceneProjection  = Transform4x4f::Identity();
+
+	// with "RenderScaleAdaptive" the scale drops while presented frames take longer than they're supposed to
+	// and is tried one step higher again after a while on time
+	static int                            adaptiveScale    = 100;
+	static double                         lastPresentTime  = 0.0;
+	static double                         frameTimeAverage = 0.0;
+	static double                         onTimeElapsed    = 0.0;
+
 //////////////////////////////////////////////////////////////////////////
 
 	static void setIcon()
@@ -61,6 +136,213 @@ namespace Renderer
 
 	} // setIcon
 
+//////////////////////////////////////////////////////////////////////////
+
+	static Vertex transformVertex(const Vertex& _vertex)
+	{
+		const Vector3f pos = worldViewMatrix * Vector3f(_vertex.pos);
+
+		return Vertex(pos.v2(), textureOffset + (_vertex.tex * textureSize), _vertex.col);
+
+	} // transformVertex
+
+//////////////////////////////////////////////////////////////////////////
+
+	static double getTime()
+	{
+		return (SDL_GetPerformanceCounter() * 1000.0) / SDL_GetPerformanceFrequency();
+
+	} // getTime
+
+//////////////////////////////////////////////////////////////////////////
+
+	static void bindWindow(const bool _clear)
+	{
+		// 0,0 of the scene target is the top left of the screen, like in beginRenderTarget()
+		if(sceneTarget != 0)
+			bindRenderTarget(sceneTarget, Rect(0, windowHeight - sceneHeight, sceneWidth, sceneHeight), sceneProjection, _clear);
+		else
+			bindRenderTarget(0, windowViewport, windowProjection, false);
+
+	} // bindWindow
+
+//////////////////////////////////////////////////////////////////////////
+
+	static void updateAdaptiveScale()
+	{
+		const double now      = getTime();
+		const double interval = now - lastPresentTime;
+
+		lastPresentTime = now;
+
+		if(!Settings::getInstance()->getBool("RenderScaleAdaptive"))
+		{
+			adaptiveScale = 100;
+			return;
+		}
+
+		// a frame presented after a pause or while idle doesn't tell how long drawing one takes
+		const double budget = (double)FrameScheduler::getFrameInterval();
+
+		if((interval > (budget * 4.0)) || FrameScheduler::isIdle())
+		{
+			frameTimeAverage = budget;
+			return;
+		}
+
+		frameTimeAverage += (interval - frameTimeAverage) * 0.1;
+
+		if(frameTimeAverage > (budget * 1.2))
+		{
+			if(adaptiveScale > ADAPTIVE_MIN)
+			{
+				adaptiveScale    = std::max(adaptiveScale - ADAPTIVE_STEP, ADAPTIVE_MIN);
+				frameTimeAverage = budget;
+			}
+
+			onTimeElapsed = 0.0;
+		}
+		else if(frameTimeAverage < (budget * 1.05))
+		{
+			// it drops again soon enough if the step up was one too many
+			onTimeElapsed += interval;
+
+			if((onTimeElapsed > 5000.0) && (adaptiveScale < 100))
+			{
+				adaptiveScale = std::min(adaptiveScale + ADAPTIVE_STEP, 100);
+				onTimeElapsed = 0.0;
+			}
+		}
+		else
+			onTimeElapsed = 0.0;
+
+	} // updateAdaptiveScale
+
+//////////////////////////////////////////////////////////////////////////
+
+	static bool updateSceneTarget()
+	{
+		const int setting = std::max(std::min(Settings::getInstance()->getInt("RenderScale"), 100), MIN_RENDER_SCALE);
+		const int scale   = sceneFailed ? 100 : std::min(setting, adaptiveScale);
+
+		if(scale == sceneScale)
+			return false;
+
+		if(sceneTarget != 0)
+		{
+			destroyRenderTarget(sceneTarget);
+			destroyTexture(sceneTexture);
+		}
+
+		sceneTexture = 0;
+		sceneTarget  = 0;
+		sceneScale   = 100;
+		sceneWidth   = 0;
+		sceneHeight  = 0;
+
+		if(scale < 100)
+		{
+			const int width  = std::max((screenWidth  * scale) / 100, 1);
+			const int height = std::max((screenHeight * scale) / 100, 1);
+
+			// filtered, it's stretched onto the window
+			sceneTexture = createTexture(Texture::RGBA, true, false, false, width, height, nullptr);
+			sceneTarget  = createRenderTarget(sceneTexture);
+
+			if(sceneTarget != 0)
+			{
+				sceneScale  = scale;
+				sceneWidth  = width;
+				sceneHeight = height;
+
+				sceneProjection = Transform4x4f::Identity();
+				sceneProjection.orthoProjection(0, (float)screenWidth, 0, (float)screenHeight, -1.0, 1.0);
+
+				LOG(LogInfo) << "Rendering at " << scale << "% of the screen, " << width << "x" << height;
+			}
+			else
+			{
+				LOG(LogWarning) << "Could not create a render target, rendering at the size of the screen";
+				destroyTexture(sceneTexture);
+				sceneTexture = 0;
+				sceneFailed  = true;
+			}
+		}
+
+		// clip rects were made for the old size, and a smaller scene isn't what's on screen
+		invalidateFrame();
+		return true;
+
+	} // updateSceneTarget
+
+//////////////////////////////////////////////////////////////////////////
+
+	static void presentScene()
+	{
+		bindRenderTarget(0, windowViewport, windowProjection, false);
+		setScissor(Rect(0, 0, 0, 0));
+
+		// the screen the scene was drawn for, rotated and offset by the projection and viewport of the window.
+		// the scene is opaque where anything was drawn, it replaces what the window holds
+		const Vertex vertices[4] =
+		{
+			{ { 0.0f,               0.0f                }, { 0.0f, 0.0f }, 0xFFFFFFFF },
+			{ { 0.0f,               (float)screenHeight }, { 0.0f, 1.0f }, 0xFFFFFFFF },
+			{ { (float)screenWidth, 0.0f                }, { 1.0f, 0.0f }, 0xFFFFFFFF },
+			{ { (float)screenWidth, (float)screenHeight }, { 1.0f, 1.0f }, 0xFFFFFFFF }
+		};
+
+		bindTexture(sceneTexture);
+		drawVertices(Primitive::TRIANGLE_STRIP, vertices, 4, Blend::ONE, Blend::ZERO);
+		++stats.drawCalls;
+		stats.vertices += 4;
+
+	} // presentScene
+
+//////////////////////////////////////////////////////////////////////////
+
+	static void createUploadContext()
+	{
+		if(!Settings::getInstance()->getBool("BackgroundTextureUpload"))
+			return;
+
+		SDL_GLContext mainContext = SDL_GL_GetCurrentContext();
+
+		// SDL creates it current on this thread, the main context is made current again right after
+		SDL_GL_SetAttribute(SDL_GL_SHARE_WITH_CURRENT_CONTEXT, 1);
+		SDL_GLContext context = SDL_GL_CreateContext(sdlWindow);
+		SDL_GL_SetAttribute(SDL_GL_SHARE_WITH_CURRENT_CONTEXT, 0);
+
+		if(context == nullptr)
+		{
+			LOG(LogWarning) << "Textures are uploaded while drawing, no shared context could be created:\n\t" << SDL_GetError();
+			return;
+		}
+
+		// the loader threads make it current on themselves
+		SDL_GL_MakeCurrent(sdlWindow, mainContext);
+
+		const std::unique_lock<std::mutex> lock(uploadMutex);
+		uploadContext = context;
+
+		LOG(LogInfo) << "Textures are uploaded in the background.";
+
+	} // createUploadContext
+
+//////////////////////////////////////////////////////////////////////////
+
+	static void destroyUploadContext()
+	{
+		// waits for an upload still running
+		const std::unique_lock<std::mutex> lock(uploadMutex);
+
+		if(uploadContext)
+			SDL_GL_DeleteContext(uploadContext);
+
+		uploadContext = nullptr;
+
+	} // destroyUploadContext
+
 //////////////////////////////////////////////////////////////////////////
 
 	static bool createWindow()
@@ -104,6 +386,7 @@ namespace Renderer
 		LOG(LogInfo) << "Created window successfully.";
 
 		createContext();
+		createUploadContext();
 		setIcon();
 		setSwapInterval();
 
@@ -115,6 +398,7 @@ namespace Renderer
 
 	static void destroyWindow()
 	{
+		destroyUploadContext();
 		destroyContext();
 
 		SDL_DestroyWindow(sdlWindow);
@@ -133,6 +417,12 @@ namespace Renderer
 		if(!createWindow())
 			return false;
 
+		++contextCount;
+
+		// a new context starts out with its own defaults
+		for(int i = 0; i < State::COUNT; ++i)
+			stateValues[i].known = false;
+
 		Transform4x4f projection = Transform4x4f::Identity();
 		Rect          viewport   = Rect(0, 0, 0, 0);
 
@@ -189,6 +479,9 @@ namespace Renderer
 			break;
 		}
 
+		windowViewport   = viewport;
+		windowProjection = projection;
+
 		setViewport(viewport);
 		setProjection(projection);
 		swapBuffers();
@@ -201,6 +494,19 @@ namespace Renderer
 
 	void deinit()
 	{
+		if(sceneTarget != 0)
+		{
+			destroyRenderTarget(sceneTarget);
+			destroyTexture(sceneTexture);
+		}
+
+		sceneTexture = 0;
+		sceneTarget  = 0;
+		sceneScale   = 100;
+		sceneWidth   = 0;
+		sceneHeight  = 0;
+		sceneFailed  = false;
+
 		destroyWindow();
 
 	} // deinit
@@ -211,15 +517,45 @@ namespace Renderer
 	{
 		Rect box(_pos.x(), _pos.y(), _size.x(), _size.y());
 
-		if(box.w == 0) box.w = screenWidth  - box.x;
-		if(box.h == 0) box.h = screenHeight - box.y;
+		if(renderTargets.empty() && (sceneTarget != 0))
+		{
+			if(box.w == 0) box.w = screenWidth  - box.x;
+			if(box.h == 0) box.h = screenHeight - box.y;
+
+			// the scene target is only smaller than the screen, its rows go bottom up like those of any other target.
+			// partly covered pixels are kept, what's clipped is cut off at the same place it would be on the screen
+			const float scaleX = (float)sceneWidth  / (float)screenWidth;
+			const float scaleY = (float)sceneHeight / (float)screenHeight;
+			const int   left   = (int)Math::floorf(box.x           * scaleX);
+			const int   top    = (int)Math::floorf(box.y           * scaleY);
+			const int   right  = (int)Math::ceilf((box.x + box.w) * scaleX);
+			const int   bottom = (int)Math::ceilf((box.y + box.h) * scaleY);
+
+			box = Rect(left, windowHeight - bottom, right - left, bottom - top);
+		}
+		else if(renderTargets.empty())
+		{
+			if(box.w == 0) box.w = screenWidth  - box.x;
+			if(box.h == 0) box.h = screenHeight - box.y;
 
-		switch(screenRotate)
+			switch(screenRotate)
+			{
+				case 0: { box = Rect(screenOffsetX + box.x,                       screenOffsetY + box.y,                        box.w, box.h); } break;
+				case 1: { box = Rect(windowWidth - screenOffsetY - box.y - box.h, screenOffsetX + box.x,                        box.h, box.w); } break;
+				case 2: { box = Rect(windowWidth - screenOffsetX - box.x - box.w, windowHeight - screenOffsetY - box.y - box.h, box.w, box.h); } break;
+				case 3: { box = Rect(screenOffsetY + box.y,                       windowHeight - screenOffsetX - box.x - box.w, box.h, box.w); } break;
+			}
+		}
+		else
 		{
-			case 0: { box = Rect(screenOffsetX + box.x,                       screenOffsetY + box.y,                        box.w, box.h); } break;
-			case 1: { box = Rect(windowWidth - screenOffsetY - box.y - box.h, screenOffsetX + box.x,                        box.h, box.w); } break;
-			case 2: { box = Rect(windowWidth - screenOffsetX - box.x - box.w, windowHeight - screenOffsetY - box.y - box.h, box.w, box.h); } break;
-			case 3: { box = Rect(screenOffsetY + box.y,                       windowHeight - screenOffsetX - box.x - box.w, box.h, box.w); } break;
+			// a render target isn't rotated or offset, its rows go bottom up so it's flipped the other way than
+			// setScissor() flips the window
+			const RenderTargetState& target = renderTargets.back();
+
+			if(box.w == 0) box.w = target.width  - box.x;
+			if(box.h == 0) box.h = target.height - box.y;
+
+			box.y = windowHeight - box.y - box.h;
 		}
 
 		// make sure the box fits within clipStack.top(), and clip further accordingly
@@ -280,6 +616,383 @@ namespace Renderer
 
 	} // drawRect
 
+//////////////////////////////////////////////////////////////////////////
+
+	void drawLines(const Vertex* _vertices, const unsigned int _numVertices, const Blend::Factor _srcBlendFactor, const Blend::Factor _dstBlendFactor)
+	{
+		if(_numVertices == 0)
+			return;
+
+		flush();
+
+		std::vector<Vertex> vertices;
+		vertices.reserve(_numVertices);
+
+		for(unsigned int i = 0; i < _numVertices; ++i)
+			vertices.push_back(transformVertex(_vertices[i]));
+
+		hashFrameState(&_srcBlendFactor, sizeof(_srcBlendFactor));
+		hashFrameState(&_dstBlendFactor, sizeof(_dstBlendFactor));
+		hashFrameState(vertices.data(), vertices.size() * sizeof(Vertex));
+
+		if(drawingFrame)
+		{
+			drawVertices(Primitive::LINES, vertices.data(), _numVertices, _srcBlendFactor, _dstBlendFactor);
+			++stats.drawCalls;
+			stats.vertices += _numVertices;
+		}
+
+	} // drawLines
+
+//////////////////////////////////////////////////////////////////////////
+
+	void drawTriangleStrips(const Vertex* _vertices, const unsigned int _numVertices, const Blend::Factor _srcBlendFactor, const Blend::Factor _dstBlendFactor)
+	{
+		if(_numVertices == 0)
+			return;
+
+		if((_srcBlendFactor != batchSrcBlendFactor) || (_dstBlendFactor != batchDstBlendFactor))
+		{
+			flush();
+			batchSrcBlendFactor = _srcBlendFactor;
+			batchDstBlendFactor = _dstBlendFactor;
+		}
+
+		const Vertex first = transformVertex(_vertices[0]);
+
+		// strips are joined by repeating the vertex on both sides of the gap, the triangles in between have no area,
+		// the new strip starts on an even vertex so its triangles keep their winding
+		if(!batchVertices.empty())
+		{
+			const Vertex last = batchVertices.back();
+
+			batchVertices.push_back(last);
+			batchVertices.push_back(first);
+
+			if(batchVertices.size() & 1)
+				batchVertices.push_back(first);
+		}
+
+		batchVertices.push_back(first);
+
+		for(unsigned int i = 1; i < _numVertices; ++i)
+			batchVertices.push_back(transformVertex(_vertices[i]));
+
+	} // drawTriangleStrips
+
+//////////////////////////////////////////////////////////////////////////
+
+	void setMatrix(const Transform4x4f& _matrix)
+	{
+		worldViewMatrix = _matrix;
+		worldViewMatrix.round();
+
+	} // setMatrix
+
+//////////////////////////////////////////////////////////////////////////
+
+	void setTextureRegion(const Vector2f& _offset, const Vector2f& _size)
+	{
+		textureOffset = _offset;
+		textureSize   = _size;
+
+	} // setTextureRegion
+
+//////////////////////////////////////////////////////////////////////////
+
+	void flush()
+	{
+		if(batchVertices.empty())
+			return;
+
+		hashFrameState(&batchSrcBlendFactor, sizeof(batchSrcBlendFactor));
+		hashFrameState(&batchDstBlendFactor, sizeof(batchDstBlendFactor));
+		hashFrameState(batchVertices.data(), batchVertices.size() * sizeof(Vertex));
+
+		if(drawingFrame)
+		{
+			drawVertices(Primitive::TRIANGLE_STRIP, batchVertices.data(), (unsigned int)batchVertices.size(), batchSrcBlendFactor, batchDstBlendFactor);
+			++stats.drawCalls;
+			stats.vertices += (unsigned int)batchVertices.size();
+		}
+
+		// the capacity is kept, the next frame batches about as much again
+		batchVertices.clear();
+
+	} // flush
+
+//////////////////////////////////////////////////////////////////////////
+
+	void beginRenderTarget(const unsigned int _target, const int _width, const int _height)
+	{
+		flush();
+
+		renderTargets.push_back({ _target, _width, _height, clipStack, frameHash, drawingFrame });
+
+		// a target is drawn even while the window only checks its frames, it's drawn from in later ones
+		clipStack    = std::stack<Rect>();
+		frameHash    = FRAME_HASH_SEED;
+		drawingFrame = (_target != 0);
+
+		setScissor(Rect(0, 0, 0, 0));
+
+		if(_target != 0)
+		{
+			Transform4x4f projection = Transform4x4f::Identity();
+			projection.orthoProjection(0, (float)_width, 0, (float)_height, -1.0, 1.0);
+
+			// bottom up like a texture is sampled, the top left of what's drawn ends up at 0,0 of the texture
+			bindRenderTarget(_target, Rect(0, windowHeight - _height, _width, _height), projection, true);
+		}
+
+	} // beginRenderTarget
+
+//////////////////////////////////////////////////////////////////////////
+
+	uint64_t endRenderTarget()
+	{
+		if(renderTargets.empty())
+		{
+			LOG(LogError) << "Tried to endRenderTarget without a target!";
+			return 0;
+		}
+
+		flush();
+
+		const uint64_t          hash  = frameHash;
+		const RenderTargetState state = renderTargets.back();
+
+		renderTargets.pop_back();
+
+		clipStack    = state.clipStack;
+		frameHash    = state.frameHash;
+		drawingFrame = state.drawingFrame;
+
+		if(state.target != 0)
+		{
+			// back to the target this one was drawn in, or the window, what they hold so far is kept
+			auto outer = renderTargets.crbegin();
+			while((outer != renderTargets.crend()) && (outer->target == 0))
+				++outer;
+
+			if(outer != renderTargets.crend())
+			{
+				Transform4x4f projection = Transform4x4f::Identity();
+				projection.orthoProjection(0, (float)outer->width, 0, (float)outer->height, -1.0, 1.0);
+
+				bindRenderTarget(outer->target, Rect(0, windowHeight - outer->height, outer->width, outer->height), projection, false);
+			}
+			else
+				bindWindow(false);
+		}
+
+		if(clipStack.empty()) setScissor(Rect(0, 0, 0, 0));
+		else                  setScissor(clipStack.top());
+
+		return hash;
+
+	} // endRenderTarget
+
+//////////////////////////////////////////////////////////////////////////
+
+	void requestRedraw()
+	{
+		// the frame about to be rendered is drawn right away instead of only being checked first
+		frameInvalidated = true;
+		drawingFrame     = true;
+
+	} // requestRedraw
+
+//////////////////////////////////////////////////////////////////////////
+
+	bool isFramePresented()
+	{
+		return framePresented;
+
+	} // isFramePresented
+
+//////////////////////////////////////////////////////////////////////////
+
+	Stats takeStats()
+	{
+		const Stats taken = stats;
+		stats = { 0, 0, 0, 0, 0 };
+
+		totalStats.drawCalls          += taken.drawCalls;
+		totalStats.textureBinds       += taken.textureBinds;
+		totalStats.vertices           += taken.vertices;
+		totalStats.stateChanges       += taken.stateChanges;
+		totalStats.stateChangesElided += taken.stateChangesElided;
+
+		return taken;
+
+	} // takeStats
+
+//////////////////////////////////////////////////////////////////////////
+
+	Stats getTotalStats()
+	{
+		const Stats total =
+		{
+			totalStats.drawCalls          + stats.drawCalls,
+			totalStats.textureBinds       + stats.textureBinds,
+			totalStats.vertices           + stats.vertices,
+			totalStats.stateChanges       + stats.stateChanges,
+			totalStats.stateChangesElided + stats.stateChangesElided
+		};
+
+		return total;
+
+	} // getTotalStats
+
+//////////////////////////////////////////////////////////////////////////
+
+	void countTextureBind()
+	{
+		if(drawingFrame)
+			++stats.textureBinds;
+
+	} // countTextureBind
+
+//////////////////////////////////////////////////////////////////////////
+
+	bool changeState(const State::Slot _slot, const void* _value, const size_t _size)
+	{
+		StateValue& state = stateValues[_slot];
+
+		if(state.known && (state.size == _size) && (memcmp(state.data, _value, _size) == 0))
+		{
+			if(drawingFrame)
+				++stats.stateChangesElided;
+
+			return false;
+		}
+
+		memcpy(state.data, _value, std::min(_size, sizeof(state.data)));
+		state.size  = _size;
+		state.known = (_size <= sizeof(state.data));
+
+		if(drawingFrame)
+			++stats.stateChanges;
+
+		return true;
+
+	} // changeState
+
+//////////////////////////////////////////////////////////////////////////
+
+	void hashFrameState(const void* _data, const size_t _size)
+	{
+		// FNV-1a over whole words, vertices and the rest of the state are all made of them
+		const uint32_t* words = (const uint32_t*)_data;
+		const size_t    count = _size / sizeof(uint32_t);
+
+		for(size_t i = 0; i < count; ++i)
+			frameHash = (frameHash ^ words[i]) * 1099511628211ULL;
+
+		const unsigned char* bytes = (const unsigned char*)(words + count);
+
+		for(size_t i = 0; i < (_size % sizeof(uint32_t)); ++i)
+			frameHash = (frameHash ^ bytes[i]) * 1099511628211ULL;
+
+	} // hashFrameState
+
+//////////////////////////////////////////////////////////////////////////
+
+	unsigned int getInvalidationCount()
+	{
+		return invalidationCount;
+
+	} // getInvalidationCount
+
+//////////////////////////////////////////////////////////////////////////
+
+	bool beginUpload()
+	{
+		uploadMutex.lock();
+
+		if(uploadContext && (SDL_GL_MakeCurrent(sdlWindow, uploadContext) == 0))
+			return true;
+
+		uploadMutex.unlock();
+		return false;
+
+	} // beginUpload
+
+//////////////////////////////////////////////////////////////////////////
+
+	void endUpload()
+	{
+		SDL_GL_MakeCurrent(sdlWindow, nullptr);
+		uploadMutex.unlock();
+
+	} // endUpload
+
+//////////////////////////////////////////////////////////////////////////
+
+	unsigned int getContextCount()
+	{
+		return contextCount;
+
+	} // getContextCount
+
+//////////////////////////////////////////////////////////////////////////
+
+	void invalidateFrame()
+	{
+		frameInvalidated = true;
+		++invalidationCount;
+
+	} // invalidateFrame
+
+//////////////////////////////////////////////////////////////////////////
+
+	bool endFrame()
+	{
+		flush();
+
+		const bool unchanged = !frameInvalidated && (frameHash == lastFrameHash);
+		const bool drawn     = drawingFrame;
+
+		lastFrameHash    = frameHash;
+
+		GpuProfiler::frameDone(drawn);
+
+		if(drawn && (sceneTarget != 0))
+			presentScene();
+
+		frameHash        = FRAME_HASH_SEED;
+		frameInvalidated = false;
+		framePresented   = drawn;
+
+		// after a frame came out like the one before it the following frames are only checked, not drawn,
+		// the first one to differ isn't presented and the one after it is drawn again
+		drawingFrame = !unchanged || !Settings::getInstance()->getBool("SkipUnchangedFrames");
+
+		return drawn;
+
+	} // endFrame
+
+//////////////////////////////////////////////////////////////////////////
+
+	void beginFrame()
+	{
+		updateAdaptiveScale();
+
+		// the scene target is cleared for the next frame like the window was
+		if(updateSceneTarget() || (sceneTarget != 0))
+			bindWindow(true);
+
+	} // beginFrame
+
+//////////////////////////////////////////////////////////////////////////
+
+	int getRenderScale()
+	{
+		return sceneScale;
+
+	} // getRenderScale
+
 //////////////////////////////////////////////////////////////////////////
 
 	SDL_Window* getSDLWindow()     { return sdlWindow; }
@@ -3,6 +3,8 @@
 #define ES_CORE_RENDERER_RENDERER_H
 
 #include "math/Vector2f.h"
+#include <stddef.h>
+#include <stdint.h>
 
 class  Transform4x4f;
 class  Vector2i;
@@ -33,13 +35,43 @@ namespace Renderer
 	{
 		enum Type
 		{
-			RGBA  = 0,
-			ALPHA = 1
+			RGBA           = 0,
+			ALPHA          = 1,
+			DXT1           = 2, // opaque block compressed formats, 4x4 pixels in 8 bytes
+			ETC1           = 3,
+			DISTANCE_FIELD = 4 // like ALPHA, but the distance to a glyph's edge, which is at 0.5
 
 		}; // Type
 
 	} // Texture::
 
+	namespace State
+	{
+		// what the API specific code keeps track of to leave out calls that wouldn't change anything
+		enum Slot
+		{
+			BLEND          = 0,
+			SCISSOR_TEST   = 1,
+			SCISSOR_BOX    = 2,
+			VIEWPORT       = 3,
+			VERTEX_POINTER = 4,
+			COUNT          = 5
+
+		}; // Slot
+
+	} // State::
+
+	namespace Primitive
+	{
+		enum Type
+		{
+			LINES          = 0,
+			TRIANGLE_STRIP = 1
+
+		}; // Type
+
+	} // Primitive::
+
 	struct Rect
 	{
 		Rect(const int _x, const int _y, const int _w, const int _h) : x(_x), y(_y), w(_w), h(_h) { }
@@ -68,6 +100,50 @@ namespace Renderer
 	void        popClipRect     ();
 	void        drawRect        (const float _x, const float _y, const float _w, const float _h, const unsigned int _color, const unsigned int _colorEnd, bool horizontalGradient = false, const Blend::Factor _srcBlendFactor = Blend::SRC_ALPHA, const Blend::Factor _dstBlendFactor = Blend::ONE_MINUS_SRC_ALPHA);
 
+	// Triangle strips are batched until the texture, blending, scissor, viewport or projection changes,
+	// the world view matrix is applied to their vertices on the way in so it never breaks a batch.
+	void        drawLines         (const Vertex* _vertices, const unsigned int _numVertices, const Blend::Factor _srcBlendFactor = Blend::SRC_ALPHA, const Blend::Factor _dstBlendFactor = Blend::ONE_MINUS_SRC_ALPHA);
+	void        drawTriangleStrips(const Vertex* _vertices, const unsigned int _numVertices, const Blend::Factor _srcBlendFactor = Blend::SRC_ALPHA, const Blend::Factor _dstBlendFactor = Blend::ONE_MINUS_SRC_ALPHA);
+	void        setMatrix         (const Transform4x4f& _matrix);
+	void        setTextureRegion  (const Vector2f& _offset, const Vector2f& _size); // maps texture coordinates into part of the bound texture, until the next bindTexture
+	void        flush             ();
+
+	// Draws into _target instead of the window until endRenderTarget(), with 0,0 at the top left of the target and
+	// clip rects relative to it. A _target of 0 draws nothing and only hashes what would have been drawn. Returns
+	// that hash, what comes out the same hashes the same, see RenderCache
+	void        beginRenderTarget (const unsigned int _target, const int _width, const int _height);
+	uint64_t    endRenderTarget   ();
+
+	// A frame that comes out exactly like the one on screen is neither drawn nor presented, the check runs on what's batched.
+	// Call requestRedraw() between frames when something outside of the renderer changed what's shown, like input or the window being exposed.
+	void        requestRedraw     ();
+	bool        isFramePresented  (); // whether the last swapBuffers() presented anything
+	unsigned int getInvalidationCount(); // goes up whenever a texture, the projection or the viewport changed
+	unsigned int getContextCount     (); // goes up with every init(), textures of the contexts before are gone
+
+	// With "BackgroundTextureUpload" a second context shares its textures with the one drawing, so the texture loader
+	// threads can create them and drawing only has to bind them. From beginUpload() to endUpload() the calling thread
+	// has that context current and may call uploadTexture(), one thread at a time. False when there is none
+	bool        beginUpload       ();
+	void        endUpload         ();
+
+	// What went to the GPU since the last call, frames that aren't drawn don't count
+	struct Stats
+	{
+		unsigned int drawCalls;
+		unsigned int textureBinds;
+		unsigned int vertices;
+		unsigned int stateChanges;
+		unsigned int stateChangesElided; // left out, the state already was what they'd have set
+
+	}; // Stats
+
+	Stats       takeStats         ();
+	Stats       getTotalStats     (); // since the renderer was started, takeStats() doesn't reset it
+
+	// Percent of the screen's size frames are drawn at, see "RenderScale" and "RenderScaleAdaptive"
+	int         getRenderScale    ();
+
 	SDL_Window* getSDLWindow    ();
 	int         getWindowWidth  ();
 	int         getWindowHeight ();
@@ -78,23 +154,47 @@ namespace Renderer
 	int         getScreenRotate ();
 
 	// API specific
-	unsigned int convertColor      (const unsigned int _color);
-	unsigned int getWindowFlags    ();
-	void         setupWindow       ();
-	void         createContext     ();
-	void         destroyContext    ();
-	unsigned int createTexture     (const Texture::Type _type, const bool _linear, const bool _repeat, const unsigned int _width, const unsigned int _height, const void* _data);
-	void         destroyTexture    (const unsigned int _texture);
-	void         updateTexture     (const unsigned int _texture, const Texture::Type _type, const unsigned int _x, const unsigned _y, const unsigned int _width, const unsigned int _height, const void* _data);
-	void         bindTexture       (const unsigned int _texture);
-	void         drawLines         (const Vertex* _vertices, const unsigned int _numVertices, const Blend::Factor _srcBlendFactor = Blend::SRC_ALPHA, const Blend::Factor _dstBlendFactor = Blend::ONE_MINUS_SRC_ALPHA);
-	void         drawTriangleStrips(const Vertex* _vertices, const unsigned int _numVertices, const Blend::Factor _srcBlendFactor = Blend::SRC_ALPHA, const Blend::Factor _dstBlendFactor = Blend::ONE_MINUS_SRC_ALPHA);
-	void         setProjection     (const Transform4x4f& _projection);
-	void         setMatrix         (const Transform4x4f& _matrix);
-	void         setViewport       (const Rect& _viewport);
-	void         setScissor        (const Rect& _scissor);
-	void         setSwapInterval   ();
-	void         swapBuffers       ();
+	unsigned int convertColor       (const unsigned int _color);
+	unsigned int getWindowFlags     ();
+	void         setupWindow        ();
+	void         createContext      ();
+	void         destroyContext     ();
+	bool         supportsTextureType(const Texture::Type _type);
+	unsigned int createTexture      (const Texture::Type _type, const bool _linear, const bool _repeat, const bool _mipmap, const unsigned int _width, const unsigned int _height, const void* _data);
+	unsigned int uploadTexture      (const Texture::Type _type, const bool _linear, const bool _repeat, const bool _mipmap, const unsigned int _width, const unsigned int _height, const void* _data); // complete once it returns
+	void         destroyTexture     (const unsigned int _texture);
+	void         updateTexture      (const unsigned int _texture, const Texture::Type _type, const unsigned int _x, const unsigned _y, const unsigned int _width, const unsigned int _height, const void* _data);
+	void         bindTexture        (const unsigned int _texture);
+	void         drawVertices       (const Primitive::Type _type, const Vertex* _vertices, const unsigned int _numVertices, const Blend::Factor _srcBlendFactor, const Blend::Factor _dstBlendFactor);
+	void         setProjection      (const Transform4x4f& _projection);
+	void         setViewport        (const Rect& _viewport);
+	void         setScissor         (const Rect& _scissor);
+	void         setSwapInterval    ();
+
+	// a target draws into _texture, createRenderTarget() returns 0 when the API can't do that. A target is cleared
+	// to transparent when it's bound with _clear, 0 binds the window again
+	unsigned int createRenderTarget (const unsigned int _texture);
+	void         destroyRenderTarget(const unsigned int _target);
+	void         bindRenderTarget   (const unsigned int _target, const Rect& _viewport, const Transform4x4f& _projection, const bool _clear);
+	void         swapBuffers        ();
+
+	// GPU timestamps, see GpuProfiler. createTimerQuery() returns 0 when the API has none, a result is there a few
+	// frames after it was queried. checkTimerDisjoint() is true when the GPU's clock jumped since the last call
+	unsigned int createTimerQuery   ();
+	void         destroyTimerQuery  (const unsigned int _query);
+	void         queryTimestamp     (const unsigned int _query);
+	bool         getTimestamp       (const unsigned int _query, uint64_t& _nanoseconds); // false until it's there
+	bool         checkTimerDisjoint ();
+
+	// used by the API specific code
+	void         hashFrameState     (const void* _data, const size_t _size);
+	void         countTextureBind   ();
+	// false when _value is what _slot already holds and the call that would set it can be left out, at most 32 bytes.
+	// every slot starts out unknown with a new context
+	bool         changeState        (const State::Slot _slot, const void* _value, const size_t _size);
+	void         invalidateFrame    ();
+	bool         endFrame           ();
+	void         beginFrame         (); // right after a frame was presented and the window cleared
 
 } // Renderer::
 
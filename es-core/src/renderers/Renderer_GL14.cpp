@@ -8,6 +8,15 @@
 #include <SDL_opengl.h>
 #include <SDL.h>
 
+#ifndef GL_COMPRESSED_RGB_S3TC_DXT1_EXT
+#define GL_COMPRESSED_RGB_S3TC_DXT1_EXT 0x83F0
+#endif // GL_COMPRESSED_RGB_S3TC_DXT1_EXT
+
+// ETC2 decoders take ETC1 data as it is
+#ifndef GL_COMPRESSED_RGB8_ETC2
+#define GL_COMPRESSED_RGB8_ETC2 0x9274
+#endif // GL_COMPRESSED_RGB8_ETC2
+
 //////////////////////////////////////////////////////////////////////////
 
 namespace Renderer
@@ -31,6 +40,13 @@ namespace Renderer
 
 	static SDL_GLContext sdlContext   = nullptr;
 	static GLuint        whiteTexture = 0;
+	static GLuint        boundTexture = 0;
+	static GLenum        dxt1Format   = 0; // 0 when the format isn't supported
+	static GLenum        etc1Format   = 0;
+
+	// core since OpenGL 1.3, but not exported by every OpenGL library
+	typedef void (APIENTRY* CompressedTexImage2DFunc)(GLenum, GLint, GLenum, GLsizei, GLsizei, GLint, GLsizei, const void*);
+	static CompressedTexImage2DFunc compressedTexImage2D = nullptr;
 
 //////////////////////////////////////////////////////////////////////////
 
@@ -59,13 +75,29 @@ namespace Renderer
 	{
 		switch(_type)
 		{
-			case Texture::RGBA:  { return GL_RGBA;  } break;
-			case Texture::ALPHA: { return GL_ALPHA; } break;
-			default:             { return GL_ZERO;  }
+			case Texture::RGBA:           { return GL_RGBA;    } break;
+			case Texture::ALPHA:          { return GL_ALPHA;   } break;
+			case Texture::DXT1:           { return dxt1Format; } break;
+			case Texture::ETC1:           { return etc1Format; } break;
+			case Texture::DISTANCE_FIELD: { return GL_ALPHA;   } break;
+			default:                      { return GL_ZERO;    }
 		}
 
 	} // convertTextureType
 
+//////////////////////////////////////////////////////////////////////////
+
+	static GLenum convertPrimitiveType(const Primitive::Type _type)
+	{
+		switch(_type)
+		{
+			case Primitive::LINES:          { return GL_LINES;          } break;
+			case Primitive::TRIANGLE_STRIP: { return GL_TRIANGLE_STRIP; } break;
+			default:                        { return GL_ZERO;           }
+		}
+
+	} // convertPrimitiveType
+
 //////////////////////////////////////////////////////////////////////////
 
 	unsigned int convertColor(const unsigned int _color)
@@ -123,8 +155,15 @@ namespace Renderer
 		LOG(LogInfo) << "Checking available OpenGL extensions...";
 		LOG(LogInfo) << " ARB_texture_non_power_of_two: " << (extensions.find("ARB_texture_non_power_of_two") != std::string::npos ? "ok" : "MISSING");
 
+		compressedTexImage2D = (CompressedTexImage2DFunc)SDL_GL_GetProcAddress("glCompressedTexImage2D");
+		dxt1Format           = (compressedTexImage2D && (extensions.find("GL_EXT_texture_compression_s3tc") != std::string::npos)) ? GL_COMPRESSED_RGB_S3TC_DXT1_EXT : 0;
+		etc1Format           = (compressedTexImage2D && (extensions.find("GL_ARB_ES3_compatibility") != std::string::npos)) ? GL_COMPRESSED_RGB8_ETC2 : 0;
+
+		LOG(LogInfo) << " EXT_texture_compression_s3tc: " << (dxt1Format ? "ok" : "MISSING");
+		LOG(LogInfo) << " ARB_ES3_compatibility: " << (etc1Format ? "ok" : "MISSING");
+
 		const uint8_t data[4] = {255, 255, 255, 255};
-		whiteTexture = createTexture(Texture::RGBA, false, true, 1, 1, data);
+		whiteTexture = createTexture(Texture::RGBA, false, true, false, 1, 1, data);
 
 		GL_CHECK_ERROR(glClearColor(0.0f, 0.0f, 0.0f, 1.0f));
 		GL_CHECK_ERROR(glEnable(GL_TEXTURE_2D));
@@ -148,9 +187,34 @@ namespace Renderer
 
 //////////////////////////////////////////////////////////////////////////
 
-	unsigned int createTexture(const Texture::Type _type, const bool _linear, const bool _repeat, const unsigned int _width, const unsigned int _height, const void* _data)
+	bool supportsTextureType(const Texture::Type _type)
+	{
+		switch(_type)
+		{
+			case Texture::DXT1:           { return (dxt1Format != 0); } break;
+			case Texture::ETC1:           { return (etc1Format != 0); } break;
+			case Texture::DISTANCE_FIELD: { return false;             } break; // needs a shader
+			default:                      { return true;              }
+		}
+
+	} // supportsTextureType
+
+//////////////////////////////////////////////////////////////////////////
+
+	// blocks until what the current context was given so far is done, so other contexts see it complete
+	static void waitForUpload()
+	{
+		GL_CHECK_ERROR(glFinish());
+
+	} // waitForUpload
+
+//////////////////////////////////////////////////////////////////////////
+
+	// the texture on whichever context is current, left bound to it
+	static unsigned int createTextureObject(const Texture::Type _type, const bool _linear, const bool _repeat, const bool _mipmap, const unsigned int _width, const unsigned int _height, const void* _data)
 	{
 		const GLenum type = convertTextureType(_type);
+		const bool   mipmap = _mipmap && (_type == Texture::RGBA);
 		unsigned int texture;
 
 		GL_CHECK_ERROR(glGenTextures(1, &texture));
@@ -159,19 +223,71 @@ namespace Renderer
 		GL_CHECK_ERROR(glTexParameterf(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, _repeat ? GL_REPEAT : GL_CLAMP_TO_EDGE));
 		GL_CHECK_ERROR(glTexParameterf(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, _repeat ? GL_REPEAT : GL_CLAMP_TO_EDGE));
 
-		GL_CHECK_ERROR(glTexParameterf(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, _linear ? GL_LINEAR : GL_NEAREST));
+		GL_CHECK_ERROR(glTexParameterf(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, mipmap ? GL_LINEAR_MIPMAP_LINEAR : (_linear ? GL_LINEAR : GL_NEAREST)));
 		GL_CHECK_ERROR(glTexParameterf(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST));
 
-		GL_CHECK_ERROR(glTexImage2D(GL_TEXTURE_2D, 0, type, _width, _height, 0, type, GL_UNSIGNED_BYTE, _data));
+		// the driver builds the mipmaps whenever the image is uploaded
+		if(mipmap)
+			GL_CHECK_ERROR(glTexParameteri(GL_TEXTURE_2D, GL_GENERATE_MIPMAP, GL_TRUE));
+
+		if((_type == Texture::DXT1) || (_type == Texture::ETC1))
+		{
+			// whole blocks of 4x4 pixels in 8 bytes
+			const GLsizei size = ((_width + 3) / 4) * ((_height + 3) / 4) * 8;
+			GL_CHECK_ERROR(compressedTexImage2D(GL_TEXTURE_2D, 0, type, _width, _height, 0, size, _data));
+		}
+		else
+		{
+			GL_CHECK_ERROR(glTexImage2D(GL_TEXTURE_2D, 0, type, _width, _height, 0, type, GL_UNSIGNED_BYTE, _data));
+		}
+
+		return texture;
+
+	} // createTextureObject
+
+//////////////////////////////////////////////////////////////////////////
+
+	unsigned int createTexture(const Texture::Type _type, const bool _linear, const bool _repeat, const bool _mipmap, const unsigned int _width, const unsigned int _height, const void* _data)
+	{
+		// the pending batch has to be drawn with the texture that's bound now
+		flush();
+		invalidateFrame();
+
+		const unsigned int texture = createTextureObject(_type, _linear, _repeat, _mipmap, _width, _height, _data);
+
+		GL_CHECK_ERROR(glBindTexture(GL_TEXTURE_2D, boundTexture));
 
 		return texture;
 
 	} // createTexture
 
+//////////////////////////////////////////////////////////////////////////
+
+	unsigned int uploadTexture(const Texture::Type _type, const bool _linear, const bool _repeat, const bool _mipmap, const unsigned int _width, const unsigned int _height, const void* _data)
+	{
+		// the upload context has a state of its own, only the textures are shared
+		GL_CHECK_ERROR(glPixelStorei(GL_UNPACK_ALIGNMENT, 1));
+
+		const unsigned int texture = createTextureObject(_type, _linear, _repeat, _mipmap, _width, _height, _data);
+
+		GL_CHECK_ERROR(glBindTexture(GL_TEXTURE_2D, 0));
+		waitForUpload();
+
+		return texture;
+
+	} // uploadTexture
+
 //////////////////////////////////////////////////////////////////////////
 
 	void destroyTexture(const unsigned int _texture)
 	{
+		flush();
+		invalidateFrame();
+
+		// deleting the bound texture unbinds it
+		if(_texture == boundTexture)
+			boundTexture = 0;
+
 		GL_CHECK_ERROR(glDeleteTextures(1, &_texture));
 
 	} // destroyTexture
@@ -182,9 +298,13 @@ namespace Renderer
 	{
 		const GLenum type = convertTextureType(_type);
 
+		// the pending batch may be drawn with the old content of this texture
+		flush();
+		invalidateFrame();
+
 		GL_CHECK_ERROR(glBindTexture(GL_TEXTURE_2D, _texture));
 		GL_CHECK_ERROR(glTexSubImage2D(GL_TEXTURE_2D, 0, _x, _y, _width, _height, type, GL_UNSIGNED_BYTE, _data));
-		GL_CHECK_ERROR(glBindTexture(GL_TEXTURE_2D, whiteTexture));
+		GL_CHECK_ERROR(glBindTexture(GL_TEXTURE_2D, boundTexture));
 
 	} // updateTexture
 
@@ -192,66 +312,78 @@ namespace Renderer
 
 	void bindTexture(const unsigned int _texture)
 	{
-		if(_texture == 0) GL_CHECK_ERROR(glBindTexture(GL_TEXTURE_2D, whiteTexture));
-		else              GL_CHECK_ERROR(glBindTexture(GL_TEXTURE_2D, _texture));
+		const GLuint texture = (_texture == 0) ? whiteTexture : _texture;
+
+		// a texture always starts out used as a whole
+		setTextureRegion(Vector2f(0.0f, 0.0f), Vector2f(1.0f, 1.0f));
+
+		hashFrameState(&texture, sizeof(texture));
+
+		// binding the same texture again keeps the batch going
+		if(texture == boundTexture)
+			return;
+
+		flush();
+		GL_CHECK_ERROR(glBindTexture(GL_TEXTURE_2D, texture));
+		countTextureBind();
+		boundTexture = texture;
 
 	} // bindTexture
 
 //////////////////////////////////////////////////////////////////////////
 
-	void drawLines(const Vertex* _vertices, const unsigned int _numVertices, const Blend::Factor _srcBlendFactor, const Blend::Factor _dstBlendFactor)
+	void drawVertices(const Primitive::Type _type, const Vertex* _vertices, const unsigned int _numVertices, const Blend::Factor _srcBlendFactor, const Blend::Factor _dstBlendFactor)
 	{
-		GL_CHECK_ERROR(glVertexPointer(  2, GL_FLOAT,         sizeof(Vertex), &_vertices[0].pos));
-		GL_CHECK_ERROR(glTexCoordPointer(2, GL_FLOAT,         sizeof(Vertex), &_vertices[0].tex));
-		GL_CHECK_ERROR(glColorPointer(   4, GL_UNSIGNED_BYTE, sizeof(Vertex), &_vertices[0].col));
+		// the arrays are read when drawing, the batch is mostly drawn from the same memory every time
+		if(changeState(State::VERTEX_POINTER, &_vertices, sizeof(_vertices)))
+		{
+			GL_CHECK_ERROR(glVertexPointer(  2, GL_FLOAT,         sizeof(Vertex), &_vertices[0].pos));
+			GL_CHECK_ERROR(glTexCoordPointer(2, GL_FLOAT,         sizeof(Vertex), &_vertices[0].tex));
+			GL_CHECK_ERROR(glColorPointer(   4, GL_UNSIGNED_BYTE, sizeof(Vertex), &_vertices[0].col));
+		}
 
-		GL_CHECK_ERROR(glBlendFunc(convertBlendFactor(_srcBlendFactor), convertBlendFactor(_dstBlendFactor)));
+		const GLenum blend[2] = { convertBlendFactor(_srcBlendFactor), convertBlendFactor(_dstBlendFactor) };
 
-		GL_CHECK_ERROR(glDrawArrays(GL_LINES, 0, _numVertices));
+		if(changeState(State::BLEND, blend, sizeof(blend)))
+			GL_CHECK_ERROR(glBlendFunc(blend[0], blend[1]));
 
-	} // drawLines
+		GL_CHECK_ERROR(glDrawArrays(convertPrimitiveType(_type), 0, _numVertices));
+
+	} // drawVertices
 
 //////////////////////////////////////////////////////////////////////////
 
-	void drawTriangleStrips(const Vertex* _vertices, const unsigned int _numVertices, const Blend::Factor _srcBlendFactor, const Blend::Factor _dstBlendFactor)
+	static void applyViewport(const Rect& _viewport)
 	{
-		GL_CHECK_ERROR(glVertexPointer(  2, GL_FLOAT,         sizeof(Vertex), &_vertices[0].pos));
-		GL_CHECK_ERROR(glTexCoordPointer(2, GL_FLOAT,         sizeof(Vertex), &_vertices[0].tex));
-		GL_CHECK_ERROR(glColorPointer(   4, GL_UNSIGNED_BYTE, sizeof(Vertex), &_vertices[0].col));
-
-		GL_CHECK_ERROR(glBlendFunc(convertBlendFactor(_srcBlendFactor), convertBlendFactor(_dstBlendFactor)));
+		// glViewport starts at the bottom left of the window
+		const GLint viewport[4] = { _viewport.x, getWindowHeight() - _viewport.y - _viewport.h, _viewport.w, _viewport.h };
 
-		GL_CHECK_ERROR(glDrawArrays(GL_TRIANGLE_STRIP, 0, _numVertices));
+		if(changeState(State::VIEWPORT, viewport, sizeof(viewport)))
+			GL_CHECK_ERROR(glViewport(viewport[0], viewport[1], viewport[2], viewport[3]));
 
-	} // drawTriangleStrips
+	} // applyViewport
 
 //////////////////////////////////////////////////////////////////////////
 
 	void setProjection(const Transform4x4f& _projection)
 	{
+		flush();
+		invalidateFrame();
+
+		// the modelview matrix stays identity, the world view matrix is applied to the vertices as they're batched
 		GL_CHECK_ERROR(glMatrixMode(GL_PROJECTION));
 		GL_CHECK_ERROR(glLoadMatrixf((GLfloat*)&_projection));
 
 	} // setProjection
 
-//////////////////////////////////////////////////////////////////////////
-
-	void setMatrix(const Transform4x4f& _matrix)
-	{
-		Transform4x4f matrix = _matrix;
-		matrix.round();
-
-		GL_CHECK_ERROR(glMatrixMode(GL_MODELVIEW));
-		GL_CHECK_ERROR(glLoadMatrixf((GLfloat*)&matrix));
-
-	} // setMatrix
-
 //////////////////////////////////////////////////////////////////////////
 
 	void setViewport(const Rect& _viewport)
 	{
-		// glViewport starts at the bottom left of the window
-		GL_CHECK_ERROR(glViewport( _viewport.x, getWindowHeight() - _viewport.y - _viewport.h, _viewport.w, _viewport.h));
+		flush();
+		invalidateFrame();
+
+		applyViewport(_viewport);
 
 	} // setViewport
 
@@ -259,15 +391,26 @@ namespace Renderer
 
 	void setScissor(const Rect& _scissor)
 	{
-		if((_scissor.x == 0) && (_scissor.y == 0) && (_scissor.w == 0) && (_scissor.h == 0))
+		flush();
+		hashFrameState(&_scissor, sizeof(_scissor));
+
+		const bool enabled = !((_scissor.x == 0) && (_scissor.y == 0) && (_scissor.w == 0) && (_scissor.h == 0));
+
+		if(enabled)
 		{
-			GL_CHECK_ERROR(glDisable(GL_SCISSOR_TEST));
+			// glScissor starts at the bottom left of the window
+			const GLint box[4] = { _scissor.x, getWindowHeight() - _scissor.y - _scissor.h, _scissor.w, _scissor.h };
+
+			if(changeState(State::SCISSOR_BOX, box, sizeof(box)))
+				GL_CHECK_ERROR(glScissor(box[0], box[1], box[2], box[3]));
 		}
-		else
+
+		if(changeState(State::SCISSOR_TEST, &enabled, sizeof(enabled)))
 		{
-			// glScissor starts at the bottom left of the window
-			GL_CHECK_ERROR(glScissor(_scissor.x, getWindowHeight() - _scissor.y - _scissor.h, _scissor.w, _scissor.h));
-			GL_CHECK_ERROR(glEnable(GL_SCISSOR_TEST));
+			if(enabled)
+				GL_CHECK_ERROR(glEnable(GL_SCISSOR_TEST));
+			else
+				GL_CHECK_ERROR(glDisable(GL_SCISSOR_TEST));
 		}
 
 	} // setScissor
@@ -293,15 +436,82 @@ namespace Renderer
 
 	} // setSwapInterval
 
+//////////////////////////////////////////////////////////////////////////
+
+	unsigned int createRenderTarget(const unsigned int /*_texture*/)
+	{
+		// framebuffer objects and separate alpha blending are newer than OpenGL 1.4, render caches draw directly
+		return 0;
+
+	} // createRenderTarget
+
+//////////////////////////////////////////////////////////////////////////
+
+	void destroyRenderTarget(const unsigned int /*_target*/)
+	{
+
+	} // destroyRenderTarget
+
+//////////////////////////////////////////////////////////////////////////
+
+	void bindRenderTarget(const unsigned int /*_target*/, const Rect& /*_viewport*/, const Transform4x4f& /*_projection*/, const bool /*_clear*/)
+	{
+
+	} // bindRenderTarget
+
 //////////////////////////////////////////////////////////////////////////
 
 	void swapBuffers()
 	{
+		// nothing was drawn when the frame came out the same as the one on screen
+		if(!endFrame())
+			return;
+
 		SDL_GL_SwapWindow(getSDLWindow());
 		GL_CHECK_ERROR(glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT));
+		beginFrame();
 
 	} // swapBuffers
 
+//////////////////////////////////////////////////////////////////////////
+
+	unsigned int createTimerQuery()
+	{
+		// timestamp queries are newer than OpenGL 1.4, the GPU can't be profiled
+		return 0;
+
+	} // createTimerQuery
+
+//////////////////////////////////////////////////////////////////////////
+
+	void destroyTimerQuery(const unsigned int /*_query*/)
+	{
+
+	} // destroyTimerQuery
+
+//////////////////////////////////////////////////////////////////////////
+
+	void queryTimestamp(const unsigned int /*_query*/)
+	{
+
+	} // queryTimestamp
+
+//////////////////////////////////////////////////////////////////////////
+
+	bool getTimestamp(const unsigned int /*_query*/, uint64_t& /*_nanoseconds*/)
+	{
+		return false;
+
+	} // getTimestamp
+
+//////////////////////////////////////////////////////////////////////////
+
+	bool checkTimerDisjoint()
+	{
+		return false;
+
+	} // checkTimerDisjoint
+
 } // Renderer::
 
 #endif // USE_OPENGL_14
@@ -7,6 +7,49 @@
 
 #include <SDL_opengl.h>
 #include <SDL.h>
+#include <set>
+
+#ifndef GL_COMPRESSED_RGB_S3TC_DXT1_EXT
+#define GL_COMPRESSED_RGB_S3TC_DXT1_EXT 0x83F0
+#endif // GL_COMPRESSED_RGB_S3TC_DXT1_EXT
+
+// ETC2 decoders take ETC1 data as it is
+#ifndef GL_COMPRESSED_RGB8_ETC2
+#define GL_COMPRESSED_RGB8_ETC2 0x9274
+#endif // GL_COMPRESSED_RGB8_ETC2
+
+#ifndef GL_FRAMEBUFFER
+#define GL_FRAMEBUFFER          0x8D40
+#define GL_COLOR_ATTACHMENT0    0x8CE0
+#define GL_FRAMEBUFFER_COMPLETE 0x8CD5
+#endif // GL_FRAMEBUFFER
+
+#ifndef GL_FRAGMENT_SHADER
+#define GL_FRAGMENT_SHADER 0x8B30
+#define GL_COMPILE_STATUS  0x8B81
+#define GL_LINK_STATUS     0x8B82
+#endif // GL_FRAGMENT_SHADER
+
+#ifndef GL_SYNC_GPU_COMMANDS_COMPLETE
+#define GL_SYNC_GPU_COMMANDS_COMPLETE 0x9117
+#endif // GL_SYNC_GPU_COMMANDS_COMPLETE
+
+#ifndef GL_SYNC_FLUSH_COMMANDS_BIT
+#define GL_SYNC_FLUSH_COMMANDS_BIT 0x00000001
+#endif // GL_SYNC_FLUSH_COMMANDS_BIT
+
+#ifndef GL_TIMEOUT_IGNORED
+#define GL_TIMEOUT_IGNORED 0xFFFFFFFFFFFFFFFFull
+#endif // GL_TIMEOUT_IGNORED
+
+#ifndef GL_TIMESTAMP
+#define GL_TIMESTAMP 0x8E28
+#endif // GL_TIMESTAMP
+
+#ifndef GL_QUERY_RESULT
+#define GL_QUERY_RESULT           0x8866
+#define GL_QUERY_RESULT_AVAILABLE 0x8867
+#endif // GL_QUERY_RESULT
 
 //////////////////////////////////////////////////////////////////////////
 
@@ -31,6 +74,65 @@ namespace Renderer
 
 	static SDL_GLContext sdlContext   = nullptr;
 	static GLuint        whiteTexture = 0;
+	static GLuint        boundTexture = 0;
+	static GLenum        dxt1Format   = 0; // 0 when the format isn't supported
+	static GLenum        etc1Format   = 0;
+
+	// core since OpenGL 1.3, but not exported by every OpenGL library
+	typedef void (APIENTRY* CompressedTexImage2DFunc)(GLenum, GLint, GLenum, GLsizei, GLsizei, GLint, GLsizei, const void*);
+	static CompressedTexImage2DFunc compressedTexImage2D = nullptr;
+
+	// core since OpenGL 2.0, only distance field glyphs use a shader, everything else stays fixed function
+	typedef GLuint (APIENTRY* CreateShaderFunc)(GLenum);
+	typedef void   (APIENTRY* ShaderSourceFunc)(GLuint, GLsizei, const char* const*, const GLint*);
+	typedef void   (APIENTRY* CompileShaderFunc)(GLuint);
+	typedef void   (APIENTRY* GetShaderivFunc)(GLuint, GLenum, GLint*);
+	typedef void   (APIENTRY* DeleteShaderFunc)(GLuint);
+	typedef GLuint (APIENTRY* CreateProgramFunc)();
+	typedef void   (APIENTRY* AttachShaderFunc)(GLuint, GLuint);
+	typedef void   (APIENTRY* LinkProgramFunc)(GLuint);
+	typedef void   (APIENTRY* GetProgramivFunc)(GLuint, GLenum, GLint*);
+	typedef void   (APIENTRY* UseProgramFunc)(GLuint);
+	typedef void   (APIENTRY* DeleteProgramFunc)(GLuint);
+	// core since OpenGL 3.0, ARB_framebuffer_object has the same names and EXT_framebuffer_object its own
+	typedef void   (APIENTRY* GenFramebuffersFunc)(GLsizei, GLuint*);
+	typedef void   (APIENTRY* DeleteFramebuffersFunc)(GLsizei, const GLuint*);
+	typedef void   (APIENTRY* BindFramebufferFunc)(GLenum, GLuint);
+	typedef void   (APIENTRY* FramebufferTexture2DFunc)(GLenum, GLenum, GLenum, GLuint, GLint);
+	typedef GLenum (APIENTRY* CheckFramebufferStatusFunc)(GLenum);
+	typedef void   (APIENTRY* BlendFuncSeparateFunc)(GLenum, GLenum, GLenum, GLenum);
+	static GenFramebuffersFunc        genFramebuffers        = nullptr;
+	static DeleteFramebuffersFunc     deleteFramebuffers     = nullptr;
+	static BindFramebufferFunc        bindFramebuffer        = nullptr;
+	static FramebufferTexture2DFunc   framebufferTexture2D   = nullptr;
+	static CheckFramebufferStatusFunc checkFramebufferStatus = nullptr;
+	static BlendFuncSeparateFunc      blendFuncSeparate      = nullptr;
+	static GLuint                     boundTarget            = 0; // 0 while drawing to the window
+
+	// core since OpenGL 3.2 or ARB_sync, lets a texture uploaded on the upload context be waited for without glFinish
+	typedef void*  (APIENTRY* FenceSyncFunc)(GLenum, GLbitfield);
+	typedef GLenum (APIENTRY* ClientWaitSyncFunc)(void*, GLbitfield, uint64_t);
+	typedef void   (APIENTRY* DeleteSyncFunc)(void*);
+	static FenceSyncFunc      fenceSync      = nullptr;
+	static ClientWaitSyncFunc clientWaitSync = nullptr;
+	static DeleteSyncFunc     deleteSync     = nullptr;
+
+	// core since OpenGL 3.3 or ARB_timer_query, only profiling the GPU uses them
+	typedef void   (APIENTRY* GenQueriesFunc)(GLsizei, GLuint*);
+	typedef void   (APIENTRY* DeleteQueriesFunc)(GLsizei, const GLuint*);
+	typedef void   (APIENTRY* QueryCounterFunc)(GLuint, GLenum);
+	typedef void   (APIENTRY* GetQueryObjectivFunc)(GLuint, GLenum, GLint*);
+	typedef void   (APIENTRY* GetQueryObjectui64vFunc)(GLuint, GLenum, uint64_t*);
+	static GenQueriesFunc          genQueries          = nullptr;
+	static DeleteQueriesFunc       deleteQueries       = nullptr;
+	static QueryCounterFunc        queryCounter        = nullptr;
+	static GetQueryObjectivFunc    getQueryObjectiv    = nullptr;
+	static GetQueryObjectui64vFunc getQueryObjectui64v = nullptr;
+
+	static UseProgramFunc   useProgram           = nullptr;
+	static GLuint           distanceFieldProgram = 0; // 0 when shaders aren't supported
+	static bool             boundDistanceField   = false;
+	static std::set<GLuint> distanceFieldTextures;
 
 //////////////////////////////////////////////////////////////////////////
 
@@ -59,13 +161,113 @@ namespace Renderer
 	{
 		switch(_type)
 		{
-			case Texture::RGBA:  { return GL_RGBA;  } break;
-			case Texture::ALPHA: { return GL_ALPHA; } break;
-			default:             { return GL_ZERO;  }
+			case Texture::RGBA:           { return GL_RGBA;    } break;
+			case Texture::ALPHA:          { return GL_ALPHA;   } break;
+			case Texture::DXT1:           { return dxt1Format; } break;
+			case Texture::ETC1:           { return etc1Format; } break;
+			case Texture::DISTANCE_FIELD: { return GL_ALPHA;   } break;
+			default:                      { return GL_ZERO;    }
 		}
 
 	} // convertTextureType
 
+//////////////////////////////////////////////////////////////////////////
+
+	static void setupDistanceFieldProgram()
+	{
+		const CreateShaderFunc  createShader  = (CreateShaderFunc)SDL_GL_GetProcAddress("glCreateShader");
+		const ShaderSourceFunc  shaderSource  = (ShaderSourceFunc)SDL_GL_GetProcAddress("glShaderSource");
+		const CompileShaderFunc compileShader = (CompileShaderFunc)SDL_GL_GetProcAddress("glCompileShader");
+		const GetShaderivFunc   getShaderiv   = (GetShaderivFunc)SDL_GL_GetProcAddress("glGetShaderiv");
+		const DeleteShaderFunc  deleteShader  = (DeleteShaderFunc)SDL_GL_GetProcAddress("glDeleteShader");
+		const CreateProgramFunc createProgram = (CreateProgramFunc)SDL_GL_GetProcAddress("glCreateProgram");
+		const AttachShaderFunc  attachShader  = (AttachShaderFunc)SDL_GL_GetProcAddress("glAttachShader");
+		const LinkProgramFunc   linkProgram   = (LinkProgramFunc)SDL_GL_GetProcAddress("glLinkProgram");
+		const GetProgramivFunc  getProgramiv  = (GetProgramivFunc)SDL_GL_GetProcAddress("glGetProgramiv");
+		const DeleteProgramFunc deleteProgram = (DeleteProgramFunc)SDL_GL_GetProcAddress("glDeleteProgram");
+
+		useProgram           = (UseProgramFunc)SDL_GL_GetProcAddress("glUseProgram");
+		distanceFieldProgram = 0;
+
+		if(!createShader || !shaderSource || !compileShader || !getShaderiv || !deleteShader || !createProgram ||
+		   !attachShader || !linkProgram || !getProgramiv || !deleteProgram || !useProgram)
+			return;
+
+		// the fixed function vertex stage feeds it, the edge is as sharp as a pixel at any scale
+		const char* fragmentSource =
+			"uniform sampler2D u_tex; \n"
+			"void main(void)                                      \n"
+			"{                                                    \n"
+			"    float d = texture2D(u_tex, gl_TexCoord[0].xy).a; \n"
+			"    float w = fwidth(d) * 0.75;                      \n"
+			"    gl_FragColor = vec4(gl_Color.rgb, gl_Color.a * smoothstep(0.5 - w, 0.5 + w, d)); \n"
+			"}                                                    \n";
+
+		const GLuint shader   = createShader(GL_FRAGMENT_SHADER);
+		GLint        compiled = GL_FALSE;
+		GLint        linked   = GL_FALSE;
+
+		GL_CHECK_ERROR(shaderSource(shader, 1, &fragmentSource, nullptr));
+		GL_CHECK_ERROR(compileShader(shader));
+		GL_CHECK_ERROR(getShaderiv(shader, GL_COMPILE_STATUS, &compiled));
+
+		if(compiled == GL_TRUE)
+		{
+			const GLuint program = createProgram();
+
+			GL_CHECK_ERROR(attachShader(program, shader));
+			GL_CHECK_ERROR(linkProgram(program));
+			GL_CHECK_ERROR(getProgramiv(program, GL_LINK_STATUS, &linked));
+
+			if(linked == GL_TRUE)
+				distanceFieldProgram = program;
+			else
+				GL_CHECK_ERROR(deleteProgram(program));
+		}
+
+		// the program keeps what it needs
+		GL_CHECK_ERROR(deleteShader(shader));
+
+		if(distanceFieldProgram == 0)
+			LOG(LogWarning) << "Could not build the distance field shader, fonts fall back to bitmaps";
+
+	} // setupDistanceFieldProgram
+
+//////////////////////////////////////////////////////////////////////////
+
+	static void setupRenderTargetFunctions()
+	{
+		const bool core = (SDL_GL_GetProcAddress("glGenFramebuffers") != nullptr);
+		const char* suffix = core ? "" : "EXT";
+
+		genFramebuffers        = (GenFramebuffersFunc)SDL_GL_GetProcAddress((std::string("glGenFramebuffers") + suffix).c_str());
+		deleteFramebuffers     = (DeleteFramebuffersFunc)SDL_GL_GetProcAddress((std::string("glDeleteFramebuffers") + suffix).c_str());
+		bindFramebuffer        = (BindFramebufferFunc)SDL_GL_GetProcAddress((std::string("glBindFramebuffer") + suffix).c_str());
+		framebufferTexture2D   = (FramebufferTexture2DFunc)SDL_GL_GetProcAddress((std::string("glFramebufferTexture2D") + suffix).c_str());
+		checkFramebufferStatus = (CheckFramebufferStatusFunc)SDL_GL_GetProcAddress((std::string("glCheckFramebufferStatus") + suffix).c_str());
+		blendFuncSeparate      = (BlendFuncSeparateFunc)SDL_GL_GetProcAddress("glBlendFuncSeparate");
+
+		// all or nothing, render caches draw directly without them
+		if(!genFramebuffers || !deleteFramebuffers || !bindFramebuffer || !framebufferTexture2D || !checkFramebufferStatus || !blendFuncSeparate)
+			genFramebuffers = nullptr;
+
+		LOG(LogInfo) << " framebuffer objects: " << (genFramebuffers ? "ok" : "MISSING");
+
+	} // setupRenderTargetFunctions
+
+//////////////////////////////////////////////////////////////////////////
+
+	static GLenum convertPrimitiveType(const Primitive::Type _type)
+	{
+		switch(_type)
+		{
+			case Primitive::LINES:          { return GL_LINES;          } break;
+			case Primitive::TRIANGLE_STRIP: { return GL_TRIANGLE_STRIP; } break;
+			default:                        { return GL_ZERO;           }
+		}
+
+	} // convertPrimitiveType
+
 //////////////////////////////////////////////////////////////////////////
 
 	unsigned int convertColor(const unsigned int _color)
@@ -123,8 +325,38 @@ namespace Renderer
 		LOG(LogInfo) << "Checking available OpenGL extensions...";
 		LOG(LogInfo) << " ARB_texture_non_power_of_two: " << (extensions.find("ARB_texture_non_power_of_two") != std::string::npos ? "ok" : "MISSING");
 
+		compressedTexImage2D = (CompressedTexImage2DFunc)SDL_GL_GetProcAddress("glCompressedTexImage2D");
+		dxt1Format           = (compressedTexImage2D && (extensions.find("GL_EXT_texture_compression_s3tc") != std::string::npos)) ? GL_COMPRESSED_RGB_S3TC_DXT1_EXT : 0;
+		etc1Format           = (compressedTexImage2D && (extensions.find("GL_ARB_ES3_compatibility") != std::string::npos)) ? GL_COMPRESSED_RGB8_ETC2 : 0;
+
+		LOG(LogInfo) << " EXT_texture_compression_s3tc: " << (dxt1Format ? "ok" : "MISSING");
+		LOG(LogInfo) << " ARB_ES3_compatibility: " << (etc1Format ? "ok" : "MISSING");
+
+		const bool sync = (extensions.find("GL_ARB_sync") != std::string::npos);
+		fenceSync       = sync ? (FenceSyncFunc)SDL_GL_GetProcAddress("glFenceSync")           : nullptr;
+		clientWaitSync  = sync ? (ClientWaitSyncFunc)SDL_GL_GetProcAddress("glClientWaitSync") : nullptr;
+		deleteSync      = sync ? (DeleteSyncFunc)SDL_GL_GetProcAddress("glDeleteSync")         : nullptr;
+
+		LOG(LogInfo) << " ARB_sync: " << ((fenceSync && clientWaitSync && deleteSync) ? "ok" : "MISSING");
+
+		const bool timerQuery = (extensions.find("GL_ARB_timer_query") != std::string::npos);
+		genQueries            = timerQuery ? (GenQueriesFunc)SDL_GL_GetProcAddress("glGenQueries")                   : nullptr;
+		deleteQueries         = timerQuery ? (DeleteQueriesFunc)SDL_GL_GetProcAddress("glDeleteQueries")             : nullptr;
+		queryCounter          = timerQuery ? (QueryCounterFunc)SDL_GL_GetProcAddress("glQueryCounter")               : nullptr;
+		getQueryObjectiv      = timerQuery ? (GetQueryObjectivFunc)SDL_GL_GetProcAddress("glGetQueryObjectiv")       : nullptr;
+		getQueryObjectui64v   = timerQuery ? (GetQueryObjectui64vFunc)SDL_GL_GetProcAddress("glGetQueryObjectui64v") : nullptr;
+
+		// all or nothing
+		if(!genQueries || !deleteQueries || !queryCounter || !getQueryObjectiv || !getQueryObjectui64v)
+			genQueries = nullptr;
+
+		LOG(LogInfo) << " ARB_timer_query: " << (genQueries ? "ok" : "MISSING");
+
+		setupDistanceFieldProgram();
+		setupRenderTargetFunctions();
+
 		const uint8_t data[4] = {255, 255, 255, 255};
-		whiteTexture = createTexture(Texture::RGBA, false, true, 1, 1, data);
+		whiteTexture = createTexture(Texture::RGBA, false, true, false, 1, 1, data);
 
 		GL_CHECK_ERROR(glClearColor(0.0f, 0.0f, 0.0f, 1.0f));
 		GL_CHECK_ERROR(glEnable(GL_TEXTURE_2D));
@@ -141,6 +373,15 @@ namespace Renderer
 
 	void destroyContext()
 	{
+		const DeleteProgramFunc deleteProgram = (DeleteProgramFunc)SDL_GL_GetProcAddress("glDeleteProgram");
+
+		if(distanceFieldProgram && deleteProgram)
+			GL_CHECK_ERROR(deleteProgram(distanceFieldProgram));
+
+		distanceFieldProgram = 0;
+		boundDistanceField   = false;
+		distanceFieldTextures.clear();
+
 		SDL_GL_DeleteContext(sdlContext);
 		sdlContext = nullptr;
 
@@ -148,9 +389,46 @@ namespace Renderer
 
 //////////////////////////////////////////////////////////////////////////
 
-	unsigned int createTexture(const Texture::Type _type, const bool _linear, const bool _repeat, const unsigned int _width, const unsigned int _height, const void* _data)
+	bool supportsTextureType(const Texture::Type _type)
+	{
+		switch(_type)
+		{
+			case Texture::DXT1:           { return (dxt1Format != 0);           } break;
+			case Texture::ETC1:           { return (etc1Format != 0);           } break;
+			case Texture::DISTANCE_FIELD: { return (distanceFieldProgram != 0); } break;
+			default:                      { return true;                        }
+		}
+
+	} // supportsTextureType
+
+//////////////////////////////////////////////////////////////////////////
+
+	// blocks until what the current context was given so far is done, so other contexts see it complete
+	static void waitForUpload()
+	{
+		if(fenceSync && clientWaitSync && deleteSync)
+		{
+			void* fence = fenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+
+			if(fence)
+			{
+				GL_CHECK_ERROR(clientWaitSync(fence, GL_SYNC_FLUSH_COMMANDS_BIT, GL_TIMEOUT_IGNORED));
+				GL_CHECK_ERROR(deleteSync(fence));
+				return;
+			}
+		}
+
+		GL_CHECK_ERROR(glFinish());
+
+	} // waitForUpload
+
+//////////////////////////////////////////////////////////////////////////
+
+	// the texture on whichever context is current, left bound to it
+	static unsigned int createTextureObject(const Texture::Type _type, const bool _linear, const bool _repeat, const bool _mipmap, const unsigned int _width, const unsigned int _height, const void* _data)
 	{
 		const GLenum type = convertTextureType(_type);
+		const bool   mipmap = _mipmap && (_type == Texture::RGBA);
 		unsigned int texture;
 
 		GL_CHECK_ERROR(glGenTextures(1, &texture));
@@ -159,19 +437,84 @@ namespace Renderer
 		GL_CHECK_ERROR(glTexParameterf(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, _repeat ? GL_REPEAT : GL_CLAMP_TO_EDGE));
 		GL_CHECK_ERROR(glTexParameterf(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, _repeat ? GL_REPEAT : GL_CLAMP_TO_EDGE));
 
-		GL_CHECK_ERROR(glTexParameterf(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, _linear ? GL_LINEAR : GL_NEAREST));
-		GL_CHECK_ERROR(glTexParameterf(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST));
+		GL_CHECK_ERROR(glTexParameterf(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, mipmap ? GL_LINEAR_MIPMAP_LINEAR : (_linear ? GL_LINEAR : GL_NEAREST)));
+		// a distance field is only smooth when it's interpolated
+		GL_CHECK_ERROR(glTexParameterf(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, (_type == Texture::DISTANCE_FIELD) ? GL_LINEAR : GL_NEAREST));
+
+		// the driver builds the mipmaps whenever the image is uploaded
+		if(mipmap)
+			GL_CHECK_ERROR(glTexParameteri(GL_TEXTURE_2D, GL_GENERATE_MIPMAP, GL_TRUE));
+
+		if((_type == Texture::DXT1) || (_type == Texture::ETC1))
+		{
+			// whole blocks of 4x4 pixels in 8 bytes
+			const GLsizei size = ((_width + 3) / 4) * ((_height + 3) / 4) * 8;
+			GL_CHECK_ERROR(compressedTexImage2D(GL_TEXTURE_2D, 0, type, _width, _height, 0, size, _data));
+		}
+		else
+		{
+			GL_CHECK_ERROR(glTexImage2D(GL_TEXTURE_2D, 0, type, _width, _height, 0, type, GL_UNSIGNED_BYTE, _data));
+		}
+
+		return texture;
+
+	} // createTextureObject
+
+//////////////////////////////////////////////////////////////////////////
+
+	unsigned int createTexture(const Texture::Type _type, const bool _linear, const bool _repeat, const bool _mipmap, const unsigned int _width, const unsigned int _height, const void* _data)
+	{
+		// the pending batch has to be drawn with the texture that's bound now
+		flush();
+		invalidateFrame();
+
+		const unsigned int texture = createTextureObject(_type, _linear, _repeat, _mipmap, _width, _height, _data);
 
-		GL_CHECK_ERROR(glTexImage2D(GL_TEXTURE_2D, 0, type, _width, _height, 0, type, GL_UNSIGNED_BYTE, _data));
+		if(_type == Texture::DISTANCE_FIELD)
+			distanceFieldTextures.insert(texture);
+
+		GL_CHECK_ERROR(glBindTexture(GL_TEXTURE_2D, boundTexture));
 
 		return texture;
 
 	} // createTexture
 
+//////////////////////////////////////////////////////////////////////////
+
+	unsigned int uploadTexture(const Texture::Type _type, const bool _linear, const bool _repeat, const bool _mipmap, const unsigned int _width, const unsigned int _height, const void* _data)
+	{
+		// the upload context has a state of its own, only the textures are shared
+		GL_CHECK_ERROR(glPixelStorei(GL_UNPACK_ALIGNMENT, 1));
+
+		const unsigned int texture = createTextureObject(_type, _linear, _repeat, _mipmap, _width, _height, _data);
+
+		GL_CHECK_ERROR(glBindTexture(GL_TEXTURE_2D, 0));
+		waitForUpload();
+
+		return texture;
+
+	} // uploadTexture
+
 //////////////////////////////////////////////////////////////////////////
 
 	void destroyTexture(const unsigned int _texture)
 	{
+		flush();
+		invalidateFrame();
+
+		// deleting the bound texture unbinds it
+		if(_texture == boundTexture)
+		{
+			boundTexture = 0;
+
+			if(boundDistanceField)
+				GL_CHECK_ERROR(useProgram(0));
+
+			boundDistanceField = false;
+		}
+
+		distanceFieldTextures.erase(_texture);
+
 		GL_CHECK_ERROR(glDeleteTextures(1, &_texture));
 
 	} // destroyTexture
@@ -182,9 +525,13 @@ namespace Renderer
 	{
 		const GLenum type = convertTextureType(_type);
 
+		// the pending batch may be drawn with the old content of this texture
+		flush();
+		invalidateFrame();
+
 		GL_CHECK_ERROR(glBindTexture(GL_TEXTURE_2D, _texture));
 		GL_CHECK_ERROR(glTexSubImage2D(GL_TEXTURE_2D, 0, _x, _y, _width, _height, type, GL_UNSIGNED_BYTE, _data));
-		GL_CHECK_ERROR(glBindTexture(GL_TEXTURE_2D, whiteTexture));
+		GL_CHECK_ERROR(glBindTexture(GL_TEXTURE_2D, boundTexture));
 
 	} // updateTexture
 
@@ -192,66 +539,103 @@ namespace Renderer
 
 	void bindTexture(const unsigned int _texture)
 	{
-		if(_texture == 0) GL_CHECK_ERROR(glBindTexture(GL_TEXTURE_2D, whiteTexture));
-		else              GL_CHECK_ERROR(glBindTexture(GL_TEXTURE_2D, _texture));
+		const GLuint texture = (_texture == 0) ? whiteTexture : _texture;
 
-	} // bindTexture
+		// a texture always starts out used as a whole
+		setTextureRegion(Vector2f(0.0f, 0.0f), Vector2f(1.0f, 1.0f));
 
-//////////////////////////////////////////////////////////////////////////
+		hashFrameState(&texture, sizeof(texture));
 
-	void drawLines(const Vertex* _vertices, const unsigned int _numVertices, const Blend::Factor _srcBlendFactor, const Blend::Factor _dstBlendFactor)
-	{
-		GL_CHECK_ERROR(glVertexPointer(  2, GL_FLOAT,         sizeof(Vertex), &_vertices[0].pos));
-		GL_CHECK_ERROR(glTexCoordPointer(2, GL_FLOAT,         sizeof(Vertex), &_vertices[0].tex));
-		GL_CHECK_ERROR(glColorPointer(   4, GL_UNSIGNED_BYTE, sizeof(Vertex), &_vertices[0].col));
+		// binding the same texture again keeps the batch going
+		if(texture == boundTexture)
+			return;
+
+		flush();
+		GL_CHECK_ERROR(glBindTexture(GL_TEXTURE_2D, texture));
+		countTextureBind();
+		boundTexture = texture;
 
-		GL_CHECK_ERROR(glBlendFunc(convertBlendFactor(_srcBlendFactor), convertBlendFactor(_dstBlendFactor)));
+		// the program is only switched along with the texture, so it never breaks a batch
+		const bool distanceField = (distanceFieldTextures.find(texture) != distanceFieldTextures.cend());
 
-		GL_CHECK_ERROR(glDrawArrays(GL_LINES, 0, _numVertices));
+		if(distanceField != boundDistanceField)
+		{
+			GL_CHECK_ERROR(useProgram(distanceField ? distanceFieldProgram : 0));
+			boundDistanceField = distanceField;
+		}
 
-	} // drawLines
+	} // bindTexture
 
 //////////////////////////////////////////////////////////////////////////
 
-	void drawTriangleStrips(const Vertex* _vertices, const unsigned int _numVertices, const Blend::Factor _srcBlendFactor, const Blend::Factor _dstBlendFactor)
+	void drawVertices(const Primitive::Type _type, const Vertex* _vertices, const unsigned int _numVertices, const Blend::Factor _srcBlendFactor, const Blend::Factor _dstBlendFactor)
 	{
-		GL_CHECK_ERROR(glVertexPointer(  2, GL_FLOAT,         sizeof(Vertex), &_vertices[0].pos));
-		GL_CHECK_ERROR(glTexCoordPointer(2, GL_FLOAT,         sizeof(Vertex), &_vertices[0].tex));
-		GL_CHECK_ERROR(glColorPointer(   4, GL_UNSIGNED_BYTE, sizeof(Vertex), &_vertices[0].col));
+		// the arrays are read when drawing, the batch is mostly drawn from the same memory every time
+		if(changeState(State::VERTEX_POINTER, &_vertices, sizeof(_vertices)))
+		{
+			GL_CHECK_ERROR(glVertexPointer(  2, GL_FLOAT,         sizeof(Vertex), &_vertices[0].pos));
+			GL_CHECK_ERROR(glTexCoordPointer(2, GL_FLOAT,         sizeof(Vertex), &_vertices[0].tex));
+			GL_CHECK_ERROR(glColorPointer(   4, GL_UNSIGNED_BYTE, sizeof(Vertex), &_vertices[0].col));
+		}
 
-		GL_CHECK_ERROR(glBlendFunc(convertBlendFactor(_srcBlendFactor), convertBlendFactor(_dstBlendFactor)));
+		// color and alpha factors, a render target keeps its alpha premultiplied so it can be drawn with ONE,
+		// ONE_MINUS_SRC_ALPHA later on, blending that isn't the usual one leaves the alpha as it is
+		GLenum blend[4] = { convertBlendFactor(_srcBlendFactor), convertBlendFactor(_dstBlendFactor), 0, 0 };
+		blend[2] = blend[0];
+		blend[3] = blend[1];
+
+		if(boundTarget != 0)
+		{
+			const bool usual = (_srcBlendFactor == Blend::SRC_ALPHA) && (_dstBlendFactor == Blend::ONE_MINUS_SRC_ALPHA);
+			blend[2] = usual ? GL_ONE                 : GL_ZERO;
+			blend[3] = usual ? GL_ONE_MINUS_SRC_ALPHA : GL_ONE;
+		}
+
+		if(changeState(State::BLEND, blend, sizeof(blend)))
+		{
+			if((blend[2] == blend[0]) && (blend[3] == blend[1]))
+				GL_CHECK_ERROR(glBlendFunc(blend[0], blend[1]));
+			else
+				GL_CHECK_ERROR(blendFuncSeparate(blend[0], blend[1], blend[2], blend[3]));
+		}
 
-		GL_CHECK_ERROR(glDrawArrays(GL_TRIANGLE_STRIP, 0, _numVertices));
+		GL_CHECK_ERROR(glDrawArrays(convertPrimitiveType(_type), 0, _numVertices));
 
-	} // drawTriangleStrips
+	} // drawVertices
 
 //////////////////////////////////////////////////////////////////////////
 
-	void setProjection(const Transform4x4f& _projection)
+	static void applyViewport(const Rect& _viewport)
 	{
-		GL_CHECK_ERROR(glMatrixMode(GL_PROJECTION));
-		GL_CHECK_ERROR(glLoadMatrixf((GLfloat*)&_projection));
+		// glViewport starts at the bottom left of the window
+		const GLint viewport[4] = { _viewport.x, getWindowHeight() - _viewport.y - _viewport.h, _viewport.w, _viewport.h };
 
-	} // setProjection
+		if(changeState(State::VIEWPORT, viewport, sizeof(viewport)))
+			GL_CHECK_ERROR(glViewport(viewport[0], viewport[1], viewport[2], viewport[3]));
+
+	} // applyViewport
 
 //////////////////////////////////////////////////////////////////////////
 
-	void setMatrix(const Transform4x4f& _matrix)
+	void setProjection(const Transform4x4f& _projection)
 	{
-		Transform4x4f matrix = _matrix;
-		matrix.round();
+		flush();
+		invalidateFrame();
 
-		GL_CHECK_ERROR(glMatrixMode(GL_MODELVIEW));
-		GL_CHECK_ERROR(glLoadMatrixf((GLfloat*)&matrix));
+		// the modelview matrix stays identity, the world view matrix is applied to the vertices as they're batched
+		GL_CHECK_ERROR(glMatrixMode(GL_PROJECTION));
+		GL_CHECK_ERROR(glLoadMatrixf((GLfloat*)&_projection));
 
-	} // setMatrix
+	} // setProjection
 
 //////////////////////////////////////////////////////////////////////////
 
 	void setViewport(const Rect& _viewport)
 	{
-		// glViewport starts at the bottom left of the window
-		GL_CHECK_ERROR(glViewport( _viewport.x, getWindowHeight() - _viewport.y - _viewport.h, _viewport.w, _viewport.h));
+		flush();
+		invalidateFrame();
+
+		applyViewport(_viewport);
 
 	} // setViewport
 
@@ -259,15 +643,26 @@ namespace Renderer
 
 	void setScissor(const Rect& _scissor)
 	{
-		if((_scissor.x == 0) && (_scissor.y == 0) && (_scissor.w == 0) && (_scissor.h == 0))
+		flush();
+		hashFrameState(&_scissor, sizeof(_scissor));
+
+		const bool enabled = !((_scissor.x == 0) && (_scissor.y == 0) && (_scissor.w == 0) && (_scissor.h == 0));
+
+		if(enabled)
 		{
-			GL_CHECK_ERROR(glDisable(GL_SCISSOR_TEST));
+			// glScissor starts at the bottom left of the window
+			const GLint box[4] = { _scissor.x, getWindowHeight() - _scissor.y - _scissor.h, _scissor.w, _scissor.h };
+
+			if(changeState(State::SCISSOR_BOX, box, sizeof(box)))
+				GL_CHECK_ERROR(glScissor(box[0], box[1], box[2], box[3]));
 		}
-		else
+
+		if(changeState(State::SCISSOR_TEST, &enabled, sizeof(enabled)))
 		{
-			// glScissor starts at the bottom left of the window
-			GL_CHECK_ERROR(glScissor(_scissor.x, getWindowHeight() - _scissor.y - _scissor.h, _scissor.w, _scissor.h));
-			GL_CHECK_ERROR(glEnable(GL_SCISSOR_TEST));
+			if(enabled)
+				GL_CHECK_ERROR(glEnable(GL_SCISSOR_TEST));
+			else
+				GL_CHECK_ERROR(glDisable(GL_SCISSOR_TEST));
 		}
 
 	} // setScissor
@@ -293,15 +688,137 @@ namespace Renderer
 
 	} // setSwapInterval
 
+//////////////////////////////////////////////////////////////////////////
+
+	unsigned int createRenderTarget(const unsigned int _texture)
+	{
+		if(!genFramebuffers)
+			return 0;
+
+		GLuint target = 0;
+
+		GL_CHECK_ERROR(genFramebuffers(1, &target));
+		GL_CHECK_ERROR(bindFramebuffer(GL_FRAMEBUFFER, target));
+		GL_CHECK_ERROR(framebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, _texture, 0));
+
+		const bool complete = (checkFramebufferStatus(GL_FRAMEBUFFER) == GL_FRAMEBUFFER_COMPLETE);
+
+		GL_CHECK_ERROR(bindFramebuffer(GL_FRAMEBUFFER, boundTarget));
+
+		if(!complete)
+		{
+			LOG(LogWarning) << "Could not create a render target, caches draw directly instead";
+			GL_CHECK_ERROR(deleteFramebuffers(1, &target));
+			return 0;
+		}
+
+		return target;
+
+	} // createRenderTarget
+
+//////////////////////////////////////////////////////////////////////////
+
+	void destroyRenderTarget(const unsigned int _target)
+	{
+		flush();
+
+		if(_target == boundTarget)
+			boundTarget = 0;
+
+		GL_CHECK_ERROR(deleteFramebuffers(1, &_target));
+
+	} // destroyRenderTarget
+
+//////////////////////////////////////////////////////////////////////////
+
+	void bindRenderTarget(const unsigned int _target, const Rect& _viewport, const Transform4x4f& _projection, const bool _clear)
+	{
+		// unlike setViewport() and setProjection() the frame isn't invalidated, switching targets is part of a frame
+		flush();
+
+		GL_CHECK_ERROR(bindFramebuffer(GL_FRAMEBUFFER, _target));
+		applyViewport(_viewport);
+		GL_CHECK_ERROR(glMatrixMode(GL_PROJECTION));
+		GL_CHECK_ERROR(glLoadMatrixf((GLfloat*)&_projection));
+		boundTarget = _target;
+
+		if((_target != 0) && _clear)
+		{
+			GL_CHECK_ERROR(glClearColor(0.0f, 0.0f, 0.0f, 0.0f));
+			GL_CHECK_ERROR(glClear(GL_COLOR_BUFFER_BIT));
+			GL_CHECK_ERROR(glClearColor(0.0f, 0.0f, 0.0f, 1.0f));
+		}
+
+	} // bindRenderTarget
+
 //////////////////////////////////////////////////////////////////////////
 
 	void swapBuffers()
 	{
+		// nothing was drawn when the frame came out the same as the one on screen
+		if(!endFrame())
+			return;
+
 		SDL_GL_SwapWindow(getSDLWindow());
 		GL_CHECK_ERROR(glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT));
+		beginFrame();
 
 	} // swapBuffers
 
+//////////////////////////////////////////////////////////////////////////
+
+	unsigned int createTimerQuery()
+	{
+		if(!genQueries)
+			return 0;
+
+		GLuint query = 0;
+		GL_CHECK_ERROR(genQueries(1, &query));
+
+		return query;
+
+	} // createTimerQuery
+
+//////////////////////////////////////////////////////////////////////////
+
+	void destroyTimerQuery(const unsigned int _query)
+	{
+		GL_CHECK_ERROR(deleteQueries(1, &_query));
+
+	} // destroyTimerQuery
+
+//////////////////////////////////////////////////////////////////////////
+
+	void queryTimestamp(const unsigned int _query)
+	{
+		GL_CHECK_ERROR(queryCounter(_query, GL_TIMESTAMP));
+
+	} // queryTimestamp
+
+//////////////////////////////////////////////////////////////////////////
+
+	bool getTimestamp(const unsigned int _query, uint64_t& _nanoseconds)
+	{
+		GLint available = GL_FALSE;
+		GL_CHECK_ERROR(getQueryObjectiv(_query, GL_QUERY_RESULT_AVAILABLE, &available));
+
+		if(available == GL_FALSE)
+			return false;
+
+		GL_CHECK_ERROR(getQueryObjectui64v(_query, GL_QUERY_RESULT, &_nanoseconds));
+		return true;
+
+	} // getTimestamp
+
+//////////////////////////////////////////////////////////////////////////
+
+	bool checkTimerDisjoint()
+	{
+		// only OpenGL ES tells about it, desktop clocks don't jump
+		return false;
+
+	} // checkTimerDisjoint
+
 } // Renderer::
 
 #endif // USE_OPENGL_21
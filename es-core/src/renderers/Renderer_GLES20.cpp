@@ -7,6 +7,29 @@
 
 #include <SDL_opengles2.h>
 #include <SDL.h>
+#include <set>
+
+#ifndef GL_COMPRESSED_RGB_S3TC_DXT1_EXT
+#define GL_COMPRESSED_RGB_S3TC_DXT1_EXT 0x83F0
+#endif // GL_COMPRESSED_RGB_S3TC_DXT1_EXT
+
+#ifndef GL_ETC1_RGB8_OES
+#define GL_ETC1_RGB8_OES 0x8D64
+#endif // GL_ETC1_RGB8_OES
+
+#ifndef GL_TIMESTAMP_EXT
+#define GL_TIMESTAMP_EXT 0x8E28
+#endif // GL_TIMESTAMP_EXT
+
+#ifndef GL_QUERY_RESULT_EXT
+#define GL_QUERY_COUNTER_BITS_EXT     0x8864
+#define GL_QUERY_RESULT_EXT           0x8866
+#define GL_QUERY_RESULT_AVAILABLE_EXT 0x8867
+#endif // GL_QUERY_RESULT_EXT
+
+#ifndef GL_GPU_DISJOINT_EXT
+#define GL_GPU_DISJOINT_EXT 0x8FBB
+#endif // GL_GPU_DISJOINT_EXT
 
 //////////////////////////////////////////////////////////////////////////
 
@@ -29,23 +52,187 @@ namespace Renderer
 
 //////////////////////////////////////////////////////////////////////////
 
-	static SDL_GLContext sdlContext       = nullptr;
-	static Transform4x4f projectionMatrix = Transform4x4f::Identity();
-	static Transform4x4f worldViewMatrix  = Transform4x4f::Identity();
-	static GLuint        shaderProgram    = 0;
-	static GLint         mvpUniform       = 0;
-	static GLint         texAttrib        = 0;
-	static GLint         colAttrib        = 0;
-	static GLint         posAttrib        = 0;
-	static GLuint        vertexBuffer     = 0;
-	static GLuint        whiteTexture     = 0;
+	// the vertex stream is written into one buffer one draw after the other, once it's full a fresh one is
+	// requested from the driver, the draws still in flight keep using the old one
+	#define VERTEX_STREAM_SIZE (sizeof(Vertex) * 1024 * 16)
+
+	// attribute locations are the same for all shaders, the arrays stay enabled when switching between them
+	#define POS_ATTRIB 0
+	#define TEX_ATTRIB 1
+	#define COL_ATTRIB 2
+
+	struct Shader
+	{
+		GLuint       program;
+		GLint        mvpUniform;
+		unsigned int projectionVersion;
+
+	}; // Shader
+
+	enum ShaderType
+	{
+		SHADER_COLOR,          // untextured, the color is all there is
+		SHADER_TEXTURE,        // textured and all vertices opaque white, the color doesn't change anything
+		SHADER_TEXTURE_COLOR,  // textured and tinted
+		SHADER_DISTANCE_FIELD, // glyphs drawn from their distance field, tinted
+		SHADER_COUNT
+
+	}; // ShaderType
+
+	static SDL_GLContext    sdlContext            = nullptr;
+	static Transform4x4f    projectionMatrix      = Transform4x4f::Identity();
+	static unsigned int     projectionVersion     = 1;
+	static Shader           shaders[SHADER_COUNT];
+	static Shader*          currentShader         = nullptr;
+	static GLuint           vertexBuffer          = 0;
+	static size_t           vertexOffset          = 0;
+	static GLuint           whiteTexture          = 0;
+	static GLuint           boundTexture          = 0;
+	static GLenum           dxt1Format            = 0; // 0 when the format isn't supported
+	static GLenum           etc1Format            = 0;
+	static bool             derivatives           = false; // whether the distance field shader can tell how large a texel is on screen
+	static bool             boundDistanceField    = false;
+	static std::set<GLuint> distanceFieldTextures;
+	static GLuint           boundTarget           = 0; // 0 while drawing to the window
+
+	// EXT_disjoint_timer_query, only profiling the GPU uses them
+	typedef void (GL_APIENTRY* GenQueriesFunc)(GLsizei, GLuint*);
+	typedef void (GL_APIENTRY* DeleteQueriesFunc)(GLsizei, const GLuint*);
+	typedef void (GL_APIENTRY* QueryCounterFunc)(GLuint, GLenum);
+	typedef void (GL_APIENTRY* GetQueryivFunc)(GLenum, GLenum, GLint*);
+	typedef void (GL_APIENTRY* GetQueryObjectivFunc)(GLuint, GLenum, GLint*);
+	typedef void (GL_APIENTRY* GetQueryObjectui64vFunc)(GLuint, GLenum, uint64_t*);
+	static GenQueriesFunc          genQueries          = nullptr;
+	static DeleteQueriesFunc       deleteQueries       = nullptr;
+	static QueryCounterFunc        queryCounter        = nullptr;
+	static GetQueryObjectivFunc    getQueryObjectiv    = nullptr;
+	static GetQueryObjectui64vFunc getQueryObjectui64v = nullptr;
+
+//////////////////////////////////////////////////////////////////////////
+
+	static void logInfo(const GLchar* _infoLog, const GLint _success, const char* _name)
+	{
+		if(_success == GL_FALSE)
+		{
+			LOG(LogError) << "GLSL " << _name << " Error\n" << _infoLog;
+		}
+		else
+		{
+			if(strstr(_infoLog, "WARNING") || strstr(_infoLog, "warning") || strstr(_infoLog, "Warning"))
+				LOG(LogWarning) << "GLSL " << _name << " Warning\n" << _infoLog;
+			else
+				LOG(LogInfo) << "GLSL " << _name << " Message\n" << _infoLog;
+		}
+
+	} // logInfo
+
+//////////////////////////////////////////////////////////////////////////
+
+	static GLuint compileShader(const GLenum _type, const GLchar* _source, const char* _name)
+	{
+		const GLuint shader = glCreateShader(_type);
+		GL_CHECK_ERROR(glShaderSource(shader, 1, &_source, nullptr));
+		GL_CHECK_ERROR(glCompileShader(shader));
+
+		GLint isCompiled = GL_FALSE;
+		GLint maxLength  = 0;
+
+		GL_CHECK_ERROR(glGetShaderiv(shader, GL_COMPILE_STATUS, &isCompiled));
+		GL_CHECK_ERROR(glGetShaderiv(shader, GL_INFO_LOG_LENGTH, &maxLength));
+
+		if(maxLength > 1)
+		{
+			char* infoLog = new char[maxLength + 1];
+
+			GL_CHECK_ERROR(glGetShaderInfoLog(shader, maxLength, &maxLength, infoLog));
+			logInfo(infoLog, isCompiled, _name);
+
+			delete[] infoLog;
+		}
+
+		return shader;
+
+	} // compileShader
+
+//////////////////////////////////////////////////////////////////////////
+
+	static void setupShader(Shader& _shader, const GLchar* _vertexSource, const GLchar* _fragmentSource)
+	{
+		const GLuint vertexShader   = compileShader(GL_VERTEX_SHADER,   _vertexSource,   "Vertex Compile");
+		const GLuint fragmentShader = compileShader(GL_FRAGMENT_SHADER, _fragmentSource, "Fragment Compile");
+
+		// shader program
+		_shader.program = glCreateProgram();
+		GL_CHECK_ERROR(glAttachShader(_shader.program, vertexShader));
+		GL_CHECK_ERROR(glAttachShader(_shader.program, fragmentShader));
+
+		GL_CHECK_ERROR(glBindAttribLocation(_shader.program, POS_ATTRIB, "a_pos"));
+		GL_CHECK_ERROR(glBindAttribLocation(_shader.program, TEX_ATTRIB, "a_tex"));
+		GL_CHECK_ERROR(glBindAttribLocation(_shader.program, COL_ATTRIB, "a_col"));
+
+		GL_CHECK_ERROR(glLinkProgram(_shader.program));
+
+		{
+			GLint isLinked  = GL_FALSE;
+			GLint maxLength = 0;
+
+			GL_CHECK_ERROR(glGetProgramiv(_shader.program, GL_LINK_STATUS, &isLinked));
+			GL_CHECK_ERROR(glGetProgramiv(_shader.program, GL_INFO_LOG_LENGTH, &maxLength));
+
+			if(maxLength > 1)
+			{
+				char* infoLog = new char[maxLength + 1];
+
+				GL_CHECK_ERROR(glGetProgramInfoLog(_shader.program, maxLength, &maxLength, infoLog));
+				logInfo(infoLog, isLinked, "Link");
+
+				delete[] infoLog;
+			}
+		}
+
+		// the program keeps what it needs, the shaders can go right away
+		GL_CHECK_ERROR(glDeleteShader(vertexShader));
+		GL_CHECK_ERROR(glDeleteShader(fragmentShader));
+
+		GL_CHECK_ERROR(glUseProgram(_shader.program));
+
+		_shader.mvpUniform        = glGetUniformLocation(_shader.program, "u_mvp");
+		_shader.projectionVersion = 0;
+		const GLint texUniform    = glGetUniformLocation(_shader.program, "u_tex");
+
+		if(texUniform != -1)
+			GL_CHECK_ERROR(glUniform1i(texUniform, 0));
+
+	} // setupShader
 
 //////////////////////////////////////////////////////////////////////////
 
 	static void setupShaders()
 	{
-		// vertex shader
-		const GLchar* vertexSource =
+		// vertex shaders
+		const GLchar* colorVertexSource =
+			"uniform   mat4 u_mvp; \n"
+			"attribute vec2 a_pos; \n"
+			"attribute vec4 a_col; \n"
+			"varying   vec4 v_col; \n"
+			"void main(void)                                     \n"
+			"{                                                   \n"
+			"    gl_Position = u_mvp * vec4(a_pos.xy, 0.0, 1.0); \n"
+			"    v_col       = a_col;                            \n"
+			"}                                                   \n";
+
+		const GLchar* textureVertexSource =
+			"uniform   mat4 u_mvp; \n"
+			"attribute vec2 a_pos; \n"
+			"attribute vec2 a_tex; \n"
+			"varying   vec2 v_tex; \n"
+			"void main(void)                                     \n"
+			"{                                                   \n"
+			"    gl_Position = u_mvp * vec4(a_pos.xy, 0.0, 1.0); \n"
+			"    v_tex       = a_tex;                            \n"
+			"}                                                   \n";
+
+		const GLchar* textureColorVertexSource =
 			"uniform   mat4 u_mvp; \n"
 			"attribute vec2 a_pos; \n"
 			"attribute vec2 a_tex; \n"
@@ -59,41 +246,25 @@ namespace Renderer
 			"    v_col       = a_col;                            \n"
 			"}                                                   \n";
 
-		const GLuint vertexShader = glCreateShader(GL_VERTEX_SHADER);
-		GL_CHECK_ERROR(glShaderSource(vertexShader, 1, &vertexSource, nullptr));
-		GL_CHECK_ERROR(glCompileShader(vertexShader));
-
-		{
-			GLint isCompiled = GL_FALSE;
-			GLint maxLength  = 0;
-
-			GL_CHECK_ERROR(glGetShaderiv(vertexShader, GL_COMPILE_STATUS, &isCompiled));
-			GL_CHECK_ERROR(glGetShaderiv(vertexShader, GL_INFO_LOG_LENGTH, &maxLength));
-
-			if(maxLength > 1)
-			{
-				char* infoLog = new char[maxLength + 1];
-
-				GL_CHECK_ERROR(glGetShaderInfoLog(vertexShader, maxLength, &maxLength, infoLog));
-
-				if(isCompiled == GL_FALSE)
-				{
-					LOG(LogError) << "GLSL Vertex Compile Error\n" << infoLog;
-				}
-				else
-				{
-					if(strstr(infoLog, "WARNING") || strstr(infoLog, "warning") || strstr(infoLog, "Warning"))
-						LOG(LogWarning) << "GLSL Vertex Compile Warning\n" << infoLog;
-					else
-						LOG(LogInfo) << "GLSL Vertex Compile Message\n" << infoLog;
-				}
+		// fragment shaders
+		const GLchar* colorFragmentSource =
+			"precision highp float;     \n"
+			"varying   vec4      v_col; \n"
+			"void main(void)                                     \n"
+			"{                                                   \n"
+			"    gl_FragColor = v_col;                           \n"
+			"}                                                   \n";
 
-				delete[] infoLog;
-			}
-		}
+		const GLchar* textureFragmentSource =
+			"precision highp float;     \n"
+			"uniform   sampler2D u_tex; \n"
+			"varying   vec2      v_tex; \n"
+			"void main(void)                                     \n"
+			"{                                                   \n"
+			"    gl_FragColor = texture2D(u_tex, v_tex);         \n"
+			"}                                                   \n";
 
-		// fragment shader
-		const GLchar* fragmentSource =
+		const GLchar* textureColorFragmentSource =
 			"precision highp float;     \n"
 			"uniform   sampler2D u_tex; \n"
 			"varying   vec2      v_tex; \n"
@@ -103,97 +274,97 @@ namespace Renderer
 			"    gl_FragColor = texture2D(u_tex, v_tex) * v_col; \n"
 			"}                                                   \n";
 
-		const GLuint fragmentShader = glCreateShader(GL_FRAGMENT_SHADER);
-		GL_CHECK_ERROR(glShaderSource(fragmentShader, 1, &fragmentSource, nullptr));
-		GL_CHECK_ERROR(glCompileShader(fragmentShader));
+		// the edge is as sharp as a pixel at any scale, a fixed width has to do without derivatives
+		const std::string distanceFieldFragmentSource = std::string(derivatives ?
+			"#extension GL_OES_standard_derivatives : enable \n" : "") +
+			"precision highp float;     \n"
+			"uniform   sampler2D u_tex; \n"
+			"varying   vec2      v_tex; \n"
+			"varying   vec4      v_col; \n"
+			"void main(void)                                     \n"
+			"{                                                   \n"
+			"    float d = texture2D(u_tex, v_tex).a;            \n" +
+			(derivatives ?
+			"    float w = fwidth(d) * 0.75;                     \n" :
+			"    float w = 0.1;                                  \n") +
+			"    gl_FragColor = vec4(v_col.rgb, v_col.a * smoothstep(0.5 - w, 0.5 + w, d)); \n"
+			"}                                                   \n";
 
-		{
-			GLint isCompiled = GL_FALSE;
-			GLint maxLength  = 0;
+		// all of them are compiled up front, switching between them never stalls on the compiler
+		setupShader(shaders[SHADER_COLOR],          colorVertexSource,        colorFragmentSource);
+		setupShader(shaders[SHADER_TEXTURE],        textureVertexSource,      textureFragmentSource);
+		setupShader(shaders[SHADER_TEXTURE_COLOR],  textureColorVertexSource, textureColorFragmentSource);
+		setupShader(shaders[SHADER_DISTANCE_FIELD], textureColorVertexSource, distanceFieldFragmentSource.c_str());
 
-			GL_CHECK_ERROR(glGetShaderiv(fragmentShader, GL_COMPILE_STATUS, &isCompiled));
-			GL_CHECK_ERROR(glGetShaderiv(fragmentShader, GL_INFO_LOG_LENGTH, &maxLength));
+		currentShader = &shaders[SHADER_TEXTURE_COLOR];
 
-			if(maxLength > 1)
-			{
-				char* infoLog = new char[maxLength + 1];
+		GL_CHECK_ERROR(glEnableVertexAttribArray(POS_ATTRIB));
+		GL_CHECK_ERROR(glEnableVertexAttribArray(TEX_ATTRIB));
+		GL_CHECK_ERROR(glEnableVertexAttribArray(COL_ATTRIB));
 
-				GL_CHECK_ERROR(glGetShaderInfoLog(fragmentShader, maxLength, &maxLength, infoLog));
+	} // setupShaders
 
-				if(isCompiled == GL_FALSE)
-				{
-					LOG(LogError) << "GLSL Fragment Compile Error\n" << infoLog;
-				}
-				else
-				{
-					if(strstr(infoLog, "WARNING") || strstr(infoLog, "warning") || strstr(infoLog, "Warning"))
-						LOG(LogWarning) << "GLSL Fragment Compile Warning\n" << infoLog;
-					else
-						LOG(LogInfo) << "GLSL Fragment Compile Message\n" << infoLog;
-				}
+//////////////////////////////////////////////////////////////////////////
 
-				delete[] infoLog;
-			}
+	static void useShader(const ShaderType _type)
+	{
+		Shader* shader = &shaders[_type];
+
+		if(shader != currentShader)
+		{
+			GL_CHECK_ERROR(glUseProgram(shader->program));
+			currentShader = shader;
 		}
 
-		// shader program
-		shaderProgram = glCreateProgram();
-		GL_CHECK_ERROR(glAttachShader(shaderProgram, vertexShader));
-		GL_CHECK_ERROR(glAttachShader(shaderProgram, fragmentShader));
+		// each program has its own copy of the projection, it's only updated once the program is used
+		if(shader->projectionVersion != projectionVersion)
+		{
+			GL_CHECK_ERROR(glUniformMatrix4fv(shader->mvpUniform, 1, GL_FALSE, (float*)&projectionMatrix));
+			shader->projectionVersion = projectionVersion;
+		}
 
-		GL_CHECK_ERROR(glLinkProgram(shaderProgram));
+	} // useShader
 
-		{
-			GLint isCompiled = GL_FALSE;
-			GLint maxLength  = 0;
+//////////////////////////////////////////////////////////////////////////
 
-			GL_CHECK_ERROR(glGetProgramiv(shaderProgram, GL_LINK_STATUS, &isCompiled));
-			GL_CHECK_ERROR(glGetProgramiv(shaderProgram, GL_INFO_LOG_LENGTH, &maxLength));
+	static void setupVertexBuffer()
+	{
+		GL_CHECK_ERROR(glGenBuffers(1, &vertexBuffer));
+		GL_CHECK_ERROR(glBindBuffer(GL_ARRAY_BUFFER, vertexBuffer));
+		GL_CHECK_ERROR(glBufferData(GL_ARRAY_BUFFER, VERTEX_STREAM_SIZE, nullptr, GL_STREAM_DRAW));
+		vertexOffset = 0;
 
-			if(maxLength > 1)
-			{
-				char* infoLog = new char[maxLength + 1];
+	} // setupVertexBuffer
 
-				GL_CHECK_ERROR(glGetProgramInfoLog(shaderProgram, maxLength, &maxLength, infoLog));
+//////////////////////////////////////////////////////////////////////////
 
-				if(isCompiled == GL_FALSE)
-				{
-					LOG(LogError) << "GLSL Link Error\n" << infoLog;
-				}
-				else
-				{
-					if(strstr(infoLog, "WARNING") || strstr(infoLog, "warning") || strstr(infoLog, "Warning"))
-						LOG(LogWarning) << "GLSL Link Warning\n" << infoLog;
-					else
-						LOG(LogInfo) << "GLSL Link Message\n" << infoLog;
-				}
+	static size_t streamVertices(const Vertex* _vertices, const unsigned int _numVertices)
+	{
+		const size_t size = sizeof(Vertex) * _numVertices;
 
-				delete[] infoLog;
-			}
+		// more than the whole stream, the buffer is sized for this draw alone
+		if(size > VERTEX_STREAM_SIZE)
+		{
+			GL_CHECK_ERROR(glBufferData(GL_ARRAY_BUFFER, size, _vertices, GL_STREAM_DRAW));
+			vertexOffset = VERTEX_STREAM_SIZE;
+			return 0;
 		}
 
-		GL_CHECK_ERROR(glUseProgram(shaderProgram));
+		// orphan the full buffer, writing over data the GPU may still read would wait for it
+		if((vertexOffset + size) > VERTEX_STREAM_SIZE)
+		{
+			GL_CHECK_ERROR(glBufferData(GL_ARRAY_BUFFER, VERTEX_STREAM_SIZE, nullptr, GL_STREAM_DRAW));
+			vertexOffset = 0;
+		}
 
-		mvpUniform       = glGetUniformLocation(shaderProgram, "u_mvp");
-		posAttrib        = glGetAttribLocation(shaderProgram, "a_pos");
-		texAttrib        = glGetAttribLocation(shaderProgram, "a_tex");
-		colAttrib        = glGetAttribLocation(shaderProgram, "a_col");
-		GLint texUniform = glGetUniformLocation(shaderProgram, "u_tex");
-		GL_CHECK_ERROR(glEnableVertexAttribArray(posAttrib));
-		GL_CHECK_ERROR(glEnableVertexAttribArray(texAttrib));
-		GL_CHECK_ERROR(glEnableVertexAttribArray(colAttrib));
-		GL_CHECK_ERROR(glUniform1i(texUniform, 0));
+		const size_t offset = vertexOffset;
 
-	} // setupShaders
-
-//////////////////////////////////////////////////////////////////////////
+		GL_CHECK_ERROR(glBufferSubData(GL_ARRAY_BUFFER, offset, size, _vertices));
+		vertexOffset += size;
 
-	static void setupVertexBuffer()
-	{
-		GL_CHECK_ERROR(glGenBuffers(1, &vertexBuffer));
-		GL_CHECK_ERROR(glBindBuffer(GL_ARRAY_BUFFER, vertexBuffer));
+		return offset;
 
-	} // setupVertexBuffer
+	} // streamVertices
 
 //////////////////////////////////////////////////////////////////////////
 
@@ -222,13 +393,29 @@ namespace Renderer
 	{
 		switch(_type)
 		{
-			case Texture::RGBA:  { return GL_RGBA;            } break;
-			case Texture::ALPHA: { return GL_LUMINANCE_ALPHA; } break;
-			default:             { return GL_ZERO;            }
+			case Texture::RGBA:           { return GL_RGBA;            } break;
+			case Texture::ALPHA:          { return GL_LUMINANCE_ALPHA; } break;
+			case Texture::DXT1:           { return dxt1Format;         } break;
+			case Texture::ETC1:           { return etc1Format;         } break;
+			case Texture::DISTANCE_FIELD: { return GL_LUMINANCE_ALPHA; } break;
+			default:                      { return GL_ZERO;            }
 		}
 
 	} // convertTextureType
 
+//////////////////////////////////////////////////////////////////////////
+
+	static GLenum convertPrimitiveType(const Primitive::Type _type)
+	{
+		switch(_type)
+		{
+			case Primitive::LINES:          { return GL_LINES;          } break;
+			case Primitive::TRIANGLE_STRIP: { return GL_TRIANGLE_STRIP; } break;
+			default:                        { return GL_ZERO;           }
+		}
+
+	} // convertPrimitiveType
+
 //////////////////////////////////////////////////////////////////////////
 
 	unsigned int convertColor(const unsigned int _color)
@@ -286,11 +473,40 @@ namespace Renderer
 		LOG(LogInfo) << "Checking available OpenGL extensions...";
 		LOG(LogInfo) << " ARB_texture_non_power_of_two: " << (extensions.find("ARB_texture_non_power_of_two") != std::string::npos ? "ok" : "MISSING");
 
+		dxt1Format = ((extensions.find("GL_EXT_texture_compression_dxt1") != std::string::npos) || (extensions.find("GL_EXT_texture_compression_s3tc") != std::string::npos)) ? GL_COMPRESSED_RGB_S3TC_DXT1_EXT : 0;
+		etc1Format = (extensions.find("GL_OES_compressed_ETC1_RGB8_texture") != std::string::npos) ? GL_ETC1_RGB8_OES : 0;
+
+		LOG(LogInfo) << " EXT_texture_compression_dxt1: " << (dxt1Format ? "ok" : "MISSING");
+		LOG(LogInfo) << " OES_compressed_ETC1_RGB8_texture: " << (etc1Format ? "ok" : "MISSING");
+
+		derivatives = (extensions.find("GL_OES_standard_derivatives") != std::string::npos);
+
+		LOG(LogInfo) << " OES_standard_derivatives: " << (derivatives ? "ok" : "MISSING");
+
+		const bool timerQuery = (extensions.find("GL_EXT_disjoint_timer_query") != std::string::npos);
+		genQueries            = timerQuery ? (GenQueriesFunc)SDL_GL_GetProcAddress("glGenQueriesEXT")                   : nullptr;
+		deleteQueries         = timerQuery ? (DeleteQueriesFunc)SDL_GL_GetProcAddress("glDeleteQueriesEXT")             : nullptr;
+		queryCounter          = timerQuery ? (QueryCounterFunc)SDL_GL_GetProcAddress("glQueryCounterEXT")               : nullptr;
+		getQueryObjectiv      = timerQuery ? (GetQueryObjectivFunc)SDL_GL_GetProcAddress("glGetQueryObjectivEXT")       : nullptr;
+		getQueryObjectui64v   = timerQuery ? (GetQueryObjectui64vFunc)SDL_GL_GetProcAddress("glGetQueryObjectui64vEXT") : nullptr;
+
+		const GetQueryivFunc getQueryiv = timerQuery ? (GetQueryivFunc)SDL_GL_GetProcAddress("glGetQueryivEXT") : nullptr;
+
+		// all or nothing, some only time whole draws and have no bits for timestamps
+		GLint timestampBits = 0;
+		if(getQueryiv)
+			GL_CHECK_ERROR(getQueryiv(GL_TIMESTAMP_EXT, GL_QUERY_COUNTER_BITS_EXT, &timestampBits));
+
+		if(!genQueries || !deleteQueries || !queryCounter || !getQueryObjectiv || !getQueryObjectui64v || (timestampBits == 0))
+			genQueries = nullptr;
+
+		LOG(LogInfo) << " EXT_disjoint_timer_query: " << (genQueries ? "ok" : "MISSING");
+
 		setupShaders();
 		setupVertexBuffer();
 
 		const uint8_t data[4] = {255, 255, 255, 255};
-		whiteTexture = createTexture(Texture::RGBA, false, true, 1, 1, data);
+		whiteTexture = createTexture(Texture::RGBA, false, true, false, 1, 1, data);
 
 		GL_CHECK_ERROR(glClearColor(0.0f, 0.0f, 0.0f, 1.0f));
 		GL_CHECK_ERROR(glActiveTexture(GL_TEXTURE0));
@@ -304,6 +520,14 @@ namespace Renderer
 
 	void destroyContext()
 	{
+		for(int i = 0; i < SHADER_COUNT; ++i)
+			GL_CHECK_ERROR(glDeleteProgram(shaders[i].program));
+
+		GL_CHECK_ERROR(glDeleteBuffers(1, &vertexBuffer));
+		currentShader = nullptr;
+		vertexBuffer  = 0;
+		distanceFieldTextures.clear();
+
 		SDL_GL_DeleteContext(sdlContext);
 		sdlContext = nullptr;
 
@@ -311,9 +535,34 @@ namespace Renderer
 
 //////////////////////////////////////////////////////////////////////////
 
-	unsigned int createTexture(const Texture::Type _type, const bool _linear, const bool _repeat, const unsigned int _width, const unsigned int _height, const void* _data)
+	bool supportsTextureType(const Texture::Type _type)
+	{
+		switch(_type)
+		{
+			case Texture::DXT1: { return (dxt1Format != 0); } break;
+			case Texture::ETC1: { return (etc1Format != 0); } break;
+			default:            { return true;              }
+		}
+
+	} // supportsTextureType
+
+//////////////////////////////////////////////////////////////////////////
+
+	// blocks until what the current context was given so far is done, so other contexts see it complete
+	static void waitForUpload()
+	{
+		GL_CHECK_ERROR(glFinish());
+
+	} // waitForUpload
+
+//////////////////////////////////////////////////////////////////////////
+
+	// the texture on whichever context is current, left bound to it
+	static unsigned int createTextureObject(const Texture::Type _type, const bool _linear, const bool _repeat, const bool _mipmap, const unsigned int _width, const unsigned int _height, const void* _data)
 	{
 		const GLenum type = convertTextureType(_type);
+		// without GL_OES_texture_npot only power of two textures can have mipmaps
+		const bool   mipmap = _mipmap && (_type == Texture::RGBA) && !(_width & (_width - 1)) && !(_height & (_height - 1));
 		unsigned int texture;
 
 		GL_CHECK_ERROR(glGenTextures(1, &texture));
@@ -322,12 +571,19 @@ namespace Renderer
 		GL_CHECK_ERROR(glTexParameterf(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, _repeat ? GL_REPEAT : GL_CLAMP_TO_EDGE));
 		GL_CHECK_ERROR(glTexParameterf(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, _repeat ? GL_REPEAT : GL_CLAMP_TO_EDGE));
 
-		GL_CHECK_ERROR(glTexParameterf(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, _linear ? GL_LINEAR : GL_NEAREST));
-		GL_CHECK_ERROR(glTexParameterf(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST));
+		GL_CHECK_ERROR(glTexParameterf(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, mipmap ? GL_LINEAR_MIPMAP_LINEAR : (_linear ? GL_LINEAR : GL_NEAREST)));
+		// a distance field is only smooth when it's interpolated
+		GL_CHECK_ERROR(glTexParameterf(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, (_type == Texture::DISTANCE_FIELD) ? GL_LINEAR : GL_NEAREST));
 
+		if((_type == Texture::DXT1) || (_type == Texture::ETC1))
+		{
+			// whole blocks of 4x4 pixels in 8 bytes
+			const GLsizei size = ((_width + 3) / 4) * ((_height + 3) / 4) * 8;
+			GL_CHECK_ERROR(glCompressedTexImage2D(GL_TEXTURE_2D, 0, type, _width, _height, 0, size, _data));
+		}
 		// Regular GL_ALPHA textures are black + alpha in shaders
 		// Create a GL_LUMINANCE_ALPHA texture instead so its white + alpha
-		if(type == GL_LUMINANCE_ALPHA)
+		else if(type == GL_LUMINANCE_ALPHA)
 		{
 			uint8_t* a_data  = (uint8_t*)_data;
 			uint8_t* la_data = new uint8_t[_width * _height * 2];
@@ -346,14 +602,64 @@ namespace Renderer
 			GL_CHECK_ERROR(glTexImage2D(GL_TEXTURE_2D, 0, type, _width, _height, 0, type, GL_UNSIGNED_BYTE, _data));
 		}
 
+		if(mipmap)
+			GL_CHECK_ERROR(glGenerateMipmap(GL_TEXTURE_2D));
+
+		return texture;
+
+	} // createTextureObject
+
+//////////////////////////////////////////////////////////////////////////
+
+	unsigned int createTexture(const Texture::Type _type, const bool _linear, const bool _repeat, const bool _mipmap, const unsigned int _width, const unsigned int _height, const void* _data)
+	{
+		// the pending batch has to be drawn with the texture that's bound now
+		flush();
+		invalidateFrame();
+
+		const unsigned int texture = createTextureObject(_type, _linear, _repeat, _mipmap, _width, _height, _data);
+
+		if(_type == Texture::DISTANCE_FIELD)
+			distanceFieldTextures.insert(texture);
+
+		GL_CHECK_ERROR(glBindTexture(GL_TEXTURE_2D, boundTexture));
+
 		return texture;
 
 	} // createTexture
 
+//////////////////////////////////////////////////////////////////////////
+
+	unsigned int uploadTexture(const Texture::Type _type, const bool _linear, const bool _repeat, const bool _mipmap, const unsigned int _width, const unsigned int _height, const void* _data)
+	{
+		// the upload context has a state of its own, only the textures are shared
+		GL_CHECK_ERROR(glPixelStorei(GL_UNPACK_ALIGNMENT, 1));
+
+		const unsigned int texture = createTextureObject(_type, _linear, _repeat, _mipmap, _width, _height, _data);
+
+		GL_CHECK_ERROR(glBindTexture(GL_TEXTURE_2D, 0));
+		waitForUpload();
+
+		return texture;
+
+	} // uploadTexture
+
 //////////////////////////////////////////////////////////////////////////
 
 	void destroyTexture(const unsigned int _texture)
 	{
+		flush();
+		invalidateFrame();
+
+		// deleting the bound texture unbinds it
+		if(_texture == boundTexture)
+		{
+			boundTexture       = 0;
+			boundDistanceField = false;
+		}
+
+		distanceFieldTextures.erase(_texture);
+
 		GL_CHECK_ERROR(glDeleteTextures(1, &_texture));
 
 	} // destroyTexture
@@ -364,6 +670,10 @@ namespace Renderer
 	{
 		const GLenum type = convertTextureType(_type);
 
+		// the pending batch may be drawn with the old content of this texture
+		flush();
+		invalidateFrame();
+
 		GL_CHECK_ERROR(glBindTexture(GL_TEXTURE_2D, _texture));
 
 		// Regular GL_ALPHA textures are black + alpha in shaders
@@ -387,7 +697,7 @@ namespace Renderer
 			GL_CHECK_ERROR(glTexSubImage2D(GL_TEXTURE_2D, 0, _x, _y, _width, _height, type, GL_UNSIGNED_BYTE, _data));
 		}
 
-		GL_CHECK_ERROR(glBindTexture(GL_TEXTURE_2D, whiteTexture));
+		GL_CHECK_ERROR(glBindTexture(GL_TEXTURE_2D, boundTexture));
 
 	} // updateTexture
 
@@ -395,70 +705,113 @@ namespace Renderer
 
 	void bindTexture(const unsigned int _texture)
 	{
-		if(_texture == 0) GL_CHECK_ERROR(glBindTexture(GL_TEXTURE_2D, whiteTexture));
-		else              GL_CHECK_ERROR(glBindTexture(GL_TEXTURE_2D, _texture));
+		const GLuint texture = (_texture == 0) ? whiteTexture : _texture;
+
+		// a texture always starts out used as a whole
+		setTextureRegion(Vector2f(0.0f, 0.0f), Vector2f(1.0f, 1.0f));
+
+		hashFrameState(&texture, sizeof(texture));
+
+		// binding the same texture again keeps the batch going
+		if(texture == boundTexture)
+			return;
+
+		flush();
+		GL_CHECK_ERROR(glBindTexture(GL_TEXTURE_2D, texture));
+		countTextureBind();
+		boundTexture       = texture;
+		boundDistanceField = (distanceFieldTextures.find(texture) != distanceFieldTextures.cend());
 
 	} // bindTexture
 
 //////////////////////////////////////////////////////////////////////////
 
-	void drawLines(const Vertex* _vertices, const unsigned int _numVertices, const Blend::Factor _srcBlendFactor, const Blend::Factor _dstBlendFactor)
+	void drawVertices(const Primitive::Type _type, const Vertex* _vertices, const unsigned int _numVertices, const Blend::Factor _srcBlendFactor, const Blend::Factor _dstBlendFactor)
 	{
-		GL_CHECK_ERROR(glVertexAttribPointer(posAttrib, 2, GL_FLOAT,         GL_FALSE, sizeof(Vertex), (const void*)offsetof(Vertex, pos)));
-		GL_CHECK_ERROR(glVertexAttribPointer(texAttrib, 2, GL_FLOAT,         GL_FALSE, sizeof(Vertex), (const void*)offsetof(Vertex, tex)));
-		GL_CHECK_ERROR(glVertexAttribPointer(colAttrib, 4, GL_UNSIGNED_BYTE, GL_TRUE,  sizeof(Vertex), (const void*)offsetof(Vertex, col)));
+		ShaderType shader = SHADER_COLOR;
 
-		GL_CHECK_ERROR(glBufferData(GL_ARRAY_BUFFER, sizeof(Vertex) * _numVertices, _vertices, GL_DYNAMIC_DRAW));
-		GL_CHECK_ERROR(glBlendFunc(convertBlendFactor(_srcBlendFactor), convertBlendFactor(_dstBlendFactor)));
+		if(boundDistanceField)
+			shader = SHADER_DISTANCE_FIELD;
+		else if(boundTexture != whiteTexture)
+		{
+			shader = SHADER_TEXTURE;
 
-		GL_CHECK_ERROR(glDrawArrays(GL_LINES, 0, _numVertices));
+			for(unsigned int i = 0; i < _numVertices; ++i)
+			{
+				if(_vertices[i].col != 0xFFFFFFFF)
+				{
+					shader = SHADER_TEXTURE_COLOR;
+					break;
+				}
+			}
+		}
 
-	} // drawLines
+		useShader(shader);
 
-//////////////////////////////////////////////////////////////////////////
+		const size_t offset = streamVertices(_vertices, _numVertices);
 
-	void drawTriangleStrips(const Vertex* _vertices, const unsigned int _numVertices, const Blend::Factor _srcBlendFactor, const Blend::Factor _dstBlendFactor)
-	{
-		GL_CHECK_ERROR(glVertexAttribPointer(posAttrib, 2, GL_FLOAT,         GL_FALSE, sizeof(Vertex), (const void*)offsetof(Vertex, pos)));
-		GL_CHECK_ERROR(glVertexAttribPointer(texAttrib, 2, GL_FLOAT,         GL_FALSE, sizeof(Vertex), (const void*)offsetof(Vertex, tex)));
-		GL_CHECK_ERROR(glVertexAttribPointer(colAttrib, 4, GL_UNSIGNED_BYTE, GL_TRUE,  sizeof(Vertex), (const void*)offsetof(Vertex, col)));
+		GL_CHECK_ERROR(glVertexAttribPointer(POS_ATTRIB, 2, GL_FLOAT,         GL_FALSE, sizeof(Vertex), (const void*)(offset + offsetof(Vertex, pos))));
+		GL_CHECK_ERROR(glVertexAttribPointer(TEX_ATTRIB, 2, GL_FLOAT,         GL_FALSE, sizeof(Vertex), (const void*)(offset + offsetof(Vertex, tex))));
+		GL_CHECK_ERROR(glVertexAttribPointer(COL_ATTRIB, 4, GL_UNSIGNED_BYTE, GL_TRUE,  sizeof(Vertex), (const void*)(offset + offsetof(Vertex, col))));
 
-		GL_CHECK_ERROR(glBufferData(GL_ARRAY_BUFFER, sizeof(Vertex) * _numVertices, _vertices, GL_DYNAMIC_DRAW));
-		GL_CHECK_ERROR(glBlendFunc(convertBlendFactor(_srcBlendFactor), convertBlendFactor(_dstBlendFactor)));
+		// color and alpha factors, a render target keeps its alpha premultiplied so it can be drawn with ONE,
+		// ONE_MINUS_SRC_ALPHA later on, blending that isn't the usual one leaves the alpha as it is
+		GLenum blend[4] = { convertBlendFactor(_srcBlendFactor), convertBlendFactor(_dstBlendFactor), 0, 0 };
+		blend[2] = blend[0];
+		blend[3] = blend[1];
 
-		GL_CHECK_ERROR(glDrawArrays(GL_TRIANGLE_STRIP, 0, _numVertices));
+		if(boundTarget != 0)
+		{
+			const bool usual = (_srcBlendFactor == Blend::SRC_ALPHA) && (_dstBlendFactor == Blend::ONE_MINUS_SRC_ALPHA);
+			blend[2] = usual ? GL_ONE                 : GL_ZERO;
+			blend[3] = usual ? GL_ONE_MINUS_SRC_ALPHA : GL_ONE;
+		}
 
-	} // drawTriangleStrips
+		if(changeState(State::BLEND, blend, sizeof(blend)))
+		{
+			if((blend[2] == blend[0]) && (blend[3] == blend[1]))
+				GL_CHECK_ERROR(glBlendFunc(blend[0], blend[1]));
+			else
+				GL_CHECK_ERROR(glBlendFuncSeparate(blend[0], blend[1], blend[2], blend[3]));
+		}
+
+		GL_CHECK_ERROR(glDrawArrays(convertPrimitiveType(_type), 0, _numVertices));
+
+	} // drawVertices
 
 //////////////////////////////////////////////////////////////////////////
 
-	void setProjection(const Transform4x4f& _projection)
+	static void applyViewport(const Rect& _viewport)
 	{
-		projectionMatrix = _projection;
+		// glViewport starts at the bottom left of the window
+		const GLint viewport[4] = { _viewport.x, getWindowHeight() - _viewport.y - _viewport.h, _viewport.w, _viewport.h };
 
-		Transform4x4f mvpMatrix = projectionMatrix * worldViewMatrix;
-		GL_CHECK_ERROR(glUniformMatrix4fv(mvpUniform, 1, GL_FALSE, (float*)&mvpMatrix));
+		if(changeState(State::VIEWPORT, viewport, sizeof(viewport)))
+			GL_CHECK_ERROR(glViewport(viewport[0], viewport[1], viewport[2], viewport[3]));
 
-	} // setProjection
+	} // applyViewport
 
 //////////////////////////////////////////////////////////////////////////
 
-	void setMatrix(const Transform4x4f& _matrix)
+	void setProjection(const Transform4x4f& _projection)
 	{
-		worldViewMatrix = _matrix;
-		worldViewMatrix.round();
+		flush();
+		invalidateFrame();
 
-		Transform4x4f mvpMatrix = projectionMatrix * worldViewMatrix;
-		GL_CHECK_ERROR(glUniformMatrix4fv(mvpUniform, 1, GL_FALSE, (float*)&mvpMatrix));
+		// the world view matrix is applied to the vertices as they're batched
+		projectionMatrix = _projection;
+		++projectionVersion;
 
-	} // setMatrix
+	} // setProjection
 
 //////////////////////////////////////////////////////////////////////////
 
 	void setViewport(const Rect& _viewport)
 	{
-		// glViewport starts at the bottom left of the window
-		GL_CHECK_ERROR(glViewport( _viewport.x, getWindowHeight() - _viewport.y - _viewport.h, _viewport.w, _viewport.h));
+		flush();
+		invalidateFrame();
+
+		applyViewport(_viewport);
 
 	} // setViewport
 
@@ -466,15 +819,26 @@ namespace Renderer
 
 	void setScissor(const Rect& _scissor)
 	{
-		if((_scissor.x == 0) && (_scissor.y == 0) && (_scissor.w == 0) && (_scissor.h == 0))
+		flush();
+		hashFrameState(&_scissor, sizeof(_scissor));
+
+		const bool enabled = !((_scissor.x == 0) && (_scissor.y == 0) && (_scissor.w == 0) && (_scissor.h == 0));
+
+		if(enabled)
 		{
-			GL_CHECK_ERROR(glDisable(GL_SCISSOR_TEST));
+			// glScissor starts at the bottom left of the window
+			const GLint box[4] = { _scissor.x, getWindowHeight() - _scissor.y - _scissor.h, _scissor.w, _scissor.h };
+
+			if(changeState(State::SCISSOR_BOX, box, sizeof(box)))
+				GL_CHECK_ERROR(glScissor(box[0], box[1], box[2], box[3]));
 		}
-		else
+
+		if(changeState(State::SCISSOR_TEST, &enabled, sizeof(enabled)))
 		{
-			// glScissor starts at the bottom left of the window
-			GL_CHECK_ERROR(glScissor(_scissor.x, getWindowHeight() - _scissor.y - _scissor.h, _scissor.w, _scissor.h));
-			GL_CHECK_ERROR(glEnable(GL_SCISSOR_TEST));
+			if(enabled)
+				GL_CHECK_ERROR(glEnable(GL_SCISSOR_TEST));
+			else
+				GL_CHECK_ERROR(glDisable(GL_SCISSOR_TEST));
 		}
 
 	} // setScissor
@@ -500,15 +864,140 @@ namespace Renderer
 
 	} // setSwapInterval
 
+//////////////////////////////////////////////////////////////////////////
+
+	unsigned int createRenderTarget(const unsigned int _texture)
+	{
+		GLuint target = 0;
+
+		GL_CHECK_ERROR(glGenFramebuffers(1, &target));
+		GL_CHECK_ERROR(glBindFramebuffer(GL_FRAMEBUFFER, target));
+		GL_CHECK_ERROR(glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, _texture, 0));
+
+		const bool complete = (glCheckFramebufferStatus(GL_FRAMEBUFFER) == GL_FRAMEBUFFER_COMPLETE);
+
+		GL_CHECK_ERROR(glBindFramebuffer(GL_FRAMEBUFFER, boundTarget));
+
+		if(!complete)
+		{
+			LOG(LogWarning) << "Could not create a render target, caches draw directly instead";
+			GL_CHECK_ERROR(glDeleteFramebuffers(1, &target));
+			return 0;
+		}
+
+		return target;
+
+	} // createRenderTarget
+
+//////////////////////////////////////////////////////////////////////////
+
+	void destroyRenderTarget(const unsigned int _target)
+	{
+		flush();
+
+		if(_target == boundTarget)
+			boundTarget = 0;
+
+		GL_CHECK_ERROR(glDeleteFramebuffers(1, &_target));
+
+	} // destroyRenderTarget
+
+//////////////////////////////////////////////////////////////////////////
+
+	void bindRenderTarget(const unsigned int _target, const Rect& _viewport, const Transform4x4f& _projection, const bool _clear)
+	{
+		// unlike setViewport() and setProjection() the frame isn't invalidated, switching targets is part of a frame
+		flush();
+
+		GL_CHECK_ERROR(glBindFramebuffer(GL_FRAMEBUFFER, _target));
+		applyViewport(_viewport);
+		boundTarget      = _target;
+		projectionMatrix = _projection;
+		++projectionVersion;
+
+		if((_target != 0) && _clear)
+		{
+			GL_CHECK_ERROR(glClearColor(0.0f, 0.0f, 0.0f, 0.0f));
+			GL_CHECK_ERROR(glClear(GL_COLOR_BUFFER_BIT));
+			GL_CHECK_ERROR(glClearColor(0.0f, 0.0f, 0.0f, 1.0f));
+		}
+
+	} // bindRenderTarget
+
 //////////////////////////////////////////////////////////////////////////
 
 	void swapBuffers()
 	{
+		// nothing was drawn when the frame came out the same as the one on screen
+		if(!endFrame())
+			return;
+
 		SDL_GL_SwapWindow(getSDLWindow());
 		GL_CHECK_ERROR(glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT));
+		beginFrame();
 
 	} // swapBuffers
 
+//////////////////////////////////////////////////////////////////////////
+
+	unsigned int createTimerQuery()
+	{
+		if(!genQueries)
+			return 0;
+
+		GLuint query = 0;
+		GL_CHECK_ERROR(genQueries(1, &query));
+
+		return query;
+
+	} // createTimerQuery
+
+//////////////////////////////////////////////////////////////////////////
+
+	void destroyTimerQuery(const unsigned int _query)
+	{
+		GL_CHECK_ERROR(deleteQueries(1, &_query));
+
+	} // destroyTimerQuery
+
+//////////////////////////////////////////////////////////////////////////
+
+	void queryTimestamp(const unsigned int _query)
+	{
+		GL_CHECK_ERROR(queryCounter(_query, GL_TIMESTAMP_EXT));
+
+	} // queryTimestamp
+
+//////////////////////////////////////////////////////////////////////////
+
+	bool getTimestamp(const unsigned int _query, uint64_t& _nanoseconds)
+	{
+		GLint available = GL_FALSE;
+		GL_CHECK_ERROR(getQueryObjectiv(_query, GL_QUERY_RESULT_AVAILABLE_EXT, &available));
+
+		if(available == GL_FALSE)
+			return false;
+
+		GL_CHECK_ERROR(getQueryObjectui64v(_query, GL_QUERY_RESULT_EXT, &_nanoseconds));
+		return true;
+
+	} // getTimestamp
+
+//////////////////////////////////////////////////////////////////////////
+
+	bool checkTimerDisjoint()
+	{
+		if(!genQueries)
+			return false;
+
+		// reading it resets it
+		GLint disjoint = GL_FALSE;
+		GL_CHECK_ERROR(glGetIntegerv(GL_GPU_DISJOINT_EXT, &disjoint));
+
+		return (disjoint != GL_FALSE);
+
+	} // checkTimerDisjoint
+
 } // Renderer::
 
 #endif // USE_OPENGLES_20
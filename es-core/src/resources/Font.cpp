@@ -1,19 +1,34 @@
 #include "resources/Font.h"
 
 #include "renderers/Renderer.h"
+#include "utils/BinaryUtil.h"
 #include "utils/FileSystemUtil.h"
 #include "utils/StringUtil.h"
 #include "Log.h"
+#include "MemoryUsage.h"
+#include "Settings.h"
+#include <math.h>
+#include <stdint.h>
+#include <string.h>
+#include <functional>
+#include <iomanip>
+#include <sstream>
 
 #ifdef WIN32
 #include <Windows.h>
 #endif
 
+static const char     GLYPH_CACHE_MAGIC[4] = { 'E', 'S', 'G', 'C' };
+static const uint32_t GLYPH_CACHE_VERSION  = 1;
+
 FT_Library Font::sLibrary = NULL;
 
 int Font::getSize() const { return mSize; }
 
 std::map< std::pair<std::string, int>, std::weak_ptr<Font> > Font::sFontMap;
+std::map< std::string, std::weak_ptr<Font> > Font::sDistanceFieldMap;
+std::vector< std::unique_ptr<Font::FontTexture> > Font::sTextures;
+int Font::sLoadedFonts = 0;
 
 Font::FontFace::FontFace(ResourceData&& d, int size) : data(d)
 {
@@ -42,9 +57,10 @@ void Font::initLibrary()
 
 size_t Font::getMemUsage() const
 {
+	// the pages are shared, count the part of them this font's glyphs take up, scaled glyphs belong to the source font
 	size_t memUsage = 0;
-	for(auto it = mTextures.cbegin(); it != mTextures.cend(); it++)
-		memUsage += it->textureSize.x() * it->textureSize.y() * 4;
+	for(auto it = mGlyphMap.cbegin(); (it != mGlyphMap.cend()) && !mSource; it++)
+		memUsage += (size_t)((it->second.texSize.x() * it->second.texture->textureSize.x()) * (it->second.texSize.y() * it->second.texture->textureSize.y())) * 4;
 
 	for(auto it = mFaceCache.cbegin(); it != mFaceCache.cend(); it++)
 		memUsage += it->second->data.length;
@@ -52,6 +68,28 @@ size_t Font::getMemUsage() const
 	return memUsage;
 }
 
+float Font::getAtlasUsage(size_t& pages)
+{
+	size_t used = 0;
+	size_t total = 0;
+
+	pages = 0;
+
+	for(auto it = sTextures.cbegin(); it != sTextures.cend(); it++)
+	{
+		if((*it)->textureId == 0)
+			continue;
+
+		for(auto node = (*it)->skyline.cbegin(); node != (*it)->skyline.cend(); node++)
+			used += node->width * node->y;
+
+		total += (*it)->textureSize.x() * (*it)->textureSize.y();
+		pages++;
+	}
+
+	return (total > 0) ? ((float)used / (float)total) : 0.0f;
+}
+
 size_t Font::getTotalMemUsage()
 {
 	size_t total = 0;
@@ -65,24 +103,39 @@ size_t Font::getTotalMemUsage()
 			continue;
 		}
 
-		total += it->second.lock()->getMemUsage();
+		std::shared_ptr<Font> font = it->second.lock();
+		for(auto fit = font->mFaceCache.cbegin(); fit != font->mFaceCache.cend(); fit++)
+			total += fit->second->data.length;
 		it++;
 	}
 
+	for(auto it = sTextures.cbegin(); it != sTextures.cend(); it++)
+	{
+		if((*it)->textureId != 0)
+			total += (*it)->textureSize.x() * (*it)->textureSize.y() * 4;
+	}
+
 	return total;
 }
 
-Font::Font(int size, const std::string& path) : mSize(size), mPath(path)
+Font::Font(int size, const std::string& path, bool distanceField, const std::shared_ptr<Font>& source) : mSize(size), mPath(path),
+	mDistanceField(distanceField), mSource(source)
 {
 	assert(mSize > 0);
 
-	mTextures.reserve(10);
 	mLoaded = true;
+	++sLoadedFonts;
 	mMaxGlyphHeight = 0;
+	mGlyphCacheDirty = false;
+	mTextLayoutVertices = 0;
 
 	if(!sLibrary)
 		initLibrary();
 
+	// scaled glyphs come from the source font, which has its own cache
+	if(!mSource)
+		loadGlyphCache();
+
 	// always initialize ASCII characters
 	for(unsigned int i = 32; i < 128; i++)
 		getGlyph(i);
@@ -93,6 +146,7 @@ Font::Font(int size, const std::string& path) : mSize(size), mPath(path)
 Font::~Font()
 {
 	unload();
+	releaseGlyphs();
 }
 
 void Font::reload()
@@ -100,6 +154,7 @@ void Font::reload()
 	if (mLoaded)
 		return;
 
+	++sLoadedFonts;
 	rebuildTextures();
 	mLoaded = true;
 }
@@ -128,26 +183,68 @@ std::shared_ptr<Font> Font::get(int size, const std::string& path)
 			return foundFont->second.lock();
 	}
 
-	std::shared_ptr<Font> font = std::shared_ptr<Font>(new Font(def.second, def.first));
+	// only fonts loaded from now on switch
+	std::shared_ptr<Font> source;
+	if(Settings::getInstance()->getBool("FontDistanceField") && Renderer::supportsTextureType(Renderer::Texture::DISTANCE_FIELD))
+		source = getDistanceField(def.first);
+
+	std::shared_ptr<Font> font = std::shared_ptr<Font>(new Font(def.second, def.first, false, source));
 	sFontMap[def] = std::weak_ptr<Font>(font);
 	ResourceManager::getInstance()->addReloadable(font);
 	return font;
 }
 
+std::shared_ptr<Font> Font::getDistanceField(const std::string& path)
+{
+	auto foundFont = sDistanceFieldMap.find(path);
+	if(foundFont != sDistanceFieldMap.cend())
+	{
+		if(!foundFont->second.expired())
+			return foundFont->second.lock();
+	}
+
+	std::shared_ptr<Font> font = std::shared_ptr<Font>(new Font(DISTANCE_FIELD_SIZE, path, true, nullptr));
+	sDistanceFieldMap[path] = std::weak_ptr<Font>(font);
+	ResourceManager::getInstance()->addReloadable(font);
+	return font;
+}
+
 void Font::unloadTextures()
 {
-	for(auto it = mTextures.begin(); it != mTextures.end(); it++)
+	// other fonts may still draw from the same pages
+	if(--sLoadedFonts > 0)
+		return;
+
+	for(auto it = sTextures.begin(); it != sTextures.end(); it++)
+	{
+		(*it)->deinitTexture();
+	}
+}
+
+void Font::releaseGlyphs()
+{
+	// a page without glyphs of live fonts gives back its VRAM and is packed again from scratch,
+	// scaled glyphs belong to the source font
+	for(auto it = mGlyphMap.cbegin(); (it != mGlyphMap.cend()) && !mSource; it++)
 	{
-		it->deinitTexture();
+		FontTexture* tex = it->second.texture;
+
+		if(--tex->glyphCount == 0)
+		{
+			tex->reset();
+			tex->deinitTexture();
+		}
 	}
+
+	mGlyphMap.clear();
 }
 
-Font::FontTexture::FontTexture()
+Font::FontTexture::FontTexture(Renderer::Texture::Type type)
 {
 	textureId = 0;
 	textureSize = Vector2i(2048, 512);
-	writePos = Vector2i::Zero();
-	rowHeight = 0;
+	this->type = type;
+	reset();
 }
 
 Font::FontTexture::~FontTexture()
@@ -155,40 +252,110 @@ Font::FontTexture::~FontTexture()
 	deinitTexture();
 }
 
+bool Font::FontTexture::fits(size_t index, const Vector2i& size, int& y_out) const
+{
+	// the glyph would sit on top of the highest node it spans
+	if(skyline[index].x + size.x() > textureSize.x())
+		return false;
+
+	int widthLeft = size.x();
+	y_out = 0;
+
+	for(size_t i = index; widthLeft > 0; i++)
+	{
+		if(skyline[i].y > y_out)
+			y_out = skyline[i].y;
+
+		if(y_out + size.y() > textureSize.y())
+			return false;
+
+		widthLeft -= skyline[i].width;
+	}
+
+	return true;
+}
+
 bool Font::FontTexture::findEmpty(const Vector2i& size, Vector2i& cursor_out)
 {
 	if(size.x() >= textureSize.x() || size.y() >= textureSize.y())
 		return false;
 
-	if(writePos.x() + size.x() >= textureSize.x() &&
-		writePos.y() + rowHeight + size.y() + 1 < textureSize.y())
+	const Vector2i paddedSize(size.x() + 1, size.y() + 1); // leave 1px of space between glyphs
+	size_t bestIndex = skyline.size();
+	int bestBottom = textureSize.y() + 1;
+	int bestWidth = textureSize.x() + 1;
+	int bestY = 0;
+
+	// the lowest spot wins, then the one that wastes the least of the node it starts on
+	for(size_t i = 0; i < skyline.size(); i++)
 	{
-		// row full, but it should fit on the next row
-		// move cursor to next row
-		writePos = Vector2i(0, writePos.y() + rowHeight + 1); // leave 1px of space between glyphs
-		rowHeight = 0;
+		int y;
+
+		if(!fits(i, paddedSize, y))
+			continue;
+
+		if((y + paddedSize.y() < bestBottom) || ((y + paddedSize.y() == bestBottom) && (skyline[i].width < bestWidth)))
+		{
+			bestIndex = i;
+			bestBottom = y + paddedSize.y();
+			bestWidth = skyline[i].width;
+			bestY = y;
+		}
 	}
 
-	if(writePos.x() + size.x() >= textureSize.x() ||
-		writePos.y() + size.y() >= textureSize.y())
-	{
-		// nope, still won't fit
+	if(bestIndex == skyline.size())
 		return false;
+
+	cursor_out = Vector2i(skyline[bestIndex].x, bestY);
+
+	const SkylineNode node = { cursor_out.x(), bestBottom, paddedSize.x() };
+	skyline.insert(skyline.begin() + bestIndex, node);
+
+	// cut away what the new node covers of the nodes to its right
+	for(size_t i = bestIndex + 1; i < skyline.size(); )
+	{
+		const int covered = (skyline[i - 1].x + skyline[i - 1].width) - skyline[i].x;
+
+		if(covered <= 0)
+			break;
+
+		skyline[i].x += covered;
+		skyline[i].width -= covered;
+
+		if(skyline[i].width > 0)
+			break;
+
+		skyline.erase(skyline.begin() + i);
 	}
 
-	cursor_out = writePos;
-	writePos[0] += size.x() + 1; // leave 1px of space between glyphs
+	// merge neighbours of the same height
+	for(size_t i = 0; i + 1 < skyline.size(); )
+	{
+		if(skyline[i].y == skyline[i + 1].y)
+		{
+			skyline[i].width += skyline[i + 1].width;
+			skyline.erase(skyline.begin() + i + 1);
+		}
+		else
+			i++;
+	}
 
-	if(size.y() > rowHeight)
-		rowHeight = size.y();
+	glyphCount++;
 
 	return true;
 }
 
+void Font::FontTexture::reset()
+{
+	const SkylineNode node = { 0, 0, textureSize.x() };
+	skyline.assign(1, node);
+	glyphCount = 0;
+}
+
 void Font::FontTexture::initTexture()
 {
 	assert(textureId == 0);
-	textureId = Renderer::createTexture(Renderer::Texture::ALPHA, false, false, textureSize.x(), textureSize.y(), nullptr);
+	textureId = Renderer::createTexture(type, type == Renderer::Texture::DISTANCE_FIELD, false, false, textureSize.x(), textureSize.y(), nullptr);
 }
 
 void Font::FontTexture::deinitTexture()
@@ -200,29 +367,28 @@ void Font::FontTexture::deinitTexture()
 	}
 }
 
-void Font::getTextureForNewGlyph(const Vector2i& glyphSize, FontTexture*& tex_out, Vector2i& cursor_out)
+void Font::getTextureForNewGlyph(Renderer::Texture::Type type, const Vector2i& glyphSize, FontTexture*& tex_out, Vector2i& cursor_out)
 {
-	if(mTextures.size())
+	// any page with space will do, glyphs of all fonts share them
+	for(auto it = sTextures.begin(); it != sTextures.end(); it++)
 	{
-		// check if the most recent texture has space
-		tex_out = &mTextures.back();
+		tex_out = it->get();
 
-		// will this one work?
-		if(tex_out->findEmpty(glyphSize, cursor_out))
-			return; // yes
-	}
+		if(tex_out->type != type)
+			continue;
 
-	if(mTextures.size() >= mTextures.capacity())
-	{
-		LOG(LogError) << "Glyph too many to create a new texture!";
-		tex_out = NULL;
-		return;
+		if(tex_out->findEmpty(glyphSize, cursor_out))
+		{
+			if(tex_out->textureId == 0)
+				tex_out->initTexture();
+			return;
+		}
 	}
 
 	// current textures are full,
 	// make a new one
-	mTextures.push_back(FontTexture());
-	tex_out = &mTextures.back();
+	sTextures.push_back(std::unique_ptr<FontTexture>(new FontTexture(type)));
+	tex_out = sTextures.back().get();
 	tex_out->initTexture();
 
 	bool ok = tex_out->findEmpty(glyphSize, cursor_out);
@@ -317,6 +483,276 @@ FT_Face Font::getFaceForChar(unsigned int id)
 void Font::clearFaceCache()
 {
 	mFaceCache.clear();
+
+	if(mSource)
+		mSource->clearFaceCache();
+}
+
+// squared distance of each of the n samples of f to the nearest 0 along one line, Felzenszwalb & Huttenlocher
+static void distanceTransform(const float* f, float* d, int* v, float* z, int n)
+{
+	int k = 0;
+	v[0] = 0;
+	z[0] = -1e20f;
+	z[1] = 1e20f;
+
+	for(int q = 1; q < n; q++)
+	{
+		float s = ((f[q] + q * q) - (f[v[k]] + v[k] * v[k])) / (2 * q - 2 * v[k]);
+		while(s <= z[k])
+		{
+			k--;
+			s = ((f[q] + q * q) - (f[v[k]] + v[k] * v[k])) / (2 * q - 2 * v[k]);
+		}
+		k++;
+		v[k] = q;
+		z[k] = s;
+		z[k + 1] = 1e20f;
+	}
+
+	k = 0;
+	for(int q = 0; q < n; q++)
+	{
+		while(z[k + 1] < q)
+			k++;
+		d[q] = (q - v[k]) * (q - v[k]) + f[v[k]];
+	}
+}
+
+// squared distance of each pixel to the nearest pixel with inside set as given
+static std::vector<float> distanceTransform(const std::vector<bool>& inside, bool to, int width, int height)
+{
+	const int n = Math::max(width, height);
+	std::vector<float> grid(width * height);
+	std::vector<float> f(n), d(n), z(n + 1);
+	std::vector<int> v(n);
+
+	for(int i = 0; i < width * height; i++)
+		grid[i] = (inside[i] == to) ? 0.0f : 1e20f;
+
+	for(int x = 0; x < width; x++)
+	{
+		for(int y = 0; y < height; y++)
+			f[y] = grid[y * width + x];
+		distanceTransform(f.data(), d.data(), v.data(), z.data(), height);
+		for(int y = 0; y < height; y++)
+			grid[y * width + x] = d[y];
+	}
+
+	for(int y = 0; y < height; y++)
+	{
+		distanceTransform(&grid[y * width], d.data(), v.data(), z.data(), width);
+		for(int x = 0; x < width; x++)
+			grid[y * width + x] = d[x];
+	}
+
+	return grid;
+}
+
+// the coverage of a glyph turned into the distance to its edge, spread pixels larger on each side.
+// 0.5 is on the edge and the distance fades to 0 outside and to 1 inside over spread pixels
+static std::vector<unsigned char> buildDistanceField(const unsigned char* coverage, int width, int height, int spread)
+{
+	const int paddedWidth = width + (spread * 2);
+	const int paddedHeight = height + (spread * 2);
+	std::vector<bool> inside(paddedWidth * paddedHeight, false);
+
+	for(int y = 0; y < height; y++)
+		for(int x = 0; x < width; x++)
+			inside[(y + spread) * paddedWidth + (x + spread)] = (coverage[y * width + x] >= 128);
+
+	const std::vector<float> outside = distanceTransform(inside, true, paddedWidth, paddedHeight);
+	const std::vector<float> within = distanceTransform(inside, false, paddedWidth, paddedHeight);
+	std::vector<unsigned char> field(paddedWidth * paddedHeight);
+
+	for(int i = 0; i < paddedWidth * paddedHeight; i++)
+	{
+		// the edge runs between the last pixel inside and the first outside
+		const float distance = inside[i] ? (sqrtf(within[i]) - 0.5f) : (0.5f - sqrtf(outside[i]));
+		const float value = 0.5f + (distance / (spread * 2));
+		field[i] = (unsigned char)(Math::clamp(value, 0.0f, 1.0f) * 255.0f + 0.5f);
+	}
+
+	return field;
+}
+
+std::vector<unsigned char> Font::renderGlyph(FT_GlyphSlot glyphSlot, Vector2i& size_out) const
+{
+	const int width = glyphSlot->bitmap.width;
+	const int height = glyphSlot->bitmap.rows;
+
+	if(mDistanceField)
+	{
+		size_out = Vector2i(width + (DISTANCE_FIELD_SPREAD * 2), height + (DISTANCE_FIELD_SPREAD * 2));
+		return buildDistanceField(glyphSlot->bitmap.buffer, width, height, DISTANCE_FIELD_SPREAD);
+	}
+
+	size_out = Vector2i(width, height);
+	return std::vector<unsigned char>(glyphSlot->bitmap.buffer, glyphSlot->bitmap.buffer + (width * height));
+}
+
+void Font::uploadGlyph(FontTexture* tex, const Vector2i& cursor, FT_GlyphSlot glyphSlot)
+{
+	Vector2i size;
+	const std::vector<unsigned char> data = renderGlyph(glyphSlot, size);
+
+	Renderer::updateTexture(tex->textureId, tex->type, cursor.x(), cursor.y(), size.x(), size.y(), data.data());
+}
+
+std::string Font::getGlyphCachePath() const
+{
+	std::stringstream key;
+	key << mPath << "@" << mSize << (mDistanceField ? "@distance" : "");
+
+	std::stringstream ss;
+	ss << std::hex << std::setw(16) << std::setfill('0') << (uint64_t)std::hash<std::string>()(key.str());
+
+	return Utils::FileSystem::getHomePath() + "/.emulationstation/glyph_cache/" + ss.str() + ".bin";
+}
+
+void Font::loadGlyphCache()
+{
+	std::string buffer;
+
+	if(!Utils::Binary::loadFile(getGlyphCachePath(), buffer))
+		return;
+
+	Utils::Binary::Reader reader(buffer);
+	char magic[4];
+	uint32_t version;
+	std::string cachedPath;
+	int32_t cachedSize;
+	uint8_t cachedDistanceField;
+	int64_t cachedFileSize;
+	int64_t cachedFileTime;
+	uint32_t count;
+
+	if(!reader.read(magic, sizeof(magic)) || memcmp(magic, GLYPH_CACHE_MAGIC, sizeof(magic)) ||
+		!reader.read(version) || (version != GLYPH_CACHE_VERSION) ||
+		!reader.readString(cachedPath) || !reader.read(cachedSize) || !reader.read(cachedDistanceField) ||
+		!reader.read(cachedFileSize) || !reader.read(cachedFileTime) || !reader.read(count))
+		return;
+
+	int64_t fileSize, fileTime;
+	ResourceManager::getInstance()->getFileStats(mPath, fileSize, fileTime);
+
+	// another font with the same hash or a changed font file
+	if((cachedPath != mPath) || (cachedSize != mSize) || ((cachedDistanceField != 0) != mDistanceField) ||
+		(cachedFileSize != fileSize) || (cachedFileTime != fileTime))
+		return;
+
+	for(uint32_t i = 0; i < count; i++)
+	{
+		uint32_t id;
+		int32_t width;
+		int32_t height;
+		CachedGlyph glyph;
+
+		if(!reader.read(id) || !reader.read(width) || !reader.read(height) || (width < 0) || (height < 0) ||
+			!reader.read(glyph.advance) || !reader.read(glyph.bearing) || (reader.getRemaining() < (size_t)(width * height)))
+		{
+			// a truncated file, the glyphs so far are fine
+			break;
+		}
+
+		glyph.size = Vector2i(width, height);
+		glyph.data.resize(width * height);
+		reader.read(glyph.data.data(), glyph.data.size());
+		mGlyphCache[id] = std::move(glyph);
+	}
+}
+
+void Font::saveGlyphCache()
+{
+	if(!mGlyphCacheDirty || mSource)
+		return;
+
+	Utils::Binary::Writer glyphs;
+	uint32_t count = 0;
+
+	// the glyphs on the pages have to be rasterized again, only their metrics are kept
+	for(auto it = mGlyphMap.cbegin(); (it != mGlyphMap.cend()) && (count < MAX_CACHED_GLYPHS); it++)
+	{
+		FT_Face face = getFaceForChar(it->first);
+
+		if(FT_Load_Char(face, it->first, FT_LOAD_RENDER))
+			continue;
+
+		Vector2i size;
+		const std::vector<unsigned char> data = renderGlyph(face->glyph, size);
+
+		glyphs.write((uint32_t)it->first);
+		glyphs.write((int32_t)size.x());
+		glyphs.write((int32_t)size.y());
+		glyphs.write(it->second.advance);
+		glyphs.write(it->second.bearing);
+		glyphs.write(data.data(), data.size());
+		count++;
+	}
+
+	// then the ones from last time that weren't needed this time
+	for(auto it = mGlyphCache.cbegin(); (it != mGlyphCache.cend()) && (count < MAX_CACHED_GLYPHS); it++)
+	{
+		glyphs.write((uint32_t)it->first);
+		glyphs.write((int32_t)it->second.size.x());
+		glyphs.write((int32_t)it->second.size.y());
+		glyphs.write(it->second.advance);
+		glyphs.write(it->second.bearing);
+		glyphs.write(it->second.data.data(), it->second.data.size());
+		count++;
+	}
+
+	clearFaceCache();
+
+	Utils::Binary::Writer writer;
+
+	writer.write(GLYPH_CACHE_MAGIC, sizeof(GLYPH_CACHE_MAGIC));
+	writer.write(GLYPH_CACHE_VERSION);
+	writer.writeString(mPath);
+	writer.write((int32_t)mSize);
+	writer.write((uint8_t)(mDistanceField ? 1 : 0));
+	int64_t fileSize, fileTime;
+	ResourceManager::getInstance()->getFileStats(mPath, fileSize, fileTime);
+	writer.write(fileSize);
+	writer.write(fileTime);
+	writer.write(count);
+	writer.write(glyphs.getBuffer().data(), glyphs.getBuffer().size());
+
+	if(Utils::Binary::saveFile(getGlyphCachePath(), writer.getBuffer()))
+		mGlyphCacheDirty = false;
+	else
+		LOG(LogWarning) << "Could not save glyph cache for font " << mPath << ", size " << mSize;
+}
+
+void Font::saveGlyphCaches()
+{
+	for(auto it = sFontMap.cbegin(); it != sFontMap.cend(); it++)
+	{
+		if(!it->second.expired())
+			it->second.lock()->saveGlyphCache();
+	}
+
+	for(auto it = sDistanceFieldMap.cbegin(); it != sDistanceFieldMap.cend(); it++)
+	{
+		if(!it->second.expired())
+			it->second.lock()->saveGlyphCache();
+	}
+}
+
+void Font::releaseTextCaches()
+{
+	for(auto it = sFontMap.cbegin(); it != sFontMap.cend(); it++)
+	{
+		if(it->second.expired())
+			continue;
+
+		std::shared_ptr<Font> font = it->second.lock();
+		font->mTextLayouts.clear();
+		font->mTextLayoutLookup.clear();
+		font->mTextLayoutVertices = 0;
+		font->mWrappedTexts.clear();
+		font->mWrappedTextLookup.clear();
+	}
 }
 
 Font::Glyph* Font::getGlyph(unsigned int id)
@@ -326,27 +762,71 @@ Font::Glyph* Font::getGlyph(unsigned int id)
 	if(it != mGlyphMap.cend())
 		return &it->second;
 
-	// nope, need to make a glyph
-	FT_Face face = getFaceForChar(id);
-	if(!face)
+	// scaled from the distance field, which is drawn as sharp at any size
+	if(mSource)
 	{
-		LOG(LogError) << "Could not find appropriate font face for character " << id << " for font " << mPath;
-		return NULL;
+		Glyph* source = mSource->getGlyph(id);
+		if(source == NULL)
+			return NULL;
+
+		const float scale = mSize / (float)mSource->mSize;
+		Glyph& glyph = mGlyphMap[id];
+
+		glyph = *source;
+		glyph.size = source->size * scale;
+		glyph.padding = source->padding * scale;
+		glyph.advance = source->advance * scale;
+		glyph.bearing = source->bearing * scale;
+
+		const int height = (int)ceilf(glyph.size.y() - (glyph.padding * 2));
+		if(height > mMaxGlyphHeight)
+			mMaxGlyphHeight = height;
+
+		return &glyph;
 	}
 
-	FT_GlyphSlot g = face->glyph;
+	// nope, need to make a glyph, from the cache when it was there last time
+	auto cached = mGlyphCache.find(id);
+	FT_GlyphSlot g = NULL;
+	Vector2i paddedSize;
+	Vector2f advance;
+	Vector2f bearing;
+	const int padding = mDistanceField ? DISTANCE_FIELD_SPREAD : 0;
 
-	if(FT_Load_Char(face, id, FT_LOAD_RENDER))
+	if(cached != mGlyphCache.end())
 	{
-		LOG(LogError) << "Could not find glyph for character " << id << " for font " << mPath << ", size " << mSize << "!";
-		return NULL;
+		paddedSize = cached->second.size;
+		advance = cached->second.advance;
+		bearing = cached->second.bearing;
+	}
+	else
+	{
+		FT_Face face = getFaceForChar(id);
+		if(!face)
+		{
+			LOG(LogError) << "Could not find appropriate font face for character " << id << " for font " << mPath;
+			return NULL;
+		}
+
+		g = face->glyph;
+
+		if(FT_Load_Char(face, id, FT_LOAD_RENDER))
+		{
+			LOG(LogError) << "Could not find glyph for character " << id << " for font " << mPath << ", size " << mSize << "!";
+			return NULL;
+		}
+
+		paddedSize = Vector2i(g->bitmap.width + (padding * 2), g->bitmap.rows + (padding * 2));
+		advance = Vector2f((float)g->metrics.horiAdvance / 64.0f, (float)g->metrics.vertAdvance / 64.0f);
+		bearing = Vector2f((float)g->metrics.horiBearingX / 64.0f - padding, (float)g->metrics.horiBearingY / 64.0f + padding);
+		mGlyphCacheDirty = true;
 	}
 
-	Vector2i glyphSize(g->bitmap.width, g->bitmap.rows);
+	const Vector2i glyphSize(paddedSize.x() - (padding * 2), paddedSize.y() - (padding * 2));
 
 	FontTexture* tex = NULL;
 	Vector2i cursor;
-	getTextureForNewGlyph(glyphSize, tex, cursor);
+	getTextureForNewGlyph(mDistanceField ? Renderer::Texture::DISTANCE_FIELD : Renderer::Texture::ALPHA, paddedSize, tex, cursor);
 
 	// getTextureForNewGlyph can fail if the glyph is bigger than the max texture size (absurdly large font size)
 	if(tex == NULL)
@@ -360,13 +840,22 @@ Font::Glyph* Font::getGlyph(unsigned int id)
 
 	glyph.texture = tex;
 	glyph.texPos = Vector2f(cursor.x() / (float)tex->textureSize.x(), cursor.y() / (float)tex->textureSize.y());
-	glyph.texSize = Vector2f(glyphSize.x() / (float)tex->textureSize.x(), glyphSize.y() / (float)tex->textureSize.y());
+	glyph.texSize = Vector2f(paddedSize.x() / (float)tex->textureSize.x(), paddedSize.y() / (float)tex->textureSize.y());
 
-	glyph.advance = Vector2f((float)g->metrics.horiAdvance / 64.0f, (float)g->metrics.vertAdvance / 64.0f);
-	glyph.bearing = Vector2f((float)g->metrics.horiBearingX / 64.0f, (float)g->metrics.horiBearingY / 64.0f);
+	glyph.size = Vector2f((float)paddedSize.x(), (float)paddedSize.y());
+	glyph.padding = (float)padding;
+
+	glyph.advance = advance;
+	glyph.bearing = bearing;
 
 	// upload glyph bitmap to texture
-	Renderer::updateTexture(tex->textureId, Renderer::Texture::ALPHA, cursor.x(), cursor.y(), glyphSize.x(), glyphSize.y(), g->bitmap.buffer);
+	if(g != NULL)
+		uploadGlyph(tex, cursor, g);
+	else
+	{
+		Renderer::updateTexture(tex->textureId, tex->type, cursor.x(), cursor.y(), paddedSize.x(), paddedSize.y(), cached->second.data.data());
+		mGlyphCache.erase(cached);
+	}
 
 	// update max glyph height
 	if(glyphSize.y() > mMaxGlyphHeight)
@@ -379,14 +868,15 @@ Font::Glyph* Font::getGlyph(unsigned int id)
 // completely recreate the texture data for all textures based on mGlyphs information
 void Font::rebuildTextures()
 {
-	// recreate OpenGL textures
-	for(auto it = mTextures.begin(); it != mTextures.end(); it++)
+	// recreate OpenGL textures, the first font to be reloaded does it for everyone using the page
+	for(auto it = mGlyphMap.cbegin(); it != mGlyphMap.cend(); it++)
 	{
-		it->initTexture();
+		if(it->second.texture->textureId == 0)
+			it->second.texture->initTexture();
 	}
 
-	// reupload the texture data
-	for(auto it = mGlyphMap.cbegin(); it != mGlyphMap.cend(); it++)
+	// reupload the texture data, the source font does it for scaled glyphs
+	for(auto it = mGlyphMap.cbegin(); (it != mGlyphMap.cend()) && !mSource; it++)
 	{
 		FT_Face face = getFaceForChar(it->first);
 		FT_GlyphSlot glyphSlot = face->glyph;
@@ -396,12 +886,11 @@ void Font::rebuildTextures()
 
 		FontTexture* tex = it->second.texture;
 
-		// find the position/size
-		Vector2i cursor((int)(it->second.texPos.x() * tex->textureSize.x()), (int)(it->second.texPos.y() * tex->textureSize.y()));
-		Vector2i glyphSize((int)(it->second.texSize.x() * tex->textureSize.x()), (int)(it->second.texSize.y() * tex->textureSize.y()));
+		// find the position
+		Vector2i cursor((int)(it->second.texPos.x() * tex->textureSize.x() + 0.5f), (int)(it->second.texPos.y() * tex->textureSize.y() + 0.5f));
 
 		// upload to texture
-		Renderer::updateTexture(tex->textureId, Renderer::Texture::ALPHA, cursor.x(), cursor.y(), glyphSize.x(), glyphSize.y(), glyphSlot->bitmap.buffer);
+		uploadGlyph(tex, cursor, glyphSlot);
 	}
 }
 
@@ -490,7 +979,7 @@ float Font::getLetterHeight()
 {
 	Glyph* glyph = getGlyph('S');
 	assert(glyph);
-	return glyph->texSize.y() * glyph->texture->textureSize.y();
+	return glyph->size.y() - (glyph->padding * 2);
 }
 
 
@@ -507,6 +996,31 @@ bool Font::isWhiteSpace(unsigned int c)
 
 // Breaks up a normal string with newlines to make it fit width (in pixels)
 std::string Font::wrapText(std::string text, float maxWidth)
+{
+	std::string key = text;
+	key.append((const char*)&maxWidth, sizeof(maxWidth));
+
+	auto found = mWrappedTextLookup.find(key);
+	if(found != mWrappedTextLookup.cend())
+	{
+		mWrappedTexts.splice(mWrappedTexts.begin(), mWrappedTexts, found->second);
+		return found->second->text;
+	}
+
+	const WrappedText wrapped = { key, wrapTextUncached(text, maxWidth) };
+	mWrappedTexts.push_front(wrapped);
+	mWrappedTextLookup[key] = mWrappedTexts.begin();
+
+	if(mWrappedTexts.size() > MAX_WRAPPED_TEXTS)
+	{
+		mWrappedTextLookup.erase(mWrappedTexts.back().key);
+		mWrappedTexts.pop_back();
+	}
+
+	return wrapped.text;
+}
+
+std::string Font::wrapTextUncached(std::string text, float maxWidth)
 {
 	std::string out = "";
 
@@ -626,6 +1140,49 @@ float Font::getNewlineStartOffset(const std::string& text, const unsigned int& c
 }
 
 TextCache* Font::buildTextCache(const std::string& text, Vector2f offset, unsigned int color, float xLen, Alignment alignment, float lineSpacing)
+{
+	std::string key = text;
+	key.append((const char*)&offset, sizeof(offset));
+	key.append((const char*)&xLen, sizeof(xLen));
+	key.append((const char*)&alignment, sizeof(alignment));
+	key.append((const char*)&lineSpacing, sizeof(lineSpacing));
+
+	auto found = mTextLayoutLookup.find(key);
+	if(found != mTextLayoutLookup.cend())
+	{
+		mTextLayouts.splice(mTextLayouts.begin(), mTextLayouts, found->second);
+
+		TextCache* cache = new TextCache(*found->second->cache);
+		cache->setColor(color);
+		return cache;
+	}
+
+	TextCache* cache = layoutText(text, offset, color, xLen, alignment, lineSpacing);
+	size_t vertices = 0;
+
+	for(auto it = cache->vertexLists.cbegin(); it != cache->vertexLists.cend(); it++)
+		vertices += it->verts.size();
+
+	// a single text larger than the whole cache would only push out everything else
+	if(vertices > MAX_TEXT_LAYOUT_VERTICES)
+		return cache;
+
+	const TextLayout layout = { key, std::shared_ptr<TextCache>(new TextCache(*cache)), vertices };
+	mTextLayouts.push_front(layout);
+	mTextLayoutLookup[key] = mTextLayouts.begin();
+	mTextLayoutVertices += vertices;
+
+	while((mTextLayouts.size() > MAX_TEXT_LAYOUTS) || (mTextLayoutVertices > MAX_TEXT_LAYOUT_VERTICES))
+	{
+		mTextLayoutVertices -= mTextLayouts.back().vertices;
+		mTextLayoutLookup.erase(mTextLayouts.back().key);
+		mTextLayouts.pop_back();
+	}
+
+	return cache;
+}
+
+TextCache* Font::layoutText(const std::string& text, Vector2f offset, unsigned int color, float xLen, Alignment alignment, float lineSpacing)
 {
 	float x = offset[0] + (xLen != 0 ? getNewlineStartOffset(text, 0, xLen, alignment) : 0);
 
@@ -663,13 +1220,13 @@ TextCache* Font::buildTextCache(const std::string& text, Vector2f offset, unsign
 		Renderer::Vertex* vertices = verts.data() + oldVertSize;
 
 		const float        glyphStartX    = x + glyph->bearing.x();
-		const Vector2i&    textureSize    = glyph->texture->textureSize;
+		const Vector2f&    glyphSize      = glyph->size;
 		const unsigned int convertedColor = Renderer::convertColor(color);
 
-		vertices[1] = { { glyphStartX                                       , y - glyph->bearing.y()                                          }, { glyph->texPos.x(),                      glyph->texPos.y()                      }, convertedColor };
-		vertices[2] = { { glyphStartX                                       , y - glyph->bearing.y() + (glyph->texSize.y() * textureSize.y()) }, { glyph->texPos.x(),                      glyph->texPos.y() + glyph->texSize.y() }, convertedColor };
-		vertices[3] = { { glyphStartX + glyph->texSize.x() * textureSize.x(), y - glyph->bearing.y()                                          }, { glyph->texPos.x() + glyph->texSize.x(), glyph->texPos.y()                      }, convertedColor };
-		vertices[4] = { { glyphStartX + glyph->texSize.x() * textureSize.x(), y - glyph->bearing.y() + (glyph->texSize.y() * textureSize.y()) }, { glyph->texPos.x() + glyph->texSize.x(), glyph->texPos.y() + glyph->texSize.y() }, convertedColor };
+		vertices[1] = { { glyphStartX                , y - glyph->bearing.y()                 }, { glyph->texPos.x(),                      glyph->texPos.y()                      }, convertedColor };
+		vertices[2] = { { glyphStartX                , y - glyph->bearing.y() + glyphSize.y() }, { glyph->texPos.x(),                      glyph->texPos.y() + glyph->texSize.y() }, convertedColor };
+		vertices[3] = { { glyphStartX + glyphSize.x(), y - glyph->bearing.y()                 }, { glyph->texPos.x() + glyph->texSize.x(), glyph->texPos.y()                      }, convertedColor };
+		vertices[4] = { { glyphStartX + glyphSize.x(), y - glyph->bearing.y() + glyphSize.y() }, { glyph->texPos.x() + glyph->texSize.x(), glyph->texPos.y() + glyph->texSize.y() }, convertedColor };
 
 		// round vertices
 		for(int i = 1; i < 5; ++i)
@@ -698,6 +1255,7 @@ TextCache* Font::buildTextCache(const std::string& text, Vector2f offset, unsign
 		vertList.verts = it->second;
 	}
 
+	cache->countVertices();
 	clearFaceCache();
 
 	return cache;
@@ -708,6 +1266,31 @@ TextCache* Font::buildTextCache(const std::string& text, float offsetX, float of
 	return buildTextCache(text, Vector2f(offsetX, offsetY), color, 0.0f);
 }
 
+TextCache::TextCache() : countedBytes(0)
+{
+}
+
+TextCache::TextCache(const TextCache& other) : vertexLists(other.vertexLists), metrics(other.metrics), countedBytes(0)
+{
+	countVertices();
+}
+
+TextCache::~TextCache()
+{
+	MemoryUsage::remove(MemoryUsage::TEXT_CACHES, countedBytes);
+}
+
+void TextCache::countVertices()
+{
+	MemoryUsage::remove(MemoryUsage::TEXT_CACHES, countedBytes);
+
+	countedBytes = vertexLists.capacity() * sizeof(VertexList);
+	for(auto it = vertexLists.cbegin(); it != vertexLists.cend(); it++)
+		countedBytes += it->verts.capacity() * sizeof(Renderer::Vertex);
+
+	MemoryUsage::add(MemoryUsage::TEXT_CACHES, countedBytes);
+}
+
 void TextCache::setColor(unsigned int color)
 {
 	const unsigned int convertedColor = Renderer::convertColor(color);
@@ -9,6 +9,8 @@
 #include "ThemeData.h"
 #include <ft2build.h>
 #include FT_FREETYPE_H
+#include <list>
+#include <memory>
 #include <vector>
 
 class TextCache;
@@ -66,28 +68,54 @@ public:
 
 	size_t getMemUsage() const; // returns an approximation of VRAM used by this font's texture (in bytes)
 	static size_t getTotalMemUsage(); // returns an approximation of total VRAM used by font textures (in bytes)
+	static float getAtlasUsage(size_t& pages); // returns how much of the glyph pages is filled below their skyline, from 0 to 1
+
+	static void saveGlyphCaches(); // writes the glyphs of fonts that had to rasterize any to disk, so they load without FreeType next time
+	static void releaseTextCaches(); // forgets the text laid out and wrapped by all fonts, it's laid out again when it's shown
 
 private:
 	static FT_Library sLibrary;
 	static std::map< std::pair<std::string, int>, std::weak_ptr<Font> > sFontMap;
+	static std::map< std::string, std::weak_ptr<Font> > sDistanceFieldMap;
+
+	// With "FontDistanceField" all sizes of a typeface scale the glyphs of one font that keeps them as distance fields,
+	// rendered once at DISTANCE_FIELD_SIZE with DISTANCE_FIELD_SPREAD pixels around them for the distance to fade out
+	static const int DISTANCE_FIELD_SIZE = 64;
+	static const int DISTANCE_FIELD_SPREAD = 8;
 
-	Font(int size, const std::string& path);
+	Font(int size, const std::string& path, bool distanceField, const std::shared_ptr<Font>& source);
 
+	static std::shared_ptr<Font> getDistanceField(const std::string& path);
+
+	// A page of glyphs, shared by all fonts. Glyphs are packed bottom-left along a skyline of the
+	// tops of the glyphs placed so far, so glyphs of any size fill the page without wasted rows
 	struct FontTexture
 	{
+		struct SkylineNode
+		{
+			int x;
+			int y;
+			int width;
+		};
+
 		unsigned int textureId;
 		Vector2i textureSize;
+		Renderer::Texture::Type type; // ALPHA or DISTANCE_FIELD, glyphs of both never share a page
 
-		Vector2i writePos;
-		int rowHeight;
+		std::vector<SkylineNode> skyline;
+		int glyphCount; // glyphs of live fonts on this page, the page is cleared once it reaches 0
 
-		FontTexture();
+		FontTexture(Renderer::Texture::Type type);
 		~FontTexture();
 		bool findEmpty(const Vector2i& size, Vector2i& cursor_out);
+		void reset(); // forgets all glyphs on the page, they must not be in use anymore
 
 		// you must call initTexture() after creating a FontTexture to get a textureId
 		void initTexture(); // initializes the OpenGL texture according to this FontTexture's settings, updating textureId
 		void deinitTexture(); // deinitializes the OpenGL texture if any exists, is automatically called in the destructor
+
+	private:
+		bool fits(size_t index, const Vector2i& size, int& y_out) const;
 	};
 
 	struct FontFace
@@ -101,10 +129,14 @@ private:
 
 	void rebuildTextures();
 	void unloadTextures();
+	void releaseGlyphs();
 
-	std::vector<FontTexture> mTextures;
+	static std::vector< std::unique_ptr<FontTexture> > sTextures; // pointers, so glyphs and text caches can keep them
+	static int sLoadedFonts; // the pages keep their textures as long as any font is loaded
 
-	void getTextureForNewGlyph(const Vector2i& glyphSize, FontTexture*& tex_out, Vector2i& cursor_out);
+	static void getTextureForNewGlyph(Renderer::Texture::Type type, const Vector2i& glyphSize, FontTexture*& tex_out, Vector2i& cursor_out);
+	void uploadGlyph(FontTexture* tex, const Vector2i& cursor, FT_GlyphSlot glyphSlot);
+	std::vector<unsigned char> renderGlyph(FT_GlyphSlot glyphSlot, Vector2i& size_out) const; // what goes on the page, a distance field if this font keeps them
 
 	std::map< unsigned int, std::unique_ptr<FontFace> > mFaceCache;
 	FT_Face getFaceForChar(unsigned int id);
@@ -117,6 +149,9 @@ private:
 		Vector2f texPos;
 		Vector2f texSize; // in texels!
 
+		Vector2f size; // on screen, in pixels
+		float padding; // the distance field around the glyph on each side, in pixels on screen
+
 		Vector2f advance;
 		Vector2f bearing;
 	};
@@ -125,15 +160,64 @@ private:
 
 	Glyph* getGlyph(unsigned int id);
 
+	// Glyphs as they went on the page last time, kept in ~/.emulationstation/glyph_cache while the font file stays the same.
+	// The ones used this session are written first, at most MAX_CACHED_GLYPHS
+	struct CachedGlyph
+	{
+		Vector2i size;
+		Vector2f advance;
+		Vector2f bearing;
+		std::vector<unsigned char> data;
+	};
+
+	static const size_t MAX_CACHED_GLYPHS = 1024;
+
+	std::map<unsigned int, CachedGlyph> mGlyphCache; // loaded, but not used yet
+	bool mGlyphCacheDirty; // a glyph had to be rasterized
+
+	void loadGlyphCache();
+	void saveGlyphCache();
+	std::string getGlyphCachePath() const;
+
 	bool isWhiteSpace(unsigned int c);
 
 	int mMaxGlyphHeight;
 
 	const int mSize;
 	const std::string mPath;
+	const bool mDistanceField; // renders its glyphs into distance fields
+	std::shared_ptr<Font> mSource; // the distance field font this font's glyphs are scaled from, if any
 
 	float getNewlineStartOffset(const std::string& text, const unsigned int& charStart, const float& xLen, const Alignment& alignment);
 
+	TextCache* layoutText(const std::string& text, Vector2f offset, unsigned int color, float xLen, Alignment alignment, float lineSpacing);
+	std::string wrapTextUncached(std::string text, float xLen);
+
+	// Recently laid out and wrapped text, so list rows and descriptions shown again aren't laid out again.
+	// The layouts are kept without their color, a cached one is copied and colored for each caller
+	struct TextLayout
+	{
+		std::string key;
+		std::shared_ptr<TextCache> cache;
+		size_t vertices;
+	};
+
+	struct WrappedText
+	{
+		std::string key;
+		std::string text;
+	};
+
+	static const size_t MAX_TEXT_LAYOUTS = 256;
+	static const size_t MAX_TEXT_LAYOUT_VERTICES = 65536;
+	static const size_t MAX_WRAPPED_TEXTS = 64;
+
+	std::list<TextLayout> mTextLayouts; // most recently used first
+	std::map<std::string, std::list<TextLayout>::iterator> mTextLayoutLookup;
+	size_t mTextLayoutVertices;
+	std::list<WrappedText> mWrappedTexts;
+	std::map<std::string, std::list<WrappedText>::iterator> mWrappedTextLookup;
+
 	bool mLoaded;
 
 	friend TextCache;
@@ -155,15 +239,26 @@ protected:
 
 	std::vector<VertexList> vertexLists;
 
+	// counts the vertices in MemoryUsage::TEXT_CACHES once they're in vertexLists
+	void countVertices();
+
 public:
 	struct CacheMetrics
 	{
 		Vector2f size;
 	} metrics;
 
+	TextCache();
+	TextCache(const TextCache& other);
+	~TextCache();
+	TextCache& operator=(const TextCache&) = delete;
+
 	void setColor(unsigned int color);
 
 	friend Font;
+
+private:
+	size_t countedBytes;
 };
 
 #endif // ES_CORE_RESOURCES_FONT_H
@@ -0,0 +1,95 @@
+#include "resources/PixelBufferPool.h"
+
+#include <iterator>
+#include <list>
+#include <mutex>
+
+// most recently pooled first
+static std::list<std::vector<unsigned char>> sBuffers;
+static size_t                                sPooledSize = 0;
+static std::mutex                            sMutex;
+
+// Sizes are split into four classes per power of two, the class of a buffer is the largest one it holds
+static size_t getClassSize(size_t size, bool roundUp)
+{
+	size_t octave = 1;
+	while ((octave << 1) <= size)
+		octave <<= 1;
+
+	const size_t step = octave / 4;
+	return roundUp ? (((size + step - 1) / step) * step) : ((size / step) * step);
+}
+
+void PixelBufferPool::acquire(std::vector<unsigned char>& buffer, size_t size)
+{
+	if ((buffer.capacity() >= size) || (size < MIN_SIZE))
+	{
+		buffer.resize(size);
+		return;
+	}
+
+	release(buffer);
+
+	const size_t classSize = getClassSize(size, true);
+	{
+		std::unique_lock<std::mutex> lock(sMutex);
+		for (auto it = sBuffers.begin(); it != sBuffers.end(); ++it)
+		{
+			if (getClassSize(it->capacity(), false) == classSize)
+			{
+				sPooledSize -= it->capacity();
+				buffer.swap(*it);
+				sBuffers.erase(it);
+				break;
+			}
+		}
+	}
+
+	// allocated at the full class size, so it fits every image of the class once it's pooled
+	if (buffer.capacity() < size)
+		buffer.reserve(classSize);
+
+	buffer.resize(size);
+}
+
+void PixelBufferPool::release(std::vector<unsigned char>& buffer)
+{
+	std::vector<unsigned char> pooled;
+	pooled.swap(buffer);
+
+	if ((pooled.capacity() < MIN_SIZE) || (pooled.capacity() > MAX_POOLED_SIZE))
+		return;
+
+	pooled.clear();
+
+	// the freed buffers are destroyed once the lock is gone
+	std::list<std::vector<unsigned char>> freed;
+	{
+		std::unique_lock<std::mutex> lock(sMutex);
+		sPooledSize += pooled.capacity();
+		sBuffers.push_front(std::vector<unsigned char>());
+		sBuffers.front().swap(pooled);
+
+		while (sPooledSize > MAX_POOLED_SIZE)
+		{
+			sPooledSize -= sBuffers.back().capacity();
+			freed.splice(freed.end(), sBuffers, std::prev(sBuffers.end()));
+		}
+	}
+}
+
+void PixelBufferPool::clear()
+{
+	std::list<std::vector<unsigned char>> freed;
+	{
+		std::unique_lock<std::mutex> lock(sMutex);
+		freed.swap(sBuffers);
+		sPooledSize = 0;
+	}
+}
+
+size_t PixelBufferPool::getPooledSize()
+{
+	std::unique_lock<std::mutex> lock(sMutex);
+	return sPooledSize;
+}
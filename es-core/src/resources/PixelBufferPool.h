@@ -0,0 +1,31 @@
+#pragma once
+#ifndef ES_CORE_RESOURCES_PIXEL_BUFFER_POOL_H
+#define ES_CORE_RESOURCES_PIXEL_BUFFER_POOL_H
+
+#include <stddef.h>
+#include <vector>
+
+// Keeps the buffers images are decoded, reduced and compressed into once a texture is done with them, so the next
+// image of about the same size takes one instead of allocating and freeing megabytes for every image scrolled past,
+// which fragments the heap of 32 bit systems quickly. Buffers are told apart by their size class, a quarter octave
+// wide, so a buffer is at most a quarter larger than the image in it. Shared by every loader thread
+class PixelBufferPool
+{
+public:
+	// Resizes buffer to size, taking a pooled buffer of the right class unless buffer already has the room
+	static void acquire(std::vector<unsigned char>& buffer, size_t size);
+
+	// Hands the memory of buffer to the pool and leaves it empty. The least recently pooled buffers are freed once
+	// the pool holds more than MAX_POOLED_SIZE, buffers smaller than MIN_SIZE are freed right away
+	static void release(std::vector<unsigned char>& buffer);
+
+	// Frees every pooled buffer
+	static void clear();
+
+	static size_t getPooledSize();
+
+	static const size_t MIN_SIZE        = 64 * 1024;
+	static const size_t MAX_POOLED_SIZE = 32 * 1024 * 1024;
+};
+
+#endif // ES_CORE_RESOURCES_PIXEL_BUFFER_POOL_H
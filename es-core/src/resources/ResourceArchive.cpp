@@ -0,0 +1,165 @@
+#include "resources/ResourceArchive.h"
+
+#include "utils/BinaryUtil.h"
+#include "utils/FileSystemUtil.h"
+#include "Log.h"
+#include <string.h>
+#include <fstream>
+
+static const char     ARCHIVE_MAGIC[4] = { 'E', 'S', 'P', 'K' };
+static const uint32_t ARCHIVE_VERSION  = 1;
+
+// magic, version and the size of the index that follows
+static const size_t HEADER_SIZE = sizeof(ARCHIVE_MAGIC) + sizeof(uint32_t) + sizeof(uint64_t);
+
+const char ResourceArchive::EXTENSION[] = ".espack";
+
+ResourceArchive::ResourceArchive(const std::string& path, const ResourceData& data, int64_t modifiedTime) : mPath(path), mData(data), mModifiedTime(modifiedTime)
+{
+}
+
+std::shared_ptr<ResourceArchive> ResourceArchive::open(const std::string& path, const ResourceData& data)
+{
+	const int64_t modifiedTime = (int64_t)Utils::FileSystem::getModifiedTime(path);
+	if(data.length < HEADER_SIZE)
+		return nullptr;
+
+	const unsigned char* bytes = data.ptr.get();
+	uint32_t version;
+	uint64_t indexSize;
+	memcpy(&version, bytes + sizeof(ARCHIVE_MAGIC), sizeof(version));
+	memcpy(&indexSize, bytes + sizeof(ARCHIVE_MAGIC) + sizeof(version), sizeof(indexSize));
+
+	if(memcmp(bytes, ARCHIVE_MAGIC, sizeof(ARCHIVE_MAGIC)) || (version != ARCHIVE_VERSION) || (indexSize > (data.length - HEADER_SIZE)))
+	{
+		LOG(LogWarning) << "\"" << path << "\" is not a resource archive";
+		return nullptr;
+	}
+
+	// only the index is copied, the files stay in the mapping
+	const std::string index((const char*)bytes + HEADER_SIZE, (size_t)indexSize);
+	Utils::Binary::Reader reader(index);
+	const uint64_t dataOffset = HEADER_SIZE + indexSize;
+	uint32_t count;
+
+	if(!reader.read(count))
+		return nullptr;
+
+	std::shared_ptr<ResourceArchive> archive(new ResourceArchive(path, data, modifiedTime));
+	archive->mEntries.reserve(count);
+
+	for(uint32_t i = 0; i < count; i++)
+	{
+		std::string name;
+		Entry entry;
+		if(!reader.readString(name) || !reader.read(entry.offset) || !reader.read(entry.size) ||
+			(entry.offset > (data.length - dataOffset)) || (entry.size > (data.length - dataOffset - entry.offset)))
+		{
+			LOG(LogWarning) << "Resource archive \"" << path << "\" is truncated";
+			return nullptr;
+		}
+
+		entry.offset += dataOffset;
+		archive->mEntries[name] = entry;
+	}
+
+	LOG(LogInfo) << "Opened resource archive \"" << path << "\" with " << count << " files";
+
+	return archive;
+}
+
+bool ResourceArchive::create(const std::string& directory, const std::string& path)
+{
+	const std::string root = Utils::FileSystem::getGenericPath(directory);
+	const std::string archivePath = Utils::FileSystem::getGenericPath(Utils::FileSystem::getAbsolutePath(path));
+
+	if(!Utils::FileSystem::isDirectory(root))
+	{
+		LOG(LogError) << "Can't pack \"" << directory << "\", it is not a directory";
+		return false;
+	}
+
+	std::vector<std::string> files;
+	Utils::Binary::Writer index;
+	uint64_t offset = 0;
+
+	const Utils::FileSystem::stringList content = Utils::FileSystem::getDirContent(root, true);
+	for(auto it = content.cbegin(); it != content.cend(); ++it)
+	{
+		if(!Utils::FileSystem::isRegularFile(*it) || (Utils::FileSystem::getAbsolutePath(*it) == archivePath))
+			continue;
+
+		files.push_back(*it);
+	}
+
+	index.write((uint32_t)files.size());
+	for(auto it = files.cbegin(); it != files.cend(); ++it)
+	{
+		const uint64_t size = (uint64_t)Utils::FileSystem::getFileSize(*it);
+
+		index.writeString(it->substr(root.size() + 1));
+		index.write(offset);
+		index.write(size);
+		offset += size;
+	}
+
+	std::ofstream stream(archivePath.c_str(), std::ios::out | std::ios::binary | std::ios::trunc);
+	if(!stream.is_open())
+	{
+		LOG(LogError) << "Can't write resource archive \"" << path << "\"";
+		return false;
+	}
+
+	const uint64_t indexSize = index.getBuffer().size();
+	stream.write(ARCHIVE_MAGIC, sizeof(ARCHIVE_MAGIC));
+	stream.write((const char*)&ARCHIVE_VERSION, sizeof(ARCHIVE_VERSION));
+	stream.write((const char*)&indexSize, sizeof(indexSize));
+	stream.write(index.getBuffer().data(), indexSize);
+
+	// the offsets in the index hold as long as nothing below directory changes while it's packed
+	for(auto it = files.cbegin(); it != files.cend(); ++it)
+	{
+		std::ifstream file(it->c_str(), std::ios::in | std::ios::binary);
+		stream << file.rdbuf();
+	}
+
+	stream.close();
+	if(stream.fail())
+	{
+		LOG(LogError) << "Can't write resource archive \"" << path << "\"";
+		return false;
+	}
+
+	LOG(LogInfo) << "Packed " << files.size() << " files of \"" << directory << "\" into \"" << path << "\"";
+
+	return true;
+}
+
+bool ResourceArchive::contains(const std::string& name) const
+{
+	return (mEntries.find(name) != mEntries.cend());
+}
+
+const ResourceData ResourceArchive::getFileData(const std::string& name) const
+{
+	auto it = mEntries.find(name);
+	if(it == mEntries.cend())
+	{
+		ResourceData data = {NULL, 0};
+		return data;
+	}
+
+	// shares the ownership of the whole archive, only points at the entry
+	ResourceData data = {std::shared_ptr<unsigned char>(mData.ptr, mData.ptr.get() + it->second.offset), (size_t)it->second.size};
+	return data;
+}
+
+bool ResourceArchive::getFileSize(const std::string& name, int64_t& size) const
+{
+	auto it = mEntries.find(name);
+	if(it == mEntries.cend())
+		return false;
+
+	size = (int64_t)it->second.size;
+	return true;
+}
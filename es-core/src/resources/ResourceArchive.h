@@ -0,0 +1,49 @@
+#pragma once
+#ifndef ES_CORE_RESOURCES_RESOURCE_ARCHIVE_H
+#define ES_CORE_RESOURCES_RESOURCE_ARCHIVE_H
+
+#include "resources/ResourceManager.h"
+#include <stdint.h>
+#include <string>
+#include <unordered_map>
+
+// A whole directory packed into one file, an index of the relative paths followed by the files themselves, stored
+// as they are. ResourceManager maps the archive instead of reading it, the data of an entry points straight into
+// the mapping and keeps it alive. Opened archives are not changed anymore, so they are safe
+// to read from any thread.
+class ResourceArchive
+{
+public:
+	// The archive in data, the whole file at path. nullptr when it's not an archive
+	static std::shared_ptr<ResourceArchive> open(const std::string& path, const ResourceData& data);
+
+	// Packs every regular file below directory into the archive at path
+	static bool create(const std::string& directory, const std::string& path);
+
+	// name is relative to the packed directory, with forward slashes
+	bool contains(const std::string& name) const;
+	const ResourceData getFileData(const std::string& name) const; // an "empty" ResourceData if it isn't in the archive
+	bool getFileSize(const std::string& name, int64_t& size) const;
+
+	const std::string& getPath() const { return mPath; }
+	int64_t getModifiedTime() const { return mModifiedTime; }
+	int64_t getSize() const { return (int64_t)mData.length; }
+
+	static const char EXTENSION[];
+
+private:
+	struct Entry
+	{
+		uint64_t offset;
+		uint64_t size;
+	};
+
+	ResourceArchive(const std::string& path, const ResourceData& data, int64_t modifiedTime);
+
+	const std::string mPath;
+	const ResourceData mData;
+	const int64_t mModifiedTime; // what tells the archive apart from one written over it later
+	std::unordered_map<std::string, Entry> mEntries;
+};
+
+#endif // ES_CORE_RESOURCES_RESOURCE_ARCHIVE_H
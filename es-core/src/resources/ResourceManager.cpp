@@ -1,15 +1,57 @@
 #include "ResourceManager.h"
 
+#include "resources/ResourceArchive.h"
 #include "utils/FileSystemUtil.h"
+#include "Log.h"
+#include <algorithm>
 #include <fstream>
 
+#if defined(_WIN32)
+#include <Windows.h>
+#else // _WIN32
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#endif // _WIN32
+
+// files from this size on are mapped instead of read, below it a page per file costs more than the copy
+#define MAP_MIN_SIZE (64 * 1024)
+
 auto array_deleter = [](unsigned char* p) { delete[] p; };
 auto nop_deleter = [](unsigned char* /*p*/) { };
 
 std::shared_ptr<ResourceManager> ResourceManager::sInstance = nullptr;
+unsigned int ResourceManager::sFrame = 0;
+std::map<std::string, ResourceManager::MappedFile> ResourceManager::sMappedFiles;
+std::mutex ResourceManager::sMappedFilesMutex;
+
+void IReloadable::markUsed()
+{
+	mLastUsedFrame = ResourceManager::getFrame();
+}
+
+ResourceManager::ResourceManager() : mStopReload(false), mReloadDone(false)
+{
+	// the built-in resources may come packed, next to wherever the loose files would be looked for
+	const std::string paths[] =
+	{
+		Utils::FileSystem::getHomePath() + "/.emulationstation/resources",
+		Utils::FileSystem::getExePath() + "/resources",
+		Utils::FileSystem::getCWDPath() + "/resources"
+	};
 
-ResourceManager::ResourceManager()
+	for(const std::string& path : paths)
+	{
+		const std::string archivePath = path + ResourceArchive::EXTENSION;
+		if(Utils::FileSystem::exists(archivePath))
+			mountArchive(path, archivePath);
+	}
+}
+
+ResourceManager::~ResourceManager()
 {
+	stopReload();
 }
 
 std::shared_ptr<ResourceManager>& ResourceManager::getInstance()
@@ -27,19 +69,21 @@ std::string ResourceManager::getResourcePath(const std::string& path) const
 	{
 		std::string test;
 
+		std::string name;
+
 		// check in homepath
 		test = Utils::FileSystem::getHomePath() + "/.emulationstation/resources/" + &path[2];
-		if(Utils::FileSystem::exists(test))
+		if(findArchive(test, name) || Utils::FileSystem::exists(test))
 			return test;
 
 		// check in exepath
 		test = Utils::FileSystem::getExePath() + "/resources/" + &path[2];
-		if(Utils::FileSystem::exists(test))
+		if(findArchive(test, name) || Utils::FileSystem::exists(test))
 			return test;
 
 		// check in cwd
 		test = Utils::FileSystem::getCWDPath() + "/resources/" + &path[2];
-		if(Utils::FileSystem::exists(test))
+		if(findArchive(test, name) || Utils::FileSystem::exists(test))
 			return test;
 	}
 
@@ -52,6 +96,12 @@ const ResourceData ResourceManager::getFileData(const std::string& path) const
 	//check if its a resource
 	const std::string respath = getResourcePath(path);
 
+	// a packed file costs no open or stat of its own
+	std::string name;
+	std::shared_ptr<ResourceArchive> archive = findArchive(respath, name);
+	if(archive)
+		return archive->getFileData(name);
+
 	if(Utils::FileSystem::exists(respath))
 	{
 		ResourceData data = loadFile(respath);
@@ -65,6 +115,10 @@ const ResourceData ResourceManager::getFileData(const std::string& path) const
 
 ResourceData ResourceManager::loadFile(const std::string& path) const
 {
+	ResourceData mapped = mapFile(path);
+	if(mapped.ptr)
+		return mapped;
+
 	std::ifstream stream(path, std::ios::binary);
 
 	stream.seekg(0, stream.end);
@@ -86,17 +140,186 @@ ResourceData ResourceManager::loadFile(const std::string& path) const
 	return ret;
 }
 
+ResourceData ResourceManager::mapFile(const std::string& path) const
+{
+	// the pages are only read in when something touches them and every user of the file shares them, a font face
+	// that only ever looks up a few glyphs of a large CJK font keeps just those parts resident
+	ResourceData ret = {NULL, 0};
+
+#if defined(_WIN32)
+	const HANDLE file = CreateFileW(std::wstring(path.begin(), path.end()).c_str(), GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+	if(file == INVALID_HANDLE_VALUE)
+		return ret;
+
+	LARGE_INTEGER fileSize;
+	FILETIME      fileTime;
+	if(!GetFileSizeEx(file, &fileSize) || !GetFileTime(file, NULL, NULL, &fileTime) || (fileSize.QuadPart < MAP_MIN_SIZE) || ((unsigned long long)fileSize.QuadPart > (size_t)-1))
+	{
+		CloseHandle(file);
+		return ret;
+	}
+
+	const size_t    size  = (size_t)fileSize.QuadPart;
+	const long long mtime = ((long long)fileTime.dwHighDateTime << 32) | fileTime.dwLowDateTime;
+#else // _WIN32
+	const int file = open(path.c_str(), O_RDONLY);
+	if(file < 0)
+		return ret;
+
+	struct stat info;
+	if((fstat(file, &info) != 0) || !S_ISREG(info.st_mode) || (info.st_size < MAP_MIN_SIZE) || ((unsigned long long)info.st_size > (size_t)-1))
+	{
+		close(file);
+		return ret;
+	}
+
+	const size_t    size  = (size_t)info.st_size;
+	const long long mtime = (long long)info.st_mtime;
+#endif // _WIN32
+
+	std::unique_lock<std::mutex> lock(sMappedFilesMutex);
+
+	// another user still has the file mapped, share it if the file didn't change since
+	auto it = sMappedFiles.find(path);
+	if(it != sMappedFiles.end())
+	{
+		std::shared_ptr<unsigned char> data = it->second.data.lock();
+		if(data && (it->second.length == size) && (it->second.mtime == mtime))
+		{
+#if defined(_WIN32)
+			CloseHandle(file);
+#else // _WIN32
+			close(file);
+#endif // _WIN32
+			ResourceData shared = { data, size };
+			return shared;
+		}
+	}
+
+	std::shared_ptr<unsigned char> data;
+
+#if defined(_WIN32)
+	const HANDLE mapping = CreateFileMappingW(file, NULL, PAGE_READONLY, 0, 0, NULL);
+	void*        view    = mapping ? MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0) : NULL;
+
+	// the view keeps the file open on its own
+	if(mapping)
+		CloseHandle(mapping);
+	CloseHandle(file);
+
+	if(view)
+		data = std::shared_ptr<unsigned char>((unsigned char*)view, [](unsigned char* p) { UnmapViewOfFile(p); });
+#else // _WIN32
+	void* view = mmap(NULL, size, PROT_READ, MAP_PRIVATE, file, 0);
+
+	// the mapping keeps the file open on its own
+	close(file);
+
+	if(view != MAP_FAILED)
+		data = std::shared_ptr<unsigned char>((unsigned char*)view, [size](unsigned char* p) { munmap(p, size); });
+	else
+		view = NULL;
+#endif // _WIN32
+
+	if(!view)
+		return ret; // let the caller read it instead
+
+	// the entry of a file that's not mapped anymore is just replaced the next time it's mapped
+	sMappedFiles[path] = { data, size, mtime };
+
+	ResourceData mappedData = { data, size };
+	return mappedData;
+}
+
 bool ResourceManager::fileExists(const std::string& path) const
 {
 	//if it exists as a resource file, return true
 	if(getResourcePath(path) != path)
 		return true;
 
+	std::string name;
+	if(findArchive(path, name))
+		return true;
+
 	return Utils::FileSystem::exists(path);
 }
 
+void ResourceManager::getFileStats(const std::string& path, int64_t& size, int64_t& modifiedTime) const
+{
+	const std::string respath = getResourcePath(path);
+
+	std::string name;
+	std::shared_ptr<ResourceArchive> archive = findArchive(respath, name);
+	if(archive && archive->getFileSize(name, size))
+	{
+		modifiedTime = archive->getModifiedTime();
+		return;
+	}
+
+	size = Utils::FileSystem::getFileSize(respath);
+	modifiedTime = (int64_t)Utils::FileSystem::getModifiedTime(respath);
+}
+
+bool ResourceManager::mountArchive(const std::string& directory, const std::string& archivePath)
+{
+	const std::string mountPath = Utils::FileSystem::getGenericPath(directory) + "/";
+	const int64_t size = Utils::FileSystem::getFileSize(archivePath);
+	const int64_t modifiedTime = (int64_t)Utils::FileSystem::getModifiedTime(archivePath);
+
+	{
+		std::unique_lock<std::mutex> lock(mMountsMutex);
+		for(auto it = mMounts.cbegin(); it != mMounts.cend(); ++it)
+		{
+			if((it->directory == mountPath) && (it->archive->getPath() == archivePath) &&
+				(it->archive->getSize() == size) && (it->archive->getModifiedTime() == modifiedTime))
+				return true;
+		}
+	}
+
+	// opened outside of the lock, the index of a large archive takes a moment
+	std::shared_ptr<ResourceArchive> archive = ResourceArchive::open(archivePath, loadFile(archivePath));
+	if(!archive)
+		return false;
+
+	std::unique_lock<std::mutex> lock(mMountsMutex);
+	for(auto it = mMounts.begin(); it != mMounts.end(); ++it)
+	{
+		if(it->directory == mountPath)
+		{
+			it->archive = archive;
+			return true;
+		}
+	}
+
+	mMounts.push_back({ mountPath, archive });
+	return true;
+}
+
+std::shared_ptr<ResourceArchive> ResourceManager::findArchive(const std::string& path, std::string& name) const
+{
+	std::unique_lock<std::mutex> lock(mMountsMutex);
+	if(mMounts.empty())
+		return nullptr;
+
+	const std::string genericPath = Utils::FileSystem::getGenericPath(path);
+	for(auto it = mMounts.cbegin(); it != mMounts.cend(); ++it)
+	{
+		if(genericPath.compare(0, it->directory.size(), it->directory) != 0)
+			continue;
+
+		name = genericPath.substr(it->directory.size());
+		if(it->archive->contains(name))
+			return it->archive;
+	}
+
+	return nullptr;
+}
+
 void ResourceManager::unloadAll()
 {
+	// whatever the background thread didn't get to yet stays marked for the next reload
+	stopReload();
+
 	auto iter = mReloadables.cbegin();
 	while(iter != mReloadables.cend())
 	{
@@ -104,7 +327,9 @@ void ResourceManager::unloadAll()
 
 		if (!info->data.expired())
 		{
-			info->reload = info->data.lock()->unload();
+			const bool unloaded = info->data.lock()->unload();
+			info->reload = info->reload || unloaded;
+			info->lastUsed = (info->data.lock()->getLastUsedFrame() >= sFrame);
 			iter++;
 		}
 		else
@@ -114,17 +339,29 @@ void ResourceManager::unloadAll()
 
 void ResourceManager::reloadAll()
 {
+	stopReload();
+
+	// what the current view showed comes back before the first frame, most of the textures of the other views
+	// decode on the background thread while the first frames are drawn and are uploaded once they're drawn
+	std::vector<std::shared_ptr<ReloadableInfo>> later;
+
 	auto iter = mReloadables.cbegin();
 	while(iter != mReloadables.cend())
 	{
 		std::shared_ptr<ReloadableInfo> info = *iter;
+		std::shared_ptr<IReloadable> data = info->data.lock();
 
-		if (!info->data.expired())
+		if (data)
 		{
 			if (info->reload)
 			{
-				info->data.lock()->reload();
-				info->reload = false;
+				if (info->lastUsed || !data->canReloadInBackground())
+				{
+					data->reload();
+					info->reload = false;
+				}
+				else
+					later.push_back(info);
 			}
 
 			iter++;
@@ -132,6 +369,57 @@ void ResourceManager::reloadAll()
 		else
 			iter = mReloadables.erase(iter);
 	}
+
+	if(later.empty())
+		return;
+
+	std::stable_sort(later.begin(), later.end(), [](const std::shared_ptr<ReloadableInfo>& a, const std::shared_ptr<ReloadableInfo>& b)
+	{
+		std::shared_ptr<IReloadable> dataA = a->data.lock();
+		std::shared_ptr<IReloadable> dataB = b->data.lock();
+		return (dataA ? dataA->getLastUsedFrame() : 0) > (dataB ? dataB->getLastUsedFrame() : 0);
+	});
+
+	LOG(LogDebug) << "Reloading " << later.size() << " resources in the background";
+
+	mBackgroundReloads.swap(later);
+	mStopReload = false;
+	mReloadDone = false;
+	mReloadThread = std::thread(&ResourceManager::reloadInBackground, this);
+}
+
+void ResourceManager::reloadInBackground()
+{
+	for(auto it = mBackgroundReloads.cbegin(); (it != mBackgroundReloads.cend()) && !mStopReload; it++)
+	{
+		// gone meanwhile, removed from the list on the next reload
+		std::shared_ptr<IReloadable> data = (*it)->data.lock();
+		if(data)
+		{
+			data->reload();
+			mBackgroundReloaded.push_back(data);
+		}
+
+		(*it)->reload = false;
+	}
+
+	mReloadDone = true;
+}
+
+void ResourceManager::stopReload()
+{
+	mStopReload = true;
+	if(mReloadThread.joinable())
+		mReloadThread.join();
+
+	mBackgroundReloads.clear();
+	mBackgroundReloaded.clear();
+}
+
+void ResourceManager::update()
+{
+	if(mReloadDone && mReloadThread.joinable())
+		stopReload();
 }
 
 void ResourceManager::addReloadable(std::weak_ptr<IReloadable> reloadable)
@@ -139,5 +427,6 @@ void ResourceManager::addReloadable(std::weak_ptr<IReloadable> reloadable)
 	std::shared_ptr<ReloadableInfo> info = std::make_shared<ReloadableInfo>();
 	info->data = reloadable;
 	info->reload = false;
+	info->lastUsed = false;
 	mReloadables.push_back(info);
 }
@@ -2,13 +2,21 @@
 #ifndef ES_CORE_RESOURCES_RESOURCE_MANAGER_H
 #define ES_CORE_RESOURCES_RESOURCE_MANAGER_H
 
+#include <atomic>
 #include <list>
+#include <map>
 #include <memory>
+#include <mutex>
+#include <stdint.h>
 #include <string>
+#include <thread>
+#include <vector>
 
 //The ResourceManager exists to...
 //Allow loading resources embedded into the executable like an actual file.
 //Allow embedded resources to be optionally remapped to actual files for further customization.
+//Large files are memory-mapped, read-only, and files loaded again while still in use share the same mapping.
+//Let a packed archive stand in for a whole directory, so a theme or the built-in resources load from one file.
 
 struct ResourceData
 {
@@ -16,13 +24,26 @@ struct ResourceData
 	const size_t length;
 };
 
+class ResourceArchive;
 class ResourceManager;
 
 class IReloadable
 {
 public:
+	IReloadable() : mLastUsedFrame(0) { }
+
 	virtual bool unload() = 0;
 	virtual void reload() = 0;
+
+	// reload() only needs the CPU and may run on the background thread of ResourceManager
+	virtual bool canReloadInBackground() const { return false; }
+
+	// call when drawn, what was drawn on the last frame before unloadAll() is reloaded first
+	void markUsed();
+	unsigned int getLastUsedFrame() const { return mLastUsedFrame; }
+
+private:
+	unsigned int mLastUsedFrame;
 };
 
 class ResourceManager
@@ -32,28 +53,80 @@ public:
 
 	void addReloadable(std::weak_ptr<IReloadable> reloadable);
 
-	void unloadAll();
-	void reloadAll();
+	~ResourceManager();
+
+	void unloadAll(); // stops what reloadAll() left for the background thread first
+	void reloadAll(); // what was drawn last and what can't reload in the background right away, the rest meanwhile later
+
+	// once a frame, picks up the background reload when it's done
+	void update();
+
+	// counts the frames for IReloadable::markUsed()
+	static void beginFrame() { ++sFrame; }
+	static unsigned int getFrame() { return sFrame; }
 
 	std::string getResourcePath(const std::string& path) const;
 	const ResourceData getFileData(const std::string& path) const;
 	bool fileExists(const std::string& path) const;
 
+	// what tells a changed file apart, for the caches keyed by a resource. A file in an archive has the time of the archive
+	void getFileStats(const std::string& path, int64_t& size, int64_t& modifiedTime) const;
+
+	// Serves the files below directory from the archive at archivePath, before looking on disk. Mounting an archive
+	// that is mounted already only checks if it changed. False if it can't be opened
+	bool mountArchive(const std::string& directory, const std::string& archivePath);
+
 private:
 	ResourceManager();
 
 	static std::shared_ptr<ResourceManager> sInstance;
 
 	ResourceData loadFile(const std::string& path) const;
+	ResourceData mapFile(const std::string& path) const; // an "empty" ResourceData if the file is small or can't be mapped
+
+	// the archive holding path, with name set to the path inside of it
+	std::shared_ptr<ResourceArchive> findArchive(const std::string& path, std::string& name) const;
+
+	struct Mount
+	{
+		std::string directory; // with a trailing slash
+		std::shared_ptr<ResourceArchive> archive;
+	};
+
+	std::vector<Mount> mMounts;
+	mutable std::mutex mMountsMutex; // themes are loaded on several threads at once
+
+	struct MappedFile
+	{
+		std::weak_ptr<unsigned char> data;
+		size_t length;
+		long long mtime; // with the length, tells if the file was replaced since it was mapped
+	};
+
+	static std::map<std::string, MappedFile> sMappedFiles;
+	static std::mutex sMappedFilesMutex;
 
 	class ReloadableInfo
 	{
 	public:
 		std::weak_ptr<IReloadable> data;
 		bool reload;
+		bool lastUsed; // drawn on the last frame before unloadAll()
 	};
 
 	std::list<std::shared_ptr<ReloadableInfo>> mReloadables; //  std::weak_ptr<IReloadable>
+
+	void reloadInBackground();
+	void stopReload();
+
+	// most recently drawn first
+	std::vector<std::shared_ptr<ReloadableInfo>> mBackgroundReloads;
+	std::vector<std::shared_ptr<IReloadable>> mBackgroundReloaded; // released on the main thread, they may hold textures
+	std::thread mReloadThread;
+	std::atomic<bool> mStopReload;
+	std::atomic<bool> mReloadDone;
+
+	static unsigned int sFrame;
 };
 
 #endif // ES_CORE_RESOURCES_RESOURCE_MANAGER_H
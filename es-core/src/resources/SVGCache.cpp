@@ -0,0 +1,266 @@
+#include "resources/SVGCache.h"
+
+#include "resources/ResourceManager.h"
+#include "utils/BinaryUtil.h"
+#include "utils/FileSystemUtil.h"
+#include "Log.h"
+#include "Settings.h"
+#include <nanosvg/nanosvg.h>
+#include <assert.h>
+#include <stdlib.h>
+#include <string.h>
+#include <functional>
+#include <iomanip>
+#include <list>
+#include <mutex>
+#include <sstream>
+#include <unordered_map>
+
+static const char     CACHE_MAGIC[4] = { 'E', 'S', 'S', 'V' };
+static const uint32_t CACHE_VERSION  = 1;
+
+#define DPI 96
+
+struct RasterEntry
+{
+	std::string     key;
+	int64_t         fileSize;
+	int64_t         fileTime;
+	SVGCache::Raster raster;
+};
+
+struct ParsedEntry
+{
+	std::string                path;
+	int64_t                    fileSize;
+	int64_t                    fileTime;
+	std::shared_ptr<NSVGimage> image;
+};
+
+// most recently used first
+static std::list<RasterEntry>                                             sRasters;
+static std::unordered_map<std::string, std::list<RasterEntry>::iterator> sRasterLookup;
+static size_t                                                             sRasterMemory = 0;
+static std::list<ParsedEntry>                                             sParsed;
+static std::mutex                                                         sMutex;
+
+// what tells a changed file apart, themes can be edited while ES runs
+static void getFileInfo(const std::string& path, int64_t& fileSize, int64_t& fileTime)
+{
+	ResourceManager::getInstance()->getFileStats(path, fileSize, fileTime);
+}
+
+static std::string getKey(const std::string& path, float sourceHeight)
+{
+	std::stringstream ss;
+	ss << path << "@" << sourceHeight;
+
+	return ss.str();
+}
+
+// expects sMutex to be locked
+static void keep(const std::string& key, int64_t fileSize, int64_t fileTime, const SVGCache::Raster& raster)
+{
+	auto it = sRasterLookup.find(key);
+	if (it != sRasterLookup.end())
+	{
+		sRasterMemory -= it->second->raster.dataRGBA->size();
+		sRasters.erase(it->second);
+		sRasterLookup.erase(it);
+	}
+
+	// a raster larger than all of it would only push everything else out
+	if (raster.dataRGBA->size() > SVGCache::MAX_MEMORY)
+		return;
+
+	sRasters.push_front({ key, fileSize, fileTime, raster });
+	sRasterLookup[key] = sRasters.begin();
+	sRasterMemory += raster.dataRGBA->size();
+
+	while (sRasterMemory > SVGCache::MAX_MEMORY)
+	{
+		sRasterMemory -= sRasters.back().raster.dataRGBA->size();
+		sRasterLookup.erase(sRasters.back().key);
+		sRasters.pop_back();
+	}
+}
+
+bool SVGCache::isEnabled()
+{
+	return Settings::getInstance()->getBool("CacheSVGs");
+}
+
+bool SVGCache::get(const std::string& path, float sourceHeight, Raster& raster)
+{
+	const std::string key = getKey(path, sourceHeight);
+	int64_t fileSize, fileTime;
+	getFileInfo(path, fileSize, fileTime);
+
+	{
+		std::unique_lock<std::mutex> lock(sMutex);
+		auto it = sRasterLookup.find(key);
+		if (it != sRasterLookup.end())
+		{
+			if ((it->second->fileSize == fileSize) && (it->second->fileTime == fileTime))
+			{
+				sRasters.splice(sRasters.begin(), sRasters, it->second);
+				raster = sRasters.front().raster;
+				return true;
+			}
+
+			sRasterMemory -= it->second->raster.dataRGBA->size();
+			sRasters.erase(it->second);
+			sRasterLookup.erase(it);
+		}
+	}
+
+	if (!isEnabled() || !loadCache(path, sourceHeight, fileSize, fileTime, raster))
+		return false;
+
+	std::unique_lock<std::mutex> lock(sMutex);
+	keep(key, fileSize, fileTime, raster);
+	return true;
+}
+
+void SVGCache::add(const std::string& path, float sourceHeight, const Raster& raster)
+{
+	int64_t fileSize, fileTime;
+	getFileInfo(path, fileSize, fileTime);
+
+	{
+		std::unique_lock<std::mutex> lock(sMutex);
+		keep(getKey(path, sourceHeight), fileSize, fileTime, raster);
+	}
+
+	if (isEnabled())
+		saveCache(path, sourceHeight, fileSize, fileTime, raster);
+}
+
+void SVGCache::clear()
+{
+	std::unique_lock<std::mutex> lock(sMutex);
+	sRasters.clear();
+	sRasterLookup.clear();
+	sRasterMemory = 0;
+	sParsed.clear();
+}
+
+std::shared_ptr<NSVGimage> SVGCache::parse(const std::string& path, const unsigned char* data, size_t length)
+{
+	int64_t fileSize, fileTime;
+	getFileInfo(path, fileSize, fileTime);
+
+	{
+		std::unique_lock<std::mutex> lock(sMutex);
+		for (auto it = sParsed.begin(); it != sParsed.end(); ++it)
+		{
+			if (it->path == path)
+			{
+				if ((it->fileSize == fileSize) && (it->fileTime == fileTime))
+				{
+					sParsed.splice(sParsed.begin(), sParsed, it);
+					return sParsed.front().image;
+				}
+
+				sParsed.erase(it);
+				break;
+			}
+		}
+	}
+
+	// nsvgParse excepts a modifiable, null-terminated string
+	char* copy = (char*)malloc(length + 1);
+	assert(copy != NULL);
+	memcpy(copy, data, length);
+	copy[length] = '\0';
+
+	NSVGimage* svgImage = nsvgParse(copy, "px", DPI);
+	free(copy);
+	if (!svgImage || (svgImage->width == 0) || (svgImage->height == 0))
+	{
+		if (svgImage)
+			nsvgDelete(svgImage);
+		return nullptr;
+	}
+
+	// rasterizing only reads the image, threads can share it
+	std::shared_ptr<NSVGimage> image(svgImage, nsvgDelete);
+
+	std::unique_lock<std::mutex> lock(sMutex);
+	sParsed.push_front({ path, fileSize, fileTime, image });
+	if (sParsed.size() > MAX_PARSED)
+		sParsed.pop_back();
+
+	return image;
+}
+
+bool SVGCache::loadCache(const std::string& path, float sourceHeight, int64_t fileSize, int64_t fileTime, Raster& raster)
+{
+	std::string buffer;
+
+	if (!Utils::Binary::loadFile(getCachePath(getKey(path, sourceHeight)), buffer))
+		return false;
+
+	Utils::Binary::Reader reader(buffer);
+	char magic[4];
+	uint32_t version;
+	std::string cachedPath;
+	float cachedHeight;
+	int64_t cachedSize;
+	int64_t cachedTime;
+	float rasterSourceWidth;
+	float rasterSourceHeight;
+	uint32_t rasterWidth;
+	uint32_t rasterHeight;
+
+	if (!reader.read(magic, sizeof(magic)) || memcmp(magic, CACHE_MAGIC, sizeof(magic)) ||
+		!reader.read(version) || (version != CACHE_VERSION) ||
+		!reader.readString(cachedPath) || !reader.read(cachedHeight) || !reader.read(cachedSize) || !reader.read(cachedTime) ||
+		!reader.read(rasterSourceWidth) || !reader.read(rasterSourceHeight) || !reader.read(rasterWidth) || !reader.read(rasterHeight))
+		return false;
+
+	// another SVG with the same hash or a changed one
+	if ((cachedPath != path) || (cachedHeight != sourceHeight) || (cachedSize != fileSize) || (cachedTime != fileTime) ||
+		(reader.getRemaining() != ((size_t)rasterWidth * rasterHeight * 4)))
+		return false;
+
+	std::shared_ptr<std::vector<unsigned char>> dataRGBA = std::make_shared<std::vector<unsigned char>>(reader.getRemaining());
+	reader.read(dataRGBA->data(), dataRGBA->size());
+
+	raster.sourceWidth = rasterSourceWidth;
+	raster.sourceHeight = rasterSourceHeight;
+	raster.width = rasterWidth;
+	raster.height = rasterHeight;
+	raster.dataRGBA = dataRGBA;
+
+	return true;
+}
+
+void SVGCache::saveCache(const std::string& path, float sourceHeight, int64_t fileSize, int64_t fileTime, const Raster& raster)
+{
+	Utils::Binary::Writer writer;
+
+	// kept as it's uploaded, SVGs have sharp edges and flat colors a JPEG would smear
+	writer.write(CACHE_MAGIC, sizeof(CACHE_MAGIC));
+	writer.write(CACHE_VERSION);
+	writer.writeString(path);
+	writer.write(sourceHeight);
+	writer.write(fileSize);
+	writer.write(fileTime);
+	writer.write(raster.sourceWidth);
+	writer.write(raster.sourceHeight);
+	writer.write((uint32_t)raster.width);
+	writer.write((uint32_t)raster.height);
+	writer.write(raster.dataRGBA->data(), raster.dataRGBA->size());
+
+	if (!Utils::Binary::saveFile(getCachePath(getKey(path, sourceHeight)), writer.getBuffer()))
+		LOG(LogWarning) << "Could not save raster of \"" << path << "\"";
+}
+
+std::string SVGCache::getCachePath(const std::string& key)
+{
+	std::stringstream ss;
+	ss << std::hex << std::setw(16) << std::setfill('0') << (uint64_t)std::hash<std::string>()(key);
+
+	return Utils::FileSystem::getHomePath() + "/.emulationstation/svg_cache/" + ss.str() + ".svgr";
+}
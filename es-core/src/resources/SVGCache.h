@@ -0,0 +1,51 @@
+#pragma once
+#ifndef ES_CORE_RESOURCES_SVG_CACHE_H
+#define ES_CORE_RESOURCES_SVG_CACHE_H
+
+#include <memory>
+#include <stddef.h>
+#include <stdint.h>
+#include <string>
+#include <vector>
+
+struct NSVGimage;
+
+// Keeps rasterized SVGs, so theme logos and help icons loaded again, for another view or after a game, skip nanosvg.
+// Rasters are kept in RAM up to MAX_MEMORY bytes and on disk next to the reduced images, keyed by the path and the
+// height they were rasterized at. Parsed SVGs are kept as well, for when the same file is rasterized at another size.
+// Safe to use from the texture loader threads.
+class SVGCache
+{
+public:
+	struct Raster
+	{
+		float                                             sourceWidth;
+		float                                             sourceHeight;
+		size_t                                            width;
+		size_t                                            height;
+		std::shared_ptr<const std::vector<unsigned char>> dataRGBA; // bottom row first, as it's uploaded
+	};
+
+	// Whether rasters are kept on disk too
+	static bool isEnabled();
+
+	// The raster of the SVG at path for sourceHeight, 0 for the height of the SVG itself. Searched in RAM, then on disk
+	static bool get(const std::string& path, float sourceHeight, Raster& raster);
+	static void add(const std::string& path, float sourceHeight, const Raster& raster);
+
+	// The SVG at path, parsed from data unless it was parsed before. nullptr when data isn't an SVG
+	static std::shared_ptr<NSVGimage> parse(const std::string& path, const unsigned char* data, size_t length);
+
+	// Forgets the rasters and parsed SVGs kept in RAM, the ones on disk stay
+	static void clear();
+
+	static const size_t MAX_MEMORY = 8 * 1024 * 1024;
+	static const size_t MAX_PARSED = 16;
+
+private:
+	static bool loadCache(const std::string& path, float sourceHeight, int64_t fileSize, int64_t fileTime, Raster& raster);
+	static void saveCache(const std::string& path, float sourceHeight, int64_t fileSize, int64_t fileTime, const Raster& raster);
+	static std::string getCachePath(const std::string& key);
+};
+
+#endif // ES_CORE_RESOURCES_SVG_CACHE_H
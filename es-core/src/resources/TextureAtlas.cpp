@@ -0,0 +1,133 @@
+#include "resources/TextureAtlas.h"
+
+#include "renderers/Renderer.h"
+#include "Log.h"
+#include <string.h>
+
+std::vector<TextureAtlas::Page> TextureAtlas::sPages;
+
+bool TextureAtlas::add(const unsigned char* dataRGBA, size_t width, size_t height, Region& region)
+{
+	if ((width == 0) || (height == 0) || (width > MAX_IMAGE_SIZE) || (height > MAX_IMAGE_SIZE))
+		return false;
+
+	// a border of repeated edge pixels keeps linear filtering from picking up the neighbouring images
+	const int paddedWidth = (int)width + 2;
+	const int paddedHeight = (int)height + 2;
+
+	Page* page = nullptr;
+	Slot slot;
+
+	for (auto it = sPages.begin(); it != sPages.end(); it++)
+	{
+		if (place(*it, paddedWidth, paddedHeight, slot))
+		{
+			page = &(*it);
+			break;
+		}
+	}
+
+	if (page == nullptr)
+	{
+		if ((int)sPages.size() >= MAX_PAGES)
+			return false;
+
+		Page newPage;
+		newPage.texture = Renderer::createTexture(Renderer::Texture::RGBA, true, false, false, PAGE_SIZE, PAGE_SIZE, nullptr);
+		newPage.shelvesHeight = 0;
+		newPage.images = 0;
+
+		if (newPage.texture == 0)
+			return false;
+
+		LOG(LogDebug) << "Created texture atlas page " << sPages.size();
+
+		sPages.push_back(newPage);
+		page = &sPages.back();
+		place(*page, paddedWidth, paddedHeight, slot);
+	}
+
+	std::vector<unsigned char> padded(paddedWidth * paddedHeight * 4);
+
+	for (int y = 0; y < paddedHeight; y++)
+	{
+		const int sourceY = (y == 0) ? 0 : ((y > (int)height) ? (int)height - 1 : y - 1);
+		const unsigned char* source = dataRGBA + (sourceY * width * 4);
+		unsigned char* row = padded.data() + (y * paddedWidth * 4);
+
+		memcpy(row + 4, source, width * 4);
+		memcpy(row, source, 4);
+		memcpy(row + ((paddedWidth - 1) * 4), source + ((width - 1) * 4), 4);
+	}
+
+	Renderer::updateTexture(page->texture, Renderer::Texture::RGBA, slot.x, slot.y, paddedWidth, paddedHeight, padded.data());
+	page->images++;
+
+	region.texture = page->texture;
+	region.offset = Vector2f((float)(slot.x + 1) / PAGE_SIZE, (float)(slot.y + 1) / PAGE_SIZE);
+	region.size = Vector2f((float)width / PAGE_SIZE, (float)height / PAGE_SIZE);
+	region.x = slot.x;
+	region.y = slot.y;
+	region.width = slot.width;
+	region.height = slot.height;
+
+	return true;
+}
+
+void TextureAtlas::remove(const Region& region)
+{
+	for (auto it = sPages.begin(); it != sPages.end(); it++)
+	{
+		if (it->texture != region.texture)
+			continue;
+
+		// a page nothing is left in is given back completely
+		if (--(it->images) == 0)
+		{
+			Renderer::destroyTexture(it->texture);
+			sPages.erase(it);
+		}
+		else
+		{
+			const Slot slot = { region.x, region.y, region.width, region.height };
+			it->freeSlots.push_back(slot);
+		}
+
+		return;
+	}
+}
+
+bool TextureAtlas::place(Page& page, int width, int height, Slot& slot)
+{
+	// reuse the space of a removed image first, themes tend to load the same sizes again
+	for (auto it = page.freeSlots.begin(); it != page.freeSlots.end(); it++)
+	{
+		if ((it->width >= width) && (it->height >= height))
+		{
+			slot = *it;
+			page.freeSlots.erase(it);
+			return true;
+		}
+	}
+
+	// then a shelf that is high enough without wasting much of it
+	for (auto it = page.shelves.begin(); it != page.shelves.end(); it++)
+	{
+		if ((it->height >= height) && (it->height <= (height + (height / 2))) && ((it->used + width) <= PAGE_SIZE))
+		{
+			slot = { it->used, it->y, width, it->height };
+			it->used += width;
+			return true;
+		}
+	}
+
+	if ((page.shelvesHeight + height) > PAGE_SIZE)
+		return false;
+
+	const Shelf shelf = { page.shelvesHeight, height, width };
+	page.shelves.push_back(shelf);
+	page.shelvesHeight += height;
+
+	slot = { 0, shelf.y, width, height };
+	return true;
+}
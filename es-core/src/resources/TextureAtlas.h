@@ -0,0 +1,66 @@
+#pragma once
+#ifndef ES_CORE_RESOURCES_TEXTURE_ATLAS_H
+#define ES_CORE_RESOURCES_TEXTURE_ATLAS_H
+
+#include "math/Vector2f.h"
+#include <stddef.h>
+#include <vector>
+
+// Packs small images into a few shared textures, so icons, stars and other theme images
+// drawn one after another bind the same texture and end up in the same batch.
+// Only used from the thread that renders.
+class TextureAtlas
+{
+public:
+	struct Region
+	{
+		unsigned int texture; // the shared texture the image was packed into
+		Vector2f     offset;  // texture coordinates of the image within it
+		Vector2f     size;
+		int          x;       // the space taken in the texture, including the padding
+		int          y;
+		int          width;
+		int          height;
+	};
+
+	// Images larger than this in either dimension get a texture of their own
+	static const size_t MAX_IMAGE_SIZE = 128;
+
+	// Copies the image into one of the shared textures, returns false when it's too big or they're all full
+	static bool add(const unsigned char* dataRGBA, size_t width, size_t height, Region& region);
+	static void remove(const Region& region);
+
+private:
+	struct Slot
+	{
+		int x;
+		int y;
+		int width;
+		int height;
+	};
+
+	struct Shelf
+	{
+		int y;
+		int height;
+		int used;
+	};
+
+	struct Page
+	{
+		unsigned int       texture;
+		std::vector<Shelf> shelves;
+		std::vector<Slot>  freeSlots;
+		int                shelvesHeight;
+		int                images;
+	};
+
+	static bool place(Page& page, int width, int height, Slot& slot);
+
+	static const int PAGE_SIZE = 1024;
+	static const int MAX_PAGES = 4;
+
+	static std::vector<Page> sPages;
+};
+
+#endif // ES_CORE_RESOURCES_TEXTURE_ATLAS_H
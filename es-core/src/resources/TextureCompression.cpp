@@ -0,0 +1,458 @@
+#include "resources/TextureCompression.h"
+
+#include "resources/PixelBufferPool.h"
+#include "utils/BinaryUtil.h"
+#include "utils/FileSystemUtil.h"
+#include "Log.h"
+#include "Settings.h"
+#include <math.h>
+#include <stdint.h>
+#include <string.h>
+#include <functional>
+#include <iomanip>
+#include <sstream>
+
+static const char     CACHE_MAGIC[4] = { 'E', 'S', 'T', 'C' };
+static const uint32_t CACHE_VERSION  = 2;
+
+// intensity modifiers of the ETC1 codewords, in the order of the pixel indices
+static const int ETC1_MODIFIERS[8][4] =
+{
+	{  2,   8,  -2,   -8 },
+	{  5,  17,  -5,  -17 },
+	{  9,  29,  -9,  -29 },
+	{ 13,  42, -13,  -42 },
+	{ 18,  60, -18,  -60 },
+	{ 24,  80, -24,  -80 },
+	{ 33, 106, -33, -106 },
+	{ 47, 183, -47, -183 }
+};
+
+static inline int clampColor(int value)
+{
+	return (value < 0) ? 0 : ((value > 255) ? 255 : value);
+}
+
+static inline int colorDistance(const int* a, const int* b)
+{
+	const int r = a[0] - b[0];
+	const int g = a[1] - b[1];
+	const int b2 = a[2] - b[2];
+
+	return (r * r) + (g * g) + (b2 * b2);
+}
+
+static inline uint16_t packRGB565(const float* color)
+{
+	const int r = clampColor((int)(color[0] + 0.5f));
+	const int g = clampColor((int)(color[1] + 0.5f));
+	const int b = clampColor((int)(color[2] + 0.5f));
+
+	return (uint16_t)((((r * 31 + 127) / 255) << 11) | (((g * 63 + 127) / 255) << 5) | ((b * 31 + 127) / 255));
+}
+
+static inline void unpackRGB565(const uint16_t packed, int* color)
+{
+	const int r = (packed >> 11) & 31;
+	const int g = (packed >> 5) & 63;
+	const int b = packed & 31;
+
+	color[0] = (r << 3) | (r >> 2);
+	color[1] = (g << 2) | (g >> 4);
+	color[2] = (b << 3) | (b >> 2);
+}
+
+Renderer::Texture::Type TextureCompression::getType()
+{
+	if (!Settings::getInstance()->getBool("CompressTextures"))
+		return Renderer::Texture::RGBA;
+
+	if (Renderer::supportsTextureType(Renderer::Texture::DXT1))
+		return Renderer::Texture::DXT1;
+
+	if (Renderer::supportsTextureType(Renderer::Texture::ETC1))
+		return Renderer::Texture::ETC1;
+
+	return Renderer::Texture::RGBA;
+}
+
+size_t TextureCompression::getSize(size_t width, size_t height)
+{
+	return ((width + BLOCK_SIZE - 1) / BLOCK_SIZE) * ((height + BLOCK_SIZE - 1) / BLOCK_SIZE) * BLOCK_BYTES;
+}
+
+bool TextureCompression::canCompress(const unsigned char* dataRGBA, size_t width, size_t height)
+{
+	if ((width == 0) || (height == 0) || (width % BLOCK_SIZE) || (height % BLOCK_SIZE))
+		return false;
+
+	// neither format keeps an alpha channel
+	for (size_t i = 3; i < (width * height * 4); i += 4)
+	{
+		if (dataRGBA[i] != 255)
+			return false;
+	}
+
+	return true;
+}
+
+void TextureCompression::compress(Renderer::Texture::Type type, const unsigned char* dataRGBA, size_t width, size_t height, std::vector<unsigned char>& data)
+{
+	unsigned char block[BLOCK_SIZE * BLOCK_SIZE * 4];
+
+	PixelBufferPool::acquire(data, getSize(width, height));
+	unsigned char* output = data.data();
+
+	for (size_t y = 0; y < height; y += BLOCK_SIZE)
+	{
+		for (size_t x = 0; x < width; x += BLOCK_SIZE)
+		{
+			for (size_t row = 0; row < BLOCK_SIZE; row++)
+				memcpy(block + (row * BLOCK_SIZE * 4), dataRGBA + ((((y + row) * width) + x) * 4), BLOCK_SIZE * 4);
+
+			if (type == Renderer::Texture::DXT1)
+				compressBlockDXT1(block, output);
+			else
+				compressBlockETC1(block, output);
+
+			output += BLOCK_BYTES;
+		}
+	}
+}
+
+void TextureCompression::compressBlockDXT1(const unsigned char* block, unsigned char* output)
+{
+	// the endpoints are the outermost colors along the axis the block varies the most in
+	float mean[3] = { 0.0f, 0.0f, 0.0f };
+
+	for (int i = 0; i < 16; i++)
+		for (int c = 0; c < 3; c++)
+			mean[c] += block[(i * 4) + c] / 16.0f;
+
+	float covariance[6] = { 0.0f, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f };
+
+	for (int i = 0; i < 16; i++)
+	{
+		const float r = block[(i * 4) + 0] - mean[0];
+		const float g = block[(i * 4) + 1] - mean[1];
+		const float b = block[(i * 4) + 2] - mean[2];
+
+		covariance[0] += r * r;
+		covariance[1] += r * g;
+		covariance[2] += r * b;
+		covariance[3] += g * g;
+		covariance[4] += g * b;
+		covariance[5] += b * b;
+	}
+
+	// a few power iterations are plenty to find the principal axis
+	float axis[3] = { 1.0f, 1.0f, 1.0f };
+
+	for (int iteration = 0; iteration < 4; iteration++)
+	{
+		const float r = (axis[0] * covariance[0]) + (axis[1] * covariance[1]) + (axis[2] * covariance[2]);
+		const float g = (axis[0] * covariance[1]) + (axis[1] * covariance[3]) + (axis[2] * covariance[4]);
+		const float b = (axis[0] * covariance[2]) + (axis[1] * covariance[4]) + (axis[2] * covariance[5]);
+		const float length = fmaxf(fabsf(r), fmaxf(fabsf(g), fabsf(b)));
+
+		if (length < 1e-6f)
+			break;
+
+		axis[0] = r / length;
+		axis[1] = g / length;
+		axis[2] = b / length;
+	}
+
+	int minIndex = 0;
+	int maxIndex = 0;
+	float minDot = 1e30f;
+	float maxDot = -1e30f;
+
+	for (int i = 0; i < 16; i++)
+	{
+		const float dot = (block[(i * 4) + 0] * axis[0]) + (block[(i * 4) + 1] * axis[1]) + (block[(i * 4) + 2] * axis[2]);
+
+		if (dot < minDot) { minDot = dot; minIndex = i; }
+		if (dot > maxDot) { maxDot = dot; maxIndex = i; }
+	}
+
+	const float maxColor[3] = { (float)block[(maxIndex * 4) + 0], (float)block[(maxIndex * 4) + 1], (float)block[(maxIndex * 4) + 2] };
+	const float minColor[3] = { (float)block[(minIndex * 4) + 0], (float)block[(minIndex * 4) + 1], (float)block[(minIndex * 4) + 2] };
+
+	uint16_t color0 = packRGB565(maxColor);
+	uint16_t color1 = packRGB565(minColor);
+	uint32_t indices = 0;
+
+	// color0 has to be the larger one, the block would be decoded with 3 colors and transparency otherwise
+	if (color0 < color1)
+	{
+		const uint16_t swap = color0;
+		color0 = color1;
+		color1 = swap;
+	}
+
+	if (color0 != color1)
+	{
+		int palette[4][3];
+
+		unpackRGB565(color0, palette[0]);
+		unpackRGB565(color1, palette[1]);
+
+		for (int c = 0; c < 3; c++)
+		{
+			palette[2][c] = ((2 * palette[0][c]) + palette[1][c]) / 3;
+			palette[3][c] = (palette[0][c] + (2 * palette[1][c])) / 3;
+		}
+
+		for (int i = 0; i < 16; i++)
+		{
+			const int pixel[3] = { block[(i * 4) + 0], block[(i * 4) + 1], block[(i * 4) + 2] };
+			int best = 0;
+			int bestDistance = colorDistance(pixel, palette[0]);
+
+			for (int p = 1; p < 4; p++)
+			{
+				const int distance = colorDistance(pixel, palette[p]);
+
+				if (distance < bestDistance)
+				{
+					best = p;
+					bestDistance = distance;
+				}
+			}
+
+			indices |= (uint32_t)best << (i * 2);
+		}
+	}
+
+	output[0] = color0 & 0xFF;
+	output[1] = color0 >> 8;
+	output[2] = color1 & 0xFF;
+	output[3] = color1 >> 8;
+	output[4] = indices & 0xFF;
+	output[5] = (indices >> 8) & 0xFF;
+	output[6] = (indices >> 16) & 0xFF;
+	output[7] = (indices >> 24) & 0xFF;
+}
+
+void TextureCompression::compressBlockETC1(const unsigned char* block, unsigned char* output)
+{
+	uint32_t bestHigh = 0;
+	uint32_t bestLow = 0;
+	int bestError = -1;
+
+	// both ways of splitting the block in halves are tried, the one closer to the original is kept
+	for (int flip = 0; flip < 2; flip++)
+	{
+		int pixels[2][8];
+		int average[2][3] = { { 0, 0, 0 }, { 0, 0, 0 } };
+		int counts[2] = { 0, 0 };
+
+		for (int y = 0; y < 4; y++)
+		{
+			for (int x = 0; x < 4; x++)
+			{
+				const int half = flip ? (y / 2) : (x / 2);
+				const int i = (y * 4) + x;
+
+				pixels[half][counts[half]++] = i;
+
+				for (int c = 0; c < 3; c++)
+					average[half][c] += block[(i * 4) + c];
+			}
+		}
+
+		// 5 bit base colors with a 3 bit difference between the halves when they're close, 4 bit colors each otherwise
+		int base[2][3];
+		int quantized[2][3];
+		bool differential = true;
+
+		for (int c = 0; c < 3; c++)
+		{
+			quantized[0][c] = ((average[0][c] * 31) + (255 * 4)) / (255 * 8);
+			quantized[1][c] = ((average[1][c] * 31) + (255 * 4)) / (255 * 8);
+
+			const int difference = quantized[1][c] - quantized[0][c];
+
+			if ((difference < -4) || (difference > 3))
+				differential = false;
+		}
+
+		for (int half = 0; half < 2; half++)
+		{
+			for (int c = 0; c < 3; c++)
+			{
+				if (differential)
+				{
+					base[half][c] = (quantized[half][c] << 3) | (quantized[half][c] >> 2);
+				}
+				else
+				{
+					quantized[half][c] = ((average[half][c] * 15) + (255 * 4)) / (255 * 8);
+					base[half][c] = (quantized[half][c] << 4) | quantized[half][c];
+				}
+			}
+		}
+
+		int tables[2];
+		int error = 0;
+		uint32_t low = 0;
+
+		for (int half = 0; half < 2; half++)
+		{
+			int bestHalfError = -1;
+			uint32_t bestHalfLow = 0;
+
+			for (int table = 0; table < 8; table++)
+			{
+				int halfError = 0;
+				uint32_t halfLow = 0;
+
+				for (int p = 0; p < 8; p++)
+				{
+					const int i = pixels[half][p];
+					const int pixel[3] = { block[(i * 4) + 0], block[(i * 4) + 1], block[(i * 4) + 2] };
+					int best = 0;
+					int bestDistance = -1;
+
+					for (int m = 0; m < 4; m++)
+					{
+						const int modifier = ETC1_MODIFIERS[table][m];
+						const int color[3] = { clampColor(base[half][0] + modifier), clampColor(base[half][1] + modifier), clampColor(base[half][2] + modifier) };
+						const int distance = colorDistance(pixel, color);
+
+						if ((bestDistance < 0) || (distance < bestDistance))
+						{
+							best = m;
+							bestDistance = distance;
+						}
+					}
+
+					// pixels are numbered column by column, the high bits of their indices come first
+					const int bit = ((i % 4) * 4) + (i / 4);
+
+					halfError += bestDistance;
+					halfLow |= ((uint32_t)(best >> 1) << (16 + bit)) | ((uint32_t)(best & 1) << bit);
+				}
+
+				if ((bestHalfError < 0) || (halfError < bestHalfError))
+				{
+					bestHalfError = halfError;
+					bestHalfLow = halfLow;
+					tables[half] = table;
+				}
+			}
+
+			error += bestHalfError;
+			low |= bestHalfLow;
+		}
+
+		if ((bestError >= 0) && (error >= bestError))
+			continue;
+
+		uint32_t high;
+
+		if (differential)
+		{
+			high = ((uint32_t)quantized[0][0] << 27) | ((uint32_t)((quantized[1][0] - quantized[0][0]) & 7) << 24) |
+			       ((uint32_t)quantized[0][1] << 19) | ((uint32_t)((quantized[1][1] - quantized[0][1]) & 7) << 16) |
+			       ((uint32_t)quantized[0][2] << 11) | ((uint32_t)((quantized[1][2] - quantized[0][2]) & 7) << 8);
+		}
+		else
+		{
+			high = ((uint32_t)quantized[0][0] << 28) | ((uint32_t)quantized[1][0] << 24) |
+			       ((uint32_t)quantized[0][1] << 20) | ((uint32_t)quantized[1][1] << 16) |
+			       ((uint32_t)quantized[0][2] << 12) | ((uint32_t)quantized[1][2] << 8);
+		}
+
+		high |= ((uint32_t)tables[0] << 5) | ((uint32_t)tables[1] << 2) | ((differential ? 1u : 0u) << 1) | (uint32_t)flip;
+
+		bestError = error;
+		bestHigh = high;
+		bestLow = low;
+	}
+
+	// blocks are stored big endian
+	for (int i = 0; i < 4; i++)
+	{
+		output[i] = (bestHigh >> (24 - (i * 8))) & 0xFF;
+		output[i + 4] = (bestLow >> (24 - (i * 8))) & 0xFF;
+	}
+}
+
+bool TextureCompression::loadCache(const std::string& path, Renderer::Texture::Type type, size_t& sourceWidth, size_t& sourceHeight, int& level, size_t& width, size_t& height, std::vector<unsigned char>& data)
+{
+	std::string buffer;
+
+	if (!Utils::Binary::loadFile(getCachePath(path), buffer))
+		return false;
+
+	Utils::Binary::Reader reader(buffer);
+	char magic[4];
+	uint32_t version;
+	std::string sourcePath;
+	int64_t sourceSize;
+	int64_t sourceTime;
+	uint32_t sourceType;
+	uint32_t fullWidth;
+	uint32_t fullHeight;
+	uint32_t reducedLevel;
+	uint32_t compressedWidth;
+	uint32_t compressedHeight;
+
+	if (!reader.read(magic, sizeof(magic)) || memcmp(magic, CACHE_MAGIC, sizeof(magic)) ||
+		!reader.read(version) || (version != CACHE_VERSION) ||
+		!reader.readString(sourcePath) || !reader.read(sourceSize) || !reader.read(sourceTime) ||
+		!reader.read(sourceType) || !reader.read(fullWidth) || !reader.read(fullHeight) ||
+		!reader.read(reducedLevel) || !reader.read(compressedWidth) || !reader.read(compressedHeight))
+		return false;
+
+	// another image with the same hash, a changed image or one compressed for another renderer
+	if ((sourcePath != path) || (sourceType != (uint32_t)type) ||
+		(sourceSize != Utils::FileSystem::getFileSize(path)) || (sourceTime != (int64_t)Utils::FileSystem::getModifiedTime(path)))
+		return false;
+
+	const size_t size = getSize(compressedWidth, compressedHeight);
+
+	if ((compressedWidth == 0) || (compressedHeight == 0) || (reader.getRemaining() != size))
+		return false;
+
+	PixelBufferPool::acquire(data, size);
+	reader.read(data.data(), size);
+	sourceWidth = fullWidth;
+	sourceHeight = fullHeight;
+	level = (int)reducedLevel;
+	width = compressedWidth;
+	height = compressedHeight;
+
+	return true;
+}
+
+void TextureCompression::saveCache(const std::string& path, Renderer::Texture::Type type, size_t sourceWidth, size_t sourceHeight, int level, size_t width, size_t height, const std::vector<unsigned char>& data)
+{
+	Utils::Binary::Writer writer;
+
+	writer.write(CACHE_MAGIC, sizeof(CACHE_MAGIC));
+	writer.write(CACHE_VERSION);
+	writer.writeString(path);
+	writer.write((int64_t)Utils::FileSystem::getFileSize(path));
+	writer.write((int64_t)Utils::FileSystem::getModifiedTime(path));
+	writer.write((uint32_t)type);
+	writer.write((uint32_t)sourceWidth);
+	writer.write((uint32_t)sourceHeight);
+	writer.write((uint32_t)level);
+	writer.write((uint32_t)width);
+	writer.write((uint32_t)height);
+	writer.write(data.data(), data.size());
+
+	if (!Utils::Binary::saveFile(getCachePath(path), writer.getBuffer()))
+		LOG(LogWarning) << "Could not save compressed copy of \"" << path << "\"";
+}
+
+std::string TextureCompression::getCachePath(const std::string& path)
+{
+	std::stringstream ss;
+	ss << std::hex << std::setw(16) << std::setfill('0') << (uint64_t)std::hash<std::string>()(path);
+
+	return Utils::FileSystem::getHomePath() + "/.emulationstation/compressed_images/" + ss.str() + ".tex";
+}
@@ -0,0 +1,42 @@
+#pragma once
+#ifndef ES_CORE_RESOURCES_TEXTURE_COMPRESSION_H
+#define ES_CORE_RESOURCES_TEXTURE_COMPRESSION_H
+
+#include "renderers/Renderer.h"
+#include <stddef.h>
+#include <string>
+#include <vector>
+
+// Transcodes opaque images like boxart into a block compressed format the GPU samples directly, 4 bits per pixel
+// instead of 32. The result is kept on disk next to the downloaded images, so an image is only decoded and
+// compressed again once its file changes. Safe to use from the texture loader thread.
+class TextureCompression
+{
+public:
+	// The format images get compressed to, Texture::RGBA when it's turned off or the renderer supports none
+	static Renderer::Texture::Type getType();
+
+	// Size in bytes of a compressed image of width x height
+	static size_t getSize(size_t width, size_t height);
+
+	// Only opaque images made of whole blocks are compressed, anything else stays RGBA
+	static bool canCompress(const unsigned char* dataRGBA, size_t width, size_t height);
+	static void compress(Renderer::Texture::Type type, const unsigned char* dataRGBA, size_t width, size_t height, std::vector<unsigned char>& data);
+
+	// The cache is only used while the image at path keeps its size and modification time. It holds the image the way
+	// it was compressed, reduced by level from sourceWidth x sourceHeight to width x height (see TextureVariant)
+	static bool loadCache(const std::string& path, Renderer::Texture::Type type, size_t& sourceWidth, size_t& sourceHeight, int& level, size_t& width, size_t& height, std::vector<unsigned char>& data);
+	static void saveCache(const std::string& path, Renderer::Texture::Type type, size_t sourceWidth, size_t sourceHeight, int level, size_t width, size_t height, const std::vector<unsigned char>& data);
+
+	// Images are compressed in blocks of BLOCK_SIZE x BLOCK_SIZE pixels taking BLOCK_BYTES each
+	static const size_t BLOCK_SIZE = 4;
+	static const size_t BLOCK_BYTES = 8;
+
+private:
+	static void compressBlockDXT1(const unsigned char* block, unsigned char* output);
+	static void compressBlockETC1(const unsigned char* block, unsigned char* output);
+
+	static std::string getCachePath(const std::string& path);
+};
+
+#endif // ES_CORE_RESOURCES_TEXTURE_COMPRESSION_H
@@ -2,18 +2,23 @@
 
 #include "math/Misc.h"
 #include "renderers/Renderer.h"
+#include "resources/PixelBufferPool.h"
 #include "resources/ResourceManager.h"
+#include "resources/SVGCache.h"
+#include "resources/TextureCompression.h"
+#include "resources/TextureVariant.h"
 #include "ImageIO.h"
 #include "Log.h"
+#include "Settings.h"
 #include <nanosvg/nanosvg.h>
 #include <nanosvg/nanosvgrast.h>
 #include <assert.h>
 #include <string.h>
 
-#define DPI 96
-
-TextureData::TextureData(bool tile) : mTile(tile), mTextureID(0), mDataRGBA(nullptr), mScalable(false),
-									  mWidth(0), mHeight(0), mSourceWidth(0.0f), mSourceHeight(0.0f)
+TextureData::TextureData(bool tile) : mTile(tile), mTextureID(0), mTextureContext(0), mDataType(Renderer::Texture::RGBA), mScalable(false), mInAtlas(false),
+									  mMipmapped(false), mWidth(0), mHeight(0), mSourceWidth(0.0f), mSourceHeight(0.0f), mLevel(-1),
+									  mDisplayWidth(0.0f), mDisplayHeight(0.0f), mDisplayFitInside(false), mDisplayPending(false),
+									  mLastUsedFrame(0)
 {
 }
 
@@ -29,32 +34,28 @@ void TextureData::initFromPath(const std::string& path)
 	mPath = path;
 	// Only textures with paths are reloadable
 	mReloadable = true;
+	// Known before loading, so SVGs never get a display size
+	mScalable = (mPath.size() >= 4) && (mPath.substr(mPath.size() - 4, std::string::npos) == ".svg");
 }
 
 bool TextureData::initSVGFromMemory(const unsigned char* fileData, size_t length)
 {
 	// If already initialised then don't read again
 	std::unique_lock<std::mutex> lock(mMutex);
-	if (mDataRGBA)
+	if (!mDataRGBA.empty())
 		return true;
 
-	// nsvgParse excepts a modifiable, null-terminated string
-	char* copy = (char*)malloc(length + 1);
-	assert(copy != NULL);
-	memcpy(copy, fileData, length);
-	copy[length] = '\0';
-
-	NSVGimage* svgImage = nsvgParse(copy, "px", DPI);
-	free(copy);
-	if (!svgImage || (svgImage->width == 0) || (svgImage->height == 0))
+	// the same file rasterized at another size is only parsed once
+	const std::shared_ptr<NSVGimage> svgImage = SVGCache::parse(mPath, fileData, length);
+	if (!svgImage)
 	{
 		LOG(LogError) << "Error parsing SVG image.";
-		nsvgDelete(svgImage);
 		return false;
 	}
 
 	// We want to rasterise this texture at a specific resolution. If the source size
 	// variables are set then use them otherwise set them from the parsed file
+	const float requestedHeight = mSourceHeight;
 	if (mSourceHeight == 0.0f)
 		mSourceHeight = svgImage->height;
 
@@ -63,18 +64,50 @@ bool TextureData::initSVGFromMemory(const unsigned char* fileData, size_t length
 	mWidth = (size_t)Math::round(mSourceWidth);
 	mHeight = (size_t)Math::round(mSourceHeight);
 
-	unsigned char* dataRGBA = new unsigned char[mWidth * mHeight * 4];
+	std::vector<unsigned char> dataRGBA;
+	PixelBufferPool::acquire(dataRGBA, mWidth * mHeight * 4);
 
 	NSVGrasterizer* rast = nsvgCreateRasterizer();
 	float scale = Math::min(mHeight / svgImage->height, mWidth / svgImage->width);
-	nsvgRasterize(rast, svgImage, 0, 0, scale, dataRGBA, (int)mWidth, (int)mHeight, (int)mWidth * 4);
+	nsvgRasterize(rast, svgImage.get(), 0, 0, scale, dataRGBA.data(), (int)mWidth, (int)mHeight, (int)mWidth * 4);
 	nsvgDeleteRasterizer(rast);
-	nsvgDelete(svgImage);
 
-	ImageIO::flipPixelsVert(dataRGBA, mWidth, mHeight);
+	ImageIO::flipPixelsVert(dataRGBA.data(), mWidth, mHeight);
+
+	const SVGCache::Raster raster = { mSourceWidth, mSourceHeight, mWidth, mHeight, std::make_shared<std::vector<unsigned char>>(dataRGBA) };
+	mDataRGBA.swap(dataRGBA);
+	lock.unlock();
+
+	SVGCache::add(mPath, requestedHeight, raster);
+
+	return true;
+}
+
+bool TextureData::loadCachedSVG()
+{
+	float sourceHeight;
+	{
+		std::unique_lock<std::mutex> lock(mMutex);
+		if (!mDataRGBA.empty())
+			return true;
+		sourceHeight = mSourceHeight;
+	}
+
+	SVGCache::Raster raster;
+	if (!SVGCache::get(mPath, sourceHeight, raster))
+		return false;
 
-	mDataRGBA = dataRGBA;
+	std::unique_lock<std::mutex> lock(mMutex);
+	if (!mDataRGBA.empty())
+		return true;
 
+	PixelBufferPool::acquire(mDataRGBA, raster.dataRGBA->size());
+	memcpy(mDataRGBA.data(), raster.dataRGBA->data(), raster.dataRGBA->size());
+	mDataType = Renderer::Texture::RGBA;
+	mSourceWidth = raster.sourceWidth;
+	mSourceHeight = raster.sourceHeight;
+	mWidth = raster.width;
+	mHeight = raster.height;
 	return true;
 }
 
@@ -85,34 +118,157 @@ bool TextureData::initImageFromMemory(const unsigned char* fileData, size_t leng
 	// If already initialised then don't read again
 	{
 		std::unique_lock<std::mutex> lock(mMutex);
-		if (mDataRGBA)
+		if (!mDataRGBA.empty() || !mDataCompressed.empty())
 			return true;
 	}
 
-	std::vector<unsigned char> imageRGBA = ImageIO::loadFromMemoryRGBA32((const unsigned char*)(fileData), length, width, height);
-	if (imageRGBA.size() == 0)
+	// Images only shown smaller are halved until they'd get smaller than that, JPEGs mostly while they're decoded
+	const bool reducible = !mPath.empty() && !mTile;
+	ImageIO::LevelFunction decodeLevel = nullptr;
+	if (reducible)
+		decodeLevel = [this](size_t sourceWidth, size_t sourceHeight) { return getLevel(sourceWidth, sourceHeight); };
+
+	std::vector<unsigned char> imageRGBA;
+	size_t sourceWidth, sourceHeight;
+	int decodedLevel;
+	if (!ImageIO::loadFromMemoryRGBA32((const unsigned char*)(fileData), length, decodeLevel, imageRGBA, sourceWidth, sourceHeight, width, height, decodedLevel))
 	{
 		LOG(LogError) << "Could not initialize texture from memory, invalid data!  (file path: " << mPath << ", data ptr: " << (size_t)fileData << ", reported size: " << length << ")";
 		return false;
 	}
 
-	mSourceWidth = (float) width;
-	mSourceHeight = (float) height;
+	mSourceWidth = (float) sourceWidth;
+	mSourceHeight = (float) sourceHeight;
 	mScalable = false;
 
-	return initFromRGBA(imageRGBA.data(), width, height);
+	const int level = reducible ? getLevel(sourceWidth, sourceHeight) : 0;
+	if (level > decodedLevel)
+		TextureVariant::reduce(imageRGBA, width, height, level - decodedLevel);
+
+	if (compress(imageRGBA.data(), sourceWidth, sourceHeight, width, height))
+	{
+		PixelBufferPool::release(imageRGBA);
+		return true;
+	}
+
+	if (level > 0)
+		TextureVariant::saveCache(mPath, sourceWidth, sourceHeight, level, width, height, imageRGBA);
+
+	return initFromRGBA(std::move(imageRGBA), width, height);
 }
 
 bool TextureData::initFromRGBA(const unsigned char* dataRGBA, size_t width, size_t height)
+{
+	// Take a copy
+	std::vector<unsigned char> copy;
+	PixelBufferPool::acquire(copy, width * height * 4);
+	memcpy(copy.data(), dataRGBA, copy.size());
+	return initFromRGBA(std::move(copy), width, height);
+}
+
+bool TextureData::initFromRGBA(std::vector<unsigned char>&& dataRGBA, size_t width, size_t height)
 {
 	// If already initialised then don't read again
 	std::unique_lock<std::mutex> lock(mMutex);
-	if (mDataRGBA)
+	if (!mDataRGBA.empty())
+	{
+		PixelBufferPool::release(dataRGBA);
 		return true;
+	}
 
-	// Take a copy
-	mDataRGBA = new unsigned char[width * height * 4];
-	memcpy(mDataRGBA, dataRGBA, width * height * 4);
+	mDataRGBA.swap(dataRGBA);
+	mDataType = Renderer::Texture::RGBA;
+	mWidth = width;
+	mHeight = height;
+	return true;
+}
+
+bool TextureData::loadCompressed()
+{
+	const Renderer::Texture::Type type = TextureCompression::getType();
+	std::vector<unsigned char> data;
+	size_t sourceWidth, sourceHeight, width, height;
+	int level;
+
+	// a copy reduced for another display size doesn't fit
+	if ((type == Renderer::Texture::RGBA) || mTile ||
+		!TextureCompression::loadCache(mPath, type, sourceWidth, sourceHeight, level, width, height, data) ||
+		(level != getLevel(sourceWidth, sourceHeight)))
+		return false;
+
+	std::unique_lock<std::mutex> lock(mMutex);
+	if (!mDataRGBA.empty() || !mDataCompressed.empty())
+		return true;
+
+	mDataCompressed.swap(data);
+	mDataType = type;
+	mWidth = width;
+	mHeight = height;
+	mSourceWidth = (float) sourceWidth;
+	mSourceHeight = (float) sourceHeight;
+	mScalable = false;
+	return true;
+}
+
+bool TextureData::loadReduced()
+{
+	std::vector<unsigned char> dataRGBA;
+	size_t sourceWidth, sourceHeight, width, height;
+	int level;
+
+	// only look for a copy when the image may be reduced at all, reading it decodes the copy
+	if (mTile || !TextureVariant::isEnabled() || ((mLevel == 0) || ((mLevel < 0) && !mDisplayPending)) ||
+		!TextureVariant::loadCache(mPath, sourceWidth, sourceHeight, level, width, height, dataRGBA) ||
+		(level != getLevel(sourceWidth, sourceHeight)))
+		return false;
+
+	mSourceWidth = (float) sourceWidth;
+	mSourceHeight = (float) sourceHeight;
+	mScalable = false;
+
+	if (compress(dataRGBA.data(), sourceWidth, sourceHeight, width, height))
+	{
+		PixelBufferPool::release(dataRGBA);
+		return true;
+	}
+
+	return initFromRGBA(std::move(dataRGBA), width, height);
+}
+
+int TextureData::getLevel(size_t sourceWidth, size_t sourceHeight)
+{
+	std::unique_lock<std::mutex> lock(mMutex);
+	if (mLevel < 0)
+	{
+		mLevel = mDisplayPending ? TextureVariant::getLevel(sourceWidth, sourceHeight, mDisplayWidth, mDisplayHeight, mDisplayFitInside) : 0;
+		mDisplayPending = false;
+	}
+	return mLevel;
+}
+
+bool TextureData::compress(const unsigned char* dataRGBA, size_t sourceWidth, size_t sourceHeight, size_t width, size_t height)
+{
+	const Renderer::Texture::Type type = TextureCompression::getType();
+
+	// small images go into the atlas instead, tiled ones are mostly patterns that show the blocks
+	if ((type == Renderer::Texture::RGBA) || mTile || mPath.empty() ||
+		((width <= TextureAtlas::MAX_IMAGE_SIZE) && (height <= TextureAtlas::MAX_IMAGE_SIZE)) ||
+		!TextureCompression::canCompress(dataRGBA, width, height))
+		return false;
+
+	std::vector<unsigned char> data;
+	TextureCompression::compress(type, dataRGBA, width, height, data);
+	TextureCompression::saveCache(mPath, type, sourceWidth, sourceHeight, getLevel(sourceWidth, sourceHeight), width, height, data);
+
+	std::unique_lock<std::mutex> lock(mMutex);
+	if (!mDataRGBA.empty() || !mDataCompressed.empty())
+	{
+		PixelBufferPool::release(data);
+		return true;
+	}
+
+	mDataCompressed.swap(data);
+	mDataType = type;
 	mWidth = width;
 	mHeight = height;
 	return true;
@@ -126,67 +282,161 @@ bool TextureData::load()
 	if (!mPath.empty())
 	{
 		std::shared_ptr<ResourceManager>& rm = ResourceManager::getInstance();
-		const ResourceData& data = rm->getFileData(mPath);
 		// is it an SVG?
 		if (mPath.substr(mPath.size() - 4, std::string::npos) == ".svg")
 		{
 			mScalable = true;
-			retval = initSVGFromMemory((const unsigned char*)data.ptr.get(), data.length);
+			if (loadCachedSVG())
+				retval = true; // rasterized at this size before, the file isn't even read
+			else
+			{
+				const ResourceData& data = rm->getFileData(mPath);
+				retval = initSVGFromMemory((const unsigned char*)data.ptr.get(), data.length);
+			}
 		}
+		else if (loadCompressed() || loadReduced())
+			retval = true; // the compressed or reduced copy saves decoding the full image
 		else
+		{
+			const ResourceData& data = rm->getFileData(mPath);
 			retval = initImageFromMemory((const unsigned char*)data.ptr.get(), data.length);
+		}
 	}
 	return retval;
 }
 
+bool TextureData::loadSize()
+{
+	size_t width, height;
+
+	if (mScalable || mPath.empty() || !ImageIO::loadSizeFromFile(ResourceManager::getInstance()->getResourcePath(mPath), width, height))
+		return false;
+
+	std::unique_lock<std::mutex> lock(mMutex);
+	mSourceWidth = (float) width;
+	mSourceHeight = (float) height;
+	// Until it's loaded that's what it takes at most
+	if (mWidth == 0)
+	{
+		mWidth = width;
+		mHeight = height;
+	}
+	return true;
+}
+
 bool TextureData::isLoaded()
 {
 	std::unique_lock<std::mutex> lock(mMutex);
-	if (mDataRGBA || (mTextureID != 0))
+	if (!mDataRGBA.empty() || !mDataCompressed.empty() || (mTextureID != 0))
 		return true;
 	return false;
 }
 
+bool TextureData::isUploaded()
+{
+	std::unique_lock<std::mutex> lock(mMutex);
+	return (mTextureID != 0);
+}
+
 bool TextureData::uploadAndBind()
 {
 	// See if it's already been uploaded
 	std::unique_lock<std::mutex> lock(mMutex);
+
+	// uploaded in the background just before the renderer went down, the texture went with the context
+	if ((mTextureID != 0) && (mTextureContext != Renderer::getContextCount()))
+	{
+		mTextureID = 0;
+		mInAtlas = false;
+		mMipmapped = false;
+	}
+
 	if (mTextureID != 0)
 	{
 		Renderer::bindTexture(mTextureID);
+		if (mInAtlas)
+			Renderer::setTextureRegion(mAtlasRegion.offset, mAtlasRegion.size);
 	}
 	else
 	{
 		// Load it if necessary
-		if (!mDataRGBA)
+		if (mDataRGBA.empty() && mDataCompressed.empty())
 		{
 			return false;
 		}
 		// Make sure we're ready to upload
-		if ((mWidth == 0) || (mHeight == 0) || (mDataRGBA == nullptr))
+		if ((mWidth == 0) || (mHeight == 0))
 			return false;
 
-		// Upload texture
-		mTextureID = Renderer::createTexture(Renderer::Texture::RGBA, true, mTile, (int)mWidth, (int)mHeight, mDataRGBA);
+		if (!mDataCompressed.empty())
+		{
+			mTextureID = Renderer::createTexture(mDataType, true, false, false, (int)mWidth, (int)mHeight, mDataCompressed.data());
+			Renderer::bindTexture(mTextureID);
+		}
+		// Small images share an atlas texture, so they can be drawn together. Tiled ones need a texture of their own to repeat
+		else if (!mTile && TextureAtlas::add(mDataRGBA.data(), mWidth, mHeight, mAtlasRegion))
+		{
+			mTextureID = mAtlasRegion.texture;
+			mInAtlas = true;
+			Renderer::bindTexture(mTextureID);
+			Renderer::setTextureRegion(mAtlasRegion.offset, mAtlasRegion.size);
+		}
+		else
+		{
+			// Upload texture, mipmaps keep images shown smaller than their texture from flickering
+			mMipmapped = Settings::getInstance()->getBool("TextureMipmaps");
+			mTextureID = Renderer::createTexture(Renderer::Texture::RGBA, true, mTile, mMipmapped, (int)mWidth, (int)mHeight, mDataRGBA.data());
+			Renderer::bindTexture(mTextureID);
+		}
+		mTextureContext = Renderer::getContextCount();
 	}
 	return true;
 }
 
+void TextureData::uploadInBackground()
+{
+	std::unique_lock<std::mutex> lock(mMutex);
+	if ((mTextureID != 0) || (mWidth == 0) || (mHeight == 0) || (mDataRGBA.empty() && mDataCompressed.empty()))
+		return;
+
+	if (mDataCompressed.empty() && !mTile && (mWidth <= TextureAtlas::MAX_IMAGE_SIZE) && (mHeight <= TextureAtlas::MAX_IMAGE_SIZE))
+		return;
+
+	if (!Renderer::beginUpload())
+		return;
+
+	if (!mDataCompressed.empty())
+		mTextureID = Renderer::uploadTexture(mDataType, true, false, false, (int)mWidth, (int)mHeight, mDataCompressed.data());
+	else
+	{
+		mMipmapped = Settings::getInstance()->getBool("TextureMipmaps");
+		mTextureID = Renderer::uploadTexture(Renderer::Texture::RGBA, true, mTile, mMipmapped, (int)mWidth, (int)mHeight, mDataRGBA.data());
+	}
+	mTextureContext = Renderer::getContextCount();
+
+	Renderer::endUpload();
+}
+
 void TextureData::releaseVRAM()
 {
 	std::unique_lock<std::mutex> lock(mMutex);
 	if (mTextureID != 0)
 	{
-		Renderer::destroyTexture(mTextureID);
+		if (mInAtlas)
+			TextureAtlas::remove(mAtlasRegion);
+		else if (mTextureContext == Renderer::getContextCount())
+			Renderer::destroyTexture(mTextureID);
 		mTextureID = 0;
+		mInAtlas = false;
+		mMipmapped = false;
 	}
 }
 
 void TextureData::releaseRAM()
 {
 	std::unique_lock<std::mutex> lock(mMutex);
-	delete[] mDataRGBA;
-	mDataRGBA = 0;
+	PixelBufferPool::release(mDataRGBA);
+	PixelBufferPool::release(mDataCompressed);
 }
 
 size_t TextureData::width()
@@ -217,6 +467,41 @@ float TextureData::sourceHeight()
 	return mSourceHeight;
 }
 
+bool TextureData::setDisplaySize(float width, float height, bool fitInside)
+{
+	// SVGs are rasterized at the size they're shown at anyway, tiled images repeat at their own size
+	if (mScalable || mTile || mPath.empty())
+		return false;
+
+	std::unique_lock<std::mutex> lock(mMutex);
+	if ((mSourceWidth == 0) || (mSourceHeight == 0))
+	{
+		// The image size is only known once it's loaded, that's when the first size asked for decides.
+		// Anything else asking before that gets the full image
+		if ((mLevel < 0) && !mDisplayPending)
+		{
+			mDisplayWidth = width;
+			mDisplayHeight = height;
+			mDisplayFitInside = fitInside;
+			mDisplayPending = true;
+		}
+		else
+		{
+			mLevel = 0;
+			mDisplayPending = false;
+		}
+		return false;
+	}
+
+	const int level = TextureVariant::getLevel((size_t)mSourceWidth, (size_t)mSourceHeight, width, height, fitInside);
+	if ((mLevel >= 0) && (level >= mLevel))
+		return false;
+
+	mLevel = level;
+	mDisplayPending = false;
+	return (!mDataRGBA.empty() || !mDataCompressed.empty() || (mTextureID != 0));
+}
+
 void TextureData::setSourceSize(float width, float height)
 {
 	if (mScalable)
@@ -233,8 +518,17 @@ void TextureData::setSourceSize(float width, float height)
 
 size_t TextureData::getVRAMUsage()
 {
-	if ((mTextureID != 0) || (mDataRGBA != nullptr))
-		return mWidth * mHeight * 4;
+	if ((mTextureID != 0) || !mDataRGBA.empty() || !mDataCompressed.empty())
+	{
+		// mipmaps take another third
+		const size_t size = (mDataType == Renderer::Texture::RGBA) ? (mWidth * mHeight * 4) : TextureCompression::getSize(mWidth, mHeight);
+		return mMipmapped ? (size + (size / 3)) : size;
+	}
 	else
 		return 0;
 }
+
+size_t TextureData::getRAMUsage()
+{
+	return mDataRGBA.capacity() + mDataCompressed.capacity();
+}
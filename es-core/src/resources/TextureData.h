@@ -2,8 +2,11 @@
 #ifndef ES_CORE_RESOURCES_TEXTURE_DATA_H
 #define ES_CORE_RESOURCES_TEXTURE_DATA_H
 
+#include "renderers/Renderer.h"
+#include "resources/TextureAtlas.h"
 #include <mutex>
 #include <string>
+#include <vector>
 
 class TextureResource;
 
@@ -20,16 +23,27 @@ public:
 	bool initSVGFromMemory(const unsigned char* fileData, size_t length);
 	bool initImageFromMemory(const unsigned char* fileData, size_t length);
 	bool initFromRGBA(const unsigned char* dataRGBA, size_t width, size_t height);
+	// Takes the data over instead of copying it, dataRGBA is left empty
+	bool initFromRGBA(std::vector<unsigned char>&& dataRGBA, size_t width, size_t height);
 
 	// Read the data into memory if necessary
 	bool load();
 
+	// Reads only the size of the image, so it can be laid out before it's loaded. Fails for SVGs, their size depends on
+	// what they're rasterized at
+	bool loadSize();
+
 	bool isLoaded();
+	bool isUploaded();
 
 	// Upload the texture to VRAM if necessary and bind. Returns true if bound ok or
 	// false if either not loaded
 	bool uploadAndBind();
 
+	// Creates the texture on the upload context when the renderer has one, called by the texture loader threads once
+	// the image is loaded. Small images are left for uploadAndBind(), the atlas is only written to while drawing
+	void uploadInBackground();
+
 	// Release the texture from VRAM
 	void releaseVRAM();
 
@@ -38,6 +52,8 @@ public:
 
 	// Get the amount of VRAM currenty used by this texture
 	size_t getVRAMUsage();
+	// Get the amount of RAM held by the pixels of this texture that aren't uploaded yet or are kept for reloading
+	size_t getRAMUsage();
 
 	size_t width();
 	size_t height();
@@ -45,20 +61,50 @@ public:
 	float sourceHeight();
 	void setSourceSize(float width, float height);
 
+	// Lets an image that's only shown at width x height be kept at a reduced size, the largest size asked for wins.
+	// Returns true when the loaded image is too small for it and has to be loaded again
+	bool setDisplaySize(float width, float height, bool fitInside);
+
 	bool tiled() { return mTile; }
 
+	// The last frame the texture was drawn in, kept by the TextureDataManager
+	unsigned int getLastUsedFrame() { return mLastUsedFrame; }
+	void setLastUsedFrame(unsigned int frame) { mLastUsedFrame = frame; }
+
 private:
+	// Replaces the RGBA data by a compressed copy when the image is large, opaque and compression is enabled
+	bool loadCompressed();
+	bool compress(const unsigned char* dataRGBA, size_t sourceWidth, size_t sourceHeight, size_t width, size_t height);
+	bool loadReduced();
+	// Takes the raster of the SVG from the SVGCache when it was rasterized at this size before
+	bool loadCachedSVG();
+
+	// How many times the image gets halved, decided by the display size once the image size is known
+	int getLevel(size_t sourceWidth, size_t sourceHeight);
+
 	std::mutex		mMutex;
 	bool			mTile;
 	std::string		mPath;
 	unsigned int	mTextureID;
-	unsigned char*	mDataRGBA;
+	unsigned int	mTextureContext; // the Renderer::getContextCount() mTextureID was created in
+	std::vector<unsigned char>	mDataRGBA;
+	std::vector<unsigned char>	mDataCompressed;
+	Renderer::Texture::Type	mDataType;
 	size_t			mWidth;
 	size_t			mHeight;
 	float			mSourceWidth;
 	float			mSourceHeight;
 	bool			mScalable;
 	bool			mReloadable;
+	bool			mInAtlas;
+	bool			mMipmapped;
+	TextureAtlas::Region	mAtlasRegion;
+	int				mLevel;
+	float			mDisplayWidth;
+	float			mDisplayHeight;
+	bool			mDisplayFitInside;
+	bool			mDisplayPending;
+	unsigned int	mLastUsedFrame;
 };
 
 #endif // ES_CORE_RESOURCES_TEXTURE_DATA_H
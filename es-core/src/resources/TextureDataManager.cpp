@@ -2,9 +2,12 @@
 
 #include "resources/TextureData.h"
 #include "resources/TextureResource.h"
+#include "FrameScheduler.h"
 #include "Settings.h"
+#include <SDL_timer.h>
+#include <iterator>
 
-TextureDataManager::TextureDataManager()
+TextureDataManager::TextureDataManager() : mStats(), mFrame(PIN_FRAMES), mUploadedBytes(0), mReservedBytes(0)
 {
 	unsigned char data[5 * 5 * 4];
 	mBlank = std::shared_ptr<TextureData>(new TextureData(false));
@@ -39,6 +42,8 @@ void TextureDataManager::remove(const TextureResource* key)
 	auto it = mTextureLookup.find(key);
 	if (it != mTextureLookup.cend())
 	{
+		// Nobody is waiting for it anymore, like a grid tile that was scrolled away before its image was loaded
+		mLoader->remove(*(*it).second);
 		// Remove the list entry
 		mTextures.erase((*it).second);
 		// And the lookup
@@ -74,12 +79,82 @@ bool TextureDataManager::bind(const TextureResource* key)
 	std::shared_ptr<TextureData> tex = get(key);
 	bool bound = false;
 	if (tex != nullptr)
-		bound = tex->uploadAndBind();
+	{
+		const bool uploaded = tex->isUploaded();
+		const bool deferred = !uploaded && tex->isLoaded() && !takeUploadBudget(tex);
+		bound = !deferred && tex->uploadAndBind();
+		tex->setLastUsedFrame(mFrame);
+
+		if (deferred)
+			++mStats.deferrals;
+		else if (!bound)
+			++mStats.misses;
+		else if (uploaded)
+			++mStats.hits;
+		else
+		{
+			++mStats.uploads;
+			mStats.uploadedBytes += tex->getVRAMUsage();
+		}
+	}
 	if (!bound)
 		mBlank->uploadAndBind();
 	return bound;
 }
 
+void TextureDataManager::frameDone()
+{
+	++mFrame;
+
+	mDeferred.swap(mDeferredNext);
+	mDeferredNext.clear();
+	mUploadedBytes = 0;
+	mReservedBytes = 0;
+	for (auto it = mDeferred.cbegin(); it != mDeferred.cend(); ++it)
+		mReservedBytes += it->second;
+}
+
+bool TextureDataManager::takeUploadBudget(const std::shared_ptr<TextureData>& tex)
+{
+	const size_t budget = (size_t)Settings::getInstance()->getInt("TextureUploadBudget") * 1024;
+	const size_t size = tex->getVRAMUsage();
+
+	// 0 is unlimited
+	if (budget == 0)
+		return true;
+
+	auto it = mDeferred.find(tex.get());
+	const bool waited = (it != mDeferred.cend());
+
+	// a texture that didn't wait only gets what's left over after the ones that did
+	const size_t reserved = waited ? 0 : mReservedBytes;
+	const bool first = (mUploadedBytes == 0) && (reserved == 0);
+
+	if (first || ((mUploadedBytes + reserved + size) <= budget) || (waited && (mUploadedBytes == 0)))
+	{
+		if (waited)
+		{
+			mReservedBytes -= (it->second < mReservedBytes) ? it->second : mReservedBytes;
+			mDeferred.erase(it);
+		}
+
+		mUploadedBytes += size;
+		return true;
+	}
+
+	// the next frame has to come even when nothing else changes
+	mDeferredNext[tex.get()] = size;
+	FrameScheduler::wakeUp();
+	return false;
+}
+
+TextureDataManager::Stats TextureDataManager::takeStats()
+{
+	const Stats stats = mStats;
+	mStats = Stats();
+	return stats;
+}
+
 size_t TextureDataManager::getTotalSize()
 {
 	size_t total = 0;
@@ -96,12 +171,25 @@ size_t TextureDataManager::getCommittedSize()
 	return total;
 }
 
+size_t TextureDataManager::getRAMSize()
+{
+	size_t total = 0;
+	for (auto tex : mTextures)
+		total += tex->getRAMUsage();
+	return total;
+}
+
 size_t TextureDataManager::getQueueSize()
 {
 	return mLoader->getQueueSize();
 }
 
-void TextureDataManager::load(std::shared_ptr<TextureData> tex, bool block)
+size_t TextureDataManager::getQueueLength()
+{
+	return mLoader->getQueueLength();
+}
+
+void TextureDataManager::load(std::shared_ptr<TextureData> tex, bool block, TextureLoader::Priority priority)
 {
 	// See if it's already loaded
 	if (tex->isLoaded())
@@ -113,94 +201,205 @@ void TextureDataManager::load(std::shared_ptr<TextureData> tex, bool block)
 	if (max_texture > 0)
 	{
 		size_t size = TextureResource::getTotalMemUsage();
+		// Textures that aren't drawn yet mustn't push out the ones that are
+		if ((priority != TextureLoader::PRIORITY_VISIBLE) && (size >= max_texture))
+			return;
+		// The least recently used textures are at the end of the list
 		for (auto it = mTextures.crbegin(); it != mTextures.crend(); ++it)
 		{
 			if (size < max_texture)
 				break;
-			//size -= (*it)->getVRAMUsage();
-			(*it)->releaseVRAM();
-			(*it)->releaseRAM();
+			// What's on screen stays, even if that's more than fits
+			if ((*it == tex) || ((mFrame - (*it)->getLastUsedFrame()) < PIN_FRAMES))
+				continue;
 			// It may be already in the loader queue. In this case it wouldn't have been using
 			// any VRAM yet but it will be. Remove it from the loader queue
 			mLoader->remove(*it);
-			size = TextureResource::getTotalMemUsage();
+			if (!(*it)->isLoaded())
+				continue;
+			const size_t usage = (*it)->getVRAMUsage();
+			size -= (usage < size) ? usage : size;
+			(*it)->releaseVRAM();
+			(*it)->releaseRAM();
+			++mStats.evictions;
 		}
 	}
 	if (!block)
-		mLoader->load(tex);
+		mLoader->load(tex, priority);
 	else
 		tex->load();
 }
 
-TextureLoader::TextureLoader() : mExit(false)
+void TextureDataManager::prefetch(const TextureResource* key, TextureLoader::Priority priority)
+{
+	// Unlike get() it stays where it is in the list
+	auto it = mTextureLookup.find(key);
+	if (it != mTextureLookup.cend())
+		load(*(*it).second, false, priority);
+}
+
+TextureLoader::TextureLoader() : mMaxPreloads(0), mExit(false)
 {
-	mThread = new std::thread(&TextureLoader::threadProc, this);
 }
 
 TextureLoader::~TextureLoader()
 {
-	// Just abort any waiting texture
-	mTextureDataQ.clear();
-	mTextureDataLookup.clear();
+	{
+		// Just abort any waiting texture
+		std::unique_lock<std::mutex> lock(mMutex);
+		for (int i = PRIORITY_VISIBLE; i < PRIORITY_COUNT; ++i)
+			mTextureDataQ[i].clear();
+		mTextureDataLookup.clear();
 
-	// Exit the thread
-	mExit = true;
-	mEvent.notify_one();
-	mThread->join();
-	delete mThread;
+		// Exit the threads, the textures they're loading are finished first
+		mExit = true;
+	}
+	mEvent.notify_all();
+	for (auto& thread : mThreads)
+		thread.join();
+}
+
+void TextureLoader::startThreads()
+{
+	// Started with the first texture instead of the constructor, the settings aren't loaded yet when that runs
+	int threads = Settings::getInstance()->getInt("TextureLoaderThreads");
+	if (threads <= 0)
+	{
+		const int cores = (int)std::thread::hardware_concurrency();
+		threads = (cores > 1) ? (cores - 1) : 1;
+	}
+	if (threads > MAX_THREADS)
+		threads = MAX_THREADS;
+
+	// every thread holds a decoded image while it works
+	const bool lowMemory = Settings::getInstance()->getBool("LowMemory");
+	if (lowMemory)
+		threads = 1;
+	mMaxPreloads = lowMemory ? LOW_MEMORY_PRELOADS : 0;
+
+	for (int i = 0; i < threads; ++i)
+		mThreads.push_back(std::thread(&TextureLoader::threadProc, this));
 }
 
 void TextureLoader::threadProc()
 {
-	while (!mExit)
+	std::unique_lock<std::mutex> lock(mMutex);
+	while (true)
 	{
+		// Wait until there is something in the queue
+		mEvent.wait(lock, [this] { return mExit || !isQueueEmpty(); });
+		if (mExit)
+			break;
+
+		expireRequests();
+
+		// Take the most urgent request
 		std::shared_ptr<TextureData> textureData;
+		for (int i = PRIORITY_VISIBLE; !textureData && (i < PRIORITY_COUNT); ++i)
 		{
-			// Wait for an event to say there is something in the queue
-			std::unique_lock<std::mutex> lock(mMutex);
-			mEvent.wait(lock);
-			if (!mTextureDataQ.empty())
+			if (!mTextureDataQ[i].empty())
 			{
-				textureData = mTextureDataQ.front();
-				mTextureDataQ.pop_front();
-				mTextureDataLookup.erase(mTextureDataLookup.find(textureData.get()));
+				textureData = mTextureDataQ[i].front().textureData;
+				mTextureDataQ[i].pop_front();
 			}
 		}
-		// Queue has been released here but we might have a texture to process
-		while (textureData)
-		{
-			textureData->load();
+		mTextureDataLookup.erase(mTextureDataLookup.find(textureData.get()));
+		// Asking for it again meanwhile mustn't have another thread load it too
+		mTextureDataLoading.insert(textureData.get());
 
-			// See if there is another item in the queue
-			textureData = nullptr;
-			std::unique_lock<std::mutex> lock(mMutex);
-			if (!mTextureDataQ.empty())
-			{
-				textureData = mTextureDataQ.front();
-				mTextureDataQ.pop_front();
-				mTextureDataLookup.erase(mTextureDataLookup.find(textureData.get()));
-			}
+		// Queue has been released here while the texture is being loaded
+		lock.unlock();
+		textureData->load();
+		textureData->uploadInBackground();
+
+		// the texture can be shown right away instead of with the next frame that happens to be drawn
+		FrameScheduler::wakeUp();
+
+		lock.lock();
+		mTextureDataLoading.erase(textureData.get());
+
+		// It may be the last reference when the texture was removed meanwhile, don't delete it with the queue locked
+		lock.unlock();
+		textureData = nullptr;
+		lock.lock();
+	}
+}
+
+void TextureLoader::expireRequests()
+{
+	const unsigned int now = SDL_GetTicks();
+
+	for (int i = PRIORITY_VISIBLE; i < PRIORITY_PRELOAD; ++i)
+	{
+		RequestList& queue = mTextureDataQ[i];
+		RequestList& preload = mTextureDataQ[PRIORITY_PRELOAD];
+
+		// Every request goes to the front, so the oldest ones are at the back
+		while (!queue.empty() && ((int)(now - queue.back().deadline) > 0))
+		{
+			auto request = std::prev(queue.end());
+			mTextureDataLookup[request->textureData.get()].first = PRIORITY_PRELOAD;
+			// The iterator in the lookup stays valid
+			preload.splice(preload.end(), queue, request);
 		}
 	}
 }
 
-void TextureLoader::load(std::shared_ptr<TextureData> textureData)
+void TextureLoader::trimPreloads(std::vector<std::shared_ptr<TextureData>>& dropped)
+{
+	RequestList& preload = mTextureDataQ[PRIORITY_PRELOAD];
+
+	// the oldest ones are at the back, they're the least likely to still be wanted
+	while (mMaxPreloads && (preload.size() > mMaxPreloads))
+	{
+		dropped.push_back(preload.back().textureData);
+		mTextureDataLookup.erase(preload.back().textureData.get());
+		preload.pop_back();
+	}
+}
+
+bool TextureLoader::isQueueEmpty() const
+{
+	for (int i = PRIORITY_VISIBLE; i < PRIORITY_COUNT; ++i)
+	{
+		if (!mTextureDataQ[i].empty())
+			return false;
+	}
+	return true;
+}
+
+void TextureLoader::load(std::shared_ptr<TextureData> textureData, Priority priority)
 {
+	// released once the queue is unlocked, they may be the last references
+	std::vector<std::shared_ptr<TextureData>> dropped;
+
 	// Make sure it's not already loaded
 	if (!textureData->isLoaded())
 	{
 		std::unique_lock<std::mutex> lock(mMutex);
-		// Remove it from the queue if it is already there
+		if (mThreads.empty())
+			startThreads();
+
+		// It will be loaded in a moment
+		if (mTextureDataLoading.find(textureData.get()) != mTextureDataLoading.cend())
+			return;
+
+		// Remove it from the queue if it is already there, unless it's already waiting for a more urgent reason
 		auto td = mTextureDataLookup.find(textureData.get());
 		if (td != mTextureDataLookup.cend())
 		{
-			mTextureDataQ.erase((*td).second);
+			if (((*td).second.first < priority) && ((int)(SDL_GetTicks() - (*(*td).second.second).deadline) <= 0))
+				return;
+
+			mTextureDataQ[(*td).second.first].erase((*td).second.second);
 			mTextureDataLookup.erase(td);
 		}
 
 		// Put it on the start of the queue as we want the newly requested textures to load first
-		mTextureDataQ.push_front(textureData);
-		mTextureDataLookup[textureData.get()] = mTextureDataQ.cbegin();
+		const Request request = { textureData, SDL_GetTicks() + REQUEST_TIMEOUT };
+		mTextureDataQ[priority].push_front(request);
+		mTextureDataLookup[textureData.get()] = std::make_pair(priority, mTextureDataQ[priority].begin());
+		trimPreloads(dropped);
 		mEvent.notify_one();
 	}
 }
@@ -212,7 +411,7 @@ void TextureLoader::remove(std::shared_ptr<TextureData> textureData)
 	auto td = mTextureDataLookup.find(textureData.get());
 	if (td != mTextureDataLookup.cend())
 	{
-		mTextureDataQ.erase((*td).second);
+		mTextureDataQ[(*td).second.first].erase((*td).second.second);
 		mTextureDataLookup.erase(td);
 	}
 }
@@ -223,9 +422,16 @@ size_t TextureLoader::getQueueSize()
 	// the queue are loaded
 	size_t mem = 0;
 	std::unique_lock<std::mutex> lock(mMutex);
-	for (auto tex : mTextureDataQ)
+	for (int i = PRIORITY_VISIBLE; i < PRIORITY_COUNT; ++i)
 	{
-		mem += tex->width() * tex->height() * 4;
+		for (auto& request : mTextureDataQ[i])
+			mem += request.textureData->width() * request.textureData->height() * 4;
 	}
 	return mem;
 }
+
+size_t TextureLoader::getQueueLength()
+{
+	std::unique_lock<std::mutex> lock(mMutex);
+	return mTextureDataLookup.size();
+}
@@ -7,30 +7,65 @@
 #include <map>
 #include <memory>
 #include <mutex>
+#include <set>
 #include <thread>
+#include <vector>
 
 class TextureData;
 class TextureResource;
 
+// Decodes textures on a pool of threads. The pool size is the "TextureLoaderThreads" setting, 0 uses all cores but
+// the one drawing. Textures on screen are decoded first, then the ones likely shown next, then the rest, and the most
+// recently requested one first within each of them. Textures that are drawn ask again every frame, a request that
+// isn't renewed within REQUEST_TIMEOUT ms falls back to PRIORITY_PRELOAD, like a grid tile that was scrolled away
 class TextureLoader
 {
 public:
+	enum Priority
+	{
+		PRIORITY_VISIBLE = 0,
+		PRIORITY_NEXT    = 1,
+		PRIORITY_PRELOAD = 2,
+		PRIORITY_COUNT   = 3
+	};
+
 	TextureLoader();
 	~TextureLoader();
 
-	void load(std::shared_ptr<TextureData> textureData);
+	void load(std::shared_ptr<TextureData> textureData, Priority priority = PRIORITY_VISIBLE);
 	void remove(std::shared_ptr<TextureData> textureData);
 
 	size_t getQueueSize();
+	size_t getQueueLength(); // textures waiting to be loaded
+
+	// More threads only hold more decoded images in memory at once without decoding any faster
+	static const int MAX_THREADS = 4;
+	static const unsigned int REQUEST_TIMEOUT = 500;
+	// preloads kept waiting with LowMemory, each holds on to its texture until it's loaded or dropped
+	static const size_t LOW_MEMORY_PRELOADS = 8;
 
 private:
-	void processQueue();
+	struct Request
+	{
+		std::shared_ptr<TextureData> textureData;
+		unsigned int                 deadline;
+	};
+	typedef std::list<Request> RequestList;
+
+	void startThreads();
 	void threadProc();
 
-	std::list<std::shared_ptr<TextureData> > 										mTextureDataQ;
-	std::map<TextureData*, std::list<std::shared_ptr<TextureData> >::const_iterator > 	mTextureDataLookup;
+	// These expect mMutex to be locked
+	void expireRequests();
+	bool isQueueEmpty() const;
+	void trimPreloads(std::vector<std::shared_ptr<TextureData>>& dropped);
 
-	std::thread*				mThread;
+	RequestList																	mTextureDataQ[PRIORITY_COUNT];
+	std::map<TextureData*, std::pair<Priority, RequestList::iterator> >			mTextureDataLookup;
+	std::set<TextureData*>														mTextureDataLoading;
+
+	std::vector<std::thread>	mThreads;
+	size_t						mMaxPreloads; // 0 == no limit
 	std::mutex					mMutex;
 	std::condition_variable		mEvent;
 	bool 						mExit;
@@ -53,6 +88,16 @@ private:
 class TextureDataManager
 {
 public:
+	struct Stats
+	{
+		size_t hits;          // textures drawn from VRAM
+		size_t uploads;       // textures drawn right after they were uploaded
+		size_t misses;        // textures drawn blank because they weren't loaded yet
+		size_t evictions;     // textures freed to stay within "MaxVRAM"
+		size_t deferrals;     // textures drawn blank because the upload budget of the frame was used up
+		size_t uploadedBytes;
+	};
+
 	TextureDataManager();
 	~TextureDataManager();
 
@@ -70,11 +115,29 @@ public:
 	size_t	getTotalSize();
 	// Get the total size of all committed textures (in VRAM) in bytes
 	size_t	getCommittedSize();
+	// Get the total size of the pixels of all textures that are held in RAM in bytes
+	size_t	getRAMSize();
 	// Get the total size of all load-pending textures in the queue - these will
 	// be committed to VRAM as the queue is processed
 	size_t  getQueueSize();
+	// The number of textures in the queue
+	size_t  getQueueLength();
 	// Load a texture, freeing resources as necessary to make space
-	void load(std::shared_ptr<TextureData> tex, bool block = false);
+	void load(std::shared_ptr<TextureData> tex, bool block = false, TextureLoader::Priority priority = TextureLoader::PRIORITY_VISIBLE);
+	// Queue a texture that isn't drawn yet. It never frees textures to make space and doesn't count as being used
+	void prefetch(const TextureResource* key, TextureLoader::Priority priority);
+
+	// Called after each frame. Textures drawn within the last PIN_FRAMES frames make up the view on screen,
+	// they're never freed to make space since they'd have to be loaded again right away
+	void frameDone();
+	// Whether tex may be uploaded in this frame. Only "TextureUploadBudget" KiB are uploaded per frame, the rest waits
+	// for the next ones. What waited and is still drawn goes first, textures only drawn for a frame or two while
+	// scrolling past don't take up the budget at all. At least one texture is uploaded every frame
+	bool takeUploadBudget(const std::shared_ptr<TextureData>& tex);
+	// The counters since the last call
+	Stats takeStats();
+
+	static const unsigned int PIN_FRAMES = 2;
 
 private:
 
@@ -82,6 +145,12 @@ private:
 	std::map<const TextureResource*, std::list<std::shared_ptr<TextureData> >::const_iterator > 	mTextureLookup;
 	std::shared_ptr<TextureData>															mBlank;
 	TextureLoader*																			mLoader;
+	Stats																					mStats;
+	unsigned int																			mFrame;
+	std::map<const TextureData*, size_t>													mDeferred;     // bytes of the textures that waited in the last frame
+	std::map<const TextureData*, size_t>													mDeferredNext; // the ones that wait in this frame
+	size_t																					mUploadedBytes;
+	size_t																					mReservedBytes; // kept for what's in mDeferred
 };
 
 #endif // ES_CORE_RESOURCES_TEXTURE_DATA_MANAGER_H
@@ -1,13 +1,30 @@
 #include "resources/TextureResource.h"
 
 #include "utils/FileSystemUtil.h"
+#include "utils/HashUtil.h"
+#include "resources/PixelBufferPool.h"
 #include "resources/TextureData.h"
+#include "Settings.h"
+
+static Setting<bool> sKeepImagesDuringGames("KeepImagesDuringGames");
+static Setting<bool> sDeduplicateImages("DeduplicateImages");
+static Setting<bool> sTrimMemoryDuringGames("TrimMemoryDuringGames");
 
 TextureDataManager		TextureResource::sTextureDataManager;
 std::map< TextureResource::TextureKeyType, std::weak_ptr<TextureResource> > TextureResource::sTextureMap;
 std::set<TextureResource*> 	TextureResource::sAllTextures;
+std::multimap< TextureResource::ContentKeyType, TextureResource::ContentEntry > TextureResource::sContentMap;
+
+static std::string hashContent(const std::string& path)
+{
+	Utils::Hash::Hasher hasher;
+	if (!Utils::Hash::hashFile(path, hasher))
+		return "";
+	hasher.finish();
+	return hasher.getSHA1();
+}
 
-TextureResource::TextureResource(const std::string& path, bool tile, bool dynamic) : mTextureData(nullptr), mSize(0.0f, 0.0f), mSourceSize(0.0f, 0.0f), mForceLoad(false)
+TextureResource::TextureResource(const std::string& path, bool tile, bool dynamic, const Vector2f& displaySize, bool fitInside, bool async) : mTextureData(nullptr), mSize(0.0f, 0.0f), mSourceSize(0.0f, 0.0f), mForceLoad(false)
 {
 	// Create a texture data object for this texture
 	if (!path.empty())
@@ -19,14 +36,17 @@ TextureResource::TextureResource(const std::string& path, bool tile, bool dynami
 		{
 			data = sTextureDataManager.add(this, tile);
 			data->initFromPath(path);
-			// Force the texture manager to load it using a blocking load
-			sTextureDataManager.load(data, true);
+			data->setDisplaySize(displaySize.x(), displaySize.y(), fitInside);
+			// Force the texture manager to load it using a blocking load, unless its size is all that's needed for now
+			if (!async || !data->loadSize())
+				sTextureDataManager.load(data, true);
 		}
 		else
 		{
 			mTextureData = std::shared_ptr<TextureData>(new TextureData(tile));
 			data = mTextureData;
 			data->initFromPath(path);
+			data->setDisplaySize(displaySize.x(), displaySize.y(), fitInside);
 			// Load it so we can read the width/height
 			data->load();
 		}
@@ -89,6 +109,8 @@ bool TextureResource::isTiled() const
 
 bool TextureResource::bind()
 {
+	markUsed();
+
 	if (mTextureData != nullptr)
 	{
 		mTextureData->uploadAndBind();
@@ -100,14 +122,14 @@ bool TextureResource::bind()
 	}
 }
 
-std::shared_ptr<TextureResource> TextureResource::get(const std::string& path, bool tile, bool forceLoad, bool dynamic)
+std::shared_ptr<TextureResource> TextureResource::get(const std::string& path, bool tile, bool forceLoad, bool dynamic, const Vector2f& displaySize, bool fitInside, bool async)
 {
 	std::shared_ptr<ResourceManager>& rm = ResourceManager::getInstance();
 
 	const std::string canonicalPath = Utils::FileSystem::getCanonicalPath(path);
 	if(canonicalPath.empty())
 	{
-		std::shared_ptr<TextureResource> tex(new TextureResource("", tile, false));
+		std::shared_ptr<TextureResource> tex(new TextureResource("", tile, false, Vector2f::Zero(), false, false));
 		rm->addReloadable(tex); //make sure we get properly deinitialized even though we do nothing on reinitialization
 		return tex;
 	}
@@ -117,19 +139,42 @@ std::shared_ptr<TextureResource> TextureResource::get(const std::string& path, b
 	if(foundTexture != sTextureMap.cend())
 	{
 		if(!foundTexture->second.expired())
-			return foundTexture->second.lock();
+		{
+			std::shared_ptr<TextureResource> tex = foundTexture->second.lock();
+			tex->setDisplaySize(displaySize, fitInside);
+			return tex;
+		}
+	}
+
+	// is it an SVG? We don't share SVGs because 2 svgs might be rasterized at different sizes
+	const bool svg = (key.first.substr(key.first.size() - 4, std::string::npos) == ".svg");
+	const bool deduplicate = !svg && dynamic && sDeduplicateImages.get();
+
+	// the same image under another path
+	std::string hash;
+	if (deduplicate)
+	{
+		std::shared_ptr<TextureResource> tex = findContent(key.first, tile, hash);
+		if (tex != nullptr)
+		{
+			sTextureMap[key] = std::weak_ptr<TextureResource>(tex);
+			tex->setDisplaySize(displaySize, fitInside);
+			return tex;
+		}
 	}
 
 	// need to create it
 	std::shared_ptr<TextureResource> tex;
-	tex = std::shared_ptr<TextureResource>(new TextureResource(key.first, tile, dynamic));
-	std::shared_ptr<TextureData> data = sTextureDataManager.get(tex.get());
+	tex = std::shared_ptr<TextureResource>(new TextureResource(key.first, tile, dynamic, displaySize, fitInside, async));
+	std::shared_ptr<TextureData> data = sTextureDataManager.get(tex.get(), false);
 
-	// is it an SVG?
-	if(key.first.substr(key.first.size() - 4, std::string::npos) != ".svg")
-	{
-		// Probably not. Add it to our map. We don't add SVGs because 2 svgs might be rasterized at different sizes
+	if (!svg)
 		sTextureMap[key] = std::weak_ptr<TextureResource>(tex);
+
+	if (deduplicate)
+	{
+		const ContentEntry entry = { key.first, hash, std::weak_ptr<TextureResource>(tex) };
+		sContentMap.insert(std::make_pair(ContentKeyType((size_t)Utils::FileSystem::getFileSize(key.first), tile), entry));
 	}
 
 	// Add it to the reloadable list
@@ -145,6 +190,33 @@ std::shared_ptr<TextureResource> TextureResource::get(const std::string& path, b
 	return tex;
 }
 
+std::shared_ptr<TextureResource> TextureResource::findContent(const std::string& path, bool tile, std::string& hash)
+{
+	const auto range = sContentMap.equal_range(ContentKeyType((size_t)Utils::FileSystem::getFileSize(path), tile));
+	for (auto it = range.first; it != range.second; )
+	{
+		std::shared_ptr<TextureResource> tex = it->second.texture.lock();
+		if (tex == nullptr)
+		{
+			it = sContentMap.erase(it);
+			continue;
+		}
+
+		// both are only read once there's something of the same size to compare them to
+		if (hash.empty())
+			hash = hashContent(path);
+		if (it->second.hash.empty())
+			it->second.hash = hashContent(it->second.path);
+
+		if (hash.empty())
+			return nullptr;
+		if (hash == it->second.hash)
+			return tex;
+		++it;
+	}
+	return nullptr;
+}
+
 // For scalable source images in textures we want to set the resolution to rasterize at
 void TextureResource::rasterizeAt(size_t width, size_t height)
 {
@@ -152,13 +224,42 @@ void TextureResource::rasterizeAt(size_t width, size_t height)
 	if (mTextureData != nullptr)
 		data = mTextureData;
 	else
-		data = sTextureDataManager.get(this);
+		data = sTextureDataManager.get(this, false); // it's loaded once it's drawn
 	mSourceSize = Vector2f((float)width, (float)height);
 	data->setSourceSize((float)width, (float)height);
 	if (mForceLoad || (mTextureData != nullptr))
 		data->load();
 }
 
+void TextureResource::setDisplaySize(const Vector2f& displaySize, bool fitInside)
+{
+	std::shared_ptr<TextureData> data;
+	if (mTextureData != nullptr)
+		data = mTextureData;
+	else
+		data = sTextureDataManager.get(this, false);
+
+	if ((data == nullptr) || !data->setDisplaySize(displaySize.x(), displaySize.y(), fitInside))
+		return;
+
+	// Reload it right away like a new texture would be, so it's never shown blank in between
+	data->releaseVRAM();
+	data->releaseRAM();
+	if (mTextureData != nullptr)
+		data->load();
+	else
+		sTextureDataManager.load(data, true);
+
+	mSize = Vector2i((int)data->width(), (int)data->height());
+}
+
+void TextureResource::prefetch(TextureLoader::Priority priority)
+{
+	// Textures that aren't dynamic are always loaded
+	if (mTextureData == nullptr)
+		sTextureDataManager.prefetch(this, priority);
+}
+
 Vector2f TextureResource::getSourceImageSize() const
 {
 	return mSourceSize;
@@ -199,6 +300,36 @@ size_t TextureResource::getTotalTextureSize()
 	return total;
 }
 
+size_t TextureResource::getTotalRAMUsage()
+{
+	size_t total = 0;
+	// Count up all textures that manage their own texture data
+	for (auto tex : sAllTextures)
+	{
+		if (tex->mTextureData != nullptr)
+			total += tex->mTextureData->getRAMUsage();
+	}
+	// Now the textures of the manager and the buffers kept for the next images
+	total += sTextureDataManager.getRAMSize();
+	total += PixelBufferPool::getPooledSize();
+	return total;
+}
+
+void TextureResource::frameDone()
+{
+	sTextureDataManager.frameDone();
+}
+
+TextureDataManager::Stats TextureResource::takeStats()
+{
+	return sTextureDataManager.takeStats();
+}
+
+size_t TextureResource::getLoadQueueLength()
+{
+	return sTextureDataManager.getQueueLength();
+}
+
 bool TextureResource::unload()
 {
 	// Release the texture's resources
@@ -211,7 +342,11 @@ bool TextureResource::unload()
 	if (data != nullptr && data->isLoaded())
 	{
 		data->releaseVRAM();
-		data->releaseRAM();
+
+		// decoded images kept in RAM are only uploaded again once they're drawn, so coming back from a game shows
+		// the current view without reading and decoding every image of the theme again
+		if (!sKeepImagesDuringGames.get() || sTrimMemoryDuringGames.get())
+			data->releaseRAM();
 
 		return true;
 	}
@@ -16,7 +16,9 @@ class TextureData;
 class TextureResource : public IReloadable
 {
 public:
-	static std::shared_ptr<TextureResource> get(const std::string& path, bool tile = false, bool forceLoad = false, bool dynamic = true);
+	// displaySize lets images that are only shown smaller be kept at a reduced size, fitInside when they're scaled to fit into it.
+	// async only reads the size of a dynamic texture, the image is loaded in the background once it's drawn or prefetched
+	static std::shared_ptr<TextureResource> get(const std::string& path, bool tile = false, bool forceLoad = false, bool dynamic = true, const Vector2f& displaySize = Vector2f::Zero(), bool fitInside = false, bool async = false);
 	void initFromPixels(const unsigned char* dataRGBA, size_t width, size_t height);
 	virtual void initFromMemory(const char* file, size_t length);
 
@@ -24,6 +26,9 @@ public:
 	void rasterizeAt(size_t width, size_t height);
 	Vector2f getSourceImageSize() const;
 
+	// Loads a texture that isn't drawn yet in the background, without holding up the ones on screen
+	void prefetch(TextureLoader::Priority priority);
+
 	virtual ~TextureResource();
 
 	bool isInitialized() const;
@@ -34,13 +39,21 @@ public:
 
 	static size_t getTotalMemUsage(); // returns an approximation of total VRAM used by textures (in bytes)
 	static size_t getTotalTextureSize(); // returns the number of bytes that would be used if all textures were in memory
+	static size_t getTotalRAMUsage(); // returns the RAM held by texture pixels and the pooled decode buffers (in bytes)
+	static void frameDone(); // marks the end of a frame, the textures drawn in it are kept in VRAM for the next one
+	static TextureDataManager::Stats takeStats(); // returns the texture cache counters since the last call
+	static size_t getLoadQueueLength(); // returns the number of textures waiting for the loader threads
 
 protected:
-	TextureResource(const std::string& path, bool tile, bool dynamic);
+	TextureResource(const std::string& path, bool tile, bool dynamic, const Vector2f& displaySize, bool fitInside, bool async);
 	virtual bool unload();
 	virtual void reload();
+	virtual bool canReloadInBackground() const { return true; } // only decodes, the upload waits for the next bind()
 
 private:
+	// Reloads the image at a larger size when it's also shown larger than it was loaded for
+	void setDisplaySize(const Vector2f& displaySize, bool fitInside);
+
 	// mTextureData is used for textures that are not loaded from a file - these ones
 	// are permanently allocated and cannot be loaded and unloaded based on resources
 	std::shared_ptr<TextureData>		mTextureData;
@@ -54,6 +67,19 @@ private:
 
 	typedef std::pair<std::string, bool> TextureKeyType;
 	static std::map< TextureKeyType, std::weak_ptr<TextureResource> > sTextureMap; // map of textures, used to prevent duplicate textures
+
+	// With "DeduplicateImages", identical files at different paths share a texture, like the same boxart copied for
+	// every region of a game. Only files of the same size can be identical, so a file is hashed once another one of its
+	// size shows up, until then it costs nothing
+	struct ContentEntry
+	{
+		std::string						path;
+		std::string						hash; // empty until it's compared to another file
+		std::weak_ptr<TextureResource>	texture;
+	};
+	typedef std::pair<size_t, bool> ContentKeyType; // file size and tile
+	static std::shared_ptr<TextureResource> findContent(const std::string& path, bool tile, std::string& hash);
+	static std::multimap< ContentKeyType, ContentEntry > sContentMap;
 	static std::set<TextureResource*> 	sAllTextures;	// Set of all textures, used for memory management
 };
 
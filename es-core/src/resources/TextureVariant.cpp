@@ -0,0 +1,303 @@
+#include "resources/TextureVariant.h"
+
+#include "resources/PixelBufferPool.h"
+#include "resources/ResourceManager.h"
+#include "resources/TextureResource.h"
+#include "utils/BinaryUtil.h"
+#include "utils/FileSystemUtil.h"
+#include "ImageIO.h"
+#include "Log.h"
+#include "Settings.h"
+#include <stdint.h>
+#include <string.h>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <iomanip>
+#include <sstream>
+#include <thread>
+
+static const char     CACHE_MAGIC[4] = { 'E', 'S', 'T', 'V' };
+static const uint32_t CACHE_VERSION  = 1;
+
+struct CacheHeader
+{
+	uint32_t sourceWidth;
+	uint32_t sourceHeight;
+	uint32_t level;
+	uint32_t width;
+	uint32_t height;
+};
+
+struct GenerateRequest
+{
+	std::string path;
+	float       displayWidth;
+	float       displayHeight;
+	bool        fitInside;
+};
+
+// generate() requests, handled one at a time
+static std::deque<GenerateRequest>     sRequests;
+static std::thread             sThread;
+static std::mutex              sMutex;
+static std::condition_variable sEvent;
+static std::atomic<bool>       sExit(false);
+
+// Leaves reader at the encoded image, false when the copy is for another image with the same hash or a changed image
+static bool readHeader(Utils::Binary::Reader& reader, const std::string& path, CacheHeader& header)
+{
+	char magic[4];
+	uint32_t version;
+	std::string cachedPath;
+	int64_t cachedSize;
+	int64_t cachedTime;
+
+	if (!reader.read(magic, sizeof(magic)) || memcmp(magic, CACHE_MAGIC, sizeof(magic)) ||
+		!reader.read(version) || (version != CACHE_VERSION) ||
+		!reader.readString(cachedPath) || !reader.read(cachedSize) || !reader.read(cachedTime) ||
+		!reader.read(header.sourceWidth) || !reader.read(header.sourceHeight) || !reader.read(header.level) ||
+		!reader.read(header.width) || !reader.read(header.height))
+		return false;
+
+	return (cachedPath == path) &&
+		(cachedSize == Utils::FileSystem::getFileSize(path)) && (cachedTime == (int64_t)Utils::FileSystem::getModifiedTime(path));
+}
+
+bool TextureVariant::isEnabled()
+{
+	return Settings::getInstance()->getBool("ReduceImages");
+}
+
+int TextureVariant::getLevel(size_t sourceWidth, size_t sourceHeight, float displayWidth, float displayHeight, bool fitInside)
+{
+	if (!isEnabled() || (sourceWidth == 0) || (sourceHeight == 0))
+		return 0;
+
+	const float scaleX = (displayWidth > 0.0f) ? (displayWidth / sourceWidth) : 0.0f;
+	const float scaleY = (displayHeight > 0.0f) ? (displayHeight / sourceHeight) : 0.0f;
+	float scale;
+
+	if ((scaleX > 0.0f) && (scaleY > 0.0f))
+		scale = fitInside ? ((scaleX < scaleY) ? scaleX : scaleY) : ((scaleX > scaleY) ? scaleX : scaleY);
+	else
+		scale = (scaleX > scaleY) ? scaleX : scaleY;
+
+	// without a display size the image could be shown at any size
+	if (scale <= 0.0f)
+		return 0;
+
+	int level = 0;
+	while ((level < MAX_LEVEL) && ((scale * (2 << level)) <= 1.0f) && ((sourceWidth >> (level + 1)) > 0) && ((sourceHeight >> (level + 1)) > 0))
+		++level;
+
+	return level;
+}
+
+void TextureVariant::reduce(std::vector<unsigned char>& dataRGBA, size_t& width, size_t& height, int level)
+{
+	for (int i = 0; (i < level) && (width > 1) && (height > 1); ++i)
+	{
+		const size_t reducedWidth = width / 2;
+		const size_t reducedHeight = height / 2;
+		std::vector<unsigned char> reduced;
+		PixelBufferPool::acquire(reduced, reducedWidth * reducedHeight * 4);
+
+		for (size_t y = 0; y < reducedHeight; ++y)
+		{
+			const unsigned char* row0 = dataRGBA.data() + ((y * 2) * width * 4);
+			const unsigned char* row1 = row0 + (width * 4);
+			unsigned char* out = reduced.data() + (y * reducedWidth * 4);
+
+			for (size_t x = 0; x < reducedWidth; ++x)
+			{
+				const unsigned char* pixels[4] = { row0 + (x * 8), row0 + (x * 8) + 4, row1 + (x * 8), row1 + (x * 8) + 4 };
+				const unsigned int alpha = pixels[0][3] + pixels[1][3] + pixels[2][3] + pixels[3][3];
+
+				for (int c = 0; c < 3; ++c)
+				{
+					if (alpha != 0)
+						out[c] = (unsigned char)(((pixels[0][c] * pixels[0][3]) + (pixels[1][c] * pixels[1][3]) + (pixels[2][c] * pixels[2][3]) + (pixels[3][c] * pixels[3][3]) + (alpha / 2)) / alpha);
+					else
+						out[c] = (unsigned char)((pixels[0][c] + pixels[1][c] + pixels[2][c] + pixels[3][c] + 2) / 4);
+				}
+
+				out[3] = (unsigned char)((alpha + 2) / 4);
+				out += 4;
+			}
+		}
+
+		dataRGBA.swap(reduced);
+		PixelBufferPool::release(reduced);
+		width = reducedWidth;
+		height = reducedHeight;
+	}
+}
+
+bool TextureVariant::loadCache(const std::string& path, size_t& sourceWidth, size_t& sourceHeight, int& level, size_t& width, size_t& height, std::vector<unsigned char>& dataRGBA)
+{
+	std::string buffer;
+
+	if (!Utils::Binary::loadFile(getCachePath(path), buffer))
+		return false;
+
+	Utils::Binary::Reader reader(buffer);
+	CacheHeader header;
+
+	if (!readHeader(reader, path, header))
+		return false;
+
+	std::string image(reader.getRemaining(), '\0');
+	reader.read(&image[0], image.size());
+
+	size_t imageWidth, imageHeight;
+	std::vector<unsigned char> imageRGBA;
+
+	if (!ImageIO::loadFromMemoryRGBA32((const unsigned char*)image.data(), image.size(), imageRGBA, imageWidth, imageHeight) ||
+		(imageWidth != header.width) || (imageHeight != header.height))
+	{
+		PixelBufferPool::release(imageRGBA);
+		return false;
+	}
+
+	dataRGBA.swap(imageRGBA);
+	sourceWidth = header.sourceWidth;
+	sourceHeight = header.sourceHeight;
+	level = (int)header.level;
+	width = header.width;
+	height = header.height;
+
+	return true;
+}
+
+void TextureVariant::saveCache(const std::string& path, size_t sourceWidth, size_t sourceHeight, int level, size_t width, size_t height, const std::vector<unsigned char>& dataRGBA)
+{
+	const std::vector<unsigned char> image = ImageIO::saveToMemory(dataRGBA.data(), width, height);
+
+	if (image.empty())
+		return;
+
+	Utils::Binary::Writer writer;
+
+	writer.write(CACHE_MAGIC, sizeof(CACHE_MAGIC));
+	writer.write(CACHE_VERSION);
+	writer.writeString(path);
+	writer.write((int64_t)Utils::FileSystem::getFileSize(path));
+	writer.write((int64_t)Utils::FileSystem::getModifiedTime(path));
+	writer.write((uint32_t)sourceWidth);
+	writer.write((uint32_t)sourceHeight);
+	writer.write((uint32_t)level);
+	writer.write((uint32_t)width);
+	writer.write((uint32_t)height);
+	writer.write(image.data(), image.size());
+
+	if (!Utils::Binary::saveFile(getCachePath(path), writer.getBuffer()))
+		LOG(LogWarning) << "Could not save reduced copy of \"" << path << "\"";
+}
+
+void TextureVariant::generate(const std::string& path, float displayWidth, float displayHeight, bool fitInside)
+{
+	if (path.empty() || !isEnabled())
+		return;
+
+	std::unique_lock<std::mutex> lock(sMutex);
+	if (!sThread.joinable())
+	{
+		sExit = false;
+		sThread = std::thread(&TextureVariant::generateThread);
+	}
+
+	const GenerateRequest request = { path, displayWidth, displayHeight, fitInside };
+	sRequests.push_back(request);
+	sEvent.notify_one();
+}
+
+void TextureVariant::cancelGeneration()
+{
+	std::unique_lock<std::mutex> lock(sMutex);
+	sRequests.clear();
+}
+
+void TextureVariant::stopGeneration()
+{
+	{
+		std::unique_lock<std::mutex> lock(sMutex);
+		sRequests.clear();
+		sExit = true;
+		sEvent.notify_one();
+	}
+
+	if (sThread.joinable())
+		sThread.join();
+}
+
+void TextureVariant::generateThread()
+{
+	while (true)
+	{
+		GenerateRequest request;
+		{
+			std::unique_lock<std::mutex> lock(sMutex);
+			sEvent.wait(lock, [] { return sExit || !sRequests.empty(); });
+			if (sExit)
+				return;
+
+			request = sRequests.front();
+			sRequests.pop_front();
+		}
+
+		while (!sExit && (TextureResource::getLoadQueueLength() > 0))
+			std::this_thread::sleep_for(std::chrono::milliseconds(50));
+
+		if (!sExit)
+			generateCache(request.path, request.displayWidth, request.displayHeight, request.fitInside);
+	}
+}
+
+void TextureVariant::generateCache(const std::string& path, float displayWidth, float displayHeight, bool fitInside)
+{
+	size_t sourceWidth, sourceHeight;
+	if (!ImageIO::loadSizeFromFile(path, sourceWidth, sourceHeight))
+		return;
+
+	const int level = getLevel(sourceWidth, sourceHeight, displayWidth, displayHeight, fitInside);
+	if (level == 0)
+		return;
+
+	// the image was shown already or is queued twice
+	std::string buffer;
+	if (Utils::Binary::loadFile(getCachePath(path), buffer))
+	{
+		Utils::Binary::Reader reader(buffer);
+		CacheHeader header;
+
+		if (readHeader(reader, path, header) && (header.level == (uint32_t)level))
+			return;
+	}
+
+	const ResourceData data = ResourceManager::getInstance()->getFileData(path);
+	if (data.ptr == nullptr)
+		return;
+
+	std::vector<unsigned char> dataRGBA;
+	size_t width, height;
+	int decodedLevel;
+	if (!ImageIO::loadFromMemoryRGBA32(data.ptr.get(), data.length, [level](size_t, size_t) { return level; }, dataRGBA, sourceWidth, sourceHeight, width, height, decodedLevel))
+		return;
+
+	if (level > decodedLevel)
+		reduce(dataRGBA, width, height, level - decodedLevel);
+
+	saveCache(path, sourceWidth, sourceHeight, level, width, height, dataRGBA);
+	PixelBufferPool::release(dataRGBA);
+}
+
+std::string TextureVariant::getCachePath(const std::string& path)
+{
+	std::stringstream ss;
+	ss << std::hex << std::setw(16) << std::setfill('0') << (uint64_t)std::hash<std::string>()(path);
+
+	return Utils::FileSystem::getHomePath() + "/.emulationstation/reduced_images/" + ss.str() + ".img";
+}
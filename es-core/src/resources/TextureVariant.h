@@ -0,0 +1,46 @@
+#pragma once
+#ifndef ES_CORE_RESOURCES_TEXTURE_VARIANT_H
+#define ES_CORE_RESOURCES_TEXTURE_VARIANT_H
+
+#include <stddef.h>
+#include <string>
+#include <vector>
+
+// Keeps images that are only shown small, like boxart in a grid, at a reduced size in RAM and VRAM.
+// An image is halved level times, as long as it stays at least as large as it's shown. The reduced copy is kept on
+// disk next to the downloaded images, so the full image only gets decoded again once its file changes. Views can have
+// the copies written ahead of time by generate(), so the first scroll through a grid doesn't decode every image at
+// full size. Safe to use from the texture loader thread.
+class TextureVariant
+{
+public:
+	// Whether images get reduced at all
+	static bool isEnabled();
+
+	// How many times an image of sourceWidth x sourceHeight can be halved when it's shown at displayWidth x displayHeight.
+	// fitInside is for images scaled to fit into that size, the others cover it. A display size of 0 leaves that side out
+	static int getLevel(size_t sourceWidth, size_t sourceHeight, float displayWidth, float displayHeight, bool fitInside);
+
+	// Halves the image level times with a box filter weighted by alpha, so transparent pixels don't bleed into the edges
+	static void reduce(std::vector<unsigned char>& dataRGBA, size_t& width, size_t& height, int level);
+
+	// The cache is only used while the image at path keeps its size and modification time
+	static bool loadCache(const std::string& path, size_t& sourceWidth, size_t& sourceHeight, int& level, size_t& width, size_t& height, std::vector<unsigned char>& dataRGBA);
+	static void saveCache(const std::string& path, size_t sourceWidth, size_t sourceHeight, int level, size_t width, size_t height, const std::vector<unsigned char>& dataRGBA);
+
+	// Queues the reduced copy of the image at path for a background thread, which writes it unless a fitting one is
+	// there already. It waits while the texture loader has images to decode, those are on screen or about to be
+	static void generate(const std::string& path, float displayWidth, float displayHeight, bool fitInside);
+	static void cancelGeneration(); // drops the queued images, like when the view they were queued for changes
+	static void stopGeneration(); // also stops the thread, it's started again by the next generate()
+
+	// Images are never reduced to less than 1 / (2 ^ MAX_LEVEL) of their size
+	static const int MAX_LEVEL = 4;
+
+private:
+	static std::string getCachePath(const std::string& path);
+	static void generateThread();
+	static void generateCache(const std::string& path, float displayWidth, float displayHeight, bool fitInside);
+};
+
+#endif // ES_CORE_RESOURCES_TEXTURE_VARIANT_H
@@ -0,0 +1,264 @@
+#include "resources/VideoPreview.h"
+
+#include "utils/BinaryUtil.h"
+#include "utils/FileSystemUtil.h"
+#include "FrameScheduler.h"
+#include "ImageIO.h"
+#include "Log.h"
+#include "Settings.h"
+#include <stdint.h>
+#include <string.h>
+#include <functional>
+#include <iomanip>
+#include <sstream>
+
+static const char     CACHE_MAGIC[4] = { 'E', 'S', 'V', 'P' };
+static const uint32_t CACHE_VERSION  = 1;
+
+bool VideoPreview::isEnabled()
+{
+	return Settings::getInstance()->getBool("VideoPreviews");
+}
+
+std::shared_ptr<const VideoPreview::Data> VideoPreview::get(const std::string& path, bool& missing)
+{
+	VideoPreview& instance = getInstance();
+	std::unique_lock<std::mutex> lock(instance.mMutex);
+
+	missing = false;
+
+	for (auto it = instance.mLoaded.begin(); it != instance.mLoaded.end(); ++it)
+	{
+		if (it->path == path)
+		{
+			instance.mLoaded.splice(instance.mLoaded.begin(), instance.mLoaded, it);
+			return it->data;
+		}
+	}
+
+	if (instance.mMissing.find(path) != instance.mMissing.cend())
+	{
+		missing = true;
+		return nullptr;
+	}
+
+	if (instance.mQueued.insert(path).second)
+	{
+		instance.mLoadQueue.push_back(path);
+		instance.mEvent.notify_one();
+	}
+
+	return nullptr;
+}
+
+void VideoPreview::add(const std::string& path, const std::shared_ptr<const Data>& data)
+{
+	VideoPreview& instance = getInstance();
+
+	{
+		std::unique_lock<std::mutex> lock(instance.mMutex);
+		instance.keep(path, data);
+		instance.mSaveQueue.push_back({ path, data });
+	}
+	instance.mEvent.notify_one();
+}
+
+size_t VideoPreview::getLoadedSize()
+{
+	// the instance and its thread aren't made just to be measured
+	if(!isEnabled())
+		return 0;
+
+	VideoPreview& instance = getInstance();
+	std::unique_lock<std::mutex> lock(instance.mMutex);
+	std::set<const Data*> counted;
+	size_t total = 0;
+
+	// a preview that was just taken is both loaded and waiting to be saved
+	for(const std::list<Entry>* entries : { &instance.mLoaded, &instance.mSaveQueue })
+	{
+		for(auto it = entries->cbegin(); it != entries->cend(); it++)
+		{
+			if(!counted.insert(it->data.get()).second)
+				continue;
+
+			for(auto frame = it->data->frames.cbegin(); frame != it->data->frames.cend(); frame++)
+				total += frame->capacity();
+		}
+	}
+
+	return total;
+}
+
+VideoPreview::VideoPreview() : mExit(false)
+{
+	mThread = std::thread(&VideoPreview::threadProc, this);
+}
+
+VideoPreview::~VideoPreview()
+{
+	{
+		// previews still waiting to be saved are taken again the next time their videos play
+		std::unique_lock<std::mutex> lock(mMutex);
+		mLoadQueue.clear();
+		mSaveQueue.clear();
+		mExit = true;
+	}
+	mEvent.notify_all();
+	mThread.join();
+}
+
+VideoPreview& VideoPreview::getInstance()
+{
+	static VideoPreview instance;
+
+	return instance;
+}
+
+void VideoPreview::threadProc()
+{
+	std::unique_lock<std::mutex> lock(mMutex);
+	while (true)
+	{
+		mEvent.wait(lock, [this] { return mExit || !mLoadQueue.empty() || !mSaveQueue.empty(); });
+		if (mExit)
+			break;
+
+		// saving comes first, a preview being saved is already in RAM
+		if (!mSaveQueue.empty())
+		{
+			const Entry entry = mSaveQueue.front();
+			mSaveQueue.pop_front();
+
+			lock.unlock();
+			saveCache(entry.path, *entry.data);
+			lock.lock();
+			continue;
+		}
+
+		const std::string path = mLoadQueue.front();
+		mLoadQueue.pop_front();
+
+		lock.unlock();
+		std::shared_ptr<const Data> data = loadCache(path);
+		lock.lock();
+
+		mQueued.erase(path);
+		if (data)
+			keep(path, data);
+		else
+			mMissing.insert(path);
+
+		FrameScheduler::wakeUp();
+	}
+}
+
+void VideoPreview::keep(const std::string& path, const std::shared_ptr<const Data>& data)
+{
+	mMissing.erase(path);
+
+	for (auto it = mLoaded.begin(); it != mLoaded.end(); ++it)
+	{
+		if (it->path == path)
+		{
+			mLoaded.erase(it);
+			break;
+		}
+	}
+
+	mLoaded.push_front({ path, data });
+	while (mLoaded.size() > MAX_LOADED)
+		mLoaded.pop_back();
+}
+
+std::shared_ptr<const VideoPreview::Data> VideoPreview::loadCache(const std::string& path)
+{
+	std::string buffer;
+
+	if (!Utils::Binary::loadFile(getCachePath(path), buffer))
+		return nullptr;
+
+	Utils::Binary::Reader reader(buffer);
+	char magic[4];
+	uint32_t version;
+	std::string cachedPath;
+	int64_t cachedSize;
+	int64_t cachedTime;
+	uint32_t videoWidth;
+	uint32_t videoHeight;
+	uint32_t width;
+	uint32_t height;
+	uint32_t frameCount;
+
+	if (!reader.read(magic, sizeof(magic)) || memcmp(magic, CACHE_MAGIC, sizeof(magic)) ||
+		!reader.read(version) || (version != CACHE_VERSION) ||
+		!reader.readString(cachedPath) || !reader.read(cachedSize) || !reader.read(cachedTime) ||
+		!reader.read(videoWidth) || !reader.read(videoHeight) || !reader.read(width) || !reader.read(height) ||
+		!reader.read(frameCount) || (frameCount == 0) || (frameCount > FRAME_COUNT))
+		return nullptr;
+
+	// another video with the same hash or a changed video
+	if ((cachedPath != path) ||
+		(cachedSize != Utils::FileSystem::getFileSize(path)) || (cachedTime != (int64_t)Utils::FileSystem::getModifiedTime(path)))
+		return nullptr;
+
+	std::shared_ptr<Data> data = std::make_shared<Data>();
+	data->videoWidth = videoWidth;
+	data->videoHeight = videoHeight;
+	data->width = width;
+	data->height = height;
+	data->frames.resize(frameCount);
+
+	for (uint32_t i = 0; i < frameCount; ++i)
+	{
+		std::string image;
+		size_t imageWidth, imageHeight;
+
+		if (!reader.readString(image))
+			return nullptr;
+
+		data->frames[i] = ImageIO::loadFromMemoryRGBA32((const unsigned char*)image.data(), image.size(), imageWidth, imageHeight);
+
+		if (data->frames[i].empty() || (imageWidth != width) || (imageHeight != height))
+			return nullptr;
+	}
+
+	return data;
+}
+
+void VideoPreview::saveCache(const std::string& path, const Data& data)
+{
+	Utils::Binary::Writer writer;
+
+	writer.write(CACHE_MAGIC, sizeof(CACHE_MAGIC));
+	writer.write(CACHE_VERSION);
+	writer.writeString(path);
+	writer.write((int64_t)Utils::FileSystem::getFileSize(path));
+	writer.write((int64_t)Utils::FileSystem::getModifiedTime(path));
+	writer.write((uint32_t)data.videoWidth);
+	writer.write((uint32_t)data.videoHeight);
+	writer.write((uint32_t)data.width);
+	writer.write((uint32_t)data.height);
+	writer.write((uint32_t)data.frames.size());
+
+	for (auto it = data.frames.cbegin(); it != data.frames.cend(); ++it)
+	{
+		const std::vector<unsigned char> image = ImageIO::saveToMemory(it->data(), data.width, data.height);
+
+		if (image.empty())
+			return;
+
+		writer.writeString(std::string((const char*)image.data(), image.size()));
+	}
+
+	if (!Utils::Binary::saveFile(getCachePath(path), writer.getBuffer()))
+		LOG(LogWarning) << "Could not save preview of \"" << path << "\"";
+}
+
+std::string VideoPreview::getCachePath(const std::string& path)
+{
+	std::stringstream ss;
+	ss << std::hex << std::setw(16) << std::setfill('0') << (uint64_t)std::hash<std::string>()(path);
+
+	return Utils::FileSystem::getHomePath() + "/.emulationstation/video_previews/" + ss.str() + ".vid";
+}
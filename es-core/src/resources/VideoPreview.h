@@ -0,0 +1,82 @@
+#pragma once
+#ifndef ES_CORE_RESOURCES_VIDEO_PREVIEW_H
+#define ES_CORE_RESOURCES_VIDEO_PREVIEW_H
+
+#include <condition_variable>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <set>
+#include <string>
+#include <thread>
+#include <vector>
+
+// A poster frame and the first seconds of a video at a low resolution, taken while the video plays for the first time.
+// The preview is kept on disk next to the reduced images and loaded in the background, so revisiting a game shows its
+// video moving right away while the video itself is still being opened.
+class VideoPreview
+{
+public:
+	struct Data
+	{
+		unsigned int                            videoWidth;
+		unsigned int                            videoHeight;
+		unsigned int                            width;
+		unsigned int                            height;
+		std::vector<std::vector<unsigned char>> frames; // RGBA, the first one is the poster frame
+	};
+
+	// Whether previews are shown and taken at all
+	static bool isEnabled();
+
+	// The preview of the video at path if it's loaded, loading it is queued otherwise.
+	// missing is set once it's known there's no preview of the video yet
+	static std::shared_ptr<const Data> get(const std::string& path, bool& missing);
+
+	// Keeps a preview that was just taken, it's written to disk in the background
+	static void add(const std::string& path, const std::shared_ptr<const Data>& data);
+
+	// The bytes of the frames of the previews loaded or waiting to be saved, 0 while previews are disabled
+	static size_t getLoadedSize();
+
+	// Previews hold FRAME_COUNT frames FRAME_INTERVAL ms apart, halved until they're at most twice HEIGHT pixels high
+	static const unsigned int FRAME_COUNT = 16;
+	static const unsigned int FRAME_INTERVAL = 125;
+	static const unsigned int HEIGHT = 120;
+
+	// Loaded previews kept in RAM, each takes around 1.5 MB
+	static const size_t MAX_LOADED = 4;
+
+private:
+	struct Entry
+	{
+		std::string                 path;
+		std::shared_ptr<const Data> data;
+	};
+
+	VideoPreview();
+	~VideoPreview();
+
+	static VideoPreview& getInstance();
+
+	void threadProc();
+
+	// These expect mMutex to be locked
+	void keep(const std::string& path, const std::shared_ptr<const Data>& data);
+
+	static std::shared_ptr<const Data> loadCache(const std::string& path);
+	static void saveCache(const std::string& path, const Data& data);
+	static std::string getCachePath(const std::string& path);
+
+	std::list<Entry>        mLoaded; // most recently used first
+	std::set<std::string>   mMissing;
+	std::set<std::string>   mQueued;
+	std::list<std::string>  mLoadQueue;
+	std::list<Entry>        mSaveQueue;
+	std::mutex              mMutex;
+	std::condition_variable mEvent;
+	std::thread             mThread;
+	bool                    mExit;
+};
+
+#endif // ES_CORE_RESOURCES_VIDEO_PREVIEW_H
@@ -0,0 +1,145 @@
+#include "utils/BinaryUtil.h"
+
+#include "utils/FileSystemUtil.h"
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#include <fstream>
+#include <iterator>
+
+//////////////////////////////////////////////////////////////////////////
+
+namespace Utils
+{
+	namespace Binary
+	{
+		Reader::Reader(const std::string& _buffer) : mData(_buffer.data()), mSize(_buffer.size()), mOffset(0)
+		{
+
+		} // Reader
+
+//////////////////////////////////////////////////////////////////////////
+
+		bool Reader::read(void* _data, const size_t _length)
+		{
+			if(_length > (mSize - mOffset))
+				return false;
+
+			memcpy(_data, mData + mOffset, _length);
+			mOffset += _length;
+			return true;
+
+		} // read
+
+//////////////////////////////////////////////////////////////////////////
+
+		bool Reader::readString(std::string& _string)
+		{
+			uint32_t length;
+
+			if(!read(&length, sizeof(length)) || (length > (mSize - mOffset)))
+				return false;
+
+			_string.assign(mData + mOffset, length);
+			mOffset += length;
+			return true;
+
+		} // readString
+
+//////////////////////////////////////////////////////////////////////////
+
+		size_t Reader::getRemaining() const
+		{
+			return (mSize - mOffset);
+
+		} // getRemaining
+
+//////////////////////////////////////////////////////////////////////////
+
+		size_t Reader::getOffset() const
+		{
+			return mOffset;
+
+		} // getOffset
+
+//////////////////////////////////////////////////////////////////////////
+
+		void Writer::write(const void* _data, const size_t _length)
+		{
+			mBuffer.append((const char*)_data, _length);
+
+		} // write
+
+//////////////////////////////////////////////////////////////////////////
+
+		void Writer::writeString(const std::string& _string)
+		{
+			const uint32_t length = (uint32_t)_string.length();
+
+			write(&length, sizeof(length));
+			mBuffer.append(_string);
+
+		} // writeString
+
+//////////////////////////////////////////////////////////////////////////
+
+		const std::string& Writer::getBuffer() const
+		{
+			return mBuffer;
+
+		} // getBuffer
+
+//////////////////////////////////////////////////////////////////////////
+
+		bool loadFile(const std::string& _path, std::string& _buffer)
+		{
+			// open directly instead of checking exists(), the file may have been written after its path was indexed
+			std::ifstream stream(Utils::FileSystem::getGenericPath(_path).c_str(), std::ios::in | std::ios::binary);
+
+			if(!stream.is_open())
+				return false;
+
+			_buffer.assign(std::istreambuf_iterator<char>(stream), std::istreambuf_iterator<char>());
+			return !stream.bad();
+
+		} // loadFile
+
+//////////////////////////////////////////////////////////////////////////
+
+		bool saveFile(const std::string& _path, const std::string& _buffer)
+		{
+			const std::string path     = Utils::FileSystem::getGenericPath(_path);
+			const std::string tempPath = path + ".tmp";
+
+			Utils::FileSystem::createDirectory(Utils::FileSystem::getParent(path));
+
+			std::ofstream stream(tempPath.c_str(), std::ios::out | std::ios::binary | std::ios::trunc);
+
+			if(!stream.is_open())
+				return false;
+
+			stream.write(_buffer.data(), _buffer.size());
+			stream.close();
+
+			if(stream.fail())
+			{
+				remove(tempPath.c_str());
+				return false;
+			}
+
+			// replace the old file in one go so a crash never leaves a half written file behind
+#if defined(_WIN32)
+			Utils::FileSystem::removeFile(path);
+#endif // _WIN32
+
+			if(rename(tempPath.c_str(), path.c_str()) != 0)
+				return false;
+
+			Utils::FileSystem::invalidateExists(path);
+			return true;
+
+		} // saveFile
+
+	} // Binary::
+
+} // Utils::
@@ -0,0 +1,61 @@
+#pragma once
+#ifndef ES_CORE_UTILS_BINARY_UTIL_H
+#define ES_CORE_UTILS_BINARY_UTIL_H
+
+#include <stddef.h>
+#include <string>
+
+namespace Utils
+{
+	namespace Binary
+	{
+		// Bounds checked reader over a buffer holding a binary cache file, reads fail instead of running past its end.
+		// Strings are stored as a 32 bit length followed by their bytes.
+		class Reader
+		{
+		public:
+
+			Reader(const std::string& _buffer);
+
+			bool   read        (void* _data, const size_t _length);
+			bool   readString  (std::string& _string);
+			size_t getRemaining() const;
+			size_t getOffset   () const;
+
+			template<typename T>
+			bool read(T& _value) { return read(&_value, sizeof(T)); }
+
+		private:
+
+			const char* mData;
+			size_t      mSize;
+			size_t      mOffset;
+
+		}; // Reader
+
+		// Builds a binary cache file in memory, in the format understood by Reader.
+		class Writer
+		{
+		public:
+
+			void               write      (const void* _data, const size_t _length);
+			void               writeString(const std::string& _string);
+			const std::string& getBuffer  () const;
+
+			template<typename T>
+			void write(const T& _value) { write(&_value, sizeof(T)); }
+
+		private:
+
+			std::string mBuffer;
+
+		}; // Writer
+
+		bool loadFile(const std::string& _path, std::string& _buffer);
+		bool saveFile(const std::string& _path, const std::string& _buffer);
+
+	} // Binary::
+
+} // Utils::
+
+#endif // ES_CORE_UTILS_BINARY_UTIL_H
@@ -3,9 +3,12 @@
 #include "utils/FileSystemUtil.h"
 
 #include <sys/stat.h>
+#include <errno.h>
 #include <string.h>
-#include <map>
+#include <algorithm>
+#include <atomic>
 #include <mutex>
+#include <unordered_map>
 
 #if defined(_WIN32)
 // because windows...
@@ -20,6 +23,7 @@
 #define S_ISDIR(x) (((x) & S_IFMT) == S_IFDIR)
 #else // _WIN32
 #include <dirent.h>
+#include <fcntl.h>
 #include <unistd.h>
 #endif // _WIN32
 
@@ -32,7 +36,38 @@ namespace Utils
 		static std::recursive_mutex        mutex           = {};
 		static std::string                 homePath        = "";
 		static std::string                 exePath         = "";
-		static std::map<std::string, bool> pathExistsIndex = std::map<std::string, bool>();
+
+		// the exists index is split into shards with a lock each, so threads looking up different paths don't wait on each other
+		static const size_t EXISTS_SHARD_COUNT = 64;
+
+		struct ExistsShard
+		{
+			std::mutex                            mutex;
+			std::unordered_map<std::string, bool> index;
+		};
+
+		static ExistsShard         existsShards[EXISTS_SHARD_COUNT];
+		static std::atomic<size_t> existsHits(0);
+		static std::atomic<size_t> existsMisses(0);
+
+//////////////////////////////////////////////////////////////////////////
+
+		static ExistsShard& getExistsShard(const std::string& _path)
+		{
+			return existsShards[std::hash<std::string>()(_path) % EXISTS_SHARD_COUNT];
+
+		} // getExistsShard
+
+//////////////////////////////////////////////////////////////////////////
+
+		static void setExists(const std::string& _path, const bool _exists)
+		{
+			ExistsShard&                       shard = getExistsShard(_path);
+			const std::unique_lock<std::mutex> lock(shard.mutex);
+
+			shard.index[_path] = _exists;
+
+		} // setExists
 
 //////////////////////////////////////////////////////////////////////////
 
@@ -55,75 +90,128 @@ namespace Utils
 		{
 			const std::string path = getGenericPath(_path);
 			stringList        contentList;
+			DirEntryList      entries;
 
 			// only parse the directory, if it's a directory
-			if(isDirectory(path))
+			if(getDirEntries(path, entries))
 			{
+				for(DirEntryList::const_iterator it = entries.cbegin(); it != entries.cend(); ++it)
+				{
+					const std::string fullName(getGenericPath(path + "/" + it->name));
+
+					contentList.push_back(fullName);
+
+					// the listing already knows what's a directory, no need to ask the disk again
+					if(_recursive && it->isDirectory)
+						contentList.merge(getDirContent(fullName, true));
+				}
+			}
+
+			// sort the content list
+			contentList.sort();
+
+			// return the content list
+			return contentList;
+
+		} // getDirContent
+
+//////////////////////////////////////////////////////////////////////////
+
+		bool getDirEntries(const std::string& _path, DirEntryList& _entries, const bool _details)
+		{
+			const std::string path = getGenericPath(_path);
+
+			_entries.clear();
 
 #if defined(_WIN32)
-				const std::unique_lock<std::recursive_mutex> lock(mutex);
-				WIN32_FIND_DATAW                             findData;
-				const std::string                            wildcard = path + "/*";
-				const HANDLE                                 hFind    = FindFirstFileW(std::wstring(wildcard.begin(), wildcard.end()).c_str(), &findData);
+			const std::unique_lock<std::recursive_mutex> lock(mutex);
+			WIN32_FIND_DATAW                             findData;
+			const std::string                            wildcard = path + "/*";
+			// the find data already has everything, skipping the short 8.3 names and fetching more per call saves round trips on network shares
+			const HANDLE                                 hFind    = FindFirstFileExW(std::wstring(wildcard.begin(), wildcard.end()).c_str(), FindExInfoBasic, &findData, FindExSearchNameMatch, nullptr, FIND_FIRST_EX_LARGE_FETCH);
 
-				if(hFind != INVALID_HANDLE_VALUE)
-				{
-					// loop over all files in the directory
-					do
-					{
-						const std::string name = convertFromWideString(findData.cFileName);
+			if(hFind == INVALID_HANDLE_VALUE)
+				return false;
 
-						// ignore "." and ".."
-						if((name != ".") && (name != ".."))
-						{
-							const std::string fullName(getGenericPath(path + "/" + name));
+			// loop over all files in the directory
+			do
+			{
+				const std::string name = convertFromWideString(findData.cFileName);
 
-							contentList.push_back(fullName);
+				// ignore "." and ".."
+				if((name == ".") || (name == ".."))
+					continue;
 
-							if(_recursive && isDirectory(fullName))
-								contentList.merge(getDirContent(fullName, true));
-						}
-					}
-					while(FindNextFileW(hFind, &findData));
+				// FILETIME counts 100ns steps since 1601
+				const uint64_t writeTime = ((uint64_t)findData.ftLastWriteTime.dwHighDateTime << 32) | findData.ftLastWriteTime.dwLowDateTime;
+				const DirEntry entry     =
+				{
+					name,
+					(findData.dwFileAttributes & FILE_ATTRIBUTE_DIRECTORY) != 0,
+					(findData.dwFileAttributes & FILE_ATTRIBUTE_REPARSE_POINT) != 0,
+					((findData.dwFileAttributes & FILE_ATTRIBUTE_HIDDEN) != 0) || (name[0] == '.'),
+					_details ? (int64_t)(((uint64_t)findData.nFileSizeHigh << 32) | findData.nFileSizeLow) : 0,
+					_details ? (time_t)((writeTime - 116444736000000000ULL) / 10000000ULL) : 0
+				};
+
+				_entries.push_back(entry);
+			}
+			while(FindNextFileW(hFind, &findData));
 
-					FindClose(hFind);
-				}
+			FindClose(hFind);
 #else // _WIN32
-				DIR* dir = opendir(path.c_str());
+			DIR* dir = opendir(path.c_str());
 
-				if(dir != NULL)
-				{
-					struct dirent* entry;
+			if(dir == NULL)
+				return false;
 
-					// loop over all files in the directory
-					while((entry = readdir(dir)) != NULL)
-					{
-						const std::string name(entry->d_name);
+			const int      fd = dirfd(dir);
+			struct dirent* dirEntry;
 
-						// ignore "." and ".."
-						if((name != ".") && (name != ".."))
-						{
-							std::string fullName(getGenericPath(path + "/" + name));
-							contentList.push_back(fullName);
+			// loop over all files in the directory
+			while((dirEntry = readdir(dir)) != NULL)
+			{
+				const char* name = dirEntry->d_name;
+
+				// ignore "." and ".."
+				if((name[0] == '.') && ((name[1] == 0) || ((name[1] == '.') && (name[2] == 0))))
+					continue;
+
+				DirEntry entry = { name, (dirEntry->d_type == DT_DIR), (dirEntry->d_type == DT_LNK), (name[0] == '.'), 0, 0 };
 
-							if(_recursive && isDirectory(fullName))
-								contentList.merge(getDirContent(fullName, true));
-						}
+				// the type from readdir is enough unless the filesystem doesn't fill it in, or it's a symlink that could point
+				// at a directory. The stat is relative to the open directory, the path isn't walked again for each entry
+				if(_details || (dirEntry->d_type == DT_UNKNOWN) || (dirEntry->d_type == DT_LNK))
+				{
+					struct stat64 info;
+					bool          found = (fstatat64(fd, name, &info, (dirEntry->d_type == DT_UNKNOWN) ? AT_SYMLINK_NOFOLLOW : 0) == 0);
+
+					if(found && (dirEntry->d_type == DT_UNKNOWN) && S_ISLNK(info.st_mode))
+					{
+						entry.isSymlink = true;
+						found           = (fstatat64(fd, name, &info, 0) == 0);
 					}
 
-					closedir(dir);
+					if(found)
+					{
+						entry.isDirectory  = S_ISDIR(info.st_mode);
+						entry.size         = _details ? (int64_t)info.st_size : 0;
+						entry.modifiedTime = _details ? info.st_mtime : 0;
+					}
 				}
-#endif // !_WIN32
 
+				_entries.push_back(entry);
 			}
 
-			// sort the content list
-			contentList.sort();
+			closedir(dir);
+#endif // !_WIN32
 
-			// return the content list
-			return contentList;
+			// sorted by name like getDirContent
+			std::sort(_entries.begin(), _entries.end(), [](const DirEntry& _a, const DirEntry& _b) { return _a.name < _b.name; });
 
-		} // getDirContent
+			return true;
+
+		} // getDirEntries
 
 //////////////////////////////////////////////////////////////////////////
 
@@ -264,26 +352,51 @@ namespace Utils
 
 //////////////////////////////////////////////////////////////////////////
 
-		std::string getGenericPath(const std::string& _path)
+		static bool hasLongPathPrefix(const std::string& _path)
 		{
-			std::string path   = _path;
-			size_t      offset = std::string::npos;
+			return (_path.compare(0, 4, "\\\\?\\") == 0);
 
-			// remove "\\\\?\\"
-			if((path.find("\\\\?\\")) == 0)
-				path.erase(0, 4);
+		} // hasLongPathPrefix
 
-			// convert '\\' to '/'
-			while((offset = path.find('\\')) != std::string::npos)
-				path.replace(offset, 1 ,"/");
+//////////////////////////////////////////////////////////////////////////
 
-			// remove double '/'
-			while((offset = path.find("//")) != std::string::npos)
-				path.erase(offset, 1);
+		static bool isSeparator(const char _char)
+		{
+			return ((_char == '/') || (_char == '\\'));
+
+		} // isSeparator
+
+//////////////////////////////////////////////////////////////////////////
+
+		static void appendGenericPath(std::string& _out, const std::string& _path)
+		{
+			const size_t start = _out.size();
+
+			// remove "\\\\?\\", convert '\\' to '/' and remove double '/' in one go
+			for(size_t i = hasLongPathPrefix(_path) ? 4 : 0; i < _path.size(); ++i)
+			{
+				const char c = (_path[i] == '\\') ? '/' : _path[i];
+
+				if((c == '/') && (_out.size() > start) && (_out.back() == '/'))
+					continue;
+
+				_out += c;
+			}
 
 			// remove trailing '/' when the path is more than a simple '/'
-			while(path.length() > 1 && ((offset = path.find_last_of('/')) == (path.length() - 1)))
-				path.erase(offset, 1);
+			while((_out.size() > (start + 1)) && (_out.back() == '/'))
+				_out.pop_back();
+
+		} // appendGenericPath
+
+//////////////////////////////////////////////////////////////////////////
+
+		std::string getGenericPath(const std::string& _path)
+		{
+			std::string path;
+
+			path.reserve(_path.size());
+			appendGenericPath(path, _path);
 
 			// return generic path
 			return path;
@@ -432,73 +545,105 @@ namespace Utils
 
 		std::string getFileName(const std::string& _path)
 		{
-			const std::string path   = getGenericPath(_path);
-			size_t            offset = std::string::npos;
+			return getFileNameView(_path).str();
+
+		} // getFileName
+
+//////////////////////////////////////////////////////////////////////////
+
+		std::string getStem(const std::string& _path)
+		{
+			return getStemView(_path).str();
+
+		} // getStem
+
+//////////////////////////////////////////////////////////////////////////
+
+		std::string getExtension(const std::string& _path)
+		{
+			return getExtensionView(_path).str();
+
+		} // getExtension
+
+//////////////////////////////////////////////////////////////////////////
+
+		PathView getFileNameView(const std::string& _path)
+		{
+			// same result as on the generic path, but the separators are looked at where they are instead of copying it
+			const char* data  = _path.data();
+			size_t      begin = hasLongPathPrefix(_path) ? 4 : 0;
+			size_t      end   = _path.size();
+
+			// trailing '/' are not part of the filename, unless the path is only that
+			while(((end - begin) > 1) && isSeparator(data[end - 1]))
+				--end;
 
 			// find last '/' and return the filename
-			if((offset = path.find_last_of('/')) != std::string::npos)
-				return ((path[offset + 1] == 0) ? "." : std::string(path, offset + 1));
+			for(size_t offset = end; offset > begin; --offset)
+			{
+				if(isSeparator(data[offset - 1]))
+					return ((offset == end) ? PathView(".", 1) : PathView(data + offset, end - offset));
+			}
 
 			// no '/' found, entire path is a filename
-			return path;
+			return PathView(data + begin, end - begin);
 
-		} // getFileName
+		} // getFileNameView
 
 //////////////////////////////////////////////////////////////////////////
 
-		std::string getStem(const std::string& _path)
+		PathView getStemView(const std::string& _path)
 		{
-			std::string fileName = getFileName(_path);
-			size_t      offset   = std::string::npos;
+			const PathView fileName = getFileNameView(_path);
 
 			// empty fileName
 			if(fileName == ".")
 				return fileName;
 
-			// find last '.' and erase the extension
-			if((offset = fileName.find_last_of('.')) != std::string::npos)
-				return fileName.erase(offset);
+			// find last '.' and drop the extension
+			for(size_t offset = fileName.size(); offset > 0; --offset)
+			{
+				if(fileName[offset - 1] == '.')
+					return PathView(fileName.data(), offset - 1);
+			}
 
 			// no '.' found, filename has no extension
 			return fileName;
 
-		} // getStem
+		} // getStemView
 
 //////////////////////////////////////////////////////////////////////////
 
-		std::string getExtension(const std::string& _path)
+		PathView getExtensionView(const std::string& _path)
 		{
-			const std::string fileName = getFileName(_path);
-			size_t            offset   = std::string::npos;
+			const PathView fileName = getFileNameView(_path);
 
 			// empty fileName
 			if(fileName == ".")
 				return fileName;
 
 			// find last '.' and return the extension
-			if((offset = fileName.find_last_of('.')) != std::string::npos)
-				return std::string(fileName, offset);
+			for(size_t offset = fileName.size(); offset > 0; --offset)
+			{
+				if(fileName[offset - 1] == '.')
+					return PathView(fileName.data() + offset - 1, fileName.size() - offset + 1);
+			}
 
 			// no '.' found, filename has no extension
-			return ".";
+			return PathView(".", 1);
 
-		} // getExtension
+		} // getExtensionView
 
 //////////////////////////////////////////////////////////////////////////
 
 		std::string resolveRelativePath(const std::string& _path, const std::string& _relativeTo, const bool _allowHome, const bool _skipDirectoryCheck)
 		{
-			const std::string path       = getGenericPath(_path);
-			const std::string relativeTo = (_skipDirectoryCheck || isDirectory(_relativeTo)) ? getGenericPath(_relativeTo) : getParent(_relativeTo);
+			const std::string path = getGenericPath(_path);
 
 			// nothing to resolve
 			if(!path.length())
 				return path;
 
-			// replace '.' with relativeTo
-			if((path[0] == '.') && (path[1] == '/'))
-				return (relativeTo + &(path[1]));
-
 			// replace '~' with homePath
 			if(_allowHome && (path[0] == '~') && (path[1] == '/'))
 				return (getHomePath() + &(path[1]));
@@ -507,8 +652,21 @@ namespace Utils
 			if(path[0] == '/')
 				return path;
 
+			// the result is built in place, this runs for every game of every gamelist
+			std::string resolved;
+			resolved.reserve(_relativeTo.size() + path.size() + 1);
+
+			if(_skipDirectoryCheck || isDirectory(_relativeTo))
+				appendGenericPath(resolved, _relativeTo);
+			else
+				resolved = getParent(_relativeTo);
+
+			// replace '.' with relativeTo
+			if((path[0] == '.') && (path[1] == '/'))
+				return resolved.append(path, 1, std::string::npos);
+
 			// concatenate paths
-			return (relativeTo + '/' + path);
+			return resolved.append(1, '/').append(path);
 
 		} // resolveRelativePath
 
@@ -541,14 +699,15 @@ namespace Utils
 
 		std::string removeCommonPath(const std::string& _path, const std::string& _common, bool& _contains, const bool _skipDirectoryCheck)
 		{
-			const std::string path   = getGenericPath(_path);
+			std::string       path   = getGenericPath(_path);
 			const std::string common = (_skipDirectoryCheck || isDirectory(_common)) ? getGenericPath(_common) : getParent(_common);
 
-			// check if path contains common
-			if(path.find(common) == 0)
+			// check if path contains common, the rest is moved to the front instead of copied out
+			if(path.compare(0, common.length(), common) == 0)
 			{
 				_contains = true;
-				return path.substr(common.length() + 1);
+				path.erase(0, common.length() + 1);
+				return path;
 			}
 
 			// it didn't
@@ -594,6 +753,38 @@ namespace Utils
 
 		} // resolveSymlink
 
+//////////////////////////////////////////////////////////////////////////
+
+		time_t getModifiedTime(const std::string& _path)
+		{
+			const std::string path = getGenericPath(_path);
+			struct stat64     info;
+
+			// check if stat64 succeeded
+			if(stat64(path.c_str(), &info) != 0)
+				return 0;
+
+			// return last modification time
+			return info.st_mtime;
+
+		} // getModifiedTime
+
+//////////////////////////////////////////////////////////////////////////
+
+		int64_t getFileSize(const std::string& _path)
+		{
+			const std::string path = getGenericPath(_path);
+			struct stat64     info;
+
+			// check if stat64 succeeded
+			if(stat64(path.c_str(), &info) != 0)
+				return -1;
+
+			// return size in bytes
+			return (int64_t)info.st_size;
+
+		} // getFileSize
+
 //////////////////////////////////////////////////////////////////////////
 
 		bool removeFile(const std::string& _path)
@@ -601,15 +792,13 @@ namespace Utils
 			const std::unique_lock<std::recursive_mutex> lock(mutex);
 			const std::string                            path = getGenericPath(_path);
 
-			// don't remove if it doesn't exists
-			if(!exists(path))
-				return true;
+			// don't go by the exists index, the file may have been created since it was indexed
+			// a file that doesn't exist counts as removed
+			const bool removed = (unlink(path.c_str()) == 0) || (errno == ENOENT);
 
-			bool removed = (unlink(path.c_str()) == 0);
-			
 			// if removed, let's remove it from the index
 			if (removed)
-				pathExistsIndex[_path] = false;
+				setExists(_path, false);
 
 			// try to remove file
 			return removed;
@@ -629,7 +818,7 @@ namespace Utils
 			// try to create directory
 			if(mkdir(path.c_str(), 0755) == 0)
 			{
-				pathExistsIndex[_path] = true;
+				setExists(_path, true);
 				return true;
 			}
 
@@ -643,7 +832,7 @@ namespace Utils
 			// try to create directory again now that the parent should exist
 			bool created = (mkdir(path.c_str(), 0755) == 0);
 			if(created)
-				pathExistsIndex[_path] = true;
+				setExists(_path, true);
 
 			return created;
 
@@ -653,20 +842,64 @@ namespace Utils
 
 		bool exists(const std::string& _path)
 		{
-			const std::unique_lock<std::recursive_mutex> lock(mutex);
+			ExistsShard& shard = getExistsShard(_path);
 
-			if(pathExistsIndex.find(_path) == pathExistsIndex.cend())
 			{
-				const std::string path = getGenericPath(_path);
-				struct stat64 info;
-				// check if stat64 succeeded
-				pathExistsIndex[_path] = (stat64(path.c_str(), &info) == 0);
+				const std::unique_lock<std::mutex>                    lock(shard.mutex);
+				std::unordered_map<std::string, bool>::const_iterator it = shard.index.find(_path);
+
+				if(it != shard.index.cend())
+				{
+					++existsHits;
+					return it->second;
+				}
 			}
 
-			return pathExistsIndex.at(_path);
+			// stat without holding the lock, two threads missing the same path at once just both stat it
+			const std::string path = getGenericPath(_path);
+			struct stat64     info;
+			const bool        found = (stat64(path.c_str(), &info) == 0);
+
+			++existsMisses;
+			setExists(_path, found);
+
+			return found;
 
 		} // exists
 
+//////////////////////////////////////////////////////////////////////////
+
+		void invalidateExists(const std::string& _path)
+		{
+			ExistsShard&                       shard = getExistsShard(_path);
+			const std::unique_lock<std::mutex> lock(shard.mutex);
+
+			shard.index.erase(_path);
+
+		} // invalidateExists
+
+//////////////////////////////////////////////////////////////////////////
+
+		void invalidateAllExists()
+		{
+			for(size_t i = 0; i < EXISTS_SHARD_COUNT; ++i)
+			{
+				const std::unique_lock<std::mutex> lock(existsShards[i].mutex);
+
+				existsShards[i].index.clear();
+			}
+
+		} // invalidateAllExists
+
+//////////////////////////////////////////////////////////////////////////
+
+		void getExistsStats(size_t& _hits, size_t& _misses)
+		{
+			_hits   = existsHits.load();
+			_misses = existsMisses.load();
+
+		} // getExistsStats
+
 //////////////////////////////////////////////////////////////////////////
 
 		bool isAbsolute(const std::string& _path)
@@ -744,17 +977,16 @@ namespace Utils
 
 		bool isHidden(const std::string& _path)
 		{
-			const std::string path = getGenericPath(_path);
-
 #if defined(_WIN32)
 			// check for hidden attribute
-			const DWORD Attributes = GetFileAttributes(path.c_str());
+			const DWORD Attributes = GetFileAttributes(getGenericPath(_path).c_str());
 			if((Attributes != INVALID_FILE_ATTRIBUTES) && (Attributes & FILE_ATTRIBUTE_HIDDEN))
 				return true;
 #endif // _WIN32
 
 			// filenames starting with . are hidden in linux, we do this check for windows as well
-			if(getFileName(path)[0] == '.')
+			const PathView fileName = getFileNameView(_path);
+			if(!fileName.empty() && (fileName[0] == '.'))
 				return true;
 
 			// not hidden
@@ -3,7 +3,10 @@
 #define ES_CORE_UTILS_FILE_SYSTEM_UTIL_H
 
 #include <list>
+#include <stdint.h>
 #include <string>
+#include <time.h>
+#include <vector>
 
 namespace Utils
 {
@@ -11,7 +14,50 @@ namespace Utils
 	{
 		typedef std::list<std::string> stringList;
 
+		struct DirEntry
+		{
+			std::string name;         // without the directory it is in
+			bool        isDirectory;  // a symlink to a directory is one too, like isDirectory()
+			bool        isSymlink;
+			bool        isHidden;
+			int64_t     size;         // size and modifiedTime are 0 unless the details were asked for
+			time_t      modifiedTime;
+
+		}; // DirEntry
+
+		typedef std::vector<DirEntry> DirEntryList;
+
+		// A piece of a path without a copy of it, a pointer into the string it was taken from and a length. It stays valid
+		// for as long as that string is left alone
+		class PathView
+		{
+		public:
+
+			PathView() : mData(""), mSize(0) { }
+			PathView(const char* _data, const size_t _size) : mData(_data), mSize(_size) { }
+
+			const char* data () const { return mData; }
+			size_t      size () const { return mSize; }
+			bool        empty() const { return (mSize == 0); }
+			std::string str  () const { return std::string(mData, mSize); }
+
+			char operator[](const size_t _index) const { return mData[_index]; }
+
+			bool operator==(const std::string& _other) const { return ((_other.size() == mSize) && (_other.compare(0, mSize, mData, mSize) == 0)); }
+			bool operator!=(const std::string& _other) const { return !(*this == _other); }
+
+		private:
+
+			const char* mData;
+			size_t      mSize;
+
+		}; // PathView
+
+		inline bool operator==(const std::string& _string, const PathView& _view) { return (_view == _string); }
+		inline bool operator!=(const std::string& _string, const PathView& _view) { return (_view != _string); }
+
 		stringList  getDirContent      (const std::string& _path, const bool _recursive = false);
+		bool        getDirEntries      (const std::string& _path, DirEntryList& _entries, const bool _details = false);
 		stringList  getPathList        (const std::string& _path);
 		void        setHomePath        (const std::string& _path);
 		std::string getHomePath        ();
@@ -27,13 +73,21 @@ namespace Utils
 		std::string getFileName        (const std::string& _path);
 		std::string getStem            (const std::string& _path);
 		std::string getExtension       (const std::string& _path);
+		PathView    getFileNameView    (const std::string& _path);
+		PathView    getStemView        (const std::string& _path);
+		PathView    getExtensionView   (const std::string& _path);
 		std::string resolveRelativePath(const std::string& _path, const std::string& _relativeTo, const bool _allowHome, const bool _skipDirectoryCheck);
 		std::string createRelativePath (const std::string& _path, const std::string& _relativeTo, const bool _allowHome, const bool _skipDirectoryCheck);
 		std::string removeCommonPath   (const std::string& _path, const std::string& _common, bool& _contains, const bool _skipDirectoryCheck);
 		std::string resolveSymlink     (const std::string& _path);
+		time_t      getModifiedTime    (const std::string& _path);
+		int64_t     getFileSize        (const std::string& _path);
 		bool        removeFile         (const std::string& _path);
 		bool        createDirectory    (const std::string& _path);
 		bool        exists             (const std::string& _path);
+		void        invalidateExists   (const std::string& _path);
+		void        invalidateAllExists();
+		void        getExistsStats     (size_t& _hits, size_t& _misses);
 		bool        isAbsolute         (const std::string& _path);
 		bool        isRegularFile      (const std::string& _path);
 		bool        isDirectory        (const std::string& _path);
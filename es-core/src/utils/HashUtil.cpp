@@ -0,0 +1,367 @@
+#include "utils/HashUtil.h"
+
+#include <stdio.h>
+#include <string.h>
+#include <vector>
+
+//////////////////////////////////////////////////////////////////////////
+
+namespace Utils
+{
+	namespace Hash
+	{
+		// read in large chunks, hashing is limited by the disk on the devices it's slow on
+		static const size_t READ_SIZE = 1024 * 1024;
+
+		// slicing-by-8 tables, the CRC of 8 bytes takes 8 lookups and no loop carried dependency per byte
+		struct CRC32Tables
+		{
+			CRC32Tables()
+			{
+				for(uint32_t i = 0; i < 256; ++i)
+				{
+					uint32_t crc = i;
+
+					for(int bit = 0; bit < 8; ++bit)
+						crc = (crc >> 1) ^ (0xEDB88320 & (0 - (crc & 1)));
+
+					table[0][i] = crc;
+				}
+
+				for(uint32_t i = 0; i < 256; ++i)
+				{
+					for(int slice = 1; slice < 8; ++slice)
+						table[slice][i] = (table[slice - 1][i] >> 8) ^ table[0][table[slice - 1][i] & 0xFF];
+				}
+
+			} // CRC32Tables
+
+			uint32_t table[8][256];
+
+		}; // CRC32Tables
+
+		static const CRC32Tables crc32Tables;
+
+//////////////////////////////////////////////////////////////////////////
+
+		static uint32_t updateCRC32(uint32_t _crc, const unsigned char* _data, size_t _length)
+		{
+			const uint32_t (&t)[8][256] = crc32Tables.table;
+
+			while(_length >= 8)
+			{
+				const uint32_t one = (uint32_t)_data[0] | ((uint32_t)_data[1] << 8) | ((uint32_t)_data[2] << 16) | ((uint32_t)_data[3] << 24);
+				const uint32_t two = (uint32_t)_data[4] | ((uint32_t)_data[5] << 8) | ((uint32_t)_data[6] << 16) | ((uint32_t)_data[7] << 24);
+				const uint32_t low = one ^ _crc;
+
+				_crc = t[7][ low        & 0xFF] ^ t[6][(low >>  8) & 0xFF] ^ t[5][(low >> 16) & 0xFF] ^ t[4][ low >> 24] ^
+				       t[3][ two        & 0xFF] ^ t[2][(two >>  8) & 0xFF] ^ t[1][(two >> 16) & 0xFF] ^ t[0][ two >> 24];
+
+				_data   += 8;
+				_length -= 8;
+			}
+
+			while(_length--)
+				_crc = (_crc >> 8) ^ t[0][(_crc ^ *_data++) & 0xFF];
+
+			return _crc;
+
+		} // updateCRC32
+
+//////////////////////////////////////////////////////////////////////////
+
+		static inline uint32_t rotateLeft(const uint32_t _value, const int _bits)
+		{
+			return (_value << _bits) | (_value >> (32 - _bits));
+
+		} // rotateLeft
+
+//////////////////////////////////////////////////////////////////////////
+
+		static std::string toHex(const unsigned char* _bytes, const size_t _length)
+		{
+			static const char* digits = "0123456789abcdef";
+			std::string        hex;
+
+			hex.reserve(_length * 2);
+
+			for(size_t i = 0; i < _length; ++i)
+			{
+				hex.push_back(digits[_bytes[i] >> 4]);
+				hex.push_back(digits[_bytes[i] & 0x0F]);
+			}
+
+			return hex;
+
+		} // toHex
+
+//////////////////////////////////////////////////////////////////////////
+
+		Hasher::Hasher() : mCRC32(0xFFFFFFFF), mBlockLength(0), mLength(0)
+		{
+			mMD5[0]  = 0x67452301;
+			mMD5[1]  = 0xEFCDAB89;
+			mMD5[2]  = 0x98BADCFE;
+			mMD5[3]  = 0x10325476;
+
+			mSHA1[0] = 0x67452301;
+			mSHA1[1] = 0xEFCDAB89;
+			mSHA1[2] = 0x98BADCFE;
+			mSHA1[3] = 0x10325476;
+			mSHA1[4] = 0xC3D2E1F0;
+
+		} // Hasher
+
+//////////////////////////////////////////////////////////////////////////
+
+		void Hasher::update(const void* _data, const size_t _length)
+		{
+			const unsigned char* data   = (const unsigned char*)_data;
+			size_t               length = _length;
+
+			mCRC32   = updateCRC32(mCRC32, data, length);
+			mLength += length;
+
+			// top up a partial block first, then hash whole blocks straight from the data
+			if(mBlockLength)
+			{
+				const size_t copy = ((64 - mBlockLength) < length) ? (64 - mBlockLength) : length;
+
+				memcpy(mBlock + mBlockLength, data, copy);
+				mBlockLength += copy;
+				data         += copy;
+				length       -= copy;
+
+				if(mBlockLength < 64)
+					return;
+
+				processMD5(mBlock);
+				processSHA1(mBlock);
+				mBlockLength = 0;
+			}
+
+			while(length >= 64)
+			{
+				processMD5(data);
+				processSHA1(data);
+				data   += 64;
+				length -= 64;
+			}
+
+			memcpy(mBlock, data, length);
+			mBlockLength = length;
+
+		} // update
+
+//////////////////////////////////////////////////////////////////////////
+
+		void Hasher::finish()
+		{
+			const uint64_t bits = mLength * 8;
+
+			// both pad the same way, only the byte order of the length differs
+			mBlock[mBlockLength++] = 0x80;
+
+			if(mBlockLength > 56)
+			{
+				memset(mBlock + mBlockLength, 0, 64 - mBlockLength);
+				processMD5(mBlock);
+				processSHA1(mBlock);
+				mBlockLength = 0;
+			}
+
+			memset(mBlock + mBlockLength, 0, 56 - mBlockLength);
+
+			unsigned char last[64];
+			memcpy(last, mBlock, 56);
+
+			for(int i = 0; i < 8; ++i)
+			{
+				mBlock[56 + i] = (unsigned char)(bits >> (i * 8));
+				last[63 - i]   = (unsigned char)(bits >> (i * 8));
+			}
+
+			processMD5(mBlock);
+			processSHA1(last);
+
+			mCRC32      ^= 0xFFFFFFFF;
+			mBlockLength = 0;
+
+		} // finish
+
+//////////////////////////////////////////////////////////////////////////
+
+		std::string Hasher::getCRC32() const
+		{
+			const unsigned char bytes[4] = { (unsigned char)(mCRC32 >> 24), (unsigned char)(mCRC32 >> 16), (unsigned char)(mCRC32 >> 8), (unsigned char)mCRC32 };
+
+			return toHex(bytes, sizeof(bytes));
+
+		} // getCRC32
+
+//////////////////////////////////////////////////////////////////////////
+
+		std::string Hasher::getMD5() const
+		{
+			unsigned char bytes[16];
+
+			for(int i = 0; i < 16; ++i)
+				bytes[i] = (unsigned char)(mMD5[i / 4] >> ((i % 4) * 8));
+
+			return toHex(bytes, sizeof(bytes));
+
+		} // getMD5
+
+//////////////////////////////////////////////////////////////////////////
+
+		std::string Hasher::getSHA1() const
+		{
+			unsigned char bytes[20];
+
+			for(int i = 0; i < 20; ++i)
+				bytes[i] = (unsigned char)(mSHA1[i / 4] >> ((3 - (i % 4)) * 8));
+
+			return toHex(bytes, sizeof(bytes));
+
+		} // getSHA1
+
+//////////////////////////////////////////////////////////////////////////
+
+		void Hasher::processMD5(const unsigned char* _block)
+		{
+			static const uint32_t k[64] =
+			{
+				0xD76AA478, 0xE8C7B756, 0x242070DB, 0xC1BDCEEE, 0xF57C0FAF, 0x4787C62A, 0xA8304613, 0xFD469501,
+				0x698098D8, 0x8B44F7AF, 0xFFFF5BB1, 0x895CD7BE, 0x6B901122, 0xFD987193, 0xA679438E, 0x49B40821,
+				0xF61E2562, 0xC040B340, 0x265E5A51, 0xE9B6C7AA, 0xD62F105D, 0x02441453, 0xD8A1E681, 0xE7D3FBC8,
+				0x21E1CDE6, 0xC33707D6, 0xF4D50D87, 0x455A14ED, 0xA9E3E905, 0xFCEFA3F8, 0x676F02D9, 0x8D2A4C8A,
+				0xFFFA3942, 0x8771F681, 0x6D9D6122, 0xFDE5380C, 0xA4BEEA44, 0x4BDECFA9, 0xF6BB4B60, 0xBEBFBC70,
+				0x289B7EC6, 0xEAA127FA, 0xD4EF3085, 0x04881D05, 0xD9D4D039, 0xE6DB99E5, 0x1FA27CF8, 0xC4AC5665,
+				0xF4292244, 0x432AFF97, 0xAB9423A7, 0xFC93A039, 0x655B59C3, 0x8F0CCC92, 0xFFEFF47D, 0x85845DD1,
+				0x6FA87E4F, 0xFE2CE6E0, 0xA3014314, 0x4E0811A1, 0xF7537E82, 0xBD3AF235, 0x2AD7D2BB, 0xEB86D391
+			};
+			static const int shifts[16] = { 7, 12, 17, 22, 5, 9, 14, 20, 4, 11, 16, 23, 6, 10, 15, 21 };
+
+			uint32_t m[16];
+
+			for(int i = 0; i < 16; ++i)
+				m[i] = (uint32_t)_block[i * 4] | ((uint32_t)_block[(i * 4) + 1] << 8) | ((uint32_t)_block[(i * 4) + 2] << 16) | ((uint32_t)_block[(i * 4) + 3] << 24);
+
+			uint32_t a = mMD5[0];
+			uint32_t b = mMD5[1];
+			uint32_t c = mMD5[2];
+			uint32_t d = mMD5[3];
+
+			for(int i = 0; i < 64; ++i)
+			{
+				uint32_t f;
+				int      g;
+
+				switch(i / 16)
+				{
+					case 0:  { f = (b & c) | (~b & d); g = i;                  } break;
+					case 1:  { f = (d & b) | (~d & c); g = ((5 * i) + 1) % 16; } break;
+					case 2:  { f = b ^ c ^ d;          g = ((3 * i) + 5) % 16; } break;
+					default: { f = c ^ (b | ~d);       g = (7 * i) % 16;       } break;
+				}
+
+				const uint32_t rotated = rotateLeft(a + f + k[i] + m[g], shifts[((i / 16) * 4) + (i % 4)]);
+
+				a = d;
+				d = c;
+				c = b;
+				b = b + rotated;
+			}
+
+			mMD5[0] += a;
+			mMD5[1] += b;
+			mMD5[2] += c;
+			mMD5[3] += d;
+
+		} // processMD5
+
+//////////////////////////////////////////////////////////////////////////
+
+		void Hasher::processSHA1(const unsigned char* _block)
+		{
+			uint32_t w[80];
+
+			for(int i = 0; i < 16; ++i)
+				w[i] = ((uint32_t)_block[i * 4] << 24) | ((uint32_t)_block[(i * 4) + 1] << 16) | ((uint32_t)_block[(i * 4) + 2] << 8) | (uint32_t)_block[(i * 4) + 3];
+
+			for(int i = 16; i < 80; ++i)
+				w[i] = rotateLeft(w[i - 3] ^ w[i - 8] ^ w[i - 14] ^ w[i - 16], 1);
+
+			uint32_t a = mSHA1[0];
+			uint32_t b = mSHA1[1];
+			uint32_t c = mSHA1[2];
+			uint32_t d = mSHA1[3];
+			uint32_t e = mSHA1[4];
+
+			for(int i = 0; i < 80; ++i)
+			{
+				uint32_t f;
+				uint32_t k;
+
+				switch(i / 20)
+				{
+					case 0:  { f = (b & c) | (~b & d);          k = 0x5A827999; } break;
+					case 1:  { f = b ^ c ^ d;                   k = 0x6ED9EBA1; } break;
+					case 2:  { f = (b & c) | (b & d) | (c & d); k = 0x8F1BBCDC; } break;
+					default: { f = b ^ c ^ d;                   k = 0xCA62C1D6; } break;
+				}
+
+				const uint32_t temp = rotateLeft(a, 5) + f + e + k + w[i];
+
+				e = d;
+				d = c;
+				c = rotateLeft(b, 30);
+				b = a;
+				a = temp;
+			}
+
+			mSHA1[0] += a;
+			mSHA1[1] += b;
+			mSHA1[2] += c;
+			mSHA1[3] += d;
+			mSHA1[4] += e;
+
+		} // processSHA1
+
+//////////////////////////////////////////////////////////////////////////
+
+		bool hashFile(const std::string& _path, Hasher& _hasher, const std::atomic<bool>* _abort)
+		{
+			FILE* file = fopen(_path.c_str(), "rb");
+
+			if(!file)
+				return false;
+
+			std::vector<unsigned char> buffer(READ_SIZE);
+			size_t                     read;
+
+			while((read = fread(buffer.data(), 1, buffer.size(), file)) > 0)
+			{
+				if(_abort && *_abort)
+				{
+					fclose(file);
+					return false;
+				}
+
+				_hasher.update(buffer.data(), read);
+			}
+
+			const bool failed = (ferror(file) != 0);
+			fclose(file);
+
+			if(failed)
+				return false;
+
+			_hasher.finish();
+			return true;
+
+		} // hashFile
+
+	} // Hash::
+
+} // Utils::
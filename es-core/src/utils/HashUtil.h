@@ -0,0 +1,49 @@
+#pragma once
+#ifndef ES_CORE_UTILS_HASH_UTIL_H
+#define ES_CORE_UTILS_HASH_UTIL_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <atomic>
+#include <string>
+
+namespace Utils
+{
+	namespace Hash
+	{
+		// Computes the CRC32, MD5 and SHA1 of a stream of data in a single pass over it, the way scraper databases
+		// identify ROMs. Results are lowercase hex strings and only valid after finish().
+		class Hasher
+		{
+		public:
+
+			Hasher();
+
+			void        update (const void* _data, const size_t _length);
+			void        finish ();
+			std::string getCRC32() const;
+			std::string getMD5  () const;
+			std::string getSHA1 () const;
+
+		private:
+
+			void processMD5 (const unsigned char* _block);
+			void processSHA1(const unsigned char* _block);
+
+			uint32_t      mCRC32;
+			uint32_t      mMD5[4];
+			uint32_t      mSHA1[5];
+			unsigned char mBlock[64];
+			size_t        mBlockLength;
+			uint64_t      mLength;
+
+		}; // Hasher
+
+		// Hashes the file at _path, false if it couldn't be read. _abort is checked between reads when it's set
+		bool hashFile(const std::string& _path, Hasher& _hasher, const std::atomic<bool>* _abort = nullptr);
+
+	} // Hash::
+
+} // Utils::
+
+#endif // ES_CORE_UTILS_HASH_UTIL_H
@@ -7,14 +7,19 @@
 #include "Log.h"
 
 #include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdlib>
+#include <limits>
+#include <mutex>
+#include <new>
+#include <stdint.h>
+#include <vector>
 
 #if defined(_WIN32)
 // because windows...
-#include <Windows.h>
 #define snprintf _snprintf
-#else // _WIN32
-#include <sys/time.h>
-#endif // !_WIN32
+#endif // _WIN32
 
 //////////////////////////////////////////////////////////////////////////
 
@@ -22,152 +27,137 @@ namespace Utils
 {
 	namespace Profiling
 	{
-		std::vector<Profile*>     profiles;
-		std::vector<ThreadStack*> threadStacks;
-		std::recursive_mutex      mutex;
-		unsigned int              counter = 0;
+		// times are kept in nanoseconds until they're dumped
+		struct Profile
+		{
+			std::string  message;
+			int64_t      timeTotal;
+			int64_t      timeExternal;
+			int64_t      timeMin;
+			int64_t      timeMax;
+			unsigned int callCount;
 
-//////////////////////////////////////////////////////////////////////////
+		}; // Profile
 
-		static double getFrequency( void )
+		struct Frame
 		{
-#if defined(_WIN32)
-			uint64_t qpFrequency;
-			QueryPerformanceFrequency((LARGE_INTEGER*)&qpFrequency);
-			return 1.0 / qpFrequency;
-#else // _WIN32
-			return 1.0 / 1000000.0;
-#endif // _WIN32
-		} // getFrequency
+			unsigned int index;
+			int64_t      timeBegin;
+			int64_t      timeExternal;
 
-//////////////////////////////////////////////////////////////////////////
+		}; // Frame
 
-	static uint64_t getCounter( void )
-	{
-#if defined(_WIN32)
-			uint64_t qpCounter;
-			QueryPerformanceCounter((LARGE_INTEGER*)&qpCounter);
-			return qpCounter;
-#else // _WIN32
-			timeval tv;
-			gettimeofday(&tv, nullptr);
-			return static_cast<uint64_t>(tv.tv_sec) * 1000000u + static_cast<uint64_t>(tv.tv_usec);
-#endif // !_WIN32
-	} // getCounter
+		// only ever touched by its own thread, and by _dump once the thread is done
+		struct ThreadData
+		{
+			std::vector<Profile> profiles;
+			std::vector<Frame>   stack;
+
+		}; // ThreadData
+
+		static std::vector<ThreadData*>  threads;
+		static std::mutex                threadsMutex;
+		static std::atomic<unsigned int> counter(0);
+
+		static std::atomic<uint64_t> allocationCount(0);
 
 //////////////////////////////////////////////////////////////////////////
 
-		static double getTime(void)
+		static int64_t getTime(void)
 		{
-			return getCounter() * getFrequency();
+			return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
 
 		} // getTime
 
 //////////////////////////////////////////////////////////////////////////
 
-		static bool _sortProfiles(const Profile* _a, const Profile* _b)
+		static ThreadData* getThreadData(void)
 		{
-			return _a->message < _b->message;
+			// the lock is only taken the first time a thread profiles something
+			static thread_local ThreadData* threadData = nullptr;
 
-		} // _sortProfiles
+			if(!threadData)
+			{
+				threadData = new ThreadData;
+
+				std::unique_lock<std::mutex> lock(threadsMutex);
+				threads.push_back(threadData);
+			}
+
+			return threadData;
+
+		} // getThreadData
 
 //////////////////////////////////////////////////////////////////////////
 
-		unsigned int _generateIndex(void)
+		static bool _sortProfiles(const Profile& _a, const Profile& _b)
 		{
-			mutex.lock();
-			unsigned int index = counter++;
-			mutex.unlock();
+			return _a.message < _b.message;
 
-			return index;
-
-		} // _generateIndex
+		} // _sortProfiles
 
 //////////////////////////////////////////////////////////////////////////
 
-		void _begin(const unsigned int _index, const std::string& _message)
+		unsigned int _generateIndex(void)
 		{
-			const std::thread::id threadId    = std::this_thread::get_id();
-			ThreadStack*          threadStack = nullptr;
-			Profile*              profile     = nullptr;
+			return counter++;
 
-			mutex.lock();
-
-			for( ThreadStack* threadStackIt : threadStacks )
-				if(threadStackIt->id == threadId)
-					threadStack = threadStackIt;
+		} // _generateIndex
 
-			if(!threadStack)
-			{
-				threadStack     = new ThreadStack;
-				threadStack->id = threadId;
+//////////////////////////////////////////////////////////////////////////
 
-				threadStacks.push_back(threadStack);
-			}
+		void _begin(const unsigned int _index, const char* _message)
+		{
+			ThreadData* threadData = getThreadData();
 
-			while(profiles.size() < counter)
+			if(threadData->profiles.size() <= _index)
 			{
-				profile               = new Profile;
-				profile->message      = "";
-				profile->timeBegin    = 0.0;
-				profile->timeTotal    = 0.0;
-				profile->timeExternal = 0.0;
-				profile->timeMin      = 999999999.0;
-				profile->timeMax      = 0.0;
-				profile->callCount    = 0;
-
-				profiles.push_back(profile);
+				Profile profile = { "", 0, 0, std::numeric_limits<int64_t>::max(), 0, 0 };
+				threadData->profiles.resize(_index + 1, profile);
 			}
 
-			profile = profiles[_index];
-
-			threadStack->stack.push(profile);
-
-			profile->message   = _message;
-			profile->timeBegin = getTime();
+			// a scope keeps its message, it's only copied the first time this thread gets to it
+			Profile& profile = threadData->profiles[_index];
+			if(profile.message.empty())
+				profile.message = _message;
 
-			mutex.unlock();
+			Frame frame = { _index, 0, 0 };
+			threadData->stack.push_back(frame);
+			threadData->stack.back().timeBegin = getTime();
 
 		} // _begin
 
 //////////////////////////////////////////////////////////////////////////
 
-		int _end(void)
+		void _begin(const unsigned int _index, const std::string& _message)
 		{
-			const double          timeEnd     = getTime();
-			const std::thread::id threadId    = std::this_thread::get_id();
-			ThreadStack*          threadStack = nullptr;
-			Profile*              profile     = nullptr;
-
-			mutex.lock();
+			_begin(_index, _message.c_str());
 
-			for( ThreadStack* threadStackIt : threadStacks )
-				if(threadStackIt->id == threadId)
-					threadStack = threadStackIt;
+		} // _begin
 
-			profile = threadStack->stack.top();
-			threadStack->stack.pop();
+//////////////////////////////////////////////////////////////////////////
 
-			// timer wrapped (~24 days)
-			if(timeEnd < profile->timeBegin)
-			{
-				mutex.unlock();
-				return 0;
-			}
+		double _end(void)
+		{
+			const int64_t timeEnd    = getTime();
+			ThreadData*   threadData = getThreadData();
+			const Frame   frame      = threadData->stack.back();
 
-			const double timeElapsed = timeEnd - profile->timeBegin;
+			threadData->stack.pop_back();
 
-			profile->timeTotal += timeElapsed;
-			profile->timeMin    = (profile->timeMin < timeElapsed) ? profile->timeMin : timeElapsed;
-			profile->timeMax    = (profile->timeMax > timeElapsed) ? profile->timeMax : timeElapsed;
-			profile->callCount++;
+			Profile&      profile     = threadData->profiles[frame.index];
+			const int64_t timeElapsed = timeEnd - frame.timeBegin;
 
-			if(!threadStack->stack.empty())
-				threadStack->stack.top()->timeExternal += timeElapsed;
+			profile.timeTotal    += timeElapsed;
+			profile.timeExternal += frame.timeExternal;
+			profile.timeMin       = (profile.timeMin < timeElapsed) ? profile.timeMin : timeElapsed;
+			profile.timeMax       = (profile.timeMax > timeElapsed) ? profile.timeMax : timeElapsed;
+			profile.callCount++;
 
-			mutex.unlock();
+			if(!threadData->stack.empty())
+				threadData->stack.back().timeExternal += timeElapsed;
 
-			return timeElapsed;
+			return timeElapsed / 1000000000.0;
 
 		} // _end
 
@@ -175,6 +165,43 @@ namespace Utils
 
 		void _dump(void)
 		{
+			std::vector<Profile> profiles;
+
+			{
+				std::unique_lock<std::mutex> lock(threadsMutex);
+
+				// the same scope on every thread adds up to one line
+				for(ThreadData* threadData : threads)
+				{
+					if(profiles.size() < threadData->profiles.size())
+					{
+						Profile profile = { "", 0, 0, std::numeric_limits<int64_t>::max(), 0, 0 };
+						profiles.resize(threadData->profiles.size(), profile);
+					}
+
+					for(size_t i = 0; i < threadData->profiles.size(); ++i)
+					{
+						Profile&       merged  = profiles[i];
+						const Profile& profile = threadData->profiles[i];
+
+						if(!profile.callCount)
+							continue;
+
+						if(merged.message.empty())
+							merged.message = profile.message;
+
+						merged.timeTotal    += profile.timeTotal;
+						merged.timeExternal += profile.timeExternal;
+						merged.timeMin       = std::min(merged.timeMin, profile.timeMin);
+						merged.timeMax       = std::max(merged.timeMax, profile.timeMax);
+						merged.callCount    += profile.callCount;
+					}
+
+					// a thread still inside a scope keeps its stack, its times start over
+					threadData->profiles.clear();
+				}
+			}
+
 			std::sort(profiles.begin(), profiles.end(), _sortProfiles);
 
 			if(!profiles.empty())
@@ -182,8 +209,8 @@ namespace Utils
 				char buffer[1024];
 				int  longestMessage = 0;
 
-				for(Profile* profile : profiles)
-					longestMessage = Math::max(longestMessage, (int)profile->message.length());
+				for(const Profile& profile : profiles)
+					longestMessage = Math::max(longestMessage, (int)profile.message.length());
 
 				char format1[1024];
 				snprintf(format1, 1024, "%%-%ds\t%%12s\t%%12s\t%%12s\t%%12s\t%%12s\t%%20s\t%%20s", longestMessage);
@@ -194,32 +221,53 @@ namespace Utils
 				char format2[1024];
 				snprintf(format2, 1024, "%%-%ds\t%%12d\t%%12.6f\t%%12.6f\t%%12.6f\t%%12.6f\t%%20.6f\t%%20.6f", longestMessage);
 
-				for(Profile* profile : profiles)
+				for(const Profile& profile : profiles)
 				{
-					if(profile->message.length())
+					if(profile.callCount)
 					{
-						snprintf(buffer, 1024, format2, profile->message.c_str(), profile->callCount, profile->timeTotal, profile->timeTotal / profile->callCount, profile->timeMin, profile->timeMax, profile->timeTotal - profile->timeExternal, (profile->timeTotal - profile->timeExternal) / profile->callCount);
+						const double timeTotal    = profile.timeTotal / 1000000000.0;
+						const double timeInternal = (profile.timeTotal - profile.timeExternal) / 1000000000.0;
+
+						snprintf(buffer, 1024, format2, profile.message.c_str(), profile.callCount, timeTotal, timeTotal / profile.callCount, profile.timeMin / 1000000000.0, profile.timeMax / 1000000000.0, timeInternal, timeInternal / profile.callCount);
 						LOG(LogDebug) << buffer;
 					}
-
-					delete profile;
 				}
-
-				profiles.clear();
 			}
 
-			if(!threadStacks.empty())
-			{
-				for(ThreadStack* threadStack : threadStacks)
-					delete threadStack;
+		} // _dump
 
-				threadStacks.clear();
-			}
+//////////////////////////////////////////////////////////////////////////
 
-		} // _dump
+		uint64_t getAllocationCount(void)
+		{
+			return allocationCount;
+
+		} // getAllocationCount
 
 	} // Profiling::
 
 } // Utils::
 
+//////////////////////////////////////////////////////////////////////////
+
+// every allocation made through new is counted, the profiled sections compare the count before and after
+void* operator new(std::size_t _size)
+{
+	Utils::Profiling::allocationCount++;
+
+	void* pointer = malloc(_size ? _size : 1);
+
+	if(!pointer)
+		throw std::bad_alloc();
+
+	return pointer;
+
+} // operator new
+
+void operator delete(void* _pointer) noexcept
+{
+	free(_pointer);
+
+} // operator delete
+
 #endif // USE_PROFILING
@@ -4,53 +4,32 @@
 
 #if defined(USE_PROFILING)
 
-#include <mutex>
-#include <stack>
+#include <stdint.h>
 #include <string>
-#include <thread>
-#include <vector>
 
 namespace Utils
 {
 	namespace Profiling
 	{
-		struct Profile
-		{
-			std::string  message;
-			double       timeBegin;
-			double       timeTotal;
-			double       timeExternal;
-			double       timeMin;
-			double       timeMax;
-			unsigned int callCount;
-
-		}; // Profile
-
-		struct ThreadStack
-		{
-			std::stack<Profile*> stack;
-			std::thread::id      id;
-
-		}; // ThreadStack
-
-		extern std::vector<Profile*>     profiles;
-		extern std::vector<ThreadStack*> threadStacks;
-		extern std::recursive_mutex      mutex;
-		extern unsigned int              counter;
-
-//////////////////////////////////////////////////////////////////////////
+		// Every thread times its scopes on a stack of its own without taking any lock, the threads are only merged
+		// in _dump. The threads that profiled something have to be done with it by then
 
 		unsigned int _generateIndex(void);
+		void         _begin        (const unsigned int _index, const char* _message);
 		void         _begin        (const unsigned int _index, const std::string& _message);
-		int          _end          (void);
+		double       _end          (void);
 		void         _dump         (void);
 
+		// allocations made through new since the program started
+		uint64_t     getAllocationCount(void);
+
 //////////////////////////////////////////////////////////////////////////
 
 		class Scope
 		{
 		public:
 
+			 Scope(const unsigned int _index, const char* _message)        { _begin(_index, _message); }
 			 Scope(const unsigned int _index, const std::string& _message) { _begin(_index, _message); }
 			~Scope(void)                                                   { _end(); }
 
@@ -1,7 +1,16 @@
 #include "utils/StringUtil.h"
 
+#include "MemoryUsage.h"
 #include <algorithm>
+#include <functional>
+#include <mutex>
 #include <stdarg.h>
+#include <unordered_set>
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#elif defined(__ARM_NEON) || defined(__ARM_NEON__)
+#include <arm_neon.h>
+#endif
 
 //////////////////////////////////////////////////////////////////////////
 
@@ -9,6 +18,19 @@ namespace Utils
 {
 	namespace String
 	{
+		// split up so threads loading different systems rarely wait on each other
+		static const size_t INTERN_SHARD_COUNT = 64;
+
+		struct InternShard
+		{
+			std::mutex                      mutex;
+			std::unordered_set<std::string> strings;
+		};
+
+		static InternShard internShards[INTERN_SHARD_COUNT];
+
+//////////////////////////////////////////////////////////////////////////
+
 		unsigned int chars2Unicode(const std::string& _string, size_t& _cursor)
 		{
 			const char&  c      = _string[_cursor];
@@ -145,14 +167,57 @@ namespace Utils
 
 		} // moveCursor
 
+//////////////////////////////////////////////////////////////////////////
+
+		// Flips the case of the characters from _first to _last. Only ASCII letters change, every byte of a UTF-8 sequence
+		// is above 0x7F and left alone, which is what toupper and tolower do in the "C" locale. 16 bytes are done at once
+		// where the CPU has the instructions for it, names and sort keys go through here for every game
+		static void flipCase(char* _data, const size_t _size, const char _first, const char _last)
+		{
+			size_t i = 0;
+
+#if defined(__SSE2__)
+			// the compares are signed, bytes above 0x7F are negative and never in range
+			const __m128i first = _mm_set1_epi8((char)(_first - 1));
+			const __m128i last  = _mm_set1_epi8((char)(_last + 1));
+			const __m128i flip  = _mm_set1_epi8(0x20);
+
+			for(; (i + 16) <= _size; i += 16)
+			{
+				const __m128i chars = _mm_loadu_si128((const __m128i*)(_data + i));
+				const __m128i mask  = _mm_and_si128(_mm_cmpgt_epi8(chars, first), _mm_cmplt_epi8(chars, last));
+
+				_mm_storeu_si128((__m128i*)(_data + i), _mm_xor_si128(chars, _mm_and_si128(mask, flip)));
+			}
+#elif defined(__ARM_NEON) || defined(__ARM_NEON__)
+			const uint8x16_t first = vdupq_n_u8((uint8_t)_first);
+			const uint8x16_t last  = vdupq_n_u8((uint8_t)_last);
+			const uint8x16_t flip  = vdupq_n_u8(0x20);
+
+			for(; (i + 16) <= _size; i += 16)
+			{
+				const uint8x16_t chars = vld1q_u8((const uint8_t*)(_data + i));
+				const uint8x16_t mask  = vandq_u8(vcgeq_u8(chars, first), vcleq_u8(chars, last));
+
+				vst1q_u8((uint8_t*)(_data + i), veorq_u8(chars, vandq_u8(mask, flip)));
+			}
+#endif // __SSE2__ || __ARM_NEON
+
+			for(; i < _size; ++i)
+			{
+				if((unsigned char)(_data[i] - _first) <= (unsigned char)(_last - _first))
+					_data[i] ^= 0x20;
+			}
+
+		} // flipCase
+
 //////////////////////////////////////////////////////////////////////////
 
 		std::string toLower(const std::string& _string)
 		{
-			std::string string;
+			std::string string = _string;
 
-			for(size_t i = 0; i < _string.length(); ++i)
-				string += (char)tolower(_string[i]);
+			makeLower(string);
 
 			return string;
 
@@ -162,15 +227,32 @@ namespace Utils
 
 		std::string toUpper(const std::string& _string)
 		{
-			std::string string;
+			std::string string = _string;
 
-			for(size_t i = 0; i < _string.length(); ++i)
-				string += (char)toupper(_string[i]);
+			makeUpper(string);
 
 			return string;
 
 		} // toUpper
 
+//////////////////////////////////////////////////////////////////////////
+
+		void makeLower(std::string& _string)
+		{
+			if(!_string.empty())
+				flipCase(&_string[0], _string.size(), 'A', 'Z');
+
+		} // makeLower
+
+//////////////////////////////////////////////////////////////////////////
+
+		void makeUpper(std::string& _string)
+		{
+			if(!_string.empty())
+				flipCase(&_string[0], _string.size(), 'a', 'z');
+
+		} // makeUpper
+
 //////////////////////////////////////////////////////////////////////////
 
 		std::string trim(const std::string& _string)
@@ -324,6 +406,37 @@ namespace Utils
 
 		} // scramble
 
+//////////////////////////////////////////////////////////////////////////
+
+		const std::string* intern(const std::string& _string)
+		{
+			InternShard&                       shard = internShards[std::hash<std::string>()(_string) % INTERN_SHARD_COUNT];
+			const std::unique_lock<std::mutex> lock(shard.mutex);
+
+			// elements of an unordered_set never move, so the pointer stays valid while the set grows
+			const auto inserted = shard.strings.insert(_string);
+
+			if(inserted.second)
+			{
+				// the node and its string
+				MemoryUsage::add(MemoryUsage::METADATA, sizeof(std::string) + (2 * sizeof(void*)) + getHeapSize(*inserted.first));
+			}
+
+			return &(*inserted.first);
+
+		} // intern
+
+//////////////////////////////////////////////////////////////////////////
+
+		size_t getHeapSize(const std::string& _string)
+		{
+			// the buffer of a short string is inside the string object
+			const bool inside = (_string.data() >= (const char*)&_string) && (_string.data() < (const char*)(&_string + 1));
+
+			return inside ? 0 : (_string.capacity() + 1);
+
+		} // getHeapSize
+
 	} // String::
 
 } // Utils::
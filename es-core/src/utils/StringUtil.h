@@ -18,6 +18,8 @@ namespace Utils
 		size_t       moveCursor             (const std::string& _string, const size_t _cursor, const int _amount);
 		std::string  toLower                (const std::string& _string);
 		std::string  toUpper                (const std::string& _string);
+		void         makeLower              (std::string& _string);
+		void         makeUpper              (std::string& _string);
 		std::string  trim                   (const std::string& _string);
 		std::string  replace                (const std::string& _string, const std::string& _replace, const std::string& _with);
 		bool         startsWith             (const std::string& _string, const std::string& _start);
@@ -28,6 +30,12 @@ namespace Utils
 		std::string  format                 (const char* _string, ...);
 		std::string  scramble               (const std::string& _input, const std::string& key);
 
+		// Returns the one shared copy of _string, equal strings get the same pointer. Interned strings live until exit.
+		const std::string* intern           (const std::string& _string);
+
+		// The bytes _string allocated on the heap, 0 for a short one that's kept inside the string object
+		size_t       getHeapSize            (const std::string& _string);
+
 	} // String::
 
 } // Utils::
@@ -0,0 +1,312 @@
+#include "utils/TaskScheduler.h"
+
+#include <algorithm>
+#include <chrono>
+
+#if WIN32
+#include <Windows.h>
+#endif
+
+//////////////////////////////////////////////////////////////////////////
+
+namespace Utils
+{
+	// the worker of the scheduler thread running this, nullptr on every other thread
+	static thread_local void* sCurrentWorker = nullptr;
+
+	TaskScheduler* TaskScheduler::sInstance = nullptr;
+
+	void TaskScheduler::init()
+	{
+		if(!sInstance)
+			sInstance = new TaskScheduler();
+
+	} // init
+
+//////////////////////////////////////////////////////////////////////////
+
+	void TaskScheduler::deinit()
+	{
+		if(sInstance)
+		{
+			delete sInstance;
+			sInstance = nullptr;
+		}
+
+	} // deinit
+
+//////////////////////////////////////////////////////////////////////////
+
+	TaskScheduler* TaskScheduler::getInstance()
+	{
+		if(!sInstance)
+			sInstance = new TaskScheduler();
+
+		return sInstance;
+
+	} // getInstance
+
+//////////////////////////////////////////////////////////////////////////
+
+	TaskScheduler::TaskScheduler() : mQueued(0), mSleeping(0), mExit(false)
+	{
+		// at least one, or the tasks nothing waits for would never run
+		const size_t cores   = std::thread::hardware_concurrency();
+		const size_t threads = std::max<size_t>(cores, 2) - 1;
+
+		for(size_t i = 0; i < threads; i++)
+			mWorkers.push_back(std::unique_ptr<Worker>(new Worker()));
+
+		// started once every worker exists, they steal from each other right away
+		for(size_t i = 0; i < threads; i++)
+		{
+			Worker* worker = mWorkers[i].get();
+			worker->thread = std::thread(&TaskScheduler::threadProc, this, worker);
+
+#if WIN32
+			SetThreadAffinityMask(worker->thread.native_handle(), (static_cast<DWORD_PTR>(1) << i));
+#endif
+		}
+
+	} // TaskScheduler
+
+//////////////////////////////////////////////////////////////////////////
+
+	TaskScheduler::~TaskScheduler()
+	{
+		// the threads finish what was queued before they exit
+		{
+			std::lock_guard<std::mutex> lock(mSleepMutex);
+			mExit = true;
+		}
+		mWake.notify_all();
+
+		for(auto it = mWorkers.cbegin(); it != mWorkers.cend(); ++it)
+		{
+			if((*it)->thread.joinable())
+				(*it)->thread.join();
+		}
+
+		// queued by the last tasks while the threads were exiting
+		while(runTask());
+
+	} // ~TaskScheduler
+
+//////////////////////////////////////////////////////////////////////////
+
+	void TaskScheduler::queue(const Task& _task, const Priority _priority, Group* _group)
+	{
+		Task task = _task;
+		if(_group)
+		{
+			_group->add();
+			task = [_task, _group]
+			{
+				try
+				{
+					_task();
+				}
+				catch(...) {}
+
+				_group->finished();
+			};
+		}
+
+		Worker* worker = sCurrentWorker ? (Worker*)sCurrentWorker : &mShared;
+		{
+			std::lock_guard<std::mutex> lock(worker->mutex);
+			worker->tasks[_priority].push_back(std::move(task));
+		}
+		mQueued++;
+
+		// a thread going to sleep counts itself before it looks at mQueued, one of the two sees the other
+		if(mSleeping.load() > 0)
+		{
+			{
+				std::lock_guard<std::mutex> lock(mSleepMutex);
+			}
+			mWake.notify_one();
+		}
+
+	} // queue
+
+//////////////////////////////////////////////////////////////////////////
+
+	bool TaskScheduler::runTask()
+	{
+		if(mQueued.load() <= 0)
+			return false;
+
+		Worker* self = (Worker*)sCurrentWorker;
+		Task    task;
+
+		for(int priority = PRIORITY_HIGH; priority < PRIORITY_COUNT; priority++)
+		{
+			if(takeTask(self, (Priority)priority, task))
+			{
+				mQueued--;
+
+				try
+				{
+					task();
+				}
+				catch(...) {}
+
+				return true;
+			}
+		}
+
+		return false;
+
+	} // runTask
+
+//////////////////////////////////////////////////////////////////////////
+
+	bool TaskScheduler::takeTask(Worker* _self, const Priority _priority, Task& _task)
+	{
+		// its own newest first
+		if(_self)
+		{
+			std::lock_guard<std::mutex> lock(_self->mutex);
+			std::deque<Task>& tasks = _self->tasks[_priority];
+			if(!tasks.empty())
+			{
+				_task = std::move(tasks.back());
+				tasks.pop_back();
+				return true;
+			}
+		}
+
+		// then the shared ones and the ones of the other threads, oldest first
+		{
+			std::lock_guard<std::mutex> lock(mShared.mutex);
+			std::deque<Task>& tasks = mShared.tasks[_priority];
+			if(!tasks.empty())
+			{
+				_task = std::move(tasks.front());
+				tasks.pop_front();
+				return true;
+			}
+		}
+
+		// starting after itself, so the threads don't all steal from the first one
+		size_t start = 0;
+		for(size_t i = 0; i < mWorkers.size(); i++)
+		{
+			if(mWorkers[i].get() == _self)
+				start = i + 1;
+		}
+
+		for(size_t i = 0; i < mWorkers.size(); i++)
+		{
+			Worker* victim = mWorkers[(start + i) % mWorkers.size()].get();
+			if(victim == _self)
+				continue;
+
+			std::lock_guard<std::mutex> lock(victim->mutex);
+			std::deque<Task>& tasks = victim->tasks[_priority];
+			if(!tasks.empty())
+			{
+				_task = std::move(tasks.front());
+				tasks.pop_front();
+				return true;
+			}
+		}
+
+		return false;
+
+	} // takeTask
+
+//////////////////////////////////////////////////////////////////////////
+
+	void TaskScheduler::threadProc(Worker* _worker)
+	{
+		sCurrentWorker = _worker;
+
+		while(true)
+		{
+			if(runTask())
+				continue;
+
+			std::unique_lock<std::mutex> lock(mSleepMutex);
+			mSleeping++;
+			mWake.wait(lock, [this] { return mExit || (mQueued.load() > 0); });
+			mSleeping--;
+
+			if(mExit && (mQueued.load() <= 0))
+				return;
+		}
+
+	} // threadProc
+
+//////////////////////////////////////////////////////////////////////////
+
+	TaskScheduler::Group::Group() : mPending(0)
+	{
+
+	} // Group
+
+//////////////////////////////////////////////////////////////////////////
+
+	TaskScheduler::Group::~Group()
+	{
+		wait();
+
+	} // ~Group
+
+//////////////////////////////////////////////////////////////////////////
+
+	void TaskScheduler::Group::wait()
+	{
+		TaskScheduler* scheduler = TaskScheduler::getInstance();
+
+		while(mPending.load() > 0)
+		{
+			if(scheduler->runTask())
+				continue;
+
+			// what's left runs on other threads
+			std::unique_lock<std::mutex> lock(mMutex);
+			mDone.wait(lock, [this] { return mPending.load() == 0; });
+		}
+
+		// the last task may still be notifying, it mustn't outlive the group
+		std::lock_guard<std::mutex> lock(mMutex);
+
+	} // wait
+
+//////////////////////////////////////////////////////////////////////////
+
+	void TaskScheduler::Group::wait(const std::function<void()>& _work, int _delay)
+	{
+		while(mPending.load() > 0)
+		{
+			_work();
+
+			std::unique_lock<std::mutex> lock(mMutex);
+			mDone.wait_for(lock, std::chrono::milliseconds(_delay), [this] { return mPending.load() == 0; });
+		}
+
+		std::lock_guard<std::mutex> lock(mMutex);
+
+	} // wait
+
+//////////////////////////////////////////////////////////////////////////
+
+	void TaskScheduler::Group::add()
+	{
+		mPending++;
+
+	} // add
+
+//////////////////////////////////////////////////////////////////////////
+
+	void TaskScheduler::Group::finished()
+	{
+		std::lock_guard<std::mutex> lock(mMutex);
+		if(--mPending == 0)
+			mDone.notify_all();
+
+	} // finished
+
+} // Utils::
@@ -0,0 +1,259 @@
+#pragma once
+#ifndef ES_CORE_UTILS_TASK_SCHEDULER_H
+#define ES_CORE_UTILS_TASK_SCHEDULER_H
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace Utils
+{
+	// Runs tasks on one thread per core but the one drawing, started once for the whole run. Every thread has a queue of
+	// its own, the tasks a task queues go there and are taken newest first while they're still likely in the cache. An
+	// idle thread takes the oldest tasks of the others, tasks queued from other threads are shared by all of them. Higher
+	// priorities go first everywhere. Waiting for a task or a group runs queued tasks on the waiting thread until there
+	// are none left, then blocks, so a task can wait for the tasks it queued without holding up a thread
+	class TaskScheduler
+	{
+	public:
+
+		enum Priority
+		{
+			PRIORITY_HIGH   = 0, // something on screen waits for it
+			PRIORITY_NORMAL = 1,
+			PRIORITY_LOW    = 2, // nothing waits for it, like writing a file
+			PRIORITY_COUNT  = 3
+		};
+
+		typedef std::function<void()> Task;
+
+		// Counts the tasks queued with it, they have to be done before it's destroyed. Exceptions of its tasks are dropped
+		class Group
+		{
+		public:
+
+			 Group();
+			~Group();
+
+			void wait();
+			// Calls _work every _delay ms while waiting instead of running tasks, like drawing a loading screen
+			void wait(const std::function<void()>& _work, int _delay);
+
+			bool isDone() const { return mPending.load() == 0; }
+
+		private:
+
+			friend class TaskScheduler;
+
+			void add     ();
+			void finished();
+
+			std::atomic<int>        mPending;
+			std::mutex              mMutex;
+			std::condition_variable mDone;
+
+		}; // Group
+
+		template<typename T> class Future;
+
+		static void           init       ();
+		static void           deinit     ();
+		static TaskScheduler* getInstance();
+
+		// Runs _task on a scheduler thread, counted by _group if there is one
+		void queue(const Task& _task, const Priority _priority = PRIORITY_NORMAL, Group* _group = nullptr);
+
+		// Runs _work on a scheduler thread, its result or what it threw is handed out by the Future
+		template<typename T> Future<T> run(const std::function<T()>& _work, const Priority _priority = PRIORITY_NORMAL);
+
+		// Runs the queued task that would go next on the calling thread, returns false if nothing was queued
+		bool runTask();
+
+		size_t getThreadCount() const { return mWorkers.size(); }
+
+	private:
+
+		struct Worker
+		{
+			std::deque<Task> tasks[PRIORITY_COUNT];
+			std::mutex       mutex;
+			std::thread      thread;
+		};
+
+		template<typename T> struct Value;
+		template<typename T> struct State;
+
+		 TaskScheduler();
+		~TaskScheduler();
+
+		void threadProc(Worker* _worker);
+
+		// Takes the next task of _priority for _self, which is nullptr on threads that aren't the scheduler's
+		bool takeTask(Worker* _self, const Priority _priority, Task& _task);
+
+		static TaskScheduler* sInstance;
+
+		std::vector<std::unique_ptr<Worker>> mWorkers;
+		Worker                               mShared; // queued from threads that aren't the scheduler's
+		std::atomic<int>                     mQueued;
+		std::atomic<int>                     mSleeping;
+		std::mutex                           mSleepMutex;
+		std::condition_variable              mWake;
+		bool                                 mExit;
+
+	}; // TaskScheduler
+
+//////////////////////////////////////////////////////////////////////////
+
+	template<typename T>
+	struct TaskScheduler::Value
+	{
+		template<typename F> void set(F& _work) { value.reset(new T(_work())); }
+		T get() const { return *value; }
+
+		std::unique_ptr<T> value;
+
+	}; // Value
+
+	template<>
+	struct TaskScheduler::Value<void>
+	{
+		template<typename F> void set(F& _work) { _work(); }
+		void get() const { }
+
+	}; // Value<void>
+
+	template<typename T>
+	struct TaskScheduler::State
+	{
+		State() : done(false) { }
+
+		template<typename F>
+		void run(F& _work)
+		{
+			try
+			{
+				value.set(_work);
+			}
+			catch(...)
+			{
+				exception = std::current_exception();
+			}
+
+			std::vector<std::pair<Task, Priority>> next;
+			{
+				std::lock_guard<std::mutex> lock(mutex);
+				done = true;
+				next.swap(continuations);
+				ready.notify_all();
+			}
+
+			for(auto it = next.cbegin(); it != next.cend(); ++it)
+				TaskScheduler::getInstance()->queue(it->first, it->second);
+		}
+
+		void wait()
+		{
+			while(!isDone())
+			{
+				if(TaskScheduler::getInstance()->runTask())
+					continue;
+
+				// what's left runs on other threads
+				std::unique_lock<std::mutex> lock(mutex);
+				ready.wait(lock, [this] { return done; });
+			}
+		}
+
+		bool isDone()
+		{
+			std::lock_guard<std::mutex> lock(mutex);
+			return done;
+		}
+
+		Value<T>                               value;
+		std::exception_ptr                     exception;
+		bool                                   done;
+		std::vector<std::pair<Task, Priority>> continuations;
+		std::mutex                             mutex;
+		std::condition_variable                ready;
+
+	}; // State
+
+	template<typename T>
+	class TaskScheduler::Future
+	{
+	public:
+
+		Future() { }
+
+		bool isValid() const { return mState != nullptr; }
+		bool isReady() const { return mState && mState->isDone(); }
+
+		// The result of the work once it's done, throws what the work threw
+		T get() const
+		{
+			mState->wait();
+			if(mState->exception)
+				std::rethrow_exception(mState->exception);
+
+			return mState->value.get();
+		}
+
+		void wait() const { mState->wait(); }
+
+		// Runs _next with this future once it's ready, the result of _next is in the returned Future
+		template<typename R>
+		Future<R> then(const std::function<R(const Future<T>&)>& _next, const Priority _priority = PRIORITY_NORMAL) const
+		{
+			const Future<T>                self = *this;
+			std::shared_ptr<State<R>>      state(new State<R>());
+			const std::function<R()>       work = [self, _next] { return _next(self); };
+			const Task                     task = [state, work] { state->run(work); };
+
+			bool ready;
+			{
+				std::lock_guard<std::mutex> lock(mState->mutex);
+				ready = mState->done;
+				if(!ready)
+					mState->continuations.push_back(std::make_pair(task, _priority));
+			}
+
+			if(ready)
+				TaskScheduler::getInstance()->queue(task, _priority);
+
+			Future<R> future;
+			future.mState = state;
+			return future;
+		}
+
+	private:
+
+		friend class TaskScheduler;
+		template<typename> friend class TaskScheduler::Future;
+
+		std::shared_ptr<State<T>> mState;
+
+	}; // Future
+
+	template<typename T>
+	TaskScheduler::Future<T> TaskScheduler::run(const std::function<T()>& _work, const Priority _priority)
+	{
+		std::shared_ptr<State<T>> state(new State<T>());
+		queue([state, _work] { state->run(_work); }, _priority);
+
+		Future<T> future;
+		future.mState = state;
+		return future;
+
+	} // run
+
+} // Utils::
+
+#endif // ES_CORE_UTILS_TASK_SCHEDULER_H
@@ -0,0 +1,226 @@
+#include "utils/TimelineUtil.h"
+
+#include "utils/FileSystemUtil.h"
+#include <atomic>
+#include <chrono>
+#include <fstream>
+#include <algorithm>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+
+//////////////////////////////////////////////////////////////////////////
+
+namespace Utils
+{
+	namespace Timeline
+	{
+		struct Event
+		{
+			const char* name;
+			std::string detail;
+			int64_t     begin;
+			int64_t     duration;
+			int         thread;
+
+		}; // Event
+
+		static std::atomic<bool>   started(false);
+		static std::atomic<int>    threadCounter(0);
+		static std::mutex          mutex;
+		static std::vector<Event>  events;
+
+		static const std::chrono::steady_clock::time_point startTime = std::chrono::steady_clock::now();
+
+//////////////////////////////////////////////////////////////////////////
+
+		static int64_t getMicroseconds(void)
+		{
+			return std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - startTime).count();
+
+		} // getMicroseconds
+
+//////////////////////////////////////////////////////////////////////////
+
+		static int getThread(void)
+		{
+			// small numbers read better than thread ids in the viewer, threads are numbered as they first finish a scope
+			static thread_local int thread = threadCounter++;
+			return thread;
+
+		} // getThread
+
+//////////////////////////////////////////////////////////////////////////
+
+		static std::string escape(const std::string& _string)
+		{
+			std::string escaped;
+			escaped.reserve(_string.size());
+
+			for(char c : _string)
+			{
+				if((c == '"') || (c == '\\'))
+					escaped += '\\';
+
+				if((unsigned char)c >= 0x20)
+					escaped += c;
+			}
+
+			return escaped;
+
+		} // escape
+
+//////////////////////////////////////////////////////////////////////////
+
+		void start(void)
+		{
+			std::unique_lock<std::mutex> lock(mutex);
+
+			events.clear();
+			started = true;
+
+		} // start
+
+//////////////////////////////////////////////////////////////////////////
+
+		void stop(void)
+		{
+			started = false;
+
+		} // stop
+
+//////////////////////////////////////////////////////////////////////////
+
+		bool isStarted(void)
+		{
+			return started;
+
+		} // isStarted
+
+//////////////////////////////////////////////////////////////////////////
+
+		int64_t getTime(void)
+		{
+			return getMicroseconds();
+
+		} // getTime
+
+//////////////////////////////////////////////////////////////////////////
+
+		void add(const char* _name, const std::string& _detail, const int64_t _begin, const int64_t _duration, const int _thread)
+		{
+			if(!started)
+				return;
+
+			Event event = { _name, _detail, _begin, _duration, _thread };
+
+			std::unique_lock<std::mutex> lock(mutex);
+			events.push_back(std::move(event));
+
+		} // add
+
+//////////////////////////////////////////////////////////////////////////
+
+		std::vector<Total> getTotals(void)
+		{
+			std::unique_lock<std::mutex>         lock(mutex);
+			std::vector<Total>                   totals;
+			std::unordered_map<std::string, int> indices;
+
+			for(const Event& event : events)
+			{
+				auto index = indices.find(event.name);
+
+				if(index == indices.end())
+				{
+					indices[event.name] = (int)totals.size();
+					totals.push_back(Total { event.name, event.begin, event.duration, 1 });
+				}
+				else
+				{
+					Total& total = totals[index->second];
+
+					total.begin     = std::min(total.begin, event.begin);
+					total.duration += event.duration;
+					total.count++;
+				}
+			}
+
+			// events are added as they end, nested scopes would come before the ones they're in. Starting in the same
+			// microsecond, the one that took longer is the outer one
+			std::sort(totals.begin(), totals.end(), [](const Total& _a, const Total& _b)
+			{
+				return (_a.begin != _b.begin) ? (_a.begin < _b.begin) : (_a.duration > _b.duration);
+			});
+
+			return totals;
+
+		} // getTotals
+
+//////////////////////////////////////////////////////////////////////////
+
+		bool save(const std::string& _path)
+		{
+			std::unique_lock<std::mutex> lock(mutex);
+			std::ofstream                stream(Utils::FileSystem::getGenericPath(_path).c_str(), std::ios::out | std::ios::trunc);
+
+			if(!stream.is_open())
+				return false;
+
+			stream << "{\"traceEvents\":[";
+
+			for(size_t i = 0; i < events.size(); ++i)
+			{
+				const Event& event = events[i];
+
+				stream << ((i > 0) ? ",\n" : "\n");
+				stream << "{\"name\":\"" << escape(event.name) << "\",\"ph\":\"X\",\"pid\":1,\"tid\":" << event.thread <<
+				          ",\"ts\":" << event.begin << ",\"dur\":" << event.duration;
+
+				if(!event.detail.empty())
+					stream << ",\"args\":{\"detail\":\"" << escape(event.detail) << "\"}";
+
+				stream << "}";
+			}
+
+			stream << "\n],\"displayTimeUnit\":\"ms\"}\n";
+			stream.close();
+
+			return !stream.fail();
+
+		} // save
+
+//////////////////////////////////////////////////////////////////////////
+
+		Scope::Scope(const char* _name) : mName(_name), mBegin(started ? getMicroseconds() : -1)
+		{
+
+		} // Scope
+
+//////////////////////////////////////////////////////////////////////////
+
+		Scope::Scope(const char* _name, const std::string& _detail) : mName(_name), mBegin(started ? getMicroseconds() : -1)
+		{
+			if(mBegin >= 0)
+				mDetail = _detail;
+
+		} // Scope
+
+//////////////////////////////////////////////////////////////////////////
+
+		Scope::~Scope(void)
+		{
+			// started after this scope began or stopped before it ended
+			if((mBegin < 0) || !started)
+				return;
+
+			Event event = { mName, std::move(mDetail), mBegin, getMicroseconds() - mBegin, getThread() };
+
+			std::unique_lock<std::mutex> lock(mutex);
+			events.push_back(std::move(event));
+
+		} // ~Scope
+
+	} // Timeline::
+
+} // Utils::
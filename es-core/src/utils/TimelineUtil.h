@@ -0,0 +1,68 @@
+#pragma once
+#ifndef ES_CORE_UTILS_TIMELINE_UTIL_H
+#define ES_CORE_UTILS_TIMELINE_UTIL_H
+
+#include <stdint.h>
+#include <string>
+#include <vector>
+
+namespace Utils
+{
+	namespace Timeline
+	{
+		// Records how long the scopes took on which thread while it's started, and writes them out in the Chrome trace
+		// format (chrome://tracing, Perfetto). Unlike Utils::Profiling it's in every build, a scope only checks a flag
+		// while nothing is recorded
+		void start  ();
+		void stop   ();
+		bool save   (const std::string& _path);
+		bool isStarted();
+
+		// Microseconds since the program started, what scopes are timed in
+		int64_t getTime();
+		// Records a scope that was timed somewhere else, like on the GPU. _thread is the row it's shown in, numbers
+		// far from those of the threads keep it apart from them
+		void    add    (const char* _name, const std::string& _detail, const int64_t _begin, const int64_t _duration, const int _thread);
+
+		struct Total
+		{
+			std::string name;
+			int64_t     begin;    // first time it started, microseconds since the program started
+			int64_t     duration; // microseconds, summed over every call on every thread
+			int         count;
+
+		}; // Total
+
+		// What was recorded so far summed up per scope name, in the order they first started
+		std::vector<Total> getTotals();
+
+//////////////////////////////////////////////////////////////////////////
+
+		class Scope
+		{
+		public:
+
+			 Scope(const char* _name);
+			 Scope(const char* _name, const std::string& _detail);
+			~Scope();
+
+		private:
+
+			const char* mName;
+			std::string mDetail;
+			int64_t     mBegin;
+
+		}; // Scope
+
+	} // Timeline::
+
+} // Utils::
+
+#define _timelineUnique(_name, _line) _name ## _line
+#define _timelineUniqueScope(_line)   _timelineUnique(timelineScope, _line)
+
+// _detail tells apart the calls of the same scope, a system name for example
+#define TimelineScope(_name)                 const Utils::Timeline::Scope _timelineUniqueScope(__LINE__)(_name)
+#define TimelineScopeDetail(_name, _detail)  const Utils::Timeline::Scope _timelineUniqueScope(__LINE__)(_name, _detail)
+
+#endif // ES_CORE_UTILS_TIMELINE_UTIL_H